@@ -26,6 +26,7 @@
 #include <syslog.h>
 #include <stdarg.h>
 #include <assert.h>
+#include <pthread.h>
 
 extern service_method_table_t           g_services;
 extern const sai_route_api_t            route_api;
@@ -40,6 +41,18 @@ extern const sai_next_hop_group_api_t   next_hop_group_api;
 extern const sai_router_interface_api_t router_interface_api;
 extern const sai_vlan_api_t             vlan_api;
 extern const sai_hostif_api_t           host_interface_api;
+extern const sai_acl_api_t              acl_api;
+extern const sai_hash_api_t             hash_api;
+extern const sai_udf_api_t              udf_api;
+extern const sai_policer_api_t          policer_api;
+extern const sai_qos_map_api_t          qos_map_api;
+extern const sai_queue_api_t            queue_api;
+extern const sai_scheduler_api_t        scheduler_api;
+extern const sai_scheduler_group_api_t  scheduler_group_api;
+extern const sai_wred_api_t             wred_api;
+extern const sai_buffer_api_t           buffer_api;
+extern const sai_mirror_api_t           mirror_api;
+extern sai_switch_notification_t        g_notification_callbacks;
 
 /*
  *  SAI operation type
@@ -77,9 +90,11 @@ typedef enum _sai_attribute_value_type_t {
     SAI_ATTR_VAL_TYPE_U32LIST,
     SAI_ATTR_VAL_TYPE_S32LIST,
     SAI_ATTR_VAL_TYPE_VLANLIST,
+    SAI_ATTR_VAL_TYPE_U8LIST,
     SAI_ATTR_VAL_TYPE_ACLFIELD,
     SAI_ATTR_VAL_TYPE_ACLACTION,
-    SAI_ATTR_VAL_TYPE_PORTBREAKOUT
+    SAI_ATTR_VAL_TYPE_PORTBREAKOUT,
+    SAI_ATTR_VAL_TYPE_QOSMAP
 } sai_attribute_value_type_t;
 typedef struct _sai_attribute_entry_t {
     sai_attr_id_t              id;
@@ -141,9 +156,87 @@ static __attribute__((__used__)) const char *sai_type2str_arr[] = {
     "Sample packet type",
 
     /* SAI_OBJECT_TYPE_STP_INSTANCE = 13 */
-    "Stp instance type"
+    "Stp instance type",
 
-    /* SAI_OBJECT_TYPE_MAX = 14 */
+    /* SAI_OBJECT_TYPE_TRAP_GROUP = 14 */
+    "Trap group type",
+
+    /* SAI_OBJECT_TYPE_ACL_TABLE_GROUP = 15 */
+    "ACL table group type",
+
+    /* SAI_OBJECT_TYPE_POLICER = 16 */
+    "Policer type",
+
+    /* SAI_OBJECT_TYPE_WRED = 17 */
+    "WRED type",
+
+    /* SAI_OBJECT_TYPE_QOS_MAPS = 18 */
+    "QoS maps type",
+
+    /* SAI_OBJECT_TYPE_QUEUE = 19 */
+    "Queue type",
+
+    /* SAI_OBJECT_TYPE_SCHEDULER = 20 */
+    "Scheduler type",
+
+    /* SAI_OBJECT_TYPE_SCHEDULER_GROUP = 21 */
+    "Scheduler group type",
+
+    /* SAI_OBJECT_TYPE_BUFFER_POOL = 22 */
+    "Buffer pool type",
+
+    /* SAI_OBJECT_TYPE_BUFFER_PROFILE = 23 */
+    "Buffer profile type",
+
+    /* SAI_OBJECT_TYPE_PRIORITY_GROUP = 24 */
+    "Priority group type",
+
+    /* SAI_OBJECT_TYPE_LAG_MEMBER = 25 */
+    "LAG member type",
+
+    /* SAI_OBJECT_TYPE_HASH = 26 */
+    "Hash type",
+
+    /* SAI_OBJECT_TYPE_UDF = 27 */
+    "UDF type",
+
+    /* SAI_OBJECT_TYPE_UDF_MATCH = 28 */
+    "UDF match type",
+
+    /* SAI_OBJECT_TYPE_UDF_GROUP = 29 */
+    "UDF group type",
+
+    /* SAI_OBJECT_TYPE_FDB = 30 */
+    "FDB type",
+
+    /* SAI_OBJECT_TYPE_SWITCH = 31 */
+    "Switch type",
+
+    /* SAI_OBJECT_TYPE_TRAP = 32 */
+    "Trap type",
+
+    /* SAI_OBJECT_TYPE_TRAP_USER_DEF = 33 */
+    "User defined trap type",
+
+    /* SAI_OBJECT_TYPE_NEIGHBOR = 34 */
+    "Neighbor type",
+
+    /* SAI_OBJECT_TYPE_ROUTE = 35 */
+    "Route type",
+
+    /* SAI_OBJECT_TYPE_VLAN = 36 */
+    "VLAN type",
+
+    /* SAI_OBJECT_TYPE_TUNNEL_MAP = 37 */
+    "Tunnel map type",
+
+    /* SAI_OBJECT_TYPE_TUNNEL = 38 */
+    "Tunnel type",
+
+    /* SAI_OBJECT_TYPE_TUNNEL_TABLE_ENTRY = 39 */
+    "Tunnel table entry type"
+
+    /* SAI_OBJECT_TYPE_MAX = 40 */
 };
 
 typedef union {
@@ -156,7 +249,8 @@ typedef union {
 typedef sai_status_t (*sai_attribute_set_fn)(_In_ const sai_object_key_t *key, _In_ const sai_attribute_value_t *value,
                                              void *arg);
 typedef union {
-    int dummy;
+    int         dummy;
+    const void *entry;   /* object snapshot shared by the getters of one get call */
 } vendor_cache_t;
 typedef sai_status_t (*sai_attribute_get_fn)(_In_ const sai_object_key_t *key, _Inout_ sai_attribute_value_t *value,
                                              _In_ uint32_t attr_index, _Inout_ vendor_cache_t *cache, void *arg);
@@ -202,6 +296,14 @@ sai_status_t sai_get_attributes(_In_ const sai_object_key_t             *key,
 #define MAX_LIST_VALUE_STR_LEN 1000
 
 #define PORT_NUMBER 32
+#define VLAN_NUMBER 4096
+
+/* Table locks prefer writers, so a steady stream of gets can not starve updates */
+#ifdef PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP
+#define STUB_RWLOCK_INITIALIZER PTHREAD_RWLOCK_WRITER_NONRECURSIVE_INITIALIZER_NP
+#else
+#define STUB_RWLOCK_INITIALIZER PTHREAD_RWLOCK_INITIALIZER
+#endif
 
 sai_status_t sai_value_to_str(_In_ sai_attribute_value_t      value,
                               _In_ sai_attribute_value_type_t type,
@@ -223,15 +325,226 @@ sai_status_t sai_nexthops_to_str(_In_ uint32_t               next_hop_count,
                                  _Out_ char                 *str);
 sai_status_t stub_object_to_type(sai_object_id_t object_id, sai_object_type_t type, uint32_t *data);
 sai_status_t stub_create_object(sai_object_type_t type, uint32_t data, sai_object_id_t *object_id);
+uint32_t stub_alloc_object_index(_Inout_ uint32_t *next_index);
 
 void db_init_next_hop_group();
 sai_status_t db_get_next_hop_group(_In_ uint32_t next_hop_group_id, _Out_ sai_object_list_t *next_hop_list);
 void db_init_vlan();
+bool db_vlan_port_member(_In_ sai_vlan_id_t vlan_id, _In_ uint32_t port);
+bool db_vlan_port_tagging(_In_ sai_vlan_id_t vlan_id, _In_ uint32_t port, _Out_ sai_vlan_tagging_mode_t *tagging_mode);
+void db_init_fdb();
+void db_init_route();
+void db_init_neighbor();
+void db_init_next_hop();
+void db_init_rif();
+void db_init_port(void);
+sai_vlan_id_t db_get_port_default_vlan(_In_ uint32_t port);
+void db_init_host_interface(_In_ sai_switch_profile_id_t profile_id);
+void db_stop_host_interface_io(void);
+sai_status_t db_get_host_interface_by_port(_In_ sai_object_id_t port_id, _Out_ sai_object_id_t *hif_id);
+
+/* Trap groups and traps, see stub_sai_hostif_trap.c */
+struct _stub_packet_t;
+void db_init_hostif_trap(void);
+sai_object_id_t db_get_default_trap_group(void);
+sai_status_t db_set_default_trap_group(_In_ sai_object_id_t trap_group_id);
+void db_apply_hostif_traps(_In_ uint32_t count, _Inout_ struct _stub_packet_t *packets);
+void db_deliver_hostif_traps(_In_ uint32_t count, _In_ const struct _stub_packet_t *packets);
+sai_status_t stub_create_hostif_trap_group(_Out_ sai_object_id_t     *hostif_trap_group_id,
+                                           _In_ uint32_t               attr_count,
+                                           _In_ const sai_attribute_t *attr_list);
+sai_status_t stub_remove_hostif_trap_group(_In_ sai_object_id_t hostif_trap_group_id);
+sai_status_t stub_set_hostif_trap_group_attribute(_In_ sai_object_id_t        hostif_trap_group_id,
+                                                  _In_ const sai_attribute_t *attr);
+sai_status_t stub_get_hostif_trap_group_attribute(_In_ sai_object_id_t     hostif_trap_group_id,
+                                                  _In_ uint32_t            attr_count,
+                                                  _Inout_ sai_attribute_t *attr_list);
+sai_status_t stub_set_hostif_trap_attribute(_In_ sai_hostif_trap_id_t   hostif_trapid,
+                                            _In_ const sai_attribute_t *attr);
+sai_status_t stub_get_hostif_trap_attribute(_In_ sai_hostif_trap_id_t hostif_trapid,
+                                            _In_ uint32_t             attr_count,
+                                            _Inout_ sai_attribute_t  *attr_list);
+
+/* ACL tables, see stub_sai_acl.h */
+void db_init_acl(void);
+void db_apply_acl(_In_ sai_int32_t               stage,
+                  _In_ uint32_t                  count,
+                  _Inout_ struct _stub_packet_t *packets,
+                  _Inout_ bool                  *pending,
+                  _Inout_ bool                  *copy);
+
+/* Hash objects and the ECMP and LAG hash engines, see stub_sai_hash.h */
+void db_init_hash(void);
+uint32_t db_hash_packet(_In_ sai_int32_t                  type,
+                        _In_ const struct _stub_packet_t *packet,
+                        _In_ uint32_t                     l3_offset,
+                        _In_ uint16_t                     ethertype,
+                        _In_ sai_vlan_id_t                vlan_id);
+sai_object_id_t db_get_switch_hash(_In_ sai_int32_t type);
+sai_status_t db_set_switch_hash(_In_ sai_int32_t type, _In_ sai_object_id_t hash_id);
+sai_int32_t db_get_switch_hash_algorithm(_In_ sai_int32_t type);
+sai_status_t db_set_switch_hash_algorithm(_In_ sai_int32_t type, _In_ sai_int32_t algorithm);
+uint32_t db_get_switch_hash_seed(_In_ sai_int32_t type);
+void db_set_switch_hash_seed(_In_ sai_int32_t type, _In_ uint32_t seed);
+sai_status_t db_select_lag_member(_In_ sai_object_id_t   lag_id,
+                                  _In_ uint32_t          hash,
+                                  _Out_ sai_object_id_t *port_id);
+
+/* UDF groups, see stub_sai_udf.h. Extraction runs inside a read side section */
+typedef struct _stub_udf_layout_t {
+    /* L2, L3 and L4 header offsets, then one that is never in a frame.
+     * UINT32_MAX for headers the frame does not have */
+    uint32_t base[SAI_UDF_BASE_L4 + 2];
+    uint16_t l2_type;
+    uint16_t gre_type;
+    uint8_t  l3_type;
+} stub_udf_layout_t;
+
+void db_init_udf(void);
+void db_udf_parse(_In_ const struct _stub_packet_t *packet, _Out_ stub_udf_layout_t *layout);
+uint32_t db_udf_extract(_In_ uint32_t                     group,
+                        _In_ const struct _stub_packet_t *packet,
+                        _In_ const stub_udf_layout_t     *layout,
+                        _In_ bool                         hash,
+                        _Out_ uint8_t                    *bytes);
+sai_status_t db_udf_group_bind(_In_ sai_object_id_t udf_group_id,
+                               _In_ sai_int32_t     type,
+                               _Out_ uint32_t      *group,
+                               _Out_ uint32_t      *length);
+void db_udf_group_unbind(_In_ uint32_t group);
+
+/* Policers, see stub_sai_policer.h. Users take them through an index */
+#define STUB_NO_POLICER UINT32_MAX
+
+void db_init_policer(void);
+sai_status_t db_policer_bind(_In_ sai_object_id_t policer_id, _Out_ uint32_t *policer);
+void db_policer_ref(_In_ uint32_t policer);
+void db_policer_unbind(_In_ uint32_t policer);
+void db_apply_policers(_In_ uint32_t                     count,
+                       _In_ const uint32_t              *policers,
+                       _In_ const struct _stub_packet_t *packets,
+                       _Inout_ bool                     *dropped);
+
+/* QoS maps, see stub_sai_qos_map.h. The data plane reads them in read side sections */
+void db_init_qos_map(void);
+sai_status_t db_get_port_qos(_In_ uint32_t port, _In_ sai_attr_id_t attr, _Out_ sai_attribute_value_t *value);
+sai_status_t db_set_port_qos(_In_ uint32_t port, _In_ sai_attr_id_t attr, _In_ const sai_attribute_value_t *value);
+void db_apply_qos_maps(_In_ uint32_t count, _Inout_ struct _stub_packet_t *packets, _In_ const bool *pending);
+void db_apply_qos_queues(_In_ uint32_t count, _Inout_ struct _stub_packet_t *packets);
+
+/* WRED profiles, see stub_sai_wred.h. Queues take them through an index,
+ * the scheduler applies them in read side sections */
+#define STUB_NO_WRED UINT32_MAX
+
+typedef enum _stub_wred_action_t {
+    STUB_WRED_QUEUE,
+    STUB_WRED_DROP,
+    /* Congestion Experienced if ECN capable, a drop otherwise */
+    STUB_WRED_MARK,
+} stub_wred_action_t;
+
+void db_init_wred(void);
+sai_status_t db_wred_bind(_In_ sai_object_id_t wred_id, _Out_ uint32_t *wred);
+void db_wred_unbind(_In_ uint32_t wred);
+stub_wred_action_t db_apply_wred(_In_ uint32_t    wred,
+                                 _Inout_ int64_t *average,
+                                 _In_ uint64_t    occupancy,
+                                 _In_ uint32_t    color);
+bool db_wred_mark_ecn(_Inout_ struct _stub_packet_t *packet);
+
+/* Shared buffer, see stub_sai_buffer.h. The scheduler admits frames into
+ * the buffer as it queues them and releases them as it sends them, holding
+ * the buffer lock across a burst */
+#define STUB_BUFFER_NO_PORT UINT32_MAX
+
+void db_init_buffer(void);
+void db_buffer_lock(void);
+void db_buffer_unlock(void);
+sai_status_t db_get_port_buffer(_In_ uint32_t port, _In_ sai_attr_id_t attr, _Out_ sai_attribute_value_t *value);
+sai_status_t db_get_queue_buffer(_In_ uint32_t port, _In_ uint32_t queue, _Out_ sai_object_id_t *profile_id);
+sai_status_t db_set_queue_buffer(_In_ uint32_t port, _In_ uint32_t queue, _In_ sai_object_id_t profile_id);
+bool db_buffer_admit(_In_ uint32_t in_port,
+                     _In_ uint32_t priority_group,
+                     _In_ uint32_t port,
+                     _In_ uint32_t queue,
+                     _In_ uint32_t length);
+void db_buffer_release(_In_ uint32_t in_port,
+                       _In_ uint32_t priority_group,
+                       _In_ uint32_t port,
+                       _In_ uint32_t queue,
+                       _In_ uint32_t length);
+
+/* Mirror sessions, see stub_sai_mirror.h */
+void db_init_mirror(void);
+sai_status_t db_get_port_mirror(_In_ uint32_t port, _In_ bool ingress, _Inout_ sai_object_list_t *sessions);
+sai_status_t db_set_port_mirror(_In_ uint32_t port, _In_ bool ingress, _In_ const sai_object_list_t *sessions);
+
+/* Queues and schedulers, see stub_sai_scheduler.h */
+void db_init_scheduler(void);
+sai_status_t db_get_port_scheduler(_In_ uint32_t port, _In_ sai_attr_id_t attr, _Out_ sai_attribute_value_t *value);
+sai_status_t db_set_port_scheduler(_In_ uint32_t port, _In_ const sai_attribute_value_t *value);
+
+/* Port counters, see stub_sai_port.h */
+uint32_t db_port_stats_shard(void);
+void db_port_stats_add(_In_ uint32_t shard, _In_ uint32_t port, _In_ sai_port_stat_counter_t counter, _In_ uint64_t value);
+void db_port_stats_frame(_In_ uint32_t       shard,
+                         _In_ uint32_t       port,
+                         _In_ bool           ingress,
+                         _In_ const uint8_t *data,
+                         _In_ uint32_t       length);
+
+/* Port policers, see stub_sai_policer.h */
+void db_apply_port_policers(_In_ uint32_t count, _Inout_ struct _stub_packet_t *packets, _Inout_ bool *pending);
+void db_apply_storm_control(_In_ uint32_t count, _Inout_ struct _stub_packet_t *packets);
+
+/* Forwarding lookups, see stub_sai_lookup.h. Route, next hop, rif and neighbor
+ * lookups must be called inside a read side section */
+void db_lookup_route_bulk(_In_ sai_object_id_t         vr_id,
+                          _In_ uint32_t                count,
+                          _In_ const sai_ip_address_t *dst_ip,
+                          _Out_ sai_status_t          *status,
+                          _Out_ sai_int32_t           *packet_action,
+                          _Out_ sai_object_id_t       *next_hop_id);
+sai_status_t db_select_next_hop_group_member(_In_ uint32_t          next_hop_group_id,
+                                             _In_ uint32_t          flow_hash,
+                                             _Out_ sai_object_id_t *next_hop_id);
+sai_status_t db_lookup_next_hop(_In_ sai_object_id_t     next_hop_id,
+                                _Out_ sai_ip_address_t *ip,
+                                _Out_ sai_object_id_t  *rif_id);
+sai_status_t db_lookup_rif(_In_ sai_object_id_t   rif_id,
+                           _Out_ sai_object_id_t *port_id,
+                           _Out_ sai_vlan_id_t   *vlan_id,
+                           _Out_ sai_mac_t        src_mac,
+                           _Out_ bool            *admin_v4,
+                           _Out_ bool            *admin_v6);
+sai_status_t db_lookup_ingress_rif(_In_ sai_object_id_t   port_id,
+                                   _In_ sai_vlan_id_t     vlan_id,
+                                   _Out_ sai_object_id_t *rif_id,
+                                   _Out_ sai_object_id_t *vr_id,
+                                   _Out_ sai_mac_t        router_mac);
+sai_status_t db_lookup_neighbor(_In_ const sai_neighbor_entry_t *neighbor_entry,
+                                _Out_ sai_mac_t                  mac,
+                                _Out_ sai_int32_t               *action);
+sai_status_t db_lookup_fdb(_In_ const sai_fdb_entry_t *fdb_entry,
+                           _Out_ sai_object_id_t      *port_id,
+                           _Out_ sai_int32_t          *action);
+
+/* Epoch based RCU, lock-free readers for the route and neighbor tables */
+void stub_rcu_read_lock(void);
+void stub_rcu_read_unlock(void);
+void stub_rcu_synchronize(void);
+void stub_rcu_barrier(void);
+void stub_rcu_defer_free(_In_ void *ptr);
+
+#define STUB_RCU_DEREF(p)       __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+#define STUB_RCU_ASSIGN(p, val) __atomic_store_n(&(p), (val), __ATOMIC_RELEASE)
 
 sai_status_t stub_fill_objlist(sai_object_id_t *data, uint32_t count, sai_object_list_t *list);
 sai_status_t stub_fill_u32list(uint32_t *data, uint32_t count, sai_u32_list_t *list);
 sai_status_t stub_fill_s32list(int32_t *data, uint32_t count, sai_s32_list_t *list);
 sai_status_t stub_fill_vlanlist(sai_vlan_id_t *data, uint32_t count, sai_vlan_list_t *list);
+sai_status_t stub_fill_u8list(uint8_t *data, uint32_t count, sai_u8_list_t *list);
+sai_status_t stub_fill_qosmaplist(sai_qos_map_t *data, uint32_t count, sai_qos_map_list_t *list);
 
 void utils_log(const sai_log_level_t severity, const char *module_name, const char *p_str, ...);
 
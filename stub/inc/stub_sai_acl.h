@@ -0,0 +1,150 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#if !defined (__STUBSAIACL_H_)
+#define __STUBSAIACL_H_
+
+#include <saitypes.h>
+#include <saistatus.h>
+#include <saiacl.h>
+#include "stub_sai_dataplane.h"
+
+/*
+ * ACL classifier. The entries of a table are compiled into a tuple space:
+ * entries that match on the same fields with the same masks share a
+ * subtable, a hash table of their masked keys. A lookup masks the frame key
+ * with the mask of each subtable and probes its hash table once. Subtables
+ * are ordered by the highest entry priority they hold, so the search of a
+ * frame stops at the first subtable that can not beat its best hit. Adding or
+ * removing an entry updates one subtable, lookups run lock free under the
+ * read side of the stub RCU.
+ *
+ * The data plane runs the ingress tables on every frame before the
+ * forwarding lookups and the egress tables on forwarded frames, both
+ * stages burst by burst. Tables of a stage are searched from the highest
+ * table priority down; every hit counts, the packet action, policer and
+ * redirect of the highest priority table that sets them win. The stub
+ * implements the packet action, redirect to a port, policer and counter
+ * actions.
+ *
+ * A bulk update stages the entry changes of a table instead: lookups keep
+ * the classifier they have while the changes pile up, and the commit
+ * compiles all entries of the table into a new classifier and swaps it in
+ * with one pointer store.
+ *
+ * Counters are kept per data plane thread: each thread adds its hits to a
+ * shard of its own without atomic instructions, a read sums the shards.
+ * Clearing or setting a counter moves its base instead of writing the
+ * shards. stub_acl_get_counters_bulk reads all counters of a table with one
+ * pass over each shard.
+ *
+ * A table matches user defined fields through UDF groups of type
+ * SAI_UDF_GROUP_GENERIC set as SAI_ACL_TABLE_ATTR_USER_DEFINED_FIELD_GROUP_MIN
+ * and the attributes after it; the entry attribute at the same distance
+ * from SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN gives the data and mask,
+ * one byte per byte of the group. The group bytes of a frame are extracted
+ * once per table that has groups, into key bytes the table reserves.
+ */
+
+/** Lowest and highest ACL table priority, a higher value is searched first */
+#define STUB_ACL_TABLE_MIN_PRIORITY 0
+#define STUB_ACL_TABLE_MAX_PRIORITY 0xFFFF
+
+/** Lowest and highest ACL entry priority, a higher value wins */
+#define STUB_ACL_ENTRY_MIN_PRIORITY 0
+#define STUB_ACL_ENTRY_MAX_PRIORITY 0xFFFFFF
+
+/** UDF groups of an ACL table at most, and their bytes together */
+#define STUB_ACL_TABLE_UDF_GROUPS 4
+#define STUB_ACL_TABLE_UDF_BYTES  12
+
+/**
+ *  @brief Stub ACL table attributes, bulk updates and classifier statistics
+ */
+typedef enum _stub_acl_table_attr_t
+{
+    /** Bulk update open [bool] (SET)
+     * (default to false). Setting it to false commits the staged changes */
+    STUB_ACL_TABLE_ATTR_BULK_UPDATE = SAI_ACL_TABLE_ATTR_CUSTOM_RANGE_BASE,
+
+    /** Time the last entry change or bulk commit took to reach the lookups,
+     * in nanoseconds [uint64_t] (READ_ONLY) */
+    STUB_ACL_TABLE_ATTR_LAST_UPDATE_LATENCY,
+
+    /** Longest update time since the table was created, in nanoseconds
+     * [uint64_t] (READ_ONLY) */
+    STUB_ACL_TABLE_ATTR_MAX_UPDATE_LATENCY,
+
+    /** Subtables of the classifier, one per set of field masks [uint32_t] (READ_ONLY) */
+    STUB_ACL_TABLE_ATTR_SUBTABLE_COUNT,
+
+    /** Memory of the classifier lookups use, rules included, in bytes
+     * [uint64_t] (READ_ONLY) */
+    STUB_ACL_TABLE_ATTR_CLASSIFIER_MEMORY
+
+} stub_acl_table_attr_t;
+
+/**
+ * Routine Description:
+ *    @brief Classify a burst of frames against one ACL table, without
+ *    applying the actions of the hits or counting them
+ *
+ * Arguments:
+ *    @param[in] acl_table_id - ACL table
+ *    @param[in] count - number of frames
+ *    @param[in] packets - frames, in_port and for egress tables out_port set
+ *    @param[out] entry_ids - hit entry of each frame, SAI_NULL_OBJECT_ID on a miss
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_acl_classify(
+    _In_ sai_object_id_t acl_table_id,
+    _In_ uint32_t count,
+    _In_ const stub_packet_t *packets,
+    _Out_ sai_object_id_t *entry_ids
+    );
+
+/**
+ * Routine Description:
+ *    @brief Read all counters of an ACL table in one call
+ *
+ * Arguments:
+ *    @param[in] acl_table_id - ACL table
+ *    @param[inout] counter_count - size of the arrays, set to the number of
+ *                                  counters of the table
+ *    @param[out] counter_ids - counters
+ *    @param[out] packets - packets of each counter
+ *    @param[out] bytes - bytes of each counter
+ *    @param[in] clear - clear the counters as they are read
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            SAI_STATUS_BUFFER_OVERFLOW if counter_count is insufficient
+ *            Failure status code on error
+ */
+sai_status_t stub_acl_get_counters_bulk(
+    _In_ sai_object_id_t acl_table_id,
+    _Inout_ uint32_t *counter_count,
+    _Out_ sai_object_id_t *counter_ids,
+    _Out_ uint64_t *packets,
+    _Out_ uint64_t *bytes,
+    _In_ bool clear
+    );
+
+#endif /* __STUBSAIACL_H_ */
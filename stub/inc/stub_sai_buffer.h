@@ -0,0 +1,104 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#if !defined (__STUBSAIBUFFER_H_)
+#define __STUBSAIBUFFER_H_
+
+#include <saitypes.h>
+#include <saistatus.h>
+#include <saibuffer.h>
+
+/*
+ * Shared buffer, simulated. The buffer is STUB_BUFFER_SIZE bytes in cells
+ * of STUB_BUFFER_CELL_SIZE, a frame takes its length rounded up to cells.
+ * Each port has STUB_QOS_PRIORITY_GROUPS ingress priority groups, frames
+ * join the one the TC_TO_PRIORITY_GROUP map of their ingress port gives,
+ * and leave it when the egress scheduler sends them from their queue
+ * (stub_sai_scheduler.h). A flooded frame is charged once per copy.
+ *
+ * Priority groups bind profiles of ingress pools, queues profiles of
+ * egress pools, and a frame needs room in both. Within its profile a user
+ * takes cells from:
+ *
+ *   BUFFER_SIZE       - reserved to it, first
+ *   the shared pool   - up to SHARED_STATIC_TH bytes in a static pool, or
+ *                       2^SHARED_DYNAMIC_TH times the shared cells still
+ *                       free in a dynamic one
+ *   XOFF_TH headroom  - priority groups only. The group asserts XOFF when
+ *                       shared cells run out and absorbs the frames in
+ *                       flight here, dropping what does not fit; it goes
+ *                       back to XON once its occupancy falls to XON_TH
+ *
+ * Reserved and headroom cells of the users of a pool are set aside from
+ * its size, the rest is SHARED_SIZE; binding more than a pool holds fails.
+ * Users without a profile are counted, not limited. Frames refused count
+ * as drops of their queue, those the priority group refuses also in its
+ * counters below. Occupancies and watermarks are in bytes of whole cells.
+ */
+
+/** Bytes of buffer, the sizes of the pools of a type add up to at most this */
+#define STUB_BUFFER_SIZE (32 * 1024 * 1024)
+
+/** Bytes per cell */
+#define STUB_BUFFER_CELL_SIZE 256
+
+/** Pools of each type */
+#define STUB_BUFFER_POOLS 8
+
+/** Range of SAI_BUFFER_PROFILE_ATTR_SHARED_DYNAMIC_TH, 1/128 to 128 of the free cells */
+#define STUB_BUFFER_MIN_DYNAMIC_TH (-7)
+#define STUB_BUFFER_MAX_DYNAMIC_TH 7
+
+/** Ingress priority group counters of the stub, after the SAI ones */
+typedef enum _stub_ingress_priority_group_stat_counter_t
+{
+    /** Frames the group refused [uint64_t] */
+    STUB_INGRESS_PRIORITY_GROUP_STAT_DROPPED_PACKETS = SAI_INGRESS_PRIORITY_GROUP_STAT_CUSTOM_RANGE_BASE,
+
+    /** Bytes of those frames [uint64_t] */
+    STUB_INGRESS_PRIORITY_GROUP_STAT_DROPPED_BYTES,
+
+    /** Headroom occupancy in bytes [uint64_t] */
+    STUB_INGRESS_PRIORITY_GROUP_STAT_HEADROOM_OCCUPANCY_BYTES,
+
+    /** Headroom watermark in bytes [uint64_t] */
+    STUB_INGRESS_PRIORITY_GROUP_STAT_HEADROOM_WATERMARK_BYTES,
+
+    /** Times the group asserted XOFF [uint64_t] */
+    STUB_INGRESS_PRIORITY_GROUP_STAT_XOFF_COUNT,
+
+} stub_ingress_priority_group_stat_counter_t;
+
+/**
+ * Routine Description:
+ *    @brief Get the priority groups of a port in XOFF, the pause a PFC
+ *    peer would be sending
+ *
+ * Arguments:
+ *    @param[in] port_id - port
+ *    @param[out] xoff - bit n set when priority group n is in XOFF
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_buffer_port_xoff(
+    _In_ sai_object_id_t port_id,
+    _Out_ uint8_t *xoff
+    );
+
+#endif /* __STUBSAIBUFFER_H_ */
@@ -0,0 +1,294 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#if !defined (__STUBSAICOUNTER_H_)
+#define __STUBSAICOUNTER_H_
+
+#include <saitypes.h>
+#include <saistatus.h>
+
+/*
+ * Counter polling. A counter group is a set of objects of one type and the
+ * counters read on each of them, polled every interval by one polling
+ * thread through the get_*_stats API of the object type. Each poll keeps
+ * the values, the deltas since the previous poll and an EWMA of the rate
+ * per second in a snapshot laid out column by column, counter after
+ * counter.
+ *
+ * Snapshots are published into a ring in POSIX shared memory, so that any
+ * number of telemetry readers map the ring and read the last snapshots of a
+ * group without calling into SAI. Each group has STUB_COUNTER_RING_DEPTH
+ * slots, written in turn. Every slot is a seqlock: the writer makes the
+ * sequence odd while it writes the slot, a reader retries until it copied
+ * the slot between two equal even sequence values.
+ */
+
+/** Counter groups */
+#define STUB_COUNTER_MAX_GROUPS   16
+
+/** Objects in a counter group */
+#define STUB_COUNTER_MAX_OBJECTS  512
+
+/** Counters read on each object of a counter group */
+#define STUB_COUNTER_MAX_COUNTERS 128
+
+/** Objects times counters of a counter group */
+#define STUB_COUNTER_MAX_CELLS    4096
+
+/** Snapshots of each counter group kept in the shared memory ring */
+#define STUB_COUNTER_RING_DEPTH   4
+
+/** First bytes of a counter ring, "SAICNTR" and the layout version */
+#define STUB_COUNTER_RING_MAGIC   0x5341494354520001ULL
+
+/**
+ *  @brief Counter group configuration
+ */
+typedef struct _stub_counter_group_config_t
+{
+    /** Object type, SAI_OBJECT_TYPE_PORT, SAI_OBJECT_TYPE_VLAN, SAI_OBJECT_TYPE_QUEUE,
+     *  SAI_OBJECT_TYPE_BUFFER_POOL or SAI_OBJECT_TYPE_POLICER */
+    sai_object_type_t object_type;
+
+    /** Number of objects */
+    uint32_t object_count;
+
+    /** Objects, port ids, VLAN ids, queue ids, buffer pool ids or policer ids */
+    const sai_object_id_t *object_ids;
+
+    /** Number of counters */
+    uint32_t counter_count;
+
+    /** Counter ids of the object type, sai_port_stat_counter_t, sai_vlan_stat_counter_t,
+     *  sai_queue_stat_counter_t, sai_buffer_pool_stat_counter_t or sai_policer_stat_counter_t */
+    const int32_t *counter_ids;
+
+    /** Polling interval in milliseconds */
+    uint32_t interval_ms;
+
+    /** Weight of the newest rate sample in the EWMA, 0 to 1, 0 selects 0.5 */
+    double ewma_alpha;
+
+} stub_counter_group_config_t;
+
+/**
+ *  @brief One poll of a counter group. Counter c of object o is at index
+ *  c * object_count + o of values, deltas and rates.
+ */
+typedef struct _stub_counter_snapshot_t
+{
+    /** Seqlock sequence of the ring slot, odd while the slot is written */
+    uint64_t sequence;
+
+    /** Counter group id */
+    uint32_t group_id;
+
+    /** Object type [sai_object_type_t] */
+    int32_t object_type;
+
+    /** Number of objects */
+    uint32_t object_count;
+
+    /** Number of counters */
+    uint32_t counter_count;
+
+    /** Polls of the group so far, this one included. In the ring, the
+     *  snapshot number within the group */
+    uint64_t poll_count;
+
+    /** CLOCK_MONOTONIC time of the poll in nanoseconds */
+    uint64_t timestamp_ns;
+
+    /** Time since the previous poll, or since the group was created, in nanoseconds */
+    uint64_t elapsed_ns;
+
+    /** Objects */
+    sai_object_id_t object_ids[STUB_COUNTER_MAX_OBJECTS];
+
+    /** Counter ids */
+    int32_t counter_ids[STUB_COUNTER_MAX_COUNTERS];
+
+    /** Counter values */
+    uint64_t values[STUB_COUNTER_MAX_CELLS];
+
+    /** Increase since the previous poll, or since the group was created. A
+     *  counter that went down was cleared, its delta is the new value */
+    uint64_t deltas[STUB_COUNTER_MAX_CELLS];
+
+    /** EWMA of the increase per second, the first poll sets it */
+    double rates[STUB_COUNTER_MAX_CELLS];
+
+} stub_counter_snapshot_t;
+
+/**
+ *  @brief Shared memory ring. Snapshot n of group g, counted from 1, is in
+ *  slots[g * STUB_COUNTER_RING_DEPTH + (n - 1) % STUB_COUNTER_RING_DEPTH]
+ */
+typedef struct _stub_counter_ring_t
+{
+    /** STUB_COUNTER_RING_MAGIC */
+    uint64_t magic;
+
+    /** Size of the mapping in bytes */
+    uint64_t size;
+
+    /** Snapshots published for each group, 0 if none */
+    uint64_t heads[STUB_COUNTER_MAX_GROUPS];
+
+    /** Snapshot slots */
+    stub_counter_snapshot_t slots[STUB_COUNTER_MAX_GROUPS * STUB_COUNTER_RING_DEPTH];
+
+} stub_counter_ring_t;
+
+/**
+ * Routine Description:
+ *    @brief Create a counter group. The group is polled by the polling
+ *    thread once started, and by stub_counter_group_poll.
+ *
+ * Arguments:
+ *    @param[out] group_id - counter group id
+ *    @param[in] config - objects, counters and interval
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_counter_group_create(
+    _Out_ uint32_t *group_id,
+    _In_ const stub_counter_group_config_t *config
+    );
+
+/**
+ * Routine Description:
+ *    @brief Remove a counter group
+ *
+ * Arguments:
+ *    @param[in] group_id - counter group id
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_counter_group_remove(
+    _In_ uint32_t group_id
+    );
+
+/**
+ * Routine Description:
+ *    @brief Poll a counter group now, independent of its interval
+ *
+ * Arguments:
+ *    @param[in] group_id - counter group id
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_counter_group_poll(
+    _In_ uint32_t group_id
+    );
+
+/**
+ * Routine Description:
+ *    @brief Copy the last snapshot of a counter group, without shared memory
+ *
+ * Arguments:
+ *    @param[in] group_id - counter group id
+ *    @param[out] snapshot - snapshot
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_counter_group_get(
+    _In_ uint32_t group_id,
+    _Out_ stub_counter_snapshot_t *snapshot
+    );
+
+/**
+ * Routine Description:
+ *    @brief Create the shared memory ring and start the polling thread
+ *
+ * Arguments:
+ *    @param[in] ring_name - shm_open name of the ring, e.g. "/sai_counters",
+ *                           NULL to poll without publishing
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_counter_poll_start(
+    _In_ const char *ring_name
+    );
+
+/**
+ * Routine Description:
+ *    @brief Stop the polling thread and unlink the shared memory ring.
+ *    Readers that mapped the ring keep the last snapshots.
+ */
+void stub_counter_poll_stop(void);
+
+/**
+ * Routine Description:
+ *    @brief Map a counter ring read only
+ *
+ * Arguments:
+ *    @param[in] ring_name - shm_open name of the ring
+ *    @param[out] ring - mapped ring
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_counter_ring_open(
+    _In_ const char *ring_name,
+    _Out_ const stub_counter_ring_t **ring
+    );
+
+/**
+ * Routine Description:
+ *    @brief Copy the newest consistent snapshot of a counter group out of a
+ *    mapped ring
+ *
+ * Arguments:
+ *    @param[in] ring - mapped ring
+ *    @param[in] group_id - counter group id
+ *    @param[out] snapshot - snapshot
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            SAI_STATUS_ITEM_NOT_FOUND if the group has not been published
+ *            Failure status code on error
+ */
+sai_status_t stub_counter_ring_read(
+    _In_ const stub_counter_ring_t *ring,
+    _In_ uint32_t group_id,
+    _Out_ stub_counter_snapshot_t *snapshot
+    );
+
+/**
+ * Routine Description:
+ *    @brief Unmap a counter ring
+ *
+ * Arguments:
+ *    @param[in] ring - mapped ring
+ */
+void stub_counter_ring_close(
+    _In_ const stub_counter_ring_t *ring
+    );
+
+#endif /* __STUBSAICOUNTER_H_ */
@@ -0,0 +1,227 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#if !defined (__STUBSAIDATAPLANE_H_)
+#define __STUBSAIDATAPLANE_H_
+
+#include <saitypes.h>
+#include <saistatus.h>
+
+/*
+ * Software data plane over the stub tables. Frames are bridged through the
+ * FDB, or routed when they are addressed to a router interface MAC: route,
+ * next hop group, neighbor lookup, MAC rewrite and TTL decrement. Control
+ * frames are classified to a trap id, the host interface traps decide and
+ * deliver them, see stub_sai_hostif.h.
+ */
+
+/** Frames handled per run-to-completion iteration */
+#define STUB_DATAPLANE_BURST     32
+
+/** Free bytes the I/O loop keeps in front of every frame */
+#define STUB_DATAPLANE_HEADROOM  64
+
+/** Largest frame the I/O loop receives */
+#define STUB_DATAPLANE_MAX_FRAME 9216
+
+/**
+ *  @brief One frame in a burst
+ */
+typedef struct _stub_packet_t
+{
+    /** Start of the Ethernet frame, moves when a VLAN tag is pushed or popped */
+    uint8_t *data;
+
+    /** Frame length in bytes */
+    uint32_t length;
+
+    /** Writable bytes in front of data, pushing a VLAN tag needs 4 */
+    uint32_t headroom;
+
+    /** Ingress port */
+    sai_object_id_t in_port;
+
+    /** Egress port, SAI_NULL_OBJECT_ID with SAI_PACKET_ACTION_FORWARD floods */
+    sai_object_id_t out_port;
+
+    /** Egress VLAN, floods reach the members of this VLAN */
+    sai_vlan_id_t vlan_id;
+
+    /** Forwarding decision [sai_packet_action_t] */
+    sai_int32_t packet_action;
+
+    /** Trap reason for trapped frames [sai_hostif_trap_id_t],
+     *  0 when trapped by a route or neighbor action */
+    sai_int32_t trap_id;
+
+    /** Traffic class from the ingress QoS maps [sai_cos_t] */
+    sai_cos_t tc;
+
+    /** Color from the ingress QoS maps [sai_packet_color_t] */
+    uint8_t color;
+
+    /** Egress queue from the TC to queue map [sai_queue_index_t] */
+    sai_queue_index_t queue;
+
+    /** Ingress priority group from the TC to priority group map */
+    uint8_t priority_group;
+
+} stub_packet_t;
+
+/**
+ *  @brief Data plane counters
+ */
+typedef struct _stub_dataplane_stats_t
+{
+    uint64_t rx_packets;
+    uint64_t tx_packets;
+    uint64_t routed;
+    uint64_t bridged;
+    uint64_t flooded;
+    uint64_t trapped;
+    uint64_t dropped;
+    uint64_t mirrored;
+
+} stub_dataplane_stats_t;
+
+/**
+ * Routine Description:
+ *    @brief Forward a burst of frames. Parses, looks up and rewrites the
+ *    frames in place and fills their forwarding decision; does no I/O.
+ *
+ * Arguments:
+ *    @param[in] count - number of frames
+ *    @param[inout] packets - frames
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_dataplane_process_burst(
+    _In_ uint32_t count,
+    _Inout_ stub_packet_t *packets
+    );
+
+/**
+ * Routine Description:
+ *    @brief Check whether a forwarded frame leaves through a port: its
+ *    egress port, or for a flooded frame every member of its VLAN but
+ *    the ingress port.
+ *
+ * Arguments:
+ *    @param[in] packet - frame after stub_dataplane_process_burst
+ *    @param[in] port - port index
+ *
+ * Return Values:
+ *    @return true when the frame is sent on the port
+ */
+bool stub_dataplane_is_sent_to(
+    _In_ const stub_packet_t *packet,
+    _In_ uint32_t port
+    );
+
+/**
+ * Routine Description:
+ *    @brief Attach a switch port to a Linux network interface. Frames are
+ *    received and sent on the interface through an AF_PACKET socket.
+ *
+ * Arguments:
+ *    @param[in] port_id - switch port
+ *    @param[in] ifname - network interface name
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_dataplane_bind_port(
+    _In_ sai_object_id_t port_id,
+    _In_ const char *ifname
+    );
+
+/**
+ * Routine Description:
+ *    @brief Detach a switch port from its network interface
+ *
+ * Arguments:
+ *    @param[in] port_id - switch port
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_dataplane_unbind_port(
+    _In_ sai_object_id_t port_id
+    );
+
+/**
+ * Routine Description:
+ *    @brief Start the forwarding workers. Each worker polls its share of
+ *    the bound ports and runs every burst to completion.
+ *
+ * Arguments:
+ *    @param[in] worker_count - number of worker threads, typically one per core
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_dataplane_start(
+    _In_ uint32_t worker_count
+    );
+
+/**
+ * Routine Description:
+ *    @brief Stop the forwarding workers
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_dataplane_stop(void);
+
+/**
+ * Routine Description:
+ *    @brief Forward all frames of a pcap file as if received on one port.
+ *    Forwarded and flooded frames are written to the output pcap file.
+ *
+ * Arguments:
+ *    @param[in] in_path - input pcap file
+ *    @param[in] in_port - ingress port of the frames
+ *    @param[in] out_path - output pcap file, may be NULL
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_dataplane_run_pcap(
+    _In_ const char *in_path,
+    _In_ sai_object_id_t in_port,
+    _In_ const char *out_path
+    );
+
+/**
+ * Routine Description:
+ *    @brief Read the data plane counters
+ *
+ * Arguments:
+ *    @param[out] stats - counters
+ */
+void stub_dataplane_get_stats(
+    _Out_ stub_dataplane_stats_t *stats
+    );
+
+#endif /* __STUBSAIDATAPLANE_H_ */
@@ -0,0 +1,78 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#if !defined (__STUBSAIHASH_H_)
+#define __STUBSAIHASH_H_
+
+#include <saitypes.h>
+#include <saistatus.h>
+#include "stub_sai_dataplane.h"
+
+/*
+ * ECMP and LAG hash engine. The data plane picks the next hop group member
+ * of a routed frame and the LAG member it leaves on by a hash of the native
+ * fields of the hash objects set as SAI_SWITCH_ATTR_ECMP_HASH and
+ * SAI_SWITCH_ATTR_LAG_HASH. The fields a frame carries are packed into a
+ * key in a fixed order and hashed with the default algorithm and seed of
+ * the switch:
+ *
+ *   CRC    - CRC32C of the key starting from the seed, with the SSE4.2
+ *            crc32 instruction when the CPU has it
+ *   XOR    - the 32 bit words of the key XORed onto the seed, then folded
+ *   RANDOM - a per thread pseudo random number, frames of a flow spread
+ *
+ * The switch starts with an ECMP hash of the IP addresses, IP protocol and
+ * L4 ports, and a LAG hash of the header's default fields: MAC addresses,
+ * in port and ethertype.
+ */
+
+/** Hash engines of the switch */
+typedef enum _stub_hash_type_t
+{
+    /** Next hop group member of routed frames */
+    STUB_HASH_TYPE_ECMP,
+
+    /** LAG member of frames sent to a LAG */
+    STUB_HASH_TYPE_LAG,
+
+    STUB_HASH_TYPE_MAX
+
+} stub_hash_type_t;
+
+/**
+ * Routine Description:
+ *    @brief Hash a burst of frames the way the data plane does, with the
+ *    current fields, algorithm and seed of one engine
+ *
+ * Arguments:
+ *    @param[in] type - hash engine
+ *    @param[in] count - number of frames
+ *    @param[in] packets - frames, in_port set
+ *    @param[out] hashes - hash of each frame
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_hash_calculate(
+    _In_ stub_hash_type_t type,
+    _In_ uint32_t count,
+    _In_ const stub_packet_t *packets,
+    _Out_ uint32_t *hashes
+    );
+
+#endif /* __STUBSAIHASH_H_ */
@@ -0,0 +1,162 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#if !defined (__STUBSAIHOSTIF_H_)
+#define __STUBSAIHOSTIF_H_
+
+#include <saitypes.h>
+#include <saistatus.h>
+#include <saihostintf.h>
+
+/*
+ * Kernel interfaces behind host interfaces of type SAI_HOSTIF_TYPE_NETDEV.
+ * Interfaces are created and deleted over one persistent NETLINK_ROUTE
+ * socket, no shell is run. Between stub_host_interface_bulk_begin and
+ * stub_host_interface_bulk_commit the kernel requests of all host interface
+ * creates and removes are sent as one netlink batch.
+ *
+ * A TAP interface is the wire of its host interface port. send_packet writes
+ * frames into the TAP, frames the kernel sends on the TAP are received on
+ * the port. With an on_packet_event notification they are delivered by an
+ * I/O thread polling all TAPs, otherwise recv_packet reads them.
+ *
+ * Traps. The data plane classifies control frames to a trap id, the trap
+ * action decides whether the host gets the frame and the trap group polices
+ * what reaches the host with its SAI_HOSTIF_TRAP_GROUP_ATTR_POLICER.
+ * Trapped frames are handed over once per burst, ordered by the CPU queue
+ * of their trap group, to the on_packet_event notification or the host
+ * interface of the trap channel.
+ */
+
+/** Frames read from one TAP per I/O thread wakeup */
+#define STUB_HOSTIF_BURST     32
+
+/** Largest frame a host interface receives */
+#define STUB_HOSTIF_MAX_FRAME 9216
+
+/** Switch profile key selecting the kernel interface kind: "dummy" (default), "tap" or "none" */
+#define STUB_HOSTIF_NETDEV_PROFILE_KEY "SAI_STUB_HOSTIF_NETDEV"
+
+/**
+ *  @brief Kernel interface created for a netdev host interface
+ */
+typedef enum _stub_hostif_netdev_kind_t
+{
+    /** Dummy interface, created over netlink */
+    STUB_HOSTIF_NETDEV_DUMMY,
+
+    /** TAP interface, lives as long as the host interface */
+    STUB_HOSTIF_NETDEV_TAP,
+
+    /** No kernel interface, host interfaces only exist in the stub */
+    STUB_HOSTIF_NETDEV_NONE
+
+} stub_hostif_netdev_kind_t;
+
+/**
+ *  @brief Trap group counters
+ */
+typedef struct _stub_hostif_trap_group_stats_t
+{
+    /** Trapped frames handed to the host */
+    uint64_t passed;
+
+    /** Trapped frames kept from the host by the policer or a disabled group */
+    uint64_t policed;
+
+} stub_hostif_trap_group_stats_t;
+
+/**
+ * Routine Description:
+ *    @brief Select the kernel interface kind of host interfaces created from
+ *    now on. Overrides STUB_HOSTIF_NETDEV_PROFILE_KEY.
+ *
+ * Arguments:
+ *    @param[in] kind - kernel interface kind
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_host_interface_set_netdev_kind(
+    _In_ stub_hostif_netdev_kind_t kind
+    );
+
+/**
+ * Routine Description:
+ *    @brief Start queueing the kernel requests of host interface creates and
+ *    removes. Creates and removes return once the stub object is updated,
+ *    before the kernel has seen the request.
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_host_interface_bulk_begin(void);
+
+/**
+ * Routine Description:
+ *    @brief Send the queued kernel requests as one netlink batch and wait
+ *    for all of them. Host interfaces whose kernel interface could not be
+ *    created stay without one.
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS if every request succeeded
+ *            Failure status code if any request failed
+ */
+sai_status_t stub_host_interface_bulk_commit(void);
+
+/**
+ * Routine Description:
+ *    @brief Send several frames through a TAP backed host interface. Same
+ *    as send_packet for each frame, with one host interface lookup.
+ *
+ * Arguments:
+ *    @param[in] hif_id - host interface id
+ *    @param[in] count - number of frames
+ *    @param[in] buffers - frames
+ *    @param[in] sizes - frame lengths in bytes
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS if every frame was sent
+ *            Failure status code on error
+ */
+sai_status_t stub_host_interface_send_bulk(
+    _In_ sai_object_id_t hif_id,
+    _In_ uint32_t count,
+    _In_ const void **buffers,
+    _In_ const sai_size_t *sizes
+    );
+
+/**
+ * Routine Description:
+ *    @brief Read the counters of a trap group
+ *
+ * Arguments:
+ *    @param[in] trap_group_id - trap group id
+ *    @param[out] stats - counters
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_host_interface_get_trap_group_stats(
+    _In_ sai_object_id_t trap_group_id,
+    _Out_ stub_hostif_trap_group_stats_t *stats
+    );
+
+#endif /* __STUBSAIHOSTIF_H_ */
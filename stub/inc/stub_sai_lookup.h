@@ -0,0 +1,111 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#if !defined (__STUBSAILOOKUP_H_)
+#define __STUBSAILOOKUP_H_
+
+#include <saitypes.h>
+#include <saistatus.h>
+
+/*
+ * Software forwarding lookup over the stub tables. Resolves a destination the
+ * way the forwarding pipeline would: route LPM, next hop group member, next
+ * hop, router interface, neighbor and, for VLAN interfaces, FDB.
+ */
+
+/**
+ *  @brief Result of one forwarding lookup
+ */
+typedef struct _stub_forwarding_result_t
+{
+    /** SAI_STATUS_SUCCESS when resolved down to the egress port or stopped by
+     *  a non forward action, SAI_STATUS_ITEM_NOT_FOUND when a stage is missing.
+     *  The fields of the stages that were reached are filled in either case */
+    sai_status_t status;
+
+    /** Action of the route, interface or neighbor that decided the packet [sai_packet_action_t].
+     *  SAI_PACKET_ACTION_DROP on route miss, SAI_PACKET_ACTION_TRAP on unresolved neighbor */
+    sai_int32_t packet_action;
+
+    /** Selected next hop, SAI_NULL_OBJECT_ID for directly connected routes */
+    sai_object_id_t next_hop_id;
+
+    /** Egress router interface */
+    sai_object_id_t rif_id;
+
+    /** Egress port */
+    sai_object_id_t port_id;
+
+    /** Egress VLAN for VLAN router interfaces, 0 otherwise */
+    sai_vlan_id_t vlan_id;
+
+    /** Rewritten source MAC */
+    sai_mac_t src_mac;
+
+    /** Rewritten destination MAC */
+    sai_mac_t dst_mac;
+
+} stub_forwarding_result_t;
+
+/**
+ * Routine Description:
+ *    @brief Resolve forwarding of one destination
+ *
+ * Arguments:
+ *    @param[in] vr_id - virtual router id
+ *    @param[in] dst_ip - destination address
+ *    @param[in] flow_hash - flow hash, selects the next hop group member
+ *    @param[out] result - lookup result
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS if the lookup ran, resolution status is in result
+ *            Failure status code on error
+ */
+sai_status_t stub_lookup_forwarding(
+    _In_ sai_object_id_t vr_id,
+    _In_ const sai_ip_address_t *dst_ip,
+    _In_ uint32_t flow_hash,
+    _Out_ stub_forwarding_result_t *result
+    );
+
+/**
+ * Routine Description:
+ *    @brief Resolve forwarding of several destinations in one virtual router.
+ *    Equivalent to calling stub_lookup_forwarding for each destination, but
+ *    the route lookups of the batch walk the trie together and overlap
+ *    their cache misses.
+ *
+ * Arguments:
+ *    @param[in] vr_id - virtual router id
+ *    @param[in] count - number of destinations
+ *    @param[in] dst_ip - destination addresses
+ *    @param[in] flow_hash - flow hashes, may be NULL to use 0 for all
+ *    @param[out] results - lookup results
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS if the lookups ran, resolution status is in results
+ *            Failure status code on error
+ */
+sai_status_t stub_lookup_forwarding_bulk(
+    _In_ sai_object_id_t vr_id,
+    _In_ uint32_t count,
+    _In_ const sai_ip_address_t *dst_ip,
+    _In_ const uint32_t *flow_hash,
+    _Out_ stub_forwarding_result_t *results
+    );
+
+#endif /* __STUBSAILOOKUP_H_ */
@@ -0,0 +1,151 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#if !defined (__STUBSAIMIRROR_H_)
+#define __STUBSAIMIRROR_H_
+
+#include <saitypes.h>
+#include <saistatus.h>
+#include <saimirror.h>
+#include "stub_sai_dataplane.h"
+
+/*
+ * Mirror sessions of the software data plane. Ports bind up to
+ * STUB_MIRROR_PORT_SESSIONS sessions with SAI_PORT_ATTR_INGRESS_MIRROR_SESSION
+ * and SAI_PORT_ATTR_EGRESS_MIRROR_SESSION. Ingress sessions mirror the
+ * frames a port receives as they arrive, dropped ones too; egress sessions
+ * the frames forwarded or flooded to a port, as rewritten. Each session
+ * makes a clone of the first TRUNCATE_SIZE bytes of the frame, all of it
+ * when 0, behind the session encapsulation:
+ *
+ *   SAI_MIRROR_TYPE_LOCAL           - none
+ *   SAI_MIRROR_TYPE_REMOTE          - a VLAN tag of VLAN_TPID, VLAN_PRI,
+ *                                     VLAN_CFI and VLAN_ID after the MAC
+ *                                     addresses of the frame
+ *   SAI_MIRROR_TYPE_ENHANCED_REMOTE - Ethernet from SRC_MAC_ADDRESS to
+ *                                     DST_MAC_ADDRESS, tagged when VLAN_ID
+ *                                     is not 0, IPv4 or IPv6 by
+ *                                     IPHDR_VERSION with TOS, TTL and the
+ *                                     addresses, then a GRE header of
+ *                                     GRE_PROTOCOL_TYPE
+ *
+ * A session builds its encapsulation once, at create and on every set. Per
+ * clone the header is copied and its IP length and IPv4 checksum patched.
+ * The mirrored bytes of a frame are copied once per direction into a
+ * reference counted buffer all its clones point to, as many bytes as the
+ * longest of them takes. Clones leave on MONITOR_PORT without lookups: the
+ * I/O loop sends them with the burst they come from, as a header and a
+ * data segment, and the pcap run writes them after the forwarded frames.
+ * Clones are not mirrored again. Frames shorter than an Ethernet header
+ * are not mirrored.
+ */
+
+/** Sessions */
+#define STUB_MIRROR_SESSIONS 16
+
+/** Sessions a port binds per direction */
+#define STUB_MIRROR_PORT_SESSIONS 4
+
+/** Longest encapsulation: Ethernet with a VLAN tag, IPv6 and GRE */
+#define STUB_MIRROR_MAX_HEADER 64
+
+/** Shortest TRUNCATE_SIZE other than 0, an Ethernet header */
+#define STUB_MIRROR_MIN_TRUNCATE 14
+
+/** Clones of a burst when every frame goes to all sessions of its port */
+#define STUB_MIRROR_BURST_CLONES (STUB_DATAPLANE_BURST * STUB_MIRROR_PORT_SESSIONS)
+
+/** Mirrored bytes of a frame, shared by its clones */
+typedef struct _stub_mirror_buffer_t stub_mirror_buffer_t;
+
+/**
+ *  @brief One clone of a mirrored frame
+ */
+typedef struct _stub_mirror_packet_t
+{
+    /** Encapsulation, the frame MAC addresses and the VLAN tag for RSPAN */
+    uint8_t header[STUB_MIRROR_MAX_HEADER];
+
+    /** Encapsulation length in bytes */
+    uint32_t header_length;
+
+    /** Mirrored bytes after the header, in the shared buffer */
+    const uint8_t *data;
+
+    /** Mirrored length in bytes */
+    uint32_t length;
+
+    /** Index of the mirrored frame in the burst */
+    uint32_t packet_index;
+
+    /** Session making the clone */
+    sai_object_id_t session_id;
+
+    /** Port the clone leaves on */
+    sai_object_id_t monitor_port;
+
+    /** Traffic class of the session [sai_cos_t] */
+    sai_cos_t tc;
+
+    /** Reference held by the clone */
+    stub_mirror_buffer_t *buffer;
+
+} stub_mirror_packet_t;
+
+/**
+ * Routine Description:
+ *    @brief Clone a burst of frames for the mirror sessions of their ports.
+ *    Ingress clones are taken before stub_dataplane_process_burst, egress
+ *    ones after. Clones past the capacity are not made.
+ *
+ * Arguments:
+ *    @param[in] ingress - true for the sessions of the ingress ports,
+ *                         false for those of the egress ports
+ *    @param[in] count - number of frames
+ *    @param[in] packets - frames
+ *    @param[in] capacity - clones that fit in clones
+ *    @param[out] clones - clones, each holding a buffer reference
+ *    @param[out] clone_count - number of clones made
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_mirror_burst(
+    _In_ bool ingress,
+    _In_ uint32_t count,
+    _In_ const stub_packet_t *packets,
+    _In_ uint32_t capacity,
+    _Out_ stub_mirror_packet_t *clones,
+    _Out_ uint32_t *clone_count
+    );
+
+/**
+ * Routine Description:
+ *    @brief Drop the buffer references of clones. A buffer goes back to
+ *    the cache of the calling thread with its last reference.
+ *
+ * Arguments:
+ *    @param[in] count - number of clones
+ *    @param[inout] clones - clones of stub_mirror_burst
+ */
+void stub_mirror_release(
+    _In_ uint32_t count,
+    _Inout_ stub_mirror_packet_t *clones
+    );
+
+#endif /* __STUBSAIMIRROR_H_ */
@@ -0,0 +1,80 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#if !defined (__STUBSAIPOLICER_H_)
+#define __STUBSAIPOLICER_H_
+
+#include <saitypes.h>
+#include <saistatus.h>
+#include "stub_sai_dataplane.h"
+
+/*
+ * Policers. A policer colors frames with token buckets that are refilled
+ * from the monotonic clock when frames arrive, not by a timer:
+ *
+ *   Sr_TCM        - RFC 2697, CIR fills the committed bucket of CBS bytes
+ *                   or packets, its overflow the excess bucket of PBS
+ *   Tr_TCM        - RFC 2698, CIR fills the committed bucket of CBS, PIR
+ *                   the peak bucket of PBS
+ *   STORM_CONTROL - CIR fills the committed bucket of CBS, frames are green
+ *                   or red
+ *
+ * Rates are per second and, like bursts, in bytes or packets by the meter
+ * type, up to 10^9. Buckets start full and refill whenever the rates or
+ * bursts change. Frames enter the switch with the color of the ingress
+ * port QoS maps, see stub_sai_qos_map.h; color aware policers never give a
+ * frame a better color than that, color blind ones take every frame as
+ * green. Each color counts packets and bytes,
+ * SAI_POLICER_ATTR_ENABLE_COUNTER_LIST is kept for reading back.
+ *
+ * Frames get the action of their color; DROP and DENY drop them, the other
+ * actions let them go on. The data plane meters the frames of a burst per
+ * policer, taking each policer once, for:
+ *
+ *   SAI_PORT_ATTR_POLICER_ID                  - frames received on the port
+ *   SAI_PORT_ATTR_*_STORM_CONTROL_POLICER_ID  - frames the port floods, by
+ *                                               broadcast, multicast or
+ *                                               unknown unicast destination
+ *   SAI_ACL_ENTRY_ATTR_ACTION_SET_POLICER     - frames hitting the entry,
+ *                                               the first policed hit wins
+ *   SAI_HOSTIF_TRAP_GROUP_ATTR_POLICER        - frames trapped to the host
+ *                                               through the group
+ */
+
+/**
+ * Routine Description:
+ *    @brief Meter a burst of frames through a policer the way the data plane
+ *    does, taking tokens and counting the frames
+ *
+ * Arguments:
+ *    @param[in] policer_id - policer
+ *    @param[in] count - number of frames
+ *    @param[in] packets - frames
+ *    @param[out] colors - color of each frame [sai_packet_color_t]
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_policer_meter(
+    _In_ sai_object_id_t policer_id,
+    _In_ uint32_t count,
+    _In_ const stub_packet_t *packets,
+    _Out_ sai_packet_color_t *colors
+    );
+
+#endif /* __STUBSAIPOLICER_H_ */
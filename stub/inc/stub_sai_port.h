@@ -0,0 +1,66 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#if !defined (__STUBSAIPORT_H_)
+#define __STUBSAIPORT_H_
+
+#include <saitypes.h>
+#include <saistatus.h>
+#include <saiport.h>
+
+/*
+ * Port counters. Every sai_port_stat_counter_t of every port is a 64-bit
+ * counter, split in per-core shards that the software data plane adds to
+ * without locks. Reads sum the shards. A clear-on-read takes each shard
+ * counter with an atomic exchange, an increment is either in the value
+ * read or left in the counter, never lost.
+ *
+ * The data plane maintains the IF_IN/IF_OUT counters, the ETHER_STATS
+ * counters of received frames and the ETHER_IN/ETHER_OUT frame size
+ * counters. Frame sizes include the 4 byte FCS the data plane never sees.
+ */
+
+/** Number of port counters, counter ids are 0 to STUB_PORT_STAT_COUNT - 1 */
+#define STUB_PORT_STAT_COUNT (SAI_PORT_STAT_ETHER_OUT_PKTS_9217_TO_16383_OCTETS + 1)
+
+/**
+ * Routine Description:
+ *    @brief Read the same counters of several ports in one call
+ *
+ * Arguments:
+ *    @param[in] port_count - number of ports
+ *    @param[in] port_ids - ports
+ *    @param[in] number_of_counters - number of counters per port
+ *    @param[in] counter_ids - counters
+ *    @param[in] clear - clear each counter as it is read
+ *    @param[out] counters - port_count rows of number_of_counters values,
+ *                           in the order of port_ids and counter_ids
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error, no counter is cleared then
+ */
+sai_status_t stub_port_get_stats_bulk(
+    _In_ uint32_t port_count,
+    _In_ const sai_object_id_t *port_ids,
+    _In_ uint32_t number_of_counters,
+    _In_ const sai_port_stat_counter_t *counter_ids,
+    _In_ bool clear,
+    _Out_ uint64_t *counters
+    );
+
+#endif /* __STUBSAIPORT_H_ */
@@ -0,0 +1,54 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#if !defined (__STUBSAIQOSMAP_H_)
+#define __STUBSAIQOSMAP_H_
+
+/*
+ * QoS maps. Each map list compiles into a flat table indexed by its key,
+ * 64 entries for DSCP keys, 8 for DOT1P, TC and PFC priority keys, and
+ * 8 x 3 for TC and color keys. Keys appear at most once, keys left out map
+ * to traffic class 0, green, queue 0, priority group 0, DSCP 0 or DOT1P 0.
+ * Setting a new list compiles a new table and swaps it in; the data plane
+ * reads the tables without locks and sees either table, never a mix.
+ *
+ * Ports bind maps of the matching type with the SAI_PORT_ATTR_QOS_*_MAP
+ * attributes. At ingress the data plane gives each frame:
+ *
+ *   tc             - DSCP_TO_TC of IP frames, else DOT1P_TO_TC of VLAN
+ *                    tagged frames, else SAI_PORT_ATTR_QOS_DEFAULT_TC
+ *   color          - DSCP_TO_COLOR of IP frames, else DOT1P_TO_COLOR of
+ *                    VLAN tagged frames, else green. Color aware policers
+ *                    meter by it
+ *   priority group - TC_TO_PRIORITY_GROUP by the traffic class, the buffer
+ *                    accounts the frame to it (stub_sai_buffer.h)
+ *
+ * and once forwarded, the queue TC_TO_QUEUE of the egress port gives it,
+ * of the ingress port for flooded frames. The remarking and PFC maps are
+ * kept and bound, the data plane does not apply them.
+ */
+
+/** Traffic classes, TC keys and values are below */
+#define STUB_QOS_TRAFFIC_CLASSES 8
+
+/** Queues per port, queue values are below */
+#define STUB_QOS_QUEUES 8
+
+/** Priority groups per port, priority group values are below */
+#define STUB_QOS_PRIORITY_GROUPS 8
+
+#endif /* __STUBSAIQOSMAP_H_ */
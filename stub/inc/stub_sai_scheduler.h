@@ -0,0 +1,113 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#if !defined (__STUBSAISCHEDULER_H_)
+#define __STUBSAISCHEDULER_H_
+
+#include <saitypes.h>
+#include <saistatus.h>
+#include "stub_sai_dataplane.h"
+
+/*
+ * Egress queues and schedulers, simulated. Each port has STUB_QOS_QUEUES
+ * queues, rings of frame descriptors (length and color, not the frame
+ * itself) that stub_scheduler_enqueue fills from processed bursts, each
+ * frame on queue packet->queue of every port it is sent to. A full ring
+ * drops the frame at its tail, as does the shared buffer when it has no
+ * room for it (stub_sai_buffer.h). stub_scheduler_transmit drains a port
+ * on a simulated clock, frame after frame at a given line rate, so
+ * congestion runs are repeatable and need no timers. Queue statistics
+ * count what was sent and dropped, per color, and the occupancy and its
+ * watermark.
+ *
+ * A port schedules its queues itself until a level 0 scheduler group is
+ * created on it; from then on the tree under that group decides, and
+ * queues outside the tree are not served. Groups of level n + 1 and queues
+ * are children of level n groups on the same port, each with one parent.
+ *
+ * The scheduler profile of a queue or group says how its parent serves it:
+ *
+ *   MIN_BANDWIDTH_RATE - children below their guaranteed rate go first
+ *   STRICT             - then strict children, the last added first (so
+ *                        queue 7 before queue 0 on ports without groups)
+ *   WRR, DWRR          - then the others in deficit round robin, WRR
+ *                        children WEIGHT frames and DWRR ones WEIGHT times
+ *                        STUB_SCHEDULER_QUANTUM bytes a round
+ *   MAX_BANDWIDTH_RATE - a shaper, children past it wait for tokens
+ *
+ * Rates and bursts are in bytes or packets by SHAPER_TYPE; a zero burst
+ * holds one frame of STUB_DATAPLANE_MAX_FRAME bytes, or one packet. The
+ * profile of a port, SAI_PORT_ATTR_QOS_SCHEDULER_PROFILE_ID, shapes the
+ * port by its maximum rate alone. Without a profile children are WRR of
+ * weight 1 without shapers.
+ */
+
+/** Frames a queue holds at most */
+#define STUB_SCHEDULER_QUEUE_FRAMES 1024
+
+/** Scheduler group levels, level 0 is the root of a port */
+#define STUB_SCHEDULER_LEVELS 4
+
+/** Children of a scheduler group at most */
+#define STUB_SCHEDULER_MAX_CHILDS 32
+
+/** DWRR bytes per unit of weight and round */
+#define STUB_SCHEDULER_QUANTUM 1536
+
+/**
+ * Routine Description:
+ *    @brief Queue the forwarded frames of a processed burst on their egress
+ *    ports, flooded frames on every port but the ingress one
+ *
+ * Arguments:
+ *    @param[in] count - number of frames
+ *    @param[inout] packets - frames the data plane processed, WRED may mark
+ *                            them Congestion Experienced
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_scheduler_enqueue(
+    _In_ uint32_t count,
+    _Inout_ stub_packet_t *packets
+    );
+
+/**
+ * Routine Description:
+ *    @brief Run the egress scheduler of a port for a simulated interval,
+ *    sending frames back to back at the line rate. A frame sent past the
+ *    end of the interval takes its time from the next one
+ *
+ * Arguments:
+ *    @param[in] port_id - port
+ *    @param[in] interval_ns - simulated nanoseconds to run
+ *    @param[in] line_rate - port rate in bytes per second
+ *    @param[out] count - frames sent
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_scheduler_transmit(
+    _In_ sai_object_id_t port_id,
+    _In_ uint64_t interval_ns,
+    _In_ uint64_t line_rate,
+    _Out_ uint32_t *count
+    );
+
+#endif /* __STUBSAISCHEDULER_H_ */
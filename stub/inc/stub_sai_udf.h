@@ -0,0 +1,73 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#if !defined (__STUBSAIUDF_H_)
+#define __STUBSAIUDF_H_
+
+#include <saitypes.h>
+#include <saistatus.h>
+#include "stub_sai_dataplane.h"
+
+/*
+ * User defined fields. A UDF group names length bytes of a frame, its UDFs
+ * say where to take them from: each UDF pairs a UDF match, a rule on the
+ * ethertype, IP protocol and GRE protocol type of the frame, with a base
+ * header and a byte offset from it. The first UDF whose match hits, by
+ * match priority, gives the bytes; frames no UDF matches and frames too
+ * short for the bytes give zeros.
+ *
+ * Whenever a UDF changes, the UDFs of its group are compiled into a
+ * program: the match rules as value and mask pairs sorted by priority, each
+ * with its base and offset resolved. Extraction tests all rules of the
+ * program with bitwise operations, picks the first hit and copies the
+ * bytes, without per field decisions. Hash objects add the bytes of their
+ * SAI_HASH_UDF_GROUP_LIST groups to the hash key, masked with the UDF hash
+ * mask; ACL tables match them through the
+ * SAI_ACL_TABLE_ATTR_USER_DEFINED_FIELD_GROUP_MIN attributes.
+ *
+ * L3 starts past the Ethernet header and up to two VLAN tags, L4 past the
+ * IPv4 header or the fixed IPv6 header, and only on first fragments.
+ */
+
+/** Bytes of a UDF group at most */
+#define STUB_UDF_GROUP_MAX_LENGTH 16
+
+/**
+ * Routine Description:
+ *    @brief Extract the bytes of a UDF group from a burst of frames the way
+ *    the hash engine and ACL tables do
+ *
+ * Arguments:
+ *    @param[in] udf_group_id - UDF group
+ *    @param[in] count - number of frames
+ *    @param[in] packets - frames
+ *    @param[in] hash - apply the UDF hash masks
+ *    @param[out] bytes - group length bytes per frame, frame after frame
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_udf_extract(
+    _In_ sai_object_id_t udf_group_id,
+    _In_ uint32_t count,
+    _In_ const stub_packet_t *packets,
+    _In_ bool hash,
+    _Out_ uint8_t *bytes
+    );
+
+#endif /* __STUBSAIUDF_H_ */
@@ -0,0 +1,70 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#if !defined (__STUBSAIWRED_H_)
+#define __STUBSAIWRED_H_
+
+#include <saitypes.h>
+#include <saiqueue.h>
+#include "stub_sai_scheduler.h"
+
+/*
+ * WRED profiles, applied by the simulated queues of stub_sai_scheduler.h
+ * to the frames stub_scheduler_enqueue offers them, before the tail drop.
+ * Queues bind a profile with SAI_QUEUE_ATTR_WRED_PROFILE_ID.
+ *
+ * Each queue keeps an average of its occupancy in bytes, moved on every
+ * offered frame by avg += (occupancy - avg) / 2^WEIGHT, so a weight of 0
+ * follows the occupancy itself. For a color enabled in the profile the
+ * average decides:
+ *
+ *   below MIN_THRESHOLD       - the frame is queued
+ *   MIN to MAX_THRESHOLD      - dropped with a probability growing linearly
+ *                               from 0 to DROP_PROBABILITY percent
+ *   MAX_THRESHOLD and above   - dropped
+ *
+ * With ECN_MARK_ENABLE, frames the ramp would drop are queued with
+ * Congestion Experienced instead when IPv4 or IPv6 says they are ECN
+ * capable; the mark is written into the frame, the IPv4 header checksum
+ * updated. A flooded frame marked on one port keeps the mark on the ports
+ * after it. Frames of colors not enabled see the tail drop only.
+ *
+ * The decision takes integer math alone and a pseudo random number of the
+ * calling thread. A set compiles the profile again and the queues switch
+ * to the new copy at once. WRED drops count in SAI_QUEUE_STAT_*DISCARD_DROPPED_*
+ * and, with the tail drops, in SAI_QUEUE_STAT_*DROPPED_*; marks count in
+ * the counters below.
+ */
+
+/** Queue counters of the stub, after the SAI ones */
+typedef enum _stub_queue_stat_counter_t
+{
+    /** Frames queued with Congestion Experienced [uint64_t] */
+    STUB_QUEUE_STAT_ECN_MARKED_PACKETS = SAI_QUEUE_STAT_CUSTOM_RANGE_BASE,
+
+    /** Bytes of those frames [uint64_t] */
+    STUB_QUEUE_STAT_ECN_MARKED_BYTES,
+
+} stub_queue_stat_counter_t;
+
+/** Highest threshold, the bytes of a queue full of the largest frames */
+#define STUB_WRED_MAX_THRESHOLD (STUB_SCHEDULER_QUEUE_FRAMES * STUB_DATAPLANE_MAX_FRAME)
+
+/** Highest SAI_WRED_ATTR_WEIGHT */
+#define STUB_WRED_MAX_WEIGHT 15
+
+#endif /* __STUBSAIWRED_H_ */
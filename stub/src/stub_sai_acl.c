@@ -0,0 +1,4277 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#include "sai.h"
+#include "stub_sai.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_acl.h"
+#include "stub_sai_udf.h"
+#include "assert.h"
+#include "inttypes.h"
+#include <stddef.h>
+
+#undef  __MODULE__
+#define __MODULE__ SAI_ACL
+
+static const sai_attribute_entry_t acl_table_attribs[] = {
+    { SAI_ACL_TABLE_ATTR_STAGE, true, true, false, true,
+      "ACL table stage", SAI_ATTR_VAL_TYPE_S32 },
+    { SAI_ACL_TABLE_ATTR_PRIORITY, true, true, false, true,
+      "ACL table priority", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_ACL_TABLE_ATTR_SIZE, false, true, false, true,
+      "ACL table size", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_ACL_TABLE_ATTR_GROUP_ID, false, true, false, true,
+      "ACL table group id", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_ACL_TABLE_ATTR_FIELD_SRC_IPv6, false, true, false, true,
+      "ACL table field source IPv6", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_DST_IPv6, false, true, false, true,
+      "ACL table field destination IPv6", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_SRC_MAC, false, true, false, true,
+      "ACL table field source MAC", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_DST_MAC, false, true, false, true,
+      "ACL table field destination MAC", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_SRC_IP, false, true, false, true,
+      "ACL table field source IPv4", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_DST_IP, false, true, false, true,
+      "ACL table field destination IPv4", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_IN_PORTS, false, true, false, true,
+      "ACL table field in ports", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_OUT_PORTS, false, true, false, true,
+      "ACL table field out ports", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_IN_PORT, false, true, false, true,
+      "ACL table field in port", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_OUT_PORT, false, true, false, true,
+      "ACL table field out port", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_SRC_PORT, false, true, false, true,
+      "ACL table field source port", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_OUTER_VLAN_ID, false, true, false, true,
+      "ACL table field outer VLAN id", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_OUTER_VLAN_PRI, false, true, false, true,
+      "ACL table field outer VLAN priority", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_OUTER_VLAN_CFI, false, true, false, true,
+      "ACL table field outer VLAN CFI", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_INNER_VLAN_ID, false, true, false, true,
+      "ACL table field inner VLAN id", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_INNER_VLAN_PRI, false, true, false, true,
+      "ACL table field inner VLAN priority", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_INNER_VLAN_CFI, false, true, false, true,
+      "ACL table field inner VLAN CFI", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_L4_SRC_PORT, false, true, false, true,
+      "ACL table field L4 source port", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_L4_DST_PORT, false, true, false, true,
+      "ACL table field L4 destination port", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_ETHER_TYPE, false, true, false, true,
+      "ACL table field ethertype", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_IP_PROTOCOL, false, true, false, true,
+      "ACL table field IP protocol", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_DSCP, false, true, false, true,
+      "ACL table field DSCP", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_ECN, false, true, false, true,
+      "ACL table field ECN", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_TTL, false, true, false, true,
+      "ACL table field TTL", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_TOS, false, true, false, true,
+      "ACL table field TOS", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_IP_FLAGS, false, true, false, true,
+      "ACL table field IP flags", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_TCP_FLAGS, false, true, false, true,
+      "ACL table field TCP flags", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_IP_TYPE, false, true, false, true,
+      "ACL table field IP type", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_IP_FRAG, false, true, false, true,
+      "ACL table field IP fragment", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_IPv6_FLOW_LABEL, false, true, false, true,
+      "ACL table field IPv6 flow label", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_TC, false, true, false, true,
+      "ACL table field traffic class", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_ICMP_TYPE, false, true, false, true,
+      "ACL table field ICMP type", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_ICMP_CODE, false, true, false, true,
+      "ACL table field ICMP code", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_VLAN_TAGS, false, true, false, true,
+      "ACL table field VLAN tags", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_FDB_DST_USER_META, false, true, false, true,
+      "ACL table field FDB user meta", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_ROUTE_DST_USER_META, false, true, false, true,
+      "ACL table field route user meta", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_NEIGHBOR_DST_USER_META, false, true, false, true,
+      "ACL table field neighbor user meta", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_PORT_USER_META, false, true, false, true,
+      "ACL table field port user meta", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_VLAN_USER_META, false, true, false, true,
+      "ACL table field VLAN user meta", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_ACL_USER_META, false, true, false, true,
+      "ACL table field ACL user meta", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_FDB_DST_NPU_META_HIT, false, true, false, true,
+      "ACL table field FDB hit", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_FIELD_NEIGHBOR_DST_NPU_META_HIT, false, true, false, true,
+      "ACL table field neighbor hit", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_TABLE_ATTR_USER_DEFINED_FIELD_GROUP_MIN, false, true, false, true,
+      "ACL table UDF group 0", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_ACL_TABLE_ATTR_USER_DEFINED_FIELD_GROUP_MIN + 1, false, true, false, true,
+      "ACL table UDF group 1", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_ACL_TABLE_ATTR_USER_DEFINED_FIELD_GROUP_MIN + 2, false, true, false, true,
+      "ACL table UDF group 2", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_ACL_TABLE_ATTR_USER_DEFINED_FIELD_GROUP_MIN + 3, false, true, false, true,
+      "ACL table UDF group 3", SAI_ATTR_VAL_TYPE_OID },
+    { STUB_ACL_TABLE_ATTR_BULK_UPDATE, false, false, true, true,
+      "ACL table bulk update", SAI_ATTR_VAL_TYPE_BOOL },
+    { STUB_ACL_TABLE_ATTR_LAST_UPDATE_LATENCY, false, false, false, true,
+      "ACL table last update latency", SAI_ATTR_VAL_TYPE_U64 },
+    { STUB_ACL_TABLE_ATTR_MAX_UPDATE_LATENCY, false, false, false, true,
+      "ACL table max update latency", SAI_ATTR_VAL_TYPE_U64 },
+    { STUB_ACL_TABLE_ATTR_SUBTABLE_COUNT, false, false, false, true,
+      "ACL table subtable count", SAI_ATTR_VAL_TYPE_U32 },
+    { STUB_ACL_TABLE_ATTR_CLASSIFIER_MEMORY, false, false, false, true,
+      "ACL table classifier memory", SAI_ATTR_VAL_TYPE_U64 },
+    { END_FUNCTIONALITY_ATTRIBS_ID, false, false, false, false,
+      "", SAI_ATTR_VAL_TYPE_UNDETERMINED }
+};
+
+sai_status_t stub_acl_table_attr_get(_In_ const sai_object_key_t   *key,
+                                     _Inout_ sai_attribute_value_t *value,
+                                     _In_ uint32_t                  attr_index,
+                                     _Inout_ vendor_cache_t        *cache,
+                                     void                          *arg);
+sai_status_t stub_acl_table_field_get(_In_ const sai_object_key_t   *key,
+                                      _Inout_ sai_attribute_value_t *value,
+                                      _In_ uint32_t                  attr_index,
+                                      _Inout_ vendor_cache_t        *cache,
+                                      void                          *arg);
+sai_status_t stub_acl_table_attr_set(_In_ const sai_object_key_t      *key,
+                                     _In_ const sai_attribute_value_t *value,
+                                     void                             *arg);
+sai_status_t stub_acl_table_udf_group_get(_In_ const sai_object_key_t   *key,
+                                          _Inout_ sai_attribute_value_t *value,
+                                          _In_ uint32_t                  attr_index,
+                                          _Inout_ vendor_cache_t        *cache,
+                                          void                          *arg);
+
+static const sai_vendor_attribute_entry_t acl_table_vendor_attribs[] = {
+    { SAI_ACL_TABLE_ATTR_STAGE,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_attr_get, (void*)SAI_ACL_TABLE_ATTR_STAGE,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_PRIORITY,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_attr_get, (void*)SAI_ACL_TABLE_ATTR_PRIORITY,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_SIZE,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_attr_get, (void*)SAI_ACL_TABLE_ATTR_SIZE,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_GROUP_ID,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_SRC_IPv6,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_SRC_IPv6,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_DST_IPv6,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_DST_IPv6,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_SRC_MAC,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_SRC_MAC,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_DST_MAC,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_DST_MAC,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_SRC_IP,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_SRC_IP,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_DST_IP,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_DST_IP,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_IN_PORTS,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_IN_PORTS,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_OUT_PORTS,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_OUT_PORTS,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_IN_PORT,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_IN_PORT,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_OUT_PORT,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_OUT_PORT,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_SRC_PORT,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_OUTER_VLAN_ID,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_OUTER_VLAN_ID,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_OUTER_VLAN_PRI,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_OUTER_VLAN_PRI,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_OUTER_VLAN_CFI,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_OUTER_VLAN_CFI,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_INNER_VLAN_ID,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_INNER_VLAN_ID,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_INNER_VLAN_PRI,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_INNER_VLAN_PRI,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_INNER_VLAN_CFI,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_INNER_VLAN_CFI,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_L4_SRC_PORT,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_L4_SRC_PORT,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_L4_DST_PORT,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_L4_DST_PORT,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_ETHER_TYPE,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_ETHER_TYPE,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_IP_PROTOCOL,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_IP_PROTOCOL,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_DSCP,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_DSCP,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_ECN,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_ECN,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_TTL,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_TTL,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_TOS,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_TOS,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_IP_FLAGS,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_IP_FLAGS,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_TCP_FLAGS,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_TCP_FLAGS,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_IP_TYPE,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_IP_TYPE,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_IP_FRAG,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_IP_FRAG,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_IPv6_FLOW_LABEL,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_IPv6_FLOW_LABEL,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_TC,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_ICMP_TYPE,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_ICMP_TYPE,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_ICMP_CODE,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_ICMP_CODE,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_VLAN_TAGS,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_field_get, (void*)SAI_ACL_TABLE_ATTR_FIELD_VLAN_TAGS,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_FDB_DST_USER_META,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_ROUTE_DST_USER_META,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_NEIGHBOR_DST_USER_META,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_PORT_USER_META,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_VLAN_USER_META,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_ACL_USER_META,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_FDB_DST_NPU_META_HIT,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_FIELD_NEIGHBOR_DST_NPU_META_HIT,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_USER_DEFINED_FIELD_GROUP_MIN,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_udf_group_get, (void*)0,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_USER_DEFINED_FIELD_GROUP_MIN + 1,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_udf_group_get, (void*)1,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_USER_DEFINED_FIELD_GROUP_MIN + 2,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_udf_group_get, (void*)2,
+      NULL, NULL },
+    { SAI_ACL_TABLE_ATTR_USER_DEFINED_FIELD_GROUP_MIN + 3,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_table_udf_group_get, (void*)3,
+      NULL, NULL },
+    { STUB_ACL_TABLE_ATTR_BULK_UPDATE,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_acl_table_attr_get, (void*)STUB_ACL_TABLE_ATTR_BULK_UPDATE,
+      stub_acl_table_attr_set, (void*)STUB_ACL_TABLE_ATTR_BULK_UPDATE },
+    { STUB_ACL_TABLE_ATTR_LAST_UPDATE_LATENCY,
+      { false, false, false, true },
+      { false, false, false, true },
+      stub_acl_table_attr_get, (void*)STUB_ACL_TABLE_ATTR_LAST_UPDATE_LATENCY,
+      NULL, NULL },
+    { STUB_ACL_TABLE_ATTR_MAX_UPDATE_LATENCY,
+      { false, false, false, true },
+      { false, false, false, true },
+      stub_acl_table_attr_get, (void*)STUB_ACL_TABLE_ATTR_MAX_UPDATE_LATENCY,
+      NULL, NULL },
+    { STUB_ACL_TABLE_ATTR_SUBTABLE_COUNT,
+      { false, false, false, true },
+      { false, false, false, true },
+      stub_acl_table_attr_get, (void*)STUB_ACL_TABLE_ATTR_SUBTABLE_COUNT,
+      NULL, NULL },
+    { STUB_ACL_TABLE_ATTR_CLASSIFIER_MEMORY,
+      { false, false, false, true },
+      { false, false, false, true },
+      stub_acl_table_attr_get, (void*)STUB_ACL_TABLE_ATTR_CLASSIFIER_MEMORY,
+      NULL, NULL },
+};
+
+static const sai_attribute_entry_t acl_entry_attribs[] = {
+    { SAI_ACL_ENTRY_ATTR_TABLE_ID, true, true, false, true,
+      "ACL entry table id", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_ACL_ENTRY_ATTR_PRIORITY, false, true, true, true,
+      "ACL entry priority", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_ACL_ENTRY_ATTR_ADMIN_STATE, false, true, true, true,
+      "ACL entry admin state", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_ENTRY_ATTR_FIELD_SRC_IPv6, false, true, true, true,
+      "ACL entry field source IPv6", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_DST_IPv6, false, true, true, true,
+      "ACL entry field destination IPv6", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_SRC_MAC, false, true, true, true,
+      "ACL entry field source MAC", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_DST_MAC, false, true, true, true,
+      "ACL entry field destination MAC", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_SRC_IP, false, true, true, true,
+      "ACL entry field source IPv4", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_DST_IP, false, true, true, true,
+      "ACL entry field destination IPv4", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_IN_PORTS, false, true, true, true,
+      "ACL entry field in ports", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_OUT_PORTS, false, true, true, true,
+      "ACL entry field out ports", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_IN_PORT, false, true, true, true,
+      "ACL entry field in port", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_OUT_PORT, false, true, true, true,
+      "ACL entry field out port", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_SRC_PORT, false, true, true, true,
+      "ACL entry field source port", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_OUTER_VLAN_ID, false, true, true, true,
+      "ACL entry field outer VLAN id", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_OUTER_VLAN_PRI, false, true, true, true,
+      "ACL entry field outer VLAN priority", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_OUTER_VLAN_CFI, false, true, true, true,
+      "ACL entry field outer VLAN CFI", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_INNER_VLAN_ID, false, true, true, true,
+      "ACL entry field inner VLAN id", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_INNER_VLAN_PRI, false, true, true, true,
+      "ACL entry field inner VLAN priority", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_INNER_VLAN_CFI, false, true, true, true,
+      "ACL entry field inner VLAN CFI", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_L4_SRC_PORT, false, true, true, true,
+      "ACL entry field L4 source port", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_L4_DST_PORT, false, true, true, true,
+      "ACL entry field L4 destination port", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_ETHER_TYPE, false, true, true, true,
+      "ACL entry field ethertype", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_IP_PROTOCOL, false, true, true, true,
+      "ACL entry field IP protocol", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_DSCP, false, true, true, true,
+      "ACL entry field DSCP", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_ECN, false, true, true, true,
+      "ACL entry field ECN", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_TTL, false, true, true, true,
+      "ACL entry field TTL", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_TOS, false, true, true, true,
+      "ACL entry field TOS", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_IP_FLAGS, false, true, true, true,
+      "ACL entry field IP flags", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_TCP_FLAGS, false, true, true, true,
+      "ACL entry field TCP flags", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_IP_TYPE, false, true, true, true,
+      "ACL entry field IP type", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_IP_FRAG, false, true, true, true,
+      "ACL entry field IP fragment", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_IPv6_FLOW_LABEL, false, true, true, true,
+      "ACL entry field IPv6 flow label", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_TC, false, true, true, true,
+      "ACL entry field traffic class", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_ICMP_TYPE, false, true, true, true,
+      "ACL entry field ICMP type", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_ICMP_CODE, false, true, true, true,
+      "ACL entry field ICMP code", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_VLAN_TAGS, false, true, true, true,
+      "ACL entry field VLAN tags", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_FDB_DST_USER_META, false, true, true, true,
+      "ACL entry field FDB user meta", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_ROUTE_DST_USER_META, false, true, true, true,
+      "ACL entry field route user meta", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_NEIGHBOR_USER_META, false, true, true, true,
+      "ACL entry field neighbor user meta", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_PORT_USER_META, false, true, true, true,
+      "ACL entry field port user meta", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_VLAN_USER_META, false, true, true, true,
+      "ACL entry field VLAN user meta", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_ACL_USER_META, false, true, true, true,
+      "ACL entry field ACL user meta", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_FDB_NPU_META_DST_HIT, false, true, true, true,
+      "ACL entry field FDB hit", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_FIELD_NEIGHBOR_NPU_META_DST_HIT, false, true, true, true,
+      "ACL entry field neighbor hit", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN, false, true, true, true,
+      "ACL entry field UDF 0", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN + 1, false, true, true, true,
+      "ACL entry field UDF 1", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN + 2, false, true, true, true,
+      "ACL entry field UDF 2", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN + 3, false, true, true, true,
+      "ACL entry field UDF 3", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_ACL_ENTRY_ATTR_ACTION_REDIRECT, false, true, true, true,
+      "ACL entry action redirect", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_REDIRECT_LIST, false, true, true, true,
+      "ACL entry action redirect list", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_PACKET_ACTION, false, true, true, true,
+      "ACL entry action packet action", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_FLOOD, false, true, true, true,
+      "ACL entry action flood", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_COUNTER, false, true, true, true,
+      "ACL entry action counter", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_MIRROR_INGRESS, false, true, true, true,
+      "ACL entry action ingress mirror", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_MIRROR_EGRESS, false, true, true, true,
+      "ACL entry action egress mirror", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_POLICER, false, true, true, true,
+      "ACL entry action policer", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_DECREMENT_TTL, false, true, true, true,
+      "ACL entry action decrement TTL", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_TC, false, true, true, true,
+      "ACL entry action set traffic class", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_COLOR, false, true, true, true,
+      "ACL entry action set color", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_INNER_VLAN_ID, false, true, true, true,
+      "ACL entry action set inner VLAN id", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_INNER_VLAN_PRI, false, true, true, true,
+      "ACL entry action set inner VLAN priority", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_OUTER_VLAN_ID, false, true, true, true,
+      "ACL entry action set outer VLAN id", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_OUTER_VLAN_PRI, false, true, true, true,
+      "ACL entry action set outer VLAN priority", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_SRC_MAC, false, true, true, true,
+      "ACL entry action set source MAC", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_DST_MAC, false, true, true, true,
+      "ACL entry action set destination MAC", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_SRC_IP, false, true, true, true,
+      "ACL entry action set source IPv4", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_DST_IP, false, true, true, true,
+      "ACL entry action set destination IPv4", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_SRC_IPv6, false, true, true, true,
+      "ACL entry action set source IPv6", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_DST_IPv6, false, true, true, true,
+      "ACL entry action set destination IPv6", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_DSCP, false, true, true, true,
+      "ACL entry action set DSCP", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_ECN, false, true, true, true,
+      "ACL entry action set ECN", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_L4_SRC_PORT, false, true, true, true,
+      "ACL entry action set L4 source port", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_L4_DST_PORT, false, true, true, true,
+      "ACL entry action set L4 destination port", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_INGRESS_SAMPLEPACKET_ENABLE, false, true, true, true,
+      "ACL entry action ingress sampling", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_EGRESS_SAMPLEPACKET_ENABLE, false, true, true, true,
+      "ACL entry action egress sampling", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_CPU_QUEUE, false, true, true, true,
+      "ACL entry action set CPU queue", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_ACL_META_DATA, false, true, true, true,
+      "ACL entry action set ACL meta data", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_EGRESS_BLOCK_PORT_LIST, false, true, true, true,
+      "ACL entry action egress block ports", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_USER_TRAP_ID, false, true, true, true,
+      "ACL entry action set user trap id", SAI_ATTR_VAL_TYPE_ACLACTION },
+    { END_FUNCTIONALITY_ATTRIBS_ID, false, false, false, false,
+      "", SAI_ATTR_VAL_TYPE_UNDETERMINED }
+};
+
+sai_status_t stub_acl_entry_attr_get(_In_ const sai_object_key_t   *key,
+                                     _Inout_ sai_attribute_value_t *value,
+                                     _In_ uint32_t                  attr_index,
+                                     _Inout_ vendor_cache_t        *cache,
+                                     void                          *arg);
+sai_status_t stub_acl_entry_attr_set(_In_ const sai_object_key_t      *key,
+                                     _In_ const sai_attribute_value_t *value,
+                                     void                             *arg);
+
+static const sai_vendor_attribute_entry_t acl_entry_vendor_attribs[] = {
+    { SAI_ACL_ENTRY_ATTR_TABLE_ID,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_TABLE_ID,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_PRIORITY,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_PRIORITY,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_PRIORITY },
+    { SAI_ACL_ENTRY_ATTR_ADMIN_STATE,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_ADMIN_STATE,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_ADMIN_STATE },
+    { SAI_ACL_ENTRY_ATTR_FIELD_SRC_IPv6,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_SRC_IPv6,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_SRC_IPv6 },
+    { SAI_ACL_ENTRY_ATTR_FIELD_DST_IPv6,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_DST_IPv6,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_DST_IPv6 },
+    { SAI_ACL_ENTRY_ATTR_FIELD_SRC_MAC,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_SRC_MAC,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_SRC_MAC },
+    { SAI_ACL_ENTRY_ATTR_FIELD_DST_MAC,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_DST_MAC,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_DST_MAC },
+    { SAI_ACL_ENTRY_ATTR_FIELD_SRC_IP,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_SRC_IP,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_SRC_IP },
+    { SAI_ACL_ENTRY_ATTR_FIELD_DST_IP,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_DST_IP,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_DST_IP },
+    { SAI_ACL_ENTRY_ATTR_FIELD_IN_PORTS,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_IN_PORTS,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_IN_PORTS },
+    { SAI_ACL_ENTRY_ATTR_FIELD_OUT_PORTS,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_OUT_PORTS,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_OUT_PORTS },
+    { SAI_ACL_ENTRY_ATTR_FIELD_IN_PORT,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_IN_PORT,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_IN_PORT },
+    { SAI_ACL_ENTRY_ATTR_FIELD_OUT_PORT,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_OUT_PORT,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_OUT_PORT },
+    { SAI_ACL_ENTRY_ATTR_FIELD_SRC_PORT,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_FIELD_OUTER_VLAN_ID,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_OUTER_VLAN_ID,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_OUTER_VLAN_ID },
+    { SAI_ACL_ENTRY_ATTR_FIELD_OUTER_VLAN_PRI,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_OUTER_VLAN_PRI,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_OUTER_VLAN_PRI },
+    { SAI_ACL_ENTRY_ATTR_FIELD_OUTER_VLAN_CFI,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_OUTER_VLAN_CFI,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_OUTER_VLAN_CFI },
+    { SAI_ACL_ENTRY_ATTR_FIELD_INNER_VLAN_ID,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_INNER_VLAN_ID,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_INNER_VLAN_ID },
+    { SAI_ACL_ENTRY_ATTR_FIELD_INNER_VLAN_PRI,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_INNER_VLAN_PRI,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_INNER_VLAN_PRI },
+    { SAI_ACL_ENTRY_ATTR_FIELD_INNER_VLAN_CFI,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_INNER_VLAN_CFI,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_INNER_VLAN_CFI },
+    { SAI_ACL_ENTRY_ATTR_FIELD_L4_SRC_PORT,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_L4_SRC_PORT,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_L4_SRC_PORT },
+    { SAI_ACL_ENTRY_ATTR_FIELD_L4_DST_PORT,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_L4_DST_PORT,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_L4_DST_PORT },
+    { SAI_ACL_ENTRY_ATTR_FIELD_ETHER_TYPE,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_ETHER_TYPE,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_ETHER_TYPE },
+    { SAI_ACL_ENTRY_ATTR_FIELD_IP_PROTOCOL,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_IP_PROTOCOL,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_IP_PROTOCOL },
+    { SAI_ACL_ENTRY_ATTR_FIELD_DSCP,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_DSCP,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_DSCP },
+    { SAI_ACL_ENTRY_ATTR_FIELD_ECN,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_ECN,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_ECN },
+    { SAI_ACL_ENTRY_ATTR_FIELD_TTL,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_TTL,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_TTL },
+    { SAI_ACL_ENTRY_ATTR_FIELD_TOS,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_TOS,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_TOS },
+    { SAI_ACL_ENTRY_ATTR_FIELD_IP_FLAGS,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_IP_FLAGS,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_IP_FLAGS },
+    { SAI_ACL_ENTRY_ATTR_FIELD_TCP_FLAGS,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_TCP_FLAGS,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_TCP_FLAGS },
+    { SAI_ACL_ENTRY_ATTR_FIELD_IP_TYPE,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_IP_TYPE,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_IP_TYPE },
+    { SAI_ACL_ENTRY_ATTR_FIELD_IP_FRAG,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_IP_FRAG,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_IP_FRAG },
+    { SAI_ACL_ENTRY_ATTR_FIELD_IPv6_FLOW_LABEL,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_IPv6_FLOW_LABEL,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_IPv6_FLOW_LABEL },
+    { SAI_ACL_ENTRY_ATTR_FIELD_TC,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_FIELD_ICMP_TYPE,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_ICMP_TYPE,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_ICMP_TYPE },
+    { SAI_ACL_ENTRY_ATTR_FIELD_ICMP_CODE,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_ICMP_CODE,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_ICMP_CODE },
+    { SAI_ACL_ENTRY_ATTR_FIELD_VLAN_TAGS,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_FIELD_VLAN_TAGS,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_FIELD_VLAN_TAGS },
+    { SAI_ACL_ENTRY_ATTR_FIELD_FDB_DST_USER_META,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_FIELD_ROUTE_DST_USER_META,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_FIELD_NEIGHBOR_USER_META,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_FIELD_PORT_USER_META,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_FIELD_VLAN_USER_META,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_FIELD_ACL_USER_META,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_FIELD_FDB_NPU_META_DST_HIT,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_FIELD_NEIGHBOR_NPU_META_DST_HIT,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN },
+    { SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN + 1,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)(SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN + 1),
+      stub_acl_entry_attr_set, (void*)(SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN + 1) },
+    { SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN + 2,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)(SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN + 2),
+      stub_acl_entry_attr_set, (void*)(SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN + 2) },
+    { SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN + 3,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)(SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN + 3),
+      stub_acl_entry_attr_set, (void*)(SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN + 3) },
+    { SAI_ACL_ENTRY_ATTR_ACTION_REDIRECT,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_ACTION_REDIRECT,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_ACTION_REDIRECT },
+    { SAI_ACL_ENTRY_ATTR_ACTION_REDIRECT_LIST,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_PACKET_ACTION,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_PACKET_ACTION,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_PACKET_ACTION },
+    { SAI_ACL_ENTRY_ATTR_ACTION_FLOOD,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_COUNTER,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_ACTION_COUNTER,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_ACTION_COUNTER },
+    { SAI_ACL_ENTRY_ATTR_ACTION_MIRROR_INGRESS,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_MIRROR_EGRESS,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_POLICER,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_acl_entry_attr_get, (void*)SAI_ACL_ENTRY_ATTR_ACTION_SET_POLICER,
+      stub_acl_entry_attr_set, (void*)SAI_ACL_ENTRY_ATTR_ACTION_SET_POLICER },
+    { SAI_ACL_ENTRY_ATTR_ACTION_DECREMENT_TTL,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_TC,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_COLOR,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_INNER_VLAN_ID,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_INNER_VLAN_PRI,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_OUTER_VLAN_ID,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_OUTER_VLAN_PRI,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_SRC_MAC,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_DST_MAC,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_SRC_IP,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_DST_IP,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_SRC_IPv6,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_DST_IPv6,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_DSCP,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_ECN,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_L4_SRC_PORT,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_L4_DST_PORT,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_INGRESS_SAMPLEPACKET_ENABLE,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_EGRESS_SAMPLEPACKET_ENABLE,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_CPU_QUEUE,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_ACL_META_DATA,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_EGRESS_BLOCK_PORT_LIST,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+    { SAI_ACL_ENTRY_ATTR_ACTION_SET_USER_TRAP_ID,
+      { false, false, false, false },
+      { false, false, false, false },
+      NULL, NULL,
+      NULL, NULL },
+};
+
+static const sai_attribute_entry_t acl_counter_attribs[] = {
+    { SAI_ACL_COUNTER_ATTR_TABLE_ID, true, true, false, true,
+      "ACL counter table id", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_ACL_COUNTER_ATTR_ENABLE_PACKET_COUNT, false, true, false, true,
+      "ACL counter packet count enable", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_COUNTER_ATTR_ENABLE_BYTE_COUNT, false, true, false, true,
+      "ACL counter byte count enable", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_ACL_COUNTER_ATTR_PACKETS, false, false, true, true,
+      "ACL counter packets", SAI_ATTR_VAL_TYPE_U64 },
+    { SAI_ACL_COUNTER_ATTR_BYTES, false, false, true, true,
+      "ACL counter bytes", SAI_ATTR_VAL_TYPE_U64 },
+    { END_FUNCTIONALITY_ATTRIBS_ID, false, false, false, false,
+      "", SAI_ATTR_VAL_TYPE_UNDETERMINED }
+};
+
+sai_status_t stub_acl_counter_attr_get(_In_ const sai_object_key_t   *key,
+                                       _Inout_ sai_attribute_value_t *value,
+                                       _In_ uint32_t                  attr_index,
+                                       _Inout_ vendor_cache_t        *cache,
+                                       void                          *arg);
+sai_status_t stub_acl_counter_attr_set(_In_ const sai_object_key_t      *key,
+                                       _In_ const sai_attribute_value_t *value,
+                                       void                             *arg);
+
+static const sai_vendor_attribute_entry_t acl_counter_vendor_attribs[] = {
+    { SAI_ACL_COUNTER_ATTR_TABLE_ID,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_counter_attr_get, (void*)SAI_ACL_COUNTER_ATTR_TABLE_ID,
+      NULL, NULL },
+    { SAI_ACL_COUNTER_ATTR_ENABLE_PACKET_COUNT,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_counter_attr_get, (void*)SAI_ACL_COUNTER_ATTR_ENABLE_PACKET_COUNT,
+      NULL, NULL },
+    { SAI_ACL_COUNTER_ATTR_ENABLE_BYTE_COUNT,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_acl_counter_attr_get, (void*)SAI_ACL_COUNTER_ATTR_ENABLE_BYTE_COUNT,
+      NULL, NULL },
+    { SAI_ACL_COUNTER_ATTR_PACKETS,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_acl_counter_attr_get, (void*)SAI_ACL_COUNTER_ATTR_PACKETS,
+      stub_acl_counter_attr_set, (void*)SAI_ACL_COUNTER_ATTR_PACKETS },
+    { SAI_ACL_COUNTER_ATTR_BYTES,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_acl_counter_attr_get, (void*)SAI_ACL_COUNTER_ATTR_BYTES,
+      stub_acl_counter_attr_set, (void*)SAI_ACL_COUNTER_ATTR_BYTES },
+};
+
+/* State DB *************/
+#define MAX_ACL_TABLES        16
+#define MAX_ACL_ENTRIES       32768
+#define MAX_ACL_COUNTERS      32768
+#define ACL_STAGE_COUNT       (SAI_ACL_STAGE_EGRESS + 1)
+#define ACL_FIELD_COUNT       (SAI_ACL_ENTRY_ATTR_FIELD_NEIGHBOR_NPU_META_DST_HIT - SAI_ACL_ENTRY_ATTR_FIELD_START + 1)
+#define ACL_FIELD_INDEX(attr) ((attr) - SAI_ACL_ENTRY_ATTR_FIELD_START)
+#define ACL_UDF_SLOT(attr)    ((attr) - SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN)
+#define ACL_ACTION_BIT(attr)  (1U << ((attr) - SAI_ACL_ENTRY_ATTR_ACTION_START))
+#define ACL_NO_COUNTER        UINT32_MAX
+#define ACL_NO_PORT           0xFF
+#define ACL_KEY_WORDS         12
+#define ACL_HASH_MIN_BUCKETS  8
+#define ACL_COUNTER_SHARDS    16
+#define ACL_SHARED_SHARD      (ACL_COUNTER_SHARDS - 1)
+#define ACL_NO_SHARD          UINT32_MAX
+
+#define ACL_ETH_HDR_LEN       14
+#define ACL_ETHERTYPE_VLAN    0x8100
+#define ACL_ETHERTYPE_QINQ    0x88A8
+#define ACL_ETHERTYPE_IPV4    0x0800
+#define ACL_ETHERTYPE_IPV6    0x86DD
+#define ACL_ETHERTYPE_ARP     0x0806
+#define ACL_IP_PROTO_ICMP     1
+#define ACL_IP_PROTO_TCP      6
+#define ACL_IP_PROTO_UDP      17
+#define ACL_IP_PROTO_ICMPV6   58
+
+/* IP type bits of a key, an IP type matches some of them */
+#define ACL_IP_TYPE_IP        0x01
+#define ACL_IP_TYPE_IPV4      0x02
+#define ACL_IP_TYPE_IPV6      0x04
+#define ACL_IP_TYPE_ARP       0x08
+#define ACL_IP_TYPE_ARP_REQ   0x10
+#define ACL_IP_TYPE_ARP_REPLY 0x20
+
+/* IP fragment bits of a key */
+#define ACL_IP_FRAG_FRAGMENT  0x01
+#define ACL_IP_FRAG_NON_HEAD  0x02
+
+/* Match key of a frame. Multi byte fields are in host order, except the
+ * addresses which stay in network order as SAI passes them */
+typedef union _acl_key_t {
+    struct {
+        sai_ip6_t src_ip6;
+        sai_ip6_t dst_ip6;
+        sai_ip4_t src_ip;
+        sai_ip4_t dst_ip;
+        uint32_t  flow_label;
+        uint16_t  ether_type;
+        uint16_t  outer_vlan_id;
+        uint16_t  inner_vlan_id;
+        uint16_t  l4_src_port;
+        uint16_t  l4_dst_port;
+        sai_mac_t src_mac;
+        sai_mac_t dst_mac;
+        uint8_t   outer_vlan_pri;
+        uint8_t   outer_vlan_cfi;
+        uint8_t   inner_vlan_pri;
+        uint8_t   inner_vlan_cfi;
+        uint8_t   ip_protocol;
+        uint8_t   dscp;
+        uint8_t   ecn;
+        uint8_t   ttl;
+        uint8_t   tos;
+        uint8_t   ip_flags;
+        uint8_t   tcp_flags;
+        uint8_t   icmp_type;
+        uint8_t   icmp_code;
+        uint8_t   ip_type;
+        uint8_t   ip_frag;
+        uint8_t   vlan_tags;
+        uint8_t   in_port;
+        uint8_t   out_port;
+        /* bytes of the UDF groups of the table looking the key up */
+        uint8_t   udf[STUB_ACL_TABLE_UDF_BYTES];
+    } f;
+    uint64_t words[ACL_KEY_WORDS];
+} acl_key_t;
+
+_Static_assert(sizeof(acl_key_t) == ACL_KEY_WORDS * sizeof(uint64_t), "ACL key is not made of whole words");
+
+/* Compiled entry. Never changed once published, a set replaces it */
+typedef struct _acl_rule_t {
+    acl_key_t       key;        /* match values, masked */
+    acl_key_t       mask;
+    uint32_t        hash;       /* hash of the key in its subtable */
+    uint32_t        priority;
+    uint32_t        entry;
+    uint32_t        in_ports;   /* IN_PORTS, bit per port index, 0 for any port */
+    uint32_t        out_ports;
+    uint64_t        fields;     /* bit per enabled match field */
+    uint32_t        udf_fields; /* bit per enabled UDF slot */
+    uint32_t        actions;    /* bit per enabled action */
+    sai_int32_t     ip_type;
+    sai_int32_t     ip_frag;
+    sai_int32_t     packet_action;
+    sai_object_id_t redirect;
+    uint32_t        counter;
+    /* each rule holds its own policer reference, see acl_rule_ref */
+    uint32_t        policer;
+    /* replaced during a bulk update while still in the classifier, freed
+     * by the commit. Writer side only */
+    struct _acl_rule_t *retired_next;
+} acl_rule_t;
+
+/* Rules of a hash bucket by priority, highest first. Replaced as a whole */
+typedef struct _acl_bucket_t {
+    uint32_t          count;
+    const acl_rule_t *rules[];
+} acl_bucket_t;
+
+typedef struct _acl_hash_t {
+    uint32_t      mask;
+    acl_bucket_t *buckets[];
+} acl_hash_t;
+
+/* Rules with the same field masks */
+typedef struct _acl_subtable_t {
+    acl_key_t   mask;
+    uint32_t    word_count;
+    uint8_t     words[ACL_KEY_WORDS];   /* key words the mask has bits in */
+    uint32_t    max_priority;
+    uint32_t    rule_count;
+    acl_hash_t *hash;
+} acl_subtable_t;
+
+/* Subtables of a table by highest rule priority, highest first. Replaced as
+ * a whole, the priorities are the ones the order was made with */
+typedef struct _acl_subtable_list_t {
+    uint32_t count;
+    struct {
+        acl_subtable_t *subtable;
+        uint32_t        max_priority;
+    } items[];
+} acl_subtable_list_t;
+
+/* Tables of a stage by priority, highest first. Replaced as a whole */
+typedef struct _acl_stage_list_t {
+    uint32_t count;
+    uint32_t tables[MAX_ACL_TABLES];
+} acl_stage_list_t;
+
+/* UDF group of a table and where its bytes go in the key. A zero length
+ * slot is not used */
+typedef struct _acl_udf_slot_t {
+    uint32_t group;
+    uint32_t offset;
+    uint32_t length;
+} acl_udf_slot_t;
+
+typedef struct _acl_table_t {
+    bool                 is_used;
+    sai_int32_t          stage;
+    uint32_t             priority;
+    uint32_t             size;
+    uint64_t             fields;
+    uint32_t             udf_count;
+    acl_udf_slot_t       udf[STUB_ACL_TABLE_UDF_GROUPS];
+    uint32_t             entry_count;
+    uint32_t             counter_count;
+    acl_subtable_list_t *subtables;
+    /* entry changes are staged, the classifier is rebuilt on commit */
+    bool                 bulk;
+    acl_rule_t          *retired;
+    uint64_t             last_update_ns;
+    uint64_t             max_update_ns;
+} acl_table_t;
+
+typedef struct _acl_entry_t {
+    bool            is_used;
+    bool            admin_state;
+    uint32_t        table;
+    acl_rule_t     *rule;
+    /* subtable holding the rule, NULL while the entry is disabled or the
+     * rule waits for a bulk commit */
+    acl_subtable_t *subtable;
+} acl_entry_t;
+
+typedef struct _acl_counter_t {
+    bool     is_used;
+    bool     packet_count;
+    bool     byte_count;
+    uint32_t table;
+    uint32_t ref_count;
+    /* shard sums at the last clear, the counter reads the sums minus these */
+    uint64_t packets_base;
+    uint64_t bytes_base;
+} acl_counter_t;
+
+/* One counter in one shard */
+typedef struct _acl_counter_value_t {
+    uint64_t packets;
+    uint64_t bytes;
+} acl_counter_value_t;
+
+typedef enum _acl_field_kind_t {
+    ACL_FIELD_UNSUPPORTED,
+    ACL_FIELD_RAW,
+    ACL_FIELD_PORT,
+    ACL_FIELD_PORTS,
+    ACL_FIELD_IP_TYPE,
+    ACL_FIELD_IP_FRAG,
+    ACL_FIELD_VLAN_TAGS,
+} acl_field_kind_t;
+
+typedef struct _acl_field_info_t {
+    acl_field_kind_t kind;
+    uint32_t         offset;
+    uint32_t         size;
+} acl_field_info_t;
+
+#define ACL_KEY_FIELD(name) offsetof(acl_key_t, f.name), sizeof(((acl_key_t*)NULL)->f.name)
+
+/* Where each match field sits in the key, by field index. RAW fields copy the
+ * leading bytes of the data and mask unions */
+static const acl_field_info_t acl_fields[ACL_FIELD_COUNT] = {
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_SRC_IPv6)]         = { ACL_FIELD_RAW, ACL_KEY_FIELD(src_ip6) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_DST_IPv6)]         = { ACL_FIELD_RAW, ACL_KEY_FIELD(dst_ip6) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_SRC_MAC)]          = { ACL_FIELD_RAW, ACL_KEY_FIELD(src_mac) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_DST_MAC)]          = { ACL_FIELD_RAW, ACL_KEY_FIELD(dst_mac) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_SRC_IP)]           = { ACL_FIELD_RAW, ACL_KEY_FIELD(src_ip) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_DST_IP)]           = { ACL_FIELD_RAW, ACL_KEY_FIELD(dst_ip) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_IN_PORTS)]         = { ACL_FIELD_PORTS, 0, 0 },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_OUT_PORTS)]        = { ACL_FIELD_PORTS, 0, 0 },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_IN_PORT)]          = { ACL_FIELD_PORT, ACL_KEY_FIELD(in_port) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_OUT_PORT)]         = { ACL_FIELD_PORT, ACL_KEY_FIELD(out_port) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_OUTER_VLAN_ID)]    = { ACL_FIELD_RAW, ACL_KEY_FIELD(outer_vlan_id) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_OUTER_VLAN_PRI)]   = { ACL_FIELD_RAW, ACL_KEY_FIELD(outer_vlan_pri) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_OUTER_VLAN_CFI)]   = { ACL_FIELD_RAW, ACL_KEY_FIELD(outer_vlan_cfi) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_INNER_VLAN_ID)]    = { ACL_FIELD_RAW, ACL_KEY_FIELD(inner_vlan_id) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_INNER_VLAN_PRI)]   = { ACL_FIELD_RAW, ACL_KEY_FIELD(inner_vlan_pri) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_INNER_VLAN_CFI)]   = { ACL_FIELD_RAW, ACL_KEY_FIELD(inner_vlan_cfi) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_L4_SRC_PORT)]      = { ACL_FIELD_RAW, ACL_KEY_FIELD(l4_src_port) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_L4_DST_PORT)]      = { ACL_FIELD_RAW, ACL_KEY_FIELD(l4_dst_port) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_ETHER_TYPE)]       = { ACL_FIELD_RAW, ACL_KEY_FIELD(ether_type) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_IP_PROTOCOL)]      = { ACL_FIELD_RAW, ACL_KEY_FIELD(ip_protocol) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_DSCP)]             = { ACL_FIELD_RAW, ACL_KEY_FIELD(dscp) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_ECN)]              = { ACL_FIELD_RAW, ACL_KEY_FIELD(ecn) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_TTL)]              = { ACL_FIELD_RAW, ACL_KEY_FIELD(ttl) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_TOS)]              = { ACL_FIELD_RAW, ACL_KEY_FIELD(tos) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_IP_FLAGS)]         = { ACL_FIELD_RAW, ACL_KEY_FIELD(ip_flags) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_TCP_FLAGS)]        = { ACL_FIELD_RAW, ACL_KEY_FIELD(tcp_flags) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_IP_TYPE)]          = { ACL_FIELD_IP_TYPE, ACL_KEY_FIELD(ip_type) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_IP_FRAG)]          = { ACL_FIELD_IP_FRAG, ACL_KEY_FIELD(ip_frag) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_IPv6_FLOW_LABEL)]  = { ACL_FIELD_RAW, ACL_KEY_FIELD(flow_label) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_ICMP_TYPE)]        = { ACL_FIELD_RAW, ACL_KEY_FIELD(icmp_type) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_ICMP_CODE)]        = { ACL_FIELD_RAW, ACL_KEY_FIELD(icmp_code) },
+    [ACL_FIELD_INDEX(SAI_ACL_ENTRY_ATTR_FIELD_VLAN_TAGS)]        = { ACL_FIELD_VLAN_TAGS, ACL_KEY_FIELD(vlan_tags) },
+};
+
+/* Key bits each sai_acl_ip_type_t looks at and the value they must have */
+static const struct {
+    uint8_t mask;
+    uint8_t value;
+} acl_ip_types[] = {
+    [SAI_ACL_IP_TYPE_ANY]         = { 0, 0 },
+    [SAI_ACL_IP_TYPE_IP]          = { ACL_IP_TYPE_IP, ACL_IP_TYPE_IP },
+    [SAI_ACL_IP_TYPE_NON_IP]      = { ACL_IP_TYPE_IP, 0 },
+    [SAI_ACL_IP_TYPE_IPv4ANY]     = { ACL_IP_TYPE_IPV4, ACL_IP_TYPE_IPV4 },
+    [SAI_ACL_IP_TYPE_NON_IPv4]    = { ACL_IP_TYPE_IPV4, 0 },
+    [SAI_ACL_IP_TYPE_IPv6ANY]     = { ACL_IP_TYPE_IPV6, ACL_IP_TYPE_IPV6 },
+    [SAI_ACL_IP_TYPE_NON_IPv6]    = { ACL_IP_TYPE_IPV6, 0 },
+    [SAI_ACL_IP_TYPE_ARP]         = { ACL_IP_TYPE_ARP, ACL_IP_TYPE_ARP },
+    [SAI_ACL_IP_TYPE_ARP_REQUEST] = { ACL_IP_TYPE_ARP_REQ, ACL_IP_TYPE_ARP_REQ },
+    [SAI_ACL_IP_TYPE_ARP_REPLY]   = { ACL_IP_TYPE_ARP_REPLY, ACL_IP_TYPE_ARP_REPLY },
+};
+
+/* Same for sai_acl_ip_frag_t */
+static const struct {
+    uint8_t mask;
+    uint8_t value;
+} acl_ip_frags[] = {
+    [SAI_ACL_IP_FRAG_ANY]              = { 0, 0 },
+    [SAI_ACL_IP_FRAG_NON_FRAG]         = { ACL_IP_FRAG_FRAGMENT, 0 },
+    [SAI_ACL_IP_FRAG_NON_FRAG_OR_HEAD] = { ACL_IP_FRAG_NON_HEAD, 0 },
+    [SAI_ACL_IP_FRAG_HEAD]             = { ACL_IP_FRAG_FRAGMENT | ACL_IP_FRAG_NON_HEAD, ACL_IP_FRAG_FRAGMENT },
+    [SAI_ACL_IP_FRAG_NON_HEAD]         = { ACL_IP_FRAG_NON_HEAD, ACL_IP_FRAG_NON_HEAD },
+};
+
+static acl_table_t       acl_table_db[MAX_ACL_TABLES];
+static acl_entry_t       acl_entry_db[MAX_ACL_ENTRIES];
+static acl_counter_t     acl_counter_db[MAX_ACL_COUNTERS];
+static acl_stage_list_t *acl_stages[ACL_STAGE_COUNT];
+static uint32_t          acl_entry_next;
+/* Writers take the tables exclusively, the data plane reads the compiled
+ * classifiers under RCU only */
+static pthread_rwlock_t  acl_db_lock = STUB_RWLOCK_INITIALIZER;
+
+/* Shards of the ACL counters. A data plane thread owns one of the first
+ * ACL_SHARED_SHARD shards while it lives and adds to it with plain stores;
+ * threads past those share the last shard and add with atomics. Counts
+ * stay in a shard when its thread exits, reads sum all shards in use */
+static acl_counter_value_t acl_counter_shards[ACL_COUNTER_SHARDS][MAX_ACL_COUNTERS] __attribute__((aligned(64)));
+static uint32_t            acl_counter_shards_used = 1;
+static bool                acl_counter_shard_owned[ACL_SHARED_SHARD];
+static pthread_mutex_t     acl_counter_shard_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t       acl_counter_shard_key;
+static pthread_once_t      acl_counter_shard_key_once = PTHREAD_ONCE_INIT;
+static __thread uint32_t   acl_counter_shard = ACL_NO_SHARD;
+
+/* Caller holds acl_db_lock */
+static sai_status_t acl_table_db_index(_In_ sai_object_id_t acl_table_id, _Out_ uint32_t *index)
+{
+    sai_status_t status;
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(acl_table_id, SAI_OBJECT_TYPE_ACL_TABLE, index))) {
+        return status;
+    }
+
+    if ((*index >= MAX_ACL_TABLES) || (!acl_table_db[*index].is_used)) {
+        STUB_LOG_ERR("ACL table %u does not exist\n", *index);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Caller holds acl_db_lock */
+static sai_status_t acl_entry_db_index(_In_ sai_object_id_t acl_entry_id, _Out_ uint32_t *index)
+{
+    sai_status_t status;
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(acl_entry_id, SAI_OBJECT_TYPE_ACL_ENTRY, index))) {
+        return status;
+    }
+
+    if ((*index >= MAX_ACL_ENTRIES) || (!acl_entry_db[*index].is_used)) {
+        STUB_LOG_ERR("ACL entry %u does not exist\n", *index);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Caller holds acl_db_lock */
+static sai_status_t acl_counter_db_index(_In_ sai_object_id_t acl_counter_id, _Out_ uint32_t *index)
+{
+    sai_status_t status;
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(acl_counter_id, SAI_OBJECT_TYPE_ACL_COUNTER, index))) {
+        return status;
+    }
+
+    if ((*index >= MAX_ACL_COUNTERS) || (!acl_counter_db[*index].is_used)) {
+        STUB_LOG_ERR("ACL counter %u does not exist\n", *index);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void acl_key_to_str(_In_ sai_object_id_t    object_id,
+                           _In_ sai_object_type_t  type,
+                           _In_ const char        *name,
+                           _Out_ char             *key_str)
+{
+    uint32_t index;
+
+    if (SAI_STATUS_SUCCESS != stub_object_to_type(object_id, type, &index)) {
+        snprintf(key_str, MAX_KEY_STR_LEN, "invalid ACL %s id", name);
+    } else {
+        snprintf(key_str, MAX_KEY_STR_LEN, "ACL %s id %u", name, index);
+    }
+}
+
+static inline uint16_t acl_read16(_In_ const uint8_t *data)
+{
+    return (uint16_t)((data[0] << 8) | data[1]);
+}
+
+static inline uint8_t acl_port_index(_In_ sai_object_id_t port_id)
+{
+    const stub_object_id_t *object = (const stub_object_id_t*)&port_id;
+
+    return ((SAI_OBJECT_TYPE_PORT == object->object_type) && (object->data < PORT_NUMBER)) ?
+           (uint8_t)object->data : ACL_NO_PORT;
+}
+
+static void acl_key_extract_l4(_Inout_ acl_key_t *key, _In_ const uint8_t *l4, _In_ uint32_t length,
+                               _In_ uint8_t icmp_protocol)
+{
+    if (icmp_protocol == key->f.ip_protocol) {
+        if (length >= 2) {
+            key->f.icmp_type = l4[0];
+            key->f.icmp_code = l4[1];
+        }
+        return;
+    }
+
+    if (((ACL_IP_PROTO_TCP == key->f.ip_protocol) || (ACL_IP_PROTO_UDP == key->f.ip_protocol)) && (length >= 4)) {
+        key->f.l4_src_port = acl_read16(l4);
+        key->f.l4_dst_port = acl_read16(l4 + 2);
+    }
+
+    if ((ACL_IP_PROTO_TCP == key->f.ip_protocol) && (length >= 14)) {
+        key->f.tcp_flags = l4[13] & 0x3F;
+    }
+}
+
+/* Match key of a frame, false for a frame too short for an Ethernet header */
+static bool acl_key_extract(_In_ const stub_packet_t *packet, _Out_ acl_key_t *key)
+{
+    const uint8_t *data = packet->data;
+    const uint8_t *l3;
+    uint32_t       offset = ACL_ETH_HDR_LEN, l3_length, ihl, frag;
+    uint16_t       tci;
+
+    memset(key, 0, sizeof(*key));
+
+    if (packet->length < ACL_ETH_HDR_LEN) {
+        return false;
+    }
+
+    memcpy(key->f.dst_mac, data, sizeof(sai_mac_t));
+    memcpy(key->f.src_mac, data + sizeof(sai_mac_t), sizeof(sai_mac_t));
+    key->f.in_port    = acl_port_index(packet->in_port);
+    key->f.out_port   = acl_port_index(packet->out_port);
+    key->f.ether_type = acl_read16(data + 12);
+
+    if (((ACL_ETHERTYPE_VLAN == key->f.ether_type) || (ACL_ETHERTYPE_QINQ == key->f.ether_type)) &&
+        (packet->length >= offset + 4)) {
+        tci                   = acl_read16(data + offset);
+        key->f.outer_vlan_id  = tci & 0x0FFF;
+        key->f.outer_vlan_pri = tci >> 13;
+        key->f.outer_vlan_cfi = (tci >> 12) & 0x1;
+        key->f.ether_type     = acl_read16(data + offset + 2);
+        key->f.vlan_tags      = SAI_PACKET_VLAN_SINGLE_OUTER_TAG;
+        offset               += 4;
+
+        if ((ACL_ETHERTYPE_VLAN == key->f.ether_type) && (packet->length >= offset + 4)) {
+            tci                   = acl_read16(data + offset);
+            key->f.inner_vlan_id  = tci & 0x0FFF;
+            key->f.inner_vlan_pri = tci >> 13;
+            key->f.inner_vlan_cfi = (tci >> 12) & 0x1;
+            key->f.ether_type     = acl_read16(data + offset + 2);
+            key->f.vlan_tags      = SAI_PACKET_VLAN_DOUBLE_TAG;
+            offset               += 4;
+        }
+    }
+
+    l3        = data + offset;
+    l3_length = packet->length - offset;
+
+    switch (key->f.ether_type) {
+    case ACL_ETHERTYPE_ARP:
+        key->f.ip_type = ACL_IP_TYPE_ARP;
+        if (l3_length >= 8) {
+            if (1 == acl_read16(l3 + 6)) {
+                key->f.ip_type |= ACL_IP_TYPE_ARP_REQ;
+            } else if (2 == acl_read16(l3 + 6)) {
+                key->f.ip_type |= ACL_IP_TYPE_ARP_REPLY;
+            }
+        }
+        break;
+
+    case ACL_ETHERTYPE_IPV4:
+        if ((l3_length < 20) || (4 != (l3[0] >> 4))) {
+            break;
+        }
+        ihl = (uint32_t)(l3[0] & 0x0F) * 4;
+        if ((ihl < 20) || (l3_length < ihl)) {
+            break;
+        }
+        key->f.ip_type     = ACL_IP_TYPE_IP | ACL_IP_TYPE_IPV4;
+        key->f.tos         = l3[1];
+        key->f.dscp        = l3[1] >> 2;
+        key->f.ecn         = l3[1] & 0x3;
+        key->f.ttl         = l3[8];
+        key->f.ip_protocol = l3[9];
+        key->f.ip_flags    = l3[6] >> 5;
+        /* more fragments flag and fragment offset */
+        frag = acl_read16(l3 + 6) & 0x3FFF;
+        if (0 != frag) {
+            key->f.ip_frag |= ACL_IP_FRAG_FRAGMENT;
+        }
+        if (0 != (frag & 0x1FFF)) {
+            key->f.ip_frag |= ACL_IP_FRAG_NON_HEAD;
+        }
+        memcpy(&key->f.src_ip, l3 + 12, sizeof(sai_ip4_t));
+        memcpy(&key->f.dst_ip, l3 + 16, sizeof(sai_ip4_t));
+        if (0 == (frag & 0x1FFF)) {
+            acl_key_extract_l4(key, l3 + ihl, l3_length - ihl, ACL_IP_PROTO_ICMP);
+        }
+        break;
+
+    case ACL_ETHERTYPE_IPV6:
+        if ((l3_length < 40) || (6 != (l3[0] >> 4))) {
+            break;
+        }
+        key->f.ip_type     = ACL_IP_TYPE_IP | ACL_IP_TYPE_IPV6;
+        key->f.tos         = (uint8_t)((l3[0] << 4) | (l3[1] >> 4));
+        key->f.dscp        = key->f.tos >> 2;
+        key->f.ecn         = key->f.tos & 0x3;
+        key->f.flow_label  = ((uint32_t)(l3[1] & 0x0F) << 16) | ((uint32_t)l3[2] << 8) | l3[3];
+        key->f.ip_protocol = l3[6];
+        key->f.ttl         = l3[7];
+        memcpy(key->f.src_ip6, l3 + 8, sizeof(sai_ip6_t));
+        memcpy(key->f.dst_ip6, l3 + 24, sizeof(sai_ip6_t));
+        acl_key_extract_l4(key, l3 + 40, l3_length - 40, ACL_IP_PROTO_ICMPV6);
+        break;
+
+    default:
+        break;
+    }
+
+    return true;
+}
+
+/* Hash of the key words a subtable masks in */
+static inline uint32_t acl_key_hash(_In_ const acl_key_t *key, _In_ const acl_subtable_t *subtable)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    uint32_t ii, word;
+
+    for (ii = 0; ii < subtable->word_count; ii++) {
+        word  = subtable->words[ii];
+        hash ^= key->words[word] & subtable->mask.words[word];
+        hash *= 0x100000001B3ULL;
+        hash ^= hash >> 29;
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    return (uint32_t)hash;
+}
+
+static inline bool acl_rule_match(_In_ const acl_rule_t     *rule,
+                                  _In_ const acl_key_t      *key,
+                                  _In_ const acl_subtable_t *subtable)
+{
+    uint32_t ii, word;
+
+    for (ii = 0; ii < subtable->word_count; ii++) {
+        word = subtable->words[ii];
+        if ((key->words[word] & subtable->mask.words[word]) != rule->key.words[word]) {
+            return false;
+        }
+    }
+
+    if ((0 != rule->in_ports) &&
+        ((ACL_NO_PORT == key->f.in_port) || (0 == (rule->in_ports & (1U << key->f.in_port))))) {
+        return false;
+    }
+
+    if ((0 != rule->out_ports) &&
+        ((ACL_NO_PORT == key->f.out_port) || (0 == (rule->out_ports & (1U << key->f.out_port))))) {
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Best rule of each active key of a burst. Subtables are searched burst wide,
+ * a key takes part only while the subtable can still beat its best hit, and
+ * the search stops at the first subtable no key takes part in. The bucket
+ * heads of the burst are prefetched before they are walked. Caller is in a
+ * read side section.
+ */
+static void acl_classify_keys(_In_ const acl_subtable_list_t *list,
+                              _In_ uint32_t                   count,
+                              _In_ const acl_key_t           *keys,
+                              _In_ const bool                *active,
+                              _Out_ const acl_rule_t        **hits)
+{
+    uint32_t              hashes[STUB_DATAPLANE_BURST];
+    uint32_t              probes[STUB_DATAPLANE_BURST];
+    const acl_subtable_t *subtable;
+    const acl_hash_t     *hash;
+    const acl_bucket_t   *bucket;
+    const acl_rule_t     *rule;
+    uint32_t              ii, jj, ss, probe_count, max_priority;
+
+    assert(count <= STUB_DATAPLANE_BURST);
+
+    for (ii = 0; ii < count; ii++) {
+        hits[ii] = NULL;
+    }
+
+    if (NULL == list) {
+        return;
+    }
+
+    for (ss = 0; ss < list->count; ss++) {
+        subtable     = list->items[ss].subtable;
+        max_priority = list->items[ss].max_priority;
+        hash         = STUB_RCU_DEREF(subtable->hash);
+
+        for (ii = 0, probe_count = 0; ii < count; ii++) {
+            if (!active[ii] || ((NULL != hits[ii]) && (hits[ii]->priority >= max_priority))) {
+                continue;
+            }
+            hashes[probe_count] = acl_key_hash(&keys[ii], subtable);
+            __builtin_prefetch(&hash->buckets[hashes[probe_count] & hash->mask]);
+            probes[probe_count++] = ii;
+        }
+
+        if (0 == probe_count) {
+            break;
+        }
+
+        for (ii = 0; ii < probe_count; ii++) {
+            if (NULL == (bucket = STUB_RCU_DEREF(hash->buckets[hashes[ii] & hash->mask]))) {
+                continue;
+            }
+            for (jj = 0; jj < bucket->count; jj++) {
+                rule = bucket->rules[jj];
+                if ((NULL != hits[probes[ii]]) && (rule->priority <= hits[probes[ii]]->priority)) {
+                    break;
+                }
+                if ((rule->hash == hashes[ii]) && acl_rule_match(rule, &keys[probes[ii]], subtable)) {
+                    hits[probes[ii]] = rule;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+static acl_hash_t* acl_hash_alloc(_In_ uint32_t bucket_count)
+{
+    acl_hash_t *hash;
+
+    if (NULL == (hash = calloc(1, sizeof(*hash) + bucket_count * sizeof(hash->buckets[0])))) {
+        return NULL;
+    }
+    hash->mask = bucket_count - 1;
+    return hash;
+}
+
+/* Copy of a bucket with a rule added after the rules of its priority */
+static acl_bucket_t* acl_bucket_insert(_In_ const acl_bucket_t *bucket, _In_ const acl_rule_t *rule)
+{
+    acl_bucket_t *copy;
+    uint32_t      ii = 0, count = (NULL == bucket) ? 0 : bucket->count;
+
+    if (NULL == (copy = malloc(sizeof(*copy) + (count + 1) * sizeof(copy->rules[0])))) {
+        return NULL;
+    }
+
+    copy->count = 0;
+    for (; (ii < count) && (bucket->rules[ii]->priority >= rule->priority); ii++) {
+        copy->rules[copy->count++] = bucket->rules[ii];
+    }
+    copy->rules[copy->count++] = rule;
+    for (; ii < count; ii++) {
+        copy->rules[copy->count++] = bucket->rules[ii];
+    }
+
+    return copy;
+}
+
+/* Copy of a bucket without a rule. Caller handles the last rule */
+static acl_bucket_t* acl_bucket_remove(_In_ const acl_bucket_t *bucket, _In_ const acl_rule_t *rule)
+{
+    acl_bucket_t *copy;
+    uint32_t      ii;
+
+    assert(bucket->count > 1);
+
+    if (NULL == (copy = malloc(sizeof(*copy) + (bucket->count - 1) * sizeof(copy->rules[0])))) {
+        return NULL;
+    }
+
+    copy->count = 0;
+    for (ii = 0; ii < bucket->count; ii++) {
+        if (bucket->rules[ii] != rule) {
+            copy->rules[copy->count++] = bucket->rules[ii];
+        }
+    }
+
+    return copy;
+}
+
+static void acl_hash_free(_In_ acl_hash_t *hash)
+{
+    uint32_t ii;
+
+    for (ii = 0; ii <= hash->mask; ii++) {
+        free(hash->buckets[ii]);
+    }
+    free(hash);
+}
+
+/* Same as acl_hash_free, once the readers are done */
+static void acl_hash_defer_free(_In_ acl_hash_t *hash)
+{
+    uint32_t ii;
+
+    for (ii = 0; ii <= hash->mask; ii++) {
+        stub_rcu_defer_free(hash->buckets[ii]);
+    }
+    stub_rcu_defer_free(hash);
+}
+
+/* Double the buckets of a subtable. The rules of a bucket split over two
+ * buckets of the new hash and keep their order */
+static sai_status_t acl_subtable_grow(_Inout_ acl_subtable_t *subtable)
+{
+    acl_hash_t         *hash = subtable->hash, *grown;
+    const acl_bucket_t *bucket;
+    acl_bucket_t       *split[2];
+    uint32_t            ii, jj, half, size = hash->mask + 1, counts[2];
+
+    if (NULL == (grown = acl_hash_alloc(2 * size))) {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    for (ii = 0; ii < size; ii++) {
+        if (NULL == (bucket = hash->buckets[ii])) {
+            continue;
+        }
+
+        counts[0] = counts[1] = 0;
+        for (jj = 0; jj < bucket->count; jj++) {
+            counts[(bucket->rules[jj]->hash & grown->mask) >= size]++;
+        }
+
+        for (half = 0; half < 2; half++) {
+            split[half] = NULL;
+            if ((0 != counts[half]) &&
+                (NULL == (split[half] = malloc(sizeof(*split[half]) + counts[half] * sizeof(split[half]->rules[0]))))) {
+                free(split[0]);
+                acl_hash_free(grown);
+                return SAI_STATUS_NO_MEMORY;
+            }
+            if (NULL != split[half]) {
+                split[half]->count = 0;
+            }
+        }
+
+        for (jj = 0; jj < bucket->count; jj++) {
+            half                                       = (bucket->rules[jj]->hash & grown->mask) >= size;
+            split[half]->rules[split[half]->count++]   = bucket->rules[jj];
+        }
+
+        grown->buckets[ii]        = split[0];
+        grown->buckets[ii + size] = split[1];
+    }
+
+    STUB_RCU_ASSIGN(subtable->hash, grown);
+    acl_hash_defer_free(hash);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t acl_subtable_create(_In_ const acl_key_t *mask, _In_ uint32_t bucket_count,
+                                        _Out_ acl_subtable_t **subtable)
+{
+    uint32_t ii;
+
+    if (NULL == (*subtable = calloc(1, sizeof(**subtable)))) {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    if (NULL == ((*subtable)->hash = acl_hash_alloc(bucket_count))) {
+        free(*subtable);
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    (*subtable)->mask = *mask;
+    for (ii = 0; ii < ACL_KEY_WORDS; ii++) {
+        if (0 != mask->words[ii]) {
+            (*subtable)->words[(*subtable)->word_count++] = ii;
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Room for the subtables of a table and one more */
+static acl_subtable_list_t* acl_subtable_list_alloc(_In_ const acl_table_t *table)
+{
+    uint32_t             count = (NULL == table->subtables) ? 0 : table->subtables->count;
+    acl_subtable_list_t *list;
+
+    list = malloc(sizeof(*list) + (count + 1) * sizeof(list->items[0]));
+    return list;
+}
+
+/* Publish the subtables of a table in priority order, into a list from
+ * acl_subtable_list_alloc, with one subtable added or dropped. Caller holds
+ * acl_db_lock exclusively */
+static void acl_subtable_list_publish(_Inout_ acl_table_t          *table,
+                                      _Inout_ acl_subtable_list_t  *list,
+                                      _In_ acl_subtable_t          *added,
+                                      _In_ const acl_subtable_t    *dropped)
+{
+    acl_subtable_list_t *old = table->subtables;
+    acl_subtable_t      *subtable;
+    uint32_t             ii, jj;
+
+    list->count = 0;
+    for (ii = 0; (NULL != old) && (ii < old->count); ii++) {
+        if (old->items[ii].subtable != dropped) {
+            list->items[list->count++].subtable = old->items[ii].subtable;
+        }
+    }
+    if (NULL != added) {
+        list->items[list->count++].subtable = added;
+    }
+
+    /* few subtables, insertion sort */
+    for (ii = 0; ii < list->count; ii++) {
+        subtable = list->items[ii].subtable;
+        for (jj = ii; (jj > 0) && (list->items[jj - 1].max_priority < subtable->max_priority); jj--) {
+            list->items[jj] = list->items[jj - 1];
+        }
+        list->items[jj].subtable     = subtable;
+        list->items[jj].max_priority = subtable->max_priority;
+    }
+
+    STUB_RCU_ASSIGN(table->subtables, list);
+    stub_rcu_defer_free(old);
+}
+
+/* Put a compiled rule in the subtable of its masks. Caller holds acl_db_lock exclusively */
+static sai_status_t acl_rule_insert(_Inout_ acl_table_t *table, _Inout_ acl_rule_t *rule,
+                                    _Out_ acl_subtable_t **rule_subtable)
+{
+    acl_subtable_list_t *list;
+    acl_subtable_t      *subtable = NULL;
+    acl_bucket_t        *bucket, *old;
+    sai_status_t         status;
+    uint32_t             ii, slot;
+    bool                 created = false;
+
+    for (ii = 0; (NULL != table->subtables) && (ii < table->subtables->count); ii++) {
+        if (0 == memcmp(&table->subtables->items[ii].subtable->mask, &rule->mask, sizeof(acl_key_t))) {
+            subtable = table->subtables->items[ii].subtable;
+            break;
+        }
+    }
+
+    if (NULL == (list = acl_subtable_list_alloc(table))) {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    if (NULL == subtable) {
+        if (SAI_STATUS_SUCCESS != (status = acl_subtable_create(&rule->mask, ACL_HASH_MIN_BUCKETS, &subtable))) {
+            free(list);
+            return status;
+        }
+        created = true;
+    } else if ((subtable->rule_count > subtable->hash->mask) &&
+               (SAI_STATUS_SUCCESS != (status = acl_subtable_grow(subtable)))) {
+        free(list);
+        return status;
+    }
+
+    rule->hash = acl_key_hash(&rule->key, subtable);
+    slot       = rule->hash & subtable->hash->mask;
+    old        = subtable->hash->buckets[slot];
+
+    if (NULL == (bucket = acl_bucket_insert(old, rule))) {
+        if (created) {
+            acl_hash_free(subtable->hash);
+            free(subtable);
+        }
+        free(list);
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    STUB_RCU_ASSIGN(subtable->hash->buckets[slot], bucket);
+    stub_rcu_defer_free(old);
+    subtable->rule_count++;
+
+    if (created || (rule->priority > subtable->max_priority)) {
+        subtable->max_priority = rule->priority;
+        acl_subtable_list_publish(table, list, created ? subtable : NULL, NULL);
+    } else {
+        free(list);
+    }
+
+    *rule_subtable = subtable;
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Take a rule out of its subtable, the subtable goes with its last rule. The
+ * rule itself is left to the caller. Caller holds acl_db_lock exclusively */
+static sai_status_t acl_rule_remove(_Inout_ acl_table_t    *table,
+                                    _Inout_ acl_subtable_t *subtable,
+                                    _In_ const acl_rule_t  *rule)
+{
+    acl_subtable_list_t *list;
+    acl_bucket_t        *bucket = NULL, *old;
+    uint32_t             ii, slot = rule->hash & subtable->hash->mask, max_priority;
+
+    if (NULL == (list = acl_subtable_list_alloc(table))) {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    old = subtable->hash->buckets[slot];
+    if ((old->count > 1) && (NULL == (bucket = acl_bucket_remove(old, rule)))) {
+        free(list);
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    STUB_RCU_ASSIGN(subtable->hash->buckets[slot], bucket);
+    stub_rcu_defer_free(old);
+
+    if (0 == --subtable->rule_count) {
+        acl_subtable_list_publish(table, list, NULL, subtable);
+        acl_hash_defer_free(subtable->hash);
+        stub_rcu_defer_free(subtable);
+        return SAI_STATUS_SUCCESS;
+    }
+
+    if (rule->priority < subtable->max_priority) {
+        free(list);
+        return SAI_STATUS_SUCCESS;
+    }
+
+    /* The bucket heads hold the highest priorities */
+    for (ii = 0, max_priority = 0; ii <= subtable->hash->mask; ii++) {
+        if ((NULL != (bucket = subtable->hash->buckets[ii])) && (bucket->rules[0]->priority > max_priority)) {
+            max_priority = bucket->rules[0]->priority;
+        }
+    }
+    subtable->max_priority = max_priority;
+    acl_subtable_list_publish(table, list, NULL, NULL);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void acl_subtable_list_free(_In_ acl_subtable_list_t *list)
+{
+    uint32_t ii;
+
+    if (NULL == list) {
+        return;
+    }
+
+    for (ii = 0; ii < list->count; ii++) {
+        acl_hash_free(list->items[ii].subtable->hash);
+        free(list->items[ii].subtable);
+    }
+    free(list);
+}
+
+/* Move a counter reference from one rule to another, either may be NULL.
+ * The old rule leaves for good and drops its policer reference, the new
+ * one took its own when the action was set. Caller holds acl_db_lock
+ * exclusively */
+static void acl_rule_ref(_In_ const acl_rule_t *old_rule, _In_ const acl_rule_t *new_rule)
+{
+    if ((NULL != old_rule) && (ACL_NO_COUNTER != old_rule->counter)) {
+        acl_counter_db[old_rule->counter].ref_count--;
+    }
+    if (NULL != old_rule) {
+        db_policer_unbind(old_rule->policer);
+    }
+    if ((NULL != new_rule) && (ACL_NO_COUNTER != new_rule->counter)) {
+        acl_counter_db[new_rule->counter].ref_count++;
+    }
+}
+
+/* Same as acl_subtable_list_free for a published list, the rules stay */
+static void acl_subtable_list_defer_free(_In_ acl_subtable_list_t *list)
+{
+    uint32_t ii;
+
+    if (NULL == list) {
+        return;
+    }
+
+    for (ii = 0; ii < list->count; ii++) {
+        acl_hash_defer_free(list->items[ii].subtable->hash);
+        stub_rcu_defer_free(list->items[ii].subtable);
+    }
+    stub_rcu_defer_free(list);
+}
+
+/* Keep a rule the classifier still holds until the bulk commit, with its
+ * counter reference. Caller holds acl_db_lock exclusively */
+static void acl_rule_retire(_Inout_ acl_table_t *table, _Inout_ acl_rule_t *rule)
+{
+    rule->retired_next = table->retired;
+    table->retired     = rule;
+}
+
+/* Free the retired rules of a table. Caller holds acl_db_lock exclusively */
+static void acl_retired_free(_Inout_ acl_table_t *table, _In_ bool readers_done)
+{
+    acl_rule_t *rule, *next;
+
+    for (rule = table->retired; NULL != rule; rule = next) {
+        next = rule->retired_next;
+        acl_rule_ref(rule, NULL);
+        if (readers_done) {
+            free(rule);
+        } else {
+            stub_rcu_defer_free(rule);
+        }
+    }
+    table->retired = NULL;
+}
+
+/* Order of the bulk compile: by masks, then by priority, highest first,
+ * then by entry */
+static int acl_rule_compile_cmp(_In_ const void *a, _In_ const void *b)
+{
+    const acl_rule_t *rule_a = *(const acl_rule_t* const*)a, *rule_b = *(const acl_rule_t* const*)b;
+    int               cmp;
+
+    if (0 != (cmp = memcmp(&rule_a->mask, &rule_b->mask, sizeof(acl_key_t)))) {
+        return cmp;
+    }
+    if (rule_a->priority != rule_b->priority) {
+        return (rule_a->priority > rule_b->priority) ? -1 : 1;
+    }
+    return (rule_a->entry < rule_b->entry) ? -1 : (rule_a->entry > rule_b->entry);
+}
+
+/* Build the subtable of the rules [first, last), sorted by
+ * acl_rule_compile_cmp, each bucket allocated once at its final size */
+static sai_status_t acl_subtable_compile(_In_ acl_rule_t **rules, _In_ uint32_t first, _In_ uint32_t last,
+                                         _Out_ acl_subtable_t **compiled)
+{
+    acl_subtable_t *subtable;
+    acl_hash_t     *hash;
+    uint32_t       *counts, bucket_count = ACL_HASH_MIN_BUCKETS, ii, slot, hash_value;
+    sai_status_t    status;
+
+    while (bucket_count < last - first) {
+        bucket_count *= 2;
+    }
+
+    if (SAI_STATUS_SUCCESS != (status = acl_subtable_create(&rules[first]->mask, bucket_count, &subtable))) {
+        return status;
+    }
+    hash = subtable->hash;
+
+    if (NULL == (counts = calloc(bucket_count, sizeof(*counts)))) {
+        acl_hash_free(hash);
+        free(subtable);
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    for (ii = first; ii < last; ii++) {
+        /* Same masks, same hash: a rule the old classifier holds keeps its
+         * value and is only written when it never had one */
+        hash_value = acl_key_hash(&rules[ii]->key, subtable);
+        if (rules[ii]->hash != hash_value) {
+            rules[ii]->hash = hash_value;
+        }
+        counts[hash_value & hash->mask]++;
+    }
+
+    for (slot = 0; slot < bucket_count; slot++) {
+        if ((0 != counts[slot]) &&
+            (NULL == (hash->buckets[slot] = malloc(sizeof(acl_bucket_t) + counts[slot] * sizeof(acl_rule_t*))))) {
+            free(counts);
+            acl_hash_free(hash);
+            free(subtable);
+            return SAI_STATUS_NO_MEMORY;
+        }
+        if (NULL != hash->buckets[slot]) {
+            hash->buckets[slot]->count = 0;
+        }
+    }
+    free(counts);
+
+    /* Sorted input, the buckets come out in priority order */
+    for (ii = first; ii < last; ii++) {
+        slot                                                      = rules[ii]->hash & hash->mask;
+        hash->buckets[slot]->rules[hash->buckets[slot]->count++] = rules[ii];
+    }
+
+    subtable->rule_count   = last - first;
+    subtable->max_priority = rules[first]->priority;
+    *compiled              = subtable;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Compile the enabled entries of a table into a new classifier, next to the
+ * published one. Caller holds acl_db_lock exclusively */
+static sai_status_t acl_table_compile(_In_ uint32_t table_index, _Out_ acl_subtable_list_t **compiled)
+{
+    acl_subtable_list_t *list;
+    acl_subtable_t      *subtable;
+    acl_rule_t         **rules;
+    sai_status_t         status;
+    uint32_t             ii, jj, first, rule_count = 0, subtable_count = 0;
+
+    *compiled = NULL;
+    if (0 == acl_table_db[table_index].entry_count) {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    if (NULL == (rules = malloc(acl_table_db[table_index].entry_count * sizeof(*rules)))) {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    for (ii = 0; ii < MAX_ACL_ENTRIES; ii++) {
+        if (acl_entry_db[ii].is_used && (table_index == acl_entry_db[ii].table) && acl_entry_db[ii].admin_state) {
+            rules[rule_count++] = acl_entry_db[ii].rule;
+        }
+    }
+
+    if (0 == rule_count) {
+        free(rules);
+        return SAI_STATUS_SUCCESS;
+    }
+
+    qsort(rules, rule_count, sizeof(*rules), acl_rule_compile_cmp);
+    for (ii = 0; ii < rule_count; ii++) {
+        subtable_count += (0 == ii) || (0 != memcmp(&rules[ii - 1]->mask, &rules[ii]->mask, sizeof(acl_key_t)));
+    }
+
+    if (NULL == (list = malloc(sizeof(*list) + subtable_count * sizeof(list->items[0])))) {
+        free(rules);
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    list->count = 0;
+    for (first = 0; first < rule_count; first = ii) {
+        for (ii = first + 1;
+             (ii < rule_count) && (0 == memcmp(&rules[first]->mask, &rules[ii]->mask, sizeof(acl_key_t)));
+             ii++) {
+        }
+
+        if (SAI_STATUS_SUCCESS != (status = acl_subtable_compile(rules, first, ii, &subtable))) {
+            acl_subtable_list_free(list);
+            free(rules);
+            return status;
+        }
+
+        for (jj = list->count; (jj > 0) && (list->items[jj - 1].max_priority < subtable->max_priority); jj--) {
+            list->items[jj] = list->items[jj - 1];
+        }
+        list->items[jj].subtable     = subtable;
+        list->items[jj].max_priority = subtable->max_priority;
+        list->count++;
+    }
+
+    free(rules);
+    *compiled = list;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Swap in the staged entries of a table, the lookups go from the old
+ * classifier to the new one at once. Caller holds acl_db_lock exclusively */
+static sai_status_t acl_table_commit(_In_ uint32_t table_index)
+{
+    acl_table_t         *table = &acl_table_db[table_index];
+    acl_subtable_list_t *list, *old = table->subtables;
+    uint32_t             ii, jj;
+    sai_status_t         status;
+
+    if (SAI_STATUS_SUCCESS != (status = acl_table_compile(table_index, &list))) {
+        return status;
+    }
+
+    STUB_RCU_ASSIGN(table->subtables, list);
+
+    for (ii = 0; ii < MAX_ACL_ENTRIES; ii++) {
+        if (!acl_entry_db[ii].is_used || (table_index != acl_entry_db[ii].table)) {
+            continue;
+        }
+        acl_entry_db[ii].subtable = NULL;
+        for (jj = 0; acl_entry_db[ii].admin_state && (NULL != list) && (jj < list->count); jj++) {
+            if (0 == memcmp(&list->items[jj].subtable->mask, &acl_entry_db[ii].rule->mask, sizeof(acl_key_t))) {
+                acl_entry_db[ii].subtable = list->items[jj].subtable;
+                break;
+            }
+        }
+    }
+
+    acl_subtable_list_defer_free(old);
+    acl_retired_free(table, false);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static inline uint64_t acl_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+/* Record the time an update took to reach the lookups. Caller holds acl_db_lock exclusively */
+static void acl_update_done(_Inout_ acl_table_t *table, _In_ uint64_t start_ns)
+{
+    table->last_update_ns = acl_now_ns() - start_ns;
+    if (table->last_update_ns > table->max_update_ns) {
+        table->max_update_ns = table->last_update_ns;
+    }
+}
+
+/* Publish the tables of a stage in priority order. Caller holds acl_db_lock exclusively */
+static sai_status_t acl_stage_publish(_In_ sai_int32_t stage)
+{
+    acl_stage_list_t *list, *old = acl_stages[stage];
+    uint32_t          jj, table;
+
+    if (NULL == (list = calloc(1, sizeof(*list)))) {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    for (table = 0; table < MAX_ACL_TABLES; table++) {
+        if (!acl_table_db[table].is_used || (stage != acl_table_db[table].stage)) {
+            continue;
+        }
+        for (jj = list->count; jj > 0; jj--) {
+            if (acl_table_db[list->tables[jj - 1]].priority >= acl_table_db[table].priority) {
+                break;
+            }
+            list->tables[jj] = list->tables[jj - 1];
+        }
+        list->tables[jj] = table;
+        list->count++;
+    }
+
+    STUB_RCU_ASSIGN(acl_stages[stage], list);
+    stub_rcu_defer_free(old);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Set or clear a match field of a rule. Caller holds acl_db_lock */
+static sai_status_t acl_rule_set_field(_In_ const acl_table_t          *table,
+                                       _Inout_ acl_rule_t             *rule,
+                                       _In_ sai_attr_id_t              id,
+                                       _In_ const sai_acl_field_data_t *field,
+                                       _In_ uint32_t                   attr_index)
+{
+    const acl_field_info_t *info  = &acl_fields[ACL_FIELD_INDEX(id)];
+    uint64_t                bit   = 1ULL << ACL_FIELD_INDEX(id);
+    uint8_t                *key   = (uint8_t*)&rule->key + info->offset;
+    uint8_t                *mask  = (uint8_t*)&rule->mask + info->offset;
+    uint32_t               *ports = (SAI_ACL_ENTRY_ATTR_FIELD_IN_PORTS == id) ? &rule->in_ports : &rule->out_ports;
+    uint32_t                ii, port;
+
+    if (0 == (table->fields & bit)) {
+        STUB_LOG_ERR("ACL table does not match on field %x\n", id);
+        return SAI_STATUS_INVALID_ATTRIBUTE_0 + attr_index;
+    }
+
+    rule->fields &= ~bit;
+    memset(key, 0, info->size);
+    memset(mask, 0, info->size);
+    if (ACL_FIELD_PORTS == info->kind) {
+        *ports = 0;
+    }
+
+    if (!field->enable) {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    switch (info->kind) {
+    case ACL_FIELD_RAW:
+        memcpy(mask, &field->mask, info->size);
+        memcpy(key, &field->data, info->size);
+        for (ii = 0; ii < info->size; ii++) {
+            key[ii] &= mask[ii];
+        }
+        break;
+
+    case ACL_FIELD_PORT:
+        if ((SAI_STATUS_SUCCESS != stub_object_to_type(field->data.oid, SAI_OBJECT_TYPE_PORT, &port)) ||
+            (port >= PORT_NUMBER)) {
+            STUB_LOG_ERR("Invalid ACL field port\n");
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + attr_index;
+        }
+        *key  = (uint8_t)port;
+        *mask = 0xFF;
+        break;
+
+    case ACL_FIELD_PORTS:
+        if ((0 == field->data.objlist.count) || (NULL == field->data.objlist.list)) {
+            STUB_LOG_ERR("Empty ACL field port list\n");
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + attr_index;
+        }
+        for (ii = 0; ii < field->data.objlist.count; ii++) {
+            if ((SAI_STATUS_SUCCESS !=
+                 stub_object_to_type(field->data.objlist.list[ii], SAI_OBJECT_TYPE_PORT, &port)) ||
+                (port >= PORT_NUMBER)) {
+                STUB_LOG_ERR("Invalid ACL field port list member %u\n", ii);
+                return SAI_STATUS_INVALID_ATTR_VALUE_0 + attr_index;
+            }
+            *ports |= 1U << port;
+        }
+        break;
+
+    case ACL_FIELD_IP_TYPE:
+        if ((field->data.s32 < SAI_ACL_IP_TYPE_ANY) || (field->data.s32 > SAI_ACL_IP_TYPE_ARP_REPLY)) {
+            STUB_LOG_ERR("Invalid ACL IP type %d\n", field->data.s32);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + attr_index;
+        }
+        rule->ip_type = field->data.s32;
+        *mask         = acl_ip_types[field->data.s32].mask;
+        *key          = acl_ip_types[field->data.s32].value;
+        break;
+
+    case ACL_FIELD_IP_FRAG:
+        if ((field->data.s32 < SAI_ACL_IP_FRAG_ANY) || (field->data.s32 > SAI_ACL_IP_FRAG_NON_HEAD)) {
+            STUB_LOG_ERR("Invalid ACL IP fragment %d\n", field->data.s32);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + attr_index;
+        }
+        rule->ip_frag = field->data.s32;
+        *mask         = acl_ip_frags[field->data.s32].mask;
+        *key          = acl_ip_frags[field->data.s32].value;
+        break;
+
+    case ACL_FIELD_VLAN_TAGS:
+        if ((field->data.s32 < SAI_PACKET_VLAN_UNTAG) || (field->data.s32 > SAI_PACKET_VLAN_DOUBLE_TAG)) {
+            STUB_LOG_ERR("Invalid ACL VLAN tags %d\n", field->data.s32);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + attr_index;
+        }
+        *key  = (uint8_t)field->data.s32;
+        *mask = 0xFF;
+        break;
+
+    default:
+        STUB_LOG_ERR("ACL field %x not supported\n", id);
+        return SAI_STATUS_ATTR_NOT_SUPPORTED_0 + attr_index;
+    }
+
+    rule->fields |= bit;
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Set or clear the data and mask of a UDF group of the table, one byte
+ * each per byte of the group. Caller holds acl_db_lock */
+static sai_status_t acl_rule_set_udf(_In_ const acl_table_t          *table,
+                                     _Inout_ acl_rule_t             *rule,
+                                     _In_ uint32_t                   slot,
+                                     _In_ const sai_acl_field_data_t *field,
+                                     _In_ uint32_t                   attr_index)
+{
+    const acl_udf_slot_t *udf  = &table->udf[slot];
+    uint8_t              *key  = rule->key.f.udf + udf->offset;
+    uint8_t              *mask = rule->mask.f.udf + udf->offset;
+    uint32_t              ii;
+
+    if (0 == udf->length) {
+        STUB_LOG_ERR("ACL table has no UDF group %u\n", slot);
+        return SAI_STATUS_INVALID_ATTRIBUTE_0 + attr_index;
+    }
+
+    rule->udf_fields &= ~(1U << slot);
+    memset(key, 0, udf->length);
+    memset(mask, 0, udf->length);
+
+    if (!field->enable) {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    if ((NULL == field->data.u8list.list) || (NULL == field->mask.u8list.list) ||
+        (udf->length != field->data.u8list.count) || (udf->length != field->mask.u8list.count)) {
+        STUB_LOG_ERR("ACL UDF field data and mask of %u and %u bytes, group length %u\n",
+                     field->data.u8list.count, field->mask.u8list.count, udf->length);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + attr_index;
+    }
+
+    for (ii = 0; ii < udf->length; ii++) {
+        mask[ii] = field->mask.u8list.list[ii];
+        key[ii]  = field->data.u8list.list[ii] & mask[ii];
+    }
+
+    rule->udf_fields |= 1U << slot;
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Set or clear an action of a rule. Caller holds acl_db_lock */
+static sai_status_t acl_rule_set_action(_In_ const acl_table_t            *table,
+                                        _In_ uint32_t                      table_index,
+                                        _Inout_ acl_rule_t               *rule,
+                                        _In_ sai_attr_id_t                id,
+                                        _In_ const sai_acl_action_data_t *action,
+                                        _In_ uint32_t                     attr_index)
+{
+    uint32_t port, counter;
+
+    rule->actions &= ~ACL_ACTION_BIT(id);
+    if (SAI_ACL_ENTRY_ATTR_ACTION_COUNTER == id) {
+        rule->counter = ACL_NO_COUNTER;
+    }
+    if (SAI_ACL_ENTRY_ATTR_ACTION_SET_POLICER == id) {
+        db_policer_unbind(rule->policer);
+        rule->policer = STUB_NO_POLICER;
+    }
+
+    if (!action->enable) {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    switch (id) {
+    case SAI_ACL_ENTRY_ATTR_PACKET_ACTION:
+        if ((action->parameter.s32 < SAI_PACKET_ACTION_DROP) || (action->parameter.s32 > SAI_PACKET_ACTION_TRANSIT)) {
+            STUB_LOG_ERR("Invalid ACL packet action %d\n", action->parameter.s32);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + attr_index;
+        }
+        rule->packet_action = action->parameter.s32;
+        break;
+
+    case SAI_ACL_ENTRY_ATTR_ACTION_REDIRECT:
+        if (SAI_ACL_STAGE_INGRESS != table->stage) {
+            STUB_LOG_ERR("ACL redirect on an egress table\n");
+            return SAI_STATUS_INVALID_ATTRIBUTE_0 + attr_index;
+        }
+        if ((SAI_STATUS_SUCCESS != stub_object_to_type(action->parameter.oid, SAI_OBJECT_TYPE_PORT, &port)) ||
+            (port >= PORT_NUMBER)) {
+            STUB_LOG_ERR("ACL redirect to a non port object\n");
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + attr_index;
+        }
+        rule->redirect = action->parameter.oid;
+        break;
+
+    case SAI_ACL_ENTRY_ATTR_ACTION_COUNTER:
+        if (SAI_STATUS_SUCCESS != acl_counter_db_index(action->parameter.oid, &counter)) {
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + attr_index;
+        }
+        if (table_index != acl_counter_db[counter].table) {
+            STUB_LOG_ERR("ACL counter %u belongs to table %u\n", counter, acl_counter_db[counter].table);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + attr_index;
+        }
+        rule->counter = counter;
+        break;
+
+    case SAI_ACL_ENTRY_ATTR_ACTION_SET_POLICER:
+        if (SAI_STATUS_SUCCESS != db_policer_bind(action->parameter.oid, &rule->policer)) {
+            rule->policer = STUB_NO_POLICER;
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + attr_index;
+        }
+        break;
+
+    default:
+        STUB_LOG_ERR("ACL action %x not supported\n", id);
+        return SAI_STATUS_ATTR_NOT_SUPPORTED_0 + attr_index;
+    }
+
+    rule->actions |= ACL_ACTION_BIT(id);
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Apply an entry attribute to a rule, table id and admin state excluded.
+ * Caller holds acl_db_lock */
+static sai_status_t acl_rule_set(_In_ uint32_t               table_index,
+                                 _Inout_ acl_rule_t         *rule,
+                                 _In_ const sai_attribute_t *attr,
+                                 _In_ uint32_t               attr_index)
+{
+    const acl_table_t *table = &acl_table_db[table_index];
+
+    if (SAI_ACL_ENTRY_ATTR_PRIORITY == attr->id) {
+        if (attr->value.u32 > STUB_ACL_ENTRY_MAX_PRIORITY) {
+            STUB_LOG_ERR("ACL entry priority %u above %u\n", attr->value.u32, STUB_ACL_ENTRY_MAX_PRIORITY);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + attr_index;
+        }
+        rule->priority = attr->value.u32;
+        return SAI_STATUS_SUCCESS;
+    }
+
+    if ((attr->id >= SAI_ACL_ENTRY_ATTR_FIELD_START) && (ACL_FIELD_INDEX(attr->id) < ACL_FIELD_COUNT)) {
+        return acl_rule_set_field(table, rule, attr->id, &attr->value.aclfield, attr_index);
+    }
+
+    if ((attr->id >= SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN) &&
+        (ACL_UDF_SLOT(attr->id) < STUB_ACL_TABLE_UDF_GROUPS)) {
+        return acl_rule_set_udf(table, rule, ACL_UDF_SLOT(attr->id), &attr->value.aclfield, attr_index);
+    }
+
+    if ((attr->id >= SAI_ACL_ENTRY_ATTR_ACTION_START) && (attr->id <= SAI_ACL_ENTRY_ATTR_ACTION_END)) {
+        return acl_rule_set_action(table, table_index, rule, attr->id, &attr->value.aclaction, attr_index);
+    }
+
+    STUB_LOG_ERR("Unexpected ACL entry attribute %x\n", attr->id);
+    return SAI_STATUS_INVALID_ATTRIBUTE_0 + attr_index;
+}
+
+/* Release the UDF groups of table slots */
+static void acl_udf_unbind(_Inout_ acl_udf_slot_t *udf)
+{
+    uint32_t slot;
+
+    for (slot = 0; slot < STUB_ACL_TABLE_UDF_GROUPS; slot++) {
+        if (0 != udf[slot].length) {
+            db_udf_group_unbind(udf[slot].group);
+            udf[slot].length = 0;
+        }
+    }
+}
+
+/* Extract the UDF bytes of a table into the keys of a burst, frames are
+ * parsed for it on first use */
+static void acl_key_extract_udf(_In_ const acl_table_t    *table,
+                                _In_ uint32_t              count,
+                                _In_ const stub_packet_t  *packets,
+                                _In_ const bool           *active,
+                                _Inout_ stub_udf_layout_t *layouts,
+                                _Inout_ bool              *parsed,
+                                _Inout_ acl_key_t         *keys)
+{
+    const acl_udf_slot_t *udf;
+    uint32_t              ii, slot;
+
+    for (ii = 0; ii < count; ii++) {
+        if (!active[ii]) {
+            continue;
+        }
+        if (!parsed[ii]) {
+            db_udf_parse(&packets[ii], &layouts[ii]);
+            parsed[ii] = true;
+        }
+        for (slot = 0; slot < STUB_ACL_TABLE_UDF_GROUPS; slot++) {
+            udf = &table->udf[slot];
+            if (0 != udf->length) {
+                db_udf_extract(udf->group, &packets[ii], &layouts[ii], false, keys[ii].f.udf + udf->offset);
+            }
+        }
+    }
+}
+
+void db_init_acl(void)
+{
+    acl_stage_list_t *stages[ACL_STAGE_COUNT];
+    uint32_t          ii;
+
+    pthread_rwlock_wrlock(&acl_db_lock);
+
+    for (ii = 0; ii < ACL_STAGE_COUNT; ii++) {
+        stages[ii] = acl_stages[ii];
+        STUB_RCU_ASSIGN(acl_stages[ii], NULL);
+    }
+    stub_rcu_synchronize();
+
+    for (ii = 0; ii < ACL_STAGE_COUNT; ii++) {
+        free(stages[ii]);
+    }
+    for (ii = 0; ii < MAX_ACL_TABLES; ii++) {
+        acl_subtable_list_free(acl_table_db[ii].subtables);
+        acl_retired_free(&acl_table_db[ii], true);
+    }
+    for (ii = 0; ii < MAX_ACL_ENTRIES; ii++) {
+        free(acl_entry_db[ii].rule);
+    }
+
+    memset(acl_table_db, 0, sizeof(acl_table_db));
+    memset(acl_entry_db, 0, sizeof(acl_entry_db));
+    memset(acl_counter_db, 0, sizeof(acl_counter_db));
+    acl_entry_next = 0;
+
+    pthread_rwlock_unlock(&acl_db_lock);
+}
+
+static void acl_counter_shard_release(void *arg)
+{
+    pthread_mutex_lock(&acl_counter_shard_lock);
+    acl_counter_shard_owned[(uintptr_t)arg - 1] = false;
+    pthread_mutex_unlock(&acl_counter_shard_lock);
+}
+
+static void acl_counter_shard_key_create(void)
+{
+    pthread_key_create(&acl_counter_shard_key, acl_counter_shard_release);
+}
+
+/* Counter shard of the calling thread, taken on its first hit */
+static uint32_t acl_counter_shard_get(void)
+{
+    uint32_t shard;
+
+    if (ACL_NO_SHARD != acl_counter_shard) {
+        return acl_counter_shard;
+    }
+
+    pthread_once(&acl_counter_shard_key_once, acl_counter_shard_key_create);
+
+    pthread_mutex_lock(&acl_counter_shard_lock);
+    for (shard = 0; shard < ACL_SHARED_SHARD; shard++) {
+        if (!acl_counter_shard_owned[shard]) {
+            acl_counter_shard_owned[shard] = true;
+            break;
+        }
+    }
+    if (shard + 1 > __atomic_load_n(&acl_counter_shards_used, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&acl_counter_shards_used, shard + 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&acl_counter_shard_lock);
+
+    if (ACL_SHARED_SHARD != shard) {
+        pthread_setspecific(acl_counter_shard_key, (void*)(uintptr_t)(shard + 1));
+    }
+    acl_counter_shard = shard;
+
+    return shard;
+}
+
+/* Add a hit to a counter in the shard of the calling thread. The owner of
+ * a shard is its only writer, its adds need no atomic read-modify-write */
+static inline void acl_count(_In_ uint32_t shard, _In_ uint32_t counter, _In_ const stub_packet_t *packet)
+{
+    const acl_counter_t *entry = &acl_counter_db[counter];
+    acl_counter_value_t *value = &acl_counter_shards[shard][counter];
+
+    if (ACL_SHARED_SHARD == shard) {
+        if (entry->packet_count) {
+            __atomic_fetch_add(&value->packets, 1, __ATOMIC_RELAXED);
+        }
+        if (entry->byte_count) {
+            __atomic_fetch_add(&value->bytes, packet->length, __ATOMIC_RELAXED);
+        }
+        return;
+    }
+
+    if (entry->packet_count) {
+        __atomic_store_n(&value->packets, __atomic_load_n(&value->packets, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+    }
+    if (entry->byte_count) {
+        __atomic_store_n(&value->bytes, __atomic_load_n(&value->bytes, __ATOMIC_RELAXED) + packet->length,
+                         __ATOMIC_RELAXED);
+    }
+}
+
+/* Shard sums of some counters, into packets and bytes */
+static void acl_counter_sum(_In_ const uint32_t *counters,
+                            _In_ uint32_t        count,
+                            _Out_ uint64_t      *packets,
+                            _Out_ uint64_t      *bytes)
+{
+    uint32_t                   shards = __atomic_load_n(&acl_counter_shards_used, __ATOMIC_RELAXED);
+    uint32_t                   shard, ii;
+    const acl_counter_value_t *values;
+
+    memset(packets, 0, count * sizeof(*packets));
+    memset(bytes, 0, count * sizeof(*bytes));
+
+    /* The shared shard is written whenever a thread has no shard of its own */
+    for (shard = 0; shard < ACL_COUNTER_SHARDS; shard++) {
+        if ((shard >= shards) && (ACL_SHARED_SHARD != shard)) {
+            continue;
+        }
+        values = acl_counter_shards[shard];
+        for (ii = 0; ii < count; ii++) {
+            packets[ii] += __atomic_load_n(&values[counters[ii]].packets, __ATOMIC_RELAXED);
+            bytes[ii]   += __atomic_load_n(&values[counters[ii]].bytes, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/*
+ * Routine Description:
+ *    Run the ACL tables of a stage on a chunk of frames. Every hit is
+ *    counted, the packet action, the policer and the redirect of the highest
+ *    priority table hit that has them apply. Frames dropped, trapped,
+ *    policed to a drop or redirected are no longer pending. Copy and log
+ *    actions only mark the frame, the caller turns it into a copy to the
+ *    host once the frame is forwarded.
+ *
+ * Arguments:
+ *    [in] stage - SAI_ACL_STAGE_INGRESS or SAI_ACL_STAGE_EGRESS
+ *    [in] count - number of frames, at most STUB_DATAPLANE_BURST
+ *    [inout] packets - frames
+ *    [inout] pending - frames the stage runs on, cleared for frames it decides
+ *    [inout] copy - set for frames to copy to the host
+ */
+void db_apply_acl(_In_ sai_int32_t                stage,
+                  _In_ uint32_t                   count,
+                  _Inout_ struct _stub_packet_t  *packets,
+                  _Inout_ bool                   *pending,
+                  _Inout_ bool                   *copy)
+{
+    acl_key_t               keys[STUB_DATAPLANE_BURST];
+    stub_udf_layout_t       layouts[STUB_DATAPLANE_BURST];
+    bool                    active[STUB_DATAPLANE_BURST];
+    bool                    parsed[STUB_DATAPLANE_BURST];
+    bool                    decided[STUB_DATAPLANE_BURST];
+    sai_object_id_t         redirect[STUB_DATAPLANE_BURST];
+    uint32_t                policers[STUB_DATAPLANE_BURST];
+    bool                    policed[STUB_DATAPLANE_BURST];
+    const acl_rule_t       *hits[STUB_DATAPLANE_BURST];
+    const acl_stage_list_t *tables;
+    const acl_table_t      *table;
+    const acl_rule_t       *rule;
+    uint32_t                ii, tt, active_count = 0, policer_count = 0;
+    uint32_t                shard;
+
+    assert(count <= STUB_DATAPLANE_BURST);
+
+    stub_rcu_read_lock();
+
+    if ((NULL == (tables = STUB_RCU_DEREF(acl_stages[stage]))) || (0 == tables->count)) {
+        stub_rcu_read_unlock();
+        return;
+    }
+
+    shard = acl_counter_shard_get();
+
+    for (ii = 0; ii < count; ii++) {
+        active[ii]   = pending[ii] && acl_key_extract(&packets[ii], &keys[ii]);
+        parsed[ii]   = false;
+        decided[ii]  = false;
+        redirect[ii] = SAI_NULL_OBJECT_ID;
+        policers[ii] = STUB_NO_POLICER;
+        policed[ii]  = false;
+        active_count += active[ii];
+    }
+
+    for (tt = 0; (tt < tables->count) && (0 != active_count); tt++) {
+        table = &acl_table_db[tables->tables[tt]];
+        if (0 != table->udf_count) {
+            acl_key_extract_udf(table, count, packets, active, layouts, parsed, keys);
+        }
+        acl_classify_keys(STUB_RCU_DEREF(table->subtables), count, keys, active, hits);
+
+        for (ii = 0; ii < count; ii++) {
+            if (NULL == (rule = hits[ii])) {
+                continue;
+            }
+
+            if (ACL_NO_COUNTER != rule->counter) {
+                acl_count(shard, rule->counter, &packets[ii]);
+            }
+
+            if ((SAI_NULL_OBJECT_ID == redirect[ii]) && (rule->actions & ACL_ACTION_BIT(SAI_ACL_ENTRY_ATTR_ACTION_REDIRECT))) {
+                redirect[ii] = rule->redirect;
+            }
+
+            if ((STUB_NO_POLICER == policers[ii]) && (STUB_NO_POLICER != rule->policer)) {
+                policers[ii] = rule->policer;
+            }
+
+            if (decided[ii] || !(rule->actions & ACL_ACTION_BIT(SAI_ACL_ENTRY_ATTR_PACKET_ACTION))) {
+                continue;
+            }
+
+            decided[ii] = true;
+            switch (rule->packet_action) {
+            case SAI_PACKET_ACTION_DROP:
+            case SAI_PACKET_ACTION_DENY:
+                packets[ii].packet_action = SAI_PACKET_ACTION_DROP;
+                pending[ii]               = false;
+                break;
+
+            case SAI_PACKET_ACTION_TRAP:
+                packets[ii].packet_action = SAI_PACKET_ACTION_TRAP;
+                packets[ii].trap_id       = 0;
+                pending[ii]               = false;
+                break;
+
+            case SAI_PACKET_ACTION_COPY:
+            case SAI_PACKET_ACTION_LOG:
+                copy[ii] = true;
+                break;
+
+            case SAI_PACKET_ACTION_COPY_CANCEL:
+                copy[ii] = false;
+                break;
+
+            default:
+                break;
+            }
+        }
+    }
+
+    stub_rcu_read_unlock();
+
+    /* Frames the ACL already dropped or trapped are not metered */
+    for (ii = 0; ii < count; ii++) {
+        if (!pending[ii]) {
+            policers[ii] = STUB_NO_POLICER;
+        }
+        policer_count += (STUB_NO_POLICER != policers[ii]);
+    }
+    if (0 != policer_count) {
+        db_apply_policers(count, policers, packets, policed);
+    }
+
+    for (ii = 0; ii < count; ii++) {
+        if (policed[ii]) {
+            packets[ii].packet_action = SAI_PACKET_ACTION_DROP;
+            pending[ii]               = false;
+        } else if (pending[ii] && (SAI_NULL_OBJECT_ID != redirect[ii])) {
+            packets[ii].out_port      = redirect[ii];
+            packets[ii].packet_action = SAI_PACKET_ACTION_FORWARD;
+            pending[ii]               = false;
+        }
+    }
+}
+
+/*
+ * Routine Description:
+ *    @brief Classify a burst of frames against one ACL table, without
+ *    applying the actions of the hits or counting them
+ *
+ * Arguments:
+ *    @param[in] acl_table_id - ACL table
+ *    @param[in] count - number of frames
+ *    @param[in] packets - frames, in_port and for egress tables out_port set
+ *    @param[out] entry_ids - hit entry of each frame, SAI_NULL_OBJECT_ID on a miss
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_acl_classify(_In_ sai_object_id_t      acl_table_id,
+                               _In_ uint32_t             count,
+                               _In_ const stub_packet_t *packets,
+                               _Out_ sai_object_id_t    *entry_ids)
+{
+    acl_key_t                  keys[STUB_DATAPLANE_BURST];
+    stub_udf_layout_t          layouts[STUB_DATAPLANE_BURST];
+    bool                       active[STUB_DATAPLANE_BURST];
+    bool                       parsed[STUB_DATAPLANE_BURST];
+    const acl_rule_t          *hits[STUB_DATAPLANE_BURST];
+    const acl_subtable_list_t *subtables;
+    sai_status_t               status;
+    uint32_t                   table, ii, jj, chunk;
+
+    if ((NULL == packets) || (NULL == entry_ids)) {
+        STUB_LOG_ERR("NULL packets or entry ids param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    pthread_rwlock_rdlock(&acl_db_lock);
+    if (SAI_STATUS_SUCCESS != (status = acl_table_db_index(acl_table_id, &table))) {
+        pthread_rwlock_unlock(&acl_db_lock);
+        return status;
+    }
+    /* Table removal waits for the readers, the table stays until the unlock */
+    stub_rcu_read_lock();
+    pthread_rwlock_unlock(&acl_db_lock);
+
+    for (ii = 0; ii < count; ii += chunk) {
+        chunk     = (count - ii < STUB_DATAPLANE_BURST) ? count - ii : STUB_DATAPLANE_BURST;
+        subtables = STUB_RCU_DEREF(acl_table_db[table].subtables);
+
+        for (jj = 0; jj < chunk; jj++) {
+            active[jj] = acl_key_extract(&packets[ii + jj], &keys[jj]);
+            parsed[jj] = false;
+        }
+        if (0 != acl_table_db[table].udf_count) {
+            acl_key_extract_udf(&acl_table_db[table], chunk, packets + ii, active, layouts, parsed, keys);
+        }
+
+        acl_classify_keys(subtables, chunk, keys, active, hits);
+
+        for (jj = 0; jj < chunk; jj++) {
+            entry_ids[ii + jj] = SAI_NULL_OBJECT_ID;
+            if (NULL != hits[jj]) {
+                stub_create_object(SAI_OBJECT_TYPE_ACL_ENTRY, hits[jj]->entry, &entry_ids[ii + jj]);
+            }
+        }
+    }
+
+    stub_rcu_read_unlock();
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    @brief Read all counters of an ACL table in one call
+ *
+ * Arguments:
+ *    @param[in] acl_table_id - ACL table
+ *    @param[inout] counter_count - size of the arrays, set to the number of
+ *                                  counters of the table
+ *    @param[out] counter_ids - counters
+ *    @param[out] packets - packets of each counter
+ *    @param[out] bytes - bytes of each counter
+ *    @param[in] clear - clear the counters as they are read
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            SAI_STATUS_BUFFER_OVERFLOW if counter_count is insufficient
+ *            Failure status code on error
+ */
+sai_status_t stub_acl_get_counters_bulk(_In_ sai_object_id_t     acl_table_id,
+                                        _Inout_ uint32_t        *counter_count,
+                                        _Out_ sai_object_id_t   *counter_ids,
+                                        _Out_ uint64_t          *packets,
+                                        _Out_ uint64_t          *bytes,
+                                        _In_ bool                clear)
+{
+    acl_counter_t *counter;
+    uint32_t      *counters;
+    sai_status_t   status;
+    uint64_t       sum_packets, sum_bytes;
+    uint32_t       table, ii, count = 0;
+
+    if ((NULL == counter_count) || (NULL == counter_ids) || (NULL == packets) || (NULL == bytes)) {
+        STUB_LOG_ERR("NULL counter count, counter ids, packets or bytes param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (clear) {
+        pthread_rwlock_wrlock(&acl_db_lock);
+    } else {
+        pthread_rwlock_rdlock(&acl_db_lock);
+    }
+
+    if (SAI_STATUS_SUCCESS != (status = acl_table_db_index(acl_table_id, &table))) {
+        pthread_rwlock_unlock(&acl_db_lock);
+        return status;
+    }
+
+    if (*counter_count < acl_table_db[table].counter_count) {
+        STUB_LOG_ERR("Counter count %u below %u\n", *counter_count, acl_table_db[table].counter_count);
+        *counter_count = acl_table_db[table].counter_count;
+        pthread_rwlock_unlock(&acl_db_lock);
+        return SAI_STATUS_BUFFER_OVERFLOW;
+    }
+
+    if (NULL == (counters = malloc((acl_table_db[table].counter_count + 1) * sizeof(*counters)))) {
+        pthread_rwlock_unlock(&acl_db_lock);
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    for (ii = 0; ii < MAX_ACL_COUNTERS; ii++) {
+        if (acl_counter_db[ii].is_used && (table == acl_counter_db[ii].table)) {
+            counters[count++] = ii;
+        }
+    }
+
+    /* One pass over each shard for all counters of the table */
+    acl_counter_sum(counters, count, packets, bytes);
+
+    for (ii = 0; ii < count; ii++) {
+        counter = &acl_counter_db[counters[ii]];
+        stub_create_object(SAI_OBJECT_TYPE_ACL_COUNTER, counters[ii], &counter_ids[ii]);
+        sum_packets = packets[ii];
+        sum_bytes   = bytes[ii];
+        packets[ii] = sum_packets - counter->packets_base;
+        bytes[ii]   = sum_bytes - counter->bytes_base;
+        if (clear) {
+            counter->packets_base = sum_packets;
+            counter->bytes_base   = sum_bytes;
+        }
+    }
+
+    pthread_rwlock_unlock(&acl_db_lock);
+
+    free(counters);
+    *counter_count = count;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Create an ACL table
+ *
+ * Arguments:
+ *    [out] acl_table_id - the acl table id
+ *    [in] attr_count - number of attributes
+ *    [in] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_create_acl_table(_Out_ sai_object_id_t     *acl_table_id,
+                                   _In_ uint32_t               attr_count,
+                                   _In_ const sai_attribute_t *attr_list)
+{
+    const sai_attribute_value_t *stage, *priority, *size, *udf_group;
+    uint32_t                     stage_index, priority_index, size_index, udf_group_index, ii, table_index;
+    uint64_t                     fields = 0;
+    acl_udf_slot_t               udf[STUB_ACL_TABLE_UDF_GROUPS];
+    uint32_t                     udf_count = 0, udf_bytes = 0;
+    acl_table_t                 *table;
+    sai_status_t                 status;
+    char                         list_str[MAX_LIST_VALUE_STR_LEN];
+    char                         key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    if (NULL == acl_table_id) {
+        STUB_LOG_ERR("NULL acl table id param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS !=
+        (status =
+             check_attribs_metadata(attr_count, attr_list, acl_table_attribs, acl_table_vendor_attribs,
+                                    SAI_OPERATION_CREATE))) {
+        STUB_LOG_ERR("Failed attribs check\n");
+        return status;
+    }
+
+    sai_attr_list_to_str(attr_count, attr_list, acl_table_attribs, MAX_LIST_VALUE_STR_LEN, list_str);
+    STUB_LOG_NTC("Create ACL table, %s\n", list_str);
+
+    assert(SAI_STATUS_SUCCESS ==
+           find_attrib_in_list(attr_count, attr_list, SAI_ACL_TABLE_ATTR_STAGE, &stage, &stage_index));
+    assert(SAI_STATUS_SUCCESS ==
+           find_attrib_in_list(attr_count, attr_list, SAI_ACL_TABLE_ATTR_PRIORITY, &priority, &priority_index));
+
+    if ((SAI_ACL_STAGE_INGRESS != stage->s32) && (SAI_ACL_STAGE_EGRESS != stage->s32)) {
+        STUB_LOG_ERR("ACL stage %d not supported, ingress and egress only\n", stage->s32);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + stage_index;
+    }
+
+    if (priority->u32 > STUB_ACL_TABLE_MAX_PRIORITY) {
+        STUB_LOG_ERR("ACL table priority %u above %u\n", priority->u32, STUB_ACL_TABLE_MAX_PRIORITY);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + priority_index;
+    }
+
+    if ((SAI_STATUS_SUCCESS ==
+         find_attrib_in_list(attr_count, attr_list, SAI_ACL_TABLE_ATTR_SIZE, &size, &size_index)) &&
+        (size->u32 > MAX_ACL_ENTRIES)) {
+        STUB_LOG_ERR("ACL table size %u above %u\n", size->u32, MAX_ACL_ENTRIES);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + size_index;
+    }
+
+    for (ii = 0; ii < attr_count; ii++) {
+        if ((attr_list[ii].id >= SAI_ACL_TABLE_ATTR_FIELD_START) &&
+            (attr_list[ii].id < SAI_ACL_TABLE_ATTR_USER_DEFINED_FIELD_GROUP_MIN) && attr_list[ii].value.booldata) {
+            fields |= 1ULL << (attr_list[ii].id - SAI_ACL_TABLE_ATTR_FIELD_START);
+        }
+    }
+
+    /* UDF bytes are laid out in the key in slot order */
+    memset(udf, 0, sizeof(udf));
+    for (ii = 0; ii < STUB_ACL_TABLE_UDF_GROUPS; ii++) {
+        if (SAI_STATUS_SUCCESS !=
+            find_attrib_in_list(attr_count, attr_list, SAI_ACL_TABLE_ATTR_USER_DEFINED_FIELD_GROUP_MIN + ii,
+                                &udf_group, &udf_group_index)) {
+            continue;
+        }
+        if (SAI_STATUS_SUCCESS !=
+            (status = db_udf_group_bind(udf_group->oid, SAI_UDF_GROUP_GENERIC, &udf[ii].group, &udf[ii].length))) {
+            acl_udf_unbind(udf);
+            return status + udf_group_index;
+        }
+        udf[ii].offset = udf_bytes;
+        udf_bytes     += udf[ii].length;
+        udf_count++;
+        if (udf_bytes > STUB_ACL_TABLE_UDF_BYTES) {
+            acl_udf_unbind(udf);
+            STUB_LOG_ERR("ACL table UDF groups of %u bytes, up to %u\n", udf_bytes, STUB_ACL_TABLE_UDF_BYTES);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + udf_group_index;
+        }
+    }
+
+    if ((0 == fields) && (0 == udf_count)) {
+        STUB_LOG_ERR("ACL table without match fields\n");
+        return SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING;
+    }
+
+    pthread_rwlock_wrlock(&acl_db_lock);
+
+    for (table_index = 0; table_index < MAX_ACL_TABLES; table_index++) {
+        if (!acl_table_db[table_index].is_used) {
+            break;
+        }
+    }
+
+    if (MAX_ACL_TABLES == table_index) {
+        pthread_rwlock_unlock(&acl_db_lock);
+        acl_udf_unbind(udf);
+        STUB_LOG_ERR("ACL table table full\n");
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    table           = &acl_table_db[table_index];
+    table->is_used  = true;
+    table->stage    = stage->s32;
+    table->priority = priority->u32;
+    table->size     = (SAI_STATUS_SUCCESS ==
+                       find_attrib_in_list(attr_count, attr_list, SAI_ACL_TABLE_ATTR_SIZE, &size,
+                                           &size_index)) ? size->u32 : 0;
+    table->fields         = fields;
+    table->udf_count      = udf_count;
+    memcpy(table->udf, udf, sizeof(table->udf));
+    table->entry_count    = 0;
+    table->counter_count  = 0;
+    table->subtables      = NULL;
+    table->bulk           = false;
+    table->retired        = NULL;
+    table->last_update_ns = 0;
+    table->max_update_ns  = 0;
+
+    if (SAI_STATUS_SUCCESS != (status = acl_stage_publish(table->stage))) {
+        table->is_used = false;
+        pthread_rwlock_unlock(&acl_db_lock);
+        acl_udf_unbind(udf);
+        return status;
+    }
+
+    pthread_rwlock_unlock(&acl_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_ACL_TABLE, table_index, acl_table_id))) {
+        return status;
+    }
+    acl_key_to_str(*acl_table_id, SAI_OBJECT_TYPE_ACL_TABLE, "table", key_str);
+    STUB_LOG_NTC("Created %s\n", key_str);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Delete an ACL table
+ *
+ * Arguments:
+ *    [in] acl_table_id - the acl table id
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_delete_acl_table(_In_ sai_object_id_t acl_table_id)
+{
+    acl_table_t *table;
+    char         key_str[MAX_KEY_STR_LEN];
+    sai_status_t status;
+    uint32_t     table_index;
+
+    STUB_LOG_ENTER();
+
+    acl_key_to_str(acl_table_id, SAI_OBJECT_TYPE_ACL_TABLE, "table", key_str);
+    STUB_LOG_NTC("Remove %s\n", key_str);
+
+    pthread_rwlock_wrlock(&acl_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = acl_table_db_index(acl_table_id, &table_index))) {
+        pthread_rwlock_unlock(&acl_db_lock);
+        return status;
+    }
+
+    table = &acl_table_db[table_index];
+    if ((0 != table->entry_count) || (0 != table->counter_count)) {
+        pthread_rwlock_unlock(&acl_db_lock);
+        STUB_LOG_ERR("ACL table %u has %u entries and %u counters\n", table_index, table->entry_count,
+                     table->counter_count);
+        return SAI_STATUS_OBJECT_IN_USE;
+    }
+
+    table->is_used = false;
+    if (SAI_STATUS_SUCCESS != (status = acl_stage_publish(table->stage))) {
+        table->is_used = true;
+        pthread_rwlock_unlock(&acl_db_lock);
+        return status;
+    }
+
+    /* The slot is not reused before the data plane is done with the table */
+    stub_rcu_synchronize();
+    acl_subtable_list_free(table->subtables);
+    acl_retired_free(table, true);
+    acl_udf_unbind(table->udf);
+    table->subtables = NULL;
+    table->bulk      = false;
+
+    pthread_rwlock_unlock(&acl_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Set ACL table attribute
+ *
+ * Arguments:
+ *    [in] acl_table_id - the acl table id
+ *    [in] attr - attribute
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_set_acl_table_attribute(_In_ sai_object_id_t acl_table_id, _In_ const sai_attribute_t *attr)
+{
+    const sai_object_key_t key = { .object_id = acl_table_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    acl_key_to_str(acl_table_id, SAI_OBJECT_TYPE_ACL_TABLE, "table", key_str);
+    return sai_set_attribute(&key, key_str, acl_table_attribs, acl_table_vendor_attribs, attr);
+}
+
+/*
+ * Routine Description:
+ *    Get ACL table attribute
+ *
+ * Arguments:
+ *    [in] acl_table_id - acl table id
+ *    [in] attr_count - number of attributes
+ *    [out] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_acl_table_attribute(_In_ sai_object_id_t   acl_table_id,
+                                          _In_ uint32_t          attr_count,
+                                          _Out_ sai_attribute_t *attr_list)
+{
+    const sai_object_key_t key = { .object_id = acl_table_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
+
+    STUB_LOG_ENTER();
+
+    acl_key_to_str(acl_table_id, SAI_OBJECT_TYPE_ACL_TABLE, "table", key_str);
+
+    pthread_rwlock_rdlock(&acl_db_lock);
+    status = sai_get_attributes(&key, key_str, acl_table_attribs, acl_table_vendor_attribs, attr_count, attr_list);
+    pthread_rwlock_unlock(&acl_db_lock);
+
+    return status;
+}
+
+/* Bytes of a published classifier, the rules it holds included. Caller holds acl_db_lock */
+static uint64_t acl_classifier_memory(_In_ const acl_subtable_list_t *list)
+{
+    const acl_subtable_t *subtable;
+    uint64_t              bytes;
+    uint32_t              ii, jj;
+
+    if (NULL == list) {
+        return 0;
+    }
+
+    bytes = sizeof(*list) + list->count * sizeof(list->items[0]);
+    for (ii = 0; ii < list->count; ii++) {
+        subtable = list->items[ii].subtable;
+        bytes   += sizeof(*subtable) + sizeof(*subtable->hash) +
+                   (subtable->hash->mask + 1) * sizeof(subtable->hash->buckets[0]) +
+                   subtable->rule_count * (sizeof(acl_rule_t) + sizeof(acl_rule_t*));
+        for (jj = 0; jj <= subtable->hash->mask; jj++) {
+            bytes += (NULL != subtable->hash->buckets[jj]) ? sizeof(acl_bucket_t) : 0;
+        }
+    }
+
+    return bytes;
+}
+
+/* Stage [sai_acl_stage_t], priority [sai_uint32_t], size [sai_uint32_t],
+ * bulk update [bool], update latencies [uint64_t], subtable count
+ * [sai_uint32_t], classifier memory [uint64_t] */
+sai_status_t stub_acl_table_attr_get(_In_ const sai_object_key_t   *key,
+                                     _Inout_ sai_attribute_value_t *value,
+                                     _In_ uint32_t                  attr_index,
+                                     _Inout_ vendor_cache_t        *cache,
+                                     void                          *arg)
+{
+    const acl_table_t *table;
+    sai_status_t       status;
+    uint32_t           table_index;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = acl_table_db_index(key->object_id, &table_index))) {
+        return status;
+    }
+
+    table = &acl_table_db[table_index];
+    switch ((long)arg) {
+    case SAI_ACL_TABLE_ATTR_STAGE:
+        value->s32 = table->stage;
+        break;
+
+    case SAI_ACL_TABLE_ATTR_PRIORITY:
+        value->u32 = table->priority;
+        break;
+
+    case SAI_ACL_TABLE_ATTR_SIZE:
+        /* grows up to the entry table when created without a size */
+        value->u32 = (0 != table->size) ? table->size : MAX_ACL_ENTRIES;
+        break;
+
+    case STUB_ACL_TABLE_ATTR_BULK_UPDATE:
+        value->booldata = table->bulk;
+        break;
+
+    case STUB_ACL_TABLE_ATTR_LAST_UPDATE_LATENCY:
+        value->u64 = table->last_update_ns;
+        break;
+
+    case STUB_ACL_TABLE_ATTR_MAX_UPDATE_LATENCY:
+        value->u64 = table->max_update_ns;
+        break;
+
+    case STUB_ACL_TABLE_ATTR_SUBTABLE_COUNT:
+        value->u32 = (NULL == table->subtables) ? 0 : table->subtables->count;
+        break;
+
+    case STUB_ACL_TABLE_ATTR_CLASSIFIER_MEMORY:
+        value->u64 = acl_classifier_memory(table->subtables);
+        break;
+    }
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Bulk update [bool]. Opening stages the entry changes of the table,
+ * closing compiles them and swaps the new classifier in */
+sai_status_t stub_acl_table_attr_set(_In_ const sai_object_key_t      *key,
+                                     _In_ const sai_attribute_value_t *value,
+                                     void                             *arg)
+{
+    acl_table_t *table;
+    sai_status_t status;
+    uint32_t     table_index;
+    uint64_t     start_ns;
+
+    STUB_LOG_ENTER();
+
+    pthread_rwlock_wrlock(&acl_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = acl_table_db_index(key->object_id, &table_index))) {
+        pthread_rwlock_unlock(&acl_db_lock);
+        return status;
+    }
+
+    table = &acl_table_db[table_index];
+    if (value->booldata || !table->bulk) {
+        table->bulk = value->booldata;
+        pthread_rwlock_unlock(&acl_db_lock);
+        STUB_LOG_EXIT();
+        return SAI_STATUS_SUCCESS;
+    }
+
+    start_ns = acl_now_ns();
+    if (SAI_STATUS_SUCCESS != (status = acl_table_commit(table_index))) {
+        pthread_rwlock_unlock(&acl_db_lock);
+        STUB_LOG_ERR("Failed to commit ACL table %u bulk update\n", table_index);
+        return status;
+    }
+    table->bulk = false;
+    acl_update_done(table, start_ns);
+
+    pthread_rwlock_unlock(&acl_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Match fields [bool] */
+sai_status_t stub_acl_table_field_get(_In_ const sai_object_key_t   *key,
+                                      _Inout_ sai_attribute_value_t *value,
+                                      _In_ uint32_t                  attr_index,
+                                      _Inout_ vendor_cache_t        *cache,
+                                      void                          *arg)
+{
+    sai_status_t status;
+    uint32_t     table_index;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = acl_table_db_index(key->object_id, &table_index))) {
+        return status;
+    }
+
+    value->booldata = 0 != (acl_table_db[table_index].fields & (1ULL << ((long)arg - SAI_ACL_TABLE_ATTR_FIELD_START)));
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/* UDF groups [sai_object_id_t], SAI_NULL_OBJECT_ID for slots without one */
+sai_status_t stub_acl_table_udf_group_get(_In_ const sai_object_key_t   *key,
+                                          _Inout_ sai_attribute_value_t *value,
+                                          _In_ uint32_t                  attr_index,
+                                          _Inout_ vendor_cache_t        *cache,
+                                          void                          *arg)
+{
+    const acl_udf_slot_t *udf;
+    sai_status_t          status;
+    uint32_t              table_index;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = acl_table_db_index(key->object_id, &table_index))) {
+        return status;
+    }
+
+    udf        = &acl_table_db[table_index].udf[(long)arg];
+    value->oid = SAI_NULL_OBJECT_ID;
+    if (0 != udf->length) {
+        status = stub_create_object(SAI_OBJECT_TYPE_UDF_GROUP, udf->group, &value->oid);
+    }
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/*
+ * Routine Description:
+ *    Create an ACL entry
+ *
+ * Arguments:
+ *    [out] acl_entry_id - the acl entry id
+ *    [in] attr_count - number of attributes
+ *    [in] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_create_acl_entry(_Out_ sai_object_id_t     *acl_entry_id,
+                                   _In_ uint32_t               attr_count,
+                                   _In_ const sai_attribute_t *attr_list)
+{
+    const sai_attribute_value_t *table_id, *admin_state;
+    uint32_t                     table_id_index, admin_state_index, table_index, entry_index = 0, ii;
+    acl_table_t                 *table;
+    acl_entry_t                 *entry;
+    acl_rule_t                  *rule;
+    acl_subtable_t              *subtable = NULL;
+    sai_status_t                 status;
+    uint64_t                     start_ns;
+    bool                         enabled;
+    char                         list_str[MAX_LIST_VALUE_STR_LEN];
+    char                         key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    if (NULL == acl_entry_id) {
+        STUB_LOG_ERR("NULL acl entry id param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS !=
+        (status =
+             check_attribs_metadata(attr_count, attr_list, acl_entry_attribs, acl_entry_vendor_attribs,
+                                    SAI_OPERATION_CREATE))) {
+        STUB_LOG_ERR("Failed attribs check\n");
+        return status;
+    }
+
+    sai_attr_list_to_str(attr_count, attr_list, acl_entry_attribs, MAX_LIST_VALUE_STR_LEN, list_str);
+    STUB_LOG_NTC("Create ACL entry, %s\n", list_str);
+
+    assert(SAI_STATUS_SUCCESS ==
+           find_attrib_in_list(attr_count, attr_list, SAI_ACL_ENTRY_ATTR_TABLE_ID, &table_id, &table_id_index));
+    enabled = (SAI_STATUS_SUCCESS ==
+               find_attrib_in_list(attr_count, attr_list, SAI_ACL_ENTRY_ATTR_ADMIN_STATE, &admin_state,
+                                   &admin_state_index)) ? admin_state->booldata : true;
+
+    if (NULL == (rule = calloc(1, sizeof(*rule)))) {
+        return SAI_STATUS_NO_MEMORY;
+    }
+    rule->priority = STUB_ACL_ENTRY_MIN_PRIORITY;
+    rule->counter  = ACL_NO_COUNTER;
+    rule->policer  = STUB_NO_POLICER;
+    rule->ip_type  = SAI_ACL_IP_TYPE_ANY;
+    rule->ip_frag  = SAI_ACL_IP_FRAG_ANY;
+
+    pthread_rwlock_wrlock(&acl_db_lock);
+    start_ns = acl_now_ns();
+
+    if (SAI_STATUS_SUCCESS != acl_table_db_index(table_id->oid, &table_index)) {
+        status = SAI_STATUS_INVALID_ATTR_VALUE_0 + table_id_index;
+        goto out;
+    }
+    table = &acl_table_db[table_index];
+
+    if ((table->entry_count >= MAX_ACL_ENTRIES) || ((0 != table->size) && (table->entry_count >= table->size))) {
+        STUB_LOG_ERR("ACL table %u full\n", table_index);
+        status = SAI_STATUS_TABLE_FULL;
+        goto out;
+    }
+
+    for (ii = 0; ii < attr_count; ii++) {
+        if ((SAI_ACL_ENTRY_ATTR_TABLE_ID == attr_list[ii].id) || (SAI_ACL_ENTRY_ATTR_ADMIN_STATE == attr_list[ii].id)) {
+            continue;
+        }
+        if (SAI_STATUS_SUCCESS != (status = acl_rule_set(table_index, rule, &attr_list[ii], ii))) {
+            goto out;
+        }
+    }
+
+    if ((0 == rule->fields) && (0 == rule->udf_fields)) {
+        STUB_LOG_ERR("ACL entry without match fields\n");
+        status = SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING;
+        goto out;
+    }
+
+    for (ii = 0; ii < MAX_ACL_ENTRIES; ii++) {
+        entry_index = (acl_entry_next + ii) % MAX_ACL_ENTRIES;
+        if (!acl_entry_db[entry_index].is_used) {
+            break;
+        }
+    }
+
+    if (MAX_ACL_ENTRIES == ii) {
+        STUB_LOG_ERR("ACL entry table full\n");
+        status = SAI_STATUS_TABLE_FULL;
+        goto out;
+    }
+    rule->entry = entry_index;
+
+    /* A bulk update compiles the rule on commit */
+    if (enabled && !table->bulk && (SAI_STATUS_SUCCESS != (status = acl_rule_insert(table, rule, &subtable)))) {
+        goto out;
+    }
+
+    entry              = &acl_entry_db[entry_index];
+    entry->is_used     = true;
+    entry->admin_state = enabled;
+    entry->table       = table_index;
+    entry->rule        = rule;
+    entry->subtable    = subtable;
+    acl_rule_ref(NULL, rule);
+    table->entry_count++;
+    acl_entry_next = (entry_index + 1) % MAX_ACL_ENTRIES;
+    rule           = NULL;
+    if (!table->bulk) {
+        acl_update_done(table, start_ns);
+    }
+
+out:
+    pthread_rwlock_unlock(&acl_db_lock);
+    if (NULL != rule) {
+        db_policer_unbind(rule->policer);
+        free(rule);
+    }
+
+    if (SAI_STATUS_SUCCESS != status) {
+        return status;
+    }
+
+    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_ACL_ENTRY, entry_index, acl_entry_id))) {
+        return status;
+    }
+    acl_key_to_str(*acl_entry_id, SAI_OBJECT_TYPE_ACL_ENTRY, "entry", key_str);
+    STUB_LOG_NTC("Created %s\n", key_str);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Delete an ACL entry
+ *
+ * Arguments:
+ *    [in] acl_entry_id - the acl entry id
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_delete_acl_entry(_In_ sai_object_id_t acl_entry_id)
+{
+    acl_entry_t *entry;
+    acl_table_t *table;
+    char         key_str[MAX_KEY_STR_LEN];
+    sai_status_t status;
+    uint32_t     entry_index;
+    uint64_t     start_ns;
+
+    STUB_LOG_ENTER();
+
+    acl_key_to_str(acl_entry_id, SAI_OBJECT_TYPE_ACL_ENTRY, "entry", key_str);
+    STUB_LOG_NTC("Remove %s\n", key_str);
+
+    pthread_rwlock_wrlock(&acl_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = acl_entry_db_index(acl_entry_id, &entry_index))) {
+        pthread_rwlock_unlock(&acl_db_lock);
+        return status;
+    }
+
+    start_ns = acl_now_ns();
+    entry    = &acl_entry_db[entry_index];
+    table    = &acl_table_db[entry->table];
+
+    if (table->bulk) {
+        /* The classifier keeps the rule until the commit */
+        if (NULL != entry->subtable) {
+            acl_rule_retire(table, entry->rule);
+        } else {
+            acl_rule_ref(entry->rule, NULL);
+            free(entry->rule);
+        }
+    } else {
+        if ((NULL != entry->subtable) &&
+            (SAI_STATUS_SUCCESS != (status = acl_rule_remove(table, entry->subtable, entry->rule)))) {
+            pthread_rwlock_unlock(&acl_db_lock);
+            return status;
+        }
+        acl_rule_ref(entry->rule, NULL);
+        stub_rcu_defer_free(entry->rule);
+        acl_update_done(table, start_ns);
+    }
+
+    table->entry_count--;
+    memset(entry, 0, sizeof(*entry));
+
+    pthread_rwlock_unlock(&acl_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Set ACL entry attribute
+ *
+ * Arguments:
+ *    [in] acl_entry_id - the acl entry id
+ *    [in] attr - attribute
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_set_acl_entry_attribute(_In_ sai_object_id_t acl_entry_id, _In_ const sai_attribute_t *attr)
+{
+    const sai_object_key_t key = { .object_id = acl_entry_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    acl_key_to_str(acl_entry_id, SAI_OBJECT_TYPE_ACL_ENTRY, "entry", key_str);
+    return sai_set_attribute(&key, key_str, acl_entry_attribs, acl_entry_vendor_attribs, attr);
+}
+
+/*
+ * Routine Description:
+ *    Get ACL entry attribute
+ *
+ * Arguments:
+ *    [in] acl_entry_id - acl entry id
+ *    [in] attr_count - number of attributes
+ *    [out] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_acl_entry_attribute(_In_ sai_object_id_t   acl_entry_id,
+                                          _In_ uint32_t          attr_count,
+                                          _Out_ sai_attribute_t *attr_list)
+{
+    const sai_object_key_t key = { .object_id = acl_entry_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
+
+    STUB_LOG_ENTER();
+
+    acl_key_to_str(acl_entry_id, SAI_OBJECT_TYPE_ACL_ENTRY, "entry", key_str);
+
+    pthread_rwlock_rdlock(&acl_db_lock);
+    status = sai_get_attributes(&key, key_str, acl_entry_attribs, acl_entry_vendor_attribs, attr_count, attr_list);
+    pthread_rwlock_unlock(&acl_db_lock);
+
+    return status;
+}
+
+/* UDF field of an entry, data and mask one byte per byte of the group */
+static sai_status_t acl_entry_udf_get(_In_ const acl_table_t      *table,
+                                      _In_ const acl_rule_t       *rule,
+                                      _In_ uint32_t                slot,
+                                      _Inout_ sai_acl_field_data_t *field)
+{
+    const acl_udf_slot_t *udf = &table->udf[slot];
+    sai_status_t          status;
+
+    field->enable = 0 != (rule->udf_fields & (1U << slot));
+    if (!field->enable) {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    if (SAI_STATUS_SUCCESS !=
+        (status = stub_fill_u8list((uint8_t*)rule->key.f.udf + udf->offset, udf->length, &field->data.u8list))) {
+        return status;
+    }
+
+    return stub_fill_u8list((uint8_t*)rule->mask.f.udf + udf->offset, udf->length, &field->mask.u8list);
+}
+
+/* Match field of an entry, as it was set */
+static sai_status_t acl_entry_field_get(_In_ const acl_rule_t      *rule,
+                                        _In_ sai_attr_id_t          id,
+                                        _Inout_ sai_acl_field_data_t *field)
+{
+    const acl_field_info_t *info = &acl_fields[ACL_FIELD_INDEX(id)];
+    sai_object_id_t         ports[PORT_NUMBER];
+    uint32_t                port, count = 0;
+    uint32_t                port_bits = (SAI_ACL_ENTRY_ATTR_FIELD_IN_PORTS == id) ? rule->in_ports : rule->out_ports;
+
+    field->enable = 0 != (rule->fields & (1ULL << ACL_FIELD_INDEX(id)));
+    if (!field->enable) {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    switch (info->kind) {
+    case ACL_FIELD_RAW:
+        memset(&field->mask, 0, sizeof(field->mask));
+        memset(&field->data, 0, sizeof(field->data));
+        memcpy(&field->mask, (const uint8_t*)&rule->mask + info->offset, info->size);
+        memcpy(&field->data, (const uint8_t*)&rule->key + info->offset, info->size);
+        return SAI_STATUS_SUCCESS;
+
+    case ACL_FIELD_PORT:
+        return stub_create_object(SAI_OBJECT_TYPE_PORT, *((const uint8_t*)&rule->key + info->offset), &field->data.oid);
+
+    case ACL_FIELD_PORTS:
+        for (port = 0; port < PORT_NUMBER; port++) {
+            if (port_bits & (1U << port)) {
+                stub_create_object(SAI_OBJECT_TYPE_PORT, port, &ports[count++]);
+            }
+        }
+        return stub_fill_objlist(ports, count, &field->data.objlist);
+
+    case ACL_FIELD_IP_TYPE:
+        field->data.s32 = rule->ip_type;
+        return SAI_STATUS_SUCCESS;
+
+    case ACL_FIELD_IP_FRAG:
+        field->data.s32 = rule->ip_frag;
+        return SAI_STATUS_SUCCESS;
+
+    case ACL_FIELD_VLAN_TAGS:
+        field->data.s32 = rule->key.f.vlan_tags;
+        return SAI_STATUS_SUCCESS;
+
+    default:
+        return SAI_STATUS_NOT_SUPPORTED;
+    }
+}
+
+/* Table id [sai_object_id_t], priority [sai_uint32_t], admin state [bool],
+ * match fields [sai_acl_field_data_t], actions [sai_acl_action_data_t] */
+sai_status_t stub_acl_entry_attr_get(_In_ const sai_object_key_t   *key,
+                                     _Inout_ sai_attribute_value_t *value,
+                                     _In_ uint32_t                  attr_index,
+                                     _Inout_ vendor_cache_t        *cache,
+                                     void                          *arg)
+{
+    const acl_entry_t *entry;
+    const acl_rule_t  *rule;
+    sai_attr_id_t      id = (long)arg;
+    sai_status_t       status;
+    uint32_t           entry_index;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = acl_entry_db_index(key->object_id, &entry_index))) {
+        return status;
+    }
+
+    entry = &acl_entry_db[entry_index];
+    rule  = entry->rule;
+
+    switch (id) {
+    case SAI_ACL_ENTRY_ATTR_TABLE_ID:
+        return stub_create_object(SAI_OBJECT_TYPE_ACL_TABLE, entry->table, &value->oid);
+
+    case SAI_ACL_ENTRY_ATTR_PRIORITY:
+        value->u32 = rule->priority;
+        return SAI_STATUS_SUCCESS;
+
+    case SAI_ACL_ENTRY_ATTR_ADMIN_STATE:
+        value->booldata = entry->admin_state;
+        return SAI_STATUS_SUCCESS;
+
+    case SAI_ACL_ENTRY_ATTR_PACKET_ACTION:
+        value->aclaction.enable        = 0 != (rule->actions & ACL_ACTION_BIT(id));
+        value->aclaction.parameter.s32 = rule->packet_action;
+        return SAI_STATUS_SUCCESS;
+
+    case SAI_ACL_ENTRY_ATTR_ACTION_REDIRECT:
+        value->aclaction.enable        = 0 != (rule->actions & ACL_ACTION_BIT(id));
+        value->aclaction.parameter.oid = rule->redirect;
+        return SAI_STATUS_SUCCESS;
+
+    case SAI_ACL_ENTRY_ATTR_ACTION_COUNTER:
+        value->aclaction.enable        = 0 != (rule->actions & ACL_ACTION_BIT(id));
+        value->aclaction.parameter.oid = SAI_NULL_OBJECT_ID;
+        if (!value->aclaction.enable) {
+            return SAI_STATUS_SUCCESS;
+        }
+        return stub_create_object(SAI_OBJECT_TYPE_ACL_COUNTER, rule->counter, &value->aclaction.parameter.oid);
+
+    case SAI_ACL_ENTRY_ATTR_ACTION_SET_POLICER:
+        value->aclaction.enable        = 0 != (rule->actions & ACL_ACTION_BIT(id));
+        value->aclaction.parameter.oid = SAI_NULL_OBJECT_ID;
+        if (!value->aclaction.enable) {
+            return SAI_STATUS_SUCCESS;
+        }
+        return stub_create_object(SAI_OBJECT_TYPE_POLICER, rule->policer, &value->aclaction.parameter.oid);
+
+    default:
+        if ((id >= SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN) && (ACL_UDF_SLOT(id) < STUB_ACL_TABLE_UDF_GROUPS)) {
+            status = acl_entry_udf_get(&acl_table_db[entry->table], rule, ACL_UDF_SLOT(id), &value->aclfield);
+        } else {
+            status = acl_entry_field_get(rule, id, &value->aclfield);
+        }
+        STUB_LOG_EXIT();
+        return status;
+    }
+}
+
+/* Priority [sai_uint32_t], admin state [bool], match fields
+ * [sai_acl_field_data_t], actions [sai_acl_action_data_t]. A change
+ * compiles a new rule and swaps it in, lookups see either rule */
+sai_status_t stub_acl_entry_attr_set(_In_ const sai_object_key_t      *key,
+                                     _In_ const sai_attribute_value_t *value,
+                                     void                             *arg)
+{
+    const sai_attribute_t attr = { .id = (long)arg, .value = *value };
+    acl_entry_t          *entry;
+    acl_table_t          *table;
+    acl_rule_t           *rule;
+    acl_subtable_t       *subtable = NULL;
+    sai_status_t          status;
+    uint32_t              entry_index;
+    uint64_t              start_ns;
+
+    STUB_LOG_ENTER();
+
+    pthread_rwlock_wrlock(&acl_db_lock);
+    start_ns = acl_now_ns();
+
+    if (SAI_STATUS_SUCCESS != (status = acl_entry_db_index(key->object_id, &entry_index))) {
+        pthread_rwlock_unlock(&acl_db_lock);
+        return status;
+    }
+
+    entry = &acl_entry_db[entry_index];
+    table = &acl_table_db[entry->table];
+
+    if ((SAI_ACL_ENTRY_ATTR_ADMIN_STATE == attr.id) && table->bulk) {
+        entry->admin_state = value->booldata;
+        pthread_rwlock_unlock(&acl_db_lock);
+        STUB_LOG_EXIT();
+        return SAI_STATUS_SUCCESS;
+    }
+
+    if (SAI_ACL_ENTRY_ATTR_ADMIN_STATE == attr.id) {
+        if (value->booldata && (NULL == entry->subtable)) {
+            status = acl_rule_insert(table, entry->rule, &entry->subtable);
+        } else if (!value->booldata && (NULL != entry->subtable) &&
+                   (SAI_STATUS_SUCCESS == (status = acl_rule_remove(table, entry->subtable, entry->rule)))) {
+            entry->subtable = NULL;
+        }
+        if (SAI_STATUS_SUCCESS == status) {
+            entry->admin_state = value->booldata;
+            acl_update_done(table, start_ns);
+        }
+        pthread_rwlock_unlock(&acl_db_lock);
+        STUB_LOG_EXIT();
+        return status;
+    }
+
+    if (NULL == (rule = malloc(sizeof(*rule)))) {
+        pthread_rwlock_unlock(&acl_db_lock);
+        return SAI_STATUS_NO_MEMORY;
+    }
+    *rule              = *entry->rule;
+    rule->retired_next = NULL;
+    db_policer_ref(rule->policer);
+
+    if (SAI_STATUS_SUCCESS != (status = acl_rule_set(entry->table, rule, &attr, 0))) {
+        pthread_rwlock_unlock(&acl_db_lock);
+        db_policer_unbind(rule->policer);
+        free(rule);
+        return status;
+    }
+
+    if (table->bulk) {
+        /* The classifier keeps the old rule until the commit */
+        acl_rule_ref(NULL, rule);
+        if (NULL != entry->subtable) {
+            acl_rule_retire(table, entry->rule);
+        } else {
+            acl_rule_ref(entry->rule, NULL);
+            free(entry->rule);
+        }
+        entry->rule     = rule;
+        entry->subtable = NULL;
+        pthread_rwlock_unlock(&acl_db_lock);
+        STUB_LOG_EXIT();
+        return SAI_STATUS_SUCCESS;
+    }
+
+    if ((NULL != entry->subtable) && (SAI_STATUS_SUCCESS != (status = acl_rule_insert(table, rule, &subtable)))) {
+        pthread_rwlock_unlock(&acl_db_lock);
+        db_policer_unbind(rule->policer);
+        free(rule);
+        return status;
+    }
+
+    /* The new rule is in, take the old one out */
+    if ((NULL != entry->subtable) &&
+        (SAI_STATUS_SUCCESS != (status = acl_rule_remove(table, entry->subtable, entry->rule)))) {
+        if (SAI_STATUS_SUCCESS == acl_rule_remove(table, subtable, rule)) {
+            db_policer_unbind(rule->policer);
+            stub_rcu_defer_free(rule);
+        } else {
+            STUB_LOG_ERR("ACL entry %u left with two rules\n", entry_index);
+        }
+        pthread_rwlock_unlock(&acl_db_lock);
+        return status;
+    }
+
+    acl_rule_ref(entry->rule, rule);
+    stub_rcu_defer_free(entry->rule);
+    entry->rule     = rule;
+    entry->subtable = subtable;
+    acl_update_done(table, start_ns);
+
+    pthread_rwlock_unlock(&acl_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Create an ACL counter
+ *
+ * Arguments:
+ *    [out] acl_counter_id - the acl counter id
+ *    [in] attr_count - number of attributes
+ *    [in] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_create_acl_counter(_Out_ sai_object_id_t     *acl_counter_id,
+                                     _In_ uint32_t               attr_count,
+                                     _In_ const sai_attribute_t *attr_list)
+{
+    const sai_attribute_value_t *table_id, *packet_count, *byte_count;
+    uint32_t                     table_id_index, packet_count_index, byte_count_index, table_index, counter_index;
+    acl_counter_t               *counter;
+    sai_status_t                 status;
+    bool                         packets, bytes;
+    char                         list_str[MAX_LIST_VALUE_STR_LEN];
+    char                         key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    if (NULL == acl_counter_id) {
+        STUB_LOG_ERR("NULL acl counter id param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS !=
+        (status =
+             check_attribs_metadata(attr_count, attr_list, acl_counter_attribs, acl_counter_vendor_attribs,
+                                    SAI_OPERATION_CREATE))) {
+        STUB_LOG_ERR("Failed attribs check\n");
+        return status;
+    }
+
+    sai_attr_list_to_str(attr_count, attr_list, acl_counter_attribs, MAX_LIST_VALUE_STR_LEN, list_str);
+    STUB_LOG_NTC("Create ACL counter, %s\n", list_str);
+
+    assert(SAI_STATUS_SUCCESS ==
+           find_attrib_in_list(attr_count, attr_list, SAI_ACL_COUNTER_ATTR_TABLE_ID, &table_id, &table_id_index));
+    packets = (SAI_STATUS_SUCCESS ==
+               find_attrib_in_list(attr_count, attr_list, SAI_ACL_COUNTER_ATTR_ENABLE_PACKET_COUNT, &packet_count,
+                                   &packet_count_index)) ? packet_count->booldata : false;
+    /* bytes are counted unless disabled */
+    bytes = (SAI_STATUS_SUCCESS ==
+             find_attrib_in_list(attr_count, attr_list, SAI_ACL_COUNTER_ATTR_ENABLE_BYTE_COUNT, &byte_count,
+                                 &byte_count_index)) ? byte_count->booldata : true;
+
+    if (!packets && !bytes) {
+        STUB_LOG_ERR("ACL counter counts neither packets nor bytes\n");
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + byte_count_index;
+    }
+
+    pthread_rwlock_wrlock(&acl_db_lock);
+
+    if (SAI_STATUS_SUCCESS != acl_table_db_index(table_id->oid, &table_index)) {
+        pthread_rwlock_unlock(&acl_db_lock);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + table_id_index;
+    }
+
+    for (counter_index = 0; counter_index < MAX_ACL_COUNTERS; counter_index++) {
+        if (!acl_counter_db[counter_index].is_used) {
+            break;
+        }
+    }
+
+    if (MAX_ACL_COUNTERS == counter_index) {
+        pthread_rwlock_unlock(&acl_db_lock);
+        STUB_LOG_ERR("ACL counter table full\n");
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    counter               = &acl_counter_db[counter_index];
+    counter->is_used      = true;
+    counter->table        = table_index;
+    counter->packet_count = packets;
+    counter->byte_count   = bytes;
+    counter->ref_count    = 0;
+    /* The shards keep the counts of earlier counters at this index */
+    acl_counter_sum(&counter_index, 1, &counter->packets_base, &counter->bytes_base);
+    acl_table_db[table_index].counter_count++;
+
+    pthread_rwlock_unlock(&acl_db_lock);
+
+    if (SAI_STATUS_SUCCESS !=
+        (status = stub_create_object(SAI_OBJECT_TYPE_ACL_COUNTER, counter_index, acl_counter_id))) {
+        return status;
+    }
+    acl_key_to_str(*acl_counter_id, SAI_OBJECT_TYPE_ACL_COUNTER, "counter", key_str);
+    STUB_LOG_NTC("Created %s\n", key_str);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Delete an ACL counter
+ *
+ * Arguments:
+ *    [in] acl_counter_id - the acl counter id
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_delete_acl_counter(_In_ sai_object_id_t acl_counter_id)
+{
+    char         key_str[MAX_KEY_STR_LEN];
+    sai_status_t status;
+    uint32_t     counter_index;
+
+    STUB_LOG_ENTER();
+
+    acl_key_to_str(acl_counter_id, SAI_OBJECT_TYPE_ACL_COUNTER, "counter", key_str);
+    STUB_LOG_NTC("Remove %s\n", key_str);
+
+    pthread_rwlock_wrlock(&acl_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = acl_counter_db_index(acl_counter_id, &counter_index))) {
+        pthread_rwlock_unlock(&acl_db_lock);
+        return status;
+    }
+
+    if (0 != acl_counter_db[counter_index].ref_count) {
+        pthread_rwlock_unlock(&acl_db_lock);
+        STUB_LOG_ERR("ACL counter %u is in use\n", counter_index);
+        return SAI_STATUS_OBJECT_IN_USE;
+    }
+
+    acl_table_db[acl_counter_db[counter_index].table].counter_count--;
+    acl_counter_db[counter_index].is_used = false;
+
+    pthread_rwlock_unlock(&acl_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Set ACL counter attribute
+ *
+ * Arguments:
+ *    [in] acl_counter_id - the acl counter id
+ *    [in] attr - attribute
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_set_acl_counter_attribute(_In_ sai_object_id_t acl_counter_id, _In_ const sai_attribute_t *attr)
+{
+    const sai_object_key_t key = { .object_id = acl_counter_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    acl_key_to_str(acl_counter_id, SAI_OBJECT_TYPE_ACL_COUNTER, "counter", key_str);
+    return sai_set_attribute(&key, key_str, acl_counter_attribs, acl_counter_vendor_attribs, attr);
+}
+
+/*
+ * Routine Description:
+ *    Get ACL counter attribute
+ *
+ * Arguments:
+ *    [in] acl_counter_id - acl counter id
+ *    [in] attr_count - number of attributes
+ *    [out] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_acl_counter_attribute(_In_ sai_object_id_t   acl_counter_id,
+                                            _In_ uint32_t          attr_count,
+                                            _Out_ sai_attribute_t *attr_list)
+{
+    const sai_object_key_t key = { .object_id = acl_counter_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
+
+    STUB_LOG_ENTER();
+
+    acl_key_to_str(acl_counter_id, SAI_OBJECT_TYPE_ACL_COUNTER, "counter", key_str);
+
+    pthread_rwlock_rdlock(&acl_db_lock);
+    status = sai_get_attributes(&key, key_str, acl_counter_attribs, acl_counter_vendor_attribs, attr_count,
+                                attr_list);
+    pthread_rwlock_unlock(&acl_db_lock);
+
+    return status;
+}
+
+/* Table id [sai_object_id_t], count enables [bool], packets and bytes [uint64_t] */
+sai_status_t stub_acl_counter_attr_get(_In_ const sai_object_key_t   *key,
+                                       _Inout_ sai_attribute_value_t *value,
+                                       _In_ uint32_t                  attr_index,
+                                       _Inout_ vendor_cache_t        *cache,
+                                       void                          *arg)
+{
+    const acl_counter_t *counter;
+    sai_status_t         status;
+    uint32_t             counter_index;
+    uint64_t             packets, bytes;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = acl_counter_db_index(key->object_id, &counter_index))) {
+        return status;
+    }
+
+    counter = &acl_counter_db[counter_index];
+    switch ((long)arg) {
+    case SAI_ACL_COUNTER_ATTR_TABLE_ID:
+        return stub_create_object(SAI_OBJECT_TYPE_ACL_TABLE, counter->table, &value->oid);
+
+    case SAI_ACL_COUNTER_ATTR_ENABLE_PACKET_COUNT:
+        value->booldata = counter->packet_count;
+        break;
+
+    case SAI_ACL_COUNTER_ATTR_ENABLE_BYTE_COUNT:
+        value->booldata = counter->byte_count;
+        break;
+
+    case SAI_ACL_COUNTER_ATTR_PACKETS:
+        acl_counter_sum(&counter_index, 1, &packets, &bytes);
+        value->u64 = packets - counter->packets_base;
+        break;
+
+    case SAI_ACL_COUNTER_ATTR_BYTES:
+        acl_counter_sum(&counter_index, 1, &packets, &bytes);
+        value->u64 = bytes - counter->bytes_base;
+        break;
+    }
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Packets and bytes [uint64_t], 0 clears the counter */
+sai_status_t stub_acl_counter_attr_set(_In_ const sai_object_key_t      *key,
+                                       _In_ const sai_attribute_value_t *value,
+                                       void                             *arg)
+{
+    acl_counter_t *counter;
+    sai_status_t   status;
+    uint32_t       counter_index;
+    uint64_t       packets, bytes;
+
+    STUB_LOG_ENTER();
+
+    pthread_rwlock_wrlock(&acl_db_lock);
+
+    /* The shards are not written back, the base moves so the sum reads value */
+    if (SAI_STATUS_SUCCESS == (status = acl_counter_db_index(key->object_id, &counter_index))) {
+        counter = &acl_counter_db[counter_index];
+        acl_counter_sum(&counter_index, 1, &packets, &bytes);
+        if (SAI_ACL_COUNTER_ATTR_PACKETS == (long)arg) {
+            counter->packets_base = packets - value->u64;
+        } else {
+            counter->bytes_base = bytes - value->u64;
+        }
+    }
+
+    pthread_rwlock_unlock(&acl_db_lock);
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+const sai_acl_api_t acl_api = {
+    stub_create_acl_table,
+    stub_delete_acl_table,
+    stub_set_acl_table_attribute,
+    stub_get_acl_table_attribute,
+    stub_create_acl_entry,
+    stub_delete_acl_entry,
+    stub_set_acl_entry_attribute,
+    stub_get_acl_entry_attribute,
+    stub_create_acl_counter,
+    stub_delete_acl_counter,
+    stub_set_acl_counter_attribute,
+    stub_get_acl_counter_attribute
+};
@@ -0,0 +1,1860 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#include "sai.h"
+#include "stub_sai.h"
+#include "stub_sai_qos_map.h"
+#include "stub_sai_buffer.h"
+#include "assert.h"
+
+#undef  __MODULE__
+#define __MODULE__ SAI_BUFFER
+
+static const sai_attribute_entry_t buffer_pool_attribs[] = {
+    { SAI_BUFFER_POOL_ATTR_SHARED_SIZE, false, false, false, true,
+      "Buffer pool shared size", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_BUFFER_POOL_ATTR_TYPE, true, true, false, true,
+      "Buffer pool type", SAI_ATTR_VAL_TYPE_S32 },
+    { SAI_BUFFER_POOL_ATTR_SIZE, true, true, true, true,
+      "Buffer pool size", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_BUFFER_POOL_ATTR_TH_MODE, false, true, false, true,
+      "Buffer pool threshold mode", SAI_ATTR_VAL_TYPE_S32 },
+    { END_FUNCTIONALITY_ATTRIBS_ID, false, false, false, false,
+      "", SAI_ATTR_VAL_TYPE_UNDETERMINED }
+};
+
+static const sai_attribute_entry_t buffer_profile_attribs[] = {
+    { SAI_BUFFER_PROFILE_ATTR_POOL_ID, true, true, true, true,
+      "Buffer profile pool", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_BUFFER_PROFILE_ATTR_BUFFER_SIZE, true, true, true, true,
+      "Buffer profile size", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_BUFFER_PROFILE_ATTR_SHARED_DYNAMIC_TH, false, true, true, true,
+      "Buffer profile dynamic threshold", SAI_ATTR_VAL_TYPE_S8 },
+    { SAI_BUFFER_PROFILE_ATTR_SHARED_STATIC_TH, false, true, true, true,
+      "Buffer profile static threshold", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_BUFFER_PROFILE_ATTR_XOFF_TH, false, true, true, true,
+      "Buffer profile XOFF threshold", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_BUFFER_PROFILE_ATTR_XON_TH, false, true, true, true,
+      "Buffer profile XON threshold", SAI_ATTR_VAL_TYPE_U32 },
+    { END_FUNCTIONALITY_ATTRIBS_ID, false, false, false, false,
+      "", SAI_ATTR_VAL_TYPE_UNDETERMINED }
+};
+
+static const sai_attribute_entry_t priority_group_attribs[] = {
+    { SAI_INGRESS_PRIORITY_GROUP_ATTR_BUFFER_PROFILE, false, false, true, true,
+      "Priority group buffer profile", SAI_ATTR_VAL_TYPE_OID },
+    { END_FUNCTIONALITY_ATTRIBS_ID, false, false, false, false,
+      "", SAI_ATTR_VAL_TYPE_UNDETERMINED }
+};
+
+sai_status_t stub_buffer_pool_attr_get(_In_ const sai_object_key_t   *key,
+                                       _Inout_ sai_attribute_value_t *value,
+                                       _In_ uint32_t                  attr_index,
+                                       _Inout_ vendor_cache_t        *cache,
+                                       void                          *arg);
+sai_status_t stub_buffer_pool_size_set(_In_ const sai_object_key_t      *key,
+                                       _In_ const sai_attribute_value_t *value,
+                                       void                             *arg);
+sai_status_t stub_buffer_profile_attr_get(_In_ const sai_object_key_t   *key,
+                                          _Inout_ sai_attribute_value_t *value,
+                                          _In_ uint32_t                  attr_index,
+                                          _Inout_ vendor_cache_t        *cache,
+                                          void                          *arg);
+sai_status_t stub_buffer_profile_attr_set(_In_ const sai_object_key_t      *key,
+                                          _In_ const sai_attribute_value_t *value,
+                                          void                             *arg);
+sai_status_t stub_priority_group_profile_get(_In_ const sai_object_key_t   *key,
+                                             _Inout_ sai_attribute_value_t *value,
+                                             _In_ uint32_t                  attr_index,
+                                             _Inout_ vendor_cache_t        *cache,
+                                             void                          *arg);
+sai_status_t stub_priority_group_profile_set(_In_ const sai_object_key_t      *key,
+                                             _In_ const sai_attribute_value_t *value,
+                                             void                             *arg);
+
+static const sai_vendor_attribute_entry_t buffer_pool_vendor_attribs[] = {
+    { SAI_BUFFER_POOL_ATTR_SHARED_SIZE,
+      { false, false, false, true },
+      { false, false, false, true },
+      stub_buffer_pool_attr_get, (void*)SAI_BUFFER_POOL_ATTR_SHARED_SIZE,
+      NULL, NULL },
+    { SAI_BUFFER_POOL_ATTR_TYPE,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_buffer_pool_attr_get, (void*)SAI_BUFFER_POOL_ATTR_TYPE,
+      NULL, NULL },
+    { SAI_BUFFER_POOL_ATTR_SIZE,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_buffer_pool_attr_get, (void*)SAI_BUFFER_POOL_ATTR_SIZE,
+      stub_buffer_pool_size_set, NULL },
+    { SAI_BUFFER_POOL_ATTR_TH_MODE,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_buffer_pool_attr_get, (void*)SAI_BUFFER_POOL_ATTR_TH_MODE,
+      NULL, NULL },
+};
+
+#define BUFFER_PROFILE_VENDOR_ATTR(attr)          \
+    { attr,                                       \
+      { true, false, true, true },                \
+      { true, false, true, true },                \
+      stub_buffer_profile_attr_get, (void*)attr,  \
+      stub_buffer_profile_attr_set, (void*)attr }
+
+static const sai_vendor_attribute_entry_t buffer_profile_vendor_attribs[] = {
+    BUFFER_PROFILE_VENDOR_ATTR(SAI_BUFFER_PROFILE_ATTR_POOL_ID),
+    BUFFER_PROFILE_VENDOR_ATTR(SAI_BUFFER_PROFILE_ATTR_BUFFER_SIZE),
+    BUFFER_PROFILE_VENDOR_ATTR(SAI_BUFFER_PROFILE_ATTR_SHARED_DYNAMIC_TH),
+    BUFFER_PROFILE_VENDOR_ATTR(SAI_BUFFER_PROFILE_ATTR_SHARED_STATIC_TH),
+    BUFFER_PROFILE_VENDOR_ATTR(SAI_BUFFER_PROFILE_ATTR_XOFF_TH),
+    BUFFER_PROFILE_VENDOR_ATTR(SAI_BUFFER_PROFILE_ATTR_XON_TH),
+};
+
+static const sai_vendor_attribute_entry_t priority_group_vendor_attribs[] = {
+    { SAI_INGRESS_PRIORITY_GROUP_ATTR_BUFFER_PROFILE,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_priority_group_profile_get, NULL,
+      stub_priority_group_profile_set, NULL },
+};
+
+/* State DB *************/
+#define MAX_BUFFER_POOLS       (2 * STUB_BUFFER_POOLS)
+#define MAX_BUFFER_PROFILES    64
+#define BUFFER_NONE            UINT32_MAX
+#define BUFFER_TOTAL_CELLS     (STUB_BUFFER_SIZE / STUB_BUFFER_CELL_SIZE)
+/* cells to hold a number of bytes */
+#define BUFFER_CELLS(bytes)    ((uint32_t)(((uint64_t)(bytes) + STUB_BUFFER_CELL_SIZE - 1) / STUB_BUFFER_CELL_SIZE))
+#define BUFFER_BYTES(cells)    ((uint64_t)(cells) * STUB_BUFFER_CELL_SIZE)
+/* SAI counters, then the stub ones of stub_sai_buffer.h */
+#define BUFFER_PG_SAI_STATS    (SAI_INGRESS_PRIORITY_GROUP_STAT_WATERMARK_BYTES + 1)
+#define BUFFER_PG_STAT_COUNT   (BUFFER_PG_SAI_STATS + STUB_INGRESS_PRIORITY_GROUP_STAT_XOFF_COUNT - \
+                                SAI_INGRESS_PRIORITY_GROUP_STAT_CUSTOM_RANGE_BASE + 1)
+#define BUFFER_PG_STAT(counter) \
+    (((uint32_t)(counter) < SAI_INGRESS_PRIORITY_GROUP_STAT_CUSTOM_RANGE_BASE) ? (uint32_t)(counter) : \
+     BUFFER_PG_SAI_STATS + (uint32_t)(counter) - SAI_INGRESS_PRIORITY_GROUP_STAT_CUSTOM_RANGE_BASE)
+
+typedef struct _buffer_pool_t {
+    bool        is_used;
+    sai_int32_t type;
+    sai_int32_t mode;
+    uint32_t    size;
+    uint32_t    cells;
+    /* reserved and headroom cells of the users of its profiles */
+    uint32_t    reserved;
+    /* cells taken, and those of them above the reserved cells of their users */
+    uint32_t    used;
+    uint32_t    shared;
+    uint32_t    watermark;
+    /* profiles of the pool */
+    uint32_t    ref_count;
+} buffer_pool_t;
+
+typedef struct _buffer_profile_t {
+    bool     is_used;
+    uint32_t pool;
+    uint32_t size;
+    bool     has_dynamic_th;
+    int8_t   dynamic_th;
+    bool     has_static_th;
+    uint32_t static_th;
+    uint32_t xoff;
+    uint32_t xon;
+    /* priority groups and queues binding the profile */
+    uint32_t ref_count;
+} buffer_profile_t;
+
+/* A priority group or a queue, and the cells its frames take */
+typedef struct _buffer_user_t {
+    uint32_t profile;
+    bool     ingress;
+    bool     xoff;
+    /* reserved and shared cells, then headroom cells */
+    uint32_t cells;
+    uint32_t headroom;
+} buffer_user_t;
+
+typedef struct _buffer_pg_t {
+    buffer_user_t user;
+    uint64_t      stats[BUFFER_PG_STAT_COUNT];
+} buffer_pg_t;
+
+static buffer_pool_t    buffer_pools[MAX_BUFFER_POOLS];
+static buffer_profile_t buffer_profiles[MAX_BUFFER_PROFILES];
+static buffer_pg_t      buffer_pgs[PORT_NUMBER][STUB_QOS_PRIORITY_GROUPS];
+static buffer_user_t    buffer_queues[PORT_NUMBER][STUB_QOS_QUEUES];
+/* Configuration and occupancy. The scheduler takes it inside its port
+ * lock for the frames it queues or sends; never take a port lock in here */
+static pthread_mutex_t  buffer_db_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Caller holds buffer_db_lock */
+static sai_status_t buffer_pool_db_index(_In_ sai_object_id_t pool_id, _Out_ uint32_t *index)
+{
+    sai_status_t status;
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(pool_id, SAI_OBJECT_TYPE_BUFFER_POOL, index))) {
+        return status;
+    }
+
+    if ((*index >= MAX_BUFFER_POOLS) || (!buffer_pools[*index].is_used)) {
+        STUB_LOG_ERR("Buffer pool %u does not exist\n", *index);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Caller holds buffer_db_lock */
+static sai_status_t buffer_profile_db_index(_In_ sai_object_id_t profile_id, _Out_ uint32_t *index)
+{
+    sai_status_t status;
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(profile_id, SAI_OBJECT_TYPE_BUFFER_PROFILE, index))) {
+        return status;
+    }
+
+    if ((*index >= MAX_BUFFER_PROFILES) || (!buffer_profiles[*index].is_used)) {
+        STUB_LOG_ERR("Buffer profile %u does not exist\n", *index);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t priority_group_db_index(_In_ sai_object_id_t pg_id, _Out_ uint32_t *port, _Out_ uint32_t *pg)
+{
+    sai_status_t status;
+    uint32_t     index;
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(pg_id, SAI_OBJECT_TYPE_PRIORITY_GROUP, &index))) {
+        return status;
+    }
+
+    if (index >= PORT_NUMBER * STUB_QOS_PRIORITY_GROUPS) {
+        STUB_LOG_ERR("Priority group %u does not exist\n", index);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    *port = index / STUB_QOS_PRIORITY_GROUPS;
+    *pg   = index % STUB_QOS_PRIORITY_GROUPS;
+    return SAI_STATUS_SUCCESS;
+}
+
+static void buffer_pool_key_to_str(_In_ sai_object_id_t pool_id, _Out_ char *key_str)
+{
+    uint32_t index;
+
+    if (SAI_STATUS_SUCCESS != stub_object_to_type(pool_id, SAI_OBJECT_TYPE_BUFFER_POOL, &index)) {
+        snprintf(key_str, MAX_KEY_STR_LEN, "invalid buffer pool id");
+    } else {
+        snprintf(key_str, MAX_KEY_STR_LEN, "buffer pool id %u", index);
+    }
+}
+
+static void buffer_profile_key_to_str(_In_ sai_object_id_t profile_id, _Out_ char *key_str)
+{
+    uint32_t index;
+
+    if (SAI_STATUS_SUCCESS != stub_object_to_type(profile_id, SAI_OBJECT_TYPE_BUFFER_PROFILE, &index)) {
+        snprintf(key_str, MAX_KEY_STR_LEN, "invalid buffer profile id");
+    } else {
+        snprintf(key_str, MAX_KEY_STR_LEN, "buffer profile id %u", index);
+    }
+}
+
+static void priority_group_key_to_str(_In_ sai_object_id_t pg_id, _Out_ char *key_str)
+{
+    uint32_t port, pg;
+
+    if (SAI_STATUS_SUCCESS != priority_group_db_index(pg_id, &port, &pg)) {
+        snprintf(key_str, MAX_KEY_STR_LEN, "invalid priority group id");
+    } else {
+        snprintf(key_str, MAX_KEY_STR_LEN, "priority group %u of port %u", pg, port);
+    }
+}
+
+/* Cells a profile sets aside in its pool, reserved and headroom */
+static inline uint32_t buffer_reserve(_In_ const buffer_profile_t *profile)
+{
+    return BUFFER_CELLS(profile->size) + BUFFER_CELLS(profile->xoff);
+}
+
+/* Cells of a user above its reserved ones */
+static inline uint32_t buffer_shared(_In_ const buffer_user_t *user, _In_ uint32_t reserved)
+{
+    return (user->cells > reserved) ? user->cells - reserved : 0;
+}
+
+static inline void buffer_pool_take(_Inout_ buffer_pool_t *pool, _In_ uint32_t cells)
+{
+    pool->used += cells;
+    if (pool->used > pool->watermark) {
+        pool->watermark = pool->used;
+    }
+}
+
+/* Take a user and what it holds out of the pool of its profile. Caller
+ * holds buffer_db_lock and attaches the user again right after */
+static void buffer_user_detach(_Inout_ buffer_user_t *user)
+{
+    const buffer_profile_t *profile;
+    buffer_pool_t          *pool;
+
+    if (BUFFER_NONE == user->profile) {
+        return;
+    }
+
+    profile = &buffer_profiles[user->profile];
+    pool    = &buffer_pools[profile->pool];
+
+    assert(pool->reserved >= buffer_reserve(profile));
+    pool->reserved -= buffer_reserve(profile);
+    pool->used     -= user->cells + user->headroom;
+    pool->shared   -= buffer_shared(user, BUFFER_CELLS(profile->size));
+}
+
+/* Put a user and what it holds into the pool of a profile, BUFFER_NONE for
+ * none. Priority groups need an ingress pool, queues an egress one, and
+ * the pool room for the reserved and headroom cells. The pool is left
+ * alone on failure. Caller holds buffer_db_lock */
+static sai_status_t buffer_user_attach(_Inout_ buffer_user_t *user, _In_ uint32_t index)
+{
+    const buffer_profile_t *profile;
+    buffer_pool_t          *pool;
+
+    if (BUFFER_NONE == index) {
+        user->profile = BUFFER_NONE;
+        user->xoff    = false;
+        return SAI_STATUS_SUCCESS;
+    }
+
+    profile = &buffer_profiles[index];
+    if (BUFFER_NONE == profile->pool) {
+        STUB_LOG_ERR("Buffer profile %u without a pool can't be bound\n", index);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    pool = &buffer_pools[profile->pool];
+    if ((user->ingress ? SAI_BUFFER_POOL_INGRESS : SAI_BUFFER_POOL_EGRESS) != pool->type) {
+        STUB_LOG_ERR("Buffer profile %u is of an %s pool\n", index, user->ingress ? "egress" : "ingress");
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    if (pool->reserved + buffer_reserve(profile) > pool->cells) {
+        STUB_LOG_ERR("Buffer pool %u can't set aside %u more cells, %u of %u are\n", profile->pool,
+                     buffer_reserve(profile), pool->reserved, pool->cells);
+        return SAI_STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    pool->reserved += buffer_reserve(profile);
+    pool->shared   += buffer_shared(user, BUFFER_CELLS(profile->size));
+    buffer_pool_take(pool, user->cells + user->headroom);
+
+    user->profile = index;
+    if (0 == profile->xoff) {
+        user->xoff = false;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Move a user to a profile, SAI_NULL_OBJECT_ID for none. What it holds
+ * moves along. Caller holds buffer_db_lock */
+static sai_status_t buffer_user_bind(_Inout_ buffer_user_t *user, _In_ sai_object_id_t profile_id)
+{
+    uint32_t     profile = BUFFER_NONE, old = user->profile;
+    sai_status_t status;
+
+    if ((SAI_NULL_OBJECT_ID != profile_id) &&
+        (SAI_STATUS_SUCCESS != buffer_profile_db_index(profile_id, &profile))) {
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    buffer_user_detach(user);
+    if (SAI_STATUS_SUCCESS != (status = buffer_user_attach(user, profile))) {
+        /* What the user left fits again */
+        buffer_user_attach(user, old);
+        return status;
+    }
+
+    if (BUFFER_NONE != profile) {
+        buffer_profiles[profile].ref_count++;
+    }
+    if (BUFFER_NONE != old) {
+        assert(buffer_profiles[old].ref_count > 0);
+        buffer_profiles[old].ref_count--;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Priority groups, then queues, binding a profile. Caller holds buffer_db_lock */
+static uint32_t buffer_profile_users(_In_ uint32_t profile, _Out_ buffer_user_t **users)
+{
+    uint32_t port, ii, count = 0;
+
+    for (port = 0; port < PORT_NUMBER; port++) {
+        for (ii = 0; ii < STUB_QOS_PRIORITY_GROUPS; ii++) {
+            if (profile == buffer_pgs[port][ii].user.profile) {
+                users[count++] = &buffer_pgs[port][ii].user;
+            }
+        }
+        for (ii = 0; ii < STUB_QOS_QUEUES; ii++) {
+            if (profile == buffer_queues[port][ii].profile) {
+                users[count++] = &buffer_queues[port][ii];
+            }
+        }
+    }
+
+    return count;
+}
+
+/* Shared cells a user of a profile may hold */
+static inline uint32_t buffer_shared_limit(_In_ const buffer_profile_t *profile, _In_ const buffer_pool_t *pool)
+{
+    uint32_t capacity = pool->cells - pool->reserved;
+    uint32_t free     = (pool->shared < capacity) ? capacity - pool->shared : 0;
+
+    if (SAI_BUFFER_THRESHOLD_MODE_STATIC == pool->mode) {
+        return profile->static_th / STUB_BUFFER_CELL_SIZE;
+    }
+
+    return (profile->dynamic_th >= 0) ? free << profile->dynamic_th : free >> -profile->dynamic_th;
+}
+
+/* Take cells for a frame: reserved, then shared, then headroom for a
+ * priority group, which then asserts XOFF. Caller holds buffer_db_lock */
+static bool buffer_user_take(_Inout_ buffer_user_t *user, _In_ uint32_t cells, _Inout_ bool *xoff)
+{
+    const buffer_profile_t *profile;
+    buffer_pool_t          *pool;
+    uint32_t                reserved, shared, need;
+
+    if (BUFFER_NONE == user->profile) {
+        user->cells += cells;
+        return true;
+    }
+
+    profile  = &buffer_profiles[user->profile];
+    pool     = &buffer_pools[profile->pool];
+    reserved = BUFFER_CELLS(profile->size);
+
+    if (user->cells + cells <= reserved) {
+        user->cells += cells;
+        buffer_pool_take(pool, cells);
+        return true;
+    }
+
+    /* shared cells the frame adds */
+    shared = buffer_shared(user, reserved);
+    need   = user->cells + cells - reserved - shared;
+    if ((shared + need <= buffer_shared_limit(profile, pool)) &&
+        (pool->shared + need <= pool->cells - pool->reserved)) {
+        user->cells  += cells;
+        pool->shared += need;
+        buffer_pool_take(pool, cells);
+        return true;
+    }
+
+    if (0 == profile->xoff) {
+        return false;
+    }
+
+    if (!user->xoff) {
+        user->xoff = true;
+        *xoff      = true;
+    }
+
+    if (user->headroom + cells > BUFFER_CELLS(profile->xoff)) {
+        return false;
+    }
+
+    user->headroom += cells;
+    buffer_pool_take(pool, cells);
+    return true;
+}
+
+/* Give back the cells of a frame, headroom first. Caller holds buffer_db_lock */
+static void buffer_user_give(_Inout_ buffer_user_t *user, _In_ uint32_t cells)
+{
+    const buffer_profile_t *profile;
+    buffer_pool_t          *pool;
+    uint32_t                headroom, reserved, shared;
+
+    headroom        = (cells < user->headroom) ? cells : user->headroom;
+    user->headroom -= headroom;
+    cells          -= headroom;
+    assert(cells <= user->cells);
+
+    if (BUFFER_NONE == user->profile) {
+        user->cells -= cells;
+        return;
+    }
+
+    profile  = &buffer_profiles[user->profile];
+    pool     = &buffer_pools[profile->pool];
+    reserved = BUFFER_CELLS(profile->size);
+    shared   = buffer_shared(user, reserved);
+
+    user->cells  -= cells;
+    pool->used   -= cells + headroom;
+    pool->shared -= shared - buffer_shared(user, reserved);
+
+    if (user->xoff && (BUFFER_BYTES(user->cells + user->headroom) <= profile->xon)) {
+        user->xoff = false;
+    }
+}
+
+void db_init_buffer(void)
+{
+    uint32_t port, ii;
+
+    pthread_mutex_lock(&buffer_db_lock);
+
+    memset(buffer_pools, 0, sizeof(buffer_pools));
+    memset(buffer_profiles, 0, sizeof(buffer_profiles));
+    memset(buffer_pgs, 0, sizeof(buffer_pgs));
+    memset(buffer_queues, 0, sizeof(buffer_queues));
+
+    for (port = 0; port < PORT_NUMBER; port++) {
+        for (ii = 0; ii < STUB_QOS_PRIORITY_GROUPS; ii++) {
+            buffer_pgs[port][ii].user.profile = BUFFER_NONE;
+            buffer_pgs[port][ii].user.ingress = true;
+        }
+        for (ii = 0; ii < STUB_QOS_QUEUES; ii++) {
+            buffer_queues[port][ii].profile = BUFFER_NONE;
+        }
+    }
+
+    pthread_mutex_unlock(&buffer_db_lock);
+}
+
+/*
+ * Routine Description:
+ *    Get the priority groups of a port
+ *
+ * Arguments:
+ *    [in] port - port index
+ *    [in] attr - SAI_PORT_ATTR_NUMBER_OF_PRIORITY_GROUPS or _PRIORITY_GROUP_LIST
+ *    [out] value - count or object list
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t db_get_port_buffer(_In_ uint32_t port, _In_ sai_attr_id_t attr, _Out_ sai_attribute_value_t *value)
+{
+    sai_object_id_t objects[STUB_QOS_PRIORITY_GROUPS];
+    sai_status_t    status;
+    uint32_t        ii;
+
+    assert(port < PORT_NUMBER);
+
+    if (SAI_PORT_ATTR_NUMBER_OF_PRIORITY_GROUPS == attr) {
+        value->u32 = STUB_QOS_PRIORITY_GROUPS;
+        return SAI_STATUS_SUCCESS;
+    }
+
+    for (ii = 0; ii < STUB_QOS_PRIORITY_GROUPS; ii++) {
+        if (SAI_STATUS_SUCCESS !=
+            (status = stub_create_object(SAI_OBJECT_TYPE_PRIORITY_GROUP, port * STUB_QOS_PRIORITY_GROUPS + ii,
+                                         &objects[ii]))) {
+            return status;
+        }
+    }
+
+    return stub_fill_objlist(objects, STUB_QOS_PRIORITY_GROUPS, &value->objlist);
+}
+
+/* Buffer profile of a queue, SAI_NULL_OBJECT_ID for none */
+sai_status_t db_get_queue_buffer(_In_ uint32_t port, _In_ uint32_t queue, _Out_ sai_object_id_t *profile_id)
+{
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    uint32_t     profile;
+
+    assert((port < PORT_NUMBER) && (queue < STUB_QOS_QUEUES));
+
+    pthread_mutex_lock(&buffer_db_lock);
+    profile = buffer_queues[port][queue].profile;
+    pthread_mutex_unlock(&buffer_db_lock);
+
+    *profile_id = SAI_NULL_OBJECT_ID;
+    if (BUFFER_NONE != profile) {
+        status = stub_create_object(SAI_OBJECT_TYPE_BUFFER_PROFILE, profile, profile_id);
+    }
+
+    return status;
+}
+
+/*
+ * Routine Description:
+ *    Bind a buffer profile to a queue, the frames it holds move along
+ *
+ * Arguments:
+ *    [in] port - port index
+ *    [in] queue - queue of the port
+ *    [in] profile_id - profile of an egress pool, SAI_NULL_OBJECT_ID for none
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    SAI_STATUS_INVALID_ATTR_VALUE_0 if the profile does not exist or is
+ *    not of an egress pool
+ *    SAI_STATUS_INSUFFICIENT_RESOURCES if its pool can't reserve the profile
+ */
+sai_status_t db_set_queue_buffer(_In_ uint32_t port, _In_ uint32_t queue, _In_ sai_object_id_t profile_id)
+{
+    sai_status_t status;
+
+    assert((port < PORT_NUMBER) && (queue < STUB_QOS_QUEUES));
+
+    pthread_mutex_lock(&buffer_db_lock);
+    status = buffer_user_bind(&buffer_queues[port][queue], profile_id);
+    pthread_mutex_unlock(&buffer_db_lock);
+
+    return status;
+}
+
+/* Lock the buffer for db_buffer_admit and db_buffer_release, inside a
+ * port lock of the scheduler */
+void db_buffer_lock(void)
+{
+    pthread_mutex_lock(&buffer_db_lock);
+}
+
+void db_buffer_unlock(void)
+{
+    pthread_mutex_unlock(&buffer_db_lock);
+}
+
+/*
+ * Routine Description:
+ *    Admit a frame into the buffer, charged to its ingress priority group
+ *    and its egress queue. Caller holds db_buffer_lock
+ *
+ * Arguments:
+ *    [in] in_port - ingress port index, STUB_BUFFER_NO_PORT for none
+ *    [in] priority_group - ingress priority group
+ *    [in] port - egress port index
+ *    [in] queue - egress queue
+ *    [in] length - frame length
+ *
+ * Return Values:
+ *    true if admitted, false if the priority group or the queue refuses it
+ */
+bool db_buffer_admit(_In_ uint32_t in_port,
+                     _In_ uint32_t priority_group,
+                     _In_ uint32_t port,
+                     _In_ uint32_t queue,
+                     _In_ uint32_t length)
+{
+    uint32_t       cells = BUFFER_CELLS(length);
+    buffer_pg_t   *pg    = NULL;
+    buffer_user_t *user;
+    uint64_t       bytes;
+    bool           xoff  = false, unused;
+
+    if (STUB_BUFFER_NO_PORT != in_port) {
+        pg   = &buffer_pgs[in_port][priority_group];
+        user = &pg->user;
+        if (!buffer_user_take(user, cells, &xoff)) {
+            pg->stats[BUFFER_PG_STAT(STUB_INGRESS_PRIORITY_GROUP_STAT_DROPPED_PACKETS)]++;
+            pg->stats[BUFFER_PG_STAT(STUB_INGRESS_PRIORITY_GROUP_STAT_DROPPED_BYTES)] += length;
+            pg->stats[BUFFER_PG_STAT(STUB_INGRESS_PRIORITY_GROUP_STAT_XOFF_COUNT)]    += xoff;
+            return false;
+        }
+        pg->stats[BUFFER_PG_STAT(STUB_INGRESS_PRIORITY_GROUP_STAT_XOFF_COUNT)] += xoff;
+    }
+
+    if (!buffer_user_take(&buffer_queues[port][queue], cells, &unused)) {
+        if (NULL != pg) {
+            buffer_user_give(&pg->user, cells);
+        }
+        return false;
+    }
+
+    if (NULL != pg) {
+        pg->stats[SAI_INGRESS_PRIORITY_GROUP_STAT_PACKETS]++;
+        pg->stats[SAI_INGRESS_PRIORITY_GROUP_STAT_BYTES] += length;
+
+        bytes = BUFFER_BYTES(pg->user.cells + pg->user.headroom);
+        if (bytes > pg->stats[SAI_INGRESS_PRIORITY_GROUP_STAT_WATERMARK_BYTES]) {
+            pg->stats[SAI_INGRESS_PRIORITY_GROUP_STAT_WATERMARK_BYTES] = bytes;
+        }
+        bytes = BUFFER_BYTES(pg->user.headroom);
+        if (bytes > pg->stats[BUFFER_PG_STAT(STUB_INGRESS_PRIORITY_GROUP_STAT_HEADROOM_WATERMARK_BYTES)]) {
+            pg->stats[BUFFER_PG_STAT(STUB_INGRESS_PRIORITY_GROUP_STAT_HEADROOM_WATERMARK_BYTES)] = bytes;
+        }
+    }
+
+    return true;
+}
+
+/* Give back the cells of a frame db_buffer_admit admitted, as the
+ * scheduler sends it. Caller holds db_buffer_lock */
+void db_buffer_release(_In_ uint32_t in_port,
+                       _In_ uint32_t priority_group,
+                       _In_ uint32_t port,
+                       _In_ uint32_t queue,
+                       _In_ uint32_t length)
+{
+    uint32_t cells = BUFFER_CELLS(length);
+
+    if (STUB_BUFFER_NO_PORT != in_port) {
+        buffer_user_give(&buffer_pgs[in_port][priority_group].user, cells);
+    }
+    buffer_user_give(&buffer_queues[port][queue], cells);
+}
+
+/*
+ * Routine Description:
+ *    @brief Get the priority groups of a port in XOFF, the pause a PFC
+ *    peer would be sending
+ *
+ * Arguments:
+ *    @param[in] port_id - port
+ *    @param[out] xoff - bit n set when priority group n is in XOFF
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_buffer_port_xoff(_In_ sai_object_id_t port_id, _Out_ uint8_t *xoff)
+{
+    sai_status_t status;
+    uint32_t     port, ii;
+
+    if (NULL == xoff) {
+        STUB_LOG_ERR("NULL xoff param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(port_id, SAI_OBJECT_TYPE_PORT, &port))) {
+        return status;
+    }
+
+    if (port >= PORT_NUMBER) {
+        STUB_LOG_ERR("Invalid port index %u\n", port);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    *xoff = 0;
+
+    pthread_mutex_lock(&buffer_db_lock);
+    for (ii = 0; ii < STUB_QOS_PRIORITY_GROUPS; ii++) {
+        if (buffer_pgs[port][ii].user.xoff) {
+            *xoff |= (uint8_t)(1 << ii);
+        }
+    }
+    pthread_mutex_unlock(&buffer_db_lock);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Pool sizes [uint32_t] of a type add up to at most STUB_BUFFER_SIZE,
+ * a pool holding at least one cell. Caller holds buffer_db_lock */
+static sai_status_t buffer_pool_check_size(_In_ uint32_t pool, _In_ sai_int32_t type, _In_ uint32_t size)
+{
+    uint64_t total = size;
+    uint32_t ii;
+
+    if (size < STUB_BUFFER_CELL_SIZE) {
+        STUB_LOG_ERR("Buffer pool size %u below a cell of %u\n", size, STUB_BUFFER_CELL_SIZE);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    for (ii = 0; ii < MAX_BUFFER_POOLS; ii++) {
+        if ((ii != pool) && buffer_pools[ii].is_used && (type == buffer_pools[ii].type)) {
+            total += buffer_pools[ii].size;
+        }
+    }
+
+    if (total > STUB_BUFFER_SIZE) {
+        STUB_LOG_ERR("Buffer pools of type %d would take %lu bytes of %u\n", type, (unsigned long)total,
+                     STUB_BUFFER_SIZE);
+        return SAI_STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Create buffer pool
+ *
+ * Arguments:
+ *    [out] pool_id - buffer pool id
+ *    [in] attr_count - number of attributes
+ *    [in] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_create_buffer_pool(_Out_ sai_object_id_t     *pool_id,
+                                     _In_ uint32_t               attr_count,
+                                     _In_ const sai_attribute_t *attr_list)
+{
+    const sai_attribute_value_t *type, *size, *mode;
+    uint32_t                     type_index, size_index, mode_index, pool, count = 0;
+    sai_status_t                 status;
+    char                         list_str[MAX_LIST_VALUE_STR_LEN];
+    char                         key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    if (NULL == pool_id) {
+        STUB_LOG_ERR("NULL buffer pool id param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS !=
+        (status =
+             check_attribs_metadata(attr_count, attr_list, buffer_pool_attribs, buffer_pool_vendor_attribs,
+                                    SAI_OPERATION_CREATE))) {
+        STUB_LOG_ERR("Failed attribs check\n");
+        return status;
+    }
+
+    sai_attr_list_to_str(attr_count, attr_list, buffer_pool_attribs, MAX_LIST_VALUE_STR_LEN, list_str);
+    STUB_LOG_NTC("Create buffer pool, %s\n", list_str);
+
+    status = find_attrib_in_list(attr_count, attr_list, SAI_BUFFER_POOL_ATTR_TYPE, &type, &type_index);
+    assert(SAI_STATUS_SUCCESS == status);
+    status = find_attrib_in_list(attr_count, attr_list, SAI_BUFFER_POOL_ATTR_SIZE, &size, &size_index);
+    assert(SAI_STATUS_SUCCESS == status);
+
+    if ((SAI_BUFFER_POOL_INGRESS != type->s32) && (SAI_BUFFER_POOL_EGRESS != type->s32)) {
+        STUB_LOG_ERR("Invalid buffer pool type %d\n", type->s32);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + type_index;
+    }
+
+    if ((SAI_STATUS_SUCCESS ==
+         find_attrib_in_list(attr_count, attr_list, SAI_BUFFER_POOL_ATTR_TH_MODE, &mode, &mode_index)) &&
+        (SAI_BUFFER_THRESHOLD_MODE_STATIC != mode->s32) && (SAI_BUFFER_THRESHOLD_MODE_DYNAMIC != mode->s32)) {
+        STUB_LOG_ERR("Invalid buffer pool threshold mode %d\n", mode->s32);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + mode_index;
+    }
+
+    pthread_mutex_lock(&buffer_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = buffer_pool_check_size(BUFFER_NONE, type->s32, size->u32))) {
+        pthread_mutex_unlock(&buffer_db_lock);
+        return (SAI_STATUS_INVALID_ATTR_VALUE_0 == status) ? SAI_STATUS_INVALID_ATTR_VALUE_0 + size_index : status;
+    }
+
+    for (pool = 0; pool < MAX_BUFFER_POOLS; pool++) {
+        if (buffer_pools[pool].is_used && (type->s32 == buffer_pools[pool].type)) {
+            count++;
+        }
+    }
+
+    if (count < STUB_BUFFER_POOLS) {
+        for (pool = 0; pool < MAX_BUFFER_POOLS; pool++) {
+            if (!buffer_pools[pool].is_used) {
+                break;
+            }
+        }
+    }
+
+    if ((STUB_BUFFER_POOLS == count) || (MAX_BUFFER_POOLS == pool)) {
+        pthread_mutex_unlock(&buffer_db_lock);
+        STUB_LOG_ERR("Buffer pools of type %d full\n", type->s32);
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    memset(&buffer_pools[pool], 0, sizeof(buffer_pools[pool]));
+    buffer_pools[pool].is_used = true;
+    buffer_pools[pool].type    = type->s32;
+    buffer_pools[pool].size    = size->u32;
+    buffer_pools[pool].cells   = size->u32 / STUB_BUFFER_CELL_SIZE;
+    buffer_pools[pool].mode    = SAI_BUFFER_THRESHOLD_MODE_DYNAMIC;
+    if (SAI_STATUS_SUCCESS ==
+        find_attrib_in_list(attr_count, attr_list, SAI_BUFFER_POOL_ATTR_TH_MODE, &mode, &mode_index)) {
+        buffer_pools[pool].mode = mode->s32;
+    }
+
+    pthread_mutex_unlock(&buffer_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_BUFFER_POOL, pool, pool_id))) {
+        return status;
+    }
+    buffer_pool_key_to_str(*pool_id, key_str);
+    STUB_LOG_NTC("Created %s\n", key_str);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Remove buffer pool
+ *
+ * Arguments:
+ *    [in] pool_id - buffer pool id
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_remove_buffer_pool(_In_ sai_object_id_t pool_id)
+{
+    char         key_str[MAX_KEY_STR_LEN];
+    sai_status_t status;
+    uint32_t     pool;
+
+    STUB_LOG_ENTER();
+
+    buffer_pool_key_to_str(pool_id, key_str);
+    STUB_LOG_NTC("Remove %s\n", key_str);
+
+    pthread_mutex_lock(&buffer_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = buffer_pool_db_index(pool_id, &pool))) {
+        pthread_mutex_unlock(&buffer_db_lock);
+        return status;
+    }
+
+    if (0 != buffer_pools[pool].ref_count) {
+        pthread_mutex_unlock(&buffer_db_lock);
+        STUB_LOG_ERR("Buffer pool %u is used by %u profiles\n", pool, buffer_pools[pool].ref_count);
+        return SAI_STATUS_OBJECT_IN_USE;
+    }
+
+    buffer_pools[pool].is_used = false;
+
+    pthread_mutex_unlock(&buffer_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Set buffer pool attribute
+ *
+ * Arguments:
+ *    [in] pool_id - buffer pool id
+ *    [in] attr - attribute
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_set_buffer_pool_attr(_In_ sai_object_id_t pool_id, _In_ const sai_attribute_t *attr)
+{
+    const sai_object_key_t key = { .object_id = pool_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    buffer_pool_key_to_str(pool_id, key_str);
+    return sai_set_attribute(&key, key_str, buffer_pool_attribs, buffer_pool_vendor_attribs, attr);
+}
+
+/*
+ * Routine Description:
+ *    Get buffer pool attributes
+ *
+ * Arguments:
+ *    [in] pool_id - buffer pool id
+ *    [in] attr_count - number of attributes
+ *    [inout] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_buffer_pool_attr(_In_ sai_object_id_t     pool_id,
+                                       _In_ uint32_t            attr_count,
+                                       _Inout_ sai_attribute_t *attr_list)
+{
+    const sai_object_key_t key = { .object_id = pool_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
+
+    STUB_LOG_ENTER();
+
+    buffer_pool_key_to_str(pool_id, key_str);
+
+    pthread_mutex_lock(&buffer_db_lock);
+    status = sai_get_attributes(&key, key_str, buffer_pool_attribs, buffer_pool_vendor_attribs, attr_count,
+                                attr_list);
+    pthread_mutex_unlock(&buffer_db_lock);
+
+    return status;
+}
+
+/* Shared size and size [uint32_t], type [sai_buffer_pool_type_t],
+ * threshold mode [sai_buffer_threshold_mode_t] */
+sai_status_t stub_buffer_pool_attr_get(_In_ const sai_object_key_t   *key,
+                                       _Inout_ sai_attribute_value_t *value,
+                                       _In_ uint32_t                  attr_index,
+                                       _Inout_ vendor_cache_t        *cache,
+                                       void                          *arg)
+{
+    const buffer_pool_t *pool;
+    sai_status_t         status;
+    uint32_t             index;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = buffer_pool_db_index(key->object_id, &index))) {
+        return status;
+    }
+
+    pool = &buffer_pools[index];
+
+    switch ((long)arg) {
+    case SAI_BUFFER_POOL_ATTR_SHARED_SIZE:
+        value->u32 = (uint32_t)BUFFER_BYTES(pool->cells - pool->reserved);
+        break;
+
+    case SAI_BUFFER_POOL_ATTR_TYPE:
+        value->s32 = pool->type;
+        break;
+
+    case SAI_BUFFER_POOL_ATTR_SIZE:
+        value->u32 = pool->size;
+        break;
+
+    case SAI_BUFFER_POOL_ATTR_TH_MODE:
+        value->s32 = pool->mode;
+        break;
+    }
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Size [uint32_t], not below what the profiles of the pool set aside */
+sai_status_t stub_buffer_pool_size_set(_In_ const sai_object_key_t      *key,
+                                       _In_ const sai_attribute_value_t *value,
+                                       void                             *arg)
+{
+    buffer_pool_t *pool;
+    sai_status_t   status;
+    uint32_t       index;
+
+    STUB_LOG_ENTER();
+
+    pthread_mutex_lock(&buffer_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = buffer_pool_db_index(key->object_id, &index))) {
+        pthread_mutex_unlock(&buffer_db_lock);
+        return status;
+    }
+
+    pool = &buffer_pools[index];
+
+    if (SAI_STATUS_SUCCESS != (status = buffer_pool_check_size(index, pool->type, value->u32))) {
+        pthread_mutex_unlock(&buffer_db_lock);
+        return status;
+    }
+
+    if (value->u32 / STUB_BUFFER_CELL_SIZE < pool->reserved) {
+        pthread_mutex_unlock(&buffer_db_lock);
+        STUB_LOG_ERR("Buffer pool %u size %u below the %u cells its profiles set aside\n", index, value->u32,
+                     pool->reserved);
+        return SAI_STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    pool->size  = value->u32;
+    pool->cells = value->u32 / STUB_BUFFER_CELL_SIZE;
+
+    pthread_mutex_unlock(&buffer_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Get buffer pool statistics counters
+ *
+ * Arguments:
+ *    [in] pool_id - buffer pool id
+ *    [in] counter_ids - specifies the array of counter ids
+ *    [in] number_of_counters - number of counters in the array
+ *    [out] counters - array of resulting counter values
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_buffer_pool_stats(_In_ sai_object_id_t                       pool_id,
+                                        _In_ const sai_buffer_pool_stat_counter_t *counter_ids,
+                                        _In_ uint32_t                              number_of_counters,
+                                        _Out_ uint64_t                            *counters)
+{
+    sai_status_t status;
+    uint32_t     pool, ii;
+    char         key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    buffer_pool_key_to_str(pool_id, key_str);
+    STUB_LOG_DBG("Get buffer pool stats %s\n", key_str);
+
+    if ((NULL == counter_ids) || (NULL == counters)) {
+        STUB_LOG_ERR("NULL counter ids or counters array param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    for (ii = 0; ii < number_of_counters; ii++) {
+        if ((SAI_BUFFER_POOL_STAT_CURR_OCCUPANCY_BYTES != counter_ids[ii]) &&
+            (SAI_BUFFER_POOL_STAT_WATERMARK_BYTES != counter_ids[ii])) {
+            STUB_LOG_ERR("Invalid buffer pool counter %d\n", counter_ids[ii]);
+            return SAI_STATUS_INVALID_PARAMETER;
+        }
+    }
+
+    pthread_mutex_lock(&buffer_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = buffer_pool_db_index(pool_id, &pool))) {
+        pthread_mutex_unlock(&buffer_db_lock);
+        return status;
+    }
+
+    for (ii = 0; ii < number_of_counters; ii++) {
+        counters[ii] = BUFFER_BYTES((SAI_BUFFER_POOL_STAT_CURR_OCCUPANCY_BYTES == counter_ids[ii]) ?
+                                    buffer_pools[pool].used : buffer_pools[pool].watermark);
+    }
+
+    pthread_mutex_unlock(&buffer_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Set ingress priority group attribute
+ *
+ * Arguments:
+ *    [in] ingress_pg_id - ingress priority group id
+ *    [in] attr - attribute
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_set_ingress_priority_group_attr(_In_ sai_object_id_t ingress_pg_id, _In_ const sai_attribute_t *attr)
+{
+    const sai_object_key_t key = { .object_id = ingress_pg_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    priority_group_key_to_str(ingress_pg_id, key_str);
+    return sai_set_attribute(&key, key_str, priority_group_attribs, priority_group_vendor_attribs, attr);
+}
+
+/*
+ * Routine Description:
+ *    Get ingress priority group attributes
+ *
+ * Arguments:
+ *    [in] ingress_pg_id - ingress priority group id
+ *    [in] attr_count - number of attributes
+ *    [inout] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_ingress_priority_group_attr(_In_ sai_object_id_t     ingress_pg_id,
+                                                  _In_ uint32_t            attr_count,
+                                                  _Inout_ sai_attribute_t *attr_list)
+{
+    const sai_object_key_t key = { .object_id = ingress_pg_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
+
+    STUB_LOG_ENTER();
+
+    priority_group_key_to_str(ingress_pg_id, key_str);
+
+    pthread_mutex_lock(&buffer_db_lock);
+    status = sai_get_attributes(&key, key_str, priority_group_attribs, priority_group_vendor_attribs, attr_count,
+                                attr_list);
+    pthread_mutex_unlock(&buffer_db_lock);
+
+    return status;
+}
+
+/* Buffer profile [sai_object_id_t], SAI_NULL_OBJECT_ID for none */
+sai_status_t stub_priority_group_profile_get(_In_ const sai_object_key_t   *key,
+                                             _Inout_ sai_attribute_value_t *value,
+                                             _In_ uint32_t                  attr_index,
+                                             _Inout_ vendor_cache_t        *cache,
+                                             void                          *arg)
+{
+    sai_status_t status;
+    uint32_t     port, pg;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = priority_group_db_index(key->object_id, &port, &pg))) {
+        return status;
+    }
+
+    value->oid = SAI_NULL_OBJECT_ID;
+    if (BUFFER_NONE != buffer_pgs[port][pg].user.profile) {
+        status = stub_create_object(SAI_OBJECT_TYPE_BUFFER_PROFILE, buffer_pgs[port][pg].user.profile, &value->oid);
+    }
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* Buffer profile of an ingress pool [sai_object_id_t], SAI_NULL_OBJECT_ID
+ * for none. The frames the group holds move along */
+sai_status_t stub_priority_group_profile_set(_In_ const sai_object_key_t      *key,
+                                             _In_ const sai_attribute_value_t *value,
+                                             void                             *arg)
+{
+    sai_status_t status;
+    uint32_t     port, pg;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = priority_group_db_index(key->object_id, &port, &pg))) {
+        return status;
+    }
+
+    pthread_mutex_lock(&buffer_db_lock);
+    status = buffer_user_bind(&buffer_pgs[port][pg].user, value->oid);
+    pthread_mutex_unlock(&buffer_db_lock);
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+static sai_status_t priority_group_check_counters(_In_ const sai_ingress_priority_group_stat_counter_t *counter_ids,
+                                                  _In_ uint32_t number_of_counters)
+{
+    uint32_t ii;
+
+    if (NULL == counter_ids) {
+        STUB_LOG_ERR("NULL counter ids array param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    for (ii = 0; ii < number_of_counters; ii++) {
+        if ((counter_ids[ii] < SAI_INGRESS_PRIORITY_GROUP_STAT_PACKETS) ||
+            (BUFFER_PG_STAT(counter_ids[ii]) >= BUFFER_PG_STAT_COUNT) ||
+            ((counter_ids[ii] >= BUFFER_PG_SAI_STATS) &&
+             (counter_ids[ii] < SAI_INGRESS_PRIORITY_GROUP_STAT_CUSTOM_RANGE_BASE))) {
+            STUB_LOG_ERR("Invalid priority group counter %d\n", counter_ids[ii]);
+            return SAI_STATUS_INVALID_PARAMETER;
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Get ingress priority group statistics counters
+ *
+ * Arguments:
+ *    [in] ingress_pg_id - ingress priority group id
+ *    [in] counter_ids - specifies the array of counter ids
+ *    [in] number_of_counters - number of counters in the array
+ *    [out] counters - array of resulting counter values
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_ingress_priority_group_stats(
+    _In_ sai_object_id_t                                  ingress_pg_id,
+    _In_ const sai_ingress_priority_group_stat_counter_t *counter_ids,
+    _In_ uint32_t                                         number_of_counters,
+    _Out_ uint64_t                                       *counters)
+{
+    const buffer_pg_t *pg;
+    sai_status_t       status;
+    uint32_t           port, index, ii;
+    char               key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    priority_group_key_to_str(ingress_pg_id, key_str);
+    STUB_LOG_DBG("Get priority group stats %s\n", key_str);
+
+    if (NULL == counters) {
+        STUB_LOG_ERR("NULL counters array param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS != (status = priority_group_check_counters(counter_ids, number_of_counters))) {
+        return status;
+    }
+
+    if (SAI_STATUS_SUCCESS != (status = priority_group_db_index(ingress_pg_id, &port, &index))) {
+        return status;
+    }
+
+    pg = &buffer_pgs[port][index];
+
+    pthread_mutex_lock(&buffer_db_lock);
+    for (ii = 0; ii < number_of_counters; ii++) {
+        switch ((long)counter_ids[ii]) {
+        case SAI_INGRESS_PRIORITY_GROUP_STAT_CURR_OCCUPANCY_BYTES:
+            counters[ii] = BUFFER_BYTES(pg->user.cells + pg->user.headroom);
+            break;
+
+        case STUB_INGRESS_PRIORITY_GROUP_STAT_HEADROOM_OCCUPANCY_BYTES:
+            counters[ii] = BUFFER_BYTES(pg->user.headroom);
+            break;
+
+        default:
+            counters[ii] = pg->stats[BUFFER_PG_STAT(counter_ids[ii])];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&buffer_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Clear ingress priority group statistics counters. Watermarks restart
+ *    from the current occupancy, occupancies stay
+ *
+ * Arguments:
+ *    [in] ingress_pg_id - ingress priority group id
+ *    [in] counter_ids - specifies the array of counter ids
+ *    [in] number_of_counters - number of counters in the array
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_clear_ingress_priority_group_stats(
+    _In_ sai_object_id_t                                  ingress_pg_id,
+    _In_ const sai_ingress_priority_group_stat_counter_t *counter_ids,
+    _In_ uint32_t                                         number_of_counters)
+{
+    buffer_pg_t *pg;
+    sai_status_t status;
+    uint32_t     port, index, ii;
+    char         key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    priority_group_key_to_str(ingress_pg_id, key_str);
+    STUB_LOG_NTC("Clear priority group stats %s\n", key_str);
+
+    if (SAI_STATUS_SUCCESS != (status = priority_group_check_counters(counter_ids, number_of_counters))) {
+        return status;
+    }
+
+    if (SAI_STATUS_SUCCESS != (status = priority_group_db_index(ingress_pg_id, &port, &index))) {
+        return status;
+    }
+
+    pg = &buffer_pgs[port][index];
+
+    pthread_mutex_lock(&buffer_db_lock);
+    for (ii = 0; ii < number_of_counters; ii++) {
+        switch ((long)counter_ids[ii]) {
+        case SAI_INGRESS_PRIORITY_GROUP_STAT_WATERMARK_BYTES:
+            pg->stats[BUFFER_PG_STAT(counter_ids[ii])] = BUFFER_BYTES(pg->user.cells + pg->user.headroom);
+            break;
+
+        case STUB_INGRESS_PRIORITY_GROUP_STAT_HEADROOM_WATERMARK_BYTES:
+            pg->stats[BUFFER_PG_STAT(counter_ids[ii])] = BUFFER_BYTES(pg->user.headroom);
+            break;
+
+        default:
+            pg->stats[BUFFER_PG_STAT(counter_ids[ii])] = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&buffer_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Sizes and thresholds [uint32_t] up to STUB_BUFFER_SIZE, dynamic
+ * threshold [sai_int8_t] in STUB_BUFFER_MIN_DYNAMIC_TH to _MAX_ */
+static sai_status_t buffer_profile_check_value(_In_ sai_attr_id_t attr, _In_ const sai_attribute_value_t *value)
+{
+    switch (attr) {
+    case SAI_BUFFER_PROFILE_ATTR_POOL_ID:
+        break;
+
+    case SAI_BUFFER_PROFILE_ATTR_SHARED_DYNAMIC_TH:
+        if ((value->s8 < STUB_BUFFER_MIN_DYNAMIC_TH) || (value->s8 > STUB_BUFFER_MAX_DYNAMIC_TH)) {
+            STUB_LOG_ERR("Buffer dynamic threshold %d out of range %d to %d\n", value->s8,
+                         STUB_BUFFER_MIN_DYNAMIC_TH, STUB_BUFFER_MAX_DYNAMIC_TH);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        break;
+
+    default:
+        if (value->u32 > STUB_BUFFER_SIZE) {
+            STUB_LOG_ERR("Buffer profile size or threshold %u above %u\n", value->u32, STUB_BUFFER_SIZE);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        break;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Caller holds buffer_db_lock, the pool is checked already */
+static void buffer_profile_apply(_Inout_ buffer_profile_t        *profile,
+                                 _In_ sai_attr_id_t               attr,
+                                 _In_ const sai_attribute_value_t *value,
+                                 _In_ uint32_t                    pool)
+{
+    switch (attr) {
+    case SAI_BUFFER_PROFILE_ATTR_POOL_ID:
+        profile->pool = pool;
+        break;
+
+    case SAI_BUFFER_PROFILE_ATTR_BUFFER_SIZE:
+        profile->size = value->u32;
+        break;
+
+    case SAI_BUFFER_PROFILE_ATTR_SHARED_DYNAMIC_TH:
+        profile->has_dynamic_th = true;
+        profile->dynamic_th     = value->s8;
+        break;
+
+    case SAI_BUFFER_PROFILE_ATTR_SHARED_STATIC_TH:
+        profile->has_static_th = true;
+        profile->static_th     = value->u32;
+        break;
+
+    case SAI_BUFFER_PROFILE_ATTR_XOFF_TH:
+        profile->xoff = value->u32;
+        break;
+
+    case SAI_BUFFER_PROFILE_ATTR_XON_TH:
+        profile->xon = value->u32;
+        break;
+    }
+}
+
+/* The threshold of the pool mode is mandatory, XOFF and XON apply to
+ * ingress pools only. Returns the attribute at fault in attr. Caller holds
+ * buffer_db_lock */
+static sai_status_t buffer_profile_check(_In_ const buffer_profile_t *profile, _Out_ sai_attr_id_t *attr)
+{
+    const buffer_pool_t *pool;
+
+    if (BUFFER_NONE == profile->pool) {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    pool = &buffer_pools[profile->pool];
+
+    if ((SAI_BUFFER_THRESHOLD_MODE_DYNAMIC == pool->mode) && (!profile->has_dynamic_th)) {
+        *attr = SAI_BUFFER_PROFILE_ATTR_SHARED_DYNAMIC_TH;
+        STUB_LOG_ERR("Buffer profile of a dynamic pool without a dynamic threshold\n");
+        return SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING;
+    }
+
+    if ((SAI_BUFFER_THRESHOLD_MODE_STATIC == pool->mode) && (!profile->has_static_th)) {
+        *attr = SAI_BUFFER_PROFILE_ATTR_SHARED_STATIC_TH;
+        STUB_LOG_ERR("Buffer profile of a static pool without a static threshold\n");
+        return SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING;
+    }
+
+    if ((SAI_BUFFER_POOL_EGRESS == pool->type) && ((0 != profile->xoff) || (0 != profile->xon))) {
+        *attr = (0 != profile->xoff) ? SAI_BUFFER_PROFILE_ATTR_XOFF_TH : SAI_BUFFER_PROFILE_ATTR_XON_TH;
+        STUB_LOG_ERR("Buffer profile of an egress pool with XOFF or XON threshold\n");
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Pool index of a pool id, BUFFER_NONE for SAI_NULL_OBJECT_ID. Caller
+ * holds buffer_db_lock */
+static sai_status_t buffer_profile_pool(_In_ sai_object_id_t pool_id, _Out_ uint32_t *pool)
+{
+    *pool = BUFFER_NONE;
+    if (SAI_NULL_OBJECT_ID == pool_id) {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    return buffer_pool_db_index(pool_id, pool);
+}
+
+/*
+ * Routine Description:
+ *    Create buffer profile
+ *
+ * Arguments:
+ *    [out] buffer_profile_id - buffer profile id
+ *    [in] attr_count - number of attributes
+ *    [in] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_create_buffer_profile(_Out_ sai_object_id_t     *buffer_profile_id,
+                                        _In_ uint32_t               attr_count,
+                                        _In_ const sai_attribute_t *attr_list)
+{
+    const sai_attribute_value_t *value;
+    buffer_profile_t             params;
+    sai_attr_id_t                attr, fault;
+    uint32_t                     index, pool = BUFFER_NONE, profile;
+    sai_status_t                 status;
+    char                         list_str[MAX_LIST_VALUE_STR_LEN];
+    char                         key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    if (NULL == buffer_profile_id) {
+        STUB_LOG_ERR("NULL buffer profile id param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS !=
+        (status =
+             check_attribs_metadata(attr_count, attr_list, buffer_profile_attribs, buffer_profile_vendor_attribs,
+                                    SAI_OPERATION_CREATE))) {
+        STUB_LOG_ERR("Failed attribs check\n");
+        return status;
+    }
+
+    sai_attr_list_to_str(attr_count, attr_list, buffer_profile_attribs, MAX_LIST_VALUE_STR_LEN, list_str);
+    STUB_LOG_NTC("Create buffer profile, %s\n", list_str);
+
+    memset(&params, 0, sizeof(params));
+
+    pthread_mutex_lock(&buffer_db_lock);
+
+    for (attr = SAI_BUFFER_PROFILE_ATTR_POOL_ID; attr <= SAI_BUFFER_PROFILE_ATTR_XON_TH; attr++) {
+        if (SAI_STATUS_SUCCESS != find_attrib_in_list(attr_count, attr_list, attr, &value, &index)) {
+            continue;
+        }
+        if ((SAI_STATUS_SUCCESS != buffer_profile_check_value(attr, value)) ||
+            ((SAI_BUFFER_PROFILE_ATTR_POOL_ID == attr) &&
+             (SAI_STATUS_SUCCESS != buffer_profile_pool(value->oid, &pool)))) {
+            pthread_mutex_unlock(&buffer_db_lock);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + index;
+        }
+        buffer_profile_apply(&params, attr, value, pool);
+    }
+
+    if (SAI_STATUS_SUCCESS != (status = buffer_profile_check(&params, &fault))) {
+        pthread_mutex_unlock(&buffer_db_lock);
+        if ((SAI_STATUS_INVALID_ATTR_VALUE_0 == status) &&
+            (SAI_STATUS_SUCCESS == find_attrib_in_list(attr_count, attr_list, fault, &value, &index))) {
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + index;
+        }
+        return status;
+    }
+
+    for (profile = 0; profile < MAX_BUFFER_PROFILES; profile++) {
+        if (!buffer_profiles[profile].is_used) {
+            break;
+        }
+    }
+
+    if (MAX_BUFFER_PROFILES == profile) {
+        pthread_mutex_unlock(&buffer_db_lock);
+        STUB_LOG_ERR("Buffer profile table full\n");
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    params.is_used           = true;
+    buffer_profiles[profile] = params;
+    if (BUFFER_NONE != params.pool) {
+        buffer_pools[params.pool].ref_count++;
+    }
+
+    pthread_mutex_unlock(&buffer_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_BUFFER_PROFILE, profile,
+                                                           buffer_profile_id))) {
+        return status;
+    }
+    buffer_profile_key_to_str(*buffer_profile_id, key_str);
+    STUB_LOG_NTC("Created %s\n", key_str);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Remove buffer profile
+ *
+ * Arguments:
+ *    [in] buffer_profile_id - buffer profile id
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_remove_buffer_profile(_In_ sai_object_id_t buffer_profile_id)
+{
+    char         key_str[MAX_KEY_STR_LEN];
+    sai_status_t status;
+    uint32_t     profile;
+
+    STUB_LOG_ENTER();
+
+    buffer_profile_key_to_str(buffer_profile_id, key_str);
+    STUB_LOG_NTC("Remove %s\n", key_str);
+
+    pthread_mutex_lock(&buffer_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = buffer_profile_db_index(buffer_profile_id, &profile))) {
+        pthread_mutex_unlock(&buffer_db_lock);
+        return status;
+    }
+
+    if (0 != buffer_profiles[profile].ref_count) {
+        pthread_mutex_unlock(&buffer_db_lock);
+        STUB_LOG_ERR("Buffer profile %u is bound to %u priority groups and queues\n", profile,
+                     buffer_profiles[profile].ref_count);
+        return SAI_STATUS_OBJECT_IN_USE;
+    }
+
+    if (BUFFER_NONE != buffer_profiles[profile].pool) {
+        assert(buffer_pools[buffer_profiles[profile].pool].ref_count > 0);
+        buffer_pools[buffer_profiles[profile].pool].ref_count--;
+    }
+    buffer_profiles[profile].is_used = false;
+
+    pthread_mutex_unlock(&buffer_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Set buffer profile attribute
+ *
+ * Arguments:
+ *    [in] buffer_profile_id - buffer profile id
+ *    [in] attr - attribute
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_set_buffer_profile_attr(_In_ sai_object_id_t buffer_profile_id, _In_ const sai_attribute_t *attr)
+{
+    const sai_object_key_t key = { .object_id = buffer_profile_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    buffer_profile_key_to_str(buffer_profile_id, key_str);
+    return sai_set_attribute(&key, key_str, buffer_profile_attribs, buffer_profile_vendor_attribs, attr);
+}
+
+/*
+ * Routine Description:
+ *    Get buffer profile attributes
+ *
+ * Arguments:
+ *    [in] buffer_profile_id - buffer profile id
+ *    [in] attr_count - number of attributes
+ *    [inout] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_buffer_profile_attr(_In_ sai_object_id_t     buffer_profile_id,
+                                          _In_ uint32_t            attr_count,
+                                          _Inout_ sai_attribute_t *attr_list)
+{
+    const sai_object_key_t key = { .object_id = buffer_profile_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
+
+    STUB_LOG_ENTER();
+
+    buffer_profile_key_to_str(buffer_profile_id, key_str);
+
+    pthread_mutex_lock(&buffer_db_lock);
+    status = sai_get_attributes(&key, key_str, buffer_profile_attribs, buffer_profile_vendor_attribs, attr_count,
+                                attr_list);
+    pthread_mutex_unlock(&buffer_db_lock);
+
+    return status;
+}
+
+/* Pool [sai_object_id_t], sizes and thresholds [uint32_t], dynamic
+ * threshold [sai_int8_t], 0 for thresholds never set */
+sai_status_t stub_buffer_profile_attr_get(_In_ const sai_object_key_t   *key,
+                                          _Inout_ sai_attribute_value_t *value,
+                                          _In_ uint32_t                  attr_index,
+                                          _Inout_ vendor_cache_t        *cache,
+                                          void                          *arg)
+{
+    const buffer_profile_t *profile;
+    sai_status_t            status;
+    uint32_t                index;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = buffer_profile_db_index(key->object_id, &index))) {
+        return status;
+    }
+
+    profile = &buffer_profiles[index];
+
+    switch ((long)arg) {
+    case SAI_BUFFER_PROFILE_ATTR_POOL_ID:
+        value->oid = SAI_NULL_OBJECT_ID;
+        if (BUFFER_NONE != profile->pool) {
+            status = stub_create_object(SAI_OBJECT_TYPE_BUFFER_POOL, profile->pool, &value->oid);
+        }
+        break;
+
+    case SAI_BUFFER_PROFILE_ATTR_BUFFER_SIZE:
+        value->u32 = profile->size;
+        break;
+
+    case SAI_BUFFER_PROFILE_ATTR_SHARED_DYNAMIC_TH:
+        value->s8 = profile->dynamic_th;
+        break;
+
+    case SAI_BUFFER_PROFILE_ATTR_SHARED_STATIC_TH:
+        value->u32 = profile->static_th;
+        break;
+
+    case SAI_BUFFER_PROFILE_ATTR_XOFF_TH:
+        value->u32 = profile->xoff;
+        break;
+
+    case SAI_BUFFER_PROFILE_ATTR_XON_TH:
+        value->u32 = profile->xon;
+        break;
+    }
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* Pool [sai_object_id_t], sizes and thresholds [uint32_t], dynamic
+ * threshold [sai_int8_t]. The priority groups and queues binding the
+ * profile move to the new values with what they hold; the set fails and
+ * changes nothing if a pool can't set aside what they then take */
+sai_status_t stub_buffer_profile_attr_set(_In_ const sai_object_key_t      *key,
+                                          _In_ const sai_attribute_value_t *value,
+                                          void                             *arg)
+{
+    buffer_user_t   *users[PORT_NUMBER * (STUB_QOS_PRIORITY_GROUPS + STUB_QOS_QUEUES)];
+    buffer_profile_t params, old;
+    sai_attr_id_t    fault;
+    sai_status_t     status;
+    uint32_t         index, pool = BUFFER_NONE, count, ii, jj;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = buffer_profile_check_value((long)arg, value))) {
+        return status;
+    }
+
+    pthread_mutex_lock(&buffer_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = buffer_profile_db_index(key->object_id, &index))) {
+        pthread_mutex_unlock(&buffer_db_lock);
+        return status;
+    }
+
+    if ((SAI_BUFFER_PROFILE_ATTR_POOL_ID == (long)arg) &&
+        (SAI_STATUS_SUCCESS != buffer_profile_pool(value->oid, &pool))) {
+        pthread_mutex_unlock(&buffer_db_lock);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    /* A threshold for the mode of a new pool is set first */
+    old    = buffer_profiles[index];
+    params = old;
+    buffer_profile_apply(&params, (long)arg, value, pool);
+    if (SAI_STATUS_SUCCESS != buffer_profile_check(&params, &fault)) {
+        pthread_mutex_unlock(&buffer_db_lock);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    count = buffer_profile_users(index, users);
+    for (ii = 0; ii < count; ii++) {
+        buffer_user_detach(users[ii]);
+    }
+
+    buffer_profiles[index] = params;
+    for (ii = 0; ii < count; ii++) {
+        if (SAI_STATUS_SUCCESS != (status = buffer_user_attach(users[ii], index))) {
+            break;
+        }
+    }
+
+    if (ii < count) {
+        for (jj = 0; jj < ii; jj++) {
+            buffer_user_detach(users[jj]);
+        }
+        buffer_profiles[index] = old;
+        for (jj = 0; jj < count; jj++) {
+            buffer_user_attach(users[jj], index);
+        }
+        pthread_mutex_unlock(&buffer_db_lock);
+        return status;
+    }
+
+    if (old.pool != params.pool) {
+        if (BUFFER_NONE != params.pool) {
+            buffer_pools[params.pool].ref_count++;
+        }
+        if (BUFFER_NONE != old.pool) {
+            assert(buffer_pools[old.pool].ref_count > 0);
+            buffer_pools[old.pool].ref_count--;
+        }
+    }
+
+    pthread_mutex_unlock(&buffer_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+const sai_buffer_api_t buffer_api = {
+    stub_create_buffer_pool,
+    stub_remove_buffer_pool,
+    stub_set_buffer_pool_attr,
+    stub_get_buffer_pool_attr,
+    stub_get_buffer_pool_stats,
+    stub_set_ingress_priority_group_attr,
+    stub_get_ingress_priority_group_attr,
+    stub_get_ingress_priority_group_stats,
+    stub_clear_ingress_priority_group_stats,
+    stub_create_buffer_profile,
+    stub_remove_buffer_profile,
+    stub_set_buffer_profile_attr,
+    stub_get_buffer_profile_attr,
+};
@@ -0,0 +1,799 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#include "sai.h"
+#include "stub_sai.h"
+#include "stub_sai_port.h"
+#include "stub_sai_counter.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#undef  __MODULE__
+#define __MODULE__ SAI_COUNTER
+
+#define COUNTER_DEFAULT_ALPHA 0.5
+/* polling thread wakeup when no group is due earlier */
+#define COUNTER_IDLE_NS       1000000000ULL
+
+typedef struct _stub_counter_group_t stub_counter_group_t;
+
+/* Read the counters of all objects of a group into raw, one row of
+ * counter_count values per object */
+typedef sai_status_t (*counter_read_fn)(_In_ const stub_counter_group_t *group, _Out_ uint64_t *raw);
+
+struct _stub_counter_group_t {
+    bool                     is_used;
+    counter_read_fn          read;
+    uint64_t                 interval_ns;
+    double                   alpha;
+    uint64_t                 next_poll_ns;
+    /* rows as read, transposed into the snapshot columns */
+    uint64_t                *raw;
+    /* columnar buffer of the last poll */
+    stub_counter_snapshot_t *snapshot;
+};
+
+static stub_counter_group_t counter_group_db[STUB_COUNTER_MAX_GROUPS];
+/* Groups, the polling thread state and the ring writer */
+static pthread_mutex_t      counter_db_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t       counter_poll_cond;
+static pthread_t            counter_poll_thread;
+static bool                 counter_poll_running;
+static stub_counter_ring_t *counter_ring;
+static char                 counter_ring_name[NAME_MAX];
+
+static inline uint64_t counter_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static sai_status_t counter_read_port(_In_ const stub_counter_group_t *group, _Out_ uint64_t *raw)
+{
+    const stub_counter_snapshot_t *snapshot = group->snapshot;
+
+    return stub_port_get_stats_bulk(snapshot->object_count, snapshot->object_ids, snapshot->counter_count,
+                                    (const sai_port_stat_counter_t*)snapshot->counter_ids, false, raw);
+}
+
+static sai_status_t counter_read_vlan(_In_ const stub_counter_group_t *group, _Out_ uint64_t *raw)
+{
+    const stub_counter_snapshot_t *snapshot = group->snapshot;
+    sai_status_t                   status;
+    uint32_t                       ii;
+
+    for (ii = 0; ii < snapshot->object_count; ii++) {
+        if (SAI_STATUS_SUCCESS !=
+            (status = vlan_api.get_vlan_stats((sai_vlan_id_t)snapshot->object_ids[ii],
+                                              (const sai_vlan_stat_counter_t*)snapshot->counter_ids,
+                                              snapshot->counter_count, raw + ii * snapshot->counter_count))) {
+            return status;
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t counter_read_queue(_In_ const stub_counter_group_t *group, _Out_ uint64_t *raw)
+{
+    const stub_counter_snapshot_t *snapshot = group->snapshot;
+    sai_status_t                   status;
+    uint32_t                       ii;
+
+    for (ii = 0; ii < snapshot->object_count; ii++) {
+        if (SAI_STATUS_SUCCESS !=
+            (status = queue_api.get_queue_stats(snapshot->object_ids[ii],
+                                                (const sai_queue_stat_counter_t*)snapshot->counter_ids,
+                                                snapshot->counter_count, raw + ii * snapshot->counter_count))) {
+            return status;
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t counter_read_buffer_pool(_In_ const stub_counter_group_t *group, _Out_ uint64_t *raw)
+{
+    const stub_counter_snapshot_t *snapshot = group->snapshot;
+    sai_status_t                   status;
+    uint32_t                       ii;
+
+    for (ii = 0; ii < snapshot->object_count; ii++) {
+        if (SAI_STATUS_SUCCESS !=
+            (status = buffer_api.get_buffer_pool_stats(snapshot->object_ids[ii],
+                                                       (const sai_buffer_pool_stat_counter_t*)snapshot->counter_ids,
+                                                       snapshot->counter_count,
+                                                       raw + ii * snapshot->counter_count))) {
+            return status;
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t counter_read_policer(_In_ const stub_counter_group_t *group, _Out_ uint64_t *raw)
+{
+    const stub_counter_snapshot_t *snapshot = group->snapshot;
+    sai_status_t                   status;
+    uint32_t                       ii;
+
+    for (ii = 0; ii < snapshot->object_count; ii++) {
+        if (SAI_STATUS_SUCCESS !=
+            (status = policer_api.get_policer_statistics(snapshot->object_ids[ii],
+                                                         (const sai_policer_stat_counter_t*)snapshot->counter_ids,
+                                                         snapshot->counter_count,
+                                                         raw + ii * snapshot->counter_count))) {
+            return status;
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Copy the filled part of a snapshot, the counts of src are trusted up to the array sizes */
+static void counter_snapshot_copy(_Out_ stub_counter_snapshot_t *dst, _In_ const stub_counter_snapshot_t *src)
+{
+    uint32_t objects  = src->object_count;
+    uint32_t counters = src->counter_count;
+    uint32_t cells;
+
+    objects  = (objects > STUB_COUNTER_MAX_OBJECTS) ? STUB_COUNTER_MAX_OBJECTS : objects;
+    counters = (counters > STUB_COUNTER_MAX_COUNTERS) ? STUB_COUNTER_MAX_COUNTERS : counters;
+    cells    = objects * counters;
+    cells    = (cells > STUB_COUNTER_MAX_CELLS) ? STUB_COUNTER_MAX_CELLS : cells;
+
+    dst->group_id      = src->group_id;
+    dst->object_type   = src->object_type;
+    dst->object_count  = objects;
+    dst->counter_count = counters;
+    dst->poll_count    = src->poll_count;
+    dst->timestamp_ns  = src->timestamp_ns;
+    dst->elapsed_ns    = src->elapsed_ns;
+    memcpy(dst->object_ids, src->object_ids, objects * sizeof(dst->object_ids[0]));
+    memcpy(dst->counter_ids, src->counter_ids, counters * sizeof(dst->counter_ids[0]));
+    memcpy(dst->values, src->values, cells * sizeof(dst->values[0]));
+    memcpy(dst->deltas, src->deltas, cells * sizeof(dst->deltas[0]));
+    memcpy(dst->rates, src->rates, cells * sizeof(dst->rates[0]));
+}
+
+/* Write the last snapshot of a group into its next ring slot. Caller holds counter_db_lock */
+static void counter_publish(_In_ uint32_t group_id)
+{
+    const stub_counter_snapshot_t *snapshot = counter_group_db[group_id].snapshot;
+    stub_counter_snapshot_t       *slot;
+    uint64_t                       sequence;
+
+    if (NULL == counter_ring) {
+        return;
+    }
+
+    slot = &counter_ring->slots[group_id * STUB_COUNTER_RING_DEPTH +
+                                (snapshot->poll_count - 1) % STUB_COUNTER_RING_DEPTH];
+    sequence = slot->sequence;
+
+    __atomic_store_n(&slot->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    counter_snapshot_copy(slot, snapshot);
+    __atomic_store_n(&slot->sequence, sequence + 2, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&counter_ring->heads[group_id], snapshot->poll_count, __ATOMIC_RELEASE);
+}
+
+/*
+ * Read the counters of a group and turn them into values, deltas and rates.
+ * When prime is set the values only become the baseline of the next poll.
+ * Caller holds counter_db_lock.
+ */
+static sai_status_t counter_group_read(_In_ uint32_t group_id, _In_ uint64_t now_ns, _In_ bool prime)
+{
+    stub_counter_group_t    *group    = &counter_group_db[group_id];
+    stub_counter_snapshot_t *snapshot = group->snapshot;
+    uint32_t                 objects  = snapshot->object_count;
+    uint32_t                 counters = snapshot->counter_count;
+    uint64_t                 elapsed_ns, value, delta;
+    double                   sample;
+    uint32_t                 obj, cnt, cell;
+    sai_status_t             status;
+
+    if (SAI_STATUS_SUCCESS != (status = group->read(group, group->raw))) {
+        return status;
+    }
+
+    elapsed_ns = now_ns - snapshot->timestamp_ns;
+
+    for (cnt = 0; cnt < counters; cnt++) {
+        for (obj = 0; obj < objects; obj++) {
+            cell  = cnt * objects + obj;
+            value = group->raw[obj * counters + cnt];
+
+            if (!prime) {
+                delta  = (value >= snapshot->values[cell]) ? value - snapshot->values[cell] : value;
+                sample = (0 == elapsed_ns) ? 0 : (double)delta * 1e9 / (double)elapsed_ns;
+
+                snapshot->deltas[cell] = delta;
+                snapshot->rates[cell]  = (0 == snapshot->poll_count) ? sample :
+                                         group->alpha * sample + (1 - group->alpha) * snapshot->rates[cell];
+            }
+            snapshot->values[cell] = value;
+        }
+    }
+
+    snapshot->timestamp_ns = now_ns;
+
+    if (!prime) {
+        snapshot->elapsed_ns = elapsed_ns;
+        snapshot->poll_count++;
+        counter_publish(group_id);
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Caller holds counter_db_lock */
+static sai_status_t counter_group_db_index(_In_ uint32_t group_id)
+{
+    if ((group_id >= STUB_COUNTER_MAX_GROUPS) || (!counter_group_db[group_id].is_used)) {
+        STUB_LOG_ERR("Counter group %u does not exist\n", group_id);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Create a counter group. The counters are read once, the first poll
+ *    reports the increase since then.
+ *
+ * Arguments:
+ *    [out] group_id - counter group id
+ *    [in] config - objects, counters and interval
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_counter_group_create(_Out_ uint32_t                          *group_id,
+                                       _In_ const stub_counter_group_config_t *config)
+{
+    stub_counter_group_t *group;
+    counter_read_fn       read;
+    sai_status_t          status;
+    uint32_t              ii;
+
+    STUB_LOG_ENTER();
+
+    if ((NULL == group_id) || (NULL == config) || (NULL == config->object_ids) ||
+        (NULL == config->counter_ids)) {
+        STUB_LOG_ERR("NULL param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    switch (config->object_type) {
+    case SAI_OBJECT_TYPE_PORT:
+        read = counter_read_port;
+        break;
+
+    case SAI_OBJECT_TYPE_VLAN:
+        read = counter_read_vlan;
+        break;
+
+    case SAI_OBJECT_TYPE_QUEUE:
+        read = counter_read_queue;
+        break;
+
+    case SAI_OBJECT_TYPE_BUFFER_POOL:
+        read = counter_read_buffer_pool;
+        break;
+
+    case SAI_OBJECT_TYPE_POLICER:
+        read = counter_read_policer;
+        break;
+
+    default:
+        STUB_LOG_ERR("Counter polling of object type %d not supported\n", config->object_type);
+        return SAI_STATUS_NOT_SUPPORTED;
+    }
+
+    if ((0 == config->object_count) || (config->object_count > STUB_COUNTER_MAX_OBJECTS) ||
+        (0 == config->counter_count) || (config->counter_count > STUB_COUNTER_MAX_COUNTERS) ||
+        (config->object_count * config->counter_count > STUB_COUNTER_MAX_CELLS)) {
+        STUB_LOG_ERR("Counter group of %u objects and %u counters exceeds %u objects, %u counters, %u values\n",
+                     config->object_count, config->counter_count, STUB_COUNTER_MAX_OBJECTS,
+                     STUB_COUNTER_MAX_COUNTERS, STUB_COUNTER_MAX_CELLS);
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if ((0 == config->interval_ms) || (config->ewma_alpha < 0) || (config->ewma_alpha > 1)) {
+        STUB_LOG_ERR("Invalid counter group interval %u ms or EWMA weight %f\n",
+                     config->interval_ms, config->ewma_alpha);
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&counter_db_lock);
+
+    for (ii = 0; ii < STUB_COUNTER_MAX_GROUPS; ii++) {
+        if (!counter_group_db[ii].is_used) {
+            break;
+        }
+    }
+
+    if (STUB_COUNTER_MAX_GROUPS == ii) {
+        pthread_mutex_unlock(&counter_db_lock);
+        STUB_LOG_ERR("Cannot create counter group: table is full\n");
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    group           = &counter_group_db[ii];
+    group->read     = read;
+    group->snapshot = calloc(1, sizeof(*group->snapshot));
+    group->raw      = calloc(config->object_count * config->counter_count, sizeof(*group->raw));
+    if ((NULL == group->snapshot) || (NULL == group->raw)) {
+        status = SAI_STATUS_NO_MEMORY;
+        goto err;
+    }
+
+    group->interval_ns             = (uint64_t)config->interval_ms * 1000000ULL;
+    group->alpha                   = (0 == config->ewma_alpha) ? COUNTER_DEFAULT_ALPHA : config->ewma_alpha;
+    group->snapshot->group_id      = ii;
+    group->snapshot->object_type   = config->object_type;
+    group->snapshot->object_count  = config->object_count;
+    group->snapshot->counter_count = config->counter_count;
+    memcpy(group->snapshot->object_ids, config->object_ids,
+           config->object_count * sizeof(config->object_ids[0]));
+    memcpy(group->snapshot->counter_ids, config->counter_ids,
+           config->counter_count * sizeof(config->counter_ids[0]));
+
+    /* the baseline read also validates the objects and counters */
+    group->next_poll_ns = counter_now_ns();
+    if (SAI_STATUS_SUCCESS != (status = counter_group_read(ii, group->next_poll_ns, true))) {
+        goto err;
+    }
+    group->next_poll_ns += group->interval_ns;
+
+    if (NULL != counter_ring) {
+        __atomic_store_n(&counter_ring->heads[ii], 0, __ATOMIC_RELEASE);
+    }
+
+    group->is_used = true;
+    *group_id      = ii;
+
+    if (counter_poll_running) {
+        pthread_cond_signal(&counter_poll_cond);
+    }
+
+    pthread_mutex_unlock(&counter_db_lock);
+
+    STUB_LOG_NTC("Created counter group %u, %u objects x %u counters every %u ms\n",
+                 ii, config->object_count, config->counter_count, config->interval_ms);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+
+err:
+    free(group->snapshot);
+    free(group->raw);
+    group->snapshot = NULL;
+    group->raw      = NULL;
+    pthread_mutex_unlock(&counter_db_lock);
+    STUB_LOG_ERR("Failed to create counter group\n");
+    return status;
+}
+
+/*
+ * Routine Description:
+ *    Remove a counter group
+ *
+ * Arguments:
+ *    [in] group_id - counter group id
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_counter_group_remove(_In_ uint32_t group_id)
+{
+    stub_counter_group_t *group;
+    sai_status_t          status;
+
+    STUB_LOG_ENTER();
+
+    pthread_mutex_lock(&counter_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = counter_group_db_index(group_id))) {
+        pthread_mutex_unlock(&counter_db_lock);
+        return status;
+    }
+
+    group = &counter_group_db[group_id];
+    free(group->snapshot);
+    free(group->raw);
+    memset(group, 0, sizeof(*group));
+
+    if (NULL != counter_ring) {
+        __atomic_store_n(&counter_ring->heads[group_id], 0, __ATOMIC_RELEASE);
+    }
+
+    pthread_mutex_unlock(&counter_db_lock);
+
+    STUB_LOG_NTC("Removed counter group %u\n", group_id);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Poll a counter group now, independent of its interval
+ *
+ * Arguments:
+ *    [in] group_id - counter group id
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_counter_group_poll(_In_ uint32_t group_id)
+{
+    sai_status_t status;
+
+    pthread_mutex_lock(&counter_db_lock);
+
+    if (SAI_STATUS_SUCCESS == (status = counter_group_db_index(group_id))) {
+        status = counter_group_read(group_id, counter_now_ns(), false);
+    }
+
+    pthread_mutex_unlock(&counter_db_lock);
+
+    return status;
+}
+
+/*
+ * Routine Description:
+ *    Copy the last snapshot of a counter group
+ *
+ * Arguments:
+ *    [in] group_id - counter group id
+ *    [out] snapshot - snapshot
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_counter_group_get(_In_ uint32_t group_id, _Out_ stub_counter_snapshot_t *snapshot)
+{
+    sai_status_t status;
+
+    if (NULL == snapshot) {
+        STUB_LOG_ERR("NULL snapshot param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&counter_db_lock);
+
+    if (SAI_STATUS_SUCCESS == (status = counter_group_db_index(group_id))) {
+        counter_snapshot_copy(snapshot, counter_group_db[group_id].snapshot);
+        snapshot->sequence = 0;
+    }
+
+    pthread_mutex_unlock(&counter_db_lock);
+
+    return status;
+}
+
+/* Poll each group when due, sleep until the next group is */
+static void* counter_poll_worker(void *arg)
+{
+    struct timespec wakeup;
+    uint64_t        now_ns, next_ns;
+    uint32_t        ii;
+
+    pthread_mutex_lock(&counter_db_lock);
+
+    while (counter_poll_running) {
+        now_ns  = counter_now_ns();
+        next_ns = now_ns + COUNTER_IDLE_NS;
+
+        for (ii = 0; ii < STUB_COUNTER_MAX_GROUPS; ii++) {
+            stub_counter_group_t *group = &counter_group_db[ii];
+
+            if (!group->is_used) {
+                continue;
+            }
+
+            if (group->next_poll_ns <= now_ns) {
+                if (SAI_STATUS_SUCCESS != counter_group_read(ii, now_ns, false)) {
+                    STUB_LOG_ERR("Failed to poll counter group %u\n", ii);
+                }
+                /* a late poll does not make up for the missed ones */
+                group->next_poll_ns += group->interval_ns;
+                if (group->next_poll_ns <= now_ns) {
+                    group->next_poll_ns = now_ns + group->interval_ns;
+                }
+            }
+
+            if (group->next_poll_ns < next_ns) {
+                next_ns = group->next_poll_ns;
+            }
+        }
+
+        wakeup.tv_sec  = next_ns / 1000000000ULL;
+        wakeup.tv_nsec = next_ns % 1000000000ULL;
+        pthread_cond_timedwait(&counter_poll_cond, &counter_db_lock, &wakeup);
+    }
+
+    pthread_mutex_unlock(&counter_db_lock);
+
+    return NULL;
+}
+
+/* Create and map the shared memory ring. Caller holds counter_db_lock */
+static sai_status_t counter_ring_create(_In_ const char *ring_name)
+{
+    int fd;
+
+    if (strlen(ring_name) >= sizeof(counter_ring_name)) {
+        STUB_LOG_ERR("Counter ring name %s too long\n", ring_name);
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (0 > (fd = shm_open(ring_name, O_CREAT | O_RDWR | O_TRUNC | O_CLOEXEC, 0644))) {
+        STUB_LOG_ERR("Failed to open counter ring %s, %s\n", ring_name, strerror(errno));
+        return SAI_STATUS_FAILURE;
+    }
+
+    /* sparse, slots of unused groups are never touched */
+    if (0 > ftruncate(fd, sizeof(*counter_ring))) {
+        STUB_LOG_ERR("Failed to size counter ring %s, %s\n", ring_name, strerror(errno));
+        close(fd);
+        shm_unlink(ring_name);
+        return SAI_STATUS_FAILURE;
+    }
+
+    counter_ring = mmap(NULL, sizeof(*counter_ring), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == counter_ring) {
+        STUB_LOG_ERR("Failed to map counter ring %s, %s\n", ring_name, strerror(errno));
+        counter_ring = NULL;
+        shm_unlink(ring_name);
+        return SAI_STATUS_FAILURE;
+    }
+
+    memcpy(counter_ring_name, ring_name, strlen(ring_name) + 1);
+    counter_ring->size = sizeof(*counter_ring);
+    __atomic_store_n(&counter_ring->magic, STUB_COUNTER_RING_MAGIC, __ATOMIC_RELEASE);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Caller holds counter_db_lock */
+static void counter_ring_destroy(void)
+{
+    if (NULL == counter_ring) {
+        return;
+    }
+
+    munmap(counter_ring, sizeof(*counter_ring));
+    shm_unlink(counter_ring_name);
+    counter_ring = NULL;
+}
+
+/*
+ * Routine Description:
+ *    Create the shared memory ring and start the polling thread
+ *
+ * Arguments:
+ *    [in] ring_name - shm_open name of the ring, NULL to poll without publishing
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_counter_poll_start(_In_ const char *ring_name)
+{
+    pthread_condattr_t attr;
+    sai_status_t       status;
+
+    STUB_LOG_ENTER();
+
+    pthread_mutex_lock(&counter_db_lock);
+
+    if (counter_poll_running) {
+        pthread_mutex_unlock(&counter_db_lock);
+        return SAI_STATUS_SUCCESS;
+    }
+
+    if ((NULL != ring_name) && (SAI_STATUS_SUCCESS != (status = counter_ring_create(ring_name)))) {
+        pthread_mutex_unlock(&counter_db_lock);
+        return status;
+    }
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&counter_poll_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    counter_poll_running = true;
+
+    if (0 != pthread_create(&counter_poll_thread, NULL, counter_poll_worker, NULL)) {
+        STUB_LOG_ERR("Failed to start counter polling thread\n");
+        counter_poll_running = false;
+        pthread_cond_destroy(&counter_poll_cond);
+        counter_ring_destroy();
+        pthread_mutex_unlock(&counter_db_lock);
+        return SAI_STATUS_FAILURE;
+    }
+
+    pthread_mutex_unlock(&counter_db_lock);
+
+    STUB_LOG_NTC("Counter polling started, ring %s\n", (NULL != ring_name) ? ring_name : "none");
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Stop the polling thread and unlink the shared memory ring
+ */
+void stub_counter_poll_stop(void)
+{
+    pthread_mutex_lock(&counter_db_lock);
+
+    if (!counter_poll_running) {
+        pthread_mutex_unlock(&counter_db_lock);
+        return;
+    }
+
+    counter_poll_running = false;
+    pthread_cond_signal(&counter_poll_cond);
+    pthread_mutex_unlock(&counter_db_lock);
+
+    pthread_join(counter_poll_thread, NULL);
+
+    pthread_mutex_lock(&counter_db_lock);
+    pthread_cond_destroy(&counter_poll_cond);
+    counter_ring_destroy();
+    pthread_mutex_unlock(&counter_db_lock);
+
+    STUB_LOG_NTC("Counter polling stopped\n");
+}
+
+/*
+ * Routine Description:
+ *    Map a counter ring read only
+ *
+ * Arguments:
+ *    [in] ring_name - shm_open name of the ring
+ *    [out] ring - mapped ring
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_counter_ring_open(_In_ const char *ring_name, _Out_ const stub_counter_ring_t **ring)
+{
+    const stub_counter_ring_t *mapped;
+    struct stat                st;
+    int                        fd;
+
+    if ((NULL == ring_name) || (NULL == ring)) {
+        STUB_LOG_ERR("NULL param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (0 > (fd = shm_open(ring_name, O_RDONLY | O_CLOEXEC, 0))) {
+        STUB_LOG_ERR("Failed to open counter ring %s, %s\n", ring_name, strerror(errno));
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    if ((0 > fstat(fd, &st)) || ((size_t)st.st_size < sizeof(*mapped))) {
+        STUB_LOG_ERR("Counter ring %s has an unexpected size\n", ring_name);
+        close(fd);
+        return SAI_STATUS_FAILURE;
+    }
+
+    mapped = mmap(NULL, sizeof(*mapped), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == mapped) {
+        STUB_LOG_ERR("Failed to map counter ring %s, %s\n", ring_name, strerror(errno));
+        return SAI_STATUS_FAILURE;
+    }
+
+    if (STUB_COUNTER_RING_MAGIC != __atomic_load_n(&mapped->magic, __ATOMIC_ACQUIRE)) {
+        STUB_LOG_ERR("Counter ring %s has an unknown layout\n", ring_name);
+        munmap((void*)mapped, sizeof(*mapped));
+        return SAI_STATUS_FAILURE;
+    }
+
+    *ring = mapped;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Copy the newest consistent snapshot of a counter group out of a mapped ring
+ *
+ * Arguments:
+ *    [in] ring - mapped ring
+ *    [in] group_id - counter group id
+ *    [out] snapshot - snapshot
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    SAI_STATUS_ITEM_NOT_FOUND if the group has not been published
+ *    Failure status code on error
+ */
+sai_status_t stub_counter_ring_read(_In_ const stub_counter_ring_t *ring,
+                                    _In_ uint32_t                   group_id,
+                                    _Out_ stub_counter_snapshot_t  *snapshot)
+{
+    const stub_counter_snapshot_t *slot;
+    uint64_t                       head, before, after;
+
+    if ((NULL == ring) || (NULL == snapshot) || (group_id >= STUB_COUNTER_MAX_GROUPS)) {
+        STUB_LOG_ERR("Invalid param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    for (;;) {
+        if (0 == (head = __atomic_load_n(&ring->heads[group_id], __ATOMIC_ACQUIRE))) {
+            return SAI_STATUS_ITEM_NOT_FOUND;
+        }
+
+        slot   = &ring->slots[group_id * STUB_COUNTER_RING_DEPTH + (head - 1) % STUB_COUNTER_RING_DEPTH];
+        before = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        if (before & 1) {
+            sched_yield();
+            continue;
+        }
+
+        counter_snapshot_copy(snapshot, slot);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&slot->sequence, __ATOMIC_RELAXED);
+
+        /* a newer snapshot may have taken the slot since head was read */
+        if ((before == after) && (snapshot->poll_count >= head)) {
+            snapshot->sequence = before;
+            return SAI_STATUS_SUCCESS;
+        }
+    }
+}
+
+/*
+ * Routine Description:
+ *    Unmap a counter ring
+ *
+ * Arguments:
+ *    [in] ring - mapped ring
+ */
+void stub_counter_ring_close(_In_ const stub_counter_ring_t *ring)
+{
+    if (NULL != ring) {
+        munmap((void*)ring, sizeof(*ring));
+    }
+}
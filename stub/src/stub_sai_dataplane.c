@@ -0,0 +1,1515 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#include "sai.h"
+#include "stub_sai.h"
+#include "stub_sai_lookup.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_hash.h"
+#include "stub_sai_mirror.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#ifdef __linux__
+#include <net/if.h>
+#include <sys/socket.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#endif
+
+#undef  __MODULE__
+#define __MODULE__ SAI_DATAPLANE
+
+#define DATAPLANE_UNTAGGED       (-1)
+#define DATAPLANE_MAX_WORKERS    PORT_NUMBER
+#define DATAPLANE_POLL_TIMEOUT   100
+#define DATAPLANE_BUFFER_SIZE    (STUB_DATAPLANE_HEADROOM + STUB_DATAPLANE_MAX_FRAME)
+
+#define ETH_ADDR_LEN             6
+#define ETH_HDR_LEN              14
+#define VLAN_HDR_LEN             4
+#define ETHERTYPE_VLAN           0x8100
+#define ETHERTYPE_IPV4           0x0800
+#define ETHERTYPE_IPV6           0x86DD
+#define ETHERTYPE_ARP            0x0806
+#define ETHERTYPE_SLOW           0x8809
+#define ETHERTYPE_EAPOL          0x888E
+#define ETHERTYPE_LLDP           0x88CC
+#define IPV4_HDR_LEN             20
+#define IPV6_HDR_LEN             40
+#define IP_PROTO_HOPOPTS         0
+#define IP_PROTO_IGMP            2
+#define IP_PROTO_TCP             6
+#define IP_PROTO_UDP             17
+#define IP_PROTO_ICMPV6          58
+#define IP_PROTO_OSPF            89
+#define IP_PROTO_PIM             103
+#define IP_PROTO_VRRP            112
+#define ICMPV6_MLD_QUERY         130
+#define ICMPV6_MLD_REPORT        131
+#define ICMPV6_MLD_DONE          132
+#define ICMPV6_ROUTER_SOLICIT    133
+#define ICMPV6_REDIRECT          137
+#define ICMPV6_MLD_V2_REPORT     143
+#define ARP_OP_REPLY             2
+#define TCP_PORT_BGP             179
+#define UDP_PORT_DHCP_SERVER     67
+#define UDP_PORT_DHCP_CLIENT     68
+#define UDP_PORT_DHCPV6_CLIENT   546
+#define UDP_PORT_DHCPV6_SERVER   547
+
+#define PCAP_MAGIC_USEC          0xA1B2C3D4
+#define PCAP_MAGIC_NSEC          0xA1B23C4D
+#define PCAP_LINKTYPE_ETHERNET   1
+
+/* Clones of an ingress and an egress pass over a burst */
+#define DATAPLANE_MAX_CLONES     (2 * STUB_MIRROR_BURST_CLONES)
+
+/* Parse results of one frame */
+typedef struct _dataplane_meta_t {
+    uint32_t         l3_offset;
+    uint16_t         ethertype;
+    sai_vlan_id_t    vlan_id;
+    bool             tagged;
+    sai_object_id_t  vr_id;
+    sai_ip_address_t dst_ip;
+    uint32_t         flow_hash;
+} dataplane_meta_t;
+
+typedef struct _dataplane_port_t {
+    int             fd;
+    sai_object_id_t port_id;
+} dataplane_port_t;
+
+typedef struct _dataplane_worker_t {
+    pthread_t thread;
+    uint32_t  id;
+    uint8_t  *buffers;
+} dataplane_worker_t;
+
+typedef struct _pcap_file_header_t {
+    uint32_t magic;
+    uint16_t version_major;
+    uint16_t version_minor;
+    int32_t  thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t linktype;
+} pcap_file_header_t;
+
+typedef struct _pcap_record_header_t {
+    uint32_t ts_sec;
+    uint32_t ts_frac;
+    uint32_t incl_len;
+    uint32_t orig_len;
+} pcap_record_header_t;
+
+static stub_dataplane_stats_t dataplane_stats;
+/* Bound ports by port index, fd is -1 when not bound. Changed only while stopped */
+static dataplane_port_t       dataplane_ports[PORT_NUMBER] = { [0 ... PORT_NUMBER - 1] = { -1, SAI_NULL_OBJECT_ID } };
+static pthread_mutex_t        dataplane_lock = PTHREAD_MUTEX_INITIALIZER;
+static dataplane_worker_t     dataplane_workers[DATAPLANE_MAX_WORKERS];
+static uint32_t               dataplane_worker_count;
+static bool                   dataplane_running;
+
+static inline uint16_t dataplane_read16(_In_ const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static inline void dataplane_write16(_In_ uint8_t *p, _In_ uint16_t value)
+{
+    p[0] = (uint8_t)(value >> 8);
+    p[1] = (uint8_t)value;
+}
+
+/* Actions that keep the frame on the data plane */
+static inline bool dataplane_is_forwarded(_In_ sai_int32_t action)
+{
+    return (SAI_PACKET_ACTION_FORWARD == action) || (SAI_PACKET_ACTION_LOG == action) ||
+           (SAI_PACKET_ACTION_COPY == action) || (SAI_PACKET_ACTION_TRANSIT == action);
+}
+
+/* Actions that send the frame to the host */
+static inline bool dataplane_is_trapped(_In_ sai_int32_t action)
+{
+    return (SAI_PACKET_ACTION_TRAP == action) || (SAI_PACKET_ACTION_LOG == action) ||
+           (SAI_PACKET_ACTION_COPY == action);
+}
+
+/* Index of a port object, false for other objects */
+static inline bool dataplane_port_index(_In_ sai_object_id_t port_id, _Out_ uint32_t *port)
+{
+    const stub_object_id_t *object = (const stub_object_id_t*)&port_id;
+
+    *port = object->data;
+    return (SAI_OBJECT_TYPE_PORT == object->object_type) && (object->data < PORT_NUMBER);
+}
+
+/* Parse the Ethernet and VLAN headers and classify the frame to a VLAN,
+ * false for runts and frames of a VLAN the ingress port is not in */
+static bool dataplane_parse_l2(_In_ const stub_packet_t *packet, _Out_ dataplane_meta_t *meta)
+{
+    const uint8_t *data = packet->data;
+    uint32_t       port;
+
+    memset(meta, 0, sizeof(*meta));
+
+    if (packet->length < ETH_HDR_LEN) {
+        return false;
+    }
+
+    meta->ethertype = dataplane_read16(data + 2 * ETH_ADDR_LEN);
+    meta->l3_offset = ETH_HDR_LEN;
+
+    if (ETHERTYPE_VLAN == meta->ethertype) {
+        if (packet->length < ETH_HDR_LEN + VLAN_HDR_LEN) {
+            return false;
+        }
+        meta->tagged    = true;
+        meta->vlan_id   = dataplane_read16(data + ETH_HDR_LEN) & 0x0FFF;
+        meta->ethertype = dataplane_read16(data + ETH_HDR_LEN + 2);
+        meta->l3_offset = ETH_HDR_LEN + VLAN_HDR_LEN;
+    }
+
+    if (!dataplane_port_index(packet->in_port, &port)) {
+        port = PORT_NUMBER;
+    }
+
+    /* Untagged and priority tagged frames are on the port VLAN */
+    if (0 == meta->vlan_id) {
+        meta->vlan_id = db_get_port_default_vlan(port);
+    }
+
+    /* Ingress filtering, a port only takes the frames of its VLANs */
+    return db_vlan_port_member(meta->vlan_id, port);
+}
+
+/* Tag of a frame of a VLAN leaving a port: DATAPLANE_UNTAGGED for untagged
+ * members, VLAN id 0 for priority tagged ones. Frames to ports out of the
+ * VLAN, LAGs and floods carry the VLAN tag */
+static int32_t dataplane_egress_tag(_In_ sai_vlan_id_t vlan_id, _In_ sai_object_id_t port_id)
+{
+    sai_vlan_tagging_mode_t tagging_mode;
+    uint32_t                port;
+
+    if (!dataplane_port_index(port_id, &port) || !db_vlan_port_tagging(vlan_id, port, &tagging_mode)) {
+        return vlan_id;
+    }
+
+    switch (tagging_mode) {
+    case SAI_VLAN_PORT_UNTAGGED:
+        return DATAPLANE_UNTAGGED;
+
+    case SAI_VLAN_PORT_PRIORITY_TAGGED:
+        return 0;
+
+    default:
+        return vlan_id;
+    }
+}
+
+/* Push, pop or rewrite the VLAN tag, keeping the priority bits. Pushing
+ * needs headroom */
+static bool dataplane_set_tag(_Inout_ stub_packet_t *packet, _Inout_ dataplane_meta_t *meta, _In_ int32_t tag)
+{
+    if (DATAPLANE_UNTAGGED == tag) {
+        if (meta->tagged) {
+            memmove(packet->data + VLAN_HDR_LEN, packet->data, 2 * ETH_ADDR_LEN);
+            packet->data     += VLAN_HDR_LEN;
+            packet->length   -= VLAN_HDR_LEN;
+            packet->headroom += VLAN_HDR_LEN;
+            meta->l3_offset  -= VLAN_HDR_LEN;
+            meta->tagged      = false;
+        }
+        return true;
+    }
+
+    if (!meta->tagged) {
+        if (packet->headroom < VLAN_HDR_LEN) {
+            return false;
+        }
+        packet->data     -= VLAN_HDR_LEN;
+        packet->length   += VLAN_HDR_LEN;
+        packet->headroom -= VLAN_HDR_LEN;
+        meta->l3_offset  += VLAN_HDR_LEN;
+        meta->tagged      = true;
+        memmove(packet->data, packet->data + VLAN_HDR_LEN, 2 * ETH_ADDR_LEN);
+        dataplane_write16(packet->data + 2 * ETH_ADDR_LEN, ETHERTYPE_VLAN);
+        dataplane_write16(packet->data + ETH_HDR_LEN, 0);
+        dataplane_write16(packet->data + ETH_HDR_LEN + 2, meta->ethertype);
+    }
+
+    dataplane_write16(packet->data + ETH_HDR_LEN,
+                      (dataplane_read16(packet->data + ETH_HDR_LEN) & 0xF000) | (tag & 0x0FFF));
+
+    return true;
+}
+
+/* Link local control frames, never forwarded. IGMP is snooped, the frame
+ * goes on through the pipeline */
+static sai_int32_t dataplane_switch_trap(_In_ const stub_packet_t *packet, _In_ const dataplane_meta_t *meta)
+{
+    static const uint8_t stp_mac[ETH_ADDR_LEN]   = { 0x01, 0x80, 0xC2, 0x00, 0x00, 0x00 };
+    static const uint8_t pvrst_mac[ETH_ADDR_LEN] = { 0x01, 0x00, 0x0C, 0xCC, 0xCC, 0xCD };
+    const uint8_t       *l3     = packet->data + meta->l3_offset;
+    uint32_t             l3_len = packet->length - meta->l3_offset;
+    uint32_t             ihl;
+
+    if (!(packet->data[0] & 0x01)) {
+        return 0;
+    }
+
+    switch (meta->ethertype) {
+    case ETHERTYPE_SLOW:
+        return SAI_HOSTIF_TRAP_ID_LACP;
+
+    case ETHERTYPE_EAPOL:
+        return SAI_HOSTIF_TRAP_ID_EAPOL;
+
+    case ETHERTYPE_LLDP:
+        return SAI_HOSTIF_TRAP_ID_LLDP;
+
+    case ETHERTYPE_IPV4:
+        if ((l3_len < IPV4_HDR_LEN) || (IP_PROTO_IGMP != l3[9]) ||
+            ((ihl = (l3[0] & 0x0F) * 4) < IPV4_HDR_LEN) || (l3_len <= ihl)) {
+            return 0;
+        }
+        switch (l3[ihl]) {
+        case 0x11:
+            return SAI_HOSTIF_TRAP_ID_IGMP_TYPE_QUERY;
+
+        case 0x12:
+            return SAI_HOSTIF_TRAP_ID_IGMP_TYPE_V1_REPORT;
+
+        case 0x16:
+            return SAI_HOSTIF_TRAP_ID_IGMP_TYPE_V2_REPORT;
+
+        case 0x17:
+            return SAI_HOSTIF_TRAP_ID_IGMP_TYPE_LEAVE;
+
+        case 0x22:
+            return SAI_HOSTIF_TRAP_ID_IGMP_TYPE_V3_REPORT;
+        }
+        return 0;
+    }
+
+    if (0 == memcmp(packet->data, stp_mac, ETH_ADDR_LEN)) {
+        return SAI_HOSTIF_TRAP_ID_STP;
+    }
+
+    if (0 == memcmp(packet->data, pvrst_mac, ETH_ADDR_LEN)) {
+        return SAI_HOSTIF_TRAP_ID_PVRST;
+    }
+
+    return 0;
+}
+
+static inline bool dataplane_is_igmp_trap(_In_ sai_int32_t trap_id)
+{
+    return (trap_id >= SAI_HOSTIF_TRAP_ID_IGMP_TYPE_QUERY) && (trap_id <= SAI_HOSTIF_TRAP_ID_IGMP_TYPE_V3_REPORT);
+}
+
+/* Neighbor resolution frames the host has to see when they arrive on a router interface */
+static sai_int32_t dataplane_neighbor_trap(_In_ const stub_packet_t *packet, _In_ const dataplane_meta_t *meta)
+{
+    const uint8_t *l3     = packet->data + meta->l3_offset;
+    uint32_t       l3_len = packet->length - meta->l3_offset;
+    uint8_t        type;
+
+    if ((ETHERTYPE_ARP == meta->ethertype) && (l3_len >= 8)) {
+        return (ARP_OP_REPLY == dataplane_read16(l3 + 6)) ?
+               SAI_HOSTIF_TRAP_ID_ARP_RESPONSE : SAI_HOSTIF_TRAP_ID_ARP_REQUEST;
+    }
+
+    if ((ETHERTYPE_IPV6 == meta->ethertype) && (l3_len > IPV6_HDR_LEN) && (IP_PROTO_ICMPV6 == l3[6])) {
+        type = l3[IPV6_HDR_LEN];
+        if ((type >= ICMPV6_ROUTER_SOLICIT) && (type <= ICMPV6_REDIRECT)) {
+            return SAI_HOSTIF_TRAP_ID_IPV6_NEIGHBOR_DISCOVERY;
+        }
+    }
+
+    return 0;
+}
+
+/* Routing protocols by transport port */
+static sai_int32_t dataplane_l4_trap(_In_ uint8_t proto, _In_ const uint8_t *l4, _In_ bool ipv6)
+{
+    uint16_t src = dataplane_read16(l4);
+    uint16_t dst = dataplane_read16(l4 + 2);
+
+    if ((IP_PROTO_TCP == proto) && ((TCP_PORT_BGP == src) || (TCP_PORT_BGP == dst))) {
+        return ipv6 ? SAI_HOSTIF_TRAP_ID_BGPV6 : SAI_HOSTIF_TRAP_ID_BGP;
+    }
+
+    if (IP_PROTO_UDP != proto) {
+        return 0;
+    }
+
+    if (!ipv6 && ((UDP_PORT_DHCP_SERVER == dst) || (UDP_PORT_DHCP_CLIENT == dst))) {
+        return SAI_HOSTIF_TRAP_ID_DHCP;
+    }
+
+    if (ipv6 && ((UDP_PORT_DHCPV6_SERVER == dst) || (UDP_PORT_DHCPV6_CLIENT == dst))) {
+        return SAI_HOSTIF_TRAP_ID_DHCPV6;
+    }
+
+    return 0;
+}
+
+/* Control protocols the host runs, for frames to a router interface */
+static sai_int32_t dataplane_router_trap(_In_ const stub_packet_t *packet, _In_ const dataplane_meta_t *meta)
+{
+    const uint8_t *l3     = packet->data + meta->l3_offset;
+    uint32_t       l3_len = packet->length - meta->l3_offset;
+    uint32_t       l4_offset;
+    sai_int32_t    trap_id;
+    uint8_t        proto;
+
+    if (0 != (trap_id = dataplane_neighbor_trap(packet, meta))) {
+        return trap_id;
+    }
+
+    if (ETHERTYPE_IPV4 == meta->ethertype) {
+        if ((l3_len < IPV4_HDR_LEN) || (4 != (l3[0] >> 4)) ||
+            ((l4_offset = (l3[0] & 0x0F) * 4) < IPV4_HDR_LEN) || (l3_len < l4_offset)) {
+            return 0;
+        }
+        switch (l3[9]) {
+        case IP_PROTO_OSPF:
+            return SAI_HOSTIF_TRAP_ID_OSPF;
+
+        case IP_PROTO_PIM:
+            return SAI_HOSTIF_TRAP_ID_PIM;
+
+        case IP_PROTO_VRRP:
+            return SAI_HOSTIF_TRAP_ID_VRRP;
+        }
+        /* L4 ports only on the first fragment */
+        if ((0 != (dataplane_read16(l3 + 6) & 0x1FFF)) || (l3_len < l4_offset + 4)) {
+            return 0;
+        }
+        return dataplane_l4_trap(l3[9], l3 + l4_offset, false);
+    }
+
+    if ((ETHERTYPE_IPV6 != meta->ethertype) || (l3_len < IPV6_HDR_LEN) || (6 != (l3[0] >> 4))) {
+        return 0;
+    }
+
+    proto     = l3[6];
+    l4_offset = IPV6_HDR_LEN;
+
+    /* MLD comes behind a hop-by-hop options header */
+    if (IP_PROTO_HOPOPTS == proto) {
+        if (l3_len < l4_offset + 8) {
+            return 0;
+        }
+        proto      = l3[l4_offset];
+        l4_offset += (l3[l4_offset + 1] + 1) * 8;
+    }
+
+    if (l3_len < l4_offset + 4) {
+        return 0;
+    }
+
+    switch (proto) {
+    case IP_PROTO_ICMPV6:
+        switch (l3[l4_offset]) {
+        case ICMPV6_MLD_QUERY:
+            return SAI_HOSTIF_TRAP_ID_IPV6_MLD_V1_V2;
+
+        case ICMPV6_MLD_REPORT:
+            return SAI_HOSTIF_TRAP_ID_IPV6_MLD_V1_REPORT;
+
+        case ICMPV6_MLD_DONE:
+            return SAI_HOSTIF_TRAP_ID_IPV6_MLD_V1_DONE;
+
+        case ICMPV6_MLD_V2_REPORT:
+            return SAI_HOSTIF_TRAP_ID_MLD_V2_REPORT;
+        }
+        return ((l3[l4_offset] >= ICMPV6_ROUTER_SOLICIT) && (l3[l4_offset] <= ICMPV6_REDIRECT)) ?
+               SAI_HOSTIF_TRAP_ID_IPV6_NEIGHBOR_DISCOVERY : 0;
+
+    case IP_PROTO_OSPF:
+        return SAI_HOSTIF_TRAP_ID_OSPFV6;
+
+    case IP_PROTO_PIM:
+        return SAI_HOSTIF_TRAP_ID_PIM;
+
+    case IP_PROTO_VRRP:
+        return SAI_HOSTIF_TRAP_ID_VRRPV6;
+    }
+
+    return dataplane_l4_trap(proto, l3 + l4_offset, true);
+}
+
+/* Parse the IP header of a frame addressed to the router. Returns false when
+ * the frame is not routed, the action is already set on the packet then.
+ * Frames raising a trap are dropped here, the trap action decides on them */
+static bool dataplane_classify_l3(_Inout_ stub_packet_t *packet, _Inout_ dataplane_meta_t *meta)
+{
+    const uint8_t *l3     = packet->data + meta->l3_offset;
+    uint32_t       l3_len = packet->length - meta->l3_offset;
+    uint32_t       ihl;
+    sai_int32_t    trap_id;
+
+    packet->packet_action = SAI_PACKET_ACTION_DROP;
+
+    if (0 != (trap_id = dataplane_neighbor_trap(packet, meta))) {
+        packet->trap_id = trap_id;
+        return false;
+    }
+
+    if (ETHERTYPE_IPV4 == meta->ethertype) {
+        if ((l3_len < IPV4_HDR_LEN) || (4 != (l3[0] >> 4)) ||
+            ((ihl = (l3[0] & 0x0F) * 4) < IPV4_HDR_LEN) || (l3_len < ihl)) {
+            return false;
+        }
+        if (l3[8] <= 1) {
+            packet->trap_id = SAI_HOSTIF_TRAP_ID_TTL_ERROR;
+            return false;
+        }
+
+        meta->dst_ip.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+        memcpy(&meta->dst_ip.addr.ip4, l3 + 16, sizeof(sai_ip4_t));
+        meta->flow_hash = db_hash_packet(STUB_HASH_TYPE_ECMP, packet, meta->l3_offset, meta->ethertype, meta->vlan_id);
+        return true;
+    }
+
+    if (ETHERTYPE_IPV6 == meta->ethertype) {
+        if ((l3_len < IPV6_HDR_LEN) || (6 != (l3[0] >> 4))) {
+            return false;
+        }
+        if (l3[7] <= 1) {
+            packet->trap_id = SAI_HOSTIF_TRAP_ID_TTL_ERROR;
+            return false;
+        }
+
+        meta->dst_ip.addr_family = SAI_IP_ADDR_FAMILY_IPV6;
+        memcpy(meta->dst_ip.addr.ip6, l3 + 24, sizeof(sai_ip6_t));
+        meta->flow_hash = db_hash_packet(STUB_HASH_TYPE_ECMP, packet, meta->l3_offset, meta->ethertype, meta->vlan_id);
+        return true;
+    }
+
+    return false;
+}
+
+/* Forward within the VLAN by destination MAC, tagged for the egress port.
+ * Caller is in a read side section */
+static void dataplane_bridge(_Inout_ stub_packet_t *packet, _Inout_ dataplane_meta_t *meta)
+{
+    sai_fdb_entry_t fdb_entry;
+    sai_object_id_t port_id;
+    sai_int32_t     action;
+
+    packet->packet_action = SAI_PACKET_ACTION_FORWARD;
+
+    /* Broadcast, multicast and unknown unicast are flooded */
+    if (packet->data[0] & 0x01) {
+        return;
+    }
+
+    memcpy(fdb_entry.mac_address, packet->data, sizeof(sai_mac_t));
+    fdb_entry.vlan_id = meta->vlan_id;
+
+    if (SAI_STATUS_SUCCESS != db_lookup_fdb(&fdb_entry, &port_id, &action)) {
+        return;
+    }
+
+    if (SAI_PACKET_ACTION_FORWARD != action) {
+        packet->packet_action = action;
+        return;
+    }
+
+    /* Never send a frame back where it came from */
+    if ((port_id == packet->in_port) || !dataplane_set_tag(packet, meta, dataplane_egress_tag(meta->vlan_id, port_id))) {
+        packet->packet_action = SAI_PACKET_ACTION_DROP;
+        return;
+    }
+
+    packet->out_port = port_id;
+}
+
+/* TTL decrement with incremental header checksum update, RFC 1624 eqn. 3 */
+static void dataplane_decrement_ttl(_Inout_ uint8_t *ip)
+{
+    uint16_t old_word = dataplane_read16(ip + 8);
+    uint16_t new_word;
+    uint32_t sum;
+
+    ip[8]--;
+    new_word = dataplane_read16(ip + 8);
+
+    sum  = (uint16_t)~dataplane_read16(ip + 10);
+    sum += (uint16_t)~old_word;
+    sum += new_word;
+    sum  = (sum & 0xFFFF) + (sum >> 16);
+    sum  = (sum & 0xFFFF) + (sum >> 16);
+
+    dataplane_write16(ip + 10, (uint16_t)~sum);
+}
+
+/* Rewrite a routed frame for its egress interface, tagged as the egress
+ * port takes the interface VLAN */
+static bool dataplane_rewrite(_Inout_ stub_packet_t                 *packet,
+                              _Inout_ dataplane_meta_t              *meta,
+                              _In_ const stub_forwarding_result_t   *result)
+{
+    uint8_t *l3;
+    int32_t  tag = DATAPLANE_UNTAGGED;
+
+    if (0 != result->vlan_id) {
+        tag = dataplane_egress_tag(result->vlan_id,
+                                   (SAI_STATUS_SUCCESS == result->status) ? result->port_id : SAI_NULL_OBJECT_ID);
+    }
+
+    if (!dataplane_set_tag(packet, meta, tag)) {
+        return false;
+    }
+
+    memcpy(packet->data, result->dst_mac, sizeof(sai_mac_t));
+    memcpy(packet->data + ETH_ADDR_LEN, result->src_mac, sizeof(sai_mac_t));
+
+    l3 = packet->data + meta->l3_offset;
+    if (SAI_IP_ADDR_FAMILY_IPV4 == meta->dst_ip.addr_family) {
+        dataplane_decrement_ttl(l3);
+    } else {
+        l3[7]--;
+    }
+
+    return true;
+}
+
+/* Apply the forwarding lookup result to a routed frame */
+static void dataplane_route(_Inout_ stub_packet_t               *packet,
+                            _Inout_ dataplane_meta_t            *meta,
+                            _In_ const stub_forwarding_result_t *result)
+{
+    packet->packet_action = result->packet_action;
+
+    if (dataplane_is_forwarded(result->packet_action)) {
+        if ((SAI_STATUS_SUCCESS != result->status) && (0 == result->vlan_id)) {
+            packet->packet_action = SAI_PACKET_ACTION_DROP;
+            return;
+        }
+        if (!dataplane_rewrite(packet, meta, result)) {
+            packet->packet_action = SAI_PACKET_ACTION_DROP;
+            return;
+        }
+        /* Neighbor not in the FDB yet, flood on the egress VLAN */
+        packet->out_port = (SAI_STATUS_SUCCESS == result->status) ? result->port_id : SAI_NULL_OBJECT_ID;
+        packet->vlan_id  = result->vlan_id;
+
+        /* A router interface on a LAG sends on the member the LAG hash picks */
+        if ((SAI_OBJECT_TYPE_LAG == ((const stub_object_id_t*)&packet->out_port)->object_type) &&
+            (SAI_STATUS_SUCCESS !=
+             db_select_lag_member(packet->out_port,
+                                  db_hash_packet(STUB_HASH_TYPE_LAG, packet, meta->l3_offset, meta->ethertype,
+                                                 meta->vlan_id),
+                                  &packet->out_port))) {
+            packet->packet_action = SAI_PACKET_ACTION_DROP;
+            packet->out_port      = SAI_NULL_OBJECT_ID;
+        }
+    }
+}
+
+static void dataplane_count(_In_ uint32_t             count,
+                            _In_ const stub_packet_t *packets,
+                            _In_ uint32_t             routed,
+                            _In_ uint32_t             shard)
+{
+    uint64_t flooded = 0, trapped = 0, dropped = 0, forwarded = 0;
+    uint32_t ii, port;
+
+    for (ii = 0; ii < count; ii++) {
+        if (dataplane_is_trapped(packets[ii].packet_action)) {
+            trapped++;
+        }
+        if (!dataplane_is_forwarded(packets[ii].packet_action)) {
+            if (SAI_PACKET_ACTION_TRAP != packets[ii].packet_action) {
+                dropped++;
+                if (dataplane_port_index(packets[ii].in_port, &port)) {
+                    db_port_stats_add(shard, port, SAI_PORT_STAT_IF_IN_DISCARDS, 1);
+                }
+            }
+        } else if (SAI_NULL_OBJECT_ID == packets[ii].out_port) {
+            flooded++;
+        } else {
+            forwarded++;
+        }
+    }
+
+    __atomic_fetch_add(&dataplane_stats.rx_packets, count, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&dataplane_stats.routed, routed, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&dataplane_stats.bridged, forwarded + flooded - routed, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&dataplane_stats.flooded, flooded, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&dataplane_stats.trapped, trapped, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&dataplane_stats.dropped, dropped, __ATOMIC_RELAXED);
+}
+
+static void dataplane_process_chunk(_In_ uint32_t count, _Inout_ stub_packet_t *packets)
+{
+    dataplane_meta_t         meta[STUB_DATAPLANE_BURST];
+    uint32_t                 l3_index[STUB_DATAPLANE_BURST];
+    uint32_t                 batch_index[STUB_DATAPLANE_BURST];
+    sai_ip_address_t         batch_ip[STUB_DATAPLANE_BURST];
+    uint32_t                 batch_hash[STUB_DATAPLANE_BURST];
+    stub_forwarding_result_t results[STUB_DATAPLANE_BURST];
+    bool                     done[STUB_DATAPLANE_BURST];
+    bool                     pending[STUB_DATAPLANE_BURST];
+    bool                     copy[STUB_DATAPLANE_BURST];
+    sai_object_id_t          rif_id, vr_id, port_id;
+    sai_vlan_id_t            rif_vlan;
+    sai_mac_t                router_mac;
+    bool                     admin_v4, admin_v6;
+    sai_int32_t              trap_id;
+    stub_packet_t           *packet;
+    uint32_t                 ii, jj, l3_count = 0, batch_count, routed = 0, port;
+    uint32_t                 shard = db_port_stats_shard();
+
+    stub_rcu_read_lock();
+
+    for (ii = 0; ii < count; ii++) {
+        packet = &packets[ii];
+        if (dataplane_port_index(packet->in_port, &port)) {
+            db_port_stats_frame(shard, port, true, packet->data, packet->length);
+        }
+
+        packet->out_port       = SAI_NULL_OBJECT_ID;
+        packet->packet_action  = SAI_PACKET_ACTION_DROP;
+        packet->trap_id        = 0;
+        packet->tc             = 0;
+        packet->color          = SAI_PACKET_COLOR_GREEN;
+        packet->queue          = 0;
+        packet->priority_group = 0;
+
+        pending[ii] = dataplane_parse_l2(packet, &meta[ii]);
+        copy[ii]    = false;
+    }
+
+    /* Traffic class and color by the ingress port QoS maps */
+    db_apply_qos_maps(count, packets, pending);
+
+    /* Frames the port policers drop skip the pipeline */
+    db_apply_port_policers(count, packets, pending);
+
+    /* Frames the ingress ACL drops, traps or redirects skip the lookups */
+    db_apply_acl(SAI_ACL_STAGE_INGRESS, count, packets, pending, copy);
+
+    for (ii = 0; ii < count; ii++) {
+        packet = &packets[ii];
+        if (!pending[ii]) {
+            continue;
+        }
+        packet->vlan_id = meta[ii].vlan_id;
+
+        if ((0 != (packet->trap_id = dataplane_switch_trap(packet, &meta[ii]))) &&
+            !dataplane_is_igmp_trap(packet->trap_id)) {
+            continue;
+        }
+
+        if (SAI_STATUS_SUCCESS != db_lookup_ingress_rif(packet->in_port, meta[ii].vlan_id, &rif_id, &vr_id, router_mac)) {
+            dataplane_bridge(packet, &meta[ii]);
+            continue;
+        }
+
+        if (0 == memcmp(packet->data, router_mac, sizeof(sai_mac_t))) {
+            if (dataplane_classify_l3(packet, &meta[ii])) {
+                meta[ii].vr_id       = vr_id;
+                done[l3_count]       = false;
+                l3_index[l3_count++] = ii;
+            }
+            continue;
+        }
+
+        if ((packet->data[0] & 0x01) && (0 != (trap_id = dataplane_router_trap(packet, &meta[ii])))) {
+            packet->trap_id = trap_id;
+            /* Hosts on a VLAN interface still need the frame, the trap copies it to the host */
+            if ((SAI_STATUS_SUCCESS == db_lookup_rif(rif_id, &port_id, &rif_vlan, router_mac, &admin_v4, &admin_v6)) &&
+                (0 != rif_vlan)) {
+                dataplane_bridge(packet, &meta[ii]);
+            }
+            continue;
+        }
+
+        dataplane_bridge(packet, &meta[ii]);
+    }
+
+    stub_rcu_read_unlock();
+
+    /* Route lookups are batched per virtual router */
+    for (ii = 0; ii < l3_count; ii++) {
+        if (done[ii]) {
+            continue;
+        }
+
+        vr_id       = meta[l3_index[ii]].vr_id;
+        batch_count = 0;
+
+        for (jj = ii; jj < l3_count; jj++) {
+            if (done[jj] || (meta[l3_index[jj]].vr_id != vr_id)) {
+                continue;
+            }
+            done[jj]                 = true;
+            batch_index[batch_count] = l3_index[jj];
+            batch_ip[batch_count]    = meta[l3_index[jj]].dst_ip;
+            batch_hash[batch_count]  = meta[l3_index[jj]].flow_hash;
+            batch_count++;
+        }
+
+        stub_lookup_forwarding_bulk(vr_id, batch_count, batch_ip, batch_hash, results);
+
+        for (jj = 0; jj < batch_count; jj++) {
+            packet = &packets[batch_index[jj]];
+            dataplane_route(packet, &meta[batch_index[jj]], &results[jj]);
+            routed += dataplane_is_forwarded(packet->packet_action);
+            /* Trapped by an IP2ME route or neighbor, name the protocol for the trap table */
+            if ((SAI_PACKET_ACTION_TRAP == packet->packet_action) && (SAI_STATUS_SUCCESS == results[jj].status)) {
+                packet->trap_id = dataplane_router_trap(packet, &meta[batch_index[jj]]);
+            }
+        }
+    }
+
+    db_apply_storm_control(count, packets);
+
+    for (ii = 0; ii < count; ii++) {
+        pending[ii] = dataplane_is_forwarded(packets[ii].packet_action);
+    }
+    db_apply_acl(SAI_ACL_STAGE_EGRESS, count, packets, pending, copy);
+    db_apply_qos_queues(count, packets);
+
+    /* ACL copies go to the host next to the forwarded frame, or instead of a dropped one */
+    for (ii = 0; ii < count; ii++) {
+        if (copy[ii] && (SAI_PACKET_ACTION_TRAP != packets[ii].packet_action)) {
+            packets[ii].packet_action = dataplane_is_forwarded(packets[ii].packet_action) ?
+                                        SAI_PACKET_ACTION_LOG : SAI_PACKET_ACTION_TRAP;
+        }
+    }
+
+    db_apply_hostif_traps(count, packets);
+    dataplane_count(count, packets, routed, shard);
+}
+
+/*
+ * Routine Description:
+ *    Forward a burst of frames
+ *
+ * Arguments:
+ *    [in] count - number of frames
+ *    [inout] packets - frames
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_dataplane_process_burst(_In_ uint32_t count, _Inout_ stub_packet_t *packets)
+{
+    uint32_t ii, chunk;
+
+    if (NULL == packets) {
+        STUB_LOG_ERR("NULL packets param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    for (ii = 0; ii < count; ii += chunk) {
+        chunk = (count - ii < STUB_DATAPLANE_BURST) ? count - ii : STUB_DATAPLANE_BURST;
+        dataplane_process_chunk(chunk, packets + ii);
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Clone a burst for the ingress sessions before it is forwarded, or for
+ * the egress sessions after, into the clones left in the array */
+static uint32_t dataplane_mirror(_In_ bool                     ingress,
+                                 _In_ uint32_t                 count,
+                                 _In_ const stub_packet_t     *packets,
+                                 _In_ uint32_t                 clone_count,
+                                 _Inout_ stub_mirror_packet_t *clones)
+{
+    uint32_t made = 0;
+
+    stub_mirror_burst(ingress, count, packets, DATAPLANE_MAX_CLONES - clone_count, clones + clone_count, &made);
+    if (0 != made) {
+        __atomic_fetch_add(&dataplane_stats.mirrored, made, __ATOMIC_RELAXED);
+    }
+
+    return clone_count + made;
+}
+
+/*
+ * Routine Description:
+ *    Check whether a forwarded frame leaves through a port. A flooded
+ *    frame reaches the members of its VLAN but the ingress port
+ *
+ * Arguments:
+ *    [in] packet - frame
+ *    [in] port - port index
+ *
+ * Return Values:
+ *    true when the frame is sent on the port
+ */
+bool stub_dataplane_is_sent_to(_In_ const stub_packet_t *packet, _In_ uint32_t port)
+{
+    uint32_t index;
+
+    if (!dataplane_is_forwarded(packet->packet_action)) {
+        return false;
+    }
+
+    if (SAI_NULL_OBJECT_ID == packet->out_port) {
+        return (!dataplane_port_index(packet->in_port, &index) || (index != port)) &&
+               db_vlan_port_member(packet->vlan_id, port);
+    }
+
+    return dataplane_port_index(packet->out_port, &index) && (index == port);
+}
+
+#ifdef __linux__
+
+/* Gather a frame for one of the ports it is sent to, with the VLAN tag the
+ * port takes. Flooded frames keep the tag of their VLAN up to here */
+static uint32_t dataplane_egress_iov(_In_ const stub_packet_t *packet,
+                                     _In_ sai_object_id_t      port_id,
+                                     _Out_ uint8_t            *tag,
+                                     _Out_ struct iovec       *iov)
+{
+    uint8_t *data   = packet->data;
+    bool     tagged = (packet->length >= ETH_HDR_LEN + VLAN_HDR_LEN) &&
+                      (ETHERTYPE_VLAN == dataplane_read16(data + 2 * ETH_ADDR_LEN));
+    uint32_t rest   = 2 * ETH_ADDR_LEN + (tagged ? VLAN_HDR_LEN : 0);
+    int32_t  egress;
+
+    iov[0].iov_base = data;
+    iov[0].iov_len  = packet->length;
+
+    if (0 == packet->vlan_id) {
+        return 1;
+    }
+
+    egress = dataplane_egress_tag(packet->vlan_id, port_id);
+    if (DATAPLANE_UNTAGGED == egress) {
+        if (!tagged) {
+            return 1;
+        }
+        iov[0].iov_len  = 2 * ETH_ADDR_LEN;
+        iov[1].iov_base = data + rest;
+        iov[1].iov_len  = packet->length - rest;
+        return 2;
+    }
+
+    if (tagged && ((dataplane_read16(data + ETH_HDR_LEN) & 0x0FFF) == egress)) {
+        return 1;
+    }
+
+    dataplane_write16(tag, ETHERTYPE_VLAN);
+    dataplane_write16(tag + 2, (tagged ? (dataplane_read16(data + ETH_HDR_LEN) & 0xF000) : 0) | egress);
+    iov[0].iov_len  = 2 * ETH_ADDR_LEN;
+    iov[1].iov_base = tag;
+    iov[1].iov_len  = VLAN_HDR_LEN;
+    iov[2].iov_base = data + rest;
+    iov[2].iov_len  = packet->length - rest;
+    return 3;
+}
+
+/* Send the forwarded frames of a burst and its mirror clones, one
+ * sendmmsg per egress port. A clone goes out as its header and data */
+static void dataplane_transmit(_In_ uint32_t                    count,
+                               _In_ const stub_packet_t        *packets,
+                               _In_ uint32_t                    clone_count,
+                               _In_ const stub_mirror_packet_t *clones)
+{
+    struct mmsghdr msgs[STUB_DATAPLANE_BURST + DATAPLANE_MAX_CLONES];
+    struct iovec   iov[STUB_DATAPLANE_BURST + DATAPLANE_MAX_CLONES][3];
+    uint8_t        tags[STUB_DATAPLANE_BURST][VLAN_HDR_LEN];
+    uint32_t       ii, jj, port, msg_count, length, shard = db_port_stats_shard();
+    int            fd, sent;
+
+    db_deliver_hostif_traps(count, packets);
+
+    for (port = 0; port < PORT_NUMBER; port++) {
+        if (-1 == (fd = dataplane_ports[port].fd)) {
+            continue;
+        }
+
+        msg_count = 0;
+        for (ii = 0; ii < count; ii++) {
+            if (!stub_dataplane_is_sent_to(&packets[ii], port)) {
+                continue;
+            }
+            memset(&msgs[msg_count], 0, sizeof(msgs[msg_count]));
+            msgs[msg_count].msg_hdr.msg_iov    = iov[msg_count];
+            msgs[msg_count].msg_hdr.msg_iovlen = dataplane_egress_iov(&packets[ii], dataplane_ports[port].port_id,
+                                                                      tags[msg_count], iov[msg_count]);
+            msg_count++;
+        }
+        for (ii = 0; ii < clone_count; ii++) {
+            if (clones[ii].monitor_port != dataplane_ports[port].port_id) {
+                continue;
+            }
+            memset(&msgs[msg_count], 0, sizeof(msgs[msg_count]));
+            msgs[msg_count].msg_hdr.msg_iov = iov[msg_count];
+            if (0 != clones[ii].header_length) {
+                iov[msg_count][0].iov_base = (void*)clones[ii].header;
+                iov[msg_count][0].iov_len  = clones[ii].header_length;
+                msgs[msg_count].msg_hdr.msg_iovlen++;
+            }
+            iov[msg_count][msgs[msg_count].msg_hdr.msg_iovlen].iov_base = (void*)clones[ii].data;
+            iov[msg_count][msgs[msg_count].msg_hdr.msg_iovlen].iov_len  = clones[ii].length;
+            msgs[msg_count].msg_hdr.msg_iovlen++;
+            msg_count++;
+        }
+
+        if (0 == msg_count) {
+            continue;
+        }
+
+        if (0 < (sent = sendmmsg(fd, msgs, msg_count, MSG_DONTWAIT))) {
+            __atomic_fetch_add(&dataplane_stats.tx_packets, sent, __ATOMIC_RELAXED);
+        }
+        for (ii = 0; ii < msg_count; ii++) {
+            if ((int)ii < sent) {
+                for (jj = 0, length = 0; jj < msgs[ii].msg_hdr.msg_iovlen; jj++) {
+                    length += iov[ii][jj].iov_len;
+                }
+                db_port_stats_frame(shard, port, false, iov[ii][0].iov_base, length);
+            } else {
+                db_port_stats_add(shard, port, SAI_PORT_STAT_IF_OUT_DISCARDS, 1);
+            }
+        }
+    }
+}
+
+/* Receive one burst from a port and run it to completion */
+static void dataplane_rx_burst(_In_ dataplane_worker_t *worker, _In_ uint32_t port)
+{
+    struct mmsghdr       msgs[STUB_DATAPLANE_BURST];
+    struct iovec         iov[STUB_DATAPLANE_BURST];
+    struct sockaddr_ll   from[STUB_DATAPLANE_BURST];
+    stub_packet_t        packets[STUB_DATAPLANE_BURST];
+    stub_mirror_packet_t clones[DATAPLANE_MAX_CLONES];
+    uint32_t             ii, count = 0, clone_count;
+    int                  received;
+
+    for (ii = 0; ii < STUB_DATAPLANE_BURST; ii++) {
+        iov[ii].iov_base = worker->buffers + ii * DATAPLANE_BUFFER_SIZE + STUB_DATAPLANE_HEADROOM;
+        iov[ii].iov_len  = STUB_DATAPLANE_MAX_FRAME;
+        memset(&msgs[ii], 0, sizeof(msgs[ii]));
+        msgs[ii].msg_hdr.msg_iov     = &iov[ii];
+        msgs[ii].msg_hdr.msg_iovlen  = 1;
+        msgs[ii].msg_hdr.msg_name    = &from[ii];
+        msgs[ii].msg_hdr.msg_namelen = sizeof(from[ii]);
+    }
+
+    if (0 >= (received = recvmmsg(dataplane_ports[port].fd, msgs, STUB_DATAPLANE_BURST, MSG_DONTWAIT, NULL))) {
+        return;
+    }
+
+    for (ii = 0; ii < (uint32_t)received; ii++) {
+        /* Frames the host itself sent on the interface */
+        if (PACKET_OUTGOING == from[ii].sll_pkttype) {
+            continue;
+        }
+        packets[count].data     = iov[ii].iov_base;
+        packets[count].length   = msgs[ii].msg_len;
+        packets[count].headroom = STUB_DATAPLANE_HEADROOM;
+        packets[count].in_port  = dataplane_ports[port].port_id;
+        count++;
+    }
+
+    clone_count = dataplane_mirror(true, count, packets, 0, clones);
+    stub_dataplane_process_burst(count, packets);
+    clone_count = dataplane_mirror(false, count, packets, clone_count, clones);
+    dataplane_transmit(count, packets, clone_count, clones);
+    stub_mirror_release(clone_count, clones);
+}
+
+static void* dataplane_worker(void *arg)
+{
+    dataplane_worker_t *worker = arg;
+    struct pollfd       fds[PORT_NUMBER];
+    uint32_t            ports[PORT_NUMBER];
+    uint32_t            port, ii, count = 0;
+
+    /* Ports are spread over the workers, each port is polled by one worker only */
+    for (port = worker->id; port < PORT_NUMBER; port += dataplane_worker_count) {
+        if (-1 == dataplane_ports[port].fd) {
+            continue;
+        }
+        fds[count].fd       = dataplane_ports[port].fd;
+        fds[count].events   = POLLIN;
+        fds[count].revents  = 0;
+        ports[count++]      = port;
+    }
+
+    while (__atomic_load_n(&dataplane_running, __ATOMIC_ACQUIRE) && (0 != count)) {
+        if (0 >= poll(fds, count, DATAPLANE_POLL_TIMEOUT)) {
+            continue;
+        }
+        for (ii = 0; ii < count; ii++) {
+            if (fds[ii].revents & POLLIN) {
+                dataplane_rx_burst(worker, ports[ii]);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+#endif /* __linux__ */
+
+/*
+ * Routine Description:
+ *    Attach a switch port to a Linux network interface
+ *
+ * Arguments:
+ *    [in] port_id - switch port
+ *    [in] ifname - network interface name
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_dataplane_bind_port(_In_ sai_object_id_t port_id, _In_ const char *ifname)
+{
+#ifdef __linux__
+    struct sockaddr_ll addr;
+    struct packet_mreq mreq;
+    uint32_t           port;
+    int                fd, ifindex;
+    sai_status_t       status;
+
+    if (NULL == ifname) {
+        STUB_LOG_ERR("NULL ifname param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(port_id, SAI_OBJECT_TYPE_PORT, &port))) {
+        return status;
+    }
+
+    if (port >= PORT_NUMBER) {
+        STUB_LOG_ERR("Invalid port index %u\n", port);
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (0 == (ifindex = if_nametoindex(ifname))) {
+        STUB_LOG_ERR("No interface %s\n", ifname);
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    if (-1 == (fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL)))) {
+        STUB_LOG_ERR("Failed to open packet socket for %s\n", ifname);
+        return SAI_STATUS_FAILURE;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sll_family   = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_ALL);
+    addr.sll_ifindex  = ifindex;
+
+    memset(&mreq, 0, sizeof(mreq));
+    mreq.mr_ifindex = ifindex;
+    mreq.mr_type    = PACKET_MR_PROMISC;
+
+    if ((0 != bind(fd, (struct sockaddr*)&addr, sizeof(addr))) ||
+        (0 != setsockopt(fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq))) ||
+        (0 != fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK))) {
+        STUB_LOG_ERR("Failed to set up packet socket for %s\n", ifname);
+        close(fd);
+        return SAI_STATUS_FAILURE;
+    }
+
+    pthread_mutex_lock(&dataplane_lock);
+
+    if (dataplane_running) {
+        pthread_mutex_unlock(&dataplane_lock);
+        close(fd);
+        STUB_LOG_ERR("Can't bind ports while the data plane runs\n");
+        return SAI_STATUS_OBJECT_IN_USE;
+    }
+
+    if (-1 != dataplane_ports[port].fd) {
+        close(dataplane_ports[port].fd);
+    }
+    dataplane_ports[port].fd      = fd;
+    dataplane_ports[port].port_id = port_id;
+
+    pthread_mutex_unlock(&dataplane_lock);
+
+    STUB_LOG_NTC("Bound port %u to %s\n", port, ifname);
+
+    return SAI_STATUS_SUCCESS;
+#else
+    return SAI_STATUS_NOT_SUPPORTED;
+#endif
+}
+
+/*
+ * Routine Description:
+ *    Detach a switch port from its network interface
+ *
+ * Arguments:
+ *    [in] port_id - switch port
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_dataplane_unbind_port(_In_ sai_object_id_t port_id)
+{
+    uint32_t     port;
+    sai_status_t status;
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(port_id, SAI_OBJECT_TYPE_PORT, &port))) {
+        return status;
+    }
+
+    if (port >= PORT_NUMBER) {
+        STUB_LOG_ERR("Invalid port index %u\n", port);
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&dataplane_lock);
+
+    if (dataplane_running) {
+        pthread_mutex_unlock(&dataplane_lock);
+        STUB_LOG_ERR("Can't unbind ports while the data plane runs\n");
+        return SAI_STATUS_OBJECT_IN_USE;
+    }
+
+    if (-1 == dataplane_ports[port].fd) {
+        pthread_mutex_unlock(&dataplane_lock);
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    close(dataplane_ports[port].fd);
+    dataplane_ports[port].fd      = -1;
+    dataplane_ports[port].port_id = SAI_NULL_OBJECT_ID;
+
+    pthread_mutex_unlock(&dataplane_lock);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Start the forwarding workers
+ *
+ * Arguments:
+ *    [in] worker_count - number of worker threads
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_dataplane_start(_In_ uint32_t worker_count)
+{
+#ifdef __linux__
+    uint32_t ii;
+
+    if ((0 == worker_count) || (worker_count > DATAPLANE_MAX_WORKERS)) {
+        STUB_LOG_ERR("Invalid worker count %u\n", worker_count);
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&dataplane_lock);
+
+    if (dataplane_running) {
+        pthread_mutex_unlock(&dataplane_lock);
+        return SAI_STATUS_ITEM_ALREADY_EXISTS;
+    }
+
+    dataplane_running      = true;
+    dataplane_worker_count = 0;
+
+    for (ii = 0; ii < worker_count; ii++) {
+        dataplane_workers[ii].id      = ii;
+        dataplane_workers[ii].buffers = malloc(STUB_DATAPLANE_BURST * DATAPLANE_BUFFER_SIZE);
+        if (NULL == dataplane_workers[ii].buffers) {
+            break;
+        }
+        dataplane_worker_count++;
+    }
+
+    if (dataplane_worker_count != worker_count) {
+        STUB_LOG_ERR("Failed to allocate data plane buffers\n");
+        for (ii = 0; ii < dataplane_worker_count; ii++) {
+            free(dataplane_workers[ii].buffers);
+        }
+        dataplane_worker_count = 0;
+        dataplane_running      = false;
+        pthread_mutex_unlock(&dataplane_lock);
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    for (ii = 0; ii < dataplane_worker_count; ii++) {
+        if (0 != pthread_create(&dataplane_workers[ii].thread, NULL, dataplane_worker, &dataplane_workers[ii])) {
+            STUB_LOG_ERR("Failed to start data plane worker %u\n", ii);
+            __atomic_store_n(&dataplane_running, false, __ATOMIC_RELEASE);
+            while (ii--) {
+                pthread_join(dataplane_workers[ii].thread, NULL);
+            }
+            for (ii = 0; ii < dataplane_worker_count; ii++) {
+                free(dataplane_workers[ii].buffers);
+            }
+            dataplane_worker_count = 0;
+            pthread_mutex_unlock(&dataplane_lock);
+            return SAI_STATUS_FAILURE;
+        }
+    }
+
+    pthread_mutex_unlock(&dataplane_lock);
+
+    STUB_LOG_NTC("Data plane started with %u workers\n", worker_count);
+
+    return SAI_STATUS_SUCCESS;
+#else
+    return SAI_STATUS_NOT_SUPPORTED;
+#endif
+}
+
+/*
+ * Routine Description:
+ *    Stop the forwarding workers
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_dataplane_stop(void)
+{
+    uint32_t ii;
+
+    pthread_mutex_lock(&dataplane_lock);
+
+    if (!dataplane_running) {
+        pthread_mutex_unlock(&dataplane_lock);
+        return SAI_STATUS_SUCCESS;
+    }
+
+    __atomic_store_n(&dataplane_running, false, __ATOMIC_RELEASE);
+
+    for (ii = 0; ii < dataplane_worker_count; ii++) {
+        pthread_join(dataplane_workers[ii].thread, NULL);
+        free(dataplane_workers[ii].buffers);
+        dataplane_workers[ii].buffers = NULL;
+    }
+    dataplane_worker_count = 0;
+
+    pthread_mutex_unlock(&dataplane_lock);
+
+    STUB_LOG_NTC("Data plane stopped\n");
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static bool pcap_write_record(_In_ FILE                       *out,
+                              _In_ const pcap_record_header_t *record,
+                              _In_ const stub_packet_t        *packet)
+{
+    pcap_record_header_t header = *record;
+
+    header.incl_len = packet->length;
+    header.orig_len = packet->length;
+
+    return (1 == fwrite(&header, sizeof(header), 1, out)) &&
+           (1 == fwrite(packet->data, packet->length, 1, out));
+}
+
+static bool pcap_write_clone(_In_ FILE                       *out,
+                             _In_ const pcap_record_header_t *record,
+                             _In_ const stub_mirror_packet_t *clone)
+{
+    pcap_record_header_t header = *record;
+
+    header.incl_len = clone->header_length + clone->length;
+    header.orig_len = header.incl_len;
+
+    return (1 == fwrite(&header, sizeof(header), 1, out)) &&
+           ((0 == clone->header_length) || (1 == fwrite(clone->header, clone->header_length, 1, out))) &&
+           (1 == fwrite(clone->data, clone->length, 1, out));
+}
+
+/*
+ * Routine Description:
+ *    Forward all frames of a pcap file as if received on one port. Mirror
+ *    clones of a burst follow its forwarded frames in the output
+ *
+ * Arguments:
+ *    [in] in_path - input pcap file
+ *    [in] in_port - ingress port of the frames
+ *    [in] out_path - output pcap file, may be NULL
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_dataplane_run_pcap(_In_ const char *in_path, _In_ sai_object_id_t in_port, _In_ const char *out_path)
+{
+    pcap_file_header_t   file_header;
+    pcap_record_header_t records[STUB_DATAPLANE_BURST];
+    stub_packet_t        packets[STUB_DATAPLANE_BURST];
+    stub_mirror_packet_t clones[DATAPLANE_MAX_CLONES];
+    uint8_t             *buffers;
+    FILE                *in, *out = NULL;
+    bool                 swapped, eof = false;
+    uint32_t             ii, count, snaplen, skip, clone_count;
+    sai_status_t         status = SAI_STATUS_SUCCESS;
+
+    if (NULL == in_path) {
+        STUB_LOG_ERR("NULL in path param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (NULL == (in = fopen(in_path, "rb"))) {
+        STUB_LOG_ERR("Failed to open %s\n", in_path);
+        return SAI_STATUS_FAILURE;
+    }
+
+    if (1 != fread(&file_header, sizeof(file_header), 1, in)) {
+        STUB_LOG_ERR("Short pcap file %s\n", in_path);
+        fclose(in);
+        return SAI_STATUS_FAILURE;
+    }
+
+    swapped = (__builtin_bswap32(PCAP_MAGIC_USEC) == file_header.magic) ||
+              (__builtin_bswap32(PCAP_MAGIC_NSEC) == file_header.magic);
+    if (swapped) {
+        file_header.magic    = __builtin_bswap32(file_header.magic);
+        file_header.linktype = __builtin_bswap32(file_header.linktype);
+    }
+
+    if (((PCAP_MAGIC_USEC != file_header.magic) && (PCAP_MAGIC_NSEC != file_header.magic)) ||
+        (PCAP_LINKTYPE_ETHERNET != file_header.linktype)) {
+        STUB_LOG_ERR("%s is not an Ethernet pcap file\n", in_path);
+        fclose(in);
+        return SAI_STATUS_FAILURE;
+    }
+
+    if (NULL == (buffers = malloc(STUB_DATAPLANE_BURST * DATAPLANE_BUFFER_SIZE))) {
+        fclose(in);
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    if (NULL != out_path) {
+        /* Output keeps the input time resolution, in host byte order */
+        file_header.version_major = 2;
+        file_header.version_minor = 4;
+        file_header.thiszone      = 0;
+        file_header.sigfigs       = 0;
+        file_header.snaplen       = STUB_DATAPLANE_MAX_FRAME + VLAN_HDR_LEN + STUB_MIRROR_MAX_HEADER;
+        if ((NULL == (out = fopen(out_path, "wb"))) ||
+            (1 != fwrite(&file_header, sizeof(file_header), 1, out))) {
+            STUB_LOG_ERR("Failed to write %s\n", out_path);
+            status = SAI_STATUS_FAILURE;
+            eof    = true;
+        }
+    }
+
+    while (!eof) {
+        for (count = 0; count < STUB_DATAPLANE_BURST; count++) {
+            if (1 != fread(&records[count], sizeof(records[count]), 1, in)) {
+                eof = true;
+                break;
+            }
+            if (swapped) {
+                records[count].ts_sec   = __builtin_bswap32(records[count].ts_sec);
+                records[count].ts_frac  = __builtin_bswap32(records[count].ts_frac);
+                records[count].incl_len = __builtin_bswap32(records[count].incl_len);
+                records[count].orig_len = __builtin_bswap32(records[count].orig_len);
+            }
+
+            /* Oversized frames are cut to the buffer */
+            snaplen = records[count].incl_len;
+            skip    = 0;
+            if (snaplen > STUB_DATAPLANE_MAX_FRAME) {
+                skip    = snaplen - STUB_DATAPLANE_MAX_FRAME;
+                snaplen = STUB_DATAPLANE_MAX_FRAME;
+            }
+
+            packets[count].data     = buffers + count * DATAPLANE_BUFFER_SIZE + STUB_DATAPLANE_HEADROOM;
+            packets[count].length   = snaplen;
+            packets[count].headroom = STUB_DATAPLANE_HEADROOM;
+            packets[count].in_port  = in_port;
+
+            if (((0 != snaplen) && (1 != fread(packets[count].data, snaplen, 1, in))) ||
+                ((0 != skip) && (0 != fseek(in, skip, SEEK_CUR)))) {
+                STUB_LOG_ERR("Truncated pcap file %s\n", in_path);
+                eof = true;
+                break;
+            }
+        }
+
+        clone_count = dataplane_mirror(true, count, packets, 0, clones);
+        stub_dataplane_process_burst(count, packets);
+        clone_count = dataplane_mirror(false, count, packets, clone_count, clones);
+        db_deliver_hostif_traps(count, packets);
+
+        for (ii = 0; ii < count; ii++) {
+            if ((NULL != out) && dataplane_is_forwarded(packets[ii].packet_action)) {
+                if (!pcap_write_record(out, &records[ii], &packets[ii])) {
+                    STUB_LOG_ERR("Failed to write %s\n", out_path);
+                    status = SAI_STATUS_FAILURE;
+                    eof    = true;
+                    break;
+                }
+                __atomic_fetch_add(&dataplane_stats.tx_packets, 1, __ATOMIC_RELAXED);
+            }
+        }
+
+        for (ii = 0; (NULL != out) && (SAI_STATUS_SUCCESS == status) && (ii < clone_count); ii++) {
+            if (!pcap_write_clone(out, &records[clones[ii].packet_index], &clones[ii])) {
+                STUB_LOG_ERR("Failed to write %s\n", out_path);
+                status = SAI_STATUS_FAILURE;
+                eof    = true;
+                break;
+            }
+            __atomic_fetch_add(&dataplane_stats.tx_packets, 1, __ATOMIC_RELAXED);
+        }
+        stub_mirror_release(clone_count, clones);
+    }
+
+    free(buffers);
+    fclose(in);
+    if ((NULL != out) && (0 != fclose(out))) {
+        status = SAI_STATUS_FAILURE;
+    }
+
+    return status;
+}
+
+/*
+ * Routine Description:
+ *    Read the data plane counters
+ *
+ * Arguments:
+ *    [out] stats - counters
+ */
+void stub_dataplane_get_stats(_Out_ stub_dataplane_stats_t *stats)
+{
+    stats->rx_packets = __atomic_load_n(&dataplane_stats.rx_packets, __ATOMIC_RELAXED);
+    stats->tx_packets = __atomic_load_n(&dataplane_stats.tx_packets, __ATOMIC_RELAXED);
+    stats->routed     = __atomic_load_n(&dataplane_stats.routed, __ATOMIC_RELAXED);
+    stats->bridged    = __atomic_load_n(&dataplane_stats.bridged, __ATOMIC_RELAXED);
+    stats->flooded    = __atomic_load_n(&dataplane_stats.flooded, __ATOMIC_RELAXED);
+    stats->trapped    = __atomic_load_n(&dataplane_stats.trapped, __ATOMIC_RELAXED);
+    stats->dropped    = __atomic_load_n(&dataplane_stats.dropped, __ATOMIC_RELAXED);
+    stats->mirrored   = __atomic_load_n(&dataplane_stats.mirrored, __ATOMIC_RELAXED);
+}
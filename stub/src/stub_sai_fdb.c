@@ -74,6 +74,117 @@ static const sai_vendor_attribute_entry_t fdb_vendor_attribs[] = {
       stub_fdb_action_get, NULL,
       stub_fdb_action_set, NULL }
 };
+/* State DB *************/
+#define FDB_HASH_BUCKETS 4096
+
+typedef struct _stub_fdb_db_entry_t {
+    sai_fdb_entry_t              key;
+    sai_int32_t                  type;
+    sai_object_id_t              port;
+    sai_int32_t                  action;
+    struct _stub_fdb_db_entry_t *next;
+} stub_fdb_db_entry_t;
+
+static stub_fdb_db_entry_t *fdb_db[FDB_HASH_BUCKETS];
+/* Learning/config writers are exclusive, lookups and attribute gets are shared */
+static pthread_rwlock_t     fdb_db_lock = STUB_RWLOCK_INITIALIZER;
+
+static uint32_t fdb_hash(_In_ const sai_fdb_entry_t *fdb_entry)
+{
+    uint32_t hash = 2166136261u;
+    uint32_t ii;
+
+    for (ii = 0; ii < sizeof(sai_mac_t); ii++) {
+        hash = (hash ^ fdb_entry->mac_address[ii]) * 16777619u;
+    }
+    hash = (hash ^ (fdb_entry->vlan_id & 0xFF)) * 16777619u;
+    hash = (hash ^ (fdb_entry->vlan_id >> 8)) * 16777619u;
+
+    return hash % FDB_HASH_BUCKETS;
+}
+
+static bool fdb_key_equal(_In_ const sai_fdb_entry_t *a, _In_ const sai_fdb_entry_t *b)
+{
+    return (a->vlan_id == b->vlan_id) && (0 == memcmp(a->mac_address, b->mac_address, sizeof(sai_mac_t)));
+}
+
+/* Caller must hold fdb_db_lock */
+static stub_fdb_db_entry_t* db_find_fdb_entry(_In_ const sai_fdb_entry_t *fdb_entry)
+{
+    stub_fdb_db_entry_t *entry;
+
+    for (entry = fdb_db[fdb_hash(fdb_entry)]; NULL != entry; entry = entry->next) {
+        if (fdb_key_equal(&entry->key, fdb_entry)) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+static sai_status_t db_get_fdb_entry(_In_ const sai_fdb_entry_t *fdb_entry, _Out_ stub_fdb_db_entry_t **entry)
+{
+    if (NULL == (*entry = db_find_fdb_entry(fdb_entry))) {
+        STUB_LOG_ERR("FDB entry not found\n");
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+void db_init_fdb()
+{
+    stub_fdb_db_entry_t *entry, *next;
+    uint32_t             ii;
+
+    pthread_rwlock_wrlock(&fdb_db_lock);
+
+    for (ii = 0; ii < FDB_HASH_BUCKETS; ii++) {
+        for (entry = fdb_db[ii]; NULL != entry; entry = next) {
+            next = entry->next;
+            free(entry);
+        }
+        fdb_db[ii] = NULL;
+    }
+
+    pthread_rwlock_unlock(&fdb_db_lock);
+}
+
+/*
+ * Routine Description:
+ *    Resolve the bridge port of a MAC in a VLAN
+ *
+ * Arguments:
+ *    [in] fdb_entry - MAC and VLAN
+ *    [out] port_id - port of the entry
+ *    [out] action - packet action of the entry
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    SAI_STATUS_ITEM_NOT_FOUND if the MAC is unknown
+ */
+sai_status_t db_lookup_fdb(_In_ const sai_fdb_entry_t *fdb_entry,
+                           _Out_ sai_object_id_t      *port_id,
+                           _Out_ sai_int32_t          *action)
+{
+    stub_fdb_db_entry_t *entry;
+    sai_status_t         status = SAI_STATUS_ITEM_NOT_FOUND;
+
+    pthread_rwlock_rdlock(&fdb_db_lock);
+
+    if (NULL != (entry = db_find_fdb_entry(fdb_entry))) {
+        *port_id = entry->port;
+        *action  = entry->action;
+        status   = SAI_STATUS_SUCCESS;
+    }
+
+    pthread_rwlock_unlock(&fdb_db_lock);
+
+    return status;
+}
+
+/*************************/
+
 static void fdb_key_to_str(_In_ const sai_fdb_entry_t* fdb_entry, _Out_ char *key_str)
 {
     snprintf(key_str, MAX_KEY_STR_LEN, "fdb entry mac [%02x:%02x:%02x:%02x:%02x:%02x] vlan %u",
@@ -105,9 +216,10 @@ sai_status_t stub_create_fdb_entry(_In_ const sai_fdb_entry_t* fdb_entry,
 {
     sai_status_t                 status;
     const sai_attribute_value_t *type, *action, *port;
-    uint32_t                     type_index, action_index, port_index, port_id;
+    uint32_t                     type_index, action_index, port_index, port_id, bucket;
     char                         key_str[MAX_KEY_STR_LEN];
     char                         list_str[MAX_LIST_VALUE_STR_LEN];
+    stub_fdb_db_entry_t         *entry;
 
     STUB_LOG_ENTER();
 
@@ -142,6 +254,31 @@ sai_status_t stub_create_fdb_entry(_In_ const sai_fdb_entry_t* fdb_entry,
         return status;
     }
 
+    if (NULL == (entry = calloc(1, sizeof(*entry)))) {
+        STUB_LOG_ERR("Failed to allocate FDB entry\n");
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    entry->key    = *fdb_entry;
+    entry->type   = type->s32;
+    entry->port   = port->oid;
+    entry->action = action->s32;
+    bucket        = fdb_hash(fdb_entry);
+
+    pthread_rwlock_wrlock(&fdb_db_lock);
+
+    if (NULL != db_find_fdb_entry(fdb_entry)) {
+        pthread_rwlock_unlock(&fdb_db_lock);
+        free(entry);
+        STUB_LOG_ERR("FDB entry %s already exists\n", key_str);
+        return SAI_STATUS_ITEM_ALREADY_EXISTS;
+    }
+
+    entry->next    = fdb_db[bucket];
+    fdb_db[bucket] = entry;
+
+    pthread_rwlock_unlock(&fdb_db_lock);
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -159,7 +296,8 @@ sai_status_t stub_create_fdb_entry(_In_ const sai_fdb_entry_t* fdb_entry,
  */
 sai_status_t stub_remove_fdb_entry(_In_ const sai_fdb_entry_t* fdb_entry)
 {
-    char key_str[MAX_KEY_STR_LEN];
+    char                  key_str[MAX_KEY_STR_LEN];
+    stub_fdb_db_entry_t **link, *entry;
 
     STUB_LOG_ENTER();
 
@@ -171,6 +309,26 @@ sai_status_t stub_remove_fdb_entry(_In_ const sai_fdb_entry_t* fdb_entry)
     fdb_key_to_str(fdb_entry, key_str);
     STUB_LOG_NTC("Remove FDB entry %s\n", key_str);
 
+    pthread_rwlock_wrlock(&fdb_db_lock);
+
+    for (link = &fdb_db[fdb_hash(fdb_entry)]; NULL != *link; link = &(*link)->next) {
+        if (fdb_key_equal(&(*link)->key, fdb_entry)) {
+            break;
+        }
+    }
+
+    if (NULL == (entry = *link)) {
+        pthread_rwlock_unlock(&fdb_db_lock);
+        STUB_LOG_ERR("FDB entry %s not found\n", key_str);
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    *link = entry->next;
+
+    pthread_rwlock_unlock(&fdb_db_lock);
+
+    free(entry);
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -191,6 +349,7 @@ sai_status_t stub_set_fdb_entry_attribute(_In_ const sai_fdb_entry_t* fdb_entry,
 {
     const sai_object_key_t key = {.fdb_entry = fdb_entry };
     char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
 
     STUB_LOG_ENTER();
 
@@ -200,14 +359,28 @@ sai_status_t stub_set_fdb_entry_attribute(_In_ const sai_fdb_entry_t* fdb_entry,
     }
 
     fdb_key_to_str(fdb_entry, key_str);
-    return sai_set_attribute(&key, key_str, fdb_attribs, fdb_vendor_attribs, attr);
+
+    pthread_rwlock_wrlock(&fdb_db_lock);
+    status = sai_set_attribute(&key, key_str, fdb_attribs, fdb_vendor_attribs, attr);
+    pthread_rwlock_unlock(&fdb_db_lock);
+
+    return status;
 }
 
 /* Set FDB entry type [sai_fdb_entry_type_t] */
 sai_status_t stub_fdb_type_set(_In_ const sai_object_key_t *key, _In_ const sai_attribute_value_t *value, void *arg)
 {
+    sai_status_t         status;
+    stub_fdb_db_entry_t *entry;
+
     STUB_LOG_ENTER();
 
+    if (SAI_STATUS_SUCCESS != (status = db_get_fdb_entry(key->fdb_entry, &entry))) {
+        return status;
+    }
+
+    entry->type = value->s32;
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -217,8 +390,9 @@ sai_status_t stub_fdb_type_set(_In_ const sai_object_key_t *key, _In_ const sai_
  * SAI LAG object id and etc. on. */
 sai_status_t stub_fdb_port_set(_In_ const sai_object_key_t *key, _In_ const sai_attribute_value_t *value, void *arg)
 {
-    sai_status_t status;
-    uint32_t     port_id;
+    sai_status_t         status;
+    uint32_t             port_id;
+    stub_fdb_db_entry_t *entry;
 
     STUB_LOG_ENTER();
 
@@ -226,6 +400,12 @@ sai_status_t stub_fdb_port_set(_In_ const sai_object_key_t *key, _In_ const sai_
         return status;
     }
 
+    if (SAI_STATUS_SUCCESS != (status = db_get_fdb_entry(key->fdb_entry, &entry))) {
+        return status;
+    }
+
+    entry->port = value->oid;
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -233,8 +413,17 @@ sai_status_t stub_fdb_port_set(_In_ const sai_object_key_t *key, _In_ const sai_
 /* Set FDB entry packet action [sai_packet_action_t] */
 sai_status_t stub_fdb_action_set(_In_ const sai_object_key_t *key, _In_ const sai_attribute_value_t *value, void *arg)
 {
+    sai_status_t         status;
+    stub_fdb_db_entry_t *entry;
+
     STUB_LOG_ENTER();
 
+    if (SAI_STATUS_SUCCESS != (status = db_get_fdb_entry(key->fdb_entry, &entry))) {
+        return status;
+    }
+
+    entry->action = value->s32;
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -258,6 +447,7 @@ sai_status_t stub_get_fdb_entry_attribute(_In_ const sai_fdb_entry_t* fdb_entry,
 {
     const sai_object_key_t key = { .fdb_entry = fdb_entry };
     char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
 
     STUB_LOG_ENTER();
 
@@ -267,7 +457,12 @@ sai_status_t stub_get_fdb_entry_attribute(_In_ const sai_fdb_entry_t* fdb_entry,
     }
 
     fdb_key_to_str(fdb_entry, key_str);
-    return sai_get_attributes(&key, key_str, fdb_attribs, fdb_vendor_attribs, attr_count, attr_list);
+
+    pthread_rwlock_rdlock(&fdb_db_lock);
+    status = sai_get_attributes(&key, key_str, fdb_attribs, fdb_vendor_attribs, attr_count, attr_list);
+    pthread_rwlock_unlock(&fdb_db_lock);
+
+    return status;
 }
 
 /* Get FDB entry type [sai_fdb_entry_type_t] */
@@ -277,9 +472,16 @@ sai_status_t stub_fdb_type_get(_In_ const sai_object_key_t   *key,
                                _Inout_ vendor_cache_t        *cache,
                                void                          *arg)
 {
+    sai_status_t         status;
+    stub_fdb_db_entry_t *entry;
+
     STUB_LOG_ENTER();
 
-    value->s32 = SAI_FDB_ENTRY_STATIC;
+    if (SAI_STATUS_SUCCESS != (status = db_get_fdb_entry(key->fdb_entry, &entry))) {
+        return status;
+    }
+
+    value->s32 = entry->type;
 
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
@@ -288,9 +490,7 @@ sai_status_t stub_fdb_type_get(_In_ const sai_object_key_t   *key,
 /* FDB entry port id [sai_object_id_t] (MANDATORY_ON_CREATE|CREATE_AND_SET)
  * The port id here can refer to a generic port object such as SAI port object id,
  * SAI LAG object id and etc. on.
- * Port 0 is returned for entries with action = drop or action = trap
- * Since port is irrelevant for these actions, even if actual port is set
- * In case the action is changed from drop/trap to forward/log, need to also set port
+ * The port set on the entry is returned whatever its packet action
  */
 sai_status_t stub_fdb_port_get(_In_ const sai_object_key_t   *key,
                                _Inout_ sai_attribute_value_t *value,
@@ -298,14 +498,17 @@ sai_status_t stub_fdb_port_get(_In_ const sai_object_key_t   *key,
                                _Inout_ vendor_cache_t        *cache,
                                void                          *arg)
 {
-    sai_status_t status;
+    sai_status_t         status;
+    stub_fdb_db_entry_t *entry;
 
     STUB_LOG_ENTER();
 
-    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_PORT, 1, &value->oid))) {
+    if (SAI_STATUS_SUCCESS != (status = db_get_fdb_entry(key->fdb_entry, &entry))) {
         return status;
     }
 
+    value->oid = entry->port;
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -317,9 +520,16 @@ sai_status_t stub_fdb_action_get(_In_ const sai_object_key_t   *key,
                                  _Inout_ vendor_cache_t        *cache,
                                  void                          *arg)
 {
+    sai_status_t         status;
+    stub_fdb_db_entry_t *entry;
+
     STUB_LOG_ENTER();
 
-    value->s32 = SAI_PACKET_ACTION_FORWARD;
+    if (SAI_STATUS_SUCCESS != (status = db_get_fdb_entry(key->fdb_entry, &entry))) {
+        return status;
+    }
+
+    value->s32 = entry->action;
 
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
@@ -340,9 +550,11 @@ sai_status_t stub_fdb_action_get(_In_ const sai_object_key_t   *key,
 sai_status_t stub_flush_fdb_entries(_In_ uint32_t attr_count, _In_ const sai_attribute_t *attr_list)
 {
     sai_status_t                 status;
-    const sai_attribute_value_t *port, *vlan, *type;
+    const sai_attribute_value_t *port = NULL, *vlan = NULL, *type = NULL;
     uint32_t                     port_index, vlan_index, type_index;
-    uint32_t                     port_id;
+    uint32_t                     port_id, ii;
+    sai_int32_t                  entry_type = SAI_FDB_ENTRY_DYNAMIC;
+    stub_fdb_db_entry_t        **link, *entry;
 
     STUB_LOG_ENTER();
 
@@ -353,20 +565,44 @@ sai_status_t stub_flush_fdb_entries(_In_ uint32_t attr_count, _In_ const sai_att
         if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(port->oid, SAI_OBJECT_TYPE_PORT, &port_id))) {
             return status;
         }
+    } else {
+        port = NULL;
     }
 
-    if (SAI_STATUS_SUCCESS ==
+    if (SAI_STATUS_SUCCESS !=
         (status =
              find_attrib_in_list(attr_count, attr_list, SAI_FDB_FLUSH_ATTR_VLAN_ID,
                                  &vlan, &vlan_index))) {
+        vlan = NULL;
     }
 
     if (SAI_STATUS_SUCCESS ==
         (status =
              find_attrib_in_list(attr_count, attr_list, SAI_FDB_FLUSH_ATTR_ENTRY_TYPE,
                                  &type, &type_index))) {
+        entry_type = (SAI_FDB_FLUSH_ENTRY_STATIC == type->s32) ? SAI_FDB_ENTRY_STATIC : SAI_FDB_ENTRY_DYNAMIC;
+    } else {
+        type = NULL;
+    }
+
+    pthread_rwlock_wrlock(&fdb_db_lock);
+
+    for (ii = 0; ii < FDB_HASH_BUCKETS; ii++) {
+        link = &fdb_db[ii];
+        while (NULL != (entry = *link)) {
+            if (((NULL == port) || (port->oid == entry->port)) &&
+                ((NULL == vlan) || (vlan->u16 == entry->key.vlan_id)) &&
+                ((NULL == type) || (entry_type == entry->type))) {
+                *link = entry->next;
+                free(entry);
+                continue;
+            }
+            link = &entry->next;
+        }
     }
 
+    pthread_rwlock_unlock(&fdb_db_lock);
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
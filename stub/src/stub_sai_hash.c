@@ -0,0 +1,924 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#include "sai.h"
+#include "stub_sai.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_hash.h"
+#include "stub_sai_udf.h"
+#include "assert.h"
+
+#undef  __MODULE__
+#define __MODULE__ SAI_HASH
+
+static const sai_attribute_entry_t hash_attribs[] = {
+    { SAI_HASH_NATIVE_FIELD_LIST, false, true, true, true,
+      "Hash native fields", SAI_ATTR_VAL_TYPE_S32LIST },
+    { SAI_HASH_UDF_GROUP_LIST, false, true, true, true,
+      "Hash UDF groups", SAI_ATTR_VAL_TYPE_OBJLIST },
+    { END_FUNCTIONALITY_ATTRIBS_ID, false, false, false, false,
+      "", SAI_ATTR_VAL_TYPE_UNDETERMINED }
+};
+
+sai_status_t stub_hash_fields_get(_In_ const sai_object_key_t   *key,
+                                  _Inout_ sai_attribute_value_t *value,
+                                  _In_ uint32_t                  attr_index,
+                                  _Inout_ vendor_cache_t        *cache,
+                                  void                          *arg);
+sai_status_t stub_hash_fields_set(_In_ const sai_object_key_t      *key,
+                                  _In_ const sai_attribute_value_t *value,
+                                  void                             *arg);
+sai_status_t stub_hash_udf_groups_get(_In_ const sai_object_key_t   *key,
+                                      _Inout_ sai_attribute_value_t *value,
+                                      _In_ uint32_t                  attr_index,
+                                      _Inout_ vendor_cache_t        *cache,
+                                      void                          *arg);
+sai_status_t stub_hash_udf_groups_set(_In_ const sai_object_key_t      *key,
+                                      _In_ const sai_attribute_value_t *value,
+                                      void                             *arg);
+
+static const sai_vendor_attribute_entry_t hash_vendor_attribs[] = {
+    { SAI_HASH_NATIVE_FIELD_LIST,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_hash_fields_get, NULL,
+      stub_hash_fields_set, NULL },
+    { SAI_HASH_UDF_GROUP_LIST,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_hash_udf_groups_get, NULL,
+      stub_hash_udf_groups_set, NULL },
+};
+
+/* State DB *************/
+#define MAX_HASHES          16
+#define HASH_FIELD_BIT(f)   (1u << (f))
+#define HASH_UDF_GROUPS     4
+/* in port, MACs, ethertype, VLAN, outer and inner addresses, protocol, L4
+ * ports, UDF groups */
+#define HASH_KEY_MAX        (4 + 2 * 6 + 2 + 2 + 4 * 16 + 1 + 2 * 2 + HASH_UDF_GROUPS * STUB_UDF_GROUP_MAX_LENGTH)
+#define HASH_CRC32C_POLY    0x82F63B78
+
+#define ETHERTYPE_VLAN      0x8100
+#define ETHERTYPE_IPV4      0x0800
+#define ETHERTYPE_IPV6      0x86DD
+#define IP_PROTO_IPIP       4
+#define IP_PROTO_TCP        6
+#define IP_PROTO_UDP        17
+#define IP_PROTO_IPV6       41
+#define IPV4_HDR_LEN        20
+#define IPV6_HDR_LEN        40
+
+/* UDF groups of a hash are packed a byte each, group index + 1, the first
+ * group in the low byte and 0 past the last */
+typedef struct _stub_hash_t {
+    bool     is_used;
+    uint32_t fields;
+    uint32_t udf_groups;
+    /* engines of the switch set to the hash */
+    uint32_t ref_count;
+} stub_hash_t;
+
+/* What the data plane hashes with. Fields are read without the lock, a
+ * frame hashed during a change sees the old or the new value of each */
+typedef struct _stub_hash_engine_t {
+    uint32_t    hash;
+    uint32_t    fields;
+    uint32_t    udf_groups;
+    sai_int32_t algorithm;
+    uint32_t    seed;
+} stub_hash_engine_t;
+
+static stub_hash_t        hash_db[MAX_HASHES];
+static stub_hash_engine_t hash_engines[STUB_HASH_TYPE_MAX];
+static pthread_rwlock_t   hash_db_lock = STUB_RWLOCK_INITIALIZER;
+static uint32_t           hash_crc32c_table[256];
+static uint32_t (*hash_crc32c)(uint32_t crc, const uint8_t *data, uint32_t length);
+static __thread uint32_t  hash_random_state;
+
+static const uint32_t     hash_default_fields[STUB_HASH_TYPE_MAX] = {
+    HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_SRC_IP) | HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_DST_IP) |
+    HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_IP_PROTOCOL) | HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_L4_SRC_PORT) |
+    HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_L4_DST_PORT),
+    HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_SRC_MAC) | HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_DST_MAC) |
+    HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_IN_PORT) | HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_ETHERTYPE),
+};
+
+static inline uint16_t hash_read16(_In_ const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t hash_crc32c_soft(uint32_t crc, const uint8_t *data, uint32_t length)
+{
+    uint32_t ii;
+
+    for (ii = 0; ii < length; ii++) {
+        crc = hash_crc32c_table[(crc ^ data[ii]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+#if defined(__x86_64__)
+/* Same CRC as hash_crc32c_soft, eight bytes per instruction */
+__attribute__((target("sse4.2")))
+static uint32_t hash_crc32c_sse42(uint32_t crc, const uint8_t *data, uint32_t length)
+{
+    uint64_t crc64 = crc, word;
+    uint32_t ii;
+
+    for (ii = 0; ii + sizeof(word) <= length; ii += sizeof(word)) {
+        memcpy(&word, data + ii, sizeof(word));
+        crc64 = __builtin_ia32_crc32di(crc64, word);
+    }
+
+    crc = (uint32_t)crc64;
+    for (; ii < length; ii++) {
+        crc = __builtin_ia32_crc32qi(crc, data[ii]);
+    }
+
+    return crc;
+}
+#endif
+
+static void hash_crc32c_init(void)
+{
+    uint32_t ii, jj, crc;
+
+    for (ii = 0; ii < 256; ii++) {
+        crc = ii;
+        for (jj = 0; jj < 8; jj++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? HASH_CRC32C_POLY : 0);
+        }
+        hash_crc32c_table[ii] = crc;
+    }
+
+    hash_crc32c = hash_crc32c_soft;
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("sse4.2")) {
+        hash_crc32c = hash_crc32c_sse42;
+    }
+#endif
+}
+
+/* Append the fields of an IP header the hash selects. l3 holds l3_len bytes */
+static uint32_t hash_key_ip(_In_ uint32_t       fields,
+                            _In_ uint16_t       ethertype,
+                            _In_ const uint8_t *l3,
+                            _In_ uint32_t       l3_len,
+                            _Out_ uint8_t      *key)
+{
+    const uint8_t *inner = NULL;
+    uint32_t       length = 0, addr_len, ihl, inner_len = 0;
+    uint8_t        proto;
+    bool           first_fragment = true;
+    uint16_t       inner_ethertype = 0;
+
+    if ((ETHERTYPE_IPV4 == ethertype) && (l3_len >= IPV4_HDR_LEN) && (4 == (l3[0] >> 4)) &&
+        ((ihl = (l3[0] & 0x0F) * 4) >= IPV4_HDR_LEN) && (l3_len >= ihl)) {
+        addr_len       = 4;
+        proto          = l3[9];
+        first_fragment = (0 == (hash_read16(l3 + 6) & 0x1FFF));
+    } else if ((ETHERTYPE_IPV6 == ethertype) && (l3_len >= IPV6_HDR_LEN) && (6 == (l3[0] >> 4))) {
+        addr_len = 16;
+        proto    = l3[6];
+        ihl      = IPV6_HDR_LEN;
+    } else {
+        return 0;
+    }
+
+    if (fields & HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_SRC_IP)) {
+        memcpy(key + length, l3 + ((4 == addr_len) ? 12 : 8), addr_len);
+        length += addr_len;
+    }
+    if (fields & HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_DST_IP)) {
+        memcpy(key + length, l3 + ((4 == addr_len) ? 16 : 24), addr_len);
+        length += addr_len;
+    }
+    if (fields & HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_IP_PROTOCOL)) {
+        key[length++] = proto;
+    }
+
+    /* L4 ports only on the first fragment */
+    if (((IP_PROTO_TCP == proto) || (IP_PROTO_UDP == proto)) && first_fragment && (l3_len >= ihl + 4)) {
+        if (fields & HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_L4_SRC_PORT)) {
+            memcpy(key + length, l3 + ihl, 2);
+            length += 2;
+        }
+        if (fields & HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_L4_DST_PORT)) {
+            memcpy(key + length, l3 + ihl + 2, 2);
+            length += 2;
+        }
+    }
+
+    /* Inner addresses of IP in IP tunnels */
+    if (first_fragment && (l3_len > ihl)) {
+        inner     = l3 + ihl;
+        inner_len = l3_len - ihl;
+        if ((IP_PROTO_IPIP == proto) && (inner_len >= IPV4_HDR_LEN) && (4 == (inner[0] >> 4))) {
+            inner_ethertype = ETHERTYPE_IPV4;
+        } else if ((IP_PROTO_IPV6 == proto) && (inner_len >= IPV6_HDR_LEN) && (6 == (inner[0] >> 4))) {
+            inner_ethertype = ETHERTYPE_IPV6;
+        }
+    }
+
+    if (0 != inner_ethertype) {
+        addr_len = (ETHERTYPE_IPV4 == inner_ethertype) ? 4 : 16;
+        if (fields & HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_INNER_SRC_IP)) {
+            memcpy(key + length, inner + ((4 == addr_len) ? 12 : 8), addr_len);
+            length += addr_len;
+        }
+        if (fields & HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_INNER_DST_IP)) {
+            memcpy(key + length, inner + ((4 == addr_len) ? 16 : 24), addr_len);
+            length += addr_len;
+        }
+    }
+
+    return length;
+}
+
+/* Hash key of the selected fields a frame carries and the bytes of the UDF
+ * groups. Returns the key length */
+static uint32_t hash_key_build(_In_ uint32_t             fields,
+                               _In_ uint32_t             udf_groups,
+                               _In_ const stub_packet_t *packet,
+                               _In_ uint32_t             l3_offset,
+                               _In_ uint16_t             ethertype,
+                               _In_ sai_vlan_id_t        vlan_id,
+                               _Out_ uint8_t            *key)
+{
+    const stub_object_id_t *port = (const stub_object_id_t*)&packet->in_port;
+    stub_udf_layout_t       layout;
+    uint32_t                length = 0;
+
+    if (fields & HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_IN_PORT)) {
+        memcpy(key + length, &port->data, sizeof(uint32_t));
+        length += sizeof(uint32_t);
+    }
+    if (fields & HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_SRC_MAC)) {
+        memcpy(key + length, packet->data + 6, 6);
+        length += 6;
+    }
+    if (fields & HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_DST_MAC)) {
+        memcpy(key + length, packet->data, 6);
+        length += 6;
+    }
+    if (fields & HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_ETHERTYPE)) {
+        key[length++] = (uint8_t)(ethertype >> 8);
+        key[length++] = (uint8_t)ethertype;
+    }
+    if (fields & HASH_FIELD_BIT(SAI_NATIVE_HASH_FIELD_VLAN_ID)) {
+        key[length++] = (uint8_t)(vlan_id >> 8);
+        key[length++] = (uint8_t)vlan_id;
+    }
+
+    if (packet->length > l3_offset) {
+        length += hash_key_ip(fields, ethertype, packet->data + l3_offset, packet->length - l3_offset, key + length);
+    }
+
+    if (0 != udf_groups) {
+        db_udf_parse(packet, &layout);
+        stub_rcu_read_lock();
+        for (; 0 != udf_groups; udf_groups >>= 8) {
+            length += db_udf_extract((udf_groups & 0xFF) - 1, packet, &layout, true, key + length);
+        }
+        stub_rcu_read_unlock();
+    }
+
+    return length;
+}
+
+static uint32_t hash_xor(_In_ uint32_t seed, _In_ const uint8_t *key, _In_ uint32_t length)
+{
+    uint32_t hash = seed, word, ii;
+
+    for (ii = 0; ii < length; ii += sizeof(word)) {
+        memcpy(&word, key + ii, sizeof(word));
+        hash ^= word;
+    }
+
+    return hash ^ (hash >> 16);
+}
+
+static uint32_t hash_random(_In_ uint32_t seed)
+{
+    uint32_t state = hash_random_state;
+
+    if (0 == state) {
+        state = (seed ^ (uint32_t)(uintptr_t)&hash_random_state) | 1;
+    }
+
+    /* xorshift32 */
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    return hash_random_state = state;
+}
+
+/*
+ * Routine Description:
+ *    Hash of a parsed frame with the current configuration of an engine
+ *
+ * Arguments:
+ *    [in] type - STUB_HASH_TYPE_ECMP or STUB_HASH_TYPE_LAG
+ *    [in] packet - frame
+ *    [in] l3_offset - offset of the IP header, past the VLAN tag
+ *    [in] ethertype - ethertype of the IP header
+ *    [in] vlan_id - VLAN of the frame
+ *
+ * Return Values:
+ *    hash
+ */
+uint32_t db_hash_packet(_In_ sai_int32_t                  type,
+                        _In_ const struct _stub_packet_t *packet,
+                        _In_ uint32_t                     l3_offset,
+                        _In_ uint16_t                     ethertype,
+                        _In_ sai_vlan_id_t                vlan_id)
+{
+    const stub_hash_engine_t *engine = &hash_engines[type];
+    uint8_t                   key[HASH_KEY_MAX + sizeof(uint64_t)];
+    uint32_t                  fields     = __atomic_load_n(&engine->fields, __ATOMIC_RELAXED);
+    uint32_t                  udf_groups = __atomic_load_n(&engine->udf_groups, __ATOMIC_RELAXED);
+    uint32_t                  seed       = __atomic_load_n(&engine->seed, __ATOMIC_RELAXED);
+    uint32_t                  length;
+
+    switch (__atomic_load_n(&engine->algorithm, __ATOMIC_RELAXED)) {
+    case SAI_HASH_ALGORITHM_RANDOM:
+        return hash_random(seed);
+
+    case SAI_HASH_ALGORITHM_XOR:
+        length = hash_key_build(fields, udf_groups, packet, l3_offset, ethertype, vlan_id, key);
+        /* whole words, the pad is zero */
+        memset(key + length, 0, sizeof(uint32_t));
+        return hash_xor(seed, key, length);
+
+    default:
+        length = hash_key_build(fields, udf_groups, packet, l3_offset, ethertype, vlan_id, key);
+        return ~hash_crc32c(~seed, key, length);
+    }
+}
+
+/* Parse the Ethernet and VLAN headers for stub_hash_calculate */
+static void hash_parse_l2(_In_ const stub_packet_t *packet,
+                          _Out_ uint32_t           *l3_offset,
+                          _Out_ uint16_t           *ethertype,
+                          _Out_ sai_vlan_id_t      *vlan_id)
+{
+    *l3_offset = 14;
+    *ethertype = (packet->length >= 14) ? hash_read16(packet->data + 12) : 0;
+    *vlan_id   = 0;
+
+    if ((ETHERTYPE_VLAN == *ethertype) && (packet->length >= 18)) {
+        *vlan_id   = hash_read16(packet->data + 14) & 0x0FFF;
+        *ethertype = hash_read16(packet->data + 16);
+        *l3_offset = 18;
+    }
+}
+
+/* Caller holds hash_db_lock */
+static sai_status_t hash_db_index(_In_ sai_object_id_t hash_id, _Out_ uint32_t *index)
+{
+    sai_status_t status;
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(hash_id, SAI_OBJECT_TYPE_HASH, index))) {
+        return status;
+    }
+
+    if ((*index >= MAX_HASHES) || (!hash_db[*index].is_used)) {
+        STUB_LOG_ERR("Hash %u does not exist\n", *index);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void hash_key_to_str(_In_ sai_object_id_t hash_id, _Out_ char *key_str)
+{
+    uint32_t hash;
+
+    if (SAI_STATUS_SUCCESS != stub_object_to_type(hash_id, SAI_OBJECT_TYPE_HASH, &hash)) {
+        snprintf(key_str, MAX_KEY_STR_LEN, "invalid hash id");
+    } else {
+        snprintf(key_str, MAX_KEY_STR_LEN, "hash id %u", hash);
+    }
+}
+
+/* Field mask of a native field list */
+static sai_status_t hash_fields_from_list(_In_ const sai_s32_list_t *list, _Out_ uint32_t *fields)
+{
+    uint32_t ii;
+
+    *fields = 0;
+
+    for (ii = 0; ii < list->count; ii++) {
+        if ((list->list[ii] < SAI_NATIVE_HASH_FIELD_SRC_IP) || (list->list[ii] > SAI_NATIVE_HASH_FIELD_IN_PORT)) {
+            STUB_LOG_ERR("Invalid hash field, element %u, value %d\n", ii, list->list[ii]);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        *fields |= HASH_FIELD_BIT(list->list[ii]);
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void hash_udf_groups_unbind(_In_ uint32_t udf_groups)
+{
+    for (; 0 != udf_groups; udf_groups >>= 8) {
+        db_udf_group_unbind((udf_groups & 0xFF) - 1);
+    }
+}
+
+/* Bind the hash UDF groups of a list, all of them or none */
+static sai_status_t hash_udf_groups_bind(_In_ const sai_object_list_t *list, _Out_ uint32_t *udf_groups)
+{
+    sai_status_t status;
+    uint32_t     ii, group, length;
+
+    *udf_groups = 0;
+
+    if (list->count > HASH_UDF_GROUPS) {
+        STUB_LOG_ERR("%u hash UDF groups, up to %u\n", list->count, HASH_UDF_GROUPS);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    for (ii = 0; ii < list->count; ii++) {
+        if (SAI_STATUS_SUCCESS !=
+            (status = db_udf_group_bind(list->list[ii], SAI_UDF_GROUP_HASH, &group, &length))) {
+            STUB_LOG_ERR("Invalid hash UDF group, element %u\n", ii);
+            hash_udf_groups_unbind(*udf_groups);
+            *udf_groups = 0;
+            return status;
+        }
+        *udf_groups |= (group + 1) << (8 * ii);
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+void db_init_hash(void)
+{
+    uint32_t type;
+
+    hash_crc32c_init();
+
+    pthread_rwlock_wrlock(&hash_db_lock);
+
+    memset(hash_db, 0, sizeof(hash_db));
+
+    /* Hash 0 and 1 are the switch defaults for ECMP and LAG */
+    for (type = 0; type < STUB_HASH_TYPE_MAX; type++) {
+        hash_db[type].is_used   = true;
+        hash_db[type].fields    = hash_default_fields[type];
+        hash_db[type].ref_count = 1;
+        hash_engines[type].hash = type;
+        __atomic_store_n(&hash_engines[type].fields, hash_default_fields[type], __ATOMIC_RELAXED);
+        __atomic_store_n(&hash_engines[type].udf_groups, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&hash_engines[type].algorithm, SAI_HASH_ALGORITHM_CRC, __ATOMIC_RELAXED);
+        __atomic_store_n(&hash_engines[type].seed, 0, __ATOMIC_RELAXED);
+    }
+
+    pthread_rwlock_unlock(&hash_db_lock);
+}
+
+sai_object_id_t db_get_switch_hash(_In_ sai_int32_t type)
+{
+    sai_object_id_t hash_id = SAI_NULL_OBJECT_ID;
+
+    pthread_rwlock_rdlock(&hash_db_lock);
+    stub_create_object(SAI_OBJECT_TYPE_HASH, hash_engines[type].hash, &hash_id);
+    pthread_rwlock_unlock(&hash_db_lock);
+
+    return hash_id;
+}
+
+sai_status_t db_set_switch_hash(_In_ sai_int32_t type, _In_ sai_object_id_t hash_id)
+{
+    stub_hash_engine_t *engine = &hash_engines[type];
+    sai_status_t        status;
+    uint32_t            hash;
+
+    pthread_rwlock_wrlock(&hash_db_lock);
+
+    if (SAI_STATUS_SUCCESS == (status = hash_db_index(hash_id, &hash))) {
+        hash_db[engine->hash].ref_count--;
+        hash_db[hash].ref_count++;
+        engine->hash = hash;
+        __atomic_store_n(&engine->fields, hash_db[hash].fields, __ATOMIC_RELAXED);
+        __atomic_store_n(&engine->udf_groups, hash_db[hash].udf_groups, __ATOMIC_RELAXED);
+    }
+
+    pthread_rwlock_unlock(&hash_db_lock);
+
+    return status;
+}
+
+sai_int32_t db_get_switch_hash_algorithm(_In_ sai_int32_t type)
+{
+    return __atomic_load_n(&hash_engines[type].algorithm, __ATOMIC_RELAXED);
+}
+
+sai_status_t db_set_switch_hash_algorithm(_In_ sai_int32_t type, _In_ sai_int32_t algorithm)
+{
+    switch (algorithm) {
+    case SAI_HASH_ALGORITHM_CRC:
+    case SAI_HASH_ALGORITHM_XOR:
+    case SAI_HASH_ALGORITHM_RANDOM:
+        break;
+
+    default:
+        STUB_LOG_ERR("Invalid hash algorithm %d\n", algorithm);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    __atomic_store_n(&hash_engines[type].algorithm, algorithm, __ATOMIC_RELAXED);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+uint32_t db_get_switch_hash_seed(_In_ sai_int32_t type)
+{
+    return __atomic_load_n(&hash_engines[type].seed, __ATOMIC_RELAXED);
+}
+
+void db_set_switch_hash_seed(_In_ sai_int32_t type, _In_ uint32_t seed)
+{
+    __atomic_store_n(&hash_engines[type].seed, seed, __ATOMIC_RELAXED);
+}
+
+/*
+ * Routine Description:
+ *    @brief Hash a burst of frames the way the data plane does, with the
+ *    current fields, algorithm and seed of one engine
+ *
+ * Arguments:
+ *    @param[in] type - hash engine
+ *    @param[in] count - number of frames
+ *    @param[in] packets - frames, in_port set
+ *    @param[out] hashes - hash of each frame
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_hash_calculate(_In_ stub_hash_type_t     type,
+                                 _In_ uint32_t             count,
+                                 _In_ const stub_packet_t *packets,
+                                 _Out_ uint32_t           *hashes)
+{
+    uint32_t      ii, l3_offset;
+    uint16_t      ethertype;
+    sai_vlan_id_t vlan_id;
+
+    if ((NULL == packets) || (NULL == hashes)) {
+        STUB_LOG_ERR("NULL packets or hashes param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (type >= STUB_HASH_TYPE_MAX) {
+        STUB_LOG_ERR("Invalid hash type %d\n", type);
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    for (ii = 0; ii < count; ii++) {
+        hash_parse_l2(&packets[ii], &l3_offset, &ethertype, &vlan_id);
+        hashes[ii] = db_hash_packet(type, &packets[ii], l3_offset, ethertype, vlan_id);
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Create hash
+ *
+ * Arguments:
+ *    [out] hash_id - hash id
+ *    [in] attr_count - number of attributes
+ *    [in] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_create_hash(_Out_ sai_object_id_t *hash_id,
+                              _In_ uint32_t          attr_count,
+                              _In_ sai_attribute_t  *attr_list)
+{
+    const sai_attribute_value_t *field_list, *udf_group_list;
+    uint32_t                     field_list_index, udf_group_list_index, fields = 0, udf_groups = 0, hash;
+    sai_status_t                 status;
+    char                         list_str[MAX_LIST_VALUE_STR_LEN];
+    char                         key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    if (NULL == hash_id) {
+        STUB_LOG_ERR("NULL hash id param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS !=
+        (status =
+             check_attribs_metadata(attr_count, attr_list, hash_attribs, hash_vendor_attribs,
+                                    SAI_OPERATION_CREATE))) {
+        STUB_LOG_ERR("Failed attribs check\n");
+        return status;
+    }
+
+    sai_attr_list_to_str(attr_count, attr_list, hash_attribs, MAX_LIST_VALUE_STR_LEN, list_str);
+    STUB_LOG_NTC("Create hash, %s\n", list_str);
+
+    if ((SAI_STATUS_SUCCESS ==
+         find_attrib_in_list(attr_count, attr_list, SAI_HASH_NATIVE_FIELD_LIST, &field_list, &field_list_index)) &&
+        (SAI_STATUS_SUCCESS != (status = hash_fields_from_list(&field_list->s32list, &fields)))) {
+        return status + field_list_index;
+    }
+
+    if ((SAI_STATUS_SUCCESS ==
+         find_attrib_in_list(attr_count, attr_list, SAI_HASH_UDF_GROUP_LIST, &udf_group_list,
+                             &udf_group_list_index)) &&
+        (SAI_STATUS_SUCCESS != (status = hash_udf_groups_bind(&udf_group_list->objlist, &udf_groups)))) {
+        return status + udf_group_list_index;
+    }
+
+    pthread_rwlock_wrlock(&hash_db_lock);
+
+    for (hash = 0; hash < MAX_HASHES; hash++) {
+        if (!hash_db[hash].is_used) {
+            break;
+        }
+    }
+
+    if (MAX_HASHES == hash) {
+        pthread_rwlock_unlock(&hash_db_lock);
+        hash_udf_groups_unbind(udf_groups);
+        STUB_LOG_ERR("Hash table full\n");
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    hash_db[hash].is_used   = true;
+    hash_db[hash].fields     = fields;
+    hash_db[hash].udf_groups = udf_groups;
+    hash_db[hash].ref_count  = 0;
+
+    pthread_rwlock_unlock(&hash_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_HASH, hash, hash_id))) {
+        return status;
+    }
+    hash_key_to_str(*hash_id, key_str);
+    STUB_LOG_NTC("Created hash %s\n", key_str);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Remove hash
+ *
+ * Arguments:
+ *    [in] hash_id - hash id
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_remove_hash(_In_ sai_object_id_t hash_id)
+{
+    char         key_str[MAX_KEY_STR_LEN];
+    sai_status_t status;
+    uint32_t     hash;
+
+    STUB_LOG_ENTER();
+
+    hash_key_to_str(hash_id, key_str);
+    STUB_LOG_NTC("Remove hash %s\n", key_str);
+
+    pthread_rwlock_wrlock(&hash_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = hash_db_index(hash_id, &hash))) {
+        pthread_rwlock_unlock(&hash_db_lock);
+        return status;
+    }
+
+    if (0 != hash_db[hash].ref_count) {
+        pthread_rwlock_unlock(&hash_db_lock);
+        STUB_LOG_ERR("Hash %u is in use\n", hash);
+        return SAI_STATUS_OBJECT_IN_USE;
+    }
+
+    hash_db[hash].is_used = false;
+    hash_udf_groups_unbind(hash_db[hash].udf_groups);
+
+    pthread_rwlock_unlock(&hash_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Set hash attribute
+ *
+ * Arguments:
+ *    [in] hash_id - hash id
+ *    [in] attr - attribute
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_set_hash_attribute(_In_ sai_object_id_t hash_id, _In_ const sai_attribute_t *attr)
+{
+    const sai_object_key_t key = { .object_id = hash_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    hash_key_to_str(hash_id, key_str);
+    return sai_set_attribute(&key, key_str, hash_attribs, hash_vendor_attribs, attr);
+}
+
+/*
+ * Routine Description:
+ *    Get hash attribute
+ *
+ * Arguments:
+ *    [in] hash_id - hash id
+ *    [in] attr_count - number of attributes
+ *    [inout] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_hash_attribute(_In_ sai_object_id_t     hash_id,
+                                     _In_ uint32_t            attr_count,
+                                     _Inout_ sai_attribute_t *attr_list)
+{
+    const sai_object_key_t key = { .object_id = hash_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
+
+    STUB_LOG_ENTER();
+
+    hash_key_to_str(hash_id, key_str);
+
+    pthread_rwlock_rdlock(&hash_db_lock);
+    status = sai_get_attributes(&key, key_str, hash_attribs, hash_vendor_attribs, attr_count, attr_list);
+    pthread_rwlock_unlock(&hash_db_lock);
+
+    return status;
+}
+
+/* Hash native fields [sai_s32_list_t(sai_native_hash_field)] */
+sai_status_t stub_hash_fields_get(_In_ const sai_object_key_t   *key,
+                                  _Inout_ sai_attribute_value_t *value,
+                                  _In_ uint32_t                  attr_index,
+                                  _Inout_ vendor_cache_t        *cache,
+                                  void                          *arg)
+{
+    int32_t      fields[SAI_NATIVE_HASH_FIELD_IN_PORT + 1];
+    sai_status_t status;
+    uint32_t     hash, field, count = 0;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = hash_db_index(key->object_id, &hash))) {
+        return status;
+    }
+
+    for (field = SAI_NATIVE_HASH_FIELD_SRC_IP; field <= SAI_NATIVE_HASH_FIELD_IN_PORT; field++) {
+        if (hash_db[hash].fields & HASH_FIELD_BIT(field)) {
+            fields[count++] = field;
+        }
+    }
+
+    status = stub_fill_s32list(fields, count, &value->s32list);
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* Hash native fields [sai_s32_list_t(sai_native_hash_field)] */
+sai_status_t stub_hash_fields_set(_In_ const sai_object_key_t      *key,
+                                  _In_ const sai_attribute_value_t *value,
+                                  void                             *arg)
+{
+    sai_status_t status;
+    uint32_t     hash, fields, type;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = hash_fields_from_list(&value->s32list, &fields))) {
+        return status;
+    }
+
+    pthread_rwlock_wrlock(&hash_db_lock);
+
+    if (SAI_STATUS_SUCCESS == (status = hash_db_index(key->object_id, &hash))) {
+        hash_db[hash].fields = fields;
+        for (type = 0; type < STUB_HASH_TYPE_MAX; type++) {
+            if (hash == hash_engines[type].hash) {
+                __atomic_store_n(&hash_engines[type].fields, fields, __ATOMIC_RELAXED);
+            }
+        }
+    }
+
+    pthread_rwlock_unlock(&hash_db_lock);
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* Hash UDF groups [sai_object_list_t(sai_object_id_t)] */
+sai_status_t stub_hash_udf_groups_get(_In_ const sai_object_key_t   *key,
+                                      _Inout_ sai_attribute_value_t *value,
+                                      _In_ uint32_t                  attr_index,
+                                      _Inout_ vendor_cache_t        *cache,
+                                      void                          *arg)
+{
+    sai_object_id_t groups[HASH_UDF_GROUPS];
+    sai_status_t    status;
+    uint32_t        hash, udf_groups, count = 0;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = hash_db_index(key->object_id, &hash))) {
+        return status;
+    }
+
+    for (udf_groups = hash_db[hash].udf_groups; 0 != udf_groups; udf_groups >>= 8) {
+        stub_create_object(SAI_OBJECT_TYPE_UDF_GROUP, (udf_groups & 0xFF) - 1, &groups[count++]);
+    }
+
+    status = stub_fill_objlist(groups, count, &value->objlist);
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* Hash UDF groups [sai_object_list_t(sai_object_id_t)]. The groups must be
+ * of type SAI_UDF_GROUP_HASH */
+sai_status_t stub_hash_udf_groups_set(_In_ const sai_object_key_t      *key,
+                                      _In_ const sai_attribute_value_t *value,
+                                      void                             *arg)
+{
+    sai_status_t status;
+    uint32_t     hash, udf_groups, old_groups, type;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = hash_udf_groups_bind(&value->objlist, &udf_groups))) {
+        return status;
+    }
+
+    pthread_rwlock_wrlock(&hash_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = hash_db_index(key->object_id, &hash))) {
+        pthread_rwlock_unlock(&hash_db_lock);
+        hash_udf_groups_unbind(udf_groups);
+        return status;
+    }
+
+    old_groups               = hash_db[hash].udf_groups;
+    hash_db[hash].udf_groups = udf_groups;
+    for (type = 0; type < STUB_HASH_TYPE_MAX; type++) {
+        if (hash == hash_engines[type].hash) {
+            __atomic_store_n(&hash_engines[type].udf_groups, udf_groups, __ATOMIC_RELAXED);
+        }
+    }
+
+    /* A frame hashed with the old groups while they are removed gets no
+     * bytes from them, see db_udf_extract */
+    hash_udf_groups_unbind(old_groups);
+
+    pthread_rwlock_unlock(&hash_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+const sai_hash_api_t hash_api = {
+    stub_create_hash,
+    stub_remove_hash,
+    stub_set_hash_attribute,
+    stub_get_hash_attribute,
+};
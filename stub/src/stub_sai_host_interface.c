@@ -17,10 +17,22 @@
 
 #include "sai.h"
 #include "stub_sai.h"
+#include "stub_sai_hostif.h"
 #include "assert.h"
+#include <errno.h>
 #ifndef _WIN32
 #include <net/if.h>
 #endif
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/if_tun.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#endif
 
 #undef  __MODULE__
 #define __MODULE__ SAI_HOST_INTERFACE
@@ -72,6 +84,693 @@ static const sai_vendor_attribute_entry_t host_interface_vendor_attribs[] = {
       stub_host_interface_name_get, NULL,
       stub_host_interface_name_set, NULL },
 };
+
+/* State DB *************/
+#define MAX_HOST_INTERFACES 1024
+
+typedef struct _stub_host_interface_t {
+    bool                      is_used;
+    sai_int32_t               type;
+    sai_object_id_t           rif_port;
+    char                      name[HOSTIF_NAME_SIZE];
+    stub_hostif_netdev_kind_t kind;
+    /* kernel interface was created here and goes away with the host interface */
+    bool                      netdev_owned;
+    int                       tap_fd;
+    /* tells the I/O thread events of an earlier user of the entry apart */
+    uint32_t                  generation;
+    /* frame recv_packet read but could not return */
+    uint8_t                  *pending;
+    uint32_t                  pending_len;
+} stub_host_interface_t;
+
+static stub_host_interface_t     hostif_db[MAX_HOST_INTERFACES];
+/* Protects hostif_db and the netlink batch */
+static pthread_mutex_t           hostif_db_lock = PTHREAD_MUTEX_INITIALIZER;
+static stub_hostif_netdev_kind_t hostif_netdev_kind = STUB_HOSTIF_NETDEV_DUMMY;
+
+/* Netlink batch *************/
+#define HOSTIF_NL_BUF_SIZE   65536
+/* room for the largest request the batch builds */
+#define HOSTIF_NL_MSG_SPACE  128
+#define HOSTIF_NL_MAX_MSGS   (HOSTIF_NL_BUF_SIZE / HOSTIF_NL_MSG_SPACE)
+#define HOSTIF_NL_REPLY_SIZE 16384
+
+typedef enum _hostif_nl_op_t {
+    HOSTIF_NL_CREATE,
+    HOSTIF_NL_DELETE,
+    HOSTIF_NL_RENAME
+} hostif_nl_op_t;
+
+/* One queued request, matched to its ack by sequence number */
+typedef struct _hostif_nl_request_t {
+    hostif_nl_op_t op;
+    uint32_t       index;
+    char           name[HOSTIF_NAME_SIZE];
+} hostif_nl_request_t;
+
+static int                 hostif_nl_fd = -1;
+static uint32_t            hostif_nl_seq;
+static bool                hostif_nl_bulk;
+static sai_status_t        hostif_nl_bulk_status;
+static uint32_t            hostif_nl_len;
+static uint32_t            hostif_nl_count;
+static uint32_t            hostif_nl_first_seq;
+static hostif_nl_request_t hostif_nl_requests[HOSTIF_NL_MAX_MSGS];
+static uint32_t            hostif_nl_buf[HOSTIF_NL_BUF_SIZE / sizeof(uint32_t)];
+static uint32_t            hostif_nl_reply[HOSTIF_NL_REPLY_SIZE / sizeof(uint32_t)];
+
+/* Packet I/O *************/
+/* epoll data of the stop event, host interfaces use index and generation */
+#define HOSTIF_IO_STOP UINT64_MAX
+
+static pthread_t hostif_io_thread;
+static bool      hostif_io_running;
+static int       hostif_io_epfd = -1;
+static int       hostif_io_stopfd = -1;
+/* STUB_HOSTIF_BURST frames, only used by the I/O thread */
+static uint8_t  *hostif_io_pool;
+
+#ifdef __linux__
+/* Caller holds hostif_db_lock */
+static sai_status_t hostif_nl_open(void)
+{
+    struct sockaddr_nl local;
+    int                fd;
+
+    if (hostif_nl_fd >= 0) {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    if (0 > (fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE))) {
+        STUB_LOG_ERR("Failed to open netlink socket, %s\n", strerror(errno));
+        return SAI_STATUS_FAILURE;
+    }
+
+    memset(&local, 0, sizeof(local));
+    local.nl_family = AF_NETLINK;
+
+    if (0 > bind(fd, (struct sockaddr*)&local, sizeof(local))) {
+        STUB_LOG_ERR("Failed to bind netlink socket, %s\n", strerror(errno));
+        close(fd);
+        return SAI_STATUS_FAILURE;
+    }
+
+#ifdef NETLINK_CAP_ACK
+    {
+        int one = 1;
+
+        /* acks need not echo the request */
+        setsockopt(fd, SOL_NETLINK, NETLINK_CAP_ACK, &one, sizeof(one));
+    }
+#endif
+
+    hostif_nl_fd = fd;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void hostif_nl_put_attr(_Inout_ struct nlmsghdr *nlh,
+                               _In_ uint16_t            type,
+                               _In_ const void         *data,
+                               _In_ uint16_t            len)
+{
+    struct rtattr *rta = (struct rtattr*)((uint8_t*)nlh + NLMSG_ALIGN(nlh->nlmsg_len));
+
+    rta->rta_type = type;
+    rta->rta_len  = RTA_LENGTH(len);
+    if (0 != len) {
+        memcpy(RTA_DATA(rta), data, len);
+    }
+    nlh->nlmsg_len = NLMSG_ALIGN(nlh->nlmsg_len) + RTA_ALIGN(rta->rta_len);
+}
+
+/* Result of one request. Caller holds hostif_db_lock */
+static sai_status_t hostif_nl_complete(_In_ const hostif_nl_request_t *request, _In_ int error)
+{
+    stub_host_interface_t *hostif = &hostif_db[request->index];
+
+    if (0 == error) {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    switch (request->op) {
+    case HOSTIF_NL_CREATE:
+        if (hostif->is_used && (0 == strncmp(hostif->name, request->name, HOSTIF_NAME_SIZE))) {
+            hostif->netdev_owned = false;
+        }
+
+        if (EEXIST == error) {
+            STUB_LOG_INF("Interface %s already exists, using it\n", request->name);
+            return SAI_STATUS_SUCCESS;
+        }
+
+        STUB_LOG_ERR("Failed to create interface %s, %s\n", request->name, strerror(error));
+        return SAI_STATUS_FAILURE;
+
+    case HOSTIF_NL_DELETE:
+        if (ENODEV == error) {
+            return SAI_STATUS_SUCCESS;
+        }
+
+        STUB_LOG_ERR("Failed to delete interface %s, %s\n", request->name, strerror(error));
+        return SAI_STATUS_FAILURE;
+
+    default:
+        STUB_LOG_ERR("Failed to rename interface %s, %s\n", request->name, strerror(error));
+        return SAI_STATUS_FAILURE;
+    }
+}
+
+/*
+ * Send the queued requests in one message and wait for every ack.
+ * Caller holds hostif_db_lock.
+ */
+static sai_status_t hostif_nl_flush(void)
+{
+    struct sockaddr_nl kernel;
+    struct nlmsghdr   *nlh;
+    struct nlmsgerr   *err;
+    sai_status_t       status = SAI_STATUS_SUCCESS;
+    uint32_t           acked  = 0, ii;
+    ssize_t            len;
+
+    if (0 == hostif_nl_count) {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    memset(&kernel, 0, sizeof(kernel));
+    kernel.nl_family = AF_NETLINK;
+
+    if (0 > sendto(hostif_nl_fd, hostif_nl_buf, hostif_nl_len, 0, (struct sockaddr*)&kernel, sizeof(kernel))) {
+        STUB_LOG_ERR("Failed to send %u netlink requests, %s\n", hostif_nl_count, strerror(errno));
+        for (ii = 0; ii < hostif_nl_count; ii++) {
+            hostif_nl_complete(&hostif_nl_requests[ii], errno);
+        }
+        status = SAI_STATUS_FAILURE;
+        acked  = hostif_nl_count;
+    }
+
+    while (acked < hostif_nl_count) {
+        len = recv(hostif_nl_fd, hostif_nl_reply, sizeof(hostif_nl_reply), 0);
+
+        if (0 > len) {
+            if (EINTR == errno) {
+                continue;
+            }
+            STUB_LOG_ERR("Failed to receive netlink acks, %s\n", strerror(errno));
+            status = SAI_STATUS_FAILURE;
+            break;
+        }
+
+        for (nlh = (struct nlmsghdr*)hostif_nl_reply; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+            ii = nlh->nlmsg_seq - hostif_nl_first_seq;
+
+            /* acks of an earlier batch that gave up waiting are skipped */
+            if ((NLMSG_ERROR != nlh->nlmsg_type) || (ii >= hostif_nl_count)) {
+                continue;
+            }
+
+            err = NLMSG_DATA(nlh);
+            if (SAI_STATUS_SUCCESS != hostif_nl_complete(&hostif_nl_requests[ii], -err->error)) {
+                status = SAI_STATUS_FAILURE;
+            }
+            acked++;
+        }
+    }
+
+    STUB_LOG_DBG("Sent %u netlink requests in %u bytes\n", hostif_nl_count, hostif_nl_len);
+
+    hostif_nl_len   = 0;
+    hostif_nl_count = 0;
+
+    if ((SAI_STATUS_SUCCESS != status) && hostif_nl_bulk) {
+        hostif_nl_bulk_status = status;
+    }
+
+    return status;
+}
+
+/*
+ * Queue a link request, sent right away unless a bulk is open.
+ * Caller holds hostif_db_lock.
+ */
+static sai_status_t hostif_nl_queue(_In_ hostif_nl_op_t op,
+                                    _In_ uint32_t       index,
+                                    _In_ const char    *name,
+                                    _In_ const char    *new_name)
+{
+    struct nlmsghdr     *nlh;
+    struct ifinfomsg    *ifi;
+    struct rtattr       *linkinfo;
+    hostif_nl_request_t *request;
+    sai_status_t         status;
+    unsigned int         ifindex = 0;
+
+    if (SAI_STATUS_SUCCESS != (status = hostif_nl_open())) {
+        return status;
+    }
+
+    if (HOSTIF_NL_RENAME == op) {
+        /* a rename reports its own status, and needs the queued creates done */
+        hostif_nl_flush();
+
+        if (0 == (ifindex = if_nametoindex(name))) {
+            STUB_LOG_ERR("Interface %s not found\n", name);
+            return SAI_STATUS_FAILURE;
+        }
+    }
+
+    if ((HOSTIF_NL_MAX_MSGS == hostif_nl_count) && (SAI_STATUS_SUCCESS != (status = hostif_nl_flush()))) {
+        return status;
+    }
+
+    nlh = (struct nlmsghdr*)((uint8_t*)hostif_nl_buf + hostif_nl_len);
+    memset(nlh, 0, HOSTIF_NL_MSG_SPACE);
+    nlh->nlmsg_len   = NLMSG_LENGTH(sizeof(*ifi));
+    nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+    nlh->nlmsg_seq   = ++hostif_nl_seq;
+    ifi              = NLMSG_DATA(nlh);
+    ifi->ifi_family  = AF_UNSPEC;
+    ifi->ifi_index   = (int)ifindex;
+
+    switch (op) {
+    case HOSTIF_NL_CREATE:
+        nlh->nlmsg_type   = RTM_NEWLINK;
+        nlh->nlmsg_flags |= NLM_F_CREATE | NLM_F_EXCL;
+        hostif_nl_put_attr(nlh, IFLA_IFNAME, name, strlen(name) + 1);
+        linkinfo = (struct rtattr*)((uint8_t*)nlh + NLMSG_ALIGN(nlh->nlmsg_len));
+        hostif_nl_put_attr(nlh, IFLA_LINKINFO, NULL, 0);
+        hostif_nl_put_attr(nlh, IFLA_INFO_KIND, "dummy", sizeof("dummy"));
+        linkinfo->rta_len = (uint8_t*)nlh + nlh->nlmsg_len - (uint8_t*)linkinfo;
+        break;
+
+    case HOSTIF_NL_DELETE:
+        nlh->nlmsg_type = RTM_DELLINK;
+        hostif_nl_put_attr(nlh, IFLA_IFNAME, name, strlen(name) + 1);
+        break;
+
+    default:
+        nlh->nlmsg_type = RTM_NEWLINK;
+        hostif_nl_put_attr(nlh, IFLA_IFNAME, new_name, strlen(new_name) + 1);
+        break;
+    }
+
+    if (0 == hostif_nl_count) {
+        hostif_nl_first_seq = nlh->nlmsg_seq;
+    }
+
+    request        = &hostif_nl_requests[hostif_nl_count++];
+    request->op    = op;
+    request->index = index;
+    strncpy(request->name, name, HOSTIF_NAME_SIZE);
+    hostif_nl_len += NLMSG_ALIGN(nlh->nlmsg_len);
+
+    if (hostif_nl_bulk && (HOSTIF_NL_RENAME != op)) {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    return hostif_nl_flush();
+}
+
+static sai_status_t hostif_tap_open(_In_ const char *name, _Out_ int *tap_fd)
+{
+    struct ifreq ifr;
+    int          fd;
+
+    if (0 > (fd = open("/dev/net/tun", O_RDWR | O_CLOEXEC | O_NONBLOCK))) {
+        STUB_LOG_ERR("Failed to open /dev/net/tun, %s\n", strerror(errno));
+        return SAI_STATUS_FAILURE;
+    }
+
+    memset(&ifr, 0, sizeof(ifr));
+    ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+    strncpy(ifr.ifr_name, name, IFNAMSIZ - 1);
+
+    if (0 > ioctl(fd, TUNSETIFF, &ifr)) {
+        STUB_LOG_ERR("Failed to create TAP interface %s, %s\n", name, strerror(errno));
+        close(fd);
+        return SAI_STATUS_FAILURE;
+    }
+
+    *tap_fd = fd;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Read and deliver the frames waiting on TAP interfaces */
+static void* hostif_io_worker(void *arg)
+{
+    struct epoll_event               events[STUB_HOSTIF_BURST];
+    uint32_t                         lengths[STUB_HOSTIF_BURST];
+    sai_packet_event_notification_fn on_packet_event;
+    stub_host_interface_t           *hostif;
+    sai_attribute_t                  attr;
+    uint32_t                         index, frames, ii;
+    ssize_t                          len;
+    int                              count, jj;
+
+    while (__atomic_load_n(&hostif_io_running, __ATOMIC_ACQUIRE)) {
+        if (0 >= (count = epoll_wait(hostif_io_epfd, events, STUB_HOSTIF_BURST, -1))) {
+            continue;
+        }
+
+        for (jj = 0; jj < count; jj++) {
+            if (HOSTIF_IO_STOP == events[jj].data.u64) {
+                continue;
+            }
+
+            index          = (uint32_t)events[jj].data.u64;
+            hostif         = &hostif_db[index];
+            frames         = 0;
+            attr.id        = SAI_HOSTIF_PACKET_INGRESS_PORT;
+            attr.value.oid = SAI_NULL_OBJECT_ID;
+
+            pthread_mutex_lock(&hostif_db_lock);
+
+            /* the host interface may be gone since epoll_wait returned */
+            if (hostif->is_used && (-1 != hostif->tap_fd) &&
+                (hostif->generation == (uint32_t)(events[jj].data.u64 >> 32))) {
+                while (frames < STUB_HOSTIF_BURST) {
+                    len = read(hostif->tap_fd, hostif_io_pool + frames * STUB_HOSTIF_MAX_FRAME,
+                               STUB_HOSTIF_MAX_FRAME);
+                    if (0 >= len) {
+                        break;
+                    }
+                    lengths[frames++] = (uint32_t)len;
+                }
+                attr.value.oid = hostif->rif_port;
+            }
+
+            pthread_mutex_unlock(&hostif_db_lock);
+
+            /* delivered unlocked, the notification may call back into the API */
+            on_packet_event = g_notification_callbacks.on_packet_event;
+            for (ii = 0; (ii < frames) && (NULL != on_packet_event); ii++) {
+                on_packet_event(hostif_io_pool + ii * STUB_HOSTIF_MAX_FRAME, lengths[ii], 1, &attr);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Start the I/O thread, frames are then delivered through on_packet_event.
+ * Without the notification recv_packet reads them. Caller holds hostif_db_lock.
+ */
+static sai_status_t hostif_io_start(void)
+{
+    struct epoll_event event;
+
+    if (hostif_io_running || (NULL == g_notification_callbacks.on_packet_event)) {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    if (NULL == (hostif_io_pool = malloc(STUB_HOSTIF_BURST * STUB_HOSTIF_MAX_FRAME))) {
+        STUB_LOG_ERR("Failed to allocate host interface buffers\n");
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    hostif_io_epfd   = epoll_create1(EPOLL_CLOEXEC);
+    hostif_io_stopfd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    event.events     = EPOLLIN;
+    event.data.u64   = HOSTIF_IO_STOP;
+
+    if ((0 > hostif_io_epfd) || (0 > hostif_io_stopfd) ||
+        (0 > epoll_ctl(hostif_io_epfd, EPOLL_CTL_ADD, hostif_io_stopfd, &event))) {
+        STUB_LOG_ERR("Failed to set up host interface polling, %s\n", strerror(errno));
+        goto err;
+    }
+
+    __atomic_store_n(&hostif_io_running, true, __ATOMIC_RELEASE);
+
+    if (0 != pthread_create(&hostif_io_thread, NULL, hostif_io_worker, NULL)) {
+        STUB_LOG_ERR("Failed to start host interface I/O thread\n");
+        hostif_io_running = false;
+        goto err;
+    }
+
+    STUB_LOG_NTC("Host interface I/O thread started\n");
+
+    return SAI_STATUS_SUCCESS;
+
+err:
+    if (0 <= hostif_io_epfd) {
+        close(hostif_io_epfd);
+    }
+    if (0 <= hostif_io_stopfd) {
+        close(hostif_io_stopfd);
+    }
+    hostif_io_epfd   = -1;
+    hostif_io_stopfd = -1;
+    free(hostif_io_pool);
+    hostif_io_pool = NULL;
+
+    return SAI_STATUS_FAILURE;
+}
+
+/* Poll a new TAP in the I/O thread. Caller holds hostif_db_lock */
+static sai_status_t hostif_io_watch(_In_ uint32_t index)
+{
+    struct epoll_event event;
+    sai_status_t       status;
+
+    if (SAI_STATUS_SUCCESS != (status = hostif_io_start())) {
+        return status;
+    }
+
+    if (!hostif_io_running) {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    event.events   = EPOLLIN;
+    event.data.u64 = ((uint64_t)hostif_db[index].generation << 32) | index;
+
+    if (0 > epoll_ctl(hostif_io_epfd, EPOLL_CTL_ADD, hostif_db[index].tap_fd, &event)) {
+        STUB_LOG_ERR("Failed to poll host interface %s, %s\n", hostif_db[index].name, strerror(errno));
+        return SAI_STATUS_FAILURE;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+#else
+static sai_status_t hostif_nl_flush(void)
+{
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t hostif_nl_queue(_In_ hostif_nl_op_t op,
+                                    _In_ uint32_t       index,
+                                    _In_ const char    *name,
+                                    _In_ const char    *new_name)
+{
+    return SAI_STATUS_NOT_SUPPORTED;
+}
+
+static sai_status_t hostif_tap_open(_In_ const char *name, _Out_ int *tap_fd)
+{
+    return SAI_STATUS_NOT_SUPPORTED;
+}
+
+static sai_status_t hostif_io_watch(_In_ uint32_t index)
+{
+    return SAI_STATUS_NOT_SUPPORTED;
+}
+#endif /* __linux__ */
+
+/* Stop the I/O thread. Called without hostif_db_lock, the thread takes it */
+void db_stop_host_interface_io(void)
+{
+#ifdef __linux__
+    uint64_t stop = 1;
+
+    if (!__atomic_load_n(&hostif_io_running, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    __atomic_store_n(&hostif_io_running, false, __ATOMIC_RELEASE);
+    if (0 > write(hostif_io_stopfd, &stop, sizeof(stop))) {
+        STUB_LOG_ERR("Failed to wake host interface I/O thread, %s\n", strerror(errno));
+    }
+    pthread_join(hostif_io_thread, NULL);
+
+    close(hostif_io_epfd);
+    close(hostif_io_stopfd);
+    hostif_io_epfd   = -1;
+    hostif_io_stopfd = -1;
+    free(hostif_io_pool);
+    hostif_io_pool = NULL;
+
+    STUB_LOG_NTC("Host interface I/O thread stopped\n");
+#endif
+}
+
+/* Release the kernel interface of a host interface. Caller holds hostif_db_lock */
+static sai_status_t hostif_netdev_release(_In_ uint32_t index)
+{
+    stub_host_interface_t *hostif = &hostif_db[index];
+    sai_status_t           status = SAI_STATUS_SUCCESS;
+
+    if (hostif->netdev_owned) {
+        if (STUB_HOSTIF_NETDEV_TAP == hostif->kind) {
+            /* a TAP interface goes away with its last file descriptor */
+            close(hostif->tap_fd);
+        } else {
+            status = hostif_nl_queue(HOSTIF_NL_DELETE, index, hostif->name, NULL);
+        }
+    }
+
+    if (SAI_STATUS_SUCCESS == status) {
+        hostif->netdev_owned = false;
+        hostif->tap_fd       = -1;
+        free(hostif->pending);
+        hostif->pending     = NULL;
+        hostif->pending_len = 0;
+    }
+
+    return status;
+}
+
+/* Host interface index of an object. Caller holds hostif_db_lock */
+static sai_status_t hostif_db_index(_In_ sai_object_id_t hif_id, _Out_ uint32_t *index)
+{
+    sai_status_t status;
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(hif_id, SAI_OBJECT_TYPE_HOST_INTERFACE, index))) {
+        return status;
+    }
+
+    if ((*index >= MAX_HOST_INTERFACES) || (!hostif_db[*index].is_used)) {
+        STUB_LOG_ERR("Host interface %u does not exist\n", *index);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+void db_init_host_interface(_In_ sai_switch_profile_id_t profile_id)
+{
+    const char *kind = NULL;
+    uint32_t    ii;
+
+    if (NULL != g_services.profile_get_value) {
+        kind = g_services.profile_get_value(profile_id, STUB_HOSTIF_NETDEV_PROFILE_KEY);
+    }
+
+    db_stop_host_interface_io();
+
+    pthread_mutex_lock(&hostif_db_lock);
+
+    if ((NULL == kind) || (0 == strcmp(kind, "dummy"))) {
+        hostif_netdev_kind = STUB_HOSTIF_NETDEV_DUMMY;
+    } else if (0 == strcmp(kind, "tap")) {
+        hostif_netdev_kind = STUB_HOSTIF_NETDEV_TAP;
+    } else if (0 == strcmp(kind, "none")) {
+        hostif_netdev_kind = STUB_HOSTIF_NETDEV_NONE;
+    } else {
+        STUB_LOG_ERR("Invalid %s value %s, using dummy\n", STUB_HOSTIF_NETDEV_PROFILE_KEY, kind);
+        hostif_netdev_kind = STUB_HOSTIF_NETDEV_DUMMY;
+    }
+
+    for (ii = 0; ii < MAX_HOST_INTERFACES; ii++) {
+        if (hostif_db[ii].is_used && hostif_db[ii].netdev_owned && (STUB_HOSTIF_NETDEV_TAP == hostif_db[ii].kind)) {
+            close(hostif_db[ii].tap_fd);
+        }
+        free(hostif_db[ii].pending);
+        hostif_db[ii].pending     = NULL;
+        hostif_db[ii].pending_len = 0;
+        hostif_db[ii].is_used     = false;
+    }
+
+    hostif_nl_bulk  = false;
+    hostif_nl_len   = 0;
+    hostif_nl_count = 0;
+
+    pthread_mutex_unlock(&hostif_db_lock);
+}
+
+/*
+ * Routine Description:
+ *    Select the kernel interface kind of netdev host interfaces
+ *
+ * Arguments:
+ *    [in] kind - kernel interface kind
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_host_interface_set_netdev_kind(_In_ stub_hostif_netdev_kind_t kind)
+{
+    if ((STUB_HOSTIF_NETDEV_DUMMY != kind) && (STUB_HOSTIF_NETDEV_TAP != kind) &&
+        (STUB_HOSTIF_NETDEV_NONE != kind)) {
+        STUB_LOG_ERR("Invalid host interface netdev kind %d\n", kind);
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&hostif_db_lock);
+    hostif_netdev_kind = kind;
+    pthread_mutex_unlock(&hostif_db_lock);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Start queueing the kernel requests of host interface creates and removes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_host_interface_bulk_begin(void)
+{
+    pthread_mutex_lock(&hostif_db_lock);
+
+    if (hostif_nl_bulk) {
+        pthread_mutex_unlock(&hostif_db_lock);
+        STUB_LOG_ERR("Host interface bulk already open\n");
+        return SAI_STATUS_FAILURE;
+    }
+
+    hostif_nl_bulk        = true;
+    hostif_nl_bulk_status = SAI_STATUS_SUCCESS;
+
+    pthread_mutex_unlock(&hostif_db_lock);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Send the queued kernel requests as one netlink batch
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS if every request succeeded
+ *    Failure status code if any request failed
+ */
+sai_status_t stub_host_interface_bulk_commit(void)
+{
+    sai_status_t status;
+
+    pthread_mutex_lock(&hostif_db_lock);
+
+    if (!hostif_nl_bulk) {
+        pthread_mutex_unlock(&hostif_db_lock);
+        STUB_LOG_ERR("No host interface bulk open\n");
+        return SAI_STATUS_FAILURE;
+    }
+
+    hostif_nl_flush();
+    status         = hostif_nl_bulk_status;
+    hostif_nl_bulk = false;
+
+    pthread_mutex_unlock(&hostif_db_lock);
+
+    return status;
+}
+
 static void host_interface_key_to_str(_In_ sai_object_id_t hif_id, _Out_ char *key_str)
 {
     uint32_t hif_data;
@@ -101,13 +800,11 @@ sai_status_t stub_create_host_interface(_Out_ sai_object_id_t     * hif_id,
                                         _In_ const sai_attribute_t *attr_list)
 {
     sai_status_t                 status;
-    int                          ret;
     const sai_attribute_value_t *type, *rif_port, *name;
-    uint32_t                     type_index, rif_port_index, name_index, rif_data;
+    uint32_t                     type_index, rif_port_index, name_index, rif_data, index;
     char                         key_str[MAX_KEY_STR_LEN];
     char                         list_str[MAX_LIST_VALUE_STR_LEN];
-    static uint32_t              next_id = 0;
-    char                         system_cmd[1024];
+    stub_host_interface_t       *hostif;
 
     STUB_LOG_ENTER();
 
@@ -154,20 +851,56 @@ sai_status_t stub_create_host_interface(_Out_ sai_object_id_t     * hif_id,
             STUB_LOG_ERR("Invalid rif port object type %s", SAI_TYPE_STR(sai_object_type_query(rif_port->oid)));
             return SAI_STATUS_INVALID_ATTR_VALUE_0 + rif_port_index;
         }
-        snprintf(system_cmd, sizeof(system_cmd), "ip link add name %s type dummy", name->chardata);
-        ret = system(system_cmd);
-        if (0 != ret) {
-            STUB_LOG_INF("Error on attempt to create dummy interface. Possibly interface already exists");
-            return SAI_STATUS_SUCCESS;
-        }
-
     } else if (SAI_HOSTIF_TYPE_FD == type->s32) {
+        rif_port = NULL;
     } else {
         STUB_LOG_ERR("Invalid host interface type %d\n", type->s32);
         return SAI_STATUS_INVALID_ATTR_VALUE_0 + type_index;
     }
 
-    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_HOST_INTERFACE, next_id++, hif_id))) {
+    pthread_mutex_lock(&hostif_db_lock);
+
+    for (index = 0; index < MAX_HOST_INTERFACES; index++) {
+        if (!hostif_db[index].is_used) {
+            break;
+        }
+    }
+
+    if (MAX_HOST_INTERFACES == index) {
+        pthread_mutex_unlock(&hostif_db_lock);
+        STUB_LOG_ERR("Host interface table full\n");
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    hostif               = &hostif_db[index];
+    hostif->is_used      = true;
+    hostif->type         = type->s32;
+    hostif->rif_port     = (NULL == rif_port) ? SAI_NULL_OBJECT_ID : rif_port->oid;
+    hostif->kind         = (NULL == rif_port) ? STUB_HOSTIF_NETDEV_NONE : hostif_netdev_kind;
+    hostif->netdev_owned = (STUB_HOSTIF_NETDEV_NONE != hostif->kind);
+    hostif->tap_fd       = -1;
+    hostif->generation++;
+    memcpy(hostif->name, name->chardata, HOSTIF_NAME_SIZE - 1);
+    hostif->name[HOSTIF_NAME_SIZE - 1] = '\0';
+    status = SAI_STATUS_SUCCESS;
+
+    if (STUB_HOSTIF_NETDEV_DUMMY == hostif->kind) {
+        status = hostif_nl_queue(HOSTIF_NL_CREATE, index, hostif->name, NULL);
+    } else if ((STUB_HOSTIF_NETDEV_TAP == hostif->kind) &&
+               (SAI_STATUS_SUCCESS == (status = hostif_tap_open(hostif->name, &hostif->tap_fd))) &&
+               (SAI_STATUS_SUCCESS != (status = hostif_io_watch(index)))) {
+        hostif_netdev_release(index);
+    }
+
+    if (SAI_STATUS_SUCCESS != status) {
+        hostif->is_used = false;
+        pthread_mutex_unlock(&hostif_db_lock);
+        return status;
+    }
+
+    pthread_mutex_unlock(&hostif_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_HOST_INTERFACE, index, hif_id))) {
         return status;
     }
     host_interface_key_to_str(*hif_id, key_str);
@@ -199,10 +932,18 @@ sai_status_t stub_remove_host_interface(_In_ sai_object_id_t hif_id)
     host_interface_key_to_str(hif_id, key_str);
     STUB_LOG_NTC("Remove host interface %s\n", key_str);
 
-    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(hif_id, SAI_OBJECT_TYPE_HOST_INTERFACE, &hif_data))) {
+    pthread_mutex_lock(&hostif_db_lock);
+
+    if ((SAI_STATUS_SUCCESS != (status = hostif_db_index(hif_id, &hif_data))) ||
+        (SAI_STATUS_SUCCESS != (status = hostif_netdev_release(hif_data)))) {
+        pthread_mutex_unlock(&hostif_db_lock);
         return status;
     }
 
+    hostif_db[hif_data].is_used = false;
+
+    pthread_mutex_unlock(&hostif_db_lock);
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -268,9 +1009,21 @@ sai_status_t stub_host_interface_type_get(_In_ const sai_object_key_t   *key,
                                           _Inout_ vendor_cache_t        *cache,
                                           void                          *arg)
 {
+    uint32_t     hif_id;
+    sai_status_t status;
+
     STUB_LOG_ENTER();
 
-    value->s32 = SAI_HOSTIF_TYPE_NETDEV;
+    pthread_mutex_lock(&hostif_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = hostif_db_index(key->object_id, &hif_id))) {
+        pthread_mutex_unlock(&hostif_db_lock);
+        return status;
+    }
+
+    value->s32 = hostif_db[hif_id].type;
+
+    pthread_mutex_unlock(&hostif_db_lock);
 
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
@@ -283,14 +1036,22 @@ sai_status_t stub_host_interface_rif_port_get(_In_ const sai_object_key_t   *key
                                               _Inout_ vendor_cache_t        *cache,
                                               void                          *arg)
 {
+    uint32_t     hif_id;
     sai_status_t status;
 
     STUB_LOG_ENTER();
 
-    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_PORT, 1, &value->oid))) {
+    pthread_mutex_lock(&hostif_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = hostif_db_index(key->object_id, &hif_id))) {
+        pthread_mutex_unlock(&hostif_db_lock);
         return status;
     }
 
+    value->oid = hostif_db[hif_id].rif_port;
+
+    pthread_mutex_unlock(&hostif_db_lock);
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -309,12 +1070,16 @@ sai_status_t stub_host_interface_name_get(_In_ const sai_object_key_t   *key,
 
     STUB_LOG_ENTER();
 
-    if (SAI_STATUS_SUCCESS !=
-        (status = stub_object_to_type(key->object_id, SAI_OBJECT_TYPE_HOST_INTERFACE, &hif_id))) {
+    pthread_mutex_lock(&hostif_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = hostif_db_index(key->object_id, &hif_id))) {
+        pthread_mutex_unlock(&hostif_db_lock);
         return status;
     }
 
-    strncpy(value->chardata, "name", HOSTIF_NAME_SIZE);
+    strncpy(value->chardata, hostif_db[hif_id].name, HOSTIF_NAME_SIZE);
+
+    pthread_mutex_unlock(&hostif_db_lock);
 
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
@@ -332,38 +1097,263 @@ sai_status_t stub_host_interface_name_set(_In_ const sai_object_key_t      *key,
 
     STUB_LOG_ENTER();
 
-    if (SAI_STATUS_SUCCESS !=
-        (status = stub_object_to_type(key->object_id, SAI_OBJECT_TYPE_HOST_INTERFACE, &hif_id))) {
+    stub_host_interface_t *hostif;
+    char                   name[HOSTIF_NAME_SIZE];
+
+    memcpy(name, value->chardata, HOSTIF_NAME_SIZE - 1);
+    name[HOSTIF_NAME_SIZE - 1] = '\0';
+
+    pthread_mutex_lock(&hostif_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = hostif_db_index(key->object_id, &hif_id))) {
+        pthread_mutex_unlock(&hostif_db_lock);
         return status;
     }
 
+    hostif = &hostif_db[hif_id];
+
+    /* interfaces found already existing are not ours to rename */
+    if (hostif->netdev_owned &&
+        (SAI_STATUS_SUCCESS != (status = hostif_nl_queue(HOSTIF_NL_RENAME, hif_id, hostif->name, name)))) {
+        pthread_mutex_unlock(&hostif_db_lock);
+        return status;
+    }
+
+    strncpy(hostif->name, name, HOSTIF_NAME_SIZE);
+
+    pthread_mutex_unlock(&hostif_db_lock);
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
 
-sai_status_t stub_set_host_interface_trap_attribute(_In_ sai_hostif_trap_id_t  hostif_trapid,
-                                                    _In_ const sai_attribute_t *attr)
+/*
+ * Routine Description:
+ *    Find the host interface of a port, the NETDEV trap channel punts the
+ *    frames received on the port to it
+ *
+ * Arguments:
+ *    [in] port_id - port id
+ *    [out] hif_id - host interface id
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    SAI_STATUS_ITEM_NOT_FOUND if the port has no host interface
+ */
+sai_status_t db_get_host_interface_by_port(_In_ sai_object_id_t port_id, _Out_ sai_object_id_t *hif_id)
+{
+    sai_status_t status = SAI_STATUS_ITEM_NOT_FOUND;
+    uint32_t     ii;
+
+    pthread_mutex_lock(&hostif_db_lock);
+
+    for (ii = 0; ii < MAX_HOST_INTERFACES; ii++) {
+        if (hostif_db[ii].is_used && (port_id == hostif_db[ii].rif_port)) {
+            status = stub_create_object(SAI_OBJECT_TYPE_HOST_INTERFACE, ii, hif_id);
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&hostif_db_lock);
+
+    return status;
+}
+
+/* TAP of a host interface. Caller holds hostif_db_lock */
+static sai_status_t hostif_db_tap(_In_ sai_object_id_t hif_id, _Out_ stub_host_interface_t **hostif)
+{
+    sai_status_t status;
+    uint32_t     index;
+
+    if (SAI_STATUS_SUCCESS != (status = hostif_db_index(hif_id, &index))) {
+        return status;
+    }
+
+    if (-1 == hostif_db[index].tap_fd) {
+        STUB_LOG_ERR("Host interface %s has no TAP interface\n", hostif_db[index].name);
+        return SAI_STATUS_NOT_SUPPORTED;
+    }
+
+    *hostif = &hostif_db[index];
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Receive a frame on the port of a TAP backed host interface, when no
+ *    on_packet_event notification takes the frames
+ *
+ * Arguments:
+ *    [in] hif_id - host interface id
+ *    [out] buffer - packet buffer
+ *    [inout] buffer_size - allocated buffer size, actual packet size
+ *    [inout] attr_count - allocated list size, number of attributes
+ *    [out] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    SAI_STATUS_ITEM_NOT_FOUND if no frame is waiting
+ *    SAI_STATUS_BUFFER_OVERFLOW if buffer_size or attr_count is insufficient,
+ *    the frame is kept for the next call
+ *    Failure status code on error
+ */
+sai_status_t stub_recv_host_interface_packet(_In_ sai_object_id_t  hif_id,
+                                             _Out_ void           *buffer,
+                                             _Inout_ sai_size_t   *buffer_size,
+                                             _Inout_ uint32_t     *attr_count,
+                                             _Out_ sai_attribute_t *attr_list)
 {
-    STUB_LOG_ENTER();
-    STUB_LOG_EXIT();
+    stub_host_interface_t *hostif;
+    sai_status_t           status;
+    ssize_t                len;
+
+    if ((NULL == buffer) || (NULL == buffer_size) || (NULL == attr_count) || (NULL == attr_list)) {
+        STUB_LOG_ERR("NULL receive param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&hostif_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = hostif_db_tap(hif_id, &hostif))) {
+        pthread_mutex_unlock(&hostif_db_lock);
+        return status;
+    }
+
+    if (__atomic_load_n(&hostif_io_running, __ATOMIC_ACQUIRE)) {
+        pthread_mutex_unlock(&hostif_db_lock);
+        STUB_LOG_ERR("Frames are delivered through on_packet_event\n");
+        return SAI_STATUS_NOT_SUPPORTED;
+    }
+
+    if (0 == hostif->pending_len) {
+        if ((NULL == hostif->pending) && (NULL == (hostif->pending = malloc(STUB_HOSTIF_MAX_FRAME)))) {
+            pthread_mutex_unlock(&hostif_db_lock);
+            return SAI_STATUS_NO_MEMORY;
+        }
+
+        if (0 >= (len = read(hostif->tap_fd, hostif->pending, STUB_HOSTIF_MAX_FRAME))) {
+            pthread_mutex_unlock(&hostif_db_lock);
+            return SAI_STATUS_ITEM_NOT_FOUND;
+        }
+        hostif->pending_len = (uint32_t)len;
+    }
+
+    if ((*buffer_size < hostif->pending_len) || (*attr_count < 1)) {
+        *buffer_size = hostif->pending_len;
+        *attr_count  = 1;
+        pthread_mutex_unlock(&hostif_db_lock);
+        return SAI_STATUS_BUFFER_OVERFLOW;
+    }
+
+    memcpy(buffer, hostif->pending, hostif->pending_len);
+    *buffer_size           = hostif->pending_len;
+    *attr_count            = 1;
+    attr_list[0].id        = SAI_HOSTIF_PACKET_INGRESS_PORT;
+    attr_list[0].value.oid = hostif->rif_port;
+    hostif->pending_len    = 0;
+
+    pthread_mutex_unlock(&hostif_db_lock);
 
     return SAI_STATUS_SUCCESS;
 }
 
+/*
+ * Routine Description:
+ *    Send several frames through a TAP backed host interface
+ *
+ * Arguments:
+ *    [in] hif_id - host interface id
+ *    [in] count - number of frames
+ *    [in] buffers - frames
+ *    [in] sizes - frame lengths in bytes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS if every frame was sent
+ *    Failure status code on error
+ */
+sai_status_t stub_host_interface_send_bulk(_In_ sai_object_id_t   hif_id,
+                                           _In_ uint32_t          count,
+                                           _In_ const void      **buffers,
+                                           _In_ const sai_size_t *sizes)
+{
+    stub_host_interface_t *hostif;
+    sai_status_t           status;
+    uint32_t               ii;
+
+    if ((NULL == buffers) || (NULL == sizes)) {
+        STUB_LOG_ERR("NULL send param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&hostif_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = hostif_db_tap(hif_id, &hostif))) {
+        pthread_mutex_unlock(&hostif_db_lock);
+        return status;
+    }
+
+    /* a TAP takes one frame per write */
+    for (ii = 0; ii < count; ii++) {
+        if (0 > write(hostif->tap_fd, buffers[ii], sizes[ii])) {
+            STUB_LOG_ERR("Failed to send frame %u of %u on %s, %s\n", ii, count, hostif->name, strerror(errno));
+            status = SAI_STATUS_FAILURE;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&hostif_db_lock);
+
+    return status;
+}
+
+/*
+ * Routine Description:
+ *    Send a frame on the port of a TAP backed host interface
+ *
+ * Arguments:
+ *    [in] hif_id - host interface id
+ *    [in] buffer - packet buffer
+ *    [in] buffer_size - packet size in bytes
+ *    [in] attr_count - number of attributes
+ *    [in] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_send_host_interface_packet(_In_ sai_object_id_t  hif_id,
+                                             _In_ void            *buffer,
+                                             _In_ sai_size_t       buffer_size,
+                                             _In_ uint32_t         attr_count,
+                                             _In_ sai_attribute_t *attr_list)
+{
+    const sai_attribute_value_t *tx_type;
+    const void                  *buffers[1] = { buffer };
+    uint32_t                     tx_type_index;
+
+    if (SAI_STATUS_SUCCESS !=
+        find_attrib_in_list(attr_count, attr_list, SAI_HOSTIF_PACKET_TX_TYPE, &tx_type, &tx_type_index)) {
+        STUB_LOG_ERR("Missing mandatory attribute tx type on send\n");
+        return SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING;
+    }
+
+    return stub_host_interface_send_bulk(hif_id, 1, buffers, &buffer_size);
+}
 
 const sai_hostif_api_t host_interface_api = {
     stub_create_host_interface,
     stub_remove_host_interface,
     stub_set_host_interface_attribute,
     stub_get_host_interface_attribute,
+    stub_create_hostif_trap_group,
+    stub_remove_hostif_trap_group,
+    stub_set_hostif_trap_group_attribute,
+    stub_get_hostif_trap_group_attribute,
+    stub_set_hostif_trap_attribute,
+    stub_get_hostif_trap_attribute,
     NULL,
     NULL,
-    NULL,
-    NULL,
-    stub_set_host_interface_trap_attribute,
-    NULL,
-    NULL,
-    NULL,
-    NULL,
-    NULL
+    stub_recv_host_interface_packet,
+    stub_send_host_interface_packet
 };
@@ -0,0 +1,1301 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#include "sai.h"
+#include "stub_sai.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_hostif.h"
+#include "assert.h"
+
+#undef  __MODULE__
+#define __MODULE__ SAI_HOSTIF_TRAP
+
+static const sai_attribute_entry_t trap_group_attribs[] = {
+    { SAI_HOSTIF_TRAP_GROUP_ATTR_ADMIN_STATE, false, true, true, true,
+      "Trap group admin state", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_HOSTIF_TRAP_GROUP_ATTR_PRIO, true, true, false, true,
+      "Trap group priority", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_HOSTIF_TRAP_GROUP_ATTR_QUEUE, false, true, true, true,
+      "Trap group CPU queue", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_HOSTIF_TRAP_GROUP_ATTR_POLICER, false, true, true, true,
+      "Trap group policer", SAI_ATTR_VAL_TYPE_OID },
+    { END_FUNCTIONALITY_ATTRIBS_ID, false, false, false, false,
+      "", SAI_ATTR_VAL_TYPE_UNDETERMINED }
+};
+
+sai_status_t stub_trap_group_u32_get(_In_ const sai_object_key_t   *key,
+                                     _Inout_ sai_attribute_value_t *value,
+                                     _In_ uint32_t                  attr_index,
+                                     _Inout_ vendor_cache_t        *cache,
+                                     void                          *arg);
+sai_status_t stub_trap_group_u32_set(_In_ const sai_object_key_t      *key,
+                                     _In_ const sai_attribute_value_t *value,
+                                     void                             *arg);
+sai_status_t stub_trap_group_admin_state_get(_In_ const sai_object_key_t   *key,
+                                             _Inout_ sai_attribute_value_t *value,
+                                             _In_ uint32_t                  attr_index,
+                                             _Inout_ vendor_cache_t        *cache,
+                                             void                          *arg);
+sai_status_t stub_trap_group_admin_state_set(_In_ const sai_object_key_t      *key,
+                                             _In_ const sai_attribute_value_t *value,
+                                             void                             *arg);
+sai_status_t stub_trap_group_policer_get(_In_ const sai_object_key_t   *key,
+                                         _Inout_ sai_attribute_value_t *value,
+                                         _In_ uint32_t                  attr_index,
+                                         _Inout_ vendor_cache_t        *cache,
+                                         void                          *arg);
+sai_status_t stub_trap_group_policer_set(_In_ const sai_object_key_t      *key,
+                                         _In_ const sai_attribute_value_t *value,
+                                         void                             *arg);
+
+static const sai_vendor_attribute_entry_t trap_group_vendor_attribs[] = {
+    { SAI_HOSTIF_TRAP_GROUP_ATTR_ADMIN_STATE,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_trap_group_admin_state_get, NULL,
+      stub_trap_group_admin_state_set, NULL },
+    { SAI_HOSTIF_TRAP_GROUP_ATTR_PRIO,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_trap_group_u32_get, (void*)SAI_HOSTIF_TRAP_GROUP_ATTR_PRIO,
+      NULL, NULL },
+    { SAI_HOSTIF_TRAP_GROUP_ATTR_QUEUE,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_trap_group_u32_get, (void*)SAI_HOSTIF_TRAP_GROUP_ATTR_QUEUE,
+      stub_trap_group_u32_set, (void*)SAI_HOSTIF_TRAP_GROUP_ATTR_QUEUE },
+    { SAI_HOSTIF_TRAP_GROUP_ATTR_POLICER,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_trap_group_policer_get, NULL,
+      stub_trap_group_policer_set, NULL },
+};
+
+static const sai_attribute_entry_t trap_attribs[] = {
+    { SAI_HOSTIF_TRAP_ATTR_PACKET_ACTION, false, false, true, true,
+      "Trap action", SAI_ATTR_VAL_TYPE_S32 },
+    { SAI_HOSTIF_TRAP_ATTR_TRAP_PRIORITY, false, false, true, true,
+      "Trap priority", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_HOSTIF_TRAP_ATTR_TRAP_CHANNEL, false, false, true, true,
+      "Trap channel", SAI_ATTR_VAL_TYPE_S32 },
+    { SAI_HOSTIF_TRAP_ATTR_FD, false, false, true, true,
+      "Trap host interface", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_HOSTIF_TRAP_ATTR_PORT_LIST, false, false, true, true,
+      "Trap port list", SAI_ATTR_VAL_TYPE_OBJLIST },
+    { SAI_HOSTIF_TRAP_ATTR_TRAP_GROUP, false, false, true, true,
+      "Trap group", SAI_ATTR_VAL_TYPE_OID },
+    { END_FUNCTIONALITY_ATTRIBS_ID, false, false, false, false,
+      "", SAI_ATTR_VAL_TYPE_UNDETERMINED }
+};
+
+sai_status_t stub_trap_attr_get(_In_ const sai_object_key_t   *key,
+                                _Inout_ sai_attribute_value_t *value,
+                                _In_ uint32_t                  attr_index,
+                                _Inout_ vendor_cache_t        *cache,
+                                void                          *arg);
+sai_status_t stub_trap_attr_set(_In_ const sai_object_key_t      *key,
+                                _In_ const sai_attribute_value_t *value,
+                                void                             *arg);
+sai_status_t stub_trap_port_list_get(_In_ const sai_object_key_t   *key,
+                                     _Inout_ sai_attribute_value_t *value,
+                                     _In_ uint32_t                  attr_index,
+                                     _Inout_ vendor_cache_t        *cache,
+                                     void                          *arg);
+sai_status_t stub_trap_port_list_set(_In_ const sai_object_key_t      *key,
+                                     _In_ const sai_attribute_value_t *value,
+                                     void                             *arg);
+sai_status_t stub_trap_group_get(_In_ const sai_object_key_t   *key,
+                                 _Inout_ sai_attribute_value_t *value,
+                                 _In_ uint32_t                  attr_index,
+                                 _Inout_ vendor_cache_t        *cache,
+                                 void                          *arg);
+sai_status_t stub_trap_group_set(_In_ const sai_object_key_t      *key,
+                                 _In_ const sai_attribute_value_t *value,
+                                 void                             *arg);
+
+static const sai_vendor_attribute_entry_t trap_vendor_attribs[] = {
+    { SAI_HOSTIF_TRAP_ATTR_PACKET_ACTION,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_trap_attr_get, (void*)SAI_HOSTIF_TRAP_ATTR_PACKET_ACTION,
+      stub_trap_attr_set, (void*)SAI_HOSTIF_TRAP_ATTR_PACKET_ACTION },
+    { SAI_HOSTIF_TRAP_ATTR_TRAP_PRIORITY,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_trap_attr_get, (void*)SAI_HOSTIF_TRAP_ATTR_TRAP_PRIORITY,
+      stub_trap_attr_set, (void*)SAI_HOSTIF_TRAP_ATTR_TRAP_PRIORITY },
+    { SAI_HOSTIF_TRAP_ATTR_TRAP_CHANNEL,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_trap_attr_get, (void*)SAI_HOSTIF_TRAP_ATTR_TRAP_CHANNEL,
+      stub_trap_attr_set, (void*)SAI_HOSTIF_TRAP_ATTR_TRAP_CHANNEL },
+    { SAI_HOSTIF_TRAP_ATTR_FD,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_trap_attr_get, (void*)SAI_HOSTIF_TRAP_ATTR_FD,
+      stub_trap_attr_set, (void*)SAI_HOSTIF_TRAP_ATTR_FD },
+    { SAI_HOSTIF_TRAP_ATTR_PORT_LIST,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_trap_port_list_get, NULL,
+      stub_trap_port_list_set, NULL },
+    { SAI_HOSTIF_TRAP_ATTR_TRAP_GROUP,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_trap_group_get, NULL,
+      stub_trap_group_set, NULL },
+};
+
+/* State DB *************/
+#define MAX_TRAP_GROUPS           64
+/* trap follows SAI_SWITCH_ATTR_DEFAULT_TRAP_GROUP */
+#define HOSTIF_TRAP_DEFAULT_GROUP UINT32_MAX
+
+#define HOSTIF_TRAP_SWITCH_COUNT  (SAI_HOSTIF_TRAP_ID_IGMP_TYPE_V3_REPORT - SAI_HOSTIF_TRAP_ID_STP + 1)
+#define HOSTIF_TRAP_ROUTER_COUNT  (SAI_HOSTIF_TRAP_ID_MLD_V2_REPORT - SAI_HOSTIF_TRAP_ID_ARP_REQUEST + 1)
+#define HOSTIF_TRAP_COUNT         (HOSTIF_TRAP_SWITCH_COUNT + HOSTIF_TRAP_ROUTER_COUNT + 1)
+
+typedef struct _stub_hostif_trap_group_t {
+    bool            is_used;
+    bool            admin_state;
+    uint32_t        prio;
+    uint32_t        queue;
+    /* policer index, STUB_NO_POLICER leaves the group unpoliced */
+    uint32_t        policer;
+    /* traps set to the group, the switch default is counted apart */
+    uint32_t        ref_count;
+    uint64_t        passed;
+    uint64_t        policed;
+} stub_hostif_trap_group_t;
+
+typedef struct _stub_hostif_trap_t {
+    sai_int32_t     action;
+    uint32_t        priority;
+    sai_int32_t     channel;
+    sai_object_id_t fd;
+    uint32_t        group;
+    bool            all_ports;
+    bool            ports[PORT_NUMBER];
+} stub_hostif_trap_t;
+
+static stub_hostif_trap_group_t trap_group_db[MAX_TRAP_GROUPS] = {
+    [0 ... MAX_TRAP_GROUPS - 1] = { .policer = STUB_NO_POLICER }
+};
+static stub_hostif_trap_t       trap_db[HOSTIF_TRAP_COUNT];
+static uint32_t                 trap_default_group;
+/* Writers take the tables exclusively, the data plane shares them per burst */
+static pthread_rwlock_t         trap_db_lock = STUB_RWLOCK_INITIALIZER;
+
+/* Trap ids by table index, with the header's default actions. ARP and ND are
+ * trapped by default, the data plane has always punted them */
+static const struct {
+    sai_hostif_trap_id_t trap_id;
+    sai_int32_t          action;
+} trap_defaults[HOSTIF_TRAP_COUNT] = {
+    { SAI_HOSTIF_TRAP_ID_STP, SAI_PACKET_ACTION_DROP },
+    { SAI_HOSTIF_TRAP_ID_LACP, SAI_PACKET_ACTION_DROP },
+    { SAI_HOSTIF_TRAP_ID_EAPOL, SAI_PACKET_ACTION_DROP },
+    { SAI_HOSTIF_TRAP_ID_LLDP, SAI_PACKET_ACTION_DROP },
+    { SAI_HOSTIF_TRAP_ID_PVRST, SAI_PACKET_ACTION_DROP },
+    { SAI_HOSTIF_TRAP_ID_IGMP_TYPE_QUERY, SAI_PACKET_ACTION_FORWARD },
+    { SAI_HOSTIF_TRAP_ID_IGMP_TYPE_LEAVE, SAI_PACKET_ACTION_FORWARD },
+    { SAI_HOSTIF_TRAP_ID_IGMP_TYPE_V1_REPORT, SAI_PACKET_ACTION_FORWARD },
+    { SAI_HOSTIF_TRAP_ID_IGMP_TYPE_V2_REPORT, SAI_PACKET_ACTION_FORWARD },
+    { SAI_HOSTIF_TRAP_ID_IGMP_TYPE_V3_REPORT, SAI_PACKET_ACTION_FORWARD },
+    { SAI_HOSTIF_TRAP_ID_ARP_REQUEST, SAI_PACKET_ACTION_TRAP },
+    { SAI_HOSTIF_TRAP_ID_ARP_RESPONSE, SAI_PACKET_ACTION_TRAP },
+    { SAI_HOSTIF_TRAP_ID_DHCP, SAI_PACKET_ACTION_FORWARD },
+    { SAI_HOSTIF_TRAP_ID_OSPF, SAI_PACKET_ACTION_FORWARD },
+    { SAI_HOSTIF_TRAP_ID_PIM, SAI_PACKET_ACTION_FORWARD },
+    { SAI_HOSTIF_TRAP_ID_VRRP, SAI_PACKET_ACTION_FORWARD },
+    { SAI_HOSTIF_TRAP_ID_BGP, SAI_PACKET_ACTION_FORWARD },
+    { SAI_HOSTIF_TRAP_ID_DHCPV6, SAI_PACKET_ACTION_FORWARD },
+    { SAI_HOSTIF_TRAP_ID_OSPFV6, SAI_PACKET_ACTION_FORWARD },
+    { SAI_HOSTIF_TRAP_ID_VRRPV6, SAI_PACKET_ACTION_FORWARD },
+    { SAI_HOSTIF_TRAP_ID_BGPV6, SAI_PACKET_ACTION_FORWARD },
+    { SAI_HOSTIF_TRAP_ID_IPV6_NEIGHBOR_DISCOVERY, SAI_PACKET_ACTION_TRAP },
+    { SAI_HOSTIF_TRAP_ID_IPV6_MLD_V1_V2, SAI_PACKET_ACTION_FORWARD },
+    { SAI_HOSTIF_TRAP_ID_IPV6_MLD_V1_REPORT, SAI_PACKET_ACTION_FORWARD },
+    { SAI_HOSTIF_TRAP_ID_IPV6_MLD_V1_DONE, SAI_PACKET_ACTION_FORWARD },
+    { SAI_HOSTIF_TRAP_ID_MLD_V2_REPORT, SAI_PACKET_ACTION_FORWARD },
+    { SAI_HOSTIF_TRAP_ID_TTL_ERROR, SAI_PACKET_ACTION_TRAP },
+};
+
+/* Table index of a trap id, false for traps the data plane does not raise */
+static inline bool trap_db_index(_In_ sai_int32_t trap_id, _Out_ uint32_t *index)
+{
+    if ((trap_id >= SAI_HOSTIF_TRAP_ID_STP) && (trap_id <= SAI_HOSTIF_TRAP_ID_IGMP_TYPE_V3_REPORT)) {
+        *index = trap_id - SAI_HOSTIF_TRAP_ID_STP;
+        return true;
+    }
+
+    if ((trap_id >= SAI_HOSTIF_TRAP_ID_ARP_REQUEST) && (trap_id <= SAI_HOSTIF_TRAP_ID_MLD_V2_REPORT)) {
+        *index = HOSTIF_TRAP_SWITCH_COUNT + trap_id - SAI_HOSTIF_TRAP_ID_ARP_REQUEST;
+        return true;
+    }
+
+    if (SAI_HOSTIF_TRAP_ID_TTL_ERROR == trap_id) {
+        *index = HOSTIF_TRAP_COUNT - 1;
+        return true;
+    }
+
+    return false;
+}
+
+/* Group a trap punts through. Caller holds trap_db_lock */
+static inline uint32_t trap_group_of(_In_ const stub_hostif_trap_t *trap)
+{
+    return (HOSTIF_TRAP_DEFAULT_GROUP == trap->group) ? trap_default_group : trap->group;
+}
+
+/* Caller holds trap_db_lock */
+static sai_status_t trap_group_db_index(_In_ sai_object_id_t trap_group_id, _Out_ uint32_t *index)
+{
+    sai_status_t status;
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(trap_group_id, SAI_OBJECT_TYPE_TRAP_GROUP, index))) {
+        return status;
+    }
+
+    if ((*index >= MAX_TRAP_GROUPS) || (!trap_group_db[*index].is_used)) {
+        STUB_LOG_ERR("Trap group %u does not exist\n", *index);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void trap_group_key_to_str(_In_ sai_object_id_t trap_group_id, _Out_ char *key_str)
+{
+    uint32_t group_id;
+
+    if (SAI_STATUS_SUCCESS != stub_object_to_type(trap_group_id, SAI_OBJECT_TYPE_TRAP_GROUP, &group_id)) {
+        snprintf(key_str, MAX_KEY_STR_LEN, "invalid trap group id");
+    } else {
+        snprintf(key_str, MAX_KEY_STR_LEN, "trap group id %u", group_id);
+    }
+}
+
+void db_init_hostif_trap(void)
+{
+    uint32_t ii;
+
+    pthread_rwlock_wrlock(&trap_db_lock);
+
+    for (ii = 0; ii < MAX_TRAP_GROUPS; ii++) {
+        trap_group_db[ii].is_used     = false;
+        trap_group_db[ii].admin_state = true;
+        trap_group_db[ii].prio        = 0;
+        trap_group_db[ii].queue       = 0;
+        trap_group_db[ii].policer     = STUB_NO_POLICER;
+        trap_group_db[ii].ref_count   = 0;
+        trap_group_db[ii].passed      = 0;
+        trap_group_db[ii].policed     = 0;
+    }
+
+    /* Group 0 is the switch default trap group, it is never removed */
+    trap_group_db[0].is_used = true;
+    trap_default_group = 0;
+
+    for (ii = 0; ii < HOSTIF_TRAP_COUNT; ii++) {
+        memset(&trap_db[ii], 0, sizeof(trap_db[ii]));
+        trap_db[ii].action    = trap_defaults[ii].action;
+        trap_db[ii].channel   = SAI_HOSTIF_TRAP_CHANNEL_CB;
+        trap_db[ii].fd        = SAI_NULL_OBJECT_ID;
+        trap_db[ii].group     = HOSTIF_TRAP_DEFAULT_GROUP;
+        trap_db[ii].all_ports = true;
+    }
+
+    pthread_rwlock_unlock(&trap_db_lock);
+}
+
+sai_object_id_t db_get_default_trap_group(void)
+{
+    sai_object_id_t trap_group_id = SAI_NULL_OBJECT_ID;
+
+    pthread_rwlock_rdlock(&trap_db_lock);
+    stub_create_object(SAI_OBJECT_TYPE_TRAP_GROUP, trap_default_group, &trap_group_id);
+    pthread_rwlock_unlock(&trap_db_lock);
+
+    return trap_group_id;
+}
+
+sai_status_t db_set_default_trap_group(_In_ sai_object_id_t trap_group_id)
+{
+    sai_status_t status;
+    uint32_t     group_id;
+
+    pthread_rwlock_wrlock(&trap_db_lock);
+
+    if (SAI_STATUS_SUCCESS == (status = trap_group_db_index(trap_group_id, &group_id))) {
+        trap_default_group = group_id;
+        STUB_LOG_NTC("Default trap group %u\n", group_id);
+    }
+
+    pthread_rwlock_unlock(&trap_db_lock);
+
+    return status;
+}
+
+/* Actions that hand the frame to the host */
+static inline bool trap_is_punted(_In_ sai_int32_t action)
+{
+    return (SAI_PACKET_ACTION_TRAP == action) || (SAI_PACKET_ACTION_LOG == action) ||
+           (SAI_PACKET_ACTION_COPY == action);
+}
+
+/* Final action of a classified frame from the trap action and the action the
+ * pipeline picked on its own */
+static sai_int32_t trap_resolve_action(_In_ sai_int32_t trap_action, _In_ const stub_packet_t *packet)
+{
+    bool forwarded = (SAI_PACKET_ACTION_FORWARD == packet->packet_action) ||
+                     (SAI_PACKET_ACTION_LOG == packet->packet_action) ||
+                     (SAI_PACKET_ACTION_COPY == packet->packet_action) ||
+                     (SAI_PACKET_ACTION_TRANSIT == packet->packet_action);
+
+    switch (trap_action) {
+    case SAI_PACKET_ACTION_TRAP:
+        /* Hosts on a VLAN interface still need the broadcast, copy it to the host */
+        return (forwarded && (SAI_NULL_OBJECT_ID == packet->out_port)) ?
+               SAI_PACKET_ACTION_LOG : SAI_PACKET_ACTION_TRAP;
+
+    case SAI_PACKET_ACTION_LOG:
+    case SAI_PACKET_ACTION_COPY:
+        return forwarded ? SAI_PACKET_ACTION_LOG : SAI_PACKET_ACTION_TRAP;
+
+    case SAI_PACKET_ACTION_DROP:
+        return SAI_PACKET_ACTION_DROP;
+
+    default:
+        return packet->packet_action;
+    }
+}
+
+/* Frames of the group that its policer dropped or that a disabled group
+ * gets keep off the host. Caller holds trap_db_lock */
+static void trap_group_police(_Inout_ stub_hostif_trap_group_t *group,
+                              _In_ uint32_t                     count,
+                              _In_ const uint32_t              *groups,
+                              _In_ uint32_t                     group_id,
+                              _In_ const bool                  *dropped,
+                              _Inout_ stub_packet_t            *packets)
+{
+    uint64_t passed = 0, policed = 0;
+    uint32_t ii;
+
+    for (ii = 0; ii < count; ii++) {
+        if (group_id != groups[ii]) {
+            continue;
+        }
+
+        if (group->admin_state && !dropped[ii]) {
+            passed++;
+            continue;
+        }
+
+        /* Policed, the frame goes on as if the trap did not match */
+        packets[ii].packet_action = (SAI_PACKET_ACTION_TRAP == packets[ii].packet_action) ?
+                                    SAI_PACKET_ACTION_DROP : SAI_PACKET_ACTION_FORWARD;
+        packets[ii].trap_id = 0;
+        policed++;
+    }
+
+    __atomic_fetch_add(&group->passed, passed, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&group->policed, policed, __ATOMIC_RELAXED);
+}
+
+/*
+ * Routine Description:
+ *    Apply the trap actions to a chunk of classified frames and police the
+ *    trapped ones with the policer of their trap group. Each policer is
+ *    taken once per chunk.
+ *
+ * Arguments:
+ *    [in] count - number of frames, at most STUB_DATAPLANE_BURST
+ *    [inout] packets - frames, trap_id set by the classifier and
+ *                      packet_action by the pipeline
+ */
+void db_apply_hostif_traps(_In_ uint32_t count, _Inout_ stub_packet_t *packets)
+{
+    uint32_t                  groups[STUB_DATAPLANE_BURST];
+    const stub_hostif_trap_t *trap;
+    stub_packet_t            *packet;
+    uint32_t                  ii, index, trapped = 0;
+
+    assert(count <= STUB_DATAPLANE_BURST);
+
+    pthread_rwlock_rdlock(&trap_db_lock);
+
+    for (ii = 0; ii < count; ii++) {
+        packet     = &packets[ii];
+        groups[ii] = HOSTIF_TRAP_DEFAULT_GROUP;
+        trap       = NULL;
+
+        if ((0 != packet->trap_id) && trap_db_index(packet->trap_id, &index)) {
+            trap = &trap_db[index];
+            if (!trap->all_ports &&
+                ((packet->in_port >> 32) >= PORT_NUMBER || !trap->ports[packet->in_port >> 32])) {
+                trap = NULL;
+            }
+        }
+
+        if ((NULL == trap) || (SAI_PACKET_ACTION_FORWARD == trap->action)) {
+            packet->trap_id = 0;
+        } else {
+            packet->packet_action = trap_resolve_action(trap->action, packet);
+        }
+
+        if (!trap_is_punted(packet->packet_action)) {
+            packet->trap_id = 0;
+            continue;
+        }
+
+        /* Traps of routes and neighbors go through the default group */
+        groups[ii] = (NULL != trap) && (0 != packet->trap_id) ? trap_group_of(trap) : trap_default_group;
+        trapped++;
+    }
+
+    if (0 != trapped) {
+        uint32_t policers[STUB_DATAPLANE_BURST];
+        bool     dropped[STUB_DATAPLANE_BURST];
+        uint32_t metered = 0, jj;
+        bool     done;
+
+        for (ii = 0; ii < count; ii++) {
+            policers[ii] = STUB_NO_POLICER;
+            dropped[ii]  = false;
+            if ((HOSTIF_TRAP_DEFAULT_GROUP != groups[ii]) && trap_group_db[groups[ii]].admin_state) {
+                policers[ii] = trap_group_db[groups[ii]].policer;
+                metered     += (STUB_NO_POLICER != policers[ii]);
+            }
+        }
+        if (0 != metered) {
+            db_apply_policers(count, policers, packets, dropped);
+        }
+
+        for (ii = 0; ii < count; ii++) {
+            if (HOSTIF_TRAP_DEFAULT_GROUP == groups[ii]) {
+                continue;
+            }
+            /* First frame of its group in the chunk polices the whole group */
+            for (jj = 0, done = false; jj < ii; jj++) {
+                if (groups[jj] == groups[ii]) {
+                    done = true;
+                    break;
+                }
+            }
+            if (!done) {
+                trap_group_police(&trap_group_db[groups[ii]], count, groups, groups[ii], dropped, packets);
+            }
+        }
+    }
+
+    pthread_rwlock_unlock(&trap_db_lock);
+}
+
+/* Where one trapped frame goes */
+typedef struct _trap_delivery_t {
+    uint32_t        packet;
+    uint32_t        queue;
+    sai_int32_t     channel;
+    sai_object_id_t hif_id;
+} trap_delivery_t;
+
+/* Write the frames of one host interface with a single lookup, frames
+ * without a host interface are dropped */
+static void trap_deliver_netdev(_In_ uint32_t                count,
+                                _In_ const trap_delivery_t *deliveries,
+                                _Inout_ bool               *handled,
+                                _In_ uint32_t                first,
+                                _In_ const stub_packet_t   *packets)
+{
+    const void     *buffers[STUB_DATAPLANE_BURST];
+    sai_size_t      sizes[STUB_DATAPLANE_BURST];
+    sai_object_id_t hif_id = deliveries[first].hif_id;
+    uint32_t        ii, frames = 0;
+
+    for (ii = first; ii < count; ii++) {
+        if (handled[ii] || (SAI_HOSTIF_TRAP_CHANNEL_CB == deliveries[ii].channel) ||
+            (hif_id != deliveries[ii].hif_id)) {
+            continue;
+        }
+        buffers[frames] = packets[deliveries[ii].packet].data;
+        sizes[frames++] = packets[deliveries[ii].packet].length;
+        handled[ii]     = true;
+    }
+
+    if ((SAI_NULL_OBJECT_ID != hif_id) &&
+        (SAI_STATUS_SUCCESS != stub_host_interface_send_bulk(hif_id, frames, buffers, sizes))) {
+        STUB_LOG_DBG("Failed to punt %u frames to the host interface\n", frames);
+    }
+}
+
+/*
+ * Routine Description:
+ *    Hand the trapped frames of a burst to the host. Frames go out ordered by
+ *    the CPU queue of their trap group, higher queues first, and frames of one
+ *    host interface are written together.
+ *
+ * Arguments:
+ *    [in] count - number of frames
+ *    [in] packets - frames after db_apply_hostif_traps
+ */
+void db_deliver_hostif_traps(_In_ uint32_t count, _In_ const stub_packet_t *packets)
+{
+    sai_packet_event_notification_fn on_packet_event = g_notification_callbacks.on_packet_event;
+    trap_delivery_t                  deliveries[STUB_DATAPLANE_BURST];
+    bool                             handled[STUB_DATAPLANE_BURST];
+    sai_attribute_t                  attrs[2];
+    const stub_hostif_trap_t        *trap;
+    const stub_packet_t             *packet;
+    trap_delivery_t                  delivery;
+    uint32_t                         ii, jj, index, base, chunk, trapped;
+
+    for (base = 0; base < count; base += chunk) {
+        chunk   = (count - base < STUB_DATAPLANE_BURST) ? count - base : STUB_DATAPLANE_BURST;
+        trapped = 0;
+
+        pthread_rwlock_rdlock(&trap_db_lock);
+
+        for (ii = base; ii < base + chunk; ii++) {
+            if (!trap_is_punted(packets[ii].packet_action)) {
+                continue;
+            }
+
+            trap             = ((0 != packets[ii].trap_id) && trap_db_index(packets[ii].trap_id, &index)) ?
+                               &trap_db[index] : NULL;
+            delivery.packet  = ii;
+            delivery.queue   = trap_group_db[(NULL != trap) ? trap_group_of(trap) : trap_default_group].queue;
+            delivery.channel = (NULL != trap) ? trap->channel : SAI_HOSTIF_TRAP_CHANNEL_CB;
+            delivery.hif_id  = ((NULL != trap) && (SAI_HOSTIF_TRAP_CHANNEL_FD == trap->channel)) ?
+                               trap->fd : SAI_NULL_OBJECT_ID;
+
+            /* Stable insert, higher queues first */
+            for (jj = trapped; (jj > 0) && (deliveries[jj - 1].queue < delivery.queue); jj--) {
+                deliveries[jj] = deliveries[jj - 1];
+            }
+            deliveries[jj] = delivery;
+            trapped++;
+        }
+
+        pthread_rwlock_unlock(&trap_db_lock);
+
+        /* Netdev traps go to the host interface of the ingress port */
+        for (ii = 0; ii < trapped; ii++) {
+            handled[ii] = false;
+            if ((SAI_HOSTIF_TRAP_CHANNEL_NETDEV == deliveries[ii].channel) &&
+                (SAI_STATUS_SUCCESS !=
+                 db_get_host_interface_by_port(packets[deliveries[ii].packet].in_port, &deliveries[ii].hif_id))) {
+                deliveries[ii].hif_id = SAI_NULL_OBJECT_ID;
+            }
+        }
+
+        for (ii = 0; ii < trapped; ii++) {
+            if (handled[ii]) {
+                continue;
+            }
+            if (SAI_HOSTIF_TRAP_CHANNEL_CB != deliveries[ii].channel) {
+                trap_deliver_netdev(trapped, deliveries, handled, ii, packets);
+                continue;
+            }
+            if (NULL == on_packet_event) {
+                continue;
+            }
+
+            packet             = &packets[deliveries[ii].packet];
+            attrs[0].id        = SAI_HOSTIF_PACKET_TRAP_ID;
+            attrs[0].value.s32 = packet->trap_id;
+            attrs[1].id        = SAI_HOSTIF_PACKET_INGRESS_PORT;
+            attrs[1].value.oid = packet->in_port;
+
+            on_packet_event(packet->data, packet->length, 2, attrs);
+        }
+    }
+}
+
+/*
+ * Routine Description:
+ *    Create host interface trap group
+ *
+ * Arguments:
+ *    [out] hostif_trap_group_id - trap group id
+ *    [in] attr_count - number of attributes
+ *    [in] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_create_hostif_trap_group(_Out_ sai_object_id_t     *hostif_trap_group_id,
+                                           _In_ uint32_t               attr_count,
+                                           _In_ const sai_attribute_t *attr_list)
+{
+    const sai_attribute_value_t *admin_state, *prio, *queue, *policer_id;
+    uint32_t                     admin_state_index, prio_index, queue_index, policer_index;
+    stub_hostif_trap_group_t    *group;
+    sai_status_t                 status;
+    uint32_t                     group_id, policer = STUB_NO_POLICER;
+    char                         list_str[MAX_LIST_VALUE_STR_LEN];
+    char                         key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    if (NULL == hostif_trap_group_id) {
+        STUB_LOG_ERR("NULL trap group id param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS !=
+        (status =
+             check_attribs_metadata(attr_count, attr_list, trap_group_attribs, trap_group_vendor_attribs,
+                                    SAI_OPERATION_CREATE))) {
+        STUB_LOG_ERR("Failed attribs check\n");
+        return status;
+    }
+
+    sai_attr_list_to_str(attr_count, attr_list, trap_group_attribs, MAX_LIST_VALUE_STR_LEN, list_str);
+    STUB_LOG_NTC("Create trap group, %s\n", list_str);
+
+    assert(SAI_STATUS_SUCCESS ==
+           find_attrib_in_list(attr_count, attr_list, SAI_HOSTIF_TRAP_GROUP_ATTR_PRIO, &prio, &prio_index));
+
+    if ((SAI_STATUS_SUCCESS ==
+         find_attrib_in_list(attr_count, attr_list, SAI_HOSTIF_TRAP_GROUP_ATTR_POLICER, &policer_id,
+                             &policer_index)) &&
+        (SAI_NULL_OBJECT_ID != policer_id->oid) &&
+        (SAI_STATUS_SUCCESS != db_policer_bind(policer_id->oid, &policer))) {
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + policer_index;
+    }
+
+    pthread_rwlock_wrlock(&trap_db_lock);
+
+    for (group_id = 0; group_id < MAX_TRAP_GROUPS; group_id++) {
+        if (!trap_group_db[group_id].is_used) {
+            break;
+        }
+    }
+
+    if (MAX_TRAP_GROUPS == group_id) {
+        pthread_rwlock_unlock(&trap_db_lock);
+        db_policer_unbind(policer);
+        STUB_LOG_ERR("Trap group table full\n");
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    group              = &trap_group_db[group_id];
+    group->is_used     = true;
+    group->prio        = prio->u32;
+    group->admin_state = (SAI_STATUS_SUCCESS ==
+                          find_attrib_in_list(attr_count, attr_list, SAI_HOSTIF_TRAP_GROUP_ATTR_ADMIN_STATE,
+                                              &admin_state, &admin_state_index)) ? admin_state->booldata : true;
+    group->queue = (SAI_STATUS_SUCCESS ==
+                    find_attrib_in_list(attr_count, attr_list, SAI_HOSTIF_TRAP_GROUP_ATTR_QUEUE, &queue,
+                                        &queue_index)) ? queue->u32 : 0;
+    group->policer   = policer;
+    group->ref_count = 0;
+    group->passed    = 0;
+    group->policed   = 0;
+
+    pthread_rwlock_unlock(&trap_db_lock);
+
+    if (SAI_STATUS_SUCCESS !=
+        (status = stub_create_object(SAI_OBJECT_TYPE_TRAP_GROUP, group_id, hostif_trap_group_id))) {
+        return status;
+    }
+    trap_group_key_to_str(*hostif_trap_group_id, key_str);
+    STUB_LOG_NTC("Created trap group %s\n", key_str);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Remove host interface trap group
+ *
+ * Arguments:
+ *    [in] hostif_trap_group_id - trap group id
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_remove_hostif_trap_group(_In_ sai_object_id_t hostif_trap_group_id)
+{
+    char         key_str[MAX_KEY_STR_LEN];
+    sai_status_t status;
+    uint32_t     group_id, policer;
+
+    STUB_LOG_ENTER();
+
+    trap_group_key_to_str(hostif_trap_group_id, key_str);
+    STUB_LOG_NTC("Remove trap group %s\n", key_str);
+
+    pthread_rwlock_wrlock(&trap_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = trap_group_db_index(hostif_trap_group_id, &group_id))) {
+        pthread_rwlock_unlock(&trap_db_lock);
+        return status;
+    }
+
+    if ((trap_default_group == group_id) || (0 != trap_group_db[group_id].ref_count)) {
+        pthread_rwlock_unlock(&trap_db_lock);
+        STUB_LOG_ERR("Trap group %u is in use\n", group_id);
+        return SAI_STATUS_OBJECT_IN_USE;
+    }
+
+    trap_group_db[group_id].is_used = false;
+    policer                         = trap_group_db[group_id].policer;
+    trap_group_db[group_id].policer = STUB_NO_POLICER;
+
+    pthread_rwlock_unlock(&trap_db_lock);
+
+    db_policer_unbind(policer);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Set host interface trap group attribute
+ *
+ * Arguments:
+ *    [in] hostif_trap_group_id - trap group id
+ *    [in] attr - attribute
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_set_hostif_trap_group_attribute(_In_ sai_object_id_t        hostif_trap_group_id,
+                                                  _In_ const sai_attribute_t *attr)
+{
+    const sai_object_key_t key = { .object_id = hostif_trap_group_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    trap_group_key_to_str(hostif_trap_group_id, key_str);
+    return sai_set_attribute(&key, key_str, trap_group_attribs, trap_group_vendor_attribs, attr);
+}
+
+/*
+ * Routine Description:
+ *    Get host interface trap group attribute
+ *
+ * Arguments:
+ *    [in] hostif_trap_group_id - trap group id
+ *    [in] attr_count - number of attributes
+ *    [inout] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_hostif_trap_group_attribute(_In_ sai_object_id_t     hostif_trap_group_id,
+                                                  _In_ uint32_t            attr_count,
+                                                  _Inout_ sai_attribute_t *attr_list)
+{
+    const sai_object_key_t key = { .object_id = hostif_trap_group_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
+
+    STUB_LOG_ENTER();
+
+    trap_group_key_to_str(hostif_trap_group_id, key_str);
+
+    pthread_rwlock_rdlock(&trap_db_lock);
+    status = sai_get_attributes(&key, key_str, trap_group_attribs, trap_group_vendor_attribs, attr_count, attr_list);
+    pthread_rwlock_unlock(&trap_db_lock);
+
+    return status;
+}
+
+/* Admin Mode [bool] */
+sai_status_t stub_trap_group_admin_state_get(_In_ const sai_object_key_t   *key,
+                                             _Inout_ sai_attribute_value_t *value,
+                                             _In_ uint32_t                  attr_index,
+                                             _Inout_ vendor_cache_t        *cache,
+                                             void                          *arg)
+{
+    sai_status_t status;
+    uint32_t     group_id;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = trap_group_db_index(key->object_id, &group_id))) {
+        return status;
+    }
+
+    value->booldata = trap_group_db[group_id].admin_state;
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Admin Mode [bool] */
+sai_status_t stub_trap_group_admin_state_set(_In_ const sai_object_key_t      *key,
+                                             _In_ const sai_attribute_value_t *value,
+                                             void                             *arg)
+{
+    sai_status_t status;
+    uint32_t     group_id;
+
+    STUB_LOG_ENTER();
+
+    pthread_rwlock_wrlock(&trap_db_lock);
+
+    if (SAI_STATUS_SUCCESS == (status = trap_group_db_index(key->object_id, &group_id))) {
+        trap_group_db[group_id].admin_state = value->booldata;
+    }
+
+    pthread_rwlock_unlock(&trap_db_lock);
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* group priority [uint32_t], cpu egress queue [uint32_t] */
+sai_status_t stub_trap_group_u32_get(_In_ const sai_object_key_t   *key,
+                                     _Inout_ sai_attribute_value_t *value,
+                                     _In_ uint32_t                  attr_index,
+                                     _Inout_ vendor_cache_t        *cache,
+                                     void                          *arg)
+{
+    sai_status_t status;
+    uint32_t     group_id;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = trap_group_db_index(key->object_id, &group_id))) {
+        return status;
+    }
+
+    value->u32 = (SAI_HOSTIF_TRAP_GROUP_ATTR_PRIO == (long)arg) ?
+                 trap_group_db[group_id].prio : trap_group_db[group_id].queue;
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/* cpu egress queue [uint32_t] */
+sai_status_t stub_trap_group_u32_set(_In_ const sai_object_key_t      *key,
+                                     _In_ const sai_attribute_value_t *value,
+                                     void                             *arg)
+{
+    sai_status_t status;
+    uint32_t     group_id;
+
+    STUB_LOG_ENTER();
+
+    pthread_rwlock_wrlock(&trap_db_lock);
+
+    if (SAI_STATUS_SUCCESS == (status = trap_group_db_index(key->object_id, &group_id))) {
+        trap_group_db[group_id].queue = value->u32;
+    }
+
+    pthread_rwlock_unlock(&trap_db_lock);
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* sai policer object id [sai_object_id_t], SAI_NULL_OBJECT_ID leaves the
+ * group unpoliced */
+sai_status_t stub_trap_group_policer_get(_In_ const sai_object_key_t   *key,
+                                         _Inout_ sai_attribute_value_t *value,
+                                         _In_ uint32_t                  attr_index,
+                                         _Inout_ vendor_cache_t        *cache,
+                                         void                          *arg)
+{
+    sai_status_t status;
+    uint32_t     group_id;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = trap_group_db_index(key->object_id, &group_id))) {
+        return status;
+    }
+
+    value->oid = SAI_NULL_OBJECT_ID;
+    if (STUB_NO_POLICER != trap_group_db[group_id].policer) {
+        status = stub_create_object(SAI_OBJECT_TYPE_POLICER, trap_group_db[group_id].policer, &value->oid);
+    }
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* sai policer object id [sai_object_id_t], SAI_NULL_OBJECT_ID leaves the
+ * group unpoliced */
+sai_status_t stub_trap_group_policer_set(_In_ const sai_object_key_t      *key,
+                                         _In_ const sai_attribute_value_t *value,
+                                         void                             *arg)
+{
+    sai_status_t status;
+    uint32_t     group_id, policer = STUB_NO_POLICER, old;
+
+    STUB_LOG_ENTER();
+
+    if ((SAI_NULL_OBJECT_ID != value->oid) &&
+        (SAI_STATUS_SUCCESS != (status = db_policer_bind(value->oid, &policer)))) {
+        return status;
+    }
+
+    pthread_rwlock_wrlock(&trap_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = trap_group_db_index(key->object_id, &group_id))) {
+        pthread_rwlock_unlock(&trap_db_lock);
+        db_policer_unbind(policer);
+        return status;
+    }
+
+    old                             = trap_group_db[group_id].policer;
+    trap_group_db[group_id].policer = policer;
+
+    pthread_rwlock_unlock(&trap_db_lock);
+
+    db_policer_unbind(old);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Read the counters of a trap group
+ *
+ * Arguments:
+ *    [in] trap_group_id - trap group id
+ *    [out] stats - counters
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_host_interface_get_trap_group_stats(_In_ sai_object_id_t                  trap_group_id,
+                                                      _Out_ stub_hostif_trap_group_stats_t *stats)
+{
+    sai_status_t status;
+    uint32_t     group_id;
+
+    if (NULL == stats) {
+        STUB_LOG_ERR("NULL stats param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    pthread_rwlock_rdlock(&trap_db_lock);
+
+    if (SAI_STATUS_SUCCESS == (status = trap_group_db_index(trap_group_id, &group_id))) {
+        stats->passed  = __atomic_load_n(&trap_group_db[group_id].passed, __ATOMIC_RELAXED);
+        stats->policed = __atomic_load_n(&trap_group_db[group_id].policed, __ATOMIC_RELAXED);
+    }
+
+    pthread_rwlock_unlock(&trap_db_lock);
+
+    return status;
+}
+
+static void trap_key_to_str(_In_ sai_hostif_trap_id_t hostif_trapid, _Out_ char *key_str)
+{
+    snprintf(key_str, MAX_KEY_STR_LEN, "trap id 0x%x", hostif_trapid);
+}
+
+/*
+ * Routine Description:
+ *    Set trap attribute value.
+ *
+ * Arguments:
+ *    [in] hostif_trapid - host interface trap id
+ *    [in] attr - attribute
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_set_hostif_trap_attribute(_In_ sai_hostif_trap_id_t   hostif_trapid,
+                                            _In_ const sai_attribute_t *attr)
+{
+    const sai_object_key_t key = { .object_id = hostif_trapid };
+    char                   key_str[MAX_KEY_STR_LEN];
+    uint32_t               index;
+
+    STUB_LOG_ENTER();
+
+    if (!trap_db_index(hostif_trapid, &index)) {
+        STUB_LOG_ERR("Unsupported trap id 0x%x\n", hostif_trapid);
+        return SAI_STATUS_NOT_SUPPORTED;
+    }
+
+    trap_key_to_str(hostif_trapid, key_str);
+    return sai_set_attribute(&key, key_str, trap_attribs, trap_vendor_attribs, attr);
+}
+
+/*
+ * Routine Description:
+ *    Get trap attribute value.
+ *
+ * Arguments:
+ *    [in] hostif_trapid - host interface trap id
+ *    [in] attr_count - number of attributes
+ *    [inout] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_hostif_trap_attribute(_In_ sai_hostif_trap_id_t hostif_trapid,
+                                            _In_ uint32_t             attr_count,
+                                            _Inout_ sai_attribute_t  *attr_list)
+{
+    const sai_object_key_t key = { .object_id = hostif_trapid };
+    char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
+    uint32_t               index;
+
+    STUB_LOG_ENTER();
+
+    if (!trap_db_index(hostif_trapid, &index)) {
+        STUB_LOG_ERR("Unsupported trap id 0x%x\n", hostif_trapid);
+        return SAI_STATUS_NOT_SUPPORTED;
+    }
+
+    trap_key_to_str(hostif_trapid, key_str);
+
+    pthread_rwlock_rdlock(&trap_db_lock);
+    status = sai_get_attributes(&key, key_str, trap_attribs, trap_vendor_attribs, attr_count, attr_list);
+    pthread_rwlock_unlock(&trap_db_lock);
+
+    return status;
+}
+
+/* trap action [sai_packet_action_t], trap priority [sai_uint32_t],
+ * trap channel [sai_hostif_trap_channel_t], file descriptor [sai_object_id_t] */
+sai_status_t stub_trap_attr_get(_In_ const sai_object_key_t   *key,
+                                _Inout_ sai_attribute_value_t *value,
+                                _In_ uint32_t                  attr_index,
+                                _Inout_ vendor_cache_t        *cache,
+                                void                          *arg)
+{
+    const stub_hostif_trap_t *trap;
+    uint32_t                  index;
+
+    STUB_LOG_ENTER();
+
+    assert(trap_db_index((sai_int32_t)key->object_id, &index));
+    trap = &trap_db[index];
+
+    switch ((long)arg) {
+    case SAI_HOSTIF_TRAP_ATTR_PACKET_ACTION:
+        value->s32 = trap->action;
+        break;
+
+    case SAI_HOSTIF_TRAP_ATTR_TRAP_PRIORITY:
+        value->u32 = trap->priority;
+        break;
+
+    case SAI_HOSTIF_TRAP_ATTR_TRAP_CHANNEL:
+        value->s32 = trap->channel;
+        break;
+
+    case SAI_HOSTIF_TRAP_ATTR_FD:
+        value->oid = trap->fd;
+        break;
+    }
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/* trap action [sai_packet_action_t], trap priority [sai_uint32_t],
+ * trap channel [sai_hostif_trap_channel_t], file descriptor [sai_object_id_t] */
+sai_status_t stub_trap_attr_set(_In_ const sai_object_key_t      *key,
+                                _In_ const sai_attribute_value_t *value,
+                                void                             *arg)
+{
+    stub_hostif_trap_t *trap;
+    sai_status_t        status = SAI_STATUS_SUCCESS;
+    uint32_t            index, hif_index;
+
+    STUB_LOG_ENTER();
+
+    assert(trap_db_index((sai_int32_t)key->object_id, &index));
+
+    if ((SAI_HOSTIF_TRAP_ATTR_FD == (long)arg) && (SAI_NULL_OBJECT_ID != value->oid) &&
+        (SAI_STATUS_SUCCESS != (status = stub_object_to_type(value->oid, SAI_OBJECT_TYPE_HOST_INTERFACE,
+                                                             &hif_index)))) {
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    pthread_rwlock_wrlock(&trap_db_lock);
+
+    trap = &trap_db[index];
+
+    switch ((long)arg) {
+    case SAI_HOSTIF_TRAP_ATTR_PACKET_ACTION:
+        if ((SAI_PACKET_ACTION_DROP != value->s32) && (SAI_PACKET_ACTION_FORWARD != value->s32) &&
+            (SAI_PACKET_ACTION_TRAP != value->s32) && (SAI_PACKET_ACTION_LOG != value->s32) &&
+            (SAI_PACKET_ACTION_COPY != value->s32)) {
+            STUB_LOG_ERR("Invalid trap action %d\n", value->s32);
+            status = SAI_STATUS_INVALID_ATTR_VALUE_0;
+            break;
+        }
+        trap->action = value->s32;
+        break;
+
+    case SAI_HOSTIF_TRAP_ATTR_TRAP_PRIORITY:
+        trap->priority = value->u32;
+        break;
+
+    case SAI_HOSTIF_TRAP_ATTR_TRAP_CHANNEL:
+        if ((SAI_HOSTIF_TRAP_CHANNEL_FD != value->s32) && (SAI_HOSTIF_TRAP_CHANNEL_CB != value->s32) &&
+            (SAI_HOSTIF_TRAP_CHANNEL_NETDEV != value->s32)) {
+            STUB_LOG_ERR("Invalid trap channel %d\n", value->s32);
+            status = SAI_STATUS_INVALID_ATTR_VALUE_0;
+            break;
+        }
+        /* The host interface has to be set before the channel */
+        if ((SAI_HOSTIF_TRAP_CHANNEL_FD == value->s32) && (SAI_NULL_OBJECT_ID == trap->fd)) {
+            STUB_LOG_ERR("Trap channel FD without a host interface\n");
+            status = SAI_STATUS_INVALID_ATTR_VALUE_0;
+            break;
+        }
+        trap->channel = value->s32;
+        break;
+
+    case SAI_HOSTIF_TRAP_ATTR_FD:
+        trap->fd = value->oid;
+        break;
+    }
+
+    pthread_rwlock_unlock(&trap_db_lock);
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* enable trap for a list of SAI ports [sai_object_list_t] */
+sai_status_t stub_trap_port_list_get(_In_ const sai_object_key_t   *key,
+                                     _Inout_ sai_attribute_value_t *value,
+                                     _In_ uint32_t                  attr_index,
+                                     _Inout_ vendor_cache_t        *cache,
+                                     void                          *arg)
+{
+    const stub_hostif_trap_t *trap;
+    sai_object_id_t           ports[PORT_NUMBER];
+    uint32_t                  index, ii, count = 0;
+
+    STUB_LOG_ENTER();
+
+    assert(trap_db_index((sai_int32_t)key->object_id, &index));
+    trap = &trap_db[index];
+
+    for (ii = 0; ii < PORT_NUMBER; ii++) {
+        if (trap->all_ports || trap->ports[ii]) {
+            stub_create_object(SAI_OBJECT_TYPE_PORT, ii, &ports[count++]);
+        }
+    }
+
+    STUB_LOG_EXIT();
+    return stub_fill_objlist(ports, count, &value->objlist);
+}
+
+/* enable trap for a list of SAI ports [sai_object_list_t], an empty list
+ * enables the trap on all ports again */
+sai_status_t stub_trap_port_list_set(_In_ const sai_object_key_t      *key,
+                                     _In_ const sai_attribute_value_t *value,
+                                     void                             *arg)
+{
+    bool     ports[PORT_NUMBER] = { false };
+    uint32_t index, ii, port;
+
+    STUB_LOG_ENTER();
+
+    assert(trap_db_index((sai_int32_t)key->object_id, &index));
+
+    for (ii = 0; ii < value->objlist.count; ii++) {
+        if ((SAI_STATUS_SUCCESS != stub_object_to_type(value->objlist.list[ii], SAI_OBJECT_TYPE_PORT, &port)) ||
+            (port >= PORT_NUMBER)) {
+            STUB_LOG_ERR("Invalid port at trap port list index %u\n", ii);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        ports[port] = true;
+    }
+
+    pthread_rwlock_wrlock(&trap_db_lock);
+    memcpy(trap_db[index].ports, ports, sizeof(ports));
+    trap_db[index].all_ports = (0 == value->objlist.count);
+    pthread_rwlock_unlock(&trap_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/* trap-group ID for the trap [sai_object_id_t] */
+sai_status_t stub_trap_group_get(_In_ const sai_object_key_t   *key,
+                                 _Inout_ sai_attribute_value_t *value,
+                                 _In_ uint32_t                  attr_index,
+                                 _Inout_ vendor_cache_t        *cache,
+                                 void                          *arg)
+{
+    uint32_t index;
+
+    STUB_LOG_ENTER();
+
+    assert(trap_db_index((sai_int32_t)key->object_id, &index));
+
+    STUB_LOG_EXIT();
+    return stub_create_object(SAI_OBJECT_TYPE_TRAP_GROUP, trap_group_of(&trap_db[index]), &value->oid);
+}
+
+/* trap-group ID for the trap [sai_object_id_t], SAI_NULL_OBJECT_ID follows the
+ * switch default trap group again */
+sai_status_t stub_trap_group_set(_In_ const sai_object_key_t      *key,
+                                 _In_ const sai_attribute_value_t *value,
+                                 void                             *arg)
+{
+    stub_hostif_trap_t *trap;
+    sai_status_t        status;
+    uint32_t            index, group_id = HOSTIF_TRAP_DEFAULT_GROUP;
+
+    STUB_LOG_ENTER();
+
+    assert(trap_db_index((sai_int32_t)key->object_id, &index));
+
+    pthread_rwlock_wrlock(&trap_db_lock);
+
+    if ((SAI_NULL_OBJECT_ID != value->oid) &&
+        (SAI_STATUS_SUCCESS != (status = trap_group_db_index(value->oid, &group_id)))) {
+        pthread_rwlock_unlock(&trap_db_lock);
+        return status;
+    }
+
+    trap = &trap_db[index];
+    if (HOSTIF_TRAP_DEFAULT_GROUP != trap->group) {
+        trap_group_db[trap->group].ref_count--;
+    }
+    if (HOSTIF_TRAP_DEFAULT_GROUP != group_id) {
+        trap_group_db[group_id].ref_count++;
+    }
+    trap->group = group_id;
+
+    pthread_rwlock_unlock(&trap_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
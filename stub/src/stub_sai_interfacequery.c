@@ -121,20 +121,20 @@ sai_status_t sai_api_query(_In_ sai_api_t sai_api_id, _Out_ void** api_method_ta
         return SAI_STATUS_SUCCESS;
 
     case SAI_API_QOS_MAPS:
-        /* TODO : implement */
-        return SAI_STATUS_NOT_IMPLEMENTED;
+        *(const sai_qos_map_api_t**)api_method_table = &qos_map_api;
+        return SAI_STATUS_SUCCESS;
 
     case SAI_API_ACL:
-        /* TODO : implement */
-        return SAI_STATUS_NOT_IMPLEMENTED;
+        *(const sai_acl_api_t**)api_method_table = &acl_api;
+        return SAI_STATUS_SUCCESS;
 
     case SAI_API_HOST_INTERFACE:
         *(const sai_hostif_api_t**)api_method_table = &host_interface_api;
         return SAI_STATUS_SUCCESS;
 
     case SAI_API_MIRROR:
-        /* TODO : implement */
-        return SAI_STATUS_NOT_IMPLEMENTED;
+        *(const sai_mirror_api_t**)api_method_table = &mirror_api;
+        return SAI_STATUS_SUCCESS;
 
     case SAI_API_SAMPLEPACKET:
         /* TODO : implement */
@@ -148,6 +148,38 @@ sai_status_t sai_api_query(_In_ sai_api_t sai_api_id, _Out_ void** api_method_ta
         *(const sai_lag_api_t**)api_method_table = &lag_api;
         return SAI_STATUS_SUCCESS;
 
+    case SAI_API_POLICER:
+        *(const sai_policer_api_t**)api_method_table = &policer_api;
+        return SAI_STATUS_SUCCESS;
+
+    case SAI_API_HASH:
+        *(const sai_hash_api_t**)api_method_table = &hash_api;
+        return SAI_STATUS_SUCCESS;
+
+    case SAI_API_UDF:
+        *(const sai_udf_api_t**)api_method_table = &udf_api;
+        return SAI_STATUS_SUCCESS;
+
+    case SAI_API_QUEUE:
+        *(const sai_queue_api_t**)api_method_table = &queue_api;
+        return SAI_STATUS_SUCCESS;
+
+    case SAI_API_SCHEDULER:
+        *(const sai_scheduler_api_t**)api_method_table = &scheduler_api;
+        return SAI_STATUS_SUCCESS;
+
+    case SAI_API_SCHEDULER_GROUP:
+        *(const sai_scheduler_group_api_t**)api_method_table = &scheduler_group_api;
+        return SAI_STATUS_SUCCESS;
+
+    case SAI_API_WRED:
+        *(const sai_wred_api_t**)api_method_table = &wred_api;
+        return SAI_STATUS_SUCCESS;
+
+    case SAI_API_BUFFERS:
+        *(const sai_buffer_api_t**)api_method_table = &buffer_api;
+        return SAI_STATUS_SUCCESS;
+
     default:
         fprintf(stderr, "Invalid API type %d\n", sai_api_id);
         return SAI_STATUS_INVALID_PARAMETER;
@@ -264,6 +296,30 @@ sai_status_t sai_log_set(_In_ sai_api_t sai_api_id, _In_ sai_log_level_t log_lev
     case SAI_API_LAG:
         break;
 
+    case SAI_API_POLICER:
+        break;
+
+    case SAI_API_HASH:
+        break;
+
+    case SAI_API_UDF:
+        break;
+
+    case SAI_API_QUEUE:
+        break;
+
+    case SAI_API_SCHEDULER:
+        break;
+
+    case SAI_API_SCHEDULER_GROUP:
+        break;
+
+    case SAI_API_WRED:
+        break;
+
+    case SAI_API_BUFFERS:
+        break;
+
     default:
         fprintf(stderr, "Invalid API type %d\n", sai_api_id);
         return SAI_STATUS_INVALID_PARAMETER;
@@ -66,6 +66,8 @@ typedef struct lag_db_t {
 } lag_db;
 
 static lag_db lags_array;
+/* Protects lags_array, writers are exclusive, attribute gets are shared */
+static pthread_rwlock_t lag_db_lock = STUB_RWLOCK_INITIALIZER;
 
 static sai_int8_t find_free_lag()
 {
@@ -108,19 +110,27 @@ sai_status_t stub_create_lag(
         return status;
     }
 
+    pthread_rwlock_wrlock(&lag_db_lock);
+
     sai_int8_t lag_indx = find_free_lag();
     if (lag_indx < 0)
     {
+        pthread_rwlock_unlock(&lag_db_lock);
         printf("Cannot create LAG: limit is reached\n");
         return SAI_STATUS_FAILURE;
     }
 
     status = stub_create_object(SAI_OBJECT_TYPE_LAG, lag_indx, lag_id);
     if (status != SAI_STATUS_SUCCESS) {
+        pthread_rwlock_unlock(&lag_db_lock);
         printf("Cannot create a LAG OID\n");
+        return status;
     }
 
     lags_array.lags[lag_indx].is_used = true;
+
+    pthread_rwlock_unlock(&lag_db_lock);
+
     printf("Created on index %i\n", lag_indx);
 
     char list_str[MAX_LIST_VALUE_STR_LEN];
@@ -134,7 +144,7 @@ static sai_int8_t get_lag_index(sai_object_id_t lag_id)
 {
     uint32_t lag_index;
     sai_status_t status = stub_object_to_type(lag_id, SAI_OBJECT_TYPE_LAG, &lag_index);
-    if (status != SAI_STATUS_SUCCESS)
+    if (status != SAI_STATUS_SUCCESS || lag_index >= MAX_NUMBER_OF_LAGS)
     {
         printf("Cannot get LAG DB index.\n");
         return -1;
@@ -147,7 +157,7 @@ static sai_int8_t get_lag_member_index(sai_object_id_t lag_member_id)
 {
     uint32_t lag_member_index;
     sai_status_t status = stub_object_to_type(lag_member_id, SAI_OBJECT_TYPE_LAG_MEMBER, &lag_member_index);
-    if (status != SAI_STATUS_SUCCESS) {
+    if (status != SAI_STATUS_SUCCESS || lag_member_index >= MAX_NUMBER_OF_LAG_MEMBERS) {
         printf("Cannot get LAG member DB index.\n");
         return -1;
     }
@@ -155,15 +165,47 @@ static sai_int8_t get_lag_member_index(sai_object_id_t lag_member_id)
     return lag_member_index;
 }
 
+/* Member port of a LAG the hash picks, members taken in member index order */
+sai_status_t db_select_lag_member(_In_ sai_object_id_t   lag_id,
+                                  _In_ uint32_t          hash,
+                                  _Out_ sai_object_id_t *port_id)
+{
+    sai_object_id_t ports[MAX_NUMBER_OF_LAG_MEMBERS];
+    uint32_t        count = 0, ii;
+
+    pthread_rwlock_rdlock(&lag_db_lock);
+
+    for (ii = 0; ii < MAX_NUMBER_OF_LAG_MEMBERS; ii++) {
+        if (lags_array.members[ii].is_ised && (lag_id == lags_array.members[ii].lag_oid)) {
+            ports[count++] = lags_array.members[ii].port_oid;
+        }
+    }
+
+    if (0 != count) {
+        *port_id = ports[hash % count];
+    }
+
+    pthread_rwlock_unlock(&lag_db_lock);
+
+    return (0 != count) ? SAI_STATUS_SUCCESS : SAI_STATUS_ITEM_NOT_FOUND;
+}
+
 sai_status_t stub_remove_lag(_In_ sai_object_id_t  lag_id)
 {
-    sai_int8_t lag_index = get_lag_index(lag_id);
-    if (lag_index < 0)
+    sai_int8_t lag_index;
+
+    pthread_rwlock_wrlock(&lag_db_lock);
+
+    lag_index = get_lag_index(lag_id);
+    if (lag_index < 0 || !lags_array.lags[lag_index].is_used)
     {
+        pthread_rwlock_unlock(&lag_db_lock);
+        printf("Failed to remove lag 0x%lX: it does not exist.\n", lag_id);
         return SAI_STATUS_FAILURE;
     }
 
     lags_array.lags[lag_index].is_used = false;
+    pthread_rwlock_unlock(&lag_db_lock);
 
     printf("REMOVED LAG: 0x%08lX\n", lag_id);
 
@@ -191,6 +233,7 @@ sai_status_t stub_get_lag_attribute(
 
     assert(SAI_STATUS_SUCCESS == find_attrib_in_list(attr_count, attr_list, SAI_LAG_ATTR_PORT_LIST, &unused, &indx));
 
+    pthread_rwlock_rdlock(&lag_db_lock);
     for (i = 0; i < MAX_NUMBER_OF_LAG_MEMBERS && count < attr_list[indx].value.objlist.count; ++i)
     {
         if (lags_array.members[i].is_ised && lags_array.members[i].lag_oid == lag_id)
@@ -200,6 +243,7 @@ sai_status_t stub_get_lag_attribute(
             count++;
         }
     }
+    pthread_rwlock_unlock(&lag_db_lock);
 
     // update count
     attr_list[indx].value.objlist.count = count;
@@ -234,9 +278,12 @@ sai_status_t stub_create_lag_member(
     assert(SAI_STATUS_SUCCESS == find_attrib_in_list(attr_count, attr_list, SAI_LAG_MEMBER_ATTR_LAG_ID, &lag_oid, &indx));
     assert(SAI_STATUS_SUCCESS == find_attrib_in_list(attr_count, attr_list, SAI_LAG_MEMBER_ATTR_PORT_ID, &lag_member_port, &indx));
 
+    pthread_rwlock_wrlock(&lag_db_lock);
+
     lag_index = get_lag_index(lag_oid->oid);
     if (lag_index < 0 || !lags_array.lags[lag_index].is_used)
     {
+        pthread_rwlock_unlock(&lag_db_lock);
         printf("Failed to create a lag member: lag 0x%lX does not exist.\n", lag_oid->oid);
         return SAI_STATUS_FAILURE;
     }
@@ -244,17 +291,26 @@ sai_status_t stub_create_lag_member(
     member_indx = get_free_lag_member();
     if (member_indx < 0)
     {
+        pthread_rwlock_unlock(&lag_db_lock);
         printf("Failed to create a lag member: limit reached.\n");
         return SAI_STATUS_FAILURE;
     }
 
     status = stub_create_object(SAI_OBJECT_TYPE_LAG_MEMBER, member_indx, lag_member_id);
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        pthread_rwlock_unlock(&lag_db_lock);
+        printf("Failed to create a lag member OID.\n");
+        return status;
+    }
 
     lags_array.lags[lag_index].members_ids[member_indx] = *lag_member_id;
     lags_array.members[member_indx].is_ised = true;
     lags_array.members[member_indx].port_oid = lag_member_port->oid;
     lags_array.members[member_indx].lag_oid = lag_oid->oid;
 
+    pthread_rwlock_unlock(&lag_db_lock);
+
     char list_str[MAX_LIST_VALUE_STR_LEN];
     sai_attr_list_to_str(attr_count, attr_list, lag_member_attribs, MAX_LIST_VALUE_STR_LEN, list_str);
 
@@ -276,12 +332,19 @@ sai_status_t stub_remove_lag_member(
         return SAI_STATUS_FAILURE;
     }
 
+    pthread_rwlock_wrlock(&lag_db_lock);
+
     lags_array.members[lag_member_indx].is_ised = false;
     lag_indx = get_lag_index(lags_array.members[lag_member_indx].lag_oid);
 
-    lags_array.lags[lag_indx].members_ids[lag_member_indx] = 0;
+    if (lag_indx >= 0)
+    {
+        lags_array.lags[lag_indx].members_ids[lag_member_indx] = 0;
+    }
     memset(&lags_array.members[lag_member_indx], 0, sizeof(lag_member_db_entry_t));
 
+    pthread_rwlock_unlock(&lag_db_lock);
+
     return SAI_STATUS_SUCCESS;
 }
 
@@ -302,7 +365,7 @@ sai_status_t get_lag_member_attribute(_In_ const sai_object_key_t   *key,
 {
 
     sai_int8_t lag_m_indx = get_lag_member_index(key->object_id);
-    if (!lags_array.members[lag_m_indx].is_ised)
+    if (lag_m_indx < 0 || !lags_array.members[lag_m_indx].is_ised)
     {
         printf("Failed to get member attribute: lag member is not used.");
         return SAI_STATUS_FAILURE;
@@ -331,7 +394,10 @@ sai_status_t stub_get_lag_member_attribute(
     _Inout_ sai_attribute_t *attr_list)
 {
     const sai_object_key_t key = { .object_id = lag_member_id };
+
+    pthread_rwlock_rdlock(&lag_db_lock);
     sai_status_t result = sai_get_attributes(&key, NULL, lag_member_attribs, lag_member_vendor_attribs, attr_count, attr_list);
+    pthread_rwlock_unlock(&lag_db_lock);
 
     char list_str[MAX_LIST_VALUE_STR_LEN];
     sai_attr_list_to_str(attr_count, attr_list, lag_member_attribs, MAX_LIST_VALUE_STR_LEN, list_str);
@@ -0,0 +1,197 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#include "sai.h"
+#include "stub_sai.h"
+#include "stub_sai_lookup.h"
+
+#undef  __MODULE__
+#define __MODULE__ SAI_LOOKUP
+
+#define LOOKUP_BULK_CHUNK 64
+
+/* Resolve everything after the route. Caller is in a read side section */
+static void lookup_resolve_next_hop(_In_ const sai_ip_address_t     *dst_ip,
+                                    _In_ sai_object_id_t             route_next_hop,
+                                    _In_ uint32_t                    flow_hash,
+                                    _Inout_ stub_forwarding_result_t *result)
+{
+    sai_neighbor_entry_t neighbor;
+    sai_fdb_entry_t      fdb_entry;
+    sai_object_id_t      next_hop_id = route_next_hop;
+    sai_int32_t          action;
+    uint32_t             group_index;
+    bool                 admin_v4, admin_v6;
+
+    result->status        = SAI_STATUS_ITEM_NOT_FOUND;
+    result->packet_action = SAI_PACKET_ACTION_DROP;
+
+    switch (sai_object_type_query(route_next_hop)) {
+    case SAI_OBJECT_TYPE_NEXT_HOP_GROUP:
+        if ((SAI_STATUS_SUCCESS !=
+             stub_object_to_type(route_next_hop, SAI_OBJECT_TYPE_NEXT_HOP_GROUP, &group_index)) ||
+            (SAI_STATUS_SUCCESS != db_select_next_hop_group_member(group_index, flow_hash, &next_hop_id))) {
+            return;
+        }
+        /* Fall through */
+
+    case SAI_OBJECT_TYPE_NEXT_HOP:
+        if (SAI_STATUS_SUCCESS != db_lookup_next_hop(next_hop_id, &neighbor.ip_address, &neighbor.rif_id)) {
+            return;
+        }
+        result->next_hop_id = next_hop_id;
+        break;
+
+    case SAI_OBJECT_TYPE_ROUTER_INTERFACE:
+        /* Directly connected, the destination itself is the neighbor */
+        neighbor.ip_address = *dst_ip;
+        neighbor.rif_id     = route_next_hop;
+        break;
+
+    default:
+        return;
+    }
+
+    result->rif_id = neighbor.rif_id;
+
+    if (SAI_STATUS_SUCCESS !=
+        db_lookup_rif(neighbor.rif_id, &result->port_id, &result->vlan_id, result->src_mac, &admin_v4, &admin_v6)) {
+        return;
+    }
+
+    if (((SAI_IP_ADDR_FAMILY_IPV4 == dst_ip->addr_family) && !admin_v4) ||
+        ((SAI_IP_ADDR_FAMILY_IPV6 == dst_ip->addr_family) && !admin_v6)) {
+        result->status = SAI_STATUS_SUCCESS;
+        return;
+    }
+
+    if (SAI_STATUS_SUCCESS != db_lookup_neighbor(&neighbor, result->dst_mac, &action)) {
+        /* Unresolved neighbor is punted so the host can resolve it */
+        result->packet_action = SAI_PACKET_ACTION_TRAP;
+        return;
+    }
+
+    if (SAI_PACKET_ACTION_FORWARD != action) {
+        result->status        = SAI_STATUS_SUCCESS;
+        result->packet_action = action;
+        return;
+    }
+
+    if (0 != result->vlan_id) {
+        memcpy(fdb_entry.mac_address, result->dst_mac, sizeof(sai_mac_t));
+        fdb_entry.vlan_id = result->vlan_id;
+
+        if (SAI_STATUS_SUCCESS != db_lookup_fdb(&fdb_entry, &result->port_id, &action)) {
+            result->packet_action = SAI_PACKET_ACTION_FORWARD;
+            return;
+        }
+
+        if (SAI_PACKET_ACTION_FORWARD != action) {
+            result->status        = SAI_STATUS_SUCCESS;
+            result->packet_action = action;
+            return;
+        }
+    }
+
+    result->status        = SAI_STATUS_SUCCESS;
+    result->packet_action = SAI_PACKET_ACTION_FORWARD;
+}
+
+/*
+ * Routine Description:
+ *    Resolve forwarding of one destination
+ *
+ * Arguments:
+ *    [in] vr_id - virtual router id
+ *    [in] dst_ip - destination address
+ *    [in] flow_hash - flow hash, selects the next hop group member
+ *    [out] result - lookup result
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_lookup_forwarding(_In_ sai_object_id_t            vr_id,
+                                    _In_ const sai_ip_address_t    *dst_ip,
+                                    _In_ uint32_t                   flow_hash,
+                                    _Out_ stub_forwarding_result_t *result)
+{
+    return stub_lookup_forwarding_bulk(vr_id, 1, dst_ip, &flow_hash, result);
+}
+
+/*
+ * Routine Description:
+ *    Resolve forwarding of several destinations in one virtual router
+ *
+ * Arguments:
+ *    [in] vr_id - virtual router id
+ *    [in] count - number of destinations
+ *    [in] dst_ip - destination addresses
+ *    [in] flow_hash - flow hashes, may be NULL
+ *    [out] results - lookup results
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_lookup_forwarding_bulk(_In_ sai_object_id_t            vr_id,
+                                         _In_ uint32_t                   count,
+                                         _In_ const sai_ip_address_t    *dst_ip,
+                                         _In_ const uint32_t            *flow_hash,
+                                         _Out_ stub_forwarding_result_t *results)
+{
+    sai_status_t    status[LOOKUP_BULK_CHUNK];
+    sai_int32_t     action[LOOKUP_BULK_CHUNK];
+    sai_object_id_t next_hop[LOOKUP_BULK_CHUNK];
+    uint32_t        ii, jj, chunk;
+
+    if ((NULL == dst_ip) || (NULL == results)) {
+        STUB_LOG_ERR("NULL lookup param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(results, 0, sizeof(*results) * count);
+
+    stub_rcu_read_lock();
+
+    for (ii = 0; ii < count; ii += chunk) {
+        chunk = (count - ii < LOOKUP_BULK_CHUNK) ? count - ii : LOOKUP_BULK_CHUNK;
+
+        db_lookup_route_bulk(vr_id, chunk, dst_ip + ii, status, action, next_hop);
+
+        for (jj = 0; jj < chunk; jj++) {
+            if (SAI_STATUS_SUCCESS != status[jj]) {
+                results[ii + jj].status        = SAI_STATUS_ITEM_NOT_FOUND;
+                results[ii + jj].packet_action = SAI_PACKET_ACTION_DROP;
+                continue;
+            }
+
+            if (SAI_PACKET_ACTION_FORWARD != action[jj]) {
+                results[ii + jj].status        = SAI_STATUS_SUCCESS;
+                results[ii + jj].packet_action = action[jj];
+                continue;
+            }
+
+            lookup_resolve_next_hop(&dst_ip[ii + jj], next_hop[jj], (NULL == flow_hash) ? 0 : flow_hash[ii + jj],
+                                    &results[ii + jj]);
+        }
+    }
+
+    stub_rcu_read_unlock();
+
+    return SAI_STATUS_SUCCESS;
+}
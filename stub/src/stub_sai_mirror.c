@@ -0,0 +1,1281 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#include "sai.h"
+#include "stub_sai.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_qos_map.h"
+#include "stub_sai_mirror.h"
+#include "assert.h"
+
+#undef  __MODULE__
+#define __MODULE__ SAI_MIRROR
+
+static const sai_attribute_entry_t mirror_attribs[] = {
+    { SAI_MIRROR_SESSION_ATTR_TYPE, true, true, false, true,
+      "Mirror session type", SAI_ATTR_VAL_TYPE_S32 },
+    { SAI_MIRROR_SESSION_ATTR_MONITOR_PORT, true, true, true, true,
+      "Mirror session monitor port", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_MIRROR_SESSION_ATTR_TRUNCATE_SIZE, false, true, true, true,
+      "Mirror session truncate size", SAI_ATTR_VAL_TYPE_U16 },
+    { SAI_MIRROR_SESSION_ATTR_TC, false, true, true, true,
+      "Mirror session traffic class", SAI_ATTR_VAL_TYPE_U8 },
+    { SAI_MIRROR_SESSION_ATTR_VLAN_TPID, false, true, true, true,
+      "Mirror session VLAN TPID", SAI_ATTR_VAL_TYPE_U16 },
+    { SAI_MIRROR_SESSION_ATTR_VLAN_ID, false, true, true, true,
+      "Mirror session VLAN ID", SAI_ATTR_VAL_TYPE_U16 },
+    { SAI_MIRROR_SESSION_ATTR_VLAN_PRI, false, true, true, true,
+      "Mirror session VLAN priority", SAI_ATTR_VAL_TYPE_U8 },
+    { SAI_MIRROR_SESSION_ATTR_VLAN_CFI, false, true, true, true,
+      "Mirror session VLAN CFI", SAI_ATTR_VAL_TYPE_U8 },
+    { SAI_MIRROR_SESSION_ATTR_ENCAP_TYPE, false, true, false, true,
+      "Mirror session encapsulation type", SAI_ATTR_VAL_TYPE_S32 },
+    { SAI_MIRROR_SESSION_ATTR_IPHDR_VERSION, false, true, true, true,
+      "Mirror session IP header version", SAI_ATTR_VAL_TYPE_U8 },
+    { SAI_MIRROR_SESSION_ATTR_TOS, false, true, true, true,
+      "Mirror session TOS", SAI_ATTR_VAL_TYPE_U8 },
+    { SAI_MIRROR_SESSION_ATTR_TTL, false, true, true, true,
+      "Mirror session TTL", SAI_ATTR_VAL_TYPE_U8 },
+    { SAI_MIRROR_SESSION_ATTR_SRC_IP_ADDRESS, false, true, true, true,
+      "Mirror session source IP", SAI_ATTR_VAL_TYPE_IPADDR },
+    { SAI_MIRROR_SESSION_ATTR_DST_IP_ADDRESS, false, true, true, true,
+      "Mirror session destination IP", SAI_ATTR_VAL_TYPE_IPADDR },
+    { SAI_MIRROR_SESSION_ATTR_SRC_MAC_ADDRESS, false, true, true, true,
+      "Mirror session source MAC", SAI_ATTR_VAL_TYPE_MAC },
+    { SAI_MIRROR_SESSION_ATTR_DST_MAC_ADDRESS, false, true, true, true,
+      "Mirror session destination MAC", SAI_ATTR_VAL_TYPE_MAC },
+    { SAI_MIRROR_SESSION_ATTR_GRE_PROTOCOL_TYPE, false, true, true, true,
+      "Mirror session GRE protocol type", SAI_ATTR_VAL_TYPE_U16 },
+    { END_FUNCTIONALITY_ATTRIBS_ID, false, false, false, false,
+      "", SAI_ATTR_VAL_TYPE_UNDETERMINED }
+};
+
+sai_status_t stub_mirror_attr_get(_In_ const sai_object_key_t   *key,
+                                  _Inout_ sai_attribute_value_t *value,
+                                  _In_ uint32_t                  attr_index,
+                                  _Inout_ vendor_cache_t        *cache,
+                                  void                          *arg);
+sai_status_t stub_mirror_attr_set(_In_ const sai_object_key_t      *key,
+                                  _In_ const sai_attribute_value_t *value,
+                                  void                             *arg);
+
+#define MIRROR_VENDOR_ATTR(attr)                \
+    { attr,                                     \
+      { true, false, true, true },              \
+      { true, false, true, true },              \
+      stub_mirror_attr_get, (void*)attr,        \
+      stub_mirror_attr_set, (void*)attr }
+
+#define MIRROR_VENDOR_CREATE_ONLY_ATTR(attr)    \
+    { attr,                                     \
+      { true, false, false, true },             \
+      { true, false, false, true },             \
+      stub_mirror_attr_get, (void*)attr,        \
+      NULL, NULL }
+
+static const sai_vendor_attribute_entry_t mirror_vendor_attribs[] = {
+    MIRROR_VENDOR_CREATE_ONLY_ATTR(SAI_MIRROR_SESSION_ATTR_TYPE),
+    MIRROR_VENDOR_ATTR(SAI_MIRROR_SESSION_ATTR_MONITOR_PORT),
+    MIRROR_VENDOR_ATTR(SAI_MIRROR_SESSION_ATTR_TRUNCATE_SIZE),
+    MIRROR_VENDOR_ATTR(SAI_MIRROR_SESSION_ATTR_TC),
+    MIRROR_VENDOR_ATTR(SAI_MIRROR_SESSION_ATTR_VLAN_TPID),
+    MIRROR_VENDOR_ATTR(SAI_MIRROR_SESSION_ATTR_VLAN_ID),
+    MIRROR_VENDOR_ATTR(SAI_MIRROR_SESSION_ATTR_VLAN_PRI),
+    MIRROR_VENDOR_ATTR(SAI_MIRROR_SESSION_ATTR_VLAN_CFI),
+    MIRROR_VENDOR_CREATE_ONLY_ATTR(SAI_MIRROR_SESSION_ATTR_ENCAP_TYPE),
+    MIRROR_VENDOR_ATTR(SAI_MIRROR_SESSION_ATTR_IPHDR_VERSION),
+    MIRROR_VENDOR_ATTR(SAI_MIRROR_SESSION_ATTR_TOS),
+    MIRROR_VENDOR_ATTR(SAI_MIRROR_SESSION_ATTR_TTL),
+    MIRROR_VENDOR_ATTR(SAI_MIRROR_SESSION_ATTR_SRC_IP_ADDRESS),
+    MIRROR_VENDOR_ATTR(SAI_MIRROR_SESSION_ATTR_DST_IP_ADDRESS),
+    MIRROR_VENDOR_ATTR(SAI_MIRROR_SESSION_ATTR_SRC_MAC_ADDRESS),
+    MIRROR_VENDOR_ATTR(SAI_MIRROR_SESSION_ATTR_DST_MAC_ADDRESS),
+    MIRROR_VENDOR_ATTR(SAI_MIRROR_SESSION_ATTR_GRE_PROTOCOL_TYPE),
+};
+
+/* State DB *************/
+#define MIRROR_INGRESS         0
+#define MIRROR_EGRESS          1
+#define MIRROR_DIRECTIONS      2
+#define MIRROR_ATTR(attr)      (1u << (attr))
+#define MIRROR_VLAN_ATTRS      (MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_VLAN_TPID) |  \
+                                MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_VLAN_ID) |    \
+                                MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_VLAN_PRI) |   \
+                                MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_VLAN_CFI))
+#define MIRROR_GRE_ATTRS       (MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_ENCAP_TYPE) |        \
+                                MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_IPHDR_VERSION) |     \
+                                MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_TOS) |               \
+                                MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_SRC_IP_ADDRESS) |    \
+                                MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_DST_IP_ADDRESS) |    \
+                                MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_SRC_MAC_ADDRESS) |   \
+                                MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_DST_MAC_ADDRESS) |   \
+                                MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_GRE_PROTOCOL_TYPE))
+/* buffers a thread keeps for reuse, those of an ingress and an egress burst */
+#define MIRROR_CACHE_BUFFERS   (2 * STUB_DATAPLANE_BURST)
+
+#define MIRROR_ETH_ADDR_LEN    6
+#define MIRROR_ETH_HDR_LEN     14
+#define MIRROR_VLAN_HDR_LEN    4
+#define MIRROR_IPV4_HDR_LEN    20
+#define MIRROR_IPV6_HDR_LEN    40
+#define MIRROR_GRE_HDR_LEN     4
+#define MIRROR_ETHERTYPE_IPV4  0x0800
+#define MIRROR_ETHERTYPE_IPV6  0x86DD
+#define MIRROR_IP_PROTO_GRE    47
+#define MIRROR_MAX_VLAN        4094
+
+typedef struct _mirror_session_t {
+    bool             is_used;
+    /* attributes given, MIRROR_ATTR bits */
+    uint32_t         attrs;
+    sai_int32_t      type;
+    sai_object_id_t  monitor_port;
+    uint16_t         truncate_size;
+    sai_cos_t        tc;
+    uint16_t         vlan_tpid;
+    sai_vlan_id_t    vlan_id;
+    uint8_t          vlan_pri;
+    uint8_t          vlan_cfi;
+    sai_int32_t      encap_type;
+    uint8_t          iphdr_version;
+    uint8_t          tos;
+    uint8_t          ttl;
+    sai_ip_address_t src_ip;
+    sai_ip_address_t dst_ip;
+    sai_mac_t        src_mac;
+    sai_mac_t        dst_mac;
+    uint16_t         gre_protocol_type;
+    /* port bindings */
+    uint32_t         ref_count;
+} mirror_session_t;
+
+/* A session compiled, swapped whole, never changed in place. Offsets are
+ * into the clone header, 0 for fields it does not have */
+typedef struct _mirror_table_t {
+    uint8_t         header[STUB_MIRROR_MAX_HEADER];
+    uint32_t        header_length;
+    /* frame bytes that go in front of the header, the MAC addresses for RSPAN */
+    uint32_t        mac_length;
+    /* IP length field, its value less the mirrored bytes */
+    uint32_t        length_offset;
+    uint32_t        length_base;
+    /* IPv4 checksum field, the one's complement sum of the header with a length of 0 */
+    uint32_t        checksum_offset;
+    uint32_t        checksum_base;
+    uint32_t        truncate_size;
+    sai_object_id_t session_id;
+    sai_object_id_t monitor_port;
+    sai_cos_t       tc;
+} mirror_table_t;
+
+/* Sessions a port binds in a direction, swapped whole */
+typedef struct _mirror_list_t {
+    uint32_t count;
+    uint32_t sessions[STUB_MIRROR_PORT_SESSIONS];
+} mirror_list_t;
+
+struct _stub_mirror_buffer_t {
+    uint32_t              refs;
+    /* frame bytes copied so far */
+    uint32_t              length;
+    stub_mirror_buffer_t *next;
+    uint8_t               data[STUB_DATAPLANE_MAX_FRAME + MIRROR_VLAN_HDR_LEN];
+};
+
+/* Free buffers of a thread */
+typedef struct _mirror_cache_t {
+    stub_mirror_buffer_t *buffers;
+    uint32_t              count;
+    bool                  registered;
+} mirror_cache_t;
+
+/* Attributes each type takes, and those it must be created with */
+static const uint32_t mirror_type_attrs[SAI_MIRROR_TYPE_ENHANCED_REMOTE + 1] = {
+    [SAI_MIRROR_TYPE_LOCAL]           = MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_TYPE) |
+                                        MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_MONITOR_PORT) |
+                                        MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_TRUNCATE_SIZE) |
+                                        MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_TC),
+    [SAI_MIRROR_TYPE_REMOTE]          = MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_TYPE) |
+                                        MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_MONITOR_PORT) |
+                                        MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_TRUNCATE_SIZE) |
+                                        MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_TC) | MIRROR_VLAN_ATTRS,
+    [SAI_MIRROR_TYPE_ENHANCED_REMOTE] = MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_TYPE) |
+                                        MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_MONITOR_PORT) |
+                                        MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_TRUNCATE_SIZE) |
+                                        MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_TC) | MIRROR_VLAN_ATTRS |
+                                        MIRROR_ATTR(SAI_MIRROR_SESSION_ATTR_TTL) | MIRROR_GRE_ATTRS,
+};
+
+static const uint32_t mirror_type_mandatory[SAI_MIRROR_TYPE_ENHANCED_REMOTE + 1] = {
+    [SAI_MIRROR_TYPE_LOCAL]           = 0,
+    [SAI_MIRROR_TYPE_REMOTE]          = MIRROR_VLAN_ATTRS,
+    [SAI_MIRROR_TYPE_ENHANCED_REMOTE] = MIRROR_VLAN_ATTRS | MIRROR_GRE_ATTRS,
+};
+
+static mirror_session_t      mirror_db[STUB_MIRROR_SESSIONS];
+/* Compiled sessions, the data plane reads them in read side sections */
+static mirror_table_t       *mirror_tables[STUB_MIRROR_SESSIONS];
+/* Sessions per port and direction, NULL when none. Read without locks */
+static mirror_list_t        *mirror_ports[PORT_NUMBER][MIRROR_DIRECTIONS];
+/* Ports binding egress sessions, flooded frames skip the port scan without */
+static uint32_t              mirror_egress_ports;
+static pthread_rwlock_t      mirror_db_lock = STUB_RWLOCK_INITIALIZER;
+static __thread mirror_cache_t mirror_cache;
+static pthread_key_t         mirror_cache_key;
+static pthread_once_t        mirror_cache_once = PTHREAD_ONCE_INIT;
+
+/* Caller holds mirror_db_lock */
+static sai_status_t mirror_db_index(_In_ sai_object_id_t session_id, _Out_ uint32_t *index)
+{
+    sai_status_t status;
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(session_id, SAI_OBJECT_TYPE_MIRROR, index))) {
+        return status;
+    }
+
+    if ((*index >= STUB_MIRROR_SESSIONS) || (!mirror_db[*index].is_used)) {
+        STUB_LOG_ERR("Mirror session %u does not exist\n", *index);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void mirror_key_to_str(_In_ sai_object_id_t session_id, _Out_ char *key_str)
+{
+    uint32_t index;
+
+    if (SAI_STATUS_SUCCESS != stub_object_to_type(session_id, SAI_OBJECT_TYPE_MIRROR, &index)) {
+        snprintf(key_str, MAX_KEY_STR_LEN, "invalid mirror session id");
+    } else {
+        snprintf(key_str, MAX_KEY_STR_LEN, "mirror session id %u", index);
+    }
+}
+
+static inline bool mirror_port_index(_In_ sai_object_id_t port_id, _Out_ uint32_t *port)
+{
+    const stub_object_id_t *object = (const stub_object_id_t*)&port_id;
+
+    *port = object->data;
+    return (SAI_OBJECT_TYPE_PORT == object->object_type) && (object->data < PORT_NUMBER);
+}
+
+/* Actions that keep the frame on the data plane */
+static inline bool mirror_is_forwarded(_In_ sai_int32_t action)
+{
+    return (SAI_PACKET_ACTION_FORWARD == action) || (SAI_PACKET_ACTION_LOG == action) ||
+           (SAI_PACKET_ACTION_COPY == action) || (SAI_PACKET_ACTION_TRANSIT == action);
+}
+
+static inline void mirror_write16(_In_ uint8_t *p, _In_ uint16_t value)
+{
+    p[0] = (uint8_t)(value >> 8);
+    p[1] = (uint8_t)value;
+}
+
+/* Type 1 to 3, monitor port a port, traffic class [sai_cos_t] below
+ * STUB_QOS_TRAFFIC_CLASSES, truncate size [uint16_t] 0 or at least
+ * STUB_MIRROR_MIN_TRUNCATE, VLAN ID [sai_vlan_id_t] up to 4094, priority
+ * [uint8_t] up to 7, CFI [uint8_t] up to 1, encapsulation GRE, IP version
+ * [uint8_t] 4 or 6 */
+static sai_status_t mirror_check_value(_In_ sai_attr_id_t attr, _In_ const sai_attribute_value_t *value)
+{
+    uint32_t port;
+
+    switch (attr) {
+    case SAI_MIRROR_SESSION_ATTR_TYPE:
+        if ((value->s32 < SAI_MIRROR_TYPE_LOCAL) || (value->s32 > SAI_MIRROR_TYPE_ENHANCED_REMOTE)) {
+            STUB_LOG_ERR("Invalid mirror type %d\n", value->s32);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_MONITOR_PORT:
+        if ((SAI_STATUS_SUCCESS != stub_object_to_type(value->oid, SAI_OBJECT_TYPE_PORT, &port)) ||
+            (port >= PORT_NUMBER)) {
+            STUB_LOG_ERR("Invalid mirror monitor port\n");
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_TRUNCATE_SIZE:
+        if ((0 != value->u16) && (value->u16 < STUB_MIRROR_MIN_TRUNCATE)) {
+            STUB_LOG_ERR("Mirror truncate size %u below %u\n", value->u16, STUB_MIRROR_MIN_TRUNCATE);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_TC:
+        if (value->u8 >= STUB_QOS_TRAFFIC_CLASSES) {
+            STUB_LOG_ERR("Mirror traffic class %u, at most %u\n", value->u8, STUB_QOS_TRAFFIC_CLASSES - 1);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_VLAN_ID:
+        if (value->u16 > MIRROR_MAX_VLAN) {
+            STUB_LOG_ERR("Mirror VLAN ID %u above %u\n", value->u16, MIRROR_MAX_VLAN);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_VLAN_PRI:
+        if (value->u8 > 7) {
+            STUB_LOG_ERR("Mirror VLAN priority %u above 7\n", value->u8);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_VLAN_CFI:
+        if (value->u8 > 1) {
+            STUB_LOG_ERR("Mirror VLAN CFI %u above 1\n", value->u8);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_ENCAP_TYPE:
+        if (SAI_MIRROR_L3_GRE_TUNNEL != value->s32) {
+            STUB_LOG_ERR("Invalid mirror encapsulation type %d\n", value->s32);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_IPHDR_VERSION:
+        if ((4 != value->u8) && (6 != value->u8)) {
+            STUB_LOG_ERR("Invalid mirror IP header version %u\n", value->u8);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        break;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void mirror_apply(_Inout_ mirror_session_t *session, _In_ sai_attr_id_t attr,
+                         _In_ const sai_attribute_value_t *value)
+{
+    session->attrs |= MIRROR_ATTR(attr);
+
+    switch (attr) {
+    case SAI_MIRROR_SESSION_ATTR_TYPE:
+        session->type = value->s32;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_MONITOR_PORT:
+        session->monitor_port = value->oid;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_TRUNCATE_SIZE:
+        session->truncate_size = value->u16;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_TC:
+        session->tc = value->u8;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_VLAN_TPID:
+        session->vlan_tpid = value->u16;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_VLAN_ID:
+        session->vlan_id = value->u16;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_VLAN_PRI:
+        session->vlan_pri = value->u8;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_VLAN_CFI:
+        session->vlan_cfi = value->u8;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_ENCAP_TYPE:
+        session->encap_type = value->s32;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_IPHDR_VERSION:
+        session->iphdr_version = value->u8;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_TOS:
+        session->tos = value->u8;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_TTL:
+        session->ttl = value->u8;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_SRC_IP_ADDRESS:
+        session->src_ip = value->ipaddr;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_DST_IP_ADDRESS:
+        session->dst_ip = value->ipaddr;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_SRC_MAC_ADDRESS:
+        memcpy(session->src_mac, value->mac, sizeof(session->src_mac));
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_DST_MAC_ADDRESS:
+        memcpy(session->dst_mac, value->mac, sizeof(session->dst_mac));
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_GRE_PROTOCOL_TYPE:
+        session->gre_protocol_type = value->u16;
+        break;
+    }
+}
+
+/* Check a session against its type. Returns the attribute at fault in attr */
+static sai_status_t mirror_check(_In_ const mirror_session_t *session, _Out_ sai_attr_id_t *attr)
+{
+    sai_ip_addr_family_t family;
+    uint32_t             extra, missing;
+
+    if (0 != (extra = session->attrs & ~mirror_type_attrs[session->type])) {
+        *attr = __builtin_ctz(extra);
+        STUB_LOG_ERR("Mirror session of type %d does not take attribute %u\n", session->type, *attr);
+        return SAI_STATUS_INVALID_ATTRIBUTE_0;
+    }
+
+    if (0 != (missing = mirror_type_mandatory[session->type] & ~session->attrs)) {
+        *attr = __builtin_ctz(missing);
+        STUB_LOG_ERR("Mirror session of type %d without attribute %u\n", session->type, *attr);
+        return SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING;
+    }
+
+    if ((SAI_MIRROR_TYPE_REMOTE == session->type) && (0 == session->vlan_id)) {
+        *attr = SAI_MIRROR_SESSION_ATTR_VLAN_ID;
+        STUB_LOG_ERR("RSPAN mirror session without a VLAN\n");
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    if (SAI_MIRROR_TYPE_ENHANCED_REMOTE == session->type) {
+        family = (4 == session->iphdr_version) ? SAI_IP_ADDR_FAMILY_IPV4 : SAI_IP_ADDR_FAMILY_IPV6;
+        if (family != session->src_ip.addr_family) {
+            *attr = SAI_MIRROR_SESSION_ATTR_SRC_IP_ADDRESS;
+            STUB_LOG_ERR("Mirror source IP not of IP version %u\n", session->iphdr_version);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        if (family != session->dst_ip.addr_family) {
+            *attr = SAI_MIRROR_SESSION_ATTR_DST_IP_ADDRESS;
+            STUB_LOG_ERR("Mirror destination IP not of IP version %u\n", session->iphdr_version);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* One's complement sum of 16 bit words, not folded */
+static uint32_t mirror_sum16(_In_ const uint8_t *data, _In_ uint32_t length)
+{
+    uint32_t sum = 0, ii;
+
+    for (ii = 0; ii + 1 < length; ii += 2) {
+        sum += (uint32_t)((data[ii] << 8) | data[ii + 1]);
+    }
+
+    return sum;
+}
+
+/* Build the encapsulation of a checked session, with IP lengths and
+ * checksums of 0 */
+static void mirror_compile_header(_In_ const mirror_session_t *session, _Inout_ mirror_table_t *table)
+{
+    uint8_t *header = table->header;
+    uint32_t offset, ip;
+
+    if (SAI_MIRROR_TYPE_LOCAL == session->type) {
+        return;
+    }
+
+    if (SAI_MIRROR_TYPE_REMOTE == session->type) {
+        table->mac_length = 2 * MIRROR_ETH_ADDR_LEN;
+        mirror_write16(header, session->vlan_tpid);
+        mirror_write16(header + 2, (uint16_t)((session->vlan_pri << 13) | (session->vlan_cfi << 12) | session->vlan_id));
+        table->header_length = MIRROR_VLAN_HDR_LEN;
+        return;
+    }
+
+    memcpy(header, session->dst_mac, MIRROR_ETH_ADDR_LEN);
+    memcpy(header + MIRROR_ETH_ADDR_LEN, session->src_mac, MIRROR_ETH_ADDR_LEN);
+    offset = 2 * MIRROR_ETH_ADDR_LEN;
+    if (0 != session->vlan_id) {
+        mirror_write16(header + offset, session->vlan_tpid);
+        mirror_write16(header + offset + 2,
+                       (uint16_t)((session->vlan_pri << 13) | (session->vlan_cfi << 12) | session->vlan_id));
+        offset += MIRROR_VLAN_HDR_LEN;
+    }
+
+    ip = offset + 2;
+    if (4 == session->iphdr_version) {
+        mirror_write16(header + offset, MIRROR_ETHERTYPE_IPV4);
+        header[ip]     = 0x45;
+        header[ip + 1] = session->tos;
+        header[ip + 8] = session->ttl;
+        header[ip + 9] = MIRROR_IP_PROTO_GRE;
+        memcpy(header + ip + 12, &session->src_ip.addr.ip4, sizeof(sai_ip4_t));
+        memcpy(header + ip + 16, &session->dst_ip.addr.ip4, sizeof(sai_ip4_t));
+        table->length_offset   = ip + 2;
+        table->length_base     = MIRROR_IPV4_HDR_LEN + MIRROR_GRE_HDR_LEN;
+        table->checksum_offset = ip + 10;
+        table->checksum_base   = mirror_sum16(header + ip, MIRROR_IPV4_HDR_LEN);
+        offset                 = ip + MIRROR_IPV4_HDR_LEN;
+    } else {
+        mirror_write16(header + offset, MIRROR_ETHERTYPE_IPV6);
+        header[ip]     = 0x60 | (session->tos >> 4);
+        header[ip + 1] = (uint8_t)(session->tos << 4);
+        header[ip + 6] = MIRROR_IP_PROTO_GRE;
+        header[ip + 7] = session->ttl;
+        memcpy(header + ip + 8, session->src_ip.addr.ip6, sizeof(sai_ip6_t));
+        memcpy(header + ip + 24, session->dst_ip.addr.ip6, sizeof(sai_ip6_t));
+        table->length_offset = ip + 4;
+        table->length_base   = MIRROR_GRE_HDR_LEN;
+        offset               = ip + MIRROR_IPV6_HDR_LEN;
+    }
+
+    /* No GRE flags, version 0 */
+    mirror_write16(header + offset + 2, session->gre_protocol_type);
+    table->header_length = offset + MIRROR_GRE_HDR_LEN;
+}
+
+/* Check and compile a session. Returns the attribute at fault in attr */
+static sai_status_t mirror_compile(_In_ const mirror_session_t *session,
+                                   _In_ uint32_t                index,
+                                   _Out_ mirror_table_t       **table,
+                                   _Out_ sai_attr_id_t         *attr)
+{
+    sai_status_t status;
+
+    *table = NULL;
+
+    if (SAI_STATUS_SUCCESS != (status = mirror_check(session, attr))) {
+        return status;
+    }
+
+    if (NULL == (*table = calloc(1, sizeof(**table)))) {
+        STUB_LOG_ERR("Can't allocate mirror table\n");
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    mirror_compile_header(session, *table);
+    (*table)->truncate_size = session->truncate_size;
+    (*table)->monitor_port  = session->monitor_port;
+    (*table)->tc            = session->tc;
+    stub_create_object(SAI_OBJECT_TYPE_MIRROR, index, &(*table)->session_id);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void mirror_cache_free(void *arg)
+{
+    mirror_cache_t       *cache = arg;
+    stub_mirror_buffer_t *buffer;
+
+    while (NULL != (buffer = cache->buffers)) {
+        cache->buffers = buffer->next;
+        free(buffer);
+    }
+    cache->count = 0;
+}
+
+static void mirror_cache_key_create(void)
+{
+    pthread_key_create(&mirror_cache_key, mirror_cache_free);
+}
+
+/* A buffer from the cache of the thread, the cache frees its buffers when
+ * the thread exits */
+static stub_mirror_buffer_t* mirror_buffer_alloc(void)
+{
+    stub_mirror_buffer_t *buffer;
+
+    if (NULL != (buffer = mirror_cache.buffers)) {
+        mirror_cache.buffers = buffer->next;
+        mirror_cache.count--;
+    } else {
+        if (!mirror_cache.registered) {
+            pthread_once(&mirror_cache_once, mirror_cache_key_create);
+            pthread_setspecific(mirror_cache_key, &mirror_cache);
+            mirror_cache.registered = true;
+        }
+        if (NULL == (buffer = malloc(sizeof(*buffer)))) {
+            STUB_LOG_ERR("Can't allocate mirror buffer\n");
+            return NULL;
+        }
+    }
+
+    buffer->refs   = 0;
+    buffer->length = 0;
+
+    return buffer;
+}
+
+static void mirror_buffer_put(_In_ stub_mirror_buffer_t *buffer)
+{
+    if (mirror_cache.registered && (mirror_cache.count < MIRROR_CACHE_BUFFERS)) {
+        buffer->next         = mirror_cache.buffers;
+        mirror_cache.buffers = buffer;
+        mirror_cache.count++;
+        return;
+    }
+
+    free(buffer);
+}
+
+void db_init_mirror(void)
+{
+    mirror_table_t *table;
+    mirror_list_t  *list;
+    uint32_t        ii, port, direction;
+
+    pthread_rwlock_wrlock(&mirror_db_lock);
+
+    for (port = 0; port < PORT_NUMBER; port++) {
+        for (direction = 0; direction < MIRROR_DIRECTIONS; direction++) {
+            list = mirror_ports[port][direction];
+            STUB_RCU_ASSIGN(mirror_ports[port][direction], NULL);
+            stub_rcu_defer_free(list);
+        }
+    }
+    STUB_RCU_ASSIGN(mirror_egress_ports, 0);
+
+    for (ii = 0; ii < STUB_MIRROR_SESSIONS; ii++) {
+        table = mirror_tables[ii];
+        STUB_RCU_ASSIGN(mirror_tables[ii], NULL);
+        stub_rcu_defer_free(table);
+    }
+
+    memset(mirror_db, 0, sizeof(mirror_db));
+
+    pthread_rwlock_unlock(&mirror_db_lock);
+}
+
+/*
+ * Routine Description:
+ *    Get the mirror sessions a port binds
+ *
+ * Arguments:
+ *    [in] port - port index
+ *    [in] ingress - ingress sessions, else egress ones
+ *    [inout] sessions - session list
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    SAI_STATUS_BUFFER_OVERFLOW when the list is too short
+ */
+sai_status_t db_get_port_mirror(_In_ uint32_t port, _In_ bool ingress, _Inout_ sai_object_list_t *sessions)
+{
+    sai_object_id_t      ids[STUB_MIRROR_PORT_SESSIONS];
+    const mirror_list_t *list;
+    uint32_t             ii, count = 0;
+
+    assert(port < PORT_NUMBER);
+
+    pthread_rwlock_rdlock(&mirror_db_lock);
+
+    if (NULL != (list = mirror_ports[port][ingress ? MIRROR_INGRESS : MIRROR_EGRESS])) {
+        for (ii = 0; ii < list->count; ii++) {
+            stub_create_object(SAI_OBJECT_TYPE_MIRROR, list->sessions[ii], &ids[count++]);
+        }
+    }
+
+    pthread_rwlock_unlock(&mirror_db_lock);
+
+    return stub_fill_objlist(ids, count, sessions);
+}
+
+/*
+ * Routine Description:
+ *    Bind a list of mirror sessions to a port, an empty list unbinds them
+ *
+ * Arguments:
+ *    [in] port - port index
+ *    [in] ingress - ingress sessions, else egress ones
+ *    [in] sessions - session list
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    SAI_STATUS_INVALID_ATTR_VALUE_0 for more than STUB_MIRROR_PORT_SESSIONS
+ *    sessions, or one that does not exist or is listed twice
+ */
+sai_status_t db_set_port_mirror(_In_ uint32_t port, _In_ bool ingress, _In_ const sai_object_list_t *sessions)
+{
+    mirror_list_t *list = NULL, *old;
+    uint32_t       ii, jj, direction = ingress ? MIRROR_INGRESS : MIRROR_EGRESS;
+
+    assert(port < PORT_NUMBER);
+
+    if (sessions->count > STUB_MIRROR_PORT_SESSIONS) {
+        STUB_LOG_ERR("%u mirror sessions on a port, at most %u\n", sessions->count, STUB_MIRROR_PORT_SESSIONS);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    if ((0 != sessions->count) && (NULL == (list = calloc(1, sizeof(*list))))) {
+        STUB_LOG_ERR("Can't allocate mirror session list\n");
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    pthread_rwlock_wrlock(&mirror_db_lock);
+
+    for (ii = 0; ii < sessions->count; ii++) {
+        if (SAI_STATUS_SUCCESS != mirror_db_index(sessions->list[ii], &list->sessions[ii])) {
+            pthread_rwlock_unlock(&mirror_db_lock);
+            free(list);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        for (jj = 0; jj < ii; jj++) {
+            if (list->sessions[jj] == list->sessions[ii]) {
+                pthread_rwlock_unlock(&mirror_db_lock);
+                STUB_LOG_ERR("Mirror session %u listed twice\n", list->sessions[ii]);
+                free(list);
+                return SAI_STATUS_INVALID_ATTR_VALUE_0;
+            }
+        }
+        list->count++;
+    }
+
+    old = mirror_ports[port][direction];
+    for (ii = 0; (NULL != list) && (ii < list->count); ii++) {
+        mirror_db[list->sessions[ii]].ref_count++;
+    }
+    for (ii = 0; (NULL != old) && (ii < old->count); ii++) {
+        mirror_db[old->sessions[ii]].ref_count--;
+    }
+
+    if (MIRROR_EGRESS == direction) {
+        STUB_RCU_ASSIGN(mirror_egress_ports, mirror_egress_ports + (NULL != list) - (NULL != old));
+    }
+    STUB_RCU_ASSIGN(mirror_ports[port][direction], list);
+    stub_rcu_defer_free(old);
+
+    pthread_rwlock_unlock(&mirror_db_lock);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Clone a frame for the sessions of one port in one direction. The first
+ * clone takes a buffer, each copies what the ones before did not. Caller
+ * is in a read side section */
+static void mirror_port_clones(_In_ const mirror_list_t    *list,
+                               _In_ const stub_packet_t    *packet,
+                               _In_ uint32_t                packet_index,
+                               _Inout_ stub_mirror_buffer_t **buffer,
+                               _In_ uint32_t                capacity,
+                               _Inout_ stub_mirror_packet_t  *clones,
+                               _Inout_ uint32_t              *clone_count)
+{
+    const mirror_table_t *table;
+    stub_mirror_packet_t *clone;
+    uint32_t              ii, length, ip_length, sum;
+
+    for (ii = 0; (ii < list->count) && (*clone_count < capacity); ii++) {
+        if (NULL == (table = STUB_RCU_DEREF(mirror_tables[list->sessions[ii]]))) {
+            continue;
+        }
+
+        length = packet->length;
+        if ((0 != table->truncate_size) && (table->truncate_size < length)) {
+            length = table->truncate_size;
+        }
+
+        if ((NULL == *buffer) && (NULL == (*buffer = mirror_buffer_alloc()))) {
+            return;
+        }
+        if (length > (*buffer)->length) {
+            memcpy((*buffer)->data + (*buffer)->length, packet->data + (*buffer)->length, length - (*buffer)->length);
+            (*buffer)->length = length;
+        }
+
+        clone                = &clones[(*clone_count)++];
+        clone->header_length = table->mac_length + table->header_length;
+        memcpy(clone->header, (*buffer)->data, table->mac_length);
+        memcpy(clone->header + table->mac_length, table->header, table->header_length);
+        clone->data          = (*buffer)->data + table->mac_length;
+        clone->length        = length - table->mac_length;
+        clone->packet_index  = packet_index;
+        clone->session_id    = table->session_id;
+        clone->monitor_port  = table->monitor_port;
+        clone->tc            = table->tc;
+        clone->buffer        = *buffer;
+        (*buffer)->refs++;
+
+        if (0 == table->length_offset) {
+            continue;
+        }
+        ip_length = table->length_base + clone->length;
+        mirror_write16(clone->header + table->length_offset, (uint16_t)ip_length);
+        if (0 != table->checksum_offset) {
+            sum = table->checksum_base + ip_length;
+            sum = (sum & 0xFFFF) + (sum >> 16);
+            sum = (sum & 0xFFFF) + (sum >> 16);
+            mirror_write16(clone->header + table->checksum_offset, (uint16_t)~sum);
+        }
+    }
+}
+
+/*
+ * Routine Description:
+ *    Clone a burst of frames for the mirror sessions of their ports
+ *
+ * Arguments:
+ *    [in] ingress - sessions of the ingress ports, else of the egress ports
+ *    [in] count - number of frames
+ *    [in] packets - frames
+ *    [in] capacity - clones that fit in clones
+ *    [out] clones - clones
+ *    [out] clone_count - number of clones made
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_mirror_burst(_In_ bool                   ingress,
+                               _In_ uint32_t               count,
+                               _In_ const stub_packet_t   *packets,
+                               _In_ uint32_t               capacity,
+                               _Out_ stub_mirror_packet_t *clones,
+                               _Out_ uint32_t             *clone_count)
+{
+    const stub_packet_t  *packet;
+    const mirror_list_t  *list;
+    stub_mirror_buffer_t *buffer;
+    uint32_t              ii, port;
+
+    if ((NULL == packets) || (NULL == clones) || (NULL == clone_count)) {
+        STUB_LOG_ERR("NULL packets, clones or clone count param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    *clone_count = 0;
+
+    if (!ingress && (0 == STUB_RCU_DEREF(mirror_egress_ports))) {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    stub_rcu_read_lock();
+
+    for (ii = 0; ii < count; ii++) {
+        packet = &packets[ii];
+        buffer = NULL;
+
+        if ((packet->length < MIRROR_ETH_HDR_LEN) || (packet->length > sizeof(buffer->data))) {
+            continue;
+        }
+
+        if (ingress) {
+            if (mirror_port_index(packet->in_port, &port) &&
+                (NULL != (list = STUB_RCU_DEREF(mirror_ports[port][MIRROR_INGRESS])))) {
+                mirror_port_clones(list, packet, ii, &buffer, capacity, clones, clone_count);
+            }
+            continue;
+        }
+
+        if (!mirror_is_forwarded(packet->packet_action)) {
+            continue;
+        }
+
+        if (SAI_NULL_OBJECT_ID != packet->out_port) {
+            if (mirror_port_index(packet->out_port, &port) &&
+                (NULL != (list = STUB_RCU_DEREF(mirror_ports[port][MIRROR_EGRESS])))) {
+                mirror_port_clones(list, packet, ii, &buffer, capacity, clones, clone_count);
+            }
+            continue;
+        }
+
+        /* Flooded, to the VLAN members but the ingress port */
+        for (port = 0; port < PORT_NUMBER; port++) {
+            if (stub_dataplane_is_sent_to(packet, port) &&
+                (NULL != (list = STUB_RCU_DEREF(mirror_ports[port][MIRROR_EGRESS])))) {
+                mirror_port_clones(list, packet, ii, &buffer, capacity, clones, clone_count);
+            }
+        }
+    }
+
+    stub_rcu_read_unlock();
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Drop the buffer references of clones
+ *
+ * Arguments:
+ *    [in] count - number of clones
+ *    [inout] clones - clones
+ */
+void stub_mirror_release(_In_ uint32_t count, _Inout_ stub_mirror_packet_t *clones)
+{
+    uint32_t ii;
+
+    for (ii = 0; ii < count; ii++) {
+        if (NULL == clones[ii].buffer) {
+            continue;
+        }
+        if (0 == __atomic_sub_fetch(&clones[ii].buffer->refs, 1, __ATOMIC_ACQ_REL)) {
+            mirror_buffer_put(clones[ii].buffer);
+        }
+        clones[ii].buffer = NULL;
+        clones[ii].data   = NULL;
+    }
+}
+
+/*
+ * Routine Description:
+ *    Create mirror session.
+ *
+ * Arguments:
+ *    [out] session_id - Port mirror session id
+ *    [in] attr_count - number of attributes
+ *    [in] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_create_mirror_session(_Out_ sai_object_id_t     *session_id,
+                                        _In_ uint32_t               attr_count,
+                                        _In_ const sai_attribute_t *attr_list)
+{
+    const sai_attribute_value_t *value;
+    mirror_session_t             session;
+    mirror_table_t              *table;
+    sai_attr_id_t                attr, fault;
+    uint32_t                     index, ii;
+    sai_status_t                 status;
+    char                         list_str[MAX_LIST_VALUE_STR_LEN];
+    char                         key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    if (NULL == session_id) {
+        STUB_LOG_ERR("NULL mirror session id param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS !=
+        (status =
+             check_attribs_metadata(attr_count, attr_list, mirror_attribs, mirror_vendor_attribs,
+                                    SAI_OPERATION_CREATE))) {
+        STUB_LOG_ERR("Failed attribs check\n");
+        return status;
+    }
+
+    sai_attr_list_to_str(attr_count, attr_list, mirror_attribs, MAX_LIST_VALUE_STR_LEN, list_str);
+    STUB_LOG_NTC("Create mirror session, %s\n", list_str);
+
+    memset(&session, 0, sizeof(session));
+    session.ttl = UINT8_MAX;
+
+    for (attr = SAI_MIRROR_SESSION_ATTR_TYPE; attr <= SAI_MIRROR_SESSION_ATTR_GRE_PROTOCOL_TYPE; attr++) {
+        if (SAI_STATUS_SUCCESS != find_attrib_in_list(attr_count, attr_list, attr, &value, &index)) {
+            continue;
+        }
+        if (SAI_STATUS_SUCCESS != mirror_check_value(attr, value)) {
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + index;
+        }
+        mirror_apply(&session, attr, value);
+    }
+
+    pthread_rwlock_wrlock(&mirror_db_lock);
+
+    for (ii = 0; ii < STUB_MIRROR_SESSIONS; ii++) {
+        if (!mirror_db[ii].is_used) {
+            break;
+        }
+    }
+
+    if (STUB_MIRROR_SESSIONS == ii) {
+        pthread_rwlock_unlock(&mirror_db_lock);
+        STUB_LOG_ERR("Mirror session table full\n");
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    if (SAI_STATUS_SUCCESS != (status = mirror_compile(&session, ii, &table, &fault))) {
+        pthread_rwlock_unlock(&mirror_db_lock);
+        if (((SAI_STATUS_INVALID_ATTR_VALUE_0 == status) || (SAI_STATUS_INVALID_ATTRIBUTE_0 == status)) &&
+            (SAI_STATUS_SUCCESS == find_attrib_in_list(attr_count, attr_list, fault, &value, &index))) {
+            return status + index;
+        }
+        return status;
+    }
+
+    session.is_used = true;
+    mirror_db[ii]   = session;
+    STUB_RCU_ASSIGN(mirror_tables[ii], table);
+
+    pthread_rwlock_unlock(&mirror_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_MIRROR, ii, session_id))) {
+        return status;
+    }
+    mirror_key_to_str(*session_id, key_str);
+    STUB_LOG_NTC("Created %s\n", key_str);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Remove mirror session.
+ *
+ * Arguments:
+ *    [in] session_id - Port mirror session id
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_remove_mirror_session(_In_ sai_object_id_t session_id)
+{
+    mirror_table_t *old;
+    char            key_str[MAX_KEY_STR_LEN];
+    sai_status_t    status;
+    uint32_t        index;
+
+    STUB_LOG_ENTER();
+
+    mirror_key_to_str(session_id, key_str);
+    STUB_LOG_NTC("Remove %s\n", key_str);
+
+    pthread_rwlock_wrlock(&mirror_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = mirror_db_index(session_id, &index))) {
+        pthread_rwlock_unlock(&mirror_db_lock);
+        return status;
+    }
+
+    if (0 != mirror_db[index].ref_count) {
+        pthread_rwlock_unlock(&mirror_db_lock);
+        STUB_LOG_ERR("Mirror session %u is bound to %u ports\n", index, mirror_db[index].ref_count);
+        return SAI_STATUS_OBJECT_IN_USE;
+    }
+
+    old = mirror_tables[index];
+    STUB_RCU_ASSIGN(mirror_tables[index], NULL);
+    stub_rcu_defer_free(old);
+
+    mirror_db[index].is_used = false;
+
+    pthread_rwlock_unlock(&mirror_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Set mirror session attributes.
+ *
+ * Arguments:
+ *    [in] session_id - Port mirror session id
+ *    [in] attr - attribute
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_set_mirror_session_attribute(_In_ sai_object_id_t session_id, _In_ const sai_attribute_t *attr)
+{
+    const sai_object_key_t key = { .object_id = session_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    mirror_key_to_str(session_id, key_str);
+    return sai_set_attribute(&key, key_str, mirror_attribs, mirror_vendor_attribs, attr);
+}
+
+/*
+ * Routine Description:
+ *    Get mirror session attributes.
+ *
+ * Arguments:
+ *    [in] session_id - Port mirror session id
+ *    [in] attr_count - number of attributes
+ *    [inout] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_mirror_session_attribute(_In_ sai_object_id_t     session_id,
+                                               _In_ uint32_t            attr_count,
+                                               _Inout_ sai_attribute_t *attr_list)
+{
+    const sai_object_key_t key = { .object_id = session_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
+
+    STUB_LOG_ENTER();
+
+    mirror_key_to_str(session_id, key_str);
+
+    pthread_rwlock_rdlock(&mirror_db_lock);
+    status = sai_get_attributes(&key, key_str, mirror_attribs, mirror_vendor_attribs, attr_count, attr_list);
+    pthread_rwlock_unlock(&mirror_db_lock);
+
+    return status;
+}
+
+/* Session attributes, as set or their defaults: TTL 255, others 0 */
+sai_status_t stub_mirror_attr_get(_In_ const sai_object_key_t   *key,
+                                  _Inout_ sai_attribute_value_t *value,
+                                  _In_ uint32_t                  attr_index,
+                                  _Inout_ vendor_cache_t        *cache,
+                                  void                          *arg)
+{
+    const mirror_session_t *session;
+    sai_status_t            status;
+    uint32_t                index;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = mirror_db_index(key->object_id, &index))) {
+        return status;
+    }
+
+    session = &mirror_db[index];
+
+    switch ((long)arg) {
+    case SAI_MIRROR_SESSION_ATTR_TYPE:
+        value->s32 = session->type;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_MONITOR_PORT:
+        value->oid = session->monitor_port;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_TRUNCATE_SIZE:
+        value->u16 = session->truncate_size;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_TC:
+        value->u8 = session->tc;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_VLAN_TPID:
+        value->u16 = session->vlan_tpid;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_VLAN_ID:
+        value->u16 = session->vlan_id;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_VLAN_PRI:
+        value->u8 = session->vlan_pri;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_VLAN_CFI:
+        value->u8 = session->vlan_cfi;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_ENCAP_TYPE:
+        value->s32 = session->encap_type;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_IPHDR_VERSION:
+        value->u8 = session->iphdr_version;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_TOS:
+        value->u8 = session->tos;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_TTL:
+        value->u8 = session->ttl;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_SRC_IP_ADDRESS:
+        value->ipaddr = session->src_ip;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_DST_IP_ADDRESS:
+        value->ipaddr = session->dst_ip;
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_SRC_MAC_ADDRESS:
+        memcpy(value->mac, session->src_mac, sizeof(value->mac));
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_DST_MAC_ADDRESS:
+        memcpy(value->mac, session->dst_mac, sizeof(value->mac));
+        break;
+
+    case SAI_MIRROR_SESSION_ATTR_GRE_PROTOCOL_TYPE:
+        value->u16 = session->gre_protocol_type;
+        break;
+    }
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Session attributes but type and encapsulation type. The session is
+ * compiled again and the ports switch to it at once */
+sai_status_t stub_mirror_attr_set(_In_ const sai_object_key_t      *key,
+                                  _In_ const sai_attribute_value_t *value,
+                                  void                             *arg)
+{
+    mirror_table_t  *table, *old;
+    mirror_session_t session;
+    sai_attr_id_t    fault;
+    sai_status_t     status;
+    uint32_t         index;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = mirror_check_value((long)arg, value))) {
+        return status;
+    }
+
+    pthread_rwlock_wrlock(&mirror_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = mirror_db_index(key->object_id, &index))) {
+        pthread_rwlock_unlock(&mirror_db_lock);
+        return status;
+    }
+
+    session = mirror_db[index];
+    mirror_apply(&session, (long)arg, value);
+    if (SAI_STATUS_SUCCESS != (status = mirror_compile(&session, index, &table, &fault))) {
+        pthread_rwlock_unlock(&mirror_db_lock);
+        return status;
+    }
+
+    mirror_db[index] = session;
+
+    old = mirror_tables[index];
+    STUB_RCU_ASSIGN(mirror_tables[index], table);
+    stub_rcu_defer_free(old);
+
+    pthread_rwlock_unlock(&mirror_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+const sai_mirror_api_t mirror_api = {
+    stub_create_mirror_session,
+    stub_remove_mirror_session,
+    stub_set_mirror_session_attribute,
+    stub_get_mirror_session_attribute
+};
@@ -60,6 +60,187 @@ static const sai_vendor_attribute_entry_t neighbor_vendor_attribs[] = {
       stub_neighbor_action_get, NULL,
       stub_neighbor_action_set, NULL },
 };
+
+/* State DB *************/
+#define NEIGHBOR_DB_BUCKETS 16384
+
+/* Neighbor data is immutable once published, updates publish a new copy */
+typedef struct _stub_neighbor_t {
+    sai_neighbor_entry_t      entry;
+    sai_mac_t                 mac;
+    sai_int32_t               packet_action;
+    struct _stub_neighbor_t *next;
+} stub_neighbor_t;
+
+/* Readers walk the chains under stub_rcu_read_lock, writers serialize on neighbor_db_lock */
+static stub_neighbor_t *neighbor_db[NEIGHBOR_DB_BUCKETS];
+static pthread_mutex_t  neighbor_db_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static bool neighbor_key_equal(_In_ const sai_neighbor_entry_t *a, _In_ const sai_neighbor_entry_t *b)
+{
+    if ((a->rif_id != b->rif_id) || (a->ip_address.addr_family != b->ip_address.addr_family)) {
+        return false;
+    }
+
+    if (SAI_IP_ADDR_FAMILY_IPV4 == a->ip_address.addr_family) {
+        return a->ip_address.addr.ip4 == b->ip_address.addr.ip4;
+    }
+
+    return 0 == memcmp(a->ip_address.addr.ip6, b->ip_address.addr.ip6, sizeof(sai_ip6_t));
+}
+
+static uint32_t neighbor_key_hash(_In_ const sai_neighbor_entry_t *neighbor_entry)
+{
+    const uint8_t *ip;
+    uint32_t       hash = 2166136261u, ii, size;
+
+    if (SAI_IP_ADDR_FAMILY_IPV4 == neighbor_entry->ip_address.addr_family) {
+        ip   = (const uint8_t*)&neighbor_entry->ip_address.addr.ip4;
+        size = sizeof(sai_ip4_t);
+    } else {
+        ip   = neighbor_entry->ip_address.addr.ip6;
+        size = sizeof(sai_ip6_t);
+    }
+
+    for (ii = 0; ii < size; ii++) {
+        hash = (hash ^ ip[ii]) * 16777619u;
+    }
+    hash = (hash ^ (uint32_t)(neighbor_entry->rif_id >> 32)) * 16777619u;
+
+    return hash % NEIGHBOR_DB_BUCKETS;
+}
+
+/* Caller holds neighbor_db_lock or is in a read side section */
+static stub_neighbor_t** db_find_neighbor_link(_In_ const sai_neighbor_entry_t *neighbor_entry)
+{
+    stub_neighbor_t **link = &neighbor_db[neighbor_key_hash(neighbor_entry)];
+    stub_neighbor_t  *neighbor;
+
+    for (; NULL != (neighbor = STUB_RCU_DEREF(*link)); link = &neighbor->next) {
+        if (neighbor_key_equal(&neighbor->entry, neighbor_entry)) {
+            return link;
+        }
+    }
+
+    return NULL;
+}
+
+static sai_status_t db_get_neighbor(_In_ const sai_neighbor_entry_t *neighbor_entry,
+                                    _Inout_ vendor_cache_t         *cache,
+                                    _Out_ const stub_neighbor_t   **neighbor)
+{
+    stub_neighbor_t **link;
+
+    if (NULL == cache->entry) {
+        if (NULL == (link = db_find_neighbor_link(neighbor_entry))) {
+            STUB_LOG_ERR("Neighbor not found\n");
+            return SAI_STATUS_ITEM_NOT_FOUND;
+        }
+        cache->entry = STUB_RCU_DEREF(*link);
+    }
+
+    *neighbor = cache->entry;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Copy the neighbor, apply the new attribute value and publish the copy */
+static sai_status_t db_update_neighbor(_In_ const sai_neighbor_entry_t  *neighbor_entry,
+                                       _In_ sai_neighbor_attr_t          attr_id,
+                                       _In_ const sai_attribute_value_t *value)
+{
+    stub_neighbor_t **link;
+    stub_neighbor_t  *old_neighbor, *new_neighbor;
+
+    if (NULL == (new_neighbor = malloc(sizeof(*new_neighbor)))) {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    pthread_mutex_lock(&neighbor_db_lock);
+
+    if (NULL == (link = db_find_neighbor_link(neighbor_entry))) {
+        pthread_mutex_unlock(&neighbor_db_lock);
+        free(new_neighbor);
+        STUB_LOG_ERR("Neighbor not found\n");
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    old_neighbor  = *link;
+    *new_neighbor = *old_neighbor;
+
+    if (SAI_NEIGHBOR_ATTR_DST_MAC_ADDRESS == attr_id) {
+        memcpy(new_neighbor->mac, value->mac, sizeof(new_neighbor->mac));
+    } else {
+        new_neighbor->packet_action = value->s32;
+    }
+
+    STUB_RCU_ASSIGN(*link, new_neighbor);
+
+    pthread_mutex_unlock(&neighbor_db_lock);
+
+    stub_rcu_defer_free(old_neighbor);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void db_free_neighbors(_In_ stub_neighbor_t **buckets)
+{
+    stub_neighbor_t *neighbor, *next;
+    uint32_t         ii;
+
+    for (ii = 0; ii < NEIGHBOR_DB_BUCKETS; ii++) {
+        for (neighbor = buckets[ii]; NULL != neighbor; neighbor = next) {
+            next = neighbor->next;
+            stub_rcu_defer_free(neighbor);
+        }
+    }
+}
+
+/*
+ * Routine Description:
+ *    Resolve the MAC of a neighbor. Caller must be in a read side section.
+ *
+ * Arguments:
+ *    [in] neighbor_entry - router interface and IP
+ *    [out] mac - neighbor MAC
+ *    [out] action - neighbor packet action
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    SAI_STATUS_ITEM_NOT_FOUND if the neighbor is not resolved
+ */
+sai_status_t db_lookup_neighbor(_In_ const sai_neighbor_entry_t *neighbor_entry,
+                                _Out_ sai_mac_t                  mac,
+                                _Out_ sai_int32_t               *action)
+{
+    stub_neighbor_t **link;
+    stub_neighbor_t  *neighbor;
+
+    if (NULL == (link = db_find_neighbor_link(neighbor_entry))) {
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    neighbor = STUB_RCU_DEREF(*link);
+    memcpy(mac, neighbor->mac, sizeof(sai_mac_t));
+    *action = neighbor->packet_action;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+void db_init_neighbor()
+{
+    pthread_mutex_lock(&neighbor_db_lock);
+
+    db_free_neighbors(neighbor_db);
+    memset(neighbor_db, 0, sizeof(neighbor_db));
+
+    pthread_mutex_unlock(&neighbor_db_lock);
+
+    stub_rcu_barrier();
+}
+
+/*************************/
+
 static void neighbor_key_to_str(_In_ const sai_neighbor_entry_t* neighbor_entry, _Out_ char *key_str)
 {
     int      res1, res2;
@@ -93,10 +274,12 @@ sai_status_t stub_create_neighbor_entry(_In_ const sai_neighbor_entry_t* neighbo
                                         _In_ uint32_t                    attr_count,
                                         _In_ const sai_attribute_t      *attr_list)
 {
-    sai_status_t status;
-    uint32_t     rif_data;
-    char         key_str[MAX_KEY_STR_LEN];
-    char         list_str[MAX_LIST_VALUE_STR_LEN];
+    sai_status_t                 status;
+    const sai_attribute_value_t *mac, *action;
+    uint32_t                     mac_index, action_index, rif_data;
+    stub_neighbor_t             *neighbor;
+    char                         key_str[MAX_KEY_STR_LEN];
+    char                         list_str[MAX_LIST_VALUE_STR_LEN];
 
     STUB_LOG_ENTER();
 
@@ -123,6 +306,42 @@ sai_status_t stub_create_neighbor_entry(_In_ const sai_neighbor_entry_t* neighbo
         return status;
     }
 
+    if ((SAI_IP_ADDR_FAMILY_IPV4 != neighbor_entry->ip_address.addr_family) &&
+        (SAI_IP_ADDR_FAMILY_IPV6 != neighbor_entry->ip_address.addr_family)) {
+        STUB_LOG_ERR("Invalid neighbor address family %d\n", neighbor_entry->ip_address.addr_family);
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    status = find_attrib_in_list(attr_count, attr_list, SAI_NEIGHBOR_ATTR_DST_MAC_ADDRESS, &mac, &mac_index);
+    assert(SAI_STATUS_SUCCESS == status);
+
+    if (NULL == (neighbor = calloc(1, sizeof(*neighbor)))) {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    neighbor->entry         = *neighbor_entry;
+    neighbor->packet_action = SAI_PACKET_ACTION_FORWARD;
+    memcpy(neighbor->mac, mac->mac, sizeof(neighbor->mac));
+
+    if (SAI_STATUS_SUCCESS ==
+        find_attrib_in_list(attr_count, attr_list, SAI_NEIGHBOR_ATTR_PACKET_ACTION, &action, &action_index)) {
+        neighbor->packet_action = action->s32;
+    }
+
+    pthread_mutex_lock(&neighbor_db_lock);
+
+    if (NULL != db_find_neighbor_link(neighbor_entry)) {
+        pthread_mutex_unlock(&neighbor_db_lock);
+        free(neighbor);
+        STUB_LOG_ERR("Neighbor already exists\n");
+        return SAI_STATUS_ITEM_ALREADY_EXISTS;
+    }
+
+    neighbor->next = neighbor_db[neighbor_key_hash(neighbor_entry)];
+    STUB_RCU_ASSIGN(neighbor_db[neighbor_key_hash(neighbor_entry)], neighbor);
+
+    pthread_mutex_unlock(&neighbor_db_lock);
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -142,7 +361,9 @@ sai_status_t stub_create_neighbor_entry(_In_ const sai_neighbor_entry_t* neighbo
  */
 sai_status_t stub_remove_neighbor_entry(_In_ const sai_neighbor_entry_t* neighbor_entry)
 {
-    char key_str[MAX_KEY_STR_LEN];
+    char              key_str[MAX_KEY_STR_LEN];
+    stub_neighbor_t **link;
+    stub_neighbor_t  *neighbor;
 
     STUB_LOG_ENTER();
 
@@ -154,6 +375,21 @@ sai_status_t stub_remove_neighbor_entry(_In_ const sai_neighbor_entry_t* neighbo
     neighbor_key_to_str(neighbor_entry, key_str);
     STUB_LOG_NTC("Remove neighbor entry %s\n", key_str);
 
+    pthread_mutex_lock(&neighbor_db_lock);
+
+    if (NULL == (link = db_find_neighbor_link(neighbor_entry))) {
+        pthread_mutex_unlock(&neighbor_db_lock);
+        STUB_LOG_ERR("Neighbor not found\n");
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    neighbor = *link;
+    STUB_RCU_ASSIGN(*link, neighbor->next);
+
+    pthread_mutex_unlock(&neighbor_db_lock);
+
+    stub_rcu_defer_free(neighbor);
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -206,6 +442,7 @@ sai_status_t stub_get_neighbor_attribute(_In_ const sai_neighbor_entry_t* neighb
 {
     const sai_object_key_t key = { .neighbor_entry = neighbor_entry };
     char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
 
     STUB_LOG_ENTER();
 
@@ -215,7 +452,13 @@ sai_status_t stub_get_neighbor_attribute(_In_ const sai_neighbor_entry_t* neighb
     }
 
     neighbor_key_to_str(neighbor_entry, key_str);
-    return sai_get_attributes(&key, key_str, neighbor_attribs, neighbor_vendor_attribs, attr_count, attr_list);
+
+    /* Lock-free read, never waits for neighbor programming */
+    stub_rcu_read_lock();
+    status = sai_get_attributes(&key, key_str, neighbor_attribs, neighbor_vendor_attribs, attr_count, attr_list);
+    stub_rcu_read_unlock();
+
+    return status;
 }
 
 /* Destination mac address for the neighbor [sai_mac_t] */
@@ -225,8 +468,17 @@ sai_status_t stub_neighbor_mac_get(_In_ const sai_object_key_t   *key,
                                    _Inout_ vendor_cache_t        *cache,
                                    void                          *arg)
 {
+    const stub_neighbor_t *neighbor;
+    sai_status_t           status;
+
     STUB_LOG_ENTER();
 
+    if (SAI_STATUS_SUCCESS != (status = db_get_neighbor(key->neighbor_entry, cache, &neighbor))) {
+        return status;
+    }
+
+    memcpy(value->mac, neighbor->mac, sizeof(value->mac));
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -238,9 +490,16 @@ sai_status_t stub_neighbor_action_get(_In_ const sai_object_key_t   *key,
                                       _Inout_ vendor_cache_t        *cache,
                                       void                          *arg)
 {
+    const stub_neighbor_t *neighbor;
+    sai_status_t           status;
+
     STUB_LOG_ENTER();
 
-    value->s32 = SAI_PACKET_ACTION_DROP;
+    if (SAI_STATUS_SUCCESS != (status = db_get_neighbor(key->neighbor_entry, cache, &neighbor))) {
+        return status;
+    }
+
+    value->s32 = neighbor->packet_action;
 
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
@@ -253,7 +512,7 @@ sai_status_t stub_neighbor_mac_set(_In_ const sai_object_key_t *key, _In_ const
     STUB_LOG_ENTER();
 
     STUB_LOG_EXIT();
-    return SAI_STATUS_SUCCESS;
+    return db_update_neighbor(key->neighbor_entry, SAI_NEIGHBOR_ATTR_DST_MAC_ADDRESS, value);
 }
 
 /* L3 forwarding action for this neighbor [sai_packet_action_t] */
@@ -264,7 +523,7 @@ sai_status_t stub_neighbor_action_set(_In_ const sai_object_key_t      *key,
     STUB_LOG_ENTER();
 
     STUB_LOG_EXIT();
-    return SAI_STATUS_SUCCESS;
+    return db_update_neighbor(key->neighbor_entry, SAI_NEIGHBOR_ATTR_PACKET_ACTION, value);
 }
 
 
@@ -285,6 +544,8 @@ sai_status_t stub_remove_all_neighbor_entries(void)
 
     STUB_LOG_NTC("Remove all neighbor entries\n");
 
+    db_init_neighbor();
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
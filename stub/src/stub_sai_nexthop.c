@@ -66,6 +66,91 @@ static const sai_vendor_attribute_entry_t next_hop_vendor_attribs[] = {
       stub_next_hop_rif_get, NULL,
       NULL, NULL },
 };
+
+/* State DB *************/
+typedef struct _stub_next_hop_t {
+    sai_ip_address_t ip;
+    sai_object_id_t  rif_id;
+} stub_next_hop_t;
+
+#define MAX_NEXT_HOP_NUMBER 4096
+/* Entries are published with STUB_RCU_ASSIGN, readers never lock */
+static stub_next_hop_t *next_hop_db[MAX_NEXT_HOP_NUMBER];
+static pthread_mutex_t  next_hop_db_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void db_init_next_hop()
+{
+    uint32_t ii;
+
+    pthread_mutex_lock(&next_hop_db_lock);
+    for (ii = 0; ii < MAX_NEXT_HOP_NUMBER; ii++) {
+        stub_rcu_defer_free(next_hop_db[ii]);
+        STUB_RCU_ASSIGN(next_hop_db[ii], NULL);
+    }
+    pthread_mutex_unlock(&next_hop_db_lock);
+
+    stub_rcu_barrier();
+}
+
+/* Caller must be in a read side section, the entry is valid until it leaves */
+static const stub_next_hop_t* db_find_next_hop(_In_ sai_object_id_t next_hop_id)
+{
+    uint32_t index;
+
+    if ((SAI_STATUS_SUCCESS != stub_object_to_type(next_hop_id, SAI_OBJECT_TYPE_NEXT_HOP, &index)) ||
+        (index >= MAX_NEXT_HOP_NUMBER)) {
+        return NULL;
+    }
+
+    return STUB_RCU_DEREF(next_hop_db[index]);
+}
+
+static sai_status_t db_get_next_hop(_In_ sai_object_id_t        next_hop_id,
+                                    _Inout_ vendor_cache_t     *cache,
+                                    _Out_ const stub_next_hop_t **next_hop)
+{
+    if (NULL == (*next_hop = cache->entry)) {
+        if (NULL == (*next_hop = db_find_next_hop(next_hop_id))) {
+            STUB_LOG_ERR("Next hop not found\n");
+            return SAI_STATUS_INVALID_OBJECT_ID;
+        }
+        cache->entry = *next_hop;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Resolve next hop IP and router interface. Caller must be in a read side section.
+ *
+ * Arguments:
+ *    [in] next_hop_id - next hop id
+ *    [out] ip - next hop IP address
+ *    [out] rif_id - egress router interface
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    SAI_STATUS_ITEM_NOT_FOUND if the next hop does not exist
+ */
+sai_status_t db_lookup_next_hop(_In_ sai_object_id_t     next_hop_id,
+                                _Out_ sai_ip_address_t *ip,
+                                _Out_ sai_object_id_t  *rif_id)
+{
+    const stub_next_hop_t *next_hop;
+
+    if (NULL == (next_hop = db_find_next_hop(next_hop_id))) {
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    *ip     = next_hop->ip;
+    *rif_id = next_hop->rif_id;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*************************/
+
 static void next_hop_key_to_str(_In_ sai_object_id_t next_hop_id, _Out_ char *key_str)
 {
     uint32_t nexthop_data;
@@ -98,10 +183,10 @@ sai_status_t stub_create_next_hop(_Out_ sai_object_id_t      *next_hop_id,
 {
     sai_status_t                 status;
     const sai_attribute_value_t *type, *ip, *rif;
-    uint32_t                     type_index, ip_index, rif_index;
+    uint32_t                     type_index, ip_index, rif_index, index;
+    stub_next_hop_t             *next_hop;
     char                         list_str[MAX_LIST_VALUE_STR_LEN];
     char                         key_str[MAX_KEY_STR_LEN];
-    static uint32_t              next_id = 0;
 
     STUB_LOG_ENTER();
 
@@ -139,7 +224,38 @@ sai_status_t stub_create_next_hop(_Out_ sai_object_id_t      *next_hop_id,
         return SAI_STATUS_INVALID_ATTR_VALUE_0 + ip_index;
     }
 
-    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_NEXT_HOP, next_id++, next_hop_id))) {
+    if (SAI_OBJECT_TYPE_ROUTER_INTERFACE != sai_object_type_query(rif->oid)) {
+        STUB_LOG_ERR("Invalid next hop rif object type %s\n", SAI_TYPE_STR(sai_object_type_query(rif->oid)));
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + rif_index;
+    }
+
+    if (NULL == (next_hop = malloc(sizeof(*next_hop)))) {
+        return SAI_STATUS_NO_MEMORY;
+    }
+    next_hop->ip     = ip->ipaddr;
+    next_hop->rif_id = rif->oid;
+
+    pthread_mutex_lock(&next_hop_db_lock);
+
+    for (index = 0; index < MAX_NEXT_HOP_NUMBER; index++) {
+        if (NULL == next_hop_db[index]) {
+            break;
+        }
+    }
+
+    if (MAX_NEXT_HOP_NUMBER == index) {
+        pthread_mutex_unlock(&next_hop_db_lock);
+        free(next_hop);
+        STUB_LOG_ERR("Next hop table full\n");
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    STUB_RCU_ASSIGN(next_hop_db[index], next_hop);
+
+    pthread_mutex_unlock(&next_hop_db_lock);
+
+    if (SAI_STATUS_SUCCESS !=
+        (status = stub_create_object(SAI_OBJECT_TYPE_NEXT_HOP, index, next_hop_id))) {
         return status;
     }
     next_hop_key_to_str(*next_hop_id, key_str);
@@ -162,13 +278,34 @@ sai_status_t stub_create_next_hop(_Out_ sai_object_id_t      *next_hop_id,
  */
 sai_status_t stub_remove_next_hop(_In_ sai_object_id_t next_hop_id)
 {
-    char key_str[MAX_KEY_STR_LEN];
+    char             key_str[MAX_KEY_STR_LEN];
+    stub_next_hop_t *next_hop;
+    sai_status_t     status;
+    uint32_t         index;
 
     STUB_LOG_ENTER();
 
     next_hop_key_to_str(next_hop_id, key_str);
     STUB_LOG_NTC("Remove next hop %s\n", key_str);
 
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(next_hop_id, SAI_OBJECT_TYPE_NEXT_HOP, &index))) {
+        return status;
+    }
+
+    pthread_mutex_lock(&next_hop_db_lock);
+
+    if ((index >= MAX_NEXT_HOP_NUMBER) || (NULL == (next_hop = next_hop_db[index]))) {
+        pthread_mutex_unlock(&next_hop_db_lock);
+        STUB_LOG_ERR("Next hop %s not found\n", key_str);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    STUB_RCU_ASSIGN(next_hop_db[index], NULL);
+
+    pthread_mutex_unlock(&next_hop_db_lock);
+
+    stub_rcu_defer_free(next_hop);
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -216,11 +353,17 @@ sai_status_t stub_get_next_hop_attribute(_In_ sai_object_id_t     next_hop_id,
 {
     const sai_object_key_t key = { .object_id = next_hop_id };
     char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
 
     STUB_LOG_ENTER();
 
     next_hop_key_to_str(next_hop_id, key_str);
-    return sai_get_attributes(&key, key_str, next_hop_attribs, next_hop_vendor_attribs, attr_count, attr_list);
+
+    stub_rcu_read_lock();
+    status = sai_get_attributes(&key, key_str, next_hop_attribs, next_hop_vendor_attribs, attr_count, attr_list);
+    stub_rcu_read_unlock();
+
+    return status;
 }
 
 /* Next hop entry type [sai_next_hop_type_t] */
@@ -230,8 +373,15 @@ sai_status_t stub_next_hop_type_get(_In_ const sai_object_key_t   *key,
                                     _Inout_ vendor_cache_t        *cache,
                                     void                          *arg)
 {
+    const stub_next_hop_t *next_hop;
+    sai_status_t           status;
+
     STUB_LOG_ENTER();
 
+    if (SAI_STATUS_SUCCESS != (status = db_get_next_hop(key->object_id, cache, &next_hop))) {
+        return status;
+    }
+
     value->s32 = SAI_NEXT_HOP_IP;
 
     STUB_LOG_EXIT();
@@ -245,18 +395,16 @@ sai_status_t stub_next_hop_ip_get(_In_ const sai_object_key_t   *key,
                                   _Inout_ vendor_cache_t        *cache,
                                   void                          *arg)
 {
-    uint32_t     nexthop_data;
-    sai_status_t status;
+    const stub_next_hop_t *next_hop;
+    sai_status_t           status;
 
     STUB_LOG_ENTER();
 
-    if (SAI_STATUS_SUCCESS !=
-        (status = stub_object_to_type(key->object_id, SAI_OBJECT_TYPE_NEXT_HOP, &nexthop_data))) {
+    if (SAI_STATUS_SUCCESS != (status = db_get_next_hop(key->object_id, cache, &next_hop))) {
         return status;
     }
 
-    value->ipaddr.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
-    value->ipaddr.addr.ip4    = 0;
+    value->ipaddr = next_hop->ip;
 
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
@@ -269,19 +417,16 @@ sai_status_t stub_next_hop_rif_get(_In_ const sai_object_key_t   *key,
                                    _Inout_ vendor_cache_t        *cache,
                                    void                          *arg)
 {
-    uint32_t     nexthop_data;
-    sai_status_t status;
+    const stub_next_hop_t *next_hop;
+    sai_status_t           status;
 
     STUB_LOG_ENTER();
 
-    if (SAI_STATUS_SUCCESS !=
-        (status = stub_object_to_type(key->object_id, SAI_OBJECT_TYPE_NEXT_HOP, &nexthop_data))) {
+    if (SAI_STATUS_SUCCESS != (status = db_get_next_hop(key->object_id, cache, &next_hop))) {
         return status;
     }
 
-    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_ROUTER_INTERFACE, 0, &value->oid))) {
-        return status;
-    }
+    value->oid = next_hop->rif_id;
 
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
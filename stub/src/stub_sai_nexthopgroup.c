@@ -81,12 +81,17 @@ typedef struct _stub_next_hop_group_t {
 
 #define MAX_NEXT_HOP_GROUP_NUMBER 1000
 static stub_next_hop_group_t next_hop_group_db[MAX_NEXT_HOP_GROUP_NUMBER];
+/* Writers take the table exclusively, attribute gets share it */
+static pthread_rwlock_t      next_hop_group_db_lock = STUB_RWLOCK_INITIALIZER;
 
 void db_init_next_hop_group()
 {
+    pthread_rwlock_wrlock(&next_hop_group_db_lock);
     memset(next_hop_group_db, 0, sizeof(next_hop_group_db));
+    pthread_rwlock_unlock(&next_hop_group_db_lock);
 }
 
+/* Returned list points into the table, caller must hold next_hop_group_db_lock */
 sai_status_t db_get_next_hop_group(_In_ uint32_t next_hop_group_id, _Out_ sai_object_list_t   *next_hop_list)
 {
     if (NULL == next_hop_list) {
@@ -106,6 +111,43 @@ sai_status_t db_get_next_hop_group(_In_ uint32_t next_hop_group_id, _Out_ sai_ob
     return SAI_STATUS_SUCCESS;
 }
 
+/*
+ * Routine Description:
+ *    Select the group member for a flow
+ *
+ * Arguments:
+ *    [in] next_hop_group_id - next hop group index
+ *    [in] flow_hash - flow hash, equal hashes select the same member
+ *    [out] next_hop_id - selected next hop
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    SAI_STATUS_ITEM_NOT_FOUND if the group does not exist or is empty
+ */
+sai_status_t db_select_next_hop_group_member(_In_ uint32_t          next_hop_group_id,
+                                             _In_ uint32_t          flow_hash,
+                                             _Out_ sai_object_id_t *next_hop_id)
+{
+    stub_next_hop_group_t *group;
+    sai_status_t           status = SAI_STATUS_ITEM_NOT_FOUND;
+
+    if (next_hop_group_id >= MAX_NEXT_HOP_GROUP_NUMBER) {
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    pthread_rwlock_rdlock(&next_hop_group_db_lock);
+
+    group = &next_hop_group_db[next_hop_group_id];
+    if (group->is_valid && (0 != group->next_hop_count)) {
+        *next_hop_id = group->next_hop_list[flow_hash % group->next_hop_count];
+        status       = SAI_STATUS_SUCCESS;
+    }
+
+    pthread_rwlock_unlock(&next_hop_group_db_lock);
+
+    return status;
+}
+
 static sai_status_t db_find_free_index(_Out_ uint32_t *free_index)
 {
     uint32_t ii;
@@ -165,12 +207,15 @@ static sai_status_t db_create_next_hop_group(_Out_ uint32_t               *next_
     }
 
     if (SAI_STATUS_SUCCESS !=
-        (status = db_find_free_index(next_hop_group_id))) {
+        (status = validate_next_hop_list(next_hop_list->count, next_hop_list->list, param_index))) {
         return status;
     }
 
+    pthread_rwlock_wrlock(&next_hop_group_db_lock);
+
     if (SAI_STATUS_SUCCESS !=
-        (status = validate_next_hop_list(next_hop_list->count, next_hop_list->list, param_index))) {
+        (status = db_find_free_index(next_hop_group_id))) {
+        pthread_rwlock_unlock(&next_hop_group_db_lock);
         return status;
     }
 
@@ -180,19 +225,26 @@ static sai_status_t db_create_next_hop_group(_Out_ uint32_t               *next_
            sizeof(sai_object_id_t) * next_hop_list->count);
     next_hop_group_db[*next_hop_group_id].is_valid = true;
 
+    pthread_rwlock_unlock(&next_hop_group_db_lock);
+
     return SAI_STATUS_SUCCESS;
 }
 
 static sai_status_t db_remove_next_hop_group(_In_ uint32_t next_hop_group_id)
 {
+    pthread_rwlock_wrlock(&next_hop_group_db_lock);
+
     if ((next_hop_group_id >= MAX_NEXT_HOP_GROUP_NUMBER) ||
         (!next_hop_group_db[next_hop_group_id].is_valid)) {
+        pthread_rwlock_unlock(&next_hop_group_db_lock);
         STUB_LOG_ERR("Invalid next hop group ID %u\n", next_hop_group_id);
         return SAI_STATUS_INVALID_PARAMETER;
     }
 
     next_hop_group_db[next_hop_group_id].is_valid = false;
 
+    pthread_rwlock_unlock(&next_hop_group_db_lock);
+
     return SAI_STATUS_SUCCESS;
 }
 
@@ -200,12 +252,6 @@ sai_status_t db_update_next_hop_group_list(_In_ uint32_t next_hop_group_id, _In_
 {
     sai_status_t status;
 
-    if ((next_hop_group_id >= MAX_NEXT_HOP_GROUP_NUMBER) ||
-        (!next_hop_group_db[next_hop_group_id].is_valid)) {
-        STUB_LOG_ERR("Invalid next hop group ID %u\n", next_hop_group_id);
-        return SAI_STATUS_INVALID_PARAMETER;
-    }
-
     if (next_hop_list.count > ECMP_MAX_PATHS) {
         STUB_LOG_ERR("Next hop count %u bigger than maximum %u\n", next_hop_list.count, ECMP_MAX_PATHS);
         return SAI_STATUS_INVALID_ATTR_VALUE_0;
@@ -216,11 +262,22 @@ sai_status_t db_update_next_hop_group_list(_In_ uint32_t next_hop_group_id, _In_
         return status;
     }
 
+    pthread_rwlock_wrlock(&next_hop_group_db_lock);
+
+    if ((next_hop_group_id >= MAX_NEXT_HOP_GROUP_NUMBER) ||
+        (!next_hop_group_db[next_hop_group_id].is_valid)) {
+        pthread_rwlock_unlock(&next_hop_group_db_lock);
+        STUB_LOG_ERR("Invalid next hop group ID %u\n", next_hop_group_id);
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
     next_hop_group_db[next_hop_group_id].next_hop_count = next_hop_list.count;
     memcpy(next_hop_group_db[next_hop_group_id].next_hop_list,
            next_hop_list.list,
            sizeof(sai_object_id_t) * next_hop_list.count);
 
+    pthread_rwlock_unlock(&next_hop_group_db_lock);
+
     return SAI_STATUS_SUCCESS;
 }
 
@@ -231,8 +288,16 @@ sai_status_t db_add_members_next_hop_group_list(_In_ uint32_t               next
     stub_next_hop_group_t *group;
     sai_status_t           status;
 
+    if (SAI_STATUS_SUCCESS !=
+        (status = validate_next_hop_list(next_hop_count, nexthops, 0))) {
+        return status;
+    }
+
+    pthread_rwlock_wrlock(&next_hop_group_db_lock);
+
     if ((next_hop_group_id >= MAX_NEXT_HOP_GROUP_NUMBER) ||
         (!next_hop_group_db[next_hop_group_id].is_valid)) {
+        pthread_rwlock_unlock(&next_hop_group_db_lock);
         STUB_LOG_ERR("Invalid next hop group ID %u\n", next_hop_group_id);
         return SAI_STATUS_INVALID_PARAMETER;
     }
@@ -240,21 +305,19 @@ sai_status_t db_add_members_next_hop_group_list(_In_ uint32_t               next
     group = &next_hop_group_db[next_hop_group_id];
 
     if (next_hop_count + group->next_hop_count > ECMP_MAX_PATHS) {
+        pthread_rwlock_unlock(&next_hop_group_db_lock);
         STUB_LOG_ERR("Next hop count %u bigger than maximum %u\n",
                      next_hop_count + group->next_hop_count, ECMP_MAX_PATHS);
         return SAI_STATUS_INVALID_ATTR_VALUE_0;
     }
 
-    if (SAI_STATUS_SUCCESS !=
-        (status = validate_next_hop_list(next_hop_count, nexthops, 0))) {
-        return status;
-    }
-
     memcpy(&group->next_hop_list[group->next_hop_count],
            nexthops,
            sizeof(sai_object_id_t) * next_hop_count);
     group->next_hop_count += next_hop_count;
 
+    pthread_rwlock_unlock(&next_hop_group_db_lock);
+
     return SAI_STATUS_SUCCESS;
 }
 
@@ -278,8 +341,11 @@ sai_status_t db_remove_members_next_hop_group_list(_In_ uint32_t               n
     stub_next_hop_group_t *group;
     uint32_t               ii = 0;
 
+    pthread_rwlock_wrlock(&next_hop_group_db_lock);
+
     if ((next_hop_group_id >= MAX_NEXT_HOP_GROUP_NUMBER) ||
         (!next_hop_group_db[next_hop_group_id].is_valid)) {
+        pthread_rwlock_unlock(&next_hop_group_db_lock);
         STUB_LOG_ERR("Invalid next hop group ID %u\n", next_hop_group_id);
         return SAI_STATUS_INVALID_PARAMETER;
     }
@@ -295,6 +361,8 @@ sai_status_t db_remove_members_next_hop_group_list(_In_ uint32_t               n
         ii++;
     }
 
+    pthread_rwlock_unlock(&next_hop_group_db_lock);
+
     return SAI_STATUS_SUCCESS;
 }
 
@@ -461,16 +529,23 @@ sai_status_t stub_get_next_hop_group_attribute(_In_ sai_object_id_t     next_hop
 {
     const sai_object_key_t key = { .object_id = next_hop_group_id };
     char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
 
     STUB_LOG_ENTER();
 
     next_hop_group_key_to_str(next_hop_group_id, key_str);
-    return sai_get_attributes(&key,
-                              key_str,
-                              next_hop_group_attribs,
-                              next_hop_group_vendor_attribs,
-                              attr_count,
-                              attr_list);
+
+    /* Hold the table for all attributes so the count and list are consistent */
+    pthread_rwlock_rdlock(&next_hop_group_db_lock);
+    status = sai_get_attributes(&key,
+                                key_str,
+                                next_hop_group_attribs,
+                                next_hop_group_vendor_attribs,
+                                attr_count,
+                                attr_list);
+    pthread_rwlock_unlock(&next_hop_group_db_lock);
+
+    return status;
 }
 
 /* Next hop group type [sai_next_hop_group_type_t] */
@@ -0,0 +1,1044 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#include "sai.h"
+#include "stub_sai.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_policer.h"
+#include "assert.h"
+#include <inttypes.h>
+#include <time.h>
+
+#undef  __MODULE__
+#define __MODULE__ SAI_POLICER
+
+static const sai_attribute_entry_t policer_attribs[] = {
+    { SAI_POLICER_ATTR_METER_TYPE, true, true, false, true,
+      "Policer meter type", SAI_ATTR_VAL_TYPE_S32 },
+    { SAI_POLICER_ATTR_MODE, true, true, false, true,
+      "Policer mode", SAI_ATTR_VAL_TYPE_S32 },
+    { SAI_POLICER_ATTR_COLOR_SOURCE, false, true, true, true,
+      "Policer color source", SAI_ATTR_VAL_TYPE_S32 },
+    { SAI_POLICER_ATTR_CBS, false, true, true, true,
+      "Policer CBS", SAI_ATTR_VAL_TYPE_U64 },
+    { SAI_POLICER_ATTR_CIR, false, true, true, true,
+      "Policer CIR", SAI_ATTR_VAL_TYPE_U64 },
+    { SAI_POLICER_ATTR_PBS, false, true, true, true,
+      "Policer PBS", SAI_ATTR_VAL_TYPE_U64 },
+    { SAI_POLICER_ATTR_PIR, false, true, true, true,
+      "Policer PIR", SAI_ATTR_VAL_TYPE_U64 },
+    { SAI_POLICER_ATTR_GREEN_PACKET_ACTION, false, true, true, true,
+      "Policer green action", SAI_ATTR_VAL_TYPE_S32 },
+    { SAI_POLICER_ATTR_YELLOW_PACKET_ACTION, false, true, true, true,
+      "Policer yellow action", SAI_ATTR_VAL_TYPE_S32 },
+    { SAI_POLICER_ATTR_RED_PACKET_ACTION, false, true, true, true,
+      "Policer red action", SAI_ATTR_VAL_TYPE_S32 },
+    { SAI_POLICER_ATTR_ENABLE_COUNTER_LIST, false, true, true, true,
+      "Policer counters", SAI_ATTR_VAL_TYPE_S32LIST },
+    { END_FUNCTIONALITY_ATTRIBS_ID, false, false, false, false,
+      "", SAI_ATTR_VAL_TYPE_UNDETERMINED }
+};
+
+sai_status_t stub_policer_attr_get(_In_ const sai_object_key_t   *key,
+                                   _Inout_ sai_attribute_value_t *value,
+                                   _In_ uint32_t                  attr_index,
+                                   _Inout_ vendor_cache_t        *cache,
+                                   void                          *arg);
+sai_status_t stub_policer_attr_set(_In_ const sai_object_key_t      *key,
+                                   _In_ const sai_attribute_value_t *value,
+                                   void                             *arg);
+
+static const sai_vendor_attribute_entry_t policer_vendor_attribs[] = {
+    { SAI_POLICER_ATTR_METER_TYPE,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_policer_attr_get, (void*)SAI_POLICER_ATTR_METER_TYPE,
+      NULL, NULL },
+    { SAI_POLICER_ATTR_MODE,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_policer_attr_get, (void*)SAI_POLICER_ATTR_MODE,
+      NULL, NULL },
+    { SAI_POLICER_ATTR_COLOR_SOURCE,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_policer_attr_get, (void*)SAI_POLICER_ATTR_COLOR_SOURCE,
+      stub_policer_attr_set, (void*)SAI_POLICER_ATTR_COLOR_SOURCE },
+    { SAI_POLICER_ATTR_CBS,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_policer_attr_get, (void*)SAI_POLICER_ATTR_CBS,
+      stub_policer_attr_set, (void*)SAI_POLICER_ATTR_CBS },
+    { SAI_POLICER_ATTR_CIR,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_policer_attr_get, (void*)SAI_POLICER_ATTR_CIR,
+      stub_policer_attr_set, (void*)SAI_POLICER_ATTR_CIR },
+    { SAI_POLICER_ATTR_PBS,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_policer_attr_get, (void*)SAI_POLICER_ATTR_PBS,
+      stub_policer_attr_set, (void*)SAI_POLICER_ATTR_PBS },
+    { SAI_POLICER_ATTR_PIR,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_policer_attr_get, (void*)SAI_POLICER_ATTR_PIR,
+      stub_policer_attr_set, (void*)SAI_POLICER_ATTR_PIR },
+    { SAI_POLICER_ATTR_GREEN_PACKET_ACTION,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_policer_attr_get, (void*)SAI_POLICER_ATTR_GREEN_PACKET_ACTION,
+      stub_policer_attr_set, (void*)SAI_POLICER_ATTR_GREEN_PACKET_ACTION },
+    { SAI_POLICER_ATTR_YELLOW_PACKET_ACTION,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_policer_attr_get, (void*)SAI_POLICER_ATTR_YELLOW_PACKET_ACTION,
+      stub_policer_attr_set, (void*)SAI_POLICER_ATTR_YELLOW_PACKET_ACTION },
+    { SAI_POLICER_ATTR_RED_PACKET_ACTION,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_policer_attr_get, (void*)SAI_POLICER_ATTR_RED_PACKET_ACTION,
+      stub_policer_attr_set, (void*)SAI_POLICER_ATTR_RED_PACKET_ACTION },
+    { SAI_POLICER_ATTR_ENABLE_COUNTER_LIST,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_policer_attr_get, (void*)SAI_POLICER_ATTR_ENABLE_COUNTER_LIST,
+      stub_policer_attr_set, (void*)SAI_POLICER_ATTR_ENABLE_COUNTER_LIST },
+};
+
+/* State DB *************/
+#define MAX_POLICERS         64
+/* bucket credit of one byte or packet, tokens are kept in unit nanoseconds */
+#define POLICER_TOKEN        1000000000ULL
+/* keeps the bucket arithmetic within 64 bits */
+#define POLICER_MAX_RATE     1000000000ULL
+#define POLICER_COLORS       (SAI_PACKET_COLOR_RED + 1)
+#define POLICER_STAT_COUNT   (SAI_POLICER_STAT_RED_BYTES + 1)
+
+typedef struct _policer_t {
+    bool            is_used;
+    sai_int32_t     meter_type;
+    sai_int32_t     mode;
+    sai_int32_t     color_source;
+    uint64_t        cbs;
+    uint64_t        cir;
+    uint64_t        pbs;
+    uint64_t        pir;
+    sai_int32_t     actions[POLICER_COLORS];
+    sai_int32_t     counters[POLICER_STAT_COUNT];
+    uint32_t        counter_count;
+    /* ports, ACL entries and trap groups metering through the policer */
+    uint32_t        ref_count;
+    /* committed and peak (excess for Sr_TCM) buckets, the data plane takes
+     * them per burst */
+    pthread_mutex_t bucket_lock;
+    uint64_t        committed;
+    uint64_t        peak;
+    uint64_t        last_ns;
+    uint64_t        packets[POLICER_COLORS];
+    uint64_t        bytes[POLICER_COLORS];
+} policer_t;
+
+static policer_t        policer_db[MAX_POLICERS] = {
+    [0 ... MAX_POLICERS - 1] = { .bucket_lock = PTHREAD_MUTEX_INITIALIZER }
+};
+/* Writers take the table exclusively, the data plane shares it per burst */
+static pthread_rwlock_t policer_db_lock = STUB_RWLOCK_INITIALIZER;
+
+static inline uint64_t policer_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+/* Caller holds policer_db_lock */
+static sai_status_t policer_db_index(_In_ sai_object_id_t policer_id, _Out_ uint32_t *index)
+{
+    sai_status_t status;
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(policer_id, SAI_OBJECT_TYPE_POLICER, index))) {
+        return status;
+    }
+
+    if ((*index >= MAX_POLICERS) || (!policer_db[*index].is_used)) {
+        STUB_LOG_ERR("Policer %u does not exist\n", *index);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void policer_key_to_str(_In_ sai_object_id_t policer_id, _Out_ char *key_str)
+{
+    uint32_t index;
+
+    if (SAI_STATUS_SUCCESS != stub_object_to_type(policer_id, SAI_OBJECT_TYPE_POLICER, &index)) {
+        snprintf(key_str, MAX_KEY_STR_LEN, "invalid policer id");
+    } else {
+        snprintf(key_str, MAX_KEY_STR_LEN, "policer id %u", index);
+    }
+}
+
+/* Full buckets. Caller holds policer_db_lock exclusively */
+static void policer_bucket_reset(_Inout_ policer_t *policer)
+{
+    pthread_mutex_lock(&policer->bucket_lock);
+    policer->committed = policer->cbs * POLICER_TOKEN;
+    policer->peak      = policer->pbs * POLICER_TOKEN;
+    policer->last_ns   = policer_now_ns();
+    pthread_mutex_unlock(&policer->bucket_lock);
+}
+
+/* Tokens a rate earns in elapsed nanoseconds, at most cap. Bounds the
+ * product, a long idle policer just refills */
+static inline uint64_t policer_earned(_In_ uint64_t elapsed, _In_ uint64_t rate, _In_ uint64_t cap)
+{
+    if ((0 == rate) || (elapsed >= cap / rate + 1)) {
+        return (0 == rate) ? 0 : cap;
+    }
+
+    return (elapsed * rate < cap) ? elapsed * rate : cap;
+}
+
+/* Refill the buckets up to now. Caller holds the bucket lock */
+static void policer_refill(_Inout_ policer_t *policer, _In_ uint64_t now_ns)
+{
+    uint64_t c_room, p_room, earned, elapsed;
+
+    if (now_ns <= policer->last_ns) {
+        return;
+    }
+
+    elapsed          = now_ns - policer->last_ns;
+    policer->last_ns = now_ns;
+    c_room           = policer->cbs * POLICER_TOKEN - policer->committed;
+    p_room           = policer->pbs * POLICER_TOKEN - policer->peak;
+
+    if (SAI_POLICER_MODE_Sr_TCM == policer->mode) {
+        /* Tokens the full committed bucket does not take go to the excess one */
+        earned              = policer_earned(elapsed, policer->cir, c_room + p_room);
+        policer->committed += (earned < c_room) ? earned : c_room;
+        policer->peak      += (earned < c_room) ? 0 : earned - c_room;
+        return;
+    }
+
+    policer->committed += policer_earned(elapsed, policer->cir, c_room);
+    if (SAI_POLICER_MODE_Tr_TCM == policer->mode) {
+        policer->peak += policer_earned(elapsed, policer->pir, p_room);
+    }
+}
+
+/* Color of one frame, taking its tokens. Color aware policers get the frame
+ * color, color blind ones green, a frame never gets a better color than it
+ * comes with (RFC 2697, RFC 2698). Caller holds the bucket lock */
+static sai_packet_color_t policer_color(_Inout_ policer_t         *policer,
+                                        _In_ uint32_t              length,
+                                        _In_ sai_packet_color_t    color)
+{
+    uint64_t cost = ((SAI_METER_TYPE_BYTES == policer->meter_type) ? length : 1) * POLICER_TOKEN;
+
+    switch (policer->mode) {
+    case SAI_POLICER_MODE_Sr_TCM:
+        if ((SAI_PACKET_COLOR_GREEN == color) && (policer->committed >= cost)) {
+            policer->committed -= cost;
+            return SAI_PACKET_COLOR_GREEN;
+        }
+        if ((SAI_PACKET_COLOR_RED != color) && (policer->peak >= cost)) {
+            policer->peak -= cost;
+            return SAI_PACKET_COLOR_YELLOW;
+        }
+        return SAI_PACKET_COLOR_RED;
+
+    case SAI_POLICER_MODE_Tr_TCM:
+        if ((SAI_PACKET_COLOR_RED == color) || (policer->peak < cost)) {
+            return SAI_PACKET_COLOR_RED;
+        }
+        policer->peak -= cost;
+        if ((SAI_PACKET_COLOR_YELLOW == color) || (policer->committed < cost)) {
+            return SAI_PACKET_COLOR_YELLOW;
+        }
+        policer->committed -= cost;
+        return SAI_PACKET_COLOR_GREEN;
+
+    default:
+        if ((SAI_PACKET_COLOR_GREEN == color) && (policer->committed >= cost)) {
+            policer->committed -= cost;
+            return SAI_PACKET_COLOR_GREEN;
+        }
+        return SAI_PACKET_COLOR_RED;
+    }
+}
+
+/* Meter the frames of one policer, colors of frames of other policers stay.
+ * Caller holds policer_db_lock */
+static void policer_meter(_Inout_ policer_t          *policer,
+                          _In_ uint32_t                count,
+                          _In_ const uint32_t         *policers,
+                          _In_ uint32_t                index,
+                          _In_ uint64_t                now_ns,
+                          _In_ const stub_packet_t    *packets,
+                          _Out_ sai_packet_color_t    *colors)
+{
+    uint32_t ii;
+
+    pthread_mutex_lock(&policer->bucket_lock);
+
+    policer_refill(policer, now_ns);
+
+    for (ii = 0; ii < count; ii++) {
+        if ((NULL != policers) && (index != policers[ii])) {
+            continue;
+        }
+        colors[ii] = policer_color(policer, packets[ii].length,
+                                   (SAI_POLICER_COLOR_SOURCE_AWARE == policer->color_source) ?
+                                   packets[ii].color : SAI_PACKET_COLOR_GREEN);
+        policer->packets[colors[ii]]++;
+        policer->bytes[colors[ii]] += packets[ii].length;
+    }
+
+    pthread_mutex_unlock(&policer->bucket_lock);
+}
+
+void db_init_policer(void)
+{
+    uint32_t ii;
+
+    pthread_rwlock_wrlock(&policer_db_lock);
+
+    /* The bucket locks stay initialized */
+    for (ii = 0; ii < MAX_POLICERS; ii++) {
+        policer_db[ii].is_used   = false;
+        policer_db[ii].ref_count = 0;
+    }
+
+    pthread_rwlock_unlock(&policer_db_lock);
+}
+
+/*
+ * Routine Description:
+ *    Take a reference on a policer for a port, an ACL entry or a trap group
+ *
+ * Arguments:
+ *    [in] policer_id - policer
+ *    [out] policer - policer index
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    SAI_STATUS_INVALID_ATTR_VALUE_0 if the policer does not exist
+ */
+sai_status_t db_policer_bind(_In_ sai_object_id_t policer_id, _Out_ uint32_t *policer)
+{
+    pthread_rwlock_wrlock(&policer_db_lock);
+
+    if (SAI_STATUS_SUCCESS != policer_db_index(policer_id, policer)) {
+        pthread_rwlock_unlock(&policer_db_lock);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    policer_db[*policer].ref_count++;
+
+    pthread_rwlock_unlock(&policer_db_lock);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* One more reference on a policer the caller holds one on, STUB_NO_POLICER
+ * is ignored */
+void db_policer_ref(_In_ uint32_t policer)
+{
+    if (STUB_NO_POLICER == policer) {
+        return;
+    }
+
+    pthread_rwlock_wrlock(&policer_db_lock);
+    assert(policer_db[policer].ref_count > 0);
+    policer_db[policer].ref_count++;
+    pthread_rwlock_unlock(&policer_db_lock);
+}
+
+/* Drop a reference of db_policer_bind, STUB_NO_POLICER is ignored */
+void db_policer_unbind(_In_ uint32_t policer)
+{
+    if (STUB_NO_POLICER == policer) {
+        return;
+    }
+
+    pthread_rwlock_wrlock(&policer_db_lock);
+    assert(policer_db[policer].ref_count > 0);
+    policer_db[policer].ref_count--;
+    pthread_rwlock_unlock(&policer_db_lock);
+}
+
+/*
+ * Routine Description:
+ *    Meter a chunk of frames, each through its policer, and tell which
+ *    frames the action of their color drops. Each policer is taken once per
+ *    chunk.
+ *
+ * Arguments:
+ *    [in] count - number of frames, at most STUB_DATAPLANE_BURST
+ *    [in] policers - policer index per frame, STUB_NO_POLICER for frames
+ *                    not metered
+ *    [in] packets - frames
+ *    [out] dropped - set for frames to drop, others stay
+ */
+void db_apply_policers(_In_ uint32_t                     count,
+                       _In_ const uint32_t              *policers,
+                       _In_ const struct _stub_packet_t *packets,
+                       _Inout_ bool                     *dropped)
+{
+    sai_packet_color_t colors[STUB_DATAPLANE_BURST];
+    uint64_t           now_ns = 0;
+    sai_int32_t        action;
+    uint32_t           ii, jj;
+    bool               done;
+
+    assert(count <= STUB_DATAPLANE_BURST);
+
+    pthread_rwlock_rdlock(&policer_db_lock);
+
+    for (ii = 0; ii < count; ii++) {
+        /* Data plane users may still see a policer their writer let go of */
+        if ((STUB_NO_POLICER == policers[ii]) || !policer_db[policers[ii]].is_used) {
+            continue;
+        }
+        /* First frame of its policer in the chunk meters the whole policer */
+        for (jj = 0, done = false; jj < ii; jj++) {
+            if (policers[jj] == policers[ii]) {
+                done = true;
+                break;
+            }
+        }
+        if (done) {
+            continue;
+        }
+        if (0 == now_ns) {
+            now_ns = policer_now_ns();
+        }
+        policer_meter(&policer_db[policers[ii]], count, policers, policers[ii], now_ns, packets, colors);
+    }
+
+    for (ii = 0; ii < count; ii++) {
+        if ((STUB_NO_POLICER == policers[ii]) || !policer_db[policers[ii]].is_used) {
+            continue;
+        }
+        action = policer_db[policers[ii]].actions[colors[ii]];
+        if ((SAI_PACKET_ACTION_DROP == action) || (SAI_PACKET_ACTION_DENY == action)) {
+            dropped[ii] = true;
+        }
+    }
+
+    pthread_rwlock_unlock(&policer_db_lock);
+}
+
+/*
+ * Routine Description:
+ *    @brief Meter a burst of frames through a policer the way the data plane
+ *    does, taking tokens and counting the frames
+ *
+ * Arguments:
+ *    @param[in] policer_id - policer
+ *    @param[in] count - number of frames
+ *    @param[in] packets - frames
+ *    @param[out] colors - color of each frame [sai_packet_color_t]
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_policer_meter(_In_ sai_object_id_t      policer_id,
+                                _In_ uint32_t             count,
+                                _In_ const stub_packet_t *packets,
+                                _Out_ sai_packet_color_t *colors)
+{
+    sai_status_t status;
+    uint32_t     policer;
+
+    if ((NULL == packets) || (NULL == colors)) {
+        STUB_LOG_ERR("NULL packets or colors param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    pthread_rwlock_rdlock(&policer_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = policer_db_index(policer_id, &policer))) {
+        pthread_rwlock_unlock(&policer_db_lock);
+        return status;
+    }
+
+    policer_meter(&policer_db[policer], count, NULL, policer, policer_now_ns(), packets, colors);
+
+    pthread_rwlock_unlock(&policer_db_lock);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Rates and bursts fit the bucket arithmetic */
+static sai_status_t policer_check_rate(_In_ const char *name, _In_ uint64_t value)
+{
+    if (value > POLICER_MAX_RATE) {
+        STUB_LOG_ERR("Policer %s %" PRIu64 " above %llu\n", name, value, POLICER_MAX_RATE);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t policer_check_action(_In_ sai_int32_t action)
+{
+    if ((action < SAI_PACKET_ACTION_DROP) || (action > SAI_PACKET_ACTION_TRANSIT)) {
+        STUB_LOG_ERR("Invalid policer packet action %d\n", action);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t policer_check_counters(_In_ const sai_s32_list_t *list)
+{
+    uint32_t ii;
+
+    if (list->count > POLICER_STAT_COUNT) {
+        STUB_LOG_ERR("Policer counter list of %u, at most %u\n", list->count, POLICER_STAT_COUNT);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    for (ii = 0; ii < list->count; ii++) {
+        if ((list->list[ii] < SAI_POLICER_STAT_PACKETS) || (list->list[ii] > SAI_POLICER_STAT_RED_BYTES)) {
+            STUB_LOG_ERR("Invalid policer counter %d\n", list->list[ii]);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Create policer
+ *
+ * Arguments:
+ *    [out] policer_id - policer id
+ *    [in] attr_count - number of attributes
+ *    [in] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_create_policer(_Out_ sai_object_id_t     *policer_id,
+                                 _In_ uint32_t               attr_count,
+                                 _In_ const sai_attribute_t *attr_list)
+{
+    const sai_attribute_value_t *value;
+    uint32_t                     index, ii, policer;
+    policer_t                    entry;
+    sai_status_t                 status;
+    char                         list_str[MAX_LIST_VALUE_STR_LEN];
+    char                         key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    if (NULL == policer_id) {
+        STUB_LOG_ERR("NULL policer id param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS !=
+        (status =
+             check_attribs_metadata(attr_count, attr_list, policer_attribs, policer_vendor_attribs,
+                                    SAI_OPERATION_CREATE))) {
+        STUB_LOG_ERR("Failed attribs check\n");
+        return status;
+    }
+
+    sai_attr_list_to_str(attr_count, attr_list, policer_attribs, MAX_LIST_VALUE_STR_LEN, list_str);
+    STUB_LOG_NTC("Create policer, %s\n", list_str);
+
+    memset(&entry, 0, sizeof(entry));
+    entry.color_source = SAI_POLICER_COLOR_SOURCE_AWARE;
+    for (ii = 0; ii < POLICER_COLORS; ii++) {
+        entry.actions[ii] = SAI_PACKET_ACTION_FORWARD;
+    }
+
+    assert(SAI_STATUS_SUCCESS ==
+           find_attrib_in_list(attr_count, attr_list, SAI_POLICER_ATTR_METER_TYPE, &value, &index));
+    if ((SAI_METER_TYPE_PACKETS != value->s32) && (SAI_METER_TYPE_BYTES != value->s32)) {
+        STUB_LOG_ERR("Invalid policer meter type %d\n", value->s32);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + index;
+    }
+    entry.meter_type = value->s32;
+
+    assert(SAI_STATUS_SUCCESS ==
+           find_attrib_in_list(attr_count, attr_list, SAI_POLICER_ATTR_MODE, &value, &index));
+    if ((value->s32 < SAI_POLICER_MODE_Sr_TCM) || (value->s32 > SAI_POLICER_MODE_STORM_CONTROL)) {
+        STUB_LOG_ERR("Invalid policer mode %d\n", value->s32);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + index;
+    }
+    entry.mode = value->s32;
+
+    if (SAI_STATUS_SUCCESS ==
+        find_attrib_in_list(attr_count, attr_list, SAI_POLICER_ATTR_COLOR_SOURCE, &value, &index)) {
+        if ((SAI_POLICER_COLOR_SOURCE_BLIND != value->s32) && (SAI_POLICER_COLOR_SOURCE_AWARE != value->s32)) {
+            STUB_LOG_ERR("Invalid policer color source %d\n", value->s32);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + index;
+        }
+        entry.color_source = value->s32;
+    }
+
+    if (SAI_STATUS_SUCCESS == find_attrib_in_list(attr_count, attr_list, SAI_POLICER_ATTR_CBS, &value, &index)) {
+        if (SAI_STATUS_SUCCESS != policer_check_rate("CBS", value->u64)) {
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + index;
+        }
+        entry.cbs = value->u64;
+    }
+
+    if (SAI_STATUS_SUCCESS == find_attrib_in_list(attr_count, attr_list, SAI_POLICER_ATTR_CIR, &value, &index)) {
+        if (SAI_STATUS_SUCCESS != policer_check_rate("CIR", value->u64)) {
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + index;
+        }
+        entry.cir = value->u64;
+    }
+
+    if (SAI_STATUS_SUCCESS == find_attrib_in_list(attr_count, attr_list, SAI_POLICER_ATTR_PBS, &value, &index)) {
+        if (SAI_STATUS_SUCCESS != policer_check_rate("PBS", value->u64)) {
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + index;
+        }
+        entry.pbs = value->u64;
+    }
+
+    if (SAI_STATUS_SUCCESS == find_attrib_in_list(attr_count, attr_list, SAI_POLICER_ATTR_PIR, &value, &index)) {
+        if (SAI_STATUS_SUCCESS != policer_check_rate("PIR", value->u64)) {
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + index;
+        }
+        entry.pir = value->u64;
+    } else if (SAI_POLICER_MODE_Tr_TCM == entry.mode) {
+        STUB_LOG_ERR("Missing mandatory PIR for a two rate policer\n");
+        return SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING;
+    }
+
+    for (ii = 0; ii < POLICER_COLORS; ii++) {
+        if (SAI_STATUS_SUCCESS ==
+            find_attrib_in_list(attr_count, attr_list, SAI_POLICER_ATTR_GREEN_PACKET_ACTION + ii, &value,
+                                &index)) {
+            if (SAI_STATUS_SUCCESS != policer_check_action(value->s32)) {
+                return SAI_STATUS_INVALID_ATTR_VALUE_0 + index;
+            }
+            entry.actions[ii] = value->s32;
+        }
+    }
+
+    if (SAI_STATUS_SUCCESS ==
+        find_attrib_in_list(attr_count, attr_list, SAI_POLICER_ATTR_ENABLE_COUNTER_LIST, &value, &index)) {
+        if (SAI_STATUS_SUCCESS != policer_check_counters(&value->s32list)) {
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + index;
+        }
+        memcpy(entry.counters, value->s32list.list, value->s32list.count * sizeof(entry.counters[0]));
+        entry.counter_count = value->s32list.count;
+    }
+
+    pthread_rwlock_wrlock(&policer_db_lock);
+
+    for (policer = 0; policer < MAX_POLICERS; policer++) {
+        if (!policer_db[policer].is_used) {
+            break;
+        }
+    }
+
+    if (MAX_POLICERS == policer) {
+        pthread_rwlock_unlock(&policer_db_lock);
+        STUB_LOG_ERR("Policer table full\n");
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    /* Keep the bucket lock, the data plane never sees an unused policer */
+    policer_db[policer].is_used       = true;
+    policer_db[policer].meter_type    = entry.meter_type;
+    policer_db[policer].mode          = entry.mode;
+    policer_db[policer].color_source  = entry.color_source;
+    policer_db[policer].cbs           = entry.cbs;
+    policer_db[policer].cir           = entry.cir;
+    policer_db[policer].pbs           = entry.pbs;
+    policer_db[policer].pir           = entry.pir;
+    policer_db[policer].counter_count = entry.counter_count;
+    policer_db[policer].ref_count     = 0;
+    memcpy(policer_db[policer].actions, entry.actions, sizeof(entry.actions));
+    memcpy(policer_db[policer].counters, entry.counters, sizeof(entry.counters));
+    memset(policer_db[policer].packets, 0, sizeof(policer_db[policer].packets));
+    memset(policer_db[policer].bytes, 0, sizeof(policer_db[policer].bytes));
+    policer_bucket_reset(&policer_db[policer]);
+
+    pthread_rwlock_unlock(&policer_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_POLICER, policer, policer_id))) {
+        return status;
+    }
+    policer_key_to_str(*policer_id, key_str);
+    STUB_LOG_NTC("Created %s\n", key_str);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Remove policer
+ *
+ * Arguments:
+ *    [in] policer_id - policer id
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_remove_policer(_In_ sai_object_id_t policer_id)
+{
+    char         key_str[MAX_KEY_STR_LEN];
+    sai_status_t status;
+    uint32_t     policer;
+
+    STUB_LOG_ENTER();
+
+    policer_key_to_str(policer_id, key_str);
+    STUB_LOG_NTC("Remove %s\n", key_str);
+
+    pthread_rwlock_wrlock(&policer_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = policer_db_index(policer_id, &policer))) {
+        pthread_rwlock_unlock(&policer_db_lock);
+        return status;
+    }
+
+    if (0 != policer_db[policer].ref_count) {
+        pthread_rwlock_unlock(&policer_db_lock);
+        STUB_LOG_ERR("Policer %u has %u users\n", policer, policer_db[policer].ref_count);
+        return SAI_STATUS_OBJECT_IN_USE;
+    }
+
+    policer_db[policer].is_used = false;
+
+    pthread_rwlock_unlock(&policer_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Set policer attribute
+ *
+ * Arguments:
+ *    [in] policer_id - policer id
+ *    [in] attr - attribute
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_set_policer_attribute(_In_ sai_object_id_t policer_id, _In_ const sai_attribute_t *attr)
+{
+    const sai_object_key_t key = { .object_id = policer_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    policer_key_to_str(policer_id, key_str);
+    return sai_set_attribute(&key, key_str, policer_attribs, policer_vendor_attribs, attr);
+}
+
+/*
+ * Routine Description:
+ *    Get policer attribute
+ *
+ * Arguments:
+ *    [in] policer_id - policer id
+ *    [in] attr_count - number of attributes
+ *    [inout] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_policer_attribute(_In_ sai_object_id_t     policer_id,
+                                        _In_ uint32_t            attr_count,
+                                        _Inout_ sai_attribute_t *attr_list)
+{
+    const sai_object_key_t key = { .object_id = policer_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
+
+    STUB_LOG_ENTER();
+
+    policer_key_to_str(policer_id, key_str);
+
+    pthread_rwlock_rdlock(&policer_db_lock);
+    status = sai_get_attributes(&key, key_str, policer_attribs, policer_vendor_attribs, attr_count, attr_list);
+    pthread_rwlock_unlock(&policer_db_lock);
+
+    return status;
+}
+
+/* Meter type [sai_meter_type_t], mode [sai_policer_mode_t], color source
+ * [sai_policer_color_source_t], CBS, CIR, PBS, PIR [uint64_t], color actions
+ * [sai_packet_action_t], counters [sai_s32_list_t] */
+sai_status_t stub_policer_attr_get(_In_ const sai_object_key_t   *key,
+                                   _Inout_ sai_attribute_value_t *value,
+                                   _In_ uint32_t                  attr_index,
+                                   _Inout_ vendor_cache_t        *cache,
+                                   void                          *arg)
+{
+    const policer_t *entry;
+    sai_status_t     status;
+    uint32_t         policer;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = policer_db_index(key->object_id, &policer))) {
+        return status;
+    }
+
+    entry = &policer_db[policer];
+
+    switch ((long)arg) {
+    case SAI_POLICER_ATTR_METER_TYPE:
+        value->s32 = entry->meter_type;
+        break;
+
+    case SAI_POLICER_ATTR_MODE:
+        value->s32 = entry->mode;
+        break;
+
+    case SAI_POLICER_ATTR_COLOR_SOURCE:
+        value->s32 = entry->color_source;
+        break;
+
+    case SAI_POLICER_ATTR_CBS:
+        value->u64 = entry->cbs;
+        break;
+
+    case SAI_POLICER_ATTR_CIR:
+        value->u64 = entry->cir;
+        break;
+
+    case SAI_POLICER_ATTR_PBS:
+        value->u64 = entry->pbs;
+        break;
+
+    case SAI_POLICER_ATTR_PIR:
+        value->u64 = entry->pir;
+        break;
+
+    case SAI_POLICER_ATTR_GREEN_PACKET_ACTION:
+    case SAI_POLICER_ATTR_YELLOW_PACKET_ACTION:
+    case SAI_POLICER_ATTR_RED_PACKET_ACTION:
+        value->s32 = entry->actions[(long)arg - SAI_POLICER_ATTR_GREEN_PACKET_ACTION];
+        break;
+
+    case SAI_POLICER_ATTR_ENABLE_COUNTER_LIST:
+        status = stub_fill_s32list((int32_t*)entry->counters, entry->counter_count, &value->s32list);
+        break;
+    }
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* Color source [sai_policer_color_source_t], CBS, CIR, PBS, PIR [uint64_t],
+ * color actions [sai_packet_action_t], counters [sai_s32_list_t] */
+sai_status_t stub_policer_attr_set(_In_ const sai_object_key_t      *key,
+                                   _In_ const sai_attribute_value_t *value,
+                                   void                             *arg)
+{
+    policer_t   *entry;
+    sai_status_t status;
+    uint32_t     policer;
+
+    STUB_LOG_ENTER();
+
+    pthread_rwlock_wrlock(&policer_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = policer_db_index(key->object_id, &policer))) {
+        pthread_rwlock_unlock(&policer_db_lock);
+        return status;
+    }
+
+    entry = &policer_db[policer];
+
+    switch ((long)arg) {
+    case SAI_POLICER_ATTR_COLOR_SOURCE:
+        if ((SAI_POLICER_COLOR_SOURCE_BLIND != value->s32) && (SAI_POLICER_COLOR_SOURCE_AWARE != value->s32)) {
+            STUB_LOG_ERR("Invalid policer color source %d\n", value->s32);
+            status = SAI_STATUS_INVALID_ATTR_VALUE_0;
+            break;
+        }
+        entry->color_source = value->s32;
+        break;
+
+    case SAI_POLICER_ATTR_CBS:
+    case SAI_POLICER_ATTR_CIR:
+    case SAI_POLICER_ATTR_PBS:
+    case SAI_POLICER_ATTR_PIR:
+        if (SAI_STATUS_SUCCESS != (status = policer_check_rate("rate or burst", value->u64))) {
+            break;
+        }
+        if (SAI_POLICER_ATTR_CBS == (long)arg) {
+            entry->cbs = value->u64;
+        } else if (SAI_POLICER_ATTR_CIR == (long)arg) {
+            entry->cir = value->u64;
+        } else if (SAI_POLICER_ATTR_PBS == (long)arg) {
+            entry->pbs = value->u64;
+        } else {
+            entry->pir = value->u64;
+        }
+        policer_bucket_reset(entry);
+        break;
+
+    case SAI_POLICER_ATTR_GREEN_PACKET_ACTION:
+    case SAI_POLICER_ATTR_YELLOW_PACKET_ACTION:
+    case SAI_POLICER_ATTR_RED_PACKET_ACTION:
+        if (SAI_STATUS_SUCCESS != (status = policer_check_action(value->s32))) {
+            break;
+        }
+        entry->actions[(long)arg - SAI_POLICER_ATTR_GREEN_PACKET_ACTION] = value->s32;
+        break;
+
+    case SAI_POLICER_ATTR_ENABLE_COUNTER_LIST:
+        if (SAI_STATUS_SUCCESS != (status = policer_check_counters(&value->s32list))) {
+            break;
+        }
+        memcpy(entry->counters, value->s32list.list, value->s32list.count * sizeof(entry->counters[0]));
+        entry->counter_count = value->s32list.count;
+        break;
+    }
+
+    pthread_rwlock_unlock(&policer_db_lock);
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/*
+ * Routine Description:
+ *    Get policer statistics counters.
+ *
+ * Arguments:
+ *    [in] policer_id - policer id
+ *    [in] counter_ids - specifies the array of counter ids
+ *    [in] number_of_counters - number of counters in the array
+ *    [out] counters - array of resulting counter values.
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_policer_stats(_In_ sai_object_id_t                   policer_id,
+                                    _In_ const sai_policer_stat_counter_t *counter_ids,
+                                    _In_ uint32_t                          number_of_counters,
+                                    _Out_ uint64_t                        *counters)
+{
+    uint64_t     packets[POLICER_COLORS], bytes[POLICER_COLORS];
+    sai_status_t status;
+    uint32_t     policer, ii;
+    char         key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    policer_key_to_str(policer_id, key_str);
+    STUB_LOG_DBG("Get policer stats %s\n", key_str);
+
+    if (NULL == counter_ids) {
+        STUB_LOG_ERR("NULL counter ids array param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (NULL == counters) {
+        STUB_LOG_ERR("NULL counters array param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    for (ii = 0; ii < number_of_counters; ii++) {
+        if ((counter_ids[ii] < SAI_POLICER_STAT_PACKETS) || (counter_ids[ii] > SAI_POLICER_STAT_RED_BYTES)) {
+            STUB_LOG_ERR("Invalid policer counter %d\n", counter_ids[ii]);
+            return SAI_STATUS_INVALID_PARAMETER;
+        }
+    }
+
+    pthread_rwlock_rdlock(&policer_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = policer_db_index(policer_id, &policer))) {
+        pthread_rwlock_unlock(&policer_db_lock);
+        return status;
+    }
+
+    pthread_mutex_lock(&policer_db[policer].bucket_lock);
+    memcpy(packets, policer_db[policer].packets, sizeof(packets));
+    memcpy(bytes, policer_db[policer].bytes, sizeof(bytes));
+    pthread_mutex_unlock(&policer_db[policer].bucket_lock);
+
+    pthread_rwlock_unlock(&policer_db_lock);
+
+    for (ii = 0; ii < number_of_counters; ii++) {
+        switch ((long)counter_ids[ii]) {
+        case SAI_POLICER_STAT_PACKETS:
+            counters[ii] = packets[SAI_PACKET_COLOR_GREEN] + packets[SAI_PACKET_COLOR_YELLOW] +
+                           packets[SAI_PACKET_COLOR_RED];
+            break;
+
+        case SAI_POLICER_STAT_ATTR_BYTES:
+            counters[ii] = bytes[SAI_PACKET_COLOR_GREEN] + bytes[SAI_PACKET_COLOR_YELLOW] +
+                           bytes[SAI_PACKET_COLOR_RED];
+            break;
+
+        case SAI_POLICER_STAT_GREEN_PACKETS:
+            counters[ii] = packets[SAI_PACKET_COLOR_GREEN];
+            break;
+
+        case SAI_POLICER_STAT_GREEN_BYTES:
+            counters[ii] = bytes[SAI_PACKET_COLOR_GREEN];
+            break;
+
+        case SAI_POLICER_STAT_YELLOW_PACKETS:
+            counters[ii] = packets[SAI_PACKET_COLOR_YELLOW];
+            break;
+
+        case SAI_POLICER_STAT_YELLOW_BYTES:
+            counters[ii] = bytes[SAI_PACKET_COLOR_YELLOW];
+            break;
+
+        case SAI_POLICER_STAT_RED_PACKETS:
+            counters[ii] = packets[SAI_PACKET_COLOR_RED];
+            break;
+
+        case SAI_POLICER_STAT_RED_BYTES:
+            counters[ii] = bytes[SAI_PACKET_COLOR_RED];
+            break;
+        }
+    }
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+const sai_policer_api_t policer_api = {
+    stub_create_policer,
+    stub_remove_policer,
+    stub_set_policer_attribute,
+    stub_get_policer_attribute,
+    stub_get_policer_stats,
+};
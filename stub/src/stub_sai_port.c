@@ -17,20 +17,34 @@
 
 #include "sai.h"
 #include "stub_sai.h"
+#include "stub_sai_port.h"
+#include "stub_sai_dataplane.h"
 #include "assert.h"
+#include <sched.h>
 
 #undef  __MODULE__
 #define __MODULE__ SAI_PORT
 
+#define PORT_DEFAULT_VLAN 1
+
 sai_status_t stub_port_fdb_violation_set(_In_ const sai_object_key_t      *key,
                                          _In_ const sai_attribute_value_t *value,
                                          void                             *arg);
 sai_status_t stub_port_max_learned_addr_set(_In_ const sai_object_key_t      *key,
                                             _In_ const sai_attribute_value_t *value,
                                             void                             *arg);
-sai_status_t stub_port_storm_control_set(_In_ const sai_object_key_t      *key,
-                                         _In_ const sai_attribute_value_t *value,
-                                         void                             *arg);
+sai_status_t stub_port_policer_set(_In_ const sai_object_key_t      *key,
+                                   _In_ const sai_attribute_value_t *value,
+                                   void                             *arg);
+sai_status_t stub_port_qos_set(_In_ const sai_object_key_t      *key,
+                               _In_ const sai_attribute_value_t *value,
+                               void                             *arg);
+sai_status_t stub_port_scheduler_set(_In_ const sai_object_key_t      *key,
+                                     _In_ const sai_attribute_value_t *value,
+                                     void                             *arg);
+sai_status_t stub_port_mirror_set(_In_ const sai_object_key_t      *key,
+                                  _In_ const sai_attribute_value_t *value,
+                                  void                             *arg);
 sai_status_t stub_port_update_dscp_set(_In_ const sai_object_key_t      *key,
                                        _In_ const sai_attribute_value_t *value,
                                        void                             *arg);
@@ -92,11 +106,31 @@ sai_status_t stub_port_media_type_get(_In_ const sai_object_key_t   *key,
                                       _In_ uint32_t                  attr_index,
                                       _Inout_ vendor_cache_t        *cache,
                                       void                          *arg);
-sai_status_t stub_port_storm_control_get(_In_ const sai_object_key_t   *key,
-                                         _Inout_ sai_attribute_value_t *value,
-                                         _In_ uint32_t                  attr_index,
-                                         _Inout_ vendor_cache_t        *cache,
-                                         void                          *arg);
+sai_status_t stub_port_policer_get(_In_ const sai_object_key_t   *key,
+                                   _Inout_ sai_attribute_value_t *value,
+                                   _In_ uint32_t                  attr_index,
+                                   _Inout_ vendor_cache_t        *cache,
+                                   void                          *arg);
+sai_status_t stub_port_qos_get(_In_ const sai_object_key_t   *key,
+                               _Inout_ sai_attribute_value_t *value,
+                               _In_ uint32_t                  attr_index,
+                               _Inout_ vendor_cache_t        *cache,
+                               void                          *arg);
+sai_status_t stub_port_scheduler_get(_In_ const sai_object_key_t   *key,
+                                     _Inout_ sai_attribute_value_t *value,
+                                     _In_ uint32_t                  attr_index,
+                                     _Inout_ vendor_cache_t        *cache,
+                                     void                          *arg);
+sai_status_t stub_port_buffer_get(_In_ const sai_object_key_t   *key,
+                                  _Inout_ sai_attribute_value_t *value,
+                                  _In_ uint32_t                  attr_index,
+                                  _Inout_ vendor_cache_t        *cache,
+                                  void                          *arg);
+sai_status_t stub_port_mirror_get(_In_ const sai_object_key_t   *key,
+                                  _Inout_ sai_attribute_value_t *value,
+                                  _In_ uint32_t                  attr_index,
+                                  _Inout_ vendor_cache_t        *cache,
+                                  void                          *arg);
 sai_status_t stub_port_update_dscp_get(_In_ const sai_object_key_t   *key,
                                        _Inout_ sai_attribute_value_t *value,
                                        _In_ uint32_t                  attr_index,
@@ -201,11 +235,11 @@ static const sai_attribute_entry_t        port_attribs[] = {
     { SAI_PORT_ATTR_MTU, false, false, true, true,
       "Port mtu", SAI_ATTR_VAL_TYPE_U32 },
     { SAI_PORT_ATTR_FLOOD_STORM_CONTROL_POLICER_ID, false, false, true, true,
-      "Port flood storm control", SAI_ATTR_VAL_TYPE_BOOL },
+      "Port flood storm control", SAI_ATTR_VAL_TYPE_OID },
     { SAI_PORT_ATTR_BROADCAST_STORM_CONTROL_POLICER_ID, false, false, true, true,
-      "Port broadcast storm control", SAI_ATTR_VAL_TYPE_BOOL },
+      "Port broadcast storm control", SAI_ATTR_VAL_TYPE_OID },
     { SAI_PORT_ATTR_MULTICAST_STORM_CONTROL_POLICER_ID, false, false, true, true,
-      "Port multicast storm control", SAI_ATTR_VAL_TYPE_BOOL },
+      "Port multicast storm control", SAI_ATTR_VAL_TYPE_OID },
     { SAI_PORT_ATTR_GLOBAL_FLOW_CONTROL, false, false, true, true,
       "Port global flow control", SAI_ATTR_VAL_TYPE_S32 },
     { SAI_PORT_ATTR_MAX_LEARNED_ADDRESSES, false, false, true, true,
@@ -220,6 +254,44 @@ static const sai_attribute_entry_t        port_attribs[] = {
       "Port ingress samplepacket enable", SAI_ATTR_VAL_TYPE_OID },
     { SAI_PORT_ATTR_EGRESS_SAMPLEPACKET_ENABLE, false, false, true, true,
       "Port egress samplepacket enable", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_PORT_ATTR_POLICER_ID, false, false, true, true,
+      "Port policer", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_PORT_ATTR_QOS_DEFAULT_TC, false, false, true, true,
+      "Port default traffic class", SAI_ATTR_VAL_TYPE_U8 },
+    { SAI_PORT_ATTR_QOS_DOT1P_TO_TC_MAP, false, false, true, true,
+      "Port dot1p to TC map", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_PORT_ATTR_QOS_DOT1P_TO_COLOR_MAP, false, false, true, true,
+      "Port dot1p to color map", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_PORT_ATTR_QOS_DSCP_TO_TC_MAP, false, false, true, true,
+      "Port DSCP to TC map", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_PORT_ATTR_QOS_DSCP_TO_COLOR_MAP, false, false, true, true,
+      "Port DSCP to color map", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_PORT_ATTR_QOS_TC_TO_QUEUE_MAP, false, false, true, true,
+      "Port TC to queue map", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_PORT_ATTR_QOS_TC_AND_COLOR_TO_DOT1P_MAP, false, false, true, true,
+      "Port TC and color to dot1p map", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_PORT_ATTR_QOS_TC_AND_COLOR_TO_DSCP_MAP, false, false, true, true,
+      "Port TC and color to DSCP map", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_PORT_ATTR_QOS_TC_TO_PRIORITY_GROUP_MAP, false, false, true, true,
+      "Port TC to priority group map", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_PORT_ATTR_QOS_PFC_PRIORITY_TO_PRIORITY_GROUP_MAP, false, false, true, true,
+      "Port PFC priority to priority group map", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_PORT_ATTR_QOS_PFC_PRIORITY_TO_QUEUE_MAP, false, false, true, true,
+      "Port PFC priority to queue map", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_PORT_ATTR_QOS_NUMBER_OF_QUEUES, false, false, false, true,
+      "Port number of queues", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_PORT_ATTR_QOS_QUEUE_LIST, false, false, false, true,
+      "Port queue list", SAI_ATTR_VAL_TYPE_OBJLIST },
+    { SAI_PORT_ATTR_QOS_NUMBER_OF_SCHEDULER_GROUPS, false, false, false, true,
+      "Port number of scheduler groups", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_PORT_ATTR_QOS_SCHEDULER_GROUP_LIST, false, false, false, true,
+      "Port scheduler group list", SAI_ATTR_VAL_TYPE_OBJLIST },
+    { SAI_PORT_ATTR_QOS_SCHEDULER_PROFILE_ID, false, false, true, true,
+      "Port scheduler", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_PORT_ATTR_NUMBER_OF_PRIORITY_GROUPS, false, false, false, true,
+      "Port number of priority groups", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_PORT_ATTR_PRIORITY_GROUP_LIST, false, false, false, true,
+      "Port priority group list", SAI_ATTR_VAL_TYPE_OBJLIST },
     { END_FUNCTIONALITY_ATTRIBS_ID, false, false, false, false,
       "", SAI_ATTR_VAL_TYPE_UNDETERMINED }
 };
@@ -317,18 +389,18 @@ static const sai_vendor_attribute_entry_t port_vendor_attribs[] = {
     { SAI_PORT_ATTR_FLOOD_STORM_CONTROL_POLICER_ID,
       { false, false, true, true },
       { false, false, true, true },
-      stub_port_storm_control_get, (void*)SAI_PORT_ATTR_FLOOD_STORM_CONTROL_POLICER_ID,
-      stub_port_storm_control_set, (void*)SAI_PORT_ATTR_FLOOD_STORM_CONTROL_POLICER_ID },
+      stub_port_policer_get, (void*)SAI_PORT_ATTR_FLOOD_STORM_CONTROL_POLICER_ID,
+      stub_port_policer_set, (void*)SAI_PORT_ATTR_FLOOD_STORM_CONTROL_POLICER_ID },
     { SAI_PORT_ATTR_BROADCAST_STORM_CONTROL_POLICER_ID,
       { false, false, true, true },
       { false, false, true, true },
-      stub_port_storm_control_get, (void*)SAI_PORT_ATTR_BROADCAST_STORM_CONTROL_POLICER_ID,
-      stub_port_storm_control_set, (void*)SAI_PORT_ATTR_BROADCAST_STORM_CONTROL_POLICER_ID },
+      stub_port_policer_get, (void*)SAI_PORT_ATTR_BROADCAST_STORM_CONTROL_POLICER_ID,
+      stub_port_policer_set, (void*)SAI_PORT_ATTR_BROADCAST_STORM_CONTROL_POLICER_ID },
     { SAI_PORT_ATTR_MULTICAST_STORM_CONTROL_POLICER_ID,
       { false, false, true, true },
       { false, false, true, true },
-      stub_port_storm_control_get, (void*)SAI_PORT_ATTR_MULTICAST_STORM_CONTROL_POLICER_ID,
-      stub_port_storm_control_set, (void*)SAI_PORT_ATTR_MULTICAST_STORM_CONTROL_POLICER_ID },
+      stub_port_policer_get, (void*)SAI_PORT_ATTR_MULTICAST_STORM_CONTROL_POLICER_ID,
+      stub_port_policer_set, (void*)SAI_PORT_ATTR_MULTICAST_STORM_CONTROL_POLICER_ID },
     { SAI_PORT_ATTR_GLOBAL_FLOW_CONTROL,
       { false, false, false, false },
       { false, false, true, true },
@@ -345,15 +417,15 @@ static const sai_vendor_attribute_entry_t port_vendor_attribs[] = {
       stub_port_fdb_violation_get, NULL,
       stub_port_fdb_violation_set, NULL },
     { SAI_PORT_ATTR_INGRESS_MIRROR_SESSION,
-      { false, false, false, false },
       { false, false, true, true },
-      NULL, NULL,
-      NULL, NULL },
+      { false, false, true, true },
+      stub_port_mirror_get, (void*)SAI_PORT_ATTR_INGRESS_MIRROR_SESSION,
+      stub_port_mirror_set, (void*)SAI_PORT_ATTR_INGRESS_MIRROR_SESSION },
     { SAI_PORT_ATTR_EGRESS_MIRROR_SESSION,
-      { false, false, false, false },
       { false, false, true, true },
-      NULL, NULL,
-      NULL, NULL },
+      { false, false, true, true },
+      stub_port_mirror_get, (void*)SAI_PORT_ATTR_EGRESS_MIRROR_SESSION,
+      stub_port_mirror_set, (void*)SAI_PORT_ATTR_EGRESS_MIRROR_SESSION },
     { SAI_PORT_ATTR_INGRESS_SAMPLEPACKET_ENABLE,
       { false, false, false, false },
       { false, false, true, true },
@@ -363,9 +435,243 @@ static const sai_vendor_attribute_entry_t port_vendor_attribs[] = {
       { false, false, false, false },
       { false, false, true, true },
       NULL, NULL,
+      NULL, NULL },
+    { SAI_PORT_ATTR_POLICER_ID,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_port_policer_get, (void*)SAI_PORT_ATTR_POLICER_ID,
+      stub_port_policer_set, (void*)SAI_PORT_ATTR_POLICER_ID },
+    { SAI_PORT_ATTR_QOS_DEFAULT_TC,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_port_qos_get, (void*)SAI_PORT_ATTR_QOS_DEFAULT_TC,
+      stub_port_qos_set, (void*)SAI_PORT_ATTR_QOS_DEFAULT_TC },
+    { SAI_PORT_ATTR_QOS_DOT1P_TO_TC_MAP,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_port_qos_get, (void*)SAI_PORT_ATTR_QOS_DOT1P_TO_TC_MAP,
+      stub_port_qos_set, (void*)SAI_PORT_ATTR_QOS_DOT1P_TO_TC_MAP },
+    { SAI_PORT_ATTR_QOS_DOT1P_TO_COLOR_MAP,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_port_qos_get, (void*)SAI_PORT_ATTR_QOS_DOT1P_TO_COLOR_MAP,
+      stub_port_qos_set, (void*)SAI_PORT_ATTR_QOS_DOT1P_TO_COLOR_MAP },
+    { SAI_PORT_ATTR_QOS_DSCP_TO_TC_MAP,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_port_qos_get, (void*)SAI_PORT_ATTR_QOS_DSCP_TO_TC_MAP,
+      stub_port_qos_set, (void*)SAI_PORT_ATTR_QOS_DSCP_TO_TC_MAP },
+    { SAI_PORT_ATTR_QOS_DSCP_TO_COLOR_MAP,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_port_qos_get, (void*)SAI_PORT_ATTR_QOS_DSCP_TO_COLOR_MAP,
+      stub_port_qos_set, (void*)SAI_PORT_ATTR_QOS_DSCP_TO_COLOR_MAP },
+    { SAI_PORT_ATTR_QOS_TC_TO_QUEUE_MAP,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_port_qos_get, (void*)SAI_PORT_ATTR_QOS_TC_TO_QUEUE_MAP,
+      stub_port_qos_set, (void*)SAI_PORT_ATTR_QOS_TC_TO_QUEUE_MAP },
+    { SAI_PORT_ATTR_QOS_TC_AND_COLOR_TO_DOT1P_MAP,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_port_qos_get, (void*)SAI_PORT_ATTR_QOS_TC_AND_COLOR_TO_DOT1P_MAP,
+      stub_port_qos_set, (void*)SAI_PORT_ATTR_QOS_TC_AND_COLOR_TO_DOT1P_MAP },
+    { SAI_PORT_ATTR_QOS_TC_AND_COLOR_TO_DSCP_MAP,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_port_qos_get, (void*)SAI_PORT_ATTR_QOS_TC_AND_COLOR_TO_DSCP_MAP,
+      stub_port_qos_set, (void*)SAI_PORT_ATTR_QOS_TC_AND_COLOR_TO_DSCP_MAP },
+    { SAI_PORT_ATTR_QOS_TC_TO_PRIORITY_GROUP_MAP,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_port_qos_get, (void*)SAI_PORT_ATTR_QOS_TC_TO_PRIORITY_GROUP_MAP,
+      stub_port_qos_set, (void*)SAI_PORT_ATTR_QOS_TC_TO_PRIORITY_GROUP_MAP },
+    { SAI_PORT_ATTR_QOS_PFC_PRIORITY_TO_PRIORITY_GROUP_MAP,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_port_qos_get, (void*)SAI_PORT_ATTR_QOS_PFC_PRIORITY_TO_PRIORITY_GROUP_MAP,
+      stub_port_qos_set, (void*)SAI_PORT_ATTR_QOS_PFC_PRIORITY_TO_PRIORITY_GROUP_MAP },
+    { SAI_PORT_ATTR_QOS_PFC_PRIORITY_TO_QUEUE_MAP,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_port_qos_get, (void*)SAI_PORT_ATTR_QOS_PFC_PRIORITY_TO_QUEUE_MAP,
+      stub_port_qos_set, (void*)SAI_PORT_ATTR_QOS_PFC_PRIORITY_TO_QUEUE_MAP },
+    { SAI_PORT_ATTR_QOS_NUMBER_OF_QUEUES,
+      { false, false, false, true },
+      { false, false, false, true },
+      stub_port_scheduler_get, (void*)SAI_PORT_ATTR_QOS_NUMBER_OF_QUEUES,
+      NULL, NULL },
+    { SAI_PORT_ATTR_QOS_QUEUE_LIST,
+      { false, false, false, true },
+      { false, false, false, true },
+      stub_port_scheduler_get, (void*)SAI_PORT_ATTR_QOS_QUEUE_LIST,
+      NULL, NULL },
+    { SAI_PORT_ATTR_QOS_NUMBER_OF_SCHEDULER_GROUPS,
+      { false, false, false, true },
+      { false, false, false, true },
+      stub_port_scheduler_get, (void*)SAI_PORT_ATTR_QOS_NUMBER_OF_SCHEDULER_GROUPS,
+      NULL, NULL },
+    { SAI_PORT_ATTR_QOS_SCHEDULER_GROUP_LIST,
+      { false, false, false, true },
+      { false, false, false, true },
+      stub_port_scheduler_get, (void*)SAI_PORT_ATTR_QOS_SCHEDULER_GROUP_LIST,
+      NULL, NULL },
+    { SAI_PORT_ATTR_QOS_SCHEDULER_PROFILE_ID,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_port_scheduler_get, (void*)SAI_PORT_ATTR_QOS_SCHEDULER_PROFILE_ID,
+      stub_port_scheduler_set, NULL },
+    { SAI_PORT_ATTR_NUMBER_OF_PRIORITY_GROUPS,
+      { false, false, false, true },
+      { false, false, false, true },
+      stub_port_buffer_get, (void*)SAI_PORT_ATTR_NUMBER_OF_PRIORITY_GROUPS,
+      NULL, NULL },
+    { SAI_PORT_ATTR_PRIORITY_GROUP_LIST,
+      { false, false, false, true },
+      { false, false, false, true },
+      stub_port_buffer_get, (void*)SAI_PORT_ATTR_PRIORITY_GROUP_LIST,
       NULL, NULL }
 };
 
+/* Port policers *************/
+enum {
+    PORT_POLICER_INGRESS,
+    PORT_POLICER_FLOOD,
+    PORT_POLICER_BROADCAST,
+    PORT_POLICER_MULTICAST,
+    PORT_POLICER_COUNT
+};
+
+/* Policer indexes per port, STUB_NO_POLICER when none is set */
+static uint32_t         port_policers[PORT_NUMBER][PORT_POLICER_COUNT] = {
+    [0 ... PORT_NUMBER - 1] = { [0 ... PORT_POLICER_COUNT - 1] = STUB_NO_POLICER }
+};
+/* Setters take the table exclusively, the data plane shares it per burst */
+static pthread_rwlock_t port_policer_lock = STUB_RWLOCK_INITIALIZER;
+
+static inline uint32_t port_policer_slot(_In_ long attr)
+{
+    switch (attr) {
+    case SAI_PORT_ATTR_FLOOD_STORM_CONTROL_POLICER_ID:
+        return PORT_POLICER_FLOOD;
+
+    case SAI_PORT_ATTR_BROADCAST_STORM_CONTROL_POLICER_ID:
+        return PORT_POLICER_BROADCAST;
+
+    case SAI_PORT_ATTR_MULTICAST_STORM_CONTROL_POLICER_ID:
+        return PORT_POLICER_MULTICAST;
+
+    default:
+        return PORT_POLICER_INGRESS;
+    }
+}
+
+/* Port index of a frame's ingress port, false for frames of other objects */
+static inline bool port_policer_index(_In_ sai_object_id_t port_id, _Out_ uint32_t *port)
+{
+    return (SAI_STATUS_SUCCESS == stub_object_to_type(port_id, SAI_OBJECT_TYPE_PORT, port)) &&
+           (*port < PORT_NUMBER);
+}
+
+/*
+ * Routine Description:
+ *    Meter the frames of a chunk through the policers of their ingress
+ *    ports. Frames the policers drop are no longer pending
+ *
+ * Arguments:
+ *    [in] count - number of frames, at most STUB_DATAPLANE_BURST
+ *    [inout] packets - frames
+ *    [inout] pending - frames still in the pipeline
+ */
+void db_apply_port_policers(_In_ uint32_t count, _Inout_ struct _stub_packet_t *packets, _Inout_ bool *pending)
+{
+    uint32_t policers[STUB_DATAPLANE_BURST];
+    bool     dropped[STUB_DATAPLANE_BURST];
+    uint32_t ii, port, policed = 0;
+
+    assert(count <= STUB_DATAPLANE_BURST);
+
+    pthread_rwlock_rdlock(&port_policer_lock);
+
+    for (ii = 0; ii < count; ii++) {
+        policers[ii] = STUB_NO_POLICER;
+        dropped[ii]  = false;
+        if (pending[ii] && port_policer_index(packets[ii].in_port, &port)) {
+            policers[ii] = port_policers[port][PORT_POLICER_INGRESS];
+            policed     += (STUB_NO_POLICER != policers[ii]);
+        }
+    }
+
+    if (0 != policed) {
+        db_apply_policers(count, policers, packets, dropped);
+    }
+
+    pthread_rwlock_unlock(&port_policer_lock);
+
+    for (ii = 0; ii < count; ii++) {
+        if (dropped[ii]) {
+            packets[ii].packet_action = SAI_PACKET_ACTION_DROP;
+            pending[ii]               = false;
+        }
+    }
+}
+
+/*
+ * Routine Description:
+ *    Meter the flooded frames of a chunk through the storm control policers
+ *    of their ingress ports: broadcast frames through the broadcast one,
+ *    other multicast frames through the multicast one, unknown unicast
+ *    through the flood one. Frames the policers drop are dropped
+ *
+ * Arguments:
+ *    [in] count - number of frames, at most STUB_DATAPLANE_BURST
+ *    [inout] packets - frames
+ */
+void db_apply_storm_control(_In_ uint32_t count, _Inout_ struct _stub_packet_t *packets)
+{
+    uint32_t             policers[STUB_DATAPLANE_BURST];
+    bool                 dropped[STUB_DATAPLANE_BURST];
+    const stub_packet_t *packet;
+    const uint8_t       *data;
+    uint32_t             ii, port, slot, policed = 0;
+
+    assert(count <= STUB_DATAPLANE_BURST);
+
+    pthread_rwlock_rdlock(&port_policer_lock);
+
+    for (ii = 0; ii < count; ii++) {
+        packet       = &packets[ii];
+        policers[ii] = STUB_NO_POLICER;
+        dropped[ii]  = false;
+        if ((SAI_PACKET_ACTION_FORWARD != packet->packet_action) || (SAI_NULL_OBJECT_ID != packet->out_port) ||
+            !port_policer_index(packet->in_port, &port)) {
+            continue;
+        }
+        data = packet->data;
+        if (0xFF == (data[0] & data[1] & data[2] & data[3] & data[4] & data[5])) {
+            slot = PORT_POLICER_BROADCAST;
+        } else if (data[0] & 0x01) {
+            slot = PORT_POLICER_MULTICAST;
+        } else {
+            slot = PORT_POLICER_FLOOD;
+        }
+        policers[ii] = port_policers[port][slot];
+        policed     += (STUB_NO_POLICER != policers[ii]);
+    }
+
+    if (0 != policed) {
+        db_apply_policers(count, policers, packets, dropped);
+    }
+
+    pthread_rwlock_unlock(&port_policer_lock);
+
+    for (ii = 0; ii < count; ii++) {
+        if (dropped[ii]) {
+            packets[ii].packet_action = SAI_PACKET_ACTION_DROP;
+        }
+    }
+}
+
 /* Admin Mode [bool] */
 sai_status_t stub_port_state_set(_In_ const sai_object_key_t *key, _In_ const sai_attribute_value_t *value, void *arg)
 {
@@ -400,13 +706,14 @@ sai_status_t stub_port_update_dscp_set(_In_ const sai_object_key_t      *key,
     return SAI_STATUS_SUCCESS;
 }
 
-/* [bool] (default to FALSE) */
-sai_status_t stub_port_storm_control_set(_In_ const sai_object_key_t      *key,
-                                         _In_ const sai_attribute_value_t *value,
-                                         void                             *arg)
+/* Storm control and port policers [sai_object_id_t], SAI_NULL_OBJECT_ID
+ * for none (default) */
+sai_status_t stub_port_policer_set(_In_ const sai_object_key_t      *key,
+                                   _In_ const sai_attribute_value_t *value,
+                                   void                             *arg)
 {
     sai_status_t status;
-    uint32_t     port_id;
+    uint32_t     port_id, policer = STUB_NO_POLICER, old, slot = port_policer_slot((long)arg);
 
     STUB_LOG_ENTER();
 
@@ -414,10 +721,105 @@ sai_status_t stub_port_storm_control_set(_In_ const sai_object_key_t      *key,
         return status;
     }
 
+    if (port_id >= PORT_NUMBER) {
+        STUB_LOG_ERR("Invalid port index %u\n", port_id);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    if ((SAI_NULL_OBJECT_ID != value->oid) &&
+        (SAI_STATUS_SUCCESS != (status = db_policer_bind(value->oid, &policer)))) {
+        return status;
+    }
+
+    pthread_rwlock_wrlock(&port_policer_lock);
+    old                          = port_policers[port_id][slot];
+    port_policers[port_id][slot] = policer;
+    pthread_rwlock_unlock(&port_policer_lock);
+
+    db_policer_unbind(old);
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
 
+/* Default traffic class [sai_uint8_t], 0 (default), and QoS maps
+ * [sai_object_id_t], SAI_NULL_OBJECT_ID for none (default) */
+sai_status_t stub_port_qos_set(_In_ const sai_object_key_t      *key,
+                               _In_ const sai_attribute_value_t *value,
+                               void                             *arg)
+{
+    sai_status_t status;
+    uint32_t     port_id;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(key->object_id, SAI_OBJECT_TYPE_PORT, &port_id))) {
+        return status;
+    }
+
+    if (port_id >= PORT_NUMBER) {
+        STUB_LOG_ERR("Invalid port index %u\n", port_id);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    status = db_set_port_qos(port_id, (long)arg, value);
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* Ingress and egress mirror sessions [sai_object_list_t], empty for none
+ * (default) */
+sai_status_t stub_port_mirror_set(_In_ const sai_object_key_t      *key,
+                                  _In_ const sai_attribute_value_t *value,
+                                  void                             *arg)
+{
+    sai_status_t status;
+    uint32_t     port_id;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(key->object_id, SAI_OBJECT_TYPE_PORT, &port_id))) {
+        return status;
+    }
+
+    if (port_id >= PORT_NUMBER) {
+        STUB_LOG_ERR("Invalid port index %u\n", port_id);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    status = db_set_port_mirror(port_id, SAI_PORT_ATTR_INGRESS_MIRROR_SESSION == (long)arg, &value->objlist);
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* Scheduler [sai_object_id_t], shapes the port by its maximum rate,
+ * SAI_NULL_OBJECT_ID for none (default) */
+sai_status_t stub_port_scheduler_set(_In_ const sai_object_key_t      *key,
+                                     _In_ const sai_attribute_value_t *value,
+                                     void                             *arg)
+{
+    sai_status_t status;
+    uint32_t     port_id;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(key->object_id, SAI_OBJECT_TYPE_PORT, &port_id))) {
+        return status;
+    }
+
+    if (port_id >= PORT_NUMBER) {
+        STUB_LOG_ERR("Invalid port index %u\n", port_id);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    status = db_set_port_scheduler(port_id, value);
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
 /* Action for packets with unknown source mac address
  * when FDB learning limit is reached.
  * [sai_packet_action_t] (default to SAI_PACKET_ACTION_DROP) */
@@ -474,6 +876,49 @@ sai_status_t stub_port_media_type_set(_In_ const sai_object_key_t      *key,
     return SAI_STATUS_SUCCESS;
 }
 
+/* Port VLAN of untagged ingress frames by port index, read by the data
+ * plane without a lock */
+static sai_vlan_id_t port_default_vlans[PORT_NUMBER] = { [0 ... PORT_NUMBER - 1] = PORT_DEFAULT_VLAN };
+
+void db_init_port(void)
+{
+    uint32_t port, slot;
+
+    for (port = 0; port < PORT_NUMBER; port++) {
+        __atomic_store_n(&port_default_vlans[port], PORT_DEFAULT_VLAN, __ATOMIC_RELAXED);
+    }
+
+    pthread_rwlock_wrlock(&port_policer_lock);
+
+    /* db_init_policer drops the references */
+    for (port = 0; port < PORT_NUMBER; port++) {
+        for (slot = 0; slot < PORT_POLICER_COUNT; slot++) {
+            port_policers[port][slot] = STUB_NO_POLICER;
+        }
+    }
+
+    pthread_rwlock_unlock(&port_policer_lock);
+}
+
+/*
+ * Routine Description:
+ *    Get the VLAN of untagged and priority tagged frames received on a port
+ *
+ * Arguments:
+ *    [in] port - port index
+ *
+ * Return Values:
+ *    VLAN id
+ */
+sai_vlan_id_t db_get_port_default_vlan(_In_ uint32_t port)
+{
+    if (port >= PORT_NUMBER) {
+        return PORT_DEFAULT_VLAN;
+    }
+
+    return __atomic_load_n(&port_default_vlans[port], __ATOMIC_RELAXED);
+}
+
 /* Default VLAN [sai_vlan_id_t]
  *   Untagged ingress frames are tagged with default VLAN
  */
@@ -490,6 +935,18 @@ sai_status_t stub_port_default_vlan_set(_In_ const sai_object_key_t      *key,
         return status;
     }
 
+    if (port_id >= PORT_NUMBER) {
+        STUB_LOG_ERR("Invalid port index %u\n", port_id);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    if ((value->u16 < 1) || (value->u16 > 4095)) {
+        STUB_LOG_ERR("Invalid port vlan %u\n", value->u16);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    __atomic_store_n(&port_default_vlans[port_id], value->u16, __ATOMIC_RELAXED);
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -780,12 +1237,48 @@ sai_status_t stub_port_update_dscp_get(_In_ const sai_object_key_t   *key,
     return SAI_STATUS_SUCCESS;
 }
 
-/* [bool] (default to FALSE) */
-sai_status_t stub_port_storm_control_get(_In_ const sai_object_key_t   *key,
-                                         _Inout_ sai_attribute_value_t *value,
-                                         _In_ uint32_t                  attr_index,
-                                         _Inout_ vendor_cache_t        *cache,
-                                         void                          *arg)
+/* Storm control and port policers [sai_object_id_t], SAI_NULL_OBJECT_ID
+ * for none (default) */
+sai_status_t stub_port_policer_get(_In_ const sai_object_key_t   *key,
+                                   _Inout_ sai_attribute_value_t *value,
+                                   _In_ uint32_t                  attr_index,
+                                   _Inout_ vendor_cache_t        *cache,
+                                   void                          *arg)
+{
+    sai_status_t status;
+    uint32_t     port_id, policer;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(key->object_id, SAI_OBJECT_TYPE_PORT, &port_id))) {
+        return status;
+    }
+
+    if (port_id >= PORT_NUMBER) {
+        STUB_LOG_ERR("Invalid port index %u\n", port_id);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    pthread_rwlock_rdlock(&port_policer_lock);
+    policer = port_policers[port_id][port_policer_slot((long)arg)];
+    pthread_rwlock_unlock(&port_policer_lock);
+
+    value->oid = SAI_NULL_OBJECT_ID;
+    if (STUB_NO_POLICER != policer) {
+        status = stub_create_object(SAI_OBJECT_TYPE_POLICER, policer, &value->oid);
+    }
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* Default traffic class [sai_uint8_t], 0 (default), and QoS maps
+ * [sai_object_id_t], SAI_NULL_OBJECT_ID for none (default) */
+sai_status_t stub_port_qos_get(_In_ const sai_object_key_t   *key,
+                               _Inout_ sai_attribute_value_t *value,
+                               _In_ uint32_t                  attr_index,
+                               _Inout_ vendor_cache_t        *cache,
+                               void                          *arg)
 {
     sai_status_t status;
     uint32_t     port_id;
@@ -796,10 +1289,98 @@ sai_status_t stub_port_storm_control_get(_In_ const sai_object_key_t   *key,
         return status;
     }
 
-    value->booldata = false;
+    if (port_id >= PORT_NUMBER) {
+        STUB_LOG_ERR("Invalid port index %u\n", port_id);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    status = db_get_port_qos(port_id, (long)arg, value);
 
     STUB_LOG_EXIT();
-    return SAI_STATUS_SUCCESS;
+    return status;
+}
+
+/* Number of queues and scheduler groups [uint32_t], queues and scheduler
+ * groups [sai_object_list_t], scheduler [sai_object_id_t] */
+sai_status_t stub_port_scheduler_get(_In_ const sai_object_key_t   *key,
+                                     _Inout_ sai_attribute_value_t *value,
+                                     _In_ uint32_t                  attr_index,
+                                     _Inout_ vendor_cache_t        *cache,
+                                     void                          *arg)
+{
+    sai_status_t status;
+    uint32_t     port_id;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(key->object_id, SAI_OBJECT_TYPE_PORT, &port_id))) {
+        return status;
+    }
+
+    if (port_id >= PORT_NUMBER) {
+        STUB_LOG_ERR("Invalid port index %u\n", port_id);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    status = db_get_port_scheduler(port_id, (long)arg, value);
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* Number of priority groups [uint32_t], priority groups [sai_object_list_t] */
+sai_status_t stub_port_buffer_get(_In_ const sai_object_key_t   *key,
+                                  _Inout_ sai_attribute_value_t *value,
+                                  _In_ uint32_t                  attr_index,
+                                  _Inout_ vendor_cache_t        *cache,
+                                  void                          *arg)
+{
+    sai_status_t status;
+    uint32_t     port_id;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(key->object_id, SAI_OBJECT_TYPE_PORT, &port_id))) {
+        return status;
+    }
+
+    if (port_id >= PORT_NUMBER) {
+        STUB_LOG_ERR("Invalid port index %u\n", port_id);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    status = db_get_port_buffer(port_id, (long)arg, value);
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* Ingress and egress mirror sessions [sai_object_list_t], empty for none
+ * (default) */
+sai_status_t stub_port_mirror_get(_In_ const sai_object_key_t   *key,
+                                  _Inout_ sai_attribute_value_t *value,
+                                  _In_ uint32_t                  attr_index,
+                                  _Inout_ vendor_cache_t        *cache,
+                                  void                          *arg)
+{
+    sai_status_t status;
+    uint32_t     port_id;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(key->object_id, SAI_OBJECT_TYPE_PORT, &port_id))) {
+        return status;
+    }
+
+    if (port_id >= PORT_NUMBER) {
+        STUB_LOG_ERR("Invalid port index %u\n", port_id);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    status = db_get_port_mirror(port_id, SAI_PORT_ATTR_INGRESS_MIRROR_SESSION == (long)arg, &value->objlist);
+
+    STUB_LOG_EXIT();
+    return status;
 }
 
 /* Operational Status [sai_port_oper_status_t] */
@@ -961,7 +1542,7 @@ sai_status_t stub_port_default_vlan_get(_In_ const sai_object_key_t   *key,
         return status;
     }
 
-    value->u16 = 1;
+    value->u16 = db_get_port_default_vlan(port_id);
 
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
@@ -1164,6 +1745,180 @@ sai_status_t stub_get_port_attribute(_In_ sai_object_id_t     port_id,
     return sai_get_attributes(&key, key_str, port_attribs, port_vendor_attribs, attr_count, attr_list);
 }
 
+/* Port counters *************/
+/* Shards of the port counters, a writer adds to the shard of the core it runs on */
+#define PORT_STAT_SHARDS 16
+
+static uint64_t port_stats[PORT_STAT_SHARDS][PORT_NUMBER][STUB_PORT_STAT_COUNT] __attribute__((aligned(64)));
+/* Shards written so far, readers skip the others */
+static uint32_t port_stat_shards_used = 1;
+
+/*
+ * Routine Description:
+ *    Shard of the calling thread's core. Writers take it once per burst,
+ *    a thread that moves to another core keeps adding correctly
+ */
+uint32_t db_port_stats_shard(void)
+{
+    int      cpu   = sched_getcpu();
+    uint32_t shard = (cpu < 0) ? 0 : (uint32_t)cpu % PORT_STAT_SHARDS;
+    uint32_t used  = __atomic_load_n(&port_stat_shards_used, __ATOMIC_RELAXED);
+
+    while ((shard >= used) &&
+           !__atomic_compare_exchange_n(&port_stat_shards_used, &used, shard + 1, false, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED)) {
+    }
+
+    return shard;
+}
+
+static inline void port_stat_add(_In_ uint64_t *counters, _In_ sai_port_stat_counter_t counter, _In_ uint64_t value)
+{
+    __atomic_fetch_add(&counters[counter], value, __ATOMIC_RELAXED);
+}
+
+/*
+ * Routine Description:
+ *    Add to one port counter
+ *
+ * Arguments:
+ *    [in] shard - shard from db_port_stats_shard
+ *    [in] port - port index
+ *    [in] counter - counter id
+ *    [in] value - value to add
+ */
+void db_port_stats_add(_In_ uint32_t shard, _In_ uint32_t port, _In_ sai_port_stat_counter_t counter, _In_ uint64_t value)
+{
+    port_stat_add(port_stats[shard][port], counter, value);
+}
+
+/* Offset of a frame size in the 64 to 16383 octets counter runs */
+static inline uint32_t port_stat_size_bucket(_In_ uint32_t size)
+{
+    static const uint32_t limits[] = { 64, 127, 255, 511, 1023, 1518, 2047, 4095, 9216 };
+    uint32_t              ii;
+
+    for (ii = 0; ii < sizeof(limits) / sizeof(limits[0]); ii++) {
+        if (size <= limits[ii]) {
+            break;
+        }
+    }
+
+    return ii;
+}
+
+/*
+ * Routine Description:
+ *    Count one frame received or sent on a port. Received frames are
+ *    counted as they arrive, before the data plane rewrites them
+ *
+ * Arguments:
+ *    [in] shard - shard from db_port_stats_shard
+ *    [in] port - port index
+ *    [in] ingress - received, else sent
+ *    [in] data - Ethernet frame
+ *    [in] length - frame length without FCS
+ */
+void db_port_stats_frame(_In_ uint32_t       shard,
+                         _In_ uint32_t       port,
+                         _In_ bool           ingress,
+                         _In_ const uint8_t *data,
+                         _In_ uint32_t       length)
+{
+    uint64_t *counters = port_stats[shard][port];
+    uint32_t  size     = length + 4;
+    uint32_t  bucket   = port_stat_size_bucket(size);
+    bool      group    = (length >= sizeof(sai_mac_t)) && (data[0] & 0x01);
+    bool      broadcast;
+
+    broadcast = group && (0xFF == (data[0] & data[1] & data[2] & data[3] & data[4] & data[5]));
+
+    if (!ingress) {
+        port_stat_add(counters, SAI_PORT_STAT_IF_OUT_OCTETS, length);
+        port_stat_add(counters, group ? SAI_PORT_STAT_IF_OUT_NON_UCAST_PKTS : SAI_PORT_STAT_IF_OUT_UCAST_PKTS, 1);
+        if (group) {
+            port_stat_add(counters,
+                          broadcast ? SAI_PORT_STAT_IF_OUT_BROADCAST_PKTS : SAI_PORT_STAT_IF_OUT_MULTICAST_PKTS, 1);
+        }
+        port_stat_add(counters, SAI_PORT_STAT_ETHER_OUT_PKTS_64_OCTETS + bucket, 1);
+        port_stat_add(counters, SAI_PORT_STAT_ETHER_STATS_TX_NO_ERRORS, 1);
+        if (size > 1518) {
+            port_stat_add(counters, SAI_PORT_STAT_ETHER_TX_OVERSIZE_PKTS, 1);
+        }
+        return;
+    }
+
+    port_stat_add(counters, SAI_PORT_STAT_IF_IN_OCTETS, length);
+    port_stat_add(counters, group ? SAI_PORT_STAT_IF_IN_NON_UCAST_PKTS : SAI_PORT_STAT_IF_IN_UCAST_PKTS, 1);
+    if (group) {
+        port_stat_add(counters,
+                      broadcast ? SAI_PORT_STAT_IF_IN_BROADCAST_PKTS : SAI_PORT_STAT_IF_IN_MULTICAST_PKTS, 1);
+        port_stat_add(counters,
+                      broadcast ? SAI_PORT_STAT_ETHER_STATS_BROADCAST_PKTS : SAI_PORT_STAT_ETHER_STATS_MULTICAST_PKTS,
+                      1);
+    }
+    port_stat_add(counters, SAI_PORT_STAT_ETHER_STATS_OCTETS, size);
+    port_stat_add(counters, SAI_PORT_STAT_ETHER_STATS_PKTS, 1);
+    port_stat_add(counters, SAI_PORT_STAT_ETHER_STATS_PKTS_64_OCTETS + bucket, 1);
+    port_stat_add(counters, SAI_PORT_STAT_ETHER_IN_PKTS_64_OCTETS + bucket, 1);
+    port_stat_add(counters, SAI_PORT_STAT_ETHER_STATS_RX_NO_ERRORS, 1);
+    if (size < 64) {
+        port_stat_add(counters, SAI_PORT_STAT_ETHER_STATS_UNDERSIZE_PKTS, 1);
+    } else if (size > 1518) {
+        port_stat_add(counters, SAI_PORT_STAT_ETHER_STATS_OVERSIZE_PKTS, 1);
+        port_stat_add(counters, SAI_PORT_STAT_ETHER_RX_OVERSIZE_PKTS, 1);
+    }
+}
+
+static sai_status_t port_stats_check(_In_ sai_object_id_t                port_id,
+                                     _In_ const sai_port_stat_counter_t *counter_ids,
+                                     _In_ uint32_t                       number_of_counters,
+                                     _Out_ uint32_t                     *port)
+{
+    sai_status_t status;
+    uint32_t     ii;
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(port_id, SAI_OBJECT_TYPE_PORT, port))) {
+        return status;
+    }
+
+    if (*port >= PORT_NUMBER) {
+        STUB_LOG_ERR("Invalid port index %u\n", *port);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    for (ii = 0; ii < number_of_counters; ii++) {
+        if ((uint32_t)counter_ids[ii] >= STUB_PORT_STAT_COUNT) {
+            STUB_LOG_ERR("Invalid port counter %d\n", counter_ids[ii]);
+            return SAI_STATUS_INVALID_PARAMETER;
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Sum the shards of some counters of one port, clearing them on the way */
+static void port_stats_read(_In_ uint32_t                       port,
+                            _In_ const sai_port_stat_counter_t *counter_ids,
+                            _In_ uint32_t                       number_of_counters,
+                            _In_ bool                           clear,
+                            _Out_ uint64_t                     *counters)
+{
+    uint32_t shards = __atomic_load_n(&port_stat_shards_used, __ATOMIC_RELAXED);
+    uint32_t shard, ii;
+
+    memset(counters, 0, number_of_counters * sizeof(*counters));
+
+    for (shard = 0; shard < shards; shard++) {
+        uint64_t *shard_counters = port_stats[shard][port];
+
+        for (ii = 0; ii < number_of_counters; ii++) {
+            counters[ii] += clear ? __atomic_exchange_n(&shard_counters[counter_ids[ii]], 0, __ATOMIC_RELAXED) :
+                            __atomic_load_n(&shard_counters[counter_ids[ii]], __ATOMIC_RELAXED);
+        }
+    }
+}
+
 /*
  * Routine Description:
  *   Get port statistics counters.
@@ -1184,13 +1939,13 @@ sai_status_t stub_get_port_stats(_In_ sai_object_id_t                port_id,
                                  _Out_ uint64_t                     *counters)
 {
     sai_status_t status;
-    uint32_t     ii, port_data;
+    uint32_t     port;
     char         key_str[MAX_KEY_STR_LEN];
 
     STUB_LOG_ENTER();
 
     port_key_to_str(port_id, key_str);
-    STUB_LOG_NTC("Get port stats %s\n", key_str);
+    STUB_LOG_DBG("Get port stats %s\n", key_str);
 
     if (NULL == counter_ids) {
         STUB_LOG_ERR("NULL counter ids array param\n");
@@ -1202,176 +1957,148 @@ sai_status_t stub_get_port_stats(_In_ sai_object_id_t                port_id,
         return SAI_STATUS_INVALID_PARAMETER;
     }
 
-    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(port_id, SAI_OBJECT_TYPE_PORT, &port_data))) {
+    if (SAI_STATUS_SUCCESS != (status = port_stats_check(port_id, counter_ids, number_of_counters, &port))) {
         return status;
     }
 
-    for (ii = 0; ii < number_of_counters; ii++) {
-        switch (counter_ids[ii]) {
-        case SAI_PORT_STAT_IF_IN_OCTETS:
-            counters[ii] = 0;
-            break;
-
-        case SAI_PORT_STAT_IF_IN_UCAST_PKTS:
-            counters[ii] = 0;
-            break;
-
-        case SAI_PORT_STAT_IF_IN_NON_UCAST_PKTS:
-            counters[ii] = 0;
-            break;
-
-        case SAI_PORT_STAT_IF_IN_DISCARDS:
-            counters[ii] = 0;
-            break;
-
-        case SAI_PORT_STAT_IF_IN_ERRORS:
-            counters[ii] = 0;
-            break;
-
-        case SAI_PORT_STAT_IF_IN_UNKNOWN_PROTOS:
-            counters[ii] = 0;
-            break;
-
-        case SAI_PORT_STAT_IF_IN_BROADCAST_PKTS:
-            counters[ii] = 0;
-            break;
-
-        case SAI_PORT_STAT_IF_IN_MULTICAST_PKTS:
-            counters[ii] = 0;
-            break;
-
-        case SAI_PORT_STAT_IF_OUT_OCTETS:
-            counters[ii] = 0;
-            break;
-
-        case SAI_PORT_STAT_IF_OUT_UCAST_PKTS:
-            counters[ii] = 0;
-            break;
-
-        case SAI_PORT_STAT_IF_OUT_NON_UCAST_PKTS:
-            counters[ii] = 0;
-            break;
-
-        case SAI_PORT_STAT_IF_OUT_DISCARDS:
-            counters[ii] = 0;
-            break;
-
-        case SAI_PORT_STAT_IF_OUT_ERRORS:
-            counters[ii] = 0;
-            break;
-
-        case SAI_PORT_STAT_IF_OUT_BROADCAST_PKTS:
-            counters[ii] = 0;
-            break;
+    port_stats_read(port, counter_ids, number_of_counters, false, counters);
 
-        case SAI_PORT_STAT_IF_OUT_MULTICAST_PKTS:
-            counters[ii] = 0;
-            break;
-
-        case SAI_PORT_STAT_ETHER_STATS_DROP_EVENTS:
-            counters[ii] = 0;
-            break;
-
-        case SAI_PORT_STAT_ETHER_STATS_MULTICAST_PKTS:
-            counters[ii] = 0;
-            break;
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
 
-        case SAI_PORT_STAT_ETHER_STATS_BROADCAST_PKTS:
-            counters[ii] = 0;
-            break;
+/*
+ * Routine Description:
+ *   Clear port statistics counters.
+ *
+ * Arguments:
+ *    [in] port_id - port id
+ *    [in] counter_ids - specifies the array of counter ids
+ *    [in] number_of_counters - number of counters in the array
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_clear_port_stats(_In_ sai_object_id_t                port_id,
+                                   _In_ const sai_port_stat_counter_t *counter_ids,
+                                   _In_ uint32_t                       number_of_counters)
+{
+    uint32_t     shards = __atomic_load_n(&port_stat_shards_used, __ATOMIC_RELAXED);
+    sai_status_t status;
+    uint32_t     port, shard, ii;
+    char         key_str[MAX_KEY_STR_LEN];
 
-        case SAI_PORT_STAT_ETHER_STATS_UNDERSIZE_PKTS:
-            counters[ii] = 0;
-            break;
+    STUB_LOG_ENTER();
 
-        case SAI_PORT_STAT_ETHER_STATS_FRAGMENTS:
-            counters[ii] = 0;
-            break;
+    port_key_to_str(port_id, key_str);
+    STUB_LOG_NTC("Clear port stats %s\n", key_str);
 
-        case SAI_PORT_STAT_ETHER_STATS_PKTS_64_OCTETS:
-            counters[ii] = 0;
-            break;
+    if (NULL == counter_ids) {
+        STUB_LOG_ERR("NULL counter ids array param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
 
-        case SAI_PORT_STAT_ETHER_STATS_PKTS_65_TO_127_OCTETS:
-            counters[ii] = 0;
-            break;
+    if (SAI_STATUS_SUCCESS != (status = port_stats_check(port_id, counter_ids, number_of_counters, &port))) {
+        return status;
+    }
 
-        case SAI_PORT_STAT_ETHER_STATS_PKTS_128_TO_255_OCTETS:
-            counters[ii] = 0;
-            break;
+    for (shard = 0; shard < shards; shard++) {
+        for (ii = 0; ii < number_of_counters; ii++) {
+            __atomic_store_n(&port_stats[shard][port][counter_ids[ii]], 0, __ATOMIC_RELAXED);
+        }
+    }
 
-        case SAI_PORT_STAT_ETHER_STATS_PKTS_256_TO_511_OCTETS:
-            counters[ii] = 0;
-            break;
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
 
-        case SAI_PORT_STAT_ETHER_STATS_PKTS_512_TO_1023_OCTETS:
-            counters[ii] = 0;
-            break;
+/*
+ * Routine Description:
+ *   Clear port's all statistics counters.
+ *
+ * Arguments:
+ *    [in] port_id - port id
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_clear_port_all_stats(_In_ sai_object_id_t port_id)
+{
+    uint32_t     shards = __atomic_load_n(&port_stat_shards_used, __ATOMIC_RELAXED);
+    sai_status_t status;
+    uint32_t     port, shard, ii;
+    char         key_str[MAX_KEY_STR_LEN];
 
-        case SAI_PORT_STAT_ETHER_STATS_PKTS_1024_TO_1518_OCTETS:
-            counters[ii] = 0;
-            break;
+    STUB_LOG_ENTER();
 
-        case SAI_PORT_STAT_ETHER_STATS_OVERSIZE_PKTS:
-            counters[ii] = 0;
-            break;
+    port_key_to_str(port_id, key_str);
+    STUB_LOG_NTC("Clear all port stats %s\n", key_str);
 
-        case SAI_PORT_STAT_ETHER_STATS_JABBERS:
-            counters[ii] = 0;
-            break;
+    if (SAI_STATUS_SUCCESS != (status = port_stats_check(port_id, NULL, 0, &port))) {
+        return status;
+    }
 
-        case SAI_PORT_STAT_ETHER_STATS_OCTETS:
-            counters[ii] = 0;
-            break;
+    for (shard = 0; shard < shards; shard++) {
+        for (ii = 0; ii < STUB_PORT_STAT_COUNT; ii++) {
+            __atomic_store_n(&port_stats[shard][port][ii], 0, __ATOMIC_RELAXED);
+        }
+    }
 
-        case SAI_PORT_STAT_ETHER_STATS_PKTS:
-            counters[ii] = 0;
-            break;
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
 
-        case SAI_PORT_STAT_ETHER_STATS_COLLISIONS:
-            counters[ii] = 0;
-            break;
+/*
+ * Routine Description:
+ *    Read the same counters of several ports in one call
+ *
+ * Arguments:
+ *    [in] port_count - number of ports
+ *    [in] port_ids - ports
+ *    [in] number_of_counters - number of counters per port
+ *    [in] counter_ids - counters
+ *    [in] clear - clear each counter as it is read
+ *    [out] counters - port_count rows of number_of_counters values
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_port_get_stats_bulk(_In_ uint32_t                       port_count,
+                                      _In_ const sai_object_id_t         *port_ids,
+                                      _In_ uint32_t                       number_of_counters,
+                                      _In_ const sai_port_stat_counter_t *counter_ids,
+                                      _In_ bool                           clear,
+                                      _Out_ uint64_t                     *counters)
+{
+    uint32_t     ports[PORT_NUMBER];
+    sai_status_t status;
+    uint32_t     ii;
 
-        case SAI_PORT_STAT_ETHER_STATS_CRC_ALIGN_ERRORS:
-            counters[ii] = 0;
-            break;
+    if ((NULL == port_ids) || (NULL == counter_ids) || (NULL == counters)) {
+        STUB_LOG_ERR("NULL port ids, counter ids or counters param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
 
-        case SAI_PORT_STAT_IF_IN_VLAN_DISCARDS:
-        case SAI_PORT_STAT_IF_OUT_QLEN:
-        case SAI_PORT_STAT_ETHER_RX_OVERSIZE_PKTS:
-        case SAI_PORT_STAT_ETHER_TX_OVERSIZE_PKTS:
-        case SAI_PORT_STAT_ETHER_STATS_TX_NO_ERRORS:
-        case SAI_PORT_STAT_ETHER_STATS_RX_NO_ERRORS:
-        case SAI_PORT_STAT_IP_IN_RECEIVES:
-        case SAI_PORT_STAT_IP_IN_OCTETS:
-        case SAI_PORT_STAT_IP_IN_UCAST_PKTS:
-        case SAI_PORT_STAT_IP_IN_NON_UCAST_PKTS:
-        case SAI_PORT_STAT_IP_IN_DISCARDS:
-        case SAI_PORT_STAT_IP_OUT_OCTETS:
-        case SAI_PORT_STAT_IP_OUT_UCAST_PKTS:
-        case SAI_PORT_STAT_IP_OUT_NON_UCAST_PKTS:
-        case SAI_PORT_STAT_IP_OUT_DISCARDS:
-        case SAI_PORT_STAT_IPV6_IN_RECEIVES:
-        case SAI_PORT_STAT_IPV6_IN_OCTETS:
-        case SAI_PORT_STAT_IPV6_IN_UCAST_PKTS:
-        case SAI_PORT_STAT_IPV6_IN_NON_UCAST_PKTS:
-        case SAI_PORT_STAT_IPV6_IN_MCAST_PKTS:
-        case SAI_PORT_STAT_IPV6_IN_DISCARDS:
-        case SAI_PORT_STAT_IPV6_OUT_OCTETS:
-        case SAI_PORT_STAT_IPV6_OUT_UCAST_PKTS:
-        case SAI_PORT_STAT_IPV6_OUT_NON_UCAST_PKTS:
-        case SAI_PORT_STAT_IPV6_OUT_MCAST_PKTS:
-        case SAI_PORT_STAT_IPV6_OUT_DISCARDS:
-            counters[ii] = 0;
-            break;
+    if (port_count > PORT_NUMBER) {
+        STUB_LOG_ERR("Port count %u above %u\n", port_count, PORT_NUMBER);
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
 
-        default:
-            STUB_LOG_ERR("Invalid port counter %d\n", counter_ids[ii]);
-            return SAI_STATUS_INVALID_PARAMETER;
+    /* Validate everything first, a failed call clears nothing */
+    for (ii = 0; ii < port_count; ii++) {
+        if (SAI_STATUS_SUCCESS !=
+            (status = port_stats_check(port_ids[ii], counter_ids, (0 == ii) ? number_of_counters : 0, &ports[ii]))) {
+            return status;
         }
     }
 
-    STUB_LOG_EXIT();
+    for (ii = 0; ii < port_count; ii++) {
+        port_stats_read(ports[ii], counter_ids, number_of_counters, clear, counters + ii * number_of_counters);
+    }
+
     return SAI_STATUS_SUCCESS;
 }
 
@@ -1379,6 +2106,6 @@ const sai_port_api_t port_api = {
     stub_set_port_attribute,
     stub_get_port_attribute,
     stub_get_port_stats,
-    NULL,
-    NULL
+    stub_clear_port_stats,
+    stub_clear_port_all_stats
 };
@@ -0,0 +1,803 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#include "sai.h"
+#include "stub_sai.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_qos_map.h"
+#include "assert.h"
+
+#undef  __MODULE__
+#define __MODULE__ SAI_QOS_MAP
+
+static const sai_attribute_entry_t qos_map_attribs[] = {
+    { SAI_QOS_MAP_ATTR_TYPE, true, true, false, true,
+      "QoS map type", SAI_ATTR_VAL_TYPE_S32 },
+    { SAI_QOS_MAP_ATTR_MAP_TO_VALUE_LIST, false, true, true, true,
+      "QoS map list", SAI_ATTR_VAL_TYPE_QOSMAP },
+    { END_FUNCTIONALITY_ATTRIBS_ID, false, false, false, false,
+      "", SAI_ATTR_VAL_TYPE_UNDETERMINED }
+};
+
+sai_status_t stub_qos_map_attr_get(_In_ const sai_object_key_t   *key,
+                                   _Inout_ sai_attribute_value_t *value,
+                                   _In_ uint32_t                  attr_index,
+                                   _Inout_ vendor_cache_t        *cache,
+                                   void                          *arg);
+sai_status_t stub_qos_map_list_set(_In_ const sai_object_key_t      *key,
+                                   _In_ const sai_attribute_value_t *value,
+                                   void                             *arg);
+
+static const sai_vendor_attribute_entry_t qos_map_vendor_attribs[] = {
+    { SAI_QOS_MAP_ATTR_TYPE,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_qos_map_attr_get, (void*)SAI_QOS_MAP_ATTR_TYPE,
+      NULL, NULL },
+    { SAI_QOS_MAP_ATTR_MAP_TO_VALUE_LIST,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_qos_map_attr_get, (void*)SAI_QOS_MAP_ATTR_MAP_TO_VALUE_LIST,
+      stub_qos_map_list_set, NULL },
+};
+
+/* State DB *************/
+#define MAX_QOS_MAPS           64
+/* entries of a compiled table, the DSCP keys take them all */
+#define QOS_TABLE_SIZE         64
+#define QOS_DOT1P_VALUES       8
+#define QOS_DSCP_VALUES        64
+#define QOS_PFC_PRIORITIES     8
+#define QOS_COLORS             (SAI_PACKET_COLOR_RED + 1)
+#define QOS_NO_MAP             UINT32_MAX
+/* SAI_PORT_ATTR_QOS_DOT1P_TO_TC_MAP to SAI_PORT_ATTR_QOS_PFC_PRIORITY_TO_QUEUE_MAP */
+#define QOS_PORT_SLOT(attr)    ((attr) - SAI_PORT_ATTR_QOS_DOT1P_TO_TC_MAP)
+#define QOS_PORT_MAPS          (QOS_PORT_SLOT(SAI_PORT_ATTR_QOS_PFC_PRIORITY_TO_QUEUE_MAP) + 1)
+
+#define QOS_ETH_HDR_LEN        14
+#define QOS_VLAN_HDR_LEN       4
+#define QOS_ETHERTYPE_VLAN     0x8100
+#define QOS_ETHERTYPE_IPV4     0x0800
+#define QOS_ETHERTYPE_IPV6     0x86DD
+
+/* Value of each key of a map, swapped whole, never changed in place */
+typedef struct _qos_table_t {
+    /* a reader racing a remove may find the slot taken by a map of another type */
+    sai_int32_t type;
+    uint8_t     values[QOS_TABLE_SIZE];
+} qos_table_t;
+
+typedef struct _qos_map_t {
+    bool           is_used;
+    sai_int32_t    type;
+    /* the list as set, for reading back */
+    sai_qos_map_t *list;
+    uint32_t       count;
+    /* ports binding the map */
+    uint32_t       ref_count;
+} qos_map_t;
+
+typedef struct _qos_port_t {
+    sai_cos_t default_tc;
+    uint32_t  maps[QOS_PORT_MAPS];
+} qos_port_t;
+
+static qos_map_t        qos_map_db[MAX_QOS_MAPS];
+/* Compiled maps, the data plane reads them in read side sections */
+static qos_table_t     *qos_tables[MAX_QOS_MAPS];
+/* Map indexes per port, QOS_NO_MAP when none is bound. Read without locks */
+static qos_port_t       qos_ports[PORT_NUMBER] = {
+    [0 ... PORT_NUMBER - 1] = { 0, { [0 ... QOS_PORT_MAPS - 1] = QOS_NO_MAP } }
+};
+static pthread_rwlock_t qos_map_db_lock = STUB_RWLOCK_INITIALIZER;
+
+/* Map type each port map attribute binds */
+static const sai_int32_t qos_port_map_types[QOS_PORT_MAPS] = {
+    [QOS_PORT_SLOT(SAI_PORT_ATTR_QOS_DOT1P_TO_TC_MAP)]                  = SAI_QOS_MAP_DOT1P_TO_TC,
+    [QOS_PORT_SLOT(SAI_PORT_ATTR_QOS_DOT1P_TO_COLOR_MAP)]               = SAI_QOS_MAP_DOT1P_TO_COLOR,
+    [QOS_PORT_SLOT(SAI_PORT_ATTR_QOS_DSCP_TO_TC_MAP)]                   = SAI_QOS_MAP_DSCP_TO_TC,
+    [QOS_PORT_SLOT(SAI_PORT_ATTR_QOS_DSCP_TO_COLOR_MAP)]                = SAI_QOS_MAP_DSCP_TO_COLOR,
+    [QOS_PORT_SLOT(SAI_PORT_ATTR_QOS_TC_TO_QUEUE_MAP)]                  = SAI_QOS_MAP_TC_TO_QUEUE,
+    [QOS_PORT_SLOT(SAI_PORT_ATTR_QOS_TC_AND_COLOR_TO_DOT1P_MAP)]        = SAI_QOS_MAP_TC_AND_COLOR_TO_DOT1P,
+    [QOS_PORT_SLOT(SAI_PORT_ATTR_QOS_TC_AND_COLOR_TO_DSCP_MAP)]         = SAI_QOS_MAP_TC_AND_COLOR_TO_DSCP,
+    [QOS_PORT_SLOT(SAI_PORT_ATTR_QOS_TC_TO_PRIORITY_GROUP_MAP)]         = SAI_QOS_MAP_TC_TO_PRIORITY_GROUP,
+    [QOS_PORT_SLOT(SAI_PORT_ATTR_QOS_PFC_PRIORITY_TO_PRIORITY_GROUP_MAP)] =
+        SAI_QOS_MAP_PFC_PRIORITY_TO_PRIORITY_GROUP,
+    [QOS_PORT_SLOT(SAI_PORT_ATTR_QOS_PFC_PRIORITY_TO_QUEUE_MAP)]        = SAI_QOS_MAP_PFC_PRIORITY_TO_QUEUE,
+};
+
+/* Caller holds qos_map_db_lock */
+static sai_status_t qos_map_db_index(_In_ sai_object_id_t qos_map_id, _Out_ uint32_t *index)
+{
+    sai_status_t status;
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(qos_map_id, SAI_OBJECT_TYPE_QOS_MAPS, index))) {
+        return status;
+    }
+
+    if ((*index >= MAX_QOS_MAPS) || (!qos_map_db[*index].is_used)) {
+        STUB_LOG_ERR("QoS map %u does not exist\n", *index);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void qos_map_key_to_str(_In_ sai_object_id_t qos_map_id, _Out_ char *key_str)
+{
+    uint32_t index;
+
+    if (SAI_STATUS_SUCCESS != stub_object_to_type(qos_map_id, SAI_OBJECT_TYPE_QOS_MAPS, &index)) {
+        snprintf(key_str, MAX_KEY_STR_LEN, "invalid QoS map id");
+    } else {
+        snprintf(key_str, MAX_KEY_STR_LEN, "QoS map id %u", index);
+    }
+}
+
+/* Table index of a map key, false when the key is out of range */
+static bool qos_map_key(_In_ sai_int32_t type, _In_ const sai_qos_map_params_t *key, _Out_ uint32_t *index)
+{
+    switch (type) {
+    case SAI_QOS_MAP_DOT1P_TO_TC:
+    case SAI_QOS_MAP_DOT1P_TO_COLOR:
+        *index = key->dot1p;
+        return key->dot1p < QOS_DOT1P_VALUES;
+
+    case SAI_QOS_MAP_DSCP_TO_TC:
+    case SAI_QOS_MAP_DSCP_TO_COLOR:
+        *index = key->dscp;
+        return key->dscp < QOS_DSCP_VALUES;
+
+    case SAI_QOS_MAP_TC_TO_QUEUE:
+    case SAI_QOS_MAP_TC_TO_PRIORITY_GROUP:
+        *index = key->tc;
+        return key->tc < STUB_QOS_TRAFFIC_CLASSES;
+
+    case SAI_QOS_MAP_TC_AND_COLOR_TO_DSCP:
+    case SAI_QOS_MAP_TC_AND_COLOR_TO_DOT1P:
+        *index = key->tc * QOS_COLORS + (uint32_t)key->color;
+        return (key->tc < STUB_QOS_TRAFFIC_CLASSES) && ((uint32_t)key->color < QOS_COLORS);
+
+    default:
+        *index = key->prio;
+        return key->prio < QOS_PFC_PRIORITIES;
+    }
+}
+
+/* Table value of a map value, false when the value is out of range */
+static bool qos_map_value(_In_ sai_int32_t type, _In_ const sai_qos_map_params_t *value, _Out_ uint8_t *table_value)
+{
+    switch (type) {
+    case SAI_QOS_MAP_DOT1P_TO_TC:
+    case SAI_QOS_MAP_DSCP_TO_TC:
+        *table_value = value->tc;
+        return value->tc < STUB_QOS_TRAFFIC_CLASSES;
+
+    case SAI_QOS_MAP_DOT1P_TO_COLOR:
+    case SAI_QOS_MAP_DSCP_TO_COLOR:
+        *table_value = (uint8_t)value->color;
+        return (uint32_t)value->color < QOS_COLORS;
+
+    case SAI_QOS_MAP_TC_TO_QUEUE:
+    case SAI_QOS_MAP_PFC_PRIORITY_TO_QUEUE:
+        *table_value = value->queue_index;
+        return value->queue_index < STUB_QOS_QUEUES;
+
+    case SAI_QOS_MAP_TC_AND_COLOR_TO_DSCP:
+        *table_value = value->dscp;
+        return value->dscp < QOS_DSCP_VALUES;
+
+    case SAI_QOS_MAP_TC_AND_COLOR_TO_DOT1P:
+        *table_value = value->dot1p;
+        return value->dot1p < QOS_DOT1P_VALUES;
+
+    default:
+        *table_value = value->pg;
+        return value->pg < STUB_QOS_PRIORITY_GROUPS;
+    }
+}
+
+/* Check a map list and compile it into a new table and a copy of the list */
+static sai_status_t qos_map_compile(_In_ sai_int32_t               type,
+                                    _In_ const sai_qos_map_list_t *list,
+                                    _Out_ qos_table_t            **table,
+                                    _Out_ sai_qos_map_t          **list_copy)
+{
+    uint64_t seen = 0;
+    uint32_t ii, index;
+    uint8_t  value;
+
+    if (list->count > QOS_TABLE_SIZE) {
+        STUB_LOG_ERR("QoS map list of %u entries, at most %u\n", list->count, QOS_TABLE_SIZE);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    for (ii = 0; ii < list->count; ii++) {
+        if (!qos_map_key(type, &list->list[ii].key, &index) || !qos_map_value(type, &list->list[ii].value, &value)) {
+            STUB_LOG_ERR("QoS map entry %u out of range for map type %d\n", ii, type);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        if (seen & (1ULL << index)) {
+            STUB_LOG_ERR("QoS map entry %u repeats a key\n", ii);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        seen |= 1ULL << index;
+    }
+
+    *table     = calloc(1, sizeof(**table));
+    *list_copy = calloc(list->count + 1, sizeof(**list_copy));
+    if ((NULL == *table) || (NULL == *list_copy)) {
+        free(*table);
+        free(*list_copy);
+        STUB_LOG_ERR("Failed to allocate QoS map\n");
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    (*table)->type = type;
+    for (ii = 0; ii < list->count; ii++) {
+        qos_map_key(type, &list->list[ii].key, &index);
+        qos_map_value(type, &list->list[ii].value, &(*table)->values[index]);
+    }
+    memcpy(*list_copy, list->list, list->count * sizeof(**list_copy));
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Port index of a port object, false for other objects */
+static inline bool qos_port_index(_In_ sai_object_id_t port_id, _Out_ uint32_t *port)
+{
+    const stub_object_id_t *object = (const stub_object_id_t*)&port_id;
+
+    *port = object->data;
+    return (SAI_OBJECT_TYPE_PORT == object->object_type) && (object->data < PORT_NUMBER);
+}
+
+/* Table a port binds in a slot, NULL when none. Caller is in a read side section */
+static inline const qos_table_t* qos_port_table(_In_ const qos_port_t *port, _In_ uint32_t slot)
+{
+    uint32_t           map = STUB_RCU_DEREF(port->maps[slot]);
+    const qos_table_t *table;
+
+    if (QOS_NO_MAP == map) {
+        return NULL;
+    }
+    table = STUB_RCU_DEREF(qos_tables[map]);
+    return ((NULL != table) && (qos_port_map_types[slot] == table->type)) ? table : NULL;
+}
+
+/* DOT1P of VLAN tagged frames and DSCP of IP frames, -1 for fields the frame has not */
+static inline void qos_frame_fields(_In_ const stub_packet_t *packet, _Out_ int32_t *dot1p, _Out_ int32_t *dscp)
+{
+    const uint8_t *data      = packet->data;
+    uint32_t       l3_offset = QOS_ETH_HDR_LEN;
+    uint16_t       ethertype;
+
+    *dot1p = -1;
+    *dscp  = -1;
+
+    if (packet->length < QOS_ETH_HDR_LEN) {
+        return;
+    }
+
+    ethertype = (uint16_t)((data[12] << 8) | data[13]);
+    if (QOS_ETHERTYPE_VLAN == ethertype) {
+        if (packet->length < QOS_ETH_HDR_LEN + QOS_VLAN_HDR_LEN) {
+            return;
+        }
+        *dot1p    = data[14] >> 5;
+        ethertype = (uint16_t)((data[16] << 8) | data[17]);
+        l3_offset = QOS_ETH_HDR_LEN + QOS_VLAN_HDR_LEN;
+    }
+
+    if (packet->length < l3_offset + 2) {
+        return;
+    }
+
+    if ((QOS_ETHERTYPE_IPV4 == ethertype) && (4 == (data[l3_offset] >> 4))) {
+        *dscp = data[l3_offset + 1] >> 2;
+    } else if ((QOS_ETHERTYPE_IPV6 == ethertype) && (6 == (data[l3_offset] >> 4))) {
+        *dscp = ((data[l3_offset] & 0x0F) << 2) | (data[l3_offset + 1] >> 6);
+    }
+}
+
+void db_init_qos_map(void)
+{
+    qos_table_t *old;
+    uint32_t     map, port, slot;
+
+    pthread_rwlock_wrlock(&qos_map_db_lock);
+
+    for (port = 0; port < PORT_NUMBER; port++) {
+        STUB_RCU_ASSIGN(qos_ports[port].default_tc, 0);
+        for (slot = 0; slot < QOS_PORT_MAPS; slot++) {
+            STUB_RCU_ASSIGN(qos_ports[port].maps[slot], QOS_NO_MAP);
+        }
+    }
+
+    for (map = 0; map < MAX_QOS_MAPS; map++) {
+        old = qos_tables[map];
+        STUB_RCU_ASSIGN(qos_tables[map], NULL);
+        stub_rcu_defer_free(old);
+        free(qos_map_db[map].list);
+    }
+
+    memset(qos_map_db, 0, sizeof(qos_map_db));
+
+    pthread_rwlock_unlock(&qos_map_db_lock);
+}
+
+/*
+ * Routine Description:
+ *    Get the default traffic class or a QoS map of a port
+ *
+ * Arguments:
+ *    [in] port - port index
+ *    [in] attr - SAI_PORT_ATTR_QOS_DEFAULT_TC or a SAI_PORT_ATTR_QOS_*_MAP
+ *    [out] value - traffic class, or map id, SAI_NULL_OBJECT_ID for none
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t db_get_port_qos(_In_ uint32_t port, _In_ sai_attr_id_t attr, _Out_ sai_attribute_value_t *value)
+{
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    uint32_t     map;
+
+    assert(port < PORT_NUMBER);
+
+    pthread_rwlock_rdlock(&qos_map_db_lock);
+
+    if (SAI_PORT_ATTR_QOS_DEFAULT_TC == attr) {
+        value->u8 = qos_ports[port].default_tc;
+    } else if (QOS_NO_MAP == (map = qos_ports[port].maps[QOS_PORT_SLOT(attr)])) {
+        value->oid = SAI_NULL_OBJECT_ID;
+    } else {
+        status = stub_create_object(SAI_OBJECT_TYPE_QOS_MAPS, map, &value->oid);
+    }
+
+    pthread_rwlock_unlock(&qos_map_db_lock);
+
+    return status;
+}
+
+/*
+ * Routine Description:
+ *    Set the default traffic class of a port, or bind a QoS map of the
+ *    matching type to it
+ *
+ * Arguments:
+ *    [in] port - port index
+ *    [in] attr - SAI_PORT_ATTR_QOS_DEFAULT_TC or a SAI_PORT_ATTR_QOS_*_MAP
+ *    [in] value - traffic class, or map id, SAI_NULL_OBJECT_ID to unbind
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    SAI_STATUS_INVALID_ATTR_VALUE_0 for a traffic class out of range, or a
+ *    map that does not exist or is of another type
+ */
+sai_status_t db_set_port_qos(_In_ uint32_t port, _In_ sai_attr_id_t attr, _In_ const sai_attribute_value_t *value)
+{
+    uint32_t slot, map = QOS_NO_MAP, old;
+
+    assert(port < PORT_NUMBER);
+
+    pthread_rwlock_wrlock(&qos_map_db_lock);
+
+    if (SAI_PORT_ATTR_QOS_DEFAULT_TC == attr) {
+        if (value->u8 >= STUB_QOS_TRAFFIC_CLASSES) {
+            pthread_rwlock_unlock(&qos_map_db_lock);
+            STUB_LOG_ERR("Default traffic class %u, at most %u\n", value->u8, STUB_QOS_TRAFFIC_CLASSES - 1);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        STUB_RCU_ASSIGN(qos_ports[port].default_tc, value->u8);
+        pthread_rwlock_unlock(&qos_map_db_lock);
+        return SAI_STATUS_SUCCESS;
+    }
+
+    slot = QOS_PORT_SLOT(attr);
+
+    if (SAI_NULL_OBJECT_ID != value->oid) {
+        if (SAI_STATUS_SUCCESS != qos_map_db_index(value->oid, &map)) {
+            pthread_rwlock_unlock(&qos_map_db_lock);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        if (qos_port_map_types[slot] != qos_map_db[map].type) {
+            pthread_rwlock_unlock(&qos_map_db_lock);
+            STUB_LOG_ERR("QoS map %u of type %d, the port attribute takes type %d\n",
+                         map, qos_map_db[map].type, qos_port_map_types[slot]);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        qos_map_db[map].ref_count++;
+    }
+
+    old = qos_ports[port].maps[slot];
+    STUB_RCU_ASSIGN(qos_ports[port].maps[slot], map);
+    if (QOS_NO_MAP != old) {
+        qos_map_db[old].ref_count--;
+    }
+
+    pthread_rwlock_unlock(&qos_map_db_lock);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Give the frames of a chunk a traffic class and a color by the QoS maps
+ *    of their ingress ports: DSCP maps for IP frames, else DOT1P maps for
+ *    VLAN tagged frames, else the port default traffic class and green.
+ *    The traffic class then gives the priority group, 0 without a map
+ *
+ * Arguments:
+ *    [in] count - number of frames
+ *    [inout] packets - frames
+ *    [in] pending - frames still in the pipeline, others stay
+ */
+void db_apply_qos_maps(_In_ uint32_t count, _Inout_ struct _stub_packet_t *packets, _In_ const bool *pending)
+{
+    const qos_port_t  *qos_port;
+    const qos_table_t *table;
+    stub_packet_t     *packet;
+    int32_t            dot1p, dscp;
+    uint32_t           ii, port;
+
+    stub_rcu_read_lock();
+
+    for (ii = 0; ii < count; ii++) {
+        packet = &packets[ii];
+        if (!pending[ii] || !qos_port_index(packet->in_port, &port)) {
+            continue;
+        }
+
+        qos_port = &qos_ports[port];
+        qos_frame_fields(packet, &dot1p, &dscp);
+
+        if ((dscp >= 0) && (NULL != (table = qos_port_table(qos_port, QOS_PORT_SLOT(SAI_PORT_ATTR_QOS_DSCP_TO_TC_MAP))))) {
+            packet->tc = table->values[dscp];
+        } else if ((dot1p >= 0) &&
+                   (NULL != (table = qos_port_table(qos_port, QOS_PORT_SLOT(SAI_PORT_ATTR_QOS_DOT1P_TO_TC_MAP))))) {
+            packet->tc = table->values[dot1p];
+        } else {
+            packet->tc = STUB_RCU_DEREF(qos_port->default_tc);
+        }
+
+        if ((dscp >= 0) &&
+            (NULL != (table = qos_port_table(qos_port, QOS_PORT_SLOT(SAI_PORT_ATTR_QOS_DSCP_TO_COLOR_MAP))))) {
+            packet->color = table->values[dscp];
+        } else if ((dot1p >= 0) &&
+                   (NULL != (table = qos_port_table(qos_port, QOS_PORT_SLOT(SAI_PORT_ATTR_QOS_DOT1P_TO_COLOR_MAP))))) {
+            packet->color = table->values[dot1p];
+        } else {
+            packet->color = SAI_PACKET_COLOR_GREEN;
+        }
+
+        if (NULL != (table = qos_port_table(qos_port, QOS_PORT_SLOT(SAI_PORT_ATTR_QOS_TC_TO_PRIORITY_GROUP_MAP)))) {
+            packet->priority_group = table->values[packet->tc];
+        }
+    }
+
+    stub_rcu_read_unlock();
+}
+
+/*
+ * Routine Description:
+ *    Give the frames of a chunk a queue by the TC to queue map of their
+ *    egress port, of the ingress port for flooded frames. Queue 0 without
+ *    a map
+ *
+ * Arguments:
+ *    [in] count - number of frames
+ *    [inout] packets - frames
+ */
+void db_apply_qos_queues(_In_ uint32_t count, _Inout_ struct _stub_packet_t *packets)
+{
+    const qos_table_t *table;
+    stub_packet_t     *packet;
+    uint32_t           ii, port;
+
+    stub_rcu_read_lock();
+
+    for (ii = 0; ii < count; ii++) {
+        packet        = &packets[ii];
+        packet->queue = 0;
+        if (!qos_port_index((SAI_NULL_OBJECT_ID != packet->out_port) ? packet->out_port : packet->in_port, &port)) {
+            continue;
+        }
+        if (NULL != (table = qos_port_table(&qos_ports[port], QOS_PORT_SLOT(SAI_PORT_ATTR_QOS_TC_TO_QUEUE_MAP)))) {
+            packet->queue = table->values[packet->tc];
+        }
+    }
+
+    stub_rcu_read_unlock();
+}
+
+/*
+ * Routine Description:
+ *    Create Qos Map
+ *
+ * Arguments:
+ *    [out] qos_map_id - Qos Map Id
+ *    [in] attr_count - number of attributes
+ *    [in] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_create_qos_map(_Out_ sai_object_id_t     *qos_map_id,
+                                 _In_ uint32_t               attr_count,
+                                 _In_ const sai_attribute_t *attr_list)
+{
+    static const sai_qos_map_list_t empty = { 0, NULL };
+    const sai_attribute_value_t    *type, *value;
+    const sai_qos_map_list_t       *map_list = &empty;
+    uint32_t                        type_index, list_index = 0, map;
+    qos_table_t                    *table;
+    sai_qos_map_t                  *list_copy;
+    sai_status_t                    status;
+    char                            list_str[MAX_LIST_VALUE_STR_LEN];
+    char                            key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    if (NULL == qos_map_id) {
+        STUB_LOG_ERR("NULL QoS map id param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS !=
+        (status =
+             check_attribs_metadata(attr_count, attr_list, qos_map_attribs, qos_map_vendor_attribs,
+                                    SAI_OPERATION_CREATE))) {
+        STUB_LOG_ERR("Failed attribs check\n");
+        return status;
+    }
+
+    sai_attr_list_to_str(attr_count, attr_list, qos_map_attribs, MAX_LIST_VALUE_STR_LEN, list_str);
+    STUB_LOG_NTC("Create QoS map, %s\n", list_str);
+
+    assert(SAI_STATUS_SUCCESS ==
+           find_attrib_in_list(attr_count, attr_list, SAI_QOS_MAP_ATTR_TYPE, &type, &type_index));
+    if ((type->s32 < SAI_QOS_MAP_DOT1P_TO_TC) || (type->s32 > SAI_QOS_MAP_PFC_PRIORITY_TO_QUEUE)) {
+        STUB_LOG_ERR("Invalid QoS map type %d\n", type->s32);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + type_index;
+    }
+
+    if (SAI_STATUS_SUCCESS ==
+        find_attrib_in_list(attr_count, attr_list, SAI_QOS_MAP_ATTR_MAP_TO_VALUE_LIST, &value, &list_index)) {
+        map_list = &value->qosmap;
+    }
+
+    if (SAI_STATUS_SUCCESS != (status = qos_map_compile(type->s32, map_list, &table, &list_copy))) {
+        if (SAI_STATUS_INVALID_ATTR_VALUE_0 == status) {
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + list_index;
+        }
+        return status;
+    }
+
+    pthread_rwlock_wrlock(&qos_map_db_lock);
+
+    for (map = 0; map < MAX_QOS_MAPS; map++) {
+        if (!qos_map_db[map].is_used) {
+            break;
+        }
+    }
+
+    if (MAX_QOS_MAPS == map) {
+        pthread_rwlock_unlock(&qos_map_db_lock);
+        free(table);
+        free(list_copy);
+        STUB_LOG_ERR("QoS map table full\n");
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    qos_map_db[map].is_used   = true;
+    qos_map_db[map].type      = type->s32;
+    qos_map_db[map].list      = list_copy;
+    qos_map_db[map].count     = map_list->count;
+    qos_map_db[map].ref_count = 0;
+    STUB_RCU_ASSIGN(qos_tables[map], table);
+
+    pthread_rwlock_unlock(&qos_map_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_QOS_MAPS, map, qos_map_id))) {
+        return status;
+    }
+    qos_map_key_to_str(*qos_map_id, key_str);
+    STUB_LOG_NTC("Created %s\n", key_str);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Remove Qos Map
+ *
+ * Arguments:
+ *    [in] qos_map_id - Qos Map id to be removed
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_remove_qos_map(_In_ sai_object_id_t qos_map_id)
+{
+    qos_table_t *old;
+    char         key_str[MAX_KEY_STR_LEN];
+    sai_status_t status;
+    uint32_t     map;
+
+    STUB_LOG_ENTER();
+
+    qos_map_key_to_str(qos_map_id, key_str);
+    STUB_LOG_NTC("Remove %s\n", key_str);
+
+    pthread_rwlock_wrlock(&qos_map_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = qos_map_db_index(qos_map_id, &map))) {
+        pthread_rwlock_unlock(&qos_map_db_lock);
+        return status;
+    }
+
+    if (0 != qos_map_db[map].ref_count) {
+        pthread_rwlock_unlock(&qos_map_db_lock);
+        STUB_LOG_ERR("QoS map %u is bound to %u ports\n", map, qos_map_db[map].ref_count);
+        return SAI_STATUS_OBJECT_IN_USE;
+    }
+
+    /* A frame may still hold the index of a map just unbound */
+    old = qos_tables[map];
+    STUB_RCU_ASSIGN(qos_tables[map], NULL);
+    stub_rcu_defer_free(old);
+
+    free(qos_map_db[map].list);
+    qos_map_db[map].list    = NULL;
+    qos_map_db[map].is_used = false;
+
+    pthread_rwlock_unlock(&qos_map_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Set attributes for qos map
+ *
+ * Arguments:
+ *    [in] qos_map_id - Qos Map Id
+ *    [in] attr - attribute to set
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_set_qos_map_attribute(_In_ sai_object_id_t qos_map_id, _In_ const sai_attribute_t *attr)
+{
+    const sai_object_key_t key = { .object_id = qos_map_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    qos_map_key_to_str(qos_map_id, key_str);
+    return sai_set_attribute(&key, key_str, qos_map_attribs, qos_map_vendor_attribs, attr);
+}
+
+/*
+ * Routine Description:
+ *    Get attrbutes of qos map
+ *
+ * Arguments:
+ *    [in] qos_map_id - map id
+ *    [in] attr_count - number of attributes
+ *    [inout] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_qos_map_attribute(_In_ sai_object_id_t     qos_map_id,
+                                        _In_ uint32_t            attr_count,
+                                        _Inout_ sai_attribute_t *attr_list)
+{
+    const sai_object_key_t key = { .object_id = qos_map_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
+
+    STUB_LOG_ENTER();
+
+    qos_map_key_to_str(qos_map_id, key_str);
+
+    pthread_rwlock_rdlock(&qos_map_db_lock);
+    status = sai_get_attributes(&key, key_str, qos_map_attribs, qos_map_vendor_attribs, attr_count, attr_list);
+    pthread_rwlock_unlock(&qos_map_db_lock);
+
+    return status;
+}
+
+/* Type [sai_qos_map_type_t], list [sai_qos_map_list_t] */
+sai_status_t stub_qos_map_attr_get(_In_ const sai_object_key_t   *key,
+                                   _Inout_ sai_attribute_value_t *value,
+                                   _In_ uint32_t                  attr_index,
+                                   _Inout_ vendor_cache_t        *cache,
+                                   void                          *arg)
+{
+    sai_status_t status;
+    uint32_t     map;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = qos_map_db_index(key->object_id, &map))) {
+        return status;
+    }
+
+    if (SAI_QOS_MAP_ATTR_TYPE == (long)arg) {
+        value->s32 = qos_map_db[map].type;
+    } else {
+        status = stub_fill_qosmaplist(qos_map_db[map].list, qos_map_db[map].count, &value->qosmap);
+    }
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* List [sai_qos_map_list_t], compiled into a new table the ports switch to at once */
+sai_status_t stub_qos_map_list_set(_In_ const sai_object_key_t      *key,
+                                   _In_ const sai_attribute_value_t *value,
+                                   void                             *arg)
+{
+    qos_table_t   *table, *old;
+    sai_qos_map_t *list_copy;
+    sai_status_t   status;
+    uint32_t       map;
+
+    STUB_LOG_ENTER();
+
+    pthread_rwlock_wrlock(&qos_map_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = qos_map_db_index(key->object_id, &map))) {
+        pthread_rwlock_unlock(&qos_map_db_lock);
+        return status;
+    }
+
+    if (SAI_STATUS_SUCCESS != (status = qos_map_compile(qos_map_db[map].type, &value->qosmap, &table, &list_copy))) {
+        pthread_rwlock_unlock(&qos_map_db_lock);
+        return status;
+    }
+
+    free(qos_map_db[map].list);
+    qos_map_db[map].list  = list_copy;
+    qos_map_db[map].count = value->qosmap.count;
+
+    old = qos_tables[map];
+    STUB_RCU_ASSIGN(qos_tables[map], table);
+    stub_rcu_defer_free(old);
+
+    pthread_rwlock_unlock(&qos_map_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+const sai_qos_map_api_t qos_map_api = {
+    stub_create_qos_map,
+    stub_remove_qos_map,
+    stub_set_qos_map_attribute,
+    stub_get_qos_map_attribute
+};
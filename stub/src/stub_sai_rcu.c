@@ -0,0 +1,239 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#include "sai.h"
+#include "stub_sai.h"
+#include <sched.h>
+
+#undef  __MODULE__
+#define __MODULE__ SAI_RCU
+
+/*
+ * Epoch based read-copy-update.
+ *
+ * Readers announce the global epoch they started in and never block.
+ * Writers unpublish an object, bump the global epoch and wait until every
+ * reader is either outside a read side section or started in the new epoch;
+ * after that no reader can still hold a reference and the object is freed.
+ * Frees are batched so a full table reload pays for one grace period per
+ * STUB_RCU_DEFER_BATCH objects instead of one per update.
+ */
+
+#define STUB_RCU_CACHE_LINE  64
+#define STUB_RCU_DEFER_BATCH 1024
+
+typedef struct _stub_rcu_reader_t {
+    uint64_t                   epoch;    /* 0 while outside of a read side section */
+    uint32_t                   nesting;
+    bool                       in_use;
+    struct _stub_rcu_reader_t *next;
+} __attribute__((aligned(STUB_RCU_CACHE_LINE))) stub_rcu_reader_t;
+
+typedef struct _stub_rcu_deferred_t {
+    void                        *ptr;
+    struct _stub_rcu_deferred_t *next;
+} stub_rcu_deferred_t;
+
+static uint64_t           rcu_global_epoch = 1;
+static stub_rcu_reader_t *rcu_readers;
+static pthread_mutex_t    rcu_readers_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t      rcu_reader_key;
+static pthread_once_t     rcu_reader_key_once = PTHREAD_ONCE_INIT;
+static __thread stub_rcu_reader_t *rcu_self;
+
+static stub_rcu_deferred_t *rcu_deferred;
+static uint32_t             rcu_deferred_count;
+static pthread_mutex_t      rcu_deferred_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void rcu_reader_release(void *arg)
+{
+    stub_rcu_reader_t *reader = arg;
+
+    __atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+    reader->nesting = 0;
+
+    pthread_mutex_lock(&rcu_readers_lock);
+    reader->in_use = false;
+    pthread_mutex_unlock(&rcu_readers_lock);
+}
+
+static void rcu_reader_key_create(void)
+{
+    pthread_key_create(&rcu_reader_key, rcu_reader_release);
+}
+
+static stub_rcu_reader_t* rcu_reader_get(void)
+{
+    stub_rcu_reader_t *reader;
+
+    if (NULL != rcu_self) {
+        return rcu_self;
+    }
+
+    pthread_once(&rcu_reader_key_once, rcu_reader_key_create);
+
+    pthread_mutex_lock(&rcu_readers_lock);
+
+    /* Reuse the record of a thread that already exited */
+    for (reader = rcu_readers; NULL != reader; reader = reader->next) {
+        if (!reader->in_use) {
+            break;
+        }
+    }
+
+    if (NULL == reader) {
+        if (0 != posix_memalign((void**)&reader, STUB_RCU_CACHE_LINE, sizeof(*reader))) {
+            pthread_mutex_unlock(&rcu_readers_lock);
+            STUB_LOG_ERR("Failed to allocate RCU reader record\n");
+            abort();
+        }
+        memset(reader, 0, sizeof(*reader));
+        reader->next = rcu_readers;
+        __atomic_store_n(&rcu_readers, reader, __ATOMIC_RELEASE);
+    }
+
+    reader->in_use = true;
+
+    pthread_mutex_unlock(&rcu_readers_lock);
+
+    pthread_setspecific(rcu_reader_key, reader);
+    rcu_self = reader;
+
+    return reader;
+}
+
+/*
+ * Routine Description:
+ *    Enter a read side section. Objects reached through STUB_RCU_DEREF
+ *    stay valid until the matching stub_rcu_read_unlock. Sections nest.
+ */
+void stub_rcu_read_lock(void)
+{
+    stub_rcu_reader_t *reader = rcu_reader_get();
+
+    if (0 == reader->nesting++) {
+        __atomic_store_n(&reader->epoch, __atomic_load_n(&rcu_global_epoch, __ATOMIC_ACQUIRE), __ATOMIC_RELAXED);
+        /* Announce the epoch before any protected pointer is loaded */
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    }
+}
+
+/*
+ * Routine Description:
+ *    Leave a read side section.
+ */
+void stub_rcu_read_unlock(void)
+{
+    stub_rcu_reader_t *reader = rcu_self;
+
+    STUB_ASSERT((NULL != reader) && (reader->nesting > 0));
+
+    if (0 == --reader->nesting) {
+        __atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+    }
+}
+
+/*
+ * Routine Description:
+ *    Wait for a grace period: every read side section that could have
+ *    observed an object unpublished before this call has finished.
+ *    Must not be called from inside a read side section.
+ */
+void stub_rcu_synchronize(void)
+{
+    stub_rcu_reader_t *reader;
+    uint64_t           target, epoch;
+
+    STUB_ASSERT((NULL == rcu_self) || (0 == rcu_self->nesting));
+
+    target = __atomic_add_fetch(&rcu_global_epoch, 1, __ATOMIC_SEQ_CST);
+
+    for (reader = __atomic_load_n(&rcu_readers, __ATOMIC_ACQUIRE); NULL != reader; reader = reader->next) {
+        while ((0 != (epoch = __atomic_load_n(&reader->epoch, __ATOMIC_ACQUIRE))) && (epoch < target)) {
+            sched_yield();
+        }
+    }
+}
+
+static void rcu_free_list(_In_ stub_rcu_deferred_t *list)
+{
+    stub_rcu_deferred_t *next;
+
+    for (; NULL != list; list = next) {
+        next = list->next;
+        free(list->ptr);
+        free(list);
+    }
+}
+
+/*
+ * Routine Description:
+ *    Free all objects passed to stub_rcu_defer_free so far, after a grace period.
+ */
+void stub_rcu_barrier(void)
+{
+    stub_rcu_deferred_t *list;
+
+    pthread_mutex_lock(&rcu_deferred_lock);
+    list               = rcu_deferred;
+    rcu_deferred       = NULL;
+    rcu_deferred_count = 0;
+    pthread_mutex_unlock(&rcu_deferred_lock);
+
+    if (NULL == list) {
+        return;
+    }
+
+    stub_rcu_synchronize();
+    rcu_free_list(list);
+}
+
+/*
+ * Routine Description:
+ *    Free an already unpublished object once no reader can reference it.
+ *
+ * Arguments:
+ *    [in] ptr - object allocated with malloc, may be NULL
+ */
+void stub_rcu_defer_free(_In_ void *ptr)
+{
+    stub_rcu_deferred_t *deferred;
+    bool                 flush;
+
+    if (NULL == ptr) {
+        return;
+    }
+
+    if (NULL == (deferred = malloc(sizeof(*deferred)))) {
+        /* No memory to queue it, pay for the grace period right away */
+        stub_rcu_synchronize();
+        free(ptr);
+        return;
+    }
+
+    deferred->ptr = ptr;
+
+    pthread_mutex_lock(&rcu_deferred_lock);
+    deferred->next = rcu_deferred;
+    rcu_deferred   = deferred;
+    flush          = (++rcu_deferred_count >= STUB_RCU_DEFER_BATCH);
+    pthread_mutex_unlock(&rcu_deferred_lock);
+
+    if (flush) {
+        stub_rcu_barrier();
+    }
+}
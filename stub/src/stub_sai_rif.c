@@ -102,6 +102,231 @@ static const sai_vendor_attribute_entry_t rif_vendor_attribs[] = {
       stub_rif_attrib_get, (void*)SAI_ROUTER_INTERFACE_ATTR_MTU,
       stub_rif_attrib_set, (void*)SAI_ROUTER_INTERFACE_ATTR_MTU }
 };
+
+/* State DB *************/
+#define RIF_DEFAULT_MTU 1514
+
+/* Router interface data is immutable once published, updates publish a new copy */
+typedef struct _stub_rif_t {
+    sai_object_id_t vr_id;
+    sai_int32_t     type;
+    sai_object_id_t port_id;
+    sai_vlan_id_t   vlan_id;
+    sai_mac_t       src_mac;
+    bool            admin_v4;
+    bool            admin_v6;
+    uint32_t        mtu;
+} stub_rif_t;
+
+#define MAX_RIF_NUMBER 1024
+/* Entries are published with STUB_RCU_ASSIGN, readers never lock */
+static stub_rif_t     *rif_db[MAX_RIF_NUMBER];
+static pthread_mutex_t rif_db_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Ingress classification, rif index + 1 per port and per vlan, 0 when none */
+static uint32_t        rif_by_port[PORT_NUMBER];
+static uint32_t        rif_by_vlan[VLAN_NUMBER];
+
+/* Caller holds rif_db_lock */
+static void db_set_ingress_rif(_In_ const stub_rif_t *rif, _In_ uint32_t value)
+{
+    uint32_t port_index;
+
+    if (SAI_ROUTER_INTERFACE_TYPE_VLAN == rif->type) {
+        if (rif->vlan_id < VLAN_NUMBER) {
+            __atomic_store_n(&rif_by_vlan[rif->vlan_id], value, __ATOMIC_RELEASE);
+        }
+    } else if ((SAI_STATUS_SUCCESS == stub_object_to_type(rif->port_id, SAI_OBJECT_TYPE_PORT, &port_index)) &&
+               (port_index < PORT_NUMBER)) {
+        __atomic_store_n(&rif_by_port[port_index], value, __ATOMIC_RELEASE);
+    }
+}
+
+void db_init_rif()
+{
+    uint32_t ii;
+
+    pthread_mutex_lock(&rif_db_lock);
+    for (ii = 0; ii < MAX_RIF_NUMBER; ii++) {
+        stub_rcu_defer_free(rif_db[ii]);
+        STUB_RCU_ASSIGN(rif_db[ii], NULL);
+    }
+    memset(rif_by_port, 0, sizeof(rif_by_port));
+    memset(rif_by_vlan, 0, sizeof(rif_by_vlan));
+    pthread_mutex_unlock(&rif_db_lock);
+
+    stub_rcu_barrier();
+}
+
+/* Caller must be in a read side section, the entry is valid until it leaves */
+static const stub_rif_t* db_find_rif(_In_ sai_object_id_t rif_id)
+{
+    uint32_t index;
+
+    if ((SAI_STATUS_SUCCESS != stub_object_to_type(rif_id, SAI_OBJECT_TYPE_ROUTER_INTERFACE, &index)) ||
+        (index >= MAX_RIF_NUMBER)) {
+        return NULL;
+    }
+
+    return STUB_RCU_DEREF(rif_db[index]);
+}
+
+static sai_status_t db_get_rif(_In_ sai_object_id_t     rif_id,
+                               _Inout_ vendor_cache_t *cache,
+                               _Out_ const stub_rif_t **rif)
+{
+    if (NULL == (*rif = cache->entry)) {
+        if (NULL == (*rif = db_find_rif(rif_id))) {
+            STUB_LOG_ERR("Router interface not found\n");
+            return SAI_STATUS_INVALID_OBJECT_ID;
+        }
+        cache->entry = *rif;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Copy the rif, apply the new attribute value and publish the copy */
+static sai_status_t db_update_rif(_In_ sai_object_id_t                rif_id,
+                                  _In_ sai_router_interface_attr_t    attr_id,
+                                  _In_ const sai_attribute_value_t   *value)
+{
+    stub_rif_t *old_rif, *new_rif;
+    uint32_t    index;
+
+    if ((SAI_STATUS_SUCCESS != stub_object_to_type(rif_id, SAI_OBJECT_TYPE_ROUTER_INTERFACE, &index)) ||
+        (index >= MAX_RIF_NUMBER)) {
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    if (NULL == (new_rif = malloc(sizeof(*new_rif)))) {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    pthread_mutex_lock(&rif_db_lock);
+
+    if (NULL == (old_rif = rif_db[index])) {
+        pthread_mutex_unlock(&rif_db_lock);
+        free(new_rif);
+        STUB_LOG_ERR("Router interface not found\n");
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    *new_rif = *old_rif;
+
+    switch (attr_id) {
+    case SAI_ROUTER_INTERFACE_ATTR_SRC_MAC_ADDRESS:
+        memcpy(new_rif->src_mac, value->mac, sizeof(new_rif->src_mac));
+        break;
+
+    case SAI_ROUTER_INTERFACE_ATTR_ADMIN_V4_STATE:
+        new_rif->admin_v4 = value->booldata;
+        break;
+
+    case SAI_ROUTER_INTERFACE_ATTR_ADMIN_V6_STATE:
+        new_rif->admin_v6 = value->booldata;
+        break;
+
+    case SAI_ROUTER_INTERFACE_ATTR_MTU:
+        new_rif->mtu = value->u32;
+        break;
+
+    default:
+        break;
+    }
+
+    STUB_RCU_ASSIGN(rif_db[index], new_rif);
+
+    pthread_mutex_unlock(&rif_db_lock);
+
+    stub_rcu_defer_free(old_rif);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Resolve router interface egress data. Caller must be in a read side section.
+ *
+ * Arguments:
+ *    [in] rif_id - router interface id
+ *    [out] port_id - egress port for port router interface, SAI_NULL_OBJECT_ID for vlan
+ *    [out] vlan_id - vlan for vlan router interface, 0 for port
+ *    [out] src_mac - router interface MAC
+ *    [out] admin_v4 - IPv4 admin state
+ *    [out] admin_v6 - IPv6 admin state
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    SAI_STATUS_ITEM_NOT_FOUND if the router interface does not exist
+ */
+sai_status_t db_lookup_rif(_In_ sai_object_id_t   rif_id,
+                           _Out_ sai_object_id_t *port_id,
+                           _Out_ sai_vlan_id_t   *vlan_id,
+                           _Out_ sai_mac_t        src_mac,
+                           _Out_ bool            *admin_v4,
+                           _Out_ bool            *admin_v6)
+{
+    const stub_rif_t *rif;
+
+    if (NULL == (rif = db_find_rif(rif_id))) {
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    *port_id  = rif->port_id;
+    *vlan_id  = rif->vlan_id;
+    *admin_v4 = rif->admin_v4;
+    *admin_v6 = rif->admin_v6;
+    memcpy(src_mac, rif->src_mac, sizeof(sai_mac_t));
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Find the router interface a frame arrives on. A port router interface
+ *    wins over a vlan one. Caller must be in a read side section.
+ *
+ * Arguments:
+ *    [in] port_id - ingress port
+ *    [in] vlan_id - ingress vlan
+ *    [out] rif_id - router interface id
+ *    [out] vr_id - virtual router of the interface
+ *    [out] router_mac - router interface MAC
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    SAI_STATUS_ITEM_NOT_FOUND if no router interface matches
+ */
+sai_status_t db_lookup_ingress_rif(_In_ sai_object_id_t   port_id,
+                                   _In_ sai_vlan_id_t     vlan_id,
+                                   _Out_ sai_object_id_t *rif_id,
+                                   _Out_ sai_object_id_t *vr_id,
+                                   _Out_ sai_mac_t        router_mac)
+{
+    const stub_rif_t *rif;
+    uint32_t          port_index, value = 0;
+
+    if ((SAI_STATUS_SUCCESS == stub_object_to_type(port_id, SAI_OBJECT_TYPE_PORT, &port_index)) &&
+        (port_index < PORT_NUMBER)) {
+        value = __atomic_load_n(&rif_by_port[port_index], __ATOMIC_ACQUIRE);
+    }
+
+    if ((0 == value) && (vlan_id < VLAN_NUMBER)) {
+        value = __atomic_load_n(&rif_by_vlan[vlan_id], __ATOMIC_ACQUIRE);
+    }
+
+    if ((0 == value) || (NULL == (rif = STUB_RCU_DEREF(rif_db[value - 1])))) {
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    *vr_id = rif->vr_id;
+    memcpy(router_mac, rif->src_mac, sizeof(sai_mac_t));
+
+    return stub_create_object(SAI_OBJECT_TYPE_ROUTER_INTERFACE, value - 1, rif_id);
+}
+
+/*************************/
+
 static void rif_key_to_str(_In_ sai_object_id_t rif_id, _Out_ char *key_str)
 {
     uint32_t rifid;
@@ -131,11 +356,12 @@ sai_status_t stub_create_router_interface(_Out_ sai_object_id_t* rif_id,
                                           _In_ const sai_attribute_t  *attr_list)
 {
     sai_status_t                 status;
-    const sai_attribute_value_t *type, *vrid, *port, *vlan;
+    const sai_attribute_value_t *type, *vrid, *port, *vlan, *attr;
     uint32_t                     type_index, vrid_index, port_index, vlan_index, vrid_data, port_data;
+    uint32_t                     attr_index, index;
+    stub_rif_t                  *rif;
     char                         list_str[MAX_LIST_VALUE_STR_LEN];
     char                         key_str[MAX_KEY_STR_LEN];
-    static uint32_t              next_id = 0;
 
     STUB_LOG_ENTER();
 
@@ -183,7 +409,9 @@ sai_status_t stub_create_router_interface(_Out_ sai_object_id_t* rif_id,
             STUB_LOG_ERR("Missing mandatory attribute port id on create\n");
             return SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING;
         }
-        if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(port->oid, SAI_OBJECT_TYPE_PORT, &port_data))) {
+        /* A LAG sends on the member its hash picks, see db_select_lag_member */
+        if ((SAI_OBJECT_TYPE_LAG != sai_object_type_query(port->oid)) &&
+            (SAI_STATUS_SUCCESS != (status = stub_object_to_type(port->oid, SAI_OBJECT_TYPE_PORT, &port_data)))) {
             return status;
         }
         if (SAI_STATUS_ITEM_NOT_FOUND !=
@@ -197,7 +425,64 @@ sai_status_t stub_create_router_interface(_Out_ sai_object_id_t* rif_id,
         return SAI_STATUS_INVALID_ATTR_VALUE_0 + type_index;
     }
 
-    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_ROUTER_INTERFACE, next_id++, rif_id))) {
+    if (NULL == (rif = calloc(1, sizeof(*rif)))) {
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    rif->vr_id    = vrid->oid;
+    rif->type     = type->s32;
+    rif->admin_v4 = true;
+    rif->admin_v6 = true;
+    rif->mtu      = RIF_DEFAULT_MTU;
+
+    if (SAI_ROUTER_INTERFACE_TYPE_VLAN == type->s32) {
+        rif->vlan_id = vlan->u16;
+    } else {
+        rif->port_id = port->oid;
+    }
+
+    if (SAI_STATUS_SUCCESS ==
+        find_attrib_in_list(attr_count, attr_list, SAI_ROUTER_INTERFACE_ATTR_SRC_MAC_ADDRESS, &attr, &attr_index)) {
+        memcpy(rif->src_mac, attr->mac, sizeof(rif->src_mac));
+    }
+
+    if (SAI_STATUS_SUCCESS ==
+        find_attrib_in_list(attr_count, attr_list, SAI_ROUTER_INTERFACE_ATTR_ADMIN_V4_STATE, &attr, &attr_index)) {
+        rif->admin_v4 = attr->booldata;
+    }
+
+    if (SAI_STATUS_SUCCESS ==
+        find_attrib_in_list(attr_count, attr_list, SAI_ROUTER_INTERFACE_ATTR_ADMIN_V6_STATE, &attr, &attr_index)) {
+        rif->admin_v6 = attr->booldata;
+    }
+
+    if (SAI_STATUS_SUCCESS ==
+        find_attrib_in_list(attr_count, attr_list, SAI_ROUTER_INTERFACE_ATTR_MTU, &attr, &attr_index)) {
+        rif->mtu = attr->u32;
+    }
+
+    pthread_mutex_lock(&rif_db_lock);
+
+    for (index = 0; index < MAX_RIF_NUMBER; index++) {
+        if (NULL == rif_db[index]) {
+            break;
+        }
+    }
+
+    if (MAX_RIF_NUMBER == index) {
+        pthread_mutex_unlock(&rif_db_lock);
+        free(rif);
+        STUB_LOG_ERR("Router interface table full\n");
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    STUB_RCU_ASSIGN(rif_db[index], rif);
+    db_set_ingress_rif(rif, index + 1);
+
+    pthread_mutex_unlock(&rif_db_lock);
+
+    if (SAI_STATUS_SUCCESS !=
+        (status = stub_create_object(SAI_OBJECT_TYPE_ROUTER_INTERFACE, index, rif_id))) {
         return status;
     }
     rif_key_to_str(*rif_id, key_str);
@@ -221,7 +506,8 @@ sai_status_t stub_create_router_interface(_Out_ sai_object_id_t* rif_id,
 sai_status_t stub_remove_router_interface(_In_ sai_object_id_t rif_id)
 {
     sai_status_t status;
-    uint32_t     data;
+    uint32_t     index;
+    stub_rif_t  *rif;
     char         key_str[MAX_KEY_STR_LEN];
 
     STUB_LOG_ENTER();
@@ -229,10 +515,25 @@ sai_status_t stub_remove_router_interface(_In_ sai_object_id_t rif_id)
     rif_key_to_str(rif_id, key_str);
     STUB_LOG_NTC("Remove rif %s\n", key_str);
 
-    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(rif_id, SAI_OBJECT_TYPE_ROUTER_INTERFACE, &data))) {
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(rif_id, SAI_OBJECT_TYPE_ROUTER_INTERFACE, &index))) {
         return status;
     }
 
+    pthread_mutex_lock(&rif_db_lock);
+
+    if ((index >= MAX_RIF_NUMBER) || (NULL == (rif = rif_db[index]))) {
+        pthread_mutex_unlock(&rif_db_lock);
+        STUB_LOG_ERR("Rif %s not found\n", key_str);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    STUB_RCU_ASSIGN(rif_db[index], NULL);
+    db_set_ingress_rif(rif, 0);
+
+    pthread_mutex_unlock(&rif_db_lock);
+
+    stub_rcu_defer_free(rif);
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -279,18 +580,23 @@ sai_status_t stub_get_router_interface_attribute(_In_ sai_object_id_t     rif_id
 {
     const sai_object_key_t key = { .object_id = rif_id };
     char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
 
     STUB_LOG_ENTER();
 
     rif_key_to_str(rif_id, key_str);
-    return sai_get_attributes(&key, key_str, rif_attribs, rif_vendor_attribs, attr_count, attr_list);
+
+    stub_rcu_read_lock();
+    status = sai_get_attributes(&key, key_str, rif_attribs, rif_vendor_attribs, attr_count, attr_list);
+    stub_rcu_read_unlock();
+
+    return status;
 }
 
 /* MAC Address [sai_mac_t] */
 /* MTU [uint32_t] */
 sai_status_t stub_rif_attrib_set(_In_ const sai_object_key_t *key, _In_ const sai_attribute_value_t *value, void *arg)
 {
-    uint32_t     data;
     sai_status_t status;
 
     STUB_LOG_ENTER();
@@ -298,8 +604,7 @@ sai_status_t stub_rif_attrib_set(_In_ const sai_object_key_t *key, _In_ const sa
     assert((SAI_ROUTER_INTERFACE_ATTR_MTU == (int64_t)arg) ||
            (SAI_ROUTER_INTERFACE_ATTR_SRC_MAC_ADDRESS == (int64_t)arg));
 
-    if (SAI_STATUS_SUCCESS !=
-        (status = stub_object_to_type(key->object_id, SAI_OBJECT_TYPE_ROUTER_INTERFACE, &data))) {
+    if (SAI_STATUS_SUCCESS != (status = db_update_rif(key->object_id, (int64_t)arg, value))) {
         return status;
     }
 
@@ -311,15 +616,13 @@ sai_status_t stub_rif_attrib_set(_In_ const sai_object_key_t *key, _In_ const sa
 sai_status_t stub_rif_admin_set(_In_ const sai_object_key_t *key, _In_ const sai_attribute_value_t *value, void *arg)
 {
     sai_status_t status;
-    uint32_t     data;
 
     STUB_LOG_ENTER();
 
     assert((SAI_ROUTER_INTERFACE_ATTR_ADMIN_V4_STATE == (int64_t)arg) ||
            (SAI_ROUTER_INTERFACE_ATTR_ADMIN_V6_STATE == (int64_t)arg));
 
-    if (SAI_STATUS_SUCCESS !=
-        (status = stub_object_to_type(key->object_id, SAI_OBJECT_TYPE_ROUTER_INTERFACE, &data))) {
+    if (SAI_STATUS_SUCCESS != (status = db_update_rif(key->object_id, (int64_t)arg, value))) {
         return status;
     }
 
@@ -339,8 +642,8 @@ sai_status_t stub_rif_attrib_get(_In_ const sai_object_key_t   *key,
                                  _Inout_ vendor_cache_t        *cache,
                                  void                          *arg)
 {
-    sai_status_t status;
-    uint32_t     data;
+    const stub_rif_t *rif;
+    sai_status_t      status;
 
     STUB_LOG_ENTER();
 
@@ -350,38 +653,33 @@ sai_status_t stub_rif_attrib_get(_In_ const sai_object_key_t   *key,
            (SAI_ROUTER_INTERFACE_ATTR_SRC_MAC_ADDRESS == (int64_t)arg) ||
            (SAI_ROUTER_INTERFACE_ATTR_MTU == (int64_t)arg));
 
-    if (SAI_STATUS_SUCCESS !=
-        (status = stub_object_to_type(key->object_id, SAI_OBJECT_TYPE_ROUTER_INTERFACE, &data))) {
+    if (SAI_STATUS_SUCCESS != (status = db_get_rif(key->object_id, cache, &rif))) {
         return status;
     }
 
     switch ((int64_t)arg) {
     case SAI_ROUTER_INTERFACE_ATTR_PORT_ID:
-        if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_PORT, 0, &value->oid))) {
-            return status;
-        }
+        value->oid = rif->port_id;
         break;
 
     case SAI_ROUTER_INTERFACE_ATTR_VLAN_ID:
-        value->u16 = 1;
+        value->u16 = rif->vlan_id;
         break;
 
     case SAI_ROUTER_INTERFACE_ATTR_MTU:
-        value->u32 = 1514;
+        value->u32 = rif->mtu;
         break;
 
     case SAI_ROUTER_INTERFACE_ATTR_SRC_MAC_ADDRESS:
+        memcpy(value->mac, rif->src_mac, sizeof(value->mac));
         break;
 
     case SAI_ROUTER_INTERFACE_ATTR_TYPE:
-        value->s32 = SAI_ROUTER_INTERFACE_TYPE_PORT;
+        value->s32 = rif->type;
         break;
 
     case SAI_ROUTER_INTERFACE_ATTR_VIRTUAL_ROUTER_ID:
-        if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_VIRTUAL_ROUTER,
-                                                               0, &value->oid))) {
-            return status;
-        }
+        value->oid = rif->vr_id;
         break;
     }
 
@@ -396,20 +694,19 @@ sai_status_t stub_rif_admin_get(_In_ const sai_object_key_t   *key,
                                 _Inout_ vendor_cache_t        *cache,
                                 void                          *arg)
 {
-    sai_status_t status;
-    uint32_t     data;
+    const stub_rif_t *rif;
+    sai_status_t      status;
 
     STUB_LOG_ENTER();
 
     assert((SAI_ROUTER_INTERFACE_ATTR_ADMIN_V4_STATE == (int64_t)arg) ||
            (SAI_ROUTER_INTERFACE_ATTR_ADMIN_V6_STATE == (int64_t)arg));
 
-    if (SAI_STATUS_SUCCESS !=
-        (status = stub_object_to_type(key->object_id, SAI_OBJECT_TYPE_ROUTER_INTERFACE, &data))) {
+    if (SAI_STATUS_SUCCESS != (status = db_get_rif(key->object_id, cache, &rif))) {
         return status;
     }
 
-    value->booldata = true;
+    value->booldata = (SAI_ROUTER_INTERFACE_ATTR_ADMIN_V4_STATE == (int64_t)arg) ? rif->admin_v4 : rif->admin_v6;
 
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
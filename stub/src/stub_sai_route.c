@@ -74,6 +74,542 @@ static const sai_vendor_attribute_entry_t route_vendor_attribs[] = {
       stub_route_next_hop_id_get, NULL,
       stub_route_next_hop_id_set, NULL },
 };
+/* State DB *************/
+#define ROUTE_TRIE_STRIDE      4
+#define ROUTE_TRIE_FANOUT      (1 << ROUTE_TRIE_STRIDE)
+#define ROUTE_TRIE_MAX_DEPTH   (128 / ROUTE_TRIE_STRIDE)
+#define ROUTE_FAMILY_IPV4      0
+#define ROUTE_FAMILY_IPV6      1
+#define ROUTE_FAMILY_NUMBER    2
+
+/* Route data is immutable once published, updates publish a new copy */
+typedef struct _stub_route_t {
+    sai_unicast_route_entry_t entry;
+    sai_int32_t               packet_action;
+    sai_uint8_t               trap_priority;
+    sai_object_id_t           next_hop_id;
+} stub_route_t;
+
+/*
+ * Multibit trie node. A node at depth d holds the prefixes with length in
+ * [d * STRIDE, (d + 1) * STRIDE); a prefix with r extra bits b is stored
+ * in route[(1 << r) - 1 + b]. Longer prefixes continue in child[nibble].
+ * Readers only follow child/route pointers, writers change them atomically.
+ */
+typedef struct _stub_route_node_t {
+    struct _stub_route_node_t *child[ROUTE_TRIE_FANOUT];
+    stub_route_t              *route[ROUTE_TRIE_FANOUT - 1];
+    uint32_t                   used;    /* children + routes, writer only */
+} stub_route_node_t;
+
+typedef struct _stub_route_table_t {
+    sai_object_id_t             vr_id;
+    stub_route_node_t          *root[ROUTE_FAMILY_NUMBER];
+    uint32_t                    route_count;
+    struct _stub_route_table_t *next;
+} stub_route_table_t;
+
+typedef struct _stub_route_key_t {
+    uint8_t  addr[16];
+    uint32_t prefix_len;
+    uint32_t family;
+} stub_route_key_t;
+
+/* One table per virtual router, readers walk it under stub_rcu_read_lock */
+static stub_route_table_t *route_tables;
+/* Serializes writers, readers never take it */
+static pthread_mutex_t     route_db_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static inline uint32_t route_key_nibble(_In_ const uint8_t *addr, _In_ uint32_t index)
+{
+    return (addr[index >> 1] >> ((index & 1) ? 0 : 4)) & 0xF;
+}
+
+static uint32_t route_mask_len(_In_ const uint8_t *mask, _In_ uint32_t size, _Out_ bool *contiguous)
+{
+    uint32_t ii, len = 0;
+    bool     hole = false;
+
+    *contiguous = true;
+
+    for (ii = 0; ii < size * 8; ii++) {
+        if (mask[ii >> 3] & (0x80 >> (ii & 7))) {
+            if (hole) {
+                *contiguous = false;
+            }
+            len++;
+        } else {
+            hole = true;
+        }
+    }
+
+    return len;
+}
+
+static sai_status_t route_prefix_to_key(_In_ const sai_ip_prefix_t *prefix, _Out_ stub_route_key_t *key)
+{
+    const uint8_t *addr, *mask;
+    uint32_t       size, ii;
+    bool           contiguous;
+
+    memset(key, 0, sizeof(*key));
+
+    if (SAI_IP_ADDR_FAMILY_IPV4 == prefix->addr_family) {
+        addr        = (const uint8_t*)&prefix->addr.ip4;
+        mask        = (const uint8_t*)&prefix->mask.ip4;
+        size        = sizeof(sai_ip4_t);
+        key->family = ROUTE_FAMILY_IPV4;
+    } else if (SAI_IP_ADDR_FAMILY_IPV6 == prefix->addr_family) {
+        addr        = prefix->addr.ip6;
+        mask        = prefix->mask.ip6;
+        size        = sizeof(sai_ip6_t);
+        key->family = ROUTE_FAMILY_IPV6;
+    } else {
+        STUB_LOG_ERR("Invalid route address family %d\n", prefix->addr_family);
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    key->prefix_len = route_mask_len(mask, size, &contiguous);
+    if (!contiguous) {
+        STUB_LOG_ERR("Route mask is not contiguous\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    /* Host bits are ignored, 10.0.0.1/8 and 10.0.0.0/8 are the same route */
+    for (ii = 0; ii < size; ii++) {
+        key->addr[ii] = addr[ii] & mask[ii];
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static inline uint32_t route_slot(_In_ const stub_route_key_t *key)
+{
+    uint32_t extra = key->prefix_len % ROUTE_TRIE_STRIDE;
+
+    if (0 == extra) {
+        return 0;
+    }
+
+    return (1 << extra) - 1 +
+           (route_key_nibble(key->addr, key->prefix_len / ROUTE_TRIE_STRIDE) >> (ROUTE_TRIE_STRIDE - extra));
+}
+
+static stub_route_table_t* db_find_route_table(_In_ sai_object_id_t vr_id)
+{
+    stub_route_table_t *table;
+
+    for (table = STUB_RCU_DEREF(route_tables); NULL != table; table = STUB_RCU_DEREF(table->next)) {
+        if (table->vr_id == vr_id) {
+            return table;
+        }
+    }
+
+    return NULL;
+}
+
+/* Caller holds route_db_lock */
+static stub_route_table_t* db_get_or_create_route_table(_In_ sai_object_id_t vr_id)
+{
+    stub_route_table_t *table;
+    uint32_t            ii;
+
+    if (NULL != (table = db_find_route_table(vr_id))) {
+        return table;
+    }
+
+    if (NULL == (table = calloc(1, sizeof(*table)))) {
+        return NULL;
+    }
+
+    for (ii = 0; ii < ROUTE_FAMILY_NUMBER; ii++) {
+        if (NULL == (table->root[ii] = calloc(1, sizeof(stub_route_node_t)))) {
+            free(table->root[0]);
+            free(table);
+            return NULL;
+        }
+    }
+
+    table->vr_id = vr_id;
+    table->next  = route_tables;
+    STUB_RCU_ASSIGN(route_tables, table);
+
+    return table;
+}
+
+/*
+ * Exact match lookup. Returns the slot holding the route, the route itself is
+ * read with STUB_RCU_DEREF. Readers call it under stub_rcu_read_lock,
+ * writers under route_db_lock.
+ */
+static stub_route_t** db_find_route_slot(_In_ const sai_unicast_route_entry_t *route_entry)
+{
+    stub_route_table_t *table;
+    stub_route_node_t  *node;
+    stub_route_key_t    key;
+    uint32_t            ii;
+
+    if (SAI_STATUS_SUCCESS != route_prefix_to_key(&route_entry->destination, &key)) {
+        return NULL;
+    }
+
+    if (NULL == (table = db_find_route_table(route_entry->vr_id))) {
+        return NULL;
+    }
+
+    node = table->root[key.family];
+    for (ii = 0; (ii < key.prefix_len / ROUTE_TRIE_STRIDE) && (NULL != node); ii++) {
+        node = STUB_RCU_DEREF(node->child[route_key_nibble(key.addr, ii)]);
+    }
+
+    if (NULL == node) {
+        return NULL;
+    }
+
+    return &node->route[route_slot(&key)];
+}
+
+static sai_status_t db_get_route(_In_ const sai_unicast_route_entry_t *route_entry,
+                                 _Inout_ vendor_cache_t              *cache,
+                                 _Out_ const stub_route_t           **route)
+{
+    stub_route_t **slot;
+
+    if (NULL == cache->entry) {
+        if ((NULL == (slot = db_find_route_slot(route_entry))) ||
+            (NULL == (cache->entry = STUB_RCU_DEREF(*slot)))) {
+            STUB_LOG_ERR("Route not found\n");
+            return SAI_STATUS_ITEM_NOT_FOUND;
+        }
+    }
+
+    *route = cache->entry;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t db_create_route(_In_ const sai_unicast_route_entry_t *route_entry,
+                                    _In_ const stub_route_t              *data)
+{
+    stub_route_table_t *table;
+    stub_route_node_t  *node, *child;
+    stub_route_t       *route;
+    stub_route_key_t    key;
+    sai_status_t        status;
+    uint32_t            ii, nibble, slot;
+
+    if (SAI_STATUS_SUCCESS != (status = route_prefix_to_key(&route_entry->destination, &key))) {
+        return status;
+    }
+
+    if (NULL == (route = malloc(sizeof(*route)))) {
+        return SAI_STATUS_NO_MEMORY;
+    }
+    *route = *data;
+
+    pthread_mutex_lock(&route_db_lock);
+
+    if (NULL == (table = db_get_or_create_route_table(route_entry->vr_id))) {
+        pthread_mutex_unlock(&route_db_lock);
+        free(route);
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    slot = route_slot(&key);
+    node = table->root[key.family];
+    for (ii = 0; ii < key.prefix_len / ROUTE_TRIE_STRIDE; ii++) {
+        nibble = route_key_nibble(key.addr, ii);
+        if (NULL == (child = node->child[nibble])) {
+            if (NULL == (child = calloc(1, sizeof(*child)))) {
+                pthread_mutex_unlock(&route_db_lock);
+                free(route);
+                return SAI_STATUS_NO_MEMORY;
+            }
+            node->used++;
+            STUB_RCU_ASSIGN(node->child[nibble], child);
+        }
+        node = child;
+    }
+
+    if (NULL != node->route[slot]) {
+        pthread_mutex_unlock(&route_db_lock);
+        free(route);
+        STUB_LOG_ERR("Route already exists\n");
+        return SAI_STATUS_ITEM_ALREADY_EXISTS;
+    }
+
+    node->used++;
+    table->route_count++;
+    STUB_RCU_ASSIGN(node->route[slot], route);
+
+    pthread_mutex_unlock(&route_db_lock);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t db_remove_route(_In_ const sai_unicast_route_entry_t *route_entry)
+{
+    stub_route_table_t *table;
+    stub_route_node_t  *path[ROUTE_TRIE_MAX_DEPTH + 1];
+    stub_route_node_t  *node;
+    stub_route_t       *route;
+    stub_route_key_t    key;
+    sai_status_t        status;
+    uint32_t            depth, ii, slot;
+
+    if (SAI_STATUS_SUCCESS != (status = route_prefix_to_key(&route_entry->destination, &key))) {
+        return status;
+    }
+
+    pthread_mutex_lock(&route_db_lock);
+
+    if (NULL == (table = db_find_route_table(route_entry->vr_id))) {
+        pthread_mutex_unlock(&route_db_lock);
+        STUB_LOG_ERR("Route not found\n");
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    depth   = key.prefix_len / ROUTE_TRIE_STRIDE;
+    node    = table->root[key.family];
+    path[0] = node;
+    for (ii = 0; (ii < depth) && (NULL != node); ii++) {
+        node        = node->child[route_key_nibble(key.addr, ii)];
+        path[ii + 1] = node;
+    }
+
+    slot = route_slot(&key);
+    if ((NULL == node) || (NULL == (route = node->route[slot]))) {
+        pthread_mutex_unlock(&route_db_lock);
+        STUB_LOG_ERR("Route not found\n");
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    STUB_RCU_ASSIGN(node->route[slot], NULL);
+    node->used--;
+    table->route_count--;
+
+    /* Prune the nodes left empty, the root always stays */
+    for (ii = depth; (ii > 0) && (0 == path[ii]->used); ii--) {
+        STUB_RCU_ASSIGN(path[ii - 1]->child[route_key_nibble(key.addr, ii - 1)], NULL);
+        path[ii - 1]->used--;
+        stub_rcu_defer_free(path[ii]);
+    }
+
+    pthread_mutex_unlock(&route_db_lock);
+
+    stub_rcu_defer_free(route);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Copy the route, apply the new attribute value and publish the copy. Caller holds route_db_lock */
+static sai_status_t db_update_route(_In_ const sai_unicast_route_entry_t *route_entry,
+                                    _In_ sai_route_attr_t                 attr_id,
+                                    _In_ const sai_attribute_value_t     *value)
+{
+    stub_route_t **slot;
+    stub_route_t  *old_route, *new_route;
+
+    if ((NULL == (slot = db_find_route_slot(route_entry))) || (NULL == (old_route = *slot))) {
+        STUB_LOG_ERR("Route not found\n");
+        return SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    if (NULL == (new_route = malloc(sizeof(*new_route)))) {
+        return SAI_STATUS_NO_MEMORY;
+    }
+    *new_route = *old_route;
+
+    switch (attr_id) {
+    case SAI_ROUTE_ATTR_PACKET_ACTION:
+        new_route->packet_action = value->s32;
+        break;
+
+    case SAI_ROUTE_ATTR_TRAP_PRIORITY:
+        new_route->trap_priority = value->u8;
+        break;
+
+    case SAI_ROUTE_ATTR_NEXT_HOP_ID:
+        new_route->next_hop_id = value->oid;
+        break;
+
+    default:
+        free(new_route);
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    STUB_RCU_ASSIGN(*slot, new_route);
+    stub_rcu_defer_free(old_route);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+#define ROUTE_LOOKUP_BATCH 16
+
+static void db_lookup_route_batch(_In_ const stub_route_table_t *table,
+                                  _In_ uint32_t                  count,
+                                  _In_ const sai_ip_address_t   *dst_ip,
+                                  _Out_ sai_status_t            *status,
+                                  _Out_ sai_int32_t             *packet_action,
+                                  _Out_ sai_object_id_t         *next_hop_id)
+{
+    const stub_route_node_t *node[ROUTE_LOOKUP_BATCH];
+    const stub_route_t      *best[ROUTE_LOOKUP_BATCH];
+    const stub_route_t      *route;
+    uint8_t                  addr[ROUTE_LOOKUP_BATCH][16];
+    uint32_t                 max_depth[ROUTE_LOOKUP_BATCH];
+    uint32_t                 ii, depth, extra, nibble, active;
+
+    memset(addr, 0, sizeof(addr));
+
+    for (ii = 0; ii < count; ii++) {
+        best[ii] = NULL;
+        node[ii] = NULL;
+
+        if (SAI_IP_ADDR_FAMILY_IPV4 == dst_ip[ii].addr_family) {
+            memcpy(addr[ii], &dst_ip[ii].addr.ip4, sizeof(sai_ip4_t));
+            max_depth[ii] = 32 / ROUTE_TRIE_STRIDE;
+            node[ii]      = table ? table->root[ROUTE_FAMILY_IPV4] : NULL;
+        } else if (SAI_IP_ADDR_FAMILY_IPV6 == dst_ip[ii].addr_family) {
+            memcpy(addr[ii], dst_ip[ii].addr.ip6, sizeof(sai_ip6_t));
+            max_depth[ii] = 128 / ROUTE_TRIE_STRIDE;
+            node[ii]      = table ? table->root[ROUTE_FAMILY_IPV6] : NULL;
+        }
+    }
+
+    /* All walks advance one level per round, the next level of every walk is
+     * prefetched before any of them is dereferenced so the misses overlap */
+    for (depth = 0, active = count; active > 0; depth++) {
+        active = 0;
+
+        for (ii = 0; ii < count; ii++) {
+            if (NULL == node[ii]) {
+                continue;
+            }
+
+            /* Full length prefixes live alone in the last level */
+            if (depth == max_depth[ii]) {
+                if (NULL != (route = STUB_RCU_DEREF(node[ii]->route[0]))) {
+                    best[ii] = route;
+                }
+                node[ii] = NULL;
+                continue;
+            }
+
+            nibble = route_key_nibble(addr[ii], depth);
+
+            /* Longest prefix within the node first */
+            for (extra = ROUTE_TRIE_STRIDE; extra-- > 0;) {
+                route = STUB_RCU_DEREF(node[ii]->route[(1 << extra) - 1 + (nibble >> (ROUTE_TRIE_STRIDE - extra))]);
+                if (NULL != route) {
+                    best[ii] = route;
+                    break;
+                }
+            }
+
+            if (NULL != (node[ii] = STUB_RCU_DEREF(node[ii]->child[nibble]))) {
+                __builtin_prefetch(node[ii]);
+                active++;
+            }
+        }
+    }
+
+    for (ii = 0; ii < count; ii++) {
+        if (NULL == best[ii]) {
+            status[ii] = SAI_STATUS_ITEM_NOT_FOUND;
+            continue;
+        }
+
+        status[ii]        = SAI_STATUS_SUCCESS;
+        packet_action[ii] = best[ii]->packet_action;
+        next_hop_id[ii]   = best[ii]->next_hop_id;
+    }
+}
+
+/*
+ * Routine Description:
+ *    Longest prefix match of several destinations in one virtual router.
+ *    Caller must be in a read side section.
+ *
+ * Arguments:
+ *    [in] vr_id - virtual router id
+ *    [in] count - number of destinations
+ *    [in] dst_ip - destination addresses
+ *    [out] status - per destination SAI_STATUS_SUCCESS or SAI_STATUS_ITEM_NOT_FOUND
+ *    [out] packet_action - action of the matched route
+ *    [out] next_hop_id - next hop, next hop group or router interface of the matched route
+ */
+void db_lookup_route_bulk(_In_ sai_object_id_t         vr_id,
+                          _In_ uint32_t                count,
+                          _In_ const sai_ip_address_t *dst_ip,
+                          _Out_ sai_status_t          *status,
+                          _Out_ sai_int32_t           *packet_action,
+                          _Out_ sai_object_id_t       *next_hop_id)
+{
+    const stub_route_table_t *table = db_find_route_table(vr_id);
+    uint32_t                  ii, batch;
+
+    for (ii = 0; ii < count; ii += batch) {
+        batch = (count - ii < ROUTE_LOOKUP_BATCH) ? count - ii : ROUTE_LOOKUP_BATCH;
+        db_lookup_route_batch(table, batch, dst_ip + ii, status + ii, packet_action + ii, next_hop_id + ii);
+    }
+}
+
+static void db_free_route_node(_In_ stub_route_node_t *node)
+{
+    uint32_t ii;
+
+    for (ii = 0; ii < ROUTE_TRIE_FANOUT; ii++) {
+        if (NULL != node->child[ii]) {
+            db_free_route_node(node->child[ii]);
+        }
+        if ((ii < ROUTE_TRIE_FANOUT - 1) && (NULL != node->route[ii])) {
+            free(node->route[ii]);
+        }
+    }
+
+    free(node);
+}
+
+void db_init_route()
+{
+    stub_route_table_t *table, *next;
+    uint32_t            ii;
+
+    pthread_mutex_lock(&route_db_lock);
+
+    table = route_tables;
+    STUB_RCU_ASSIGN(route_tables, NULL);
+    stub_rcu_synchronize();
+
+    for (; NULL != table; table = next) {
+        next = table->next;
+        for (ii = 0; ii < ROUTE_FAMILY_NUMBER; ii++) {
+            db_free_route_node(table->root[ii]);
+        }
+        free(table);
+    }
+
+    pthread_mutex_unlock(&route_db_lock);
+}
+
+static sai_status_t validate_route_next_hop(_In_ sai_object_id_t next_hop_id, _In_ uint32_t param_index)
+{
+    sai_object_type_t type = sai_object_type_query(next_hop_id);
+
+    if ((SAI_NULL_OBJECT_ID != next_hop_id) &&
+        (SAI_OBJECT_TYPE_NEXT_HOP != type) &&
+        (SAI_OBJECT_TYPE_NEXT_HOP_GROUP != type) &&
+        (SAI_OBJECT_TYPE_ROUTER_INTERFACE != type)) {
+        STUB_LOG_ERR("Invalid route next hop object type %s\n", SAI_TYPE_STR(type));
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + param_index;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*************************/
+
 static void route_key_to_str(_In_ const sai_unicast_route_entry_t* unicast_route_entry, _Out_ char *key_str)
 {
     int res;
@@ -102,9 +638,12 @@ sai_status_t stub_create_route(_In_ const sai_unicast_route_entry_t* unicast_rou
                                _In_ uint32_t                         attr_count,
                                _In_ const sai_attribute_t           *attr_list)
 {
-    sai_status_t status;
-    char         list_str[MAX_LIST_VALUE_STR_LEN];
-    char         key_str[MAX_KEY_STR_LEN];
+    sai_status_t                 status;
+    const sai_attribute_value_t *action, *priority, *next_hop;
+    uint32_t                     action_index, priority_index, next_hop_index, vr_data;
+    stub_route_t                 route;
+    char                         list_str[MAX_LIST_VALUE_STR_LEN];
+    char                         key_str[MAX_KEY_STR_LEN];
 
     STUB_LOG_ENTER();
 
@@ -126,6 +665,37 @@ sai_status_t stub_create_route(_In_ const sai_unicast_route_entry_t* unicast_rou
     STUB_LOG_NTC("Create route %s\n", key_str);
     STUB_LOG_NTC("Attribs %s\n", list_str);
 
+    if (SAI_STATUS_SUCCESS !=
+        (status = stub_object_to_type(unicast_route_entry->vr_id, SAI_OBJECT_TYPE_VIRTUAL_ROUTER, &vr_data))) {
+        return status;
+    }
+
+    memset(&route, 0, sizeof(route));
+    route.entry         = *unicast_route_entry;
+    route.packet_action = SAI_PACKET_ACTION_FORWARD;
+
+    if (SAI_STATUS_SUCCESS ==
+        find_attrib_in_list(attr_count, attr_list, SAI_ROUTE_ATTR_PACKET_ACTION, &action, &action_index)) {
+        route.packet_action = action->s32;
+    }
+
+    if (SAI_STATUS_SUCCESS ==
+        find_attrib_in_list(attr_count, attr_list, SAI_ROUTE_ATTR_TRAP_PRIORITY, &priority, &priority_index)) {
+        route.trap_priority = priority->u8;
+    }
+
+    if (SAI_STATUS_SUCCESS ==
+        find_attrib_in_list(attr_count, attr_list, SAI_ROUTE_ATTR_NEXT_HOP_ID, &next_hop, &next_hop_index)) {
+        if (SAI_STATUS_SUCCESS != (status = validate_route_next_hop(next_hop->oid, next_hop_index))) {
+            return status;
+        }
+        route.next_hop_id = next_hop->oid;
+    }
+
+    if (SAI_STATUS_SUCCESS != (status = db_create_route(unicast_route_entry, &route))) {
+        return status;
+    }
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -145,7 +715,8 @@ sai_status_t stub_create_route(_In_ const sai_unicast_route_entry_t* unicast_rou
  */
 sai_status_t stub_remove_route(_In_ const sai_unicast_route_entry_t* unicast_route_entry)
 {
-    char key_str[MAX_KEY_STR_LEN];
+    char         key_str[MAX_KEY_STR_LEN];
+    sai_status_t status;
 
     STUB_LOG_ENTER();
 
@@ -157,6 +728,10 @@ sai_status_t stub_remove_route(_In_ const sai_unicast_route_entry_t* unicast_rou
     route_key_to_str(unicast_route_entry, key_str);
     STUB_LOG_NTC("Remove route %s\n", key_str);
 
+    if (SAI_STATUS_SUCCESS != (status = db_remove_route(unicast_route_entry))) {
+        return status;
+    }
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -178,6 +753,7 @@ sai_status_t stub_set_route_attribute(_In_ const sai_unicast_route_entry_t* unic
 {
     const sai_object_key_t key = { .unicast_route_entry = unicast_route_entry };
     char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
 
     STUB_LOG_ENTER();
 
@@ -187,7 +763,12 @@ sai_status_t stub_set_route_attribute(_In_ const sai_unicast_route_entry_t* unic
     }
 
     route_key_to_str(unicast_route_entry, key_str);
-    return sai_set_attribute(&key, key_str, route_attribs, route_vendor_attribs, attr);
+
+    pthread_mutex_lock(&route_db_lock);
+    status = sai_set_attribute(&key, key_str, route_attribs, route_vendor_attribs, attr);
+    pthread_mutex_unlock(&route_db_lock);
+
+    return status;
 }
 
 /*
@@ -209,6 +790,7 @@ sai_status_t stub_get_route_attribute(_In_ const sai_unicast_route_entry_t* unic
 {
     const sai_object_key_t key = { .unicast_route_entry = unicast_route_entry };
     char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
 
     STUB_LOG_ENTER();
 
@@ -218,7 +800,13 @@ sai_status_t stub_get_route_attribute(_In_ const sai_unicast_route_entry_t* unic
     }
 
     route_key_to_str(unicast_route_entry, key_str);
-    return sai_get_attributes(&key, key_str, route_attribs, route_vendor_attribs, attr_count, attr_list);
+
+    /* Lock-free read, never waits for route programming */
+    stub_rcu_read_lock();
+    status = sai_get_attributes(&key, key_str, route_attribs, route_vendor_attribs, attr_count, attr_list);
+    stub_rcu_read_unlock();
+
+    return status;
 }
 
 /* Packet action [sai_packet_action_t] */
@@ -228,9 +816,16 @@ sai_status_t stub_route_packet_action_get(_In_ const sai_object_key_t   *key,
                                           _Inout_ vendor_cache_t        *cache,
                                           void                          *arg)
 {
+    const stub_route_t *route;
+    sai_status_t        status;
+
     STUB_LOG_ENTER();
 
-    value->s32 = SAI_PACKET_ACTION_DROP;
+    if (SAI_STATUS_SUCCESS != (status = db_get_route(key->unicast_route_entry, cache, &route))) {
+        return status;
+    }
+
+    value->s32 = route->packet_action;
 
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
@@ -243,9 +838,16 @@ sai_status_t stub_route_trap_priority_get(_In_ const sai_object_key_t   *key,
                                           _Inout_ vendor_cache_t        *cache,
                                           void                          *arg)
 {
+    const stub_route_t *route;
+    sai_status_t        status;
+
     STUB_LOG_ENTER();
 
-    value->u8 = 0;
+    if (SAI_STATUS_SUCCESS != (status = db_get_route(key->unicast_route_entry, cache, &route))) {
+        return status;
+    }
+
+    value->u8 = route->trap_priority;
 
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
@@ -260,14 +862,17 @@ sai_status_t stub_route_next_hop_id_get(_In_ const sai_object_key_t   *key,
                                         _Inout_ vendor_cache_t        *cache,
                                         void                          *arg)
 {
-    sai_status_t status;
+    const stub_route_t *route;
+    sai_status_t        status;
 
     STUB_LOG_ENTER();
 
-    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_NEXT_HOP, 0, &value->oid))) {
+    if (SAI_STATUS_SUCCESS != (status = db_get_route(key->unicast_route_entry, cache, &route))) {
         return status;
     }
 
+    value->oid = route->next_hop_id;
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -277,8 +882,14 @@ sai_status_t stub_route_packet_action_set(_In_ const sai_object_key_t      *key,
                                           _In_ const sai_attribute_value_t *value,
                                           void                             *arg)
 {
+    sai_status_t status;
+
     STUB_LOG_ENTER();
 
+    if (SAI_STATUS_SUCCESS != (status = db_update_route(key->unicast_route_entry, SAI_ROUTE_ATTR_PACKET_ACTION, value))) {
+        return status;
+    }
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -288,8 +899,14 @@ sai_status_t stub_route_trap_priority_set(_In_ const sai_object_key_t      *key,
                                           _In_ const sai_attribute_value_t *value,
                                           void                             *arg)
 {
+    sai_status_t status;
+
     STUB_LOG_ENTER();
 
+    if (SAI_STATUS_SUCCESS != (status = db_update_route(key->unicast_route_entry, SAI_ROUTE_ATTR_TRAP_PRIORITY, value))) {
+        return status;
+    }
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -301,8 +918,18 @@ sai_status_t stub_route_next_hop_id_set(_In_ const sai_object_key_t      *key,
                                         _In_ const sai_attribute_value_t *value,
                                         void                             *arg)
 {
+    sai_status_t status;
+
     STUB_LOG_ENTER();
 
+    if (SAI_STATUS_SUCCESS != (status = validate_route_next_hop(value->oid, 0))) {
+        return status;
+    }
+
+    if (SAI_STATUS_SUCCESS != (status = db_update_route(key->unicast_route_entry, SAI_ROUTE_ATTR_NEXT_HOP_ID, value))) {
+        return status;
+    }
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -322,7 +322,8 @@ sai_status_t stub_create_virtual_router(_Out_ sai_object_id_t      *vr_id,
     sai_attr_list_to_str(attr_count, attr_list, router_attribs, MAX_LIST_VALUE_STR_LEN, list_str);
     STUB_LOG_NTC("Create router, %s\n", list_str);
 
-    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_VIRTUAL_ROUTER, next_id++, vr_id))) {
+    if (SAI_STATUS_SUCCESS !=
+        (status = stub_create_object(SAI_OBJECT_TYPE_VIRTUAL_ROUTER, stub_alloc_object_index(&next_id), vr_id))) {
         return status;
     }
     router_key_to_str(*vr_id, key_str);
@@ -0,0 +1,2285 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#include "sai.h"
+#include "stub_sai.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_qos_map.h"
+#include "stub_sai_scheduler.h"
+#include "stub_sai_wred.h"
+#include "assert.h"
+#include <inttypes.h>
+
+#undef  __MODULE__
+#define __MODULE__ SAI_SCHEDULER
+
+static const sai_attribute_entry_t scheduler_attribs[] = {
+    { SAI_SCHEDULER_ATTR_SCHEDULING_ALGORITHM, false, true, true, true,
+      "Scheduler algorithm", SAI_ATTR_VAL_TYPE_S32 },
+    { SAI_SCHEDULER_ATTR_SCHEDULING_WEIGHT, false, true, true, true,
+      "Scheduler weight", SAI_ATTR_VAL_TYPE_U8 },
+    { SAI_SCHEDULER_ATTR_SHAPER_TYPE, false, true, true, true,
+      "Scheduler shaper type", SAI_ATTR_VAL_TYPE_S32 },
+    { SAI_SCHEDULER_ATTR_MIN_BANDWIDTH_RATE, false, true, true, true,
+      "Scheduler min bandwidth rate", SAI_ATTR_VAL_TYPE_U64 },
+    { SAI_SCHEDULER_ATTR_MIN_BANDWIDTH_BURST_RATE, false, true, true, true,
+      "Scheduler min bandwidth burst", SAI_ATTR_VAL_TYPE_U64 },
+    { SAI_SCHEDULER_ATTR_MAX_BANDWIDTH_RATE, false, true, true, true,
+      "Scheduler max bandwidth rate", SAI_ATTR_VAL_TYPE_U64 },
+    { SAI_SCHEDULER_ATTR_MAX_BANDWIDTH_BURST_RATE, false, true, true, true,
+      "Scheduler max bandwidth burst", SAI_ATTR_VAL_TYPE_U64 },
+    { END_FUNCTIONALITY_ATTRIBS_ID, false, false, false, false,
+      "", SAI_ATTR_VAL_TYPE_UNDETERMINED }
+};
+
+static const sai_attribute_entry_t scheduler_group_attribs[] = {
+    { SAI_SCHEDULER_GROUP_ATTR_CHILD_COUNT, false, false, false, true,
+      "Scheduler group child count", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_SCHEDULER_GROUP_ATTR_CHILD_LIST, false, false, false, true,
+      "Scheduler group child list", SAI_ATTR_VAL_TYPE_OBJLIST },
+    { SAI_SCHEDULER_GROUP_ATTR_PORT_ID, true, true, false, true,
+      "Scheduler group port", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_SCHEDULER_GROUP_ATTR_LEVEL, true, true, false, true,
+      "Scheduler group level", SAI_ATTR_VAL_TYPE_U8 },
+    { SAI_SCHEDULER_GROUP_ATTR_MAX_CHILDS, true, true, false, true,
+      "Scheduler group max childs", SAI_ATTR_VAL_TYPE_U8 },
+    { SAI_SCHEDULER_GROUP_ATTR_SCHEDULER_PROFILE_ID, false, true, true, true,
+      "Scheduler group scheduler", SAI_ATTR_VAL_TYPE_OID },
+    { END_FUNCTIONALITY_ATTRIBS_ID, false, false, false, false,
+      "", SAI_ATTR_VAL_TYPE_UNDETERMINED }
+};
+
+static const sai_attribute_entry_t queue_attribs[] = {
+    { SAI_QUEUE_ATTR_TYPE, false, false, false, true,
+      "Queue type", SAI_ATTR_VAL_TYPE_S32 },
+    { SAI_QUEUE_ATTR_WRED_PROFILE_ID, false, false, true, true,
+      "Queue WRED profile", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_QUEUE_ATTR_BUFFER_PROFILE_ID, false, false, true, true,
+      "Queue buffer profile", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_QUEUE_ATTR_SCHEDULER_PROFILE_ID, false, false, true, true,
+      "Queue scheduler", SAI_ATTR_VAL_TYPE_OID },
+    { END_FUNCTIONALITY_ATTRIBS_ID, false, false, false, false,
+      "", SAI_ATTR_VAL_TYPE_UNDETERMINED }
+};
+
+sai_status_t stub_scheduler_attr_get(_In_ const sai_object_key_t   *key,
+                                     _Inout_ sai_attribute_value_t *value,
+                                     _In_ uint32_t                  attr_index,
+                                     _Inout_ vendor_cache_t        *cache,
+                                     void                          *arg);
+sai_status_t stub_scheduler_attr_set(_In_ const sai_object_key_t      *key,
+                                     _In_ const sai_attribute_value_t *value,
+                                     void                             *arg);
+sai_status_t stub_scheduler_group_attr_get(_In_ const sai_object_key_t   *key,
+                                           _Inout_ sai_attribute_value_t *value,
+                                           _In_ uint32_t                  attr_index,
+                                           _Inout_ vendor_cache_t        *cache,
+                                           void                          *arg);
+sai_status_t stub_scheduler_group_profile_set(_In_ const sai_object_key_t      *key,
+                                              _In_ const sai_attribute_value_t *value,
+                                              void                             *arg);
+sai_status_t stub_queue_attr_get(_In_ const sai_object_key_t   *key,
+                                 _Inout_ sai_attribute_value_t *value,
+                                 _In_ uint32_t                  attr_index,
+                                 _Inout_ vendor_cache_t        *cache,
+                                 void                          *arg);
+sai_status_t stub_queue_profile_set(_In_ const sai_object_key_t      *key,
+                                    _In_ const sai_attribute_value_t *value,
+                                    void                             *arg);
+sai_status_t stub_queue_wred_set(_In_ const sai_object_key_t      *key,
+                                 _In_ const sai_attribute_value_t *value,
+                                 void                             *arg);
+sai_status_t stub_queue_buffer_set(_In_ const sai_object_key_t      *key,
+                                   _In_ const sai_attribute_value_t *value,
+                                   void                             *arg);
+
+static const sai_vendor_attribute_entry_t scheduler_vendor_attribs[] = {
+    { SAI_SCHEDULER_ATTR_SCHEDULING_ALGORITHM,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_scheduler_attr_get, (void*)SAI_SCHEDULER_ATTR_SCHEDULING_ALGORITHM,
+      stub_scheduler_attr_set, (void*)SAI_SCHEDULER_ATTR_SCHEDULING_ALGORITHM },
+    { SAI_SCHEDULER_ATTR_SCHEDULING_WEIGHT,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_scheduler_attr_get, (void*)SAI_SCHEDULER_ATTR_SCHEDULING_WEIGHT,
+      stub_scheduler_attr_set, (void*)SAI_SCHEDULER_ATTR_SCHEDULING_WEIGHT },
+    { SAI_SCHEDULER_ATTR_SHAPER_TYPE,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_scheduler_attr_get, (void*)SAI_SCHEDULER_ATTR_SHAPER_TYPE,
+      stub_scheduler_attr_set, (void*)SAI_SCHEDULER_ATTR_SHAPER_TYPE },
+    { SAI_SCHEDULER_ATTR_MIN_BANDWIDTH_RATE,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_scheduler_attr_get, (void*)SAI_SCHEDULER_ATTR_MIN_BANDWIDTH_RATE,
+      stub_scheduler_attr_set, (void*)SAI_SCHEDULER_ATTR_MIN_BANDWIDTH_RATE },
+    { SAI_SCHEDULER_ATTR_MIN_BANDWIDTH_BURST_RATE,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_scheduler_attr_get, (void*)SAI_SCHEDULER_ATTR_MIN_BANDWIDTH_BURST_RATE,
+      stub_scheduler_attr_set, (void*)SAI_SCHEDULER_ATTR_MIN_BANDWIDTH_BURST_RATE },
+    { SAI_SCHEDULER_ATTR_MAX_BANDWIDTH_RATE,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_scheduler_attr_get, (void*)SAI_SCHEDULER_ATTR_MAX_BANDWIDTH_RATE,
+      stub_scheduler_attr_set, (void*)SAI_SCHEDULER_ATTR_MAX_BANDWIDTH_RATE },
+    { SAI_SCHEDULER_ATTR_MAX_BANDWIDTH_BURST_RATE,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_scheduler_attr_get, (void*)SAI_SCHEDULER_ATTR_MAX_BANDWIDTH_BURST_RATE,
+      stub_scheduler_attr_set, (void*)SAI_SCHEDULER_ATTR_MAX_BANDWIDTH_BURST_RATE },
+};
+
+static const sai_vendor_attribute_entry_t scheduler_group_vendor_attribs[] = {
+    { SAI_SCHEDULER_GROUP_ATTR_CHILD_COUNT,
+      { false, false, false, true },
+      { false, false, false, true },
+      stub_scheduler_group_attr_get, (void*)SAI_SCHEDULER_GROUP_ATTR_CHILD_COUNT,
+      NULL, NULL },
+    { SAI_SCHEDULER_GROUP_ATTR_CHILD_LIST,
+      { false, false, false, true },
+      { false, false, false, true },
+      stub_scheduler_group_attr_get, (void*)SAI_SCHEDULER_GROUP_ATTR_CHILD_LIST,
+      NULL, NULL },
+    { SAI_SCHEDULER_GROUP_ATTR_PORT_ID,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_scheduler_group_attr_get, (void*)SAI_SCHEDULER_GROUP_ATTR_PORT_ID,
+      NULL, NULL },
+    { SAI_SCHEDULER_GROUP_ATTR_LEVEL,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_scheduler_group_attr_get, (void*)SAI_SCHEDULER_GROUP_ATTR_LEVEL,
+      NULL, NULL },
+    { SAI_SCHEDULER_GROUP_ATTR_MAX_CHILDS,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_scheduler_group_attr_get, (void*)SAI_SCHEDULER_GROUP_ATTR_MAX_CHILDS,
+      NULL, NULL },
+    { SAI_SCHEDULER_GROUP_ATTR_SCHEDULER_PROFILE_ID,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_scheduler_group_attr_get, (void*)SAI_SCHEDULER_GROUP_ATTR_SCHEDULER_PROFILE_ID,
+      stub_scheduler_group_profile_set, NULL },
+};
+
+static const sai_vendor_attribute_entry_t queue_vendor_attribs[] = {
+    { SAI_QUEUE_ATTR_TYPE,
+      { false, false, false, true },
+      { false, false, false, true },
+      stub_queue_attr_get, (void*)SAI_QUEUE_ATTR_TYPE,
+      NULL, NULL },
+    { SAI_QUEUE_ATTR_WRED_PROFILE_ID,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_queue_attr_get, (void*)SAI_QUEUE_ATTR_WRED_PROFILE_ID,
+      stub_queue_wred_set, NULL },
+    { SAI_QUEUE_ATTR_BUFFER_PROFILE_ID,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_queue_attr_get, (void*)SAI_QUEUE_ATTR_BUFFER_PROFILE_ID,
+      stub_queue_buffer_set, NULL },
+    { SAI_QUEUE_ATTR_SCHEDULER_PROFILE_ID,
+      { false, false, true, true },
+      { false, false, true, true },
+      stub_queue_attr_get, (void*)SAI_QUEUE_ATTR_SCHEDULER_PROFILE_ID,
+      stub_queue_profile_set, NULL },
+};
+
+/* State DB *************/
+#define MAX_SCHEDULERS        64
+#define MAX_SCHEDULER_GROUPS  256
+#define SCHED_NONE            UINT32_MAX
+/* Children are queues by their index on the port, or flagged group indexes */
+#define SCHED_GROUP_REF       0x80000000
+#define SCHED_NO_PORT         UINT8_MAX
+/* shaper credit of one byte or packet, tokens are kept in unit nanoseconds */
+#define SCHED_TOKEN           1000000000ULL
+/* 800 Gbps, keeps the bucket and clock arithmetic within 64 bits */
+#define SCHED_MAX_RATE        100000000000ULL
+#define SCHED_MAX_BURST       1000000000ULL
+#define SCHED_MAX_WEIGHT      100
+/* deficit round robin rounds before the largest frame fits a weight of 1 */
+#define SCHED_DRR_ROUNDS      (STUB_DATAPLANE_MAX_FRAME / STUB_SCHEDULER_QUANTUM + 2)
+/* simulated time a port waits when every backlogged child is shaped */
+#define SCHED_IDLE_NS         1000
+/* frames a port sends between taking the buffer lock */
+#define SCHED_BUFFER_BATCH    32
+/* SAI counters, then the stub ones of stub_sai_wred.h */
+#define SCHED_SAI_STATS       (SAI_QUEUE_STAT_WATERMARK_BYTES + 1)
+#define SCHED_STAT_COUNT      (SCHED_SAI_STATS + STUB_QUEUE_STAT_ECN_MARKED_BYTES - SAI_QUEUE_STAT_CUSTOM_RANGE_BASE + 1)
+#define SCHED_STAT(counter) \
+    (((uint32_t)(counter) < SAI_QUEUE_STAT_CUSTOM_RANGE_BASE) ? (uint32_t)(counter) : \
+     SCHED_SAI_STATS + (uint32_t)(counter) - SAI_QUEUE_STAT_CUSTOM_RANGE_BASE)
+#define SCHED_COLOR_STAT(counter, color) \
+    ((counter) + (color) * (SAI_QUEUE_STAT_YELLOW_PACKETS - SAI_QUEUE_STAT_GREEN_PACKETS))
+#define SCHED_COLOR_DISCARD_STAT(counter, color) \
+    ((counter) + (color) * (SAI_QUEUE_STAT_YELLOW_DISCARD_DROPPED_PACKETS - SAI_QUEUE_STAT_GREEN_DISCARD_DROPPED_PACKETS))
+
+typedef struct _sched_params_t {
+    sai_int32_t algorithm;
+    uint32_t    weight;
+    sai_int32_t shaper_type;
+    uint64_t    min_rate;
+    uint64_t    min_burst;
+    uint64_t    max_rate;
+    uint64_t    max_burst;
+} sched_params_t;
+
+typedef struct _scheduler_t {
+    bool           is_used;
+    sched_params_t params;
+    /* queues, groups and ports scheduled by the profile */
+    uint32_t       ref_count;
+} scheduler_t;
+
+/* How a parent serves a queue or group, a copy of its profile, and the
+ * shaper buckets and round robin deficit of the simulation */
+typedef struct _sched_node_t {
+    uint32_t       profile;
+    sched_params_t params;
+    uint32_t       parent;
+    int64_t        min_tokens;
+    int64_t        max_tokens;
+    uint64_t       last_ns;
+    int64_t        deficit;
+    bool           granted;
+} sched_node_t;
+
+typedef struct _sched_group_t {
+    bool         is_used;
+    uint32_t     port;
+    uint8_t      level;
+    uint8_t      max_childs;
+    uint32_t     children[STUB_SCHEDULER_MAX_CHILDS];
+    uint32_t     child_count;
+    /* round robin position, and the child the last selection took */
+    uint32_t     rr;
+    uint32_t     pick;
+    bool         pick_drr;
+    sched_node_t node;
+} sched_group_t;
+
+/* A queued frame, with the ingress port, SCHED_NO_PORT for none, and
+ * priority group the buffer charged it to */
+typedef struct _sched_frame_t {
+    uint32_t length;
+    uint8_t  color;
+    uint8_t  in_port;
+    uint8_t  priority_group;
+} sched_frame_t;
+
+typedef struct _sched_queue_t {
+    sched_frame_t frames[STUB_SCHEDULER_QUEUE_FRAMES];
+    uint32_t      head;
+    uint32_t      count;
+    uint64_t      bytes;
+    uint64_t      stats[SCHED_STAT_COUNT];
+    sched_node_t  node;
+    /* WRED profile, STUB_NO_WRED for none, and the average it keeps */
+    uint32_t      wred;
+    int64_t       wred_avg;
+} sched_queue_t;
+
+typedef struct _sched_port_t {
+    /* queues, the simulation state of the nodes of the port and the
+     * children of its groups */
+    pthread_mutex_t lock;
+    sched_queue_t   queues[STUB_QOS_QUEUES];
+    uint32_t        frames;
+    /* level 0 group, SCHED_NONE while the port serves its queues through flat */
+    uint32_t        root;
+    sched_group_t   flat;
+    /* port shaper */
+    sched_node_t    node;
+    /* simulated clock, the link is busy until now_ns */
+    uint64_t        now_ns;
+    uint64_t        end_ns;
+    uint64_t        tx_frac;
+} sched_port_t;
+
+static const sched_params_t sched_default_params = {
+    SAI_SCHEDULING_WRR, 1, SAI_METER_TYPE_BYTES, 0, 0, 0, 0
+};
+
+static scheduler_t      scheduler_db[MAX_SCHEDULERS];
+static sched_group_t    sched_groups[MAX_SCHEDULER_GROUPS];
+static sched_port_t     sched_ports[PORT_NUMBER] = {
+    [0 ... PORT_NUMBER - 1] = { .lock = PTHREAD_MUTEX_INITIALIZER }
+};
+/* Profiles and group configuration. Writers changing what the simulation
+ * reads also take the port lock */
+static pthread_rwlock_t scheduler_db_lock = STUB_RWLOCK_INITIALIZER;
+
+/* Caller holds scheduler_db_lock */
+static sai_status_t scheduler_db_index(_In_ sai_object_id_t scheduler_id, _Out_ uint32_t *index)
+{
+    sai_status_t status;
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(scheduler_id, SAI_OBJECT_TYPE_SCHEDULER, index))) {
+        return status;
+    }
+
+    if ((*index >= MAX_SCHEDULERS) || (!scheduler_db[*index].is_used)) {
+        STUB_LOG_ERR("Scheduler %u does not exist\n", *index);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Caller holds scheduler_db_lock */
+static sai_status_t scheduler_group_db_index(_In_ sai_object_id_t scheduler_group_id, _Out_ uint32_t *index)
+{
+    sai_status_t status;
+
+    if (SAI_STATUS_SUCCESS !=
+        (status = stub_object_to_type(scheduler_group_id, SAI_OBJECT_TYPE_SCHEDULER_GROUP, index))) {
+        return status;
+    }
+
+    if ((*index >= MAX_SCHEDULER_GROUPS) || (!sched_groups[*index].is_used)) {
+        STUB_LOG_ERR("Scheduler group %u does not exist\n", *index);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t queue_db_index(_In_ sai_object_id_t queue_id, _Out_ uint32_t *port, _Out_ uint32_t *queue)
+{
+    sai_status_t status;
+    uint32_t     index;
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(queue_id, SAI_OBJECT_TYPE_QUEUE, &index))) {
+        return status;
+    }
+
+    if (index >= PORT_NUMBER * STUB_QOS_QUEUES) {
+        STUB_LOG_ERR("Queue %u does not exist\n", index);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    *port  = index / STUB_QOS_QUEUES;
+    *queue = index % STUB_QOS_QUEUES;
+    return SAI_STATUS_SUCCESS;
+}
+
+static void scheduler_key_to_str(_In_ sai_object_id_t scheduler_id, _Out_ char *key_str)
+{
+    uint32_t index;
+
+    if (SAI_STATUS_SUCCESS != stub_object_to_type(scheduler_id, SAI_OBJECT_TYPE_SCHEDULER, &index)) {
+        snprintf(key_str, MAX_KEY_STR_LEN, "invalid scheduler id");
+    } else {
+        snprintf(key_str, MAX_KEY_STR_LEN, "scheduler id %u", index);
+    }
+}
+
+static void scheduler_group_key_to_str(_In_ sai_object_id_t scheduler_group_id, _Out_ char *key_str)
+{
+    uint32_t index;
+
+    if (SAI_STATUS_SUCCESS != stub_object_to_type(scheduler_group_id, SAI_OBJECT_TYPE_SCHEDULER_GROUP, &index)) {
+        snprintf(key_str, MAX_KEY_STR_LEN, "invalid scheduler group id");
+    } else {
+        snprintf(key_str, MAX_KEY_STR_LEN, "scheduler group id %u", index);
+    }
+}
+
+static void queue_key_to_str(_In_ sai_object_id_t queue_id, _Out_ char *key_str)
+{
+    uint32_t port, queue;
+
+    if (SAI_STATUS_SUCCESS != queue_db_index(queue_id, &port, &queue)) {
+        snprintf(key_str, MAX_KEY_STR_LEN, "invalid queue id");
+    } else {
+        snprintf(key_str, MAX_KEY_STR_LEN, "queue %u of port %u", queue, port);
+    }
+}
+
+/* Object id of a child of a group on a port */
+static sai_status_t sched_child_to_object(_In_ uint32_t port, _In_ uint32_t child, _Out_ sai_object_id_t *object_id)
+{
+    if (child & SCHED_GROUP_REF) {
+        return stub_create_object(SAI_OBJECT_TYPE_SCHEDULER_GROUP, child & ~SCHED_GROUP_REF, object_id);
+    }
+
+    return stub_create_object(SAI_OBJECT_TYPE_QUEUE, port * STUB_QOS_QUEUES + child, object_id);
+}
+
+/* Profile object id of a node, SAI_NULL_OBJECT_ID for none */
+static sai_status_t sched_node_profile_get(_In_ const sched_node_t *node, _Out_ sai_object_id_t *scheduler_id)
+{
+    *scheduler_id = SAI_NULL_OBJECT_ID;
+    if (SCHED_NONE == node->profile) {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    return stub_create_object(SAI_OBJECT_TYPE_SCHEDULER, node->profile, scheduler_id);
+}
+
+/* Bucket size in tokens, a zero burst holds one largest frame or one packet */
+static inline int64_t sched_burst(_In_ const sched_params_t *params, _In_ uint64_t burst)
+{
+    if (0 == burst) {
+        burst = (SAI_METER_TYPE_BYTES == params->shaper_type) ? STUB_DATAPLANE_MAX_FRAME : 1;
+    }
+
+    return (int64_t)(burst * SCHED_TOKEN);
+}
+
+/* Schedule a node by a profile, SCHED_NONE for the defaults, with full
+ * buckets. Caller holds the port lock */
+static void sched_node_set(_Inout_ sched_node_t *node, _In_ uint32_t profile, _In_ uint64_t now_ns)
+{
+    node->profile    = profile;
+    node->params     = (SCHED_NONE == profile) ? sched_default_params : scheduler_db[profile].params;
+    node->min_tokens = sched_burst(&node->params, node->params.min_burst);
+    node->max_tokens = sched_burst(&node->params, node->params.max_burst);
+    node->last_ns    = now_ns;
+    node->deficit    = 0;
+    node->granted    = false;
+}
+
+/* Tokens a rate earns in elapsed nanoseconds, at most cap */
+static inline uint64_t sched_earned(_In_ uint64_t elapsed, _In_ uint64_t rate, _In_ uint64_t cap)
+{
+    if (elapsed >= cap / rate + 1) {
+        return cap;
+    }
+
+    return (elapsed * rate < cap) ? elapsed * rate : cap;
+}
+
+/* Refill the shaper buckets of a node up to the port clock */
+static void sched_node_refill(_Inout_ sched_node_t *node, _In_ uint64_t now_ns)
+{
+    uint64_t elapsed = now_ns - node->last_ns;
+    int64_t  cap;
+
+    if (0 == elapsed) {
+        return;
+    }
+    node->last_ns = now_ns;
+
+    if (0 != node->params.max_rate) {
+        cap = sched_burst(&node->params, node->params.max_burst);
+        if (node->max_tokens < cap) {
+            node->max_tokens += (int64_t)sched_earned(elapsed, node->params.max_rate,
+                                                      (uint64_t)(cap - node->max_tokens));
+        }
+    }
+
+    if (0 != node->params.min_rate) {
+        cap = sched_burst(&node->params, node->params.min_burst);
+        if (node->min_tokens < cap) {
+            node->min_tokens += (int64_t)sched_earned(elapsed, node->params.min_rate,
+                                                      (uint64_t)(cap - node->min_tokens));
+        }
+    }
+}
+
+/* Not held back by its shaper. The bucket may go below zero by one frame */
+static inline bool sched_node_open(_In_ const sched_node_t *node)
+{
+    return (0 == node->params.max_rate) || (node->max_tokens > 0);
+}
+
+/* Below its guaranteed rate */
+static inline bool sched_node_guaranteed(_In_ const sched_node_t *node)
+{
+    return (0 != node->params.min_rate) && (node->min_tokens > 0);
+}
+
+/* Take the tokens of a frame. Service past the guarantee leaves none,
+ * it does not build up debt */
+static void sched_node_charge(_Inout_ sched_node_t *node, _In_ uint32_t length)
+{
+    int64_t cost = (int64_t)(((SAI_METER_TYPE_BYTES == node->params.shaper_type) ? length : 1) * SCHED_TOKEN);
+
+    if (0 != node->params.max_rate) {
+        node->max_tokens -= cost;
+    }
+    if (0 != node->params.min_rate) {
+        node->min_tokens = (node->min_tokens > cost) ? node->min_tokens - cost : 0;
+    }
+}
+
+/* Deficit a weighted child earns a round, and the deficit a frame takes */
+static inline int64_t sched_quantum(_In_ const sched_node_t *node)
+{
+    return (SAI_SCHEDULING_DWRR == node->params.algorithm) ?
+           (int64_t)node->params.weight * STUB_SCHEDULER_QUANTUM : (int64_t)node->params.weight;
+}
+
+static inline int64_t sched_drr_cost(_In_ const sched_node_t *node, _In_ uint32_t length)
+{
+    return (SAI_SCHEDULING_DWRR == node->params.algorithm) ? length : 1;
+}
+
+static inline sched_node_t* sched_child_node(_In_ sched_port_t *port, _In_ uint32_t child)
+{
+    return (child & SCHED_GROUP_REF) ? &sched_groups[child & ~SCHED_GROUP_REF].node : &port->queues[child].node;
+}
+
+static uint32_t sched_select_group(_Inout_ sched_port_t  *port,
+                                   _Inout_ sched_group_t *group,
+                                   _In_ uint64_t          now_ns,
+                                   _Out_ uint32_t        *length);
+
+/* Queue a child sends from next and the length of its frame, SCHED_NONE
+ * when nothing under the child may send. Caller holds the port lock */
+static uint32_t sched_select(_Inout_ sched_port_t *port,
+                             _In_ uint32_t         child,
+                             _In_ uint64_t         now_ns,
+                             _Out_ uint32_t       *length)
+{
+    const sched_queue_t *queue;
+
+    if (child & SCHED_GROUP_REF) {
+        return sched_select_group(port, &sched_groups[child & ~SCHED_GROUP_REF], now_ns, length);
+    }
+
+    queue = &port->queues[child];
+    if (0 == queue->count) {
+        return SCHED_NONE;
+    }
+
+    *length = queue->frames[queue->head].length;
+    return child;
+}
+
+/* Queue a group sends from next. Each group on the way keeps the child it
+ * took in pick, for sched_commit. Caller holds the port lock */
+static uint32_t sched_select_group(_Inout_ sched_port_t  *port,
+                                   _Inout_ sched_group_t *group,
+                                   _In_ uint64_t          now_ns,
+                                   _Out_ uint32_t        *length)
+{
+    sched_node_t *node;
+    uint32_t      ii, pass, child, queue, tries;
+
+    /* Children below their guarantee, then strict children, the last added first */
+    for (pass = 0; pass < 2; pass++) {
+        for (ii = group->child_count; ii-- > 0;) {
+            child = group->children[ii];
+            node  = sched_child_node(port, child);
+            sched_node_refill(node, now_ns);
+            if (!sched_node_open(node) ||
+                ((0 == pass) ? !sched_node_guaranteed(node) : (SAI_SCHEDULING_STRICT != node->params.algorithm))) {
+                continue;
+            }
+            if (SCHED_NONE != (queue = sched_select(port, child, now_ns, length))) {
+                group->pick     = child;
+                group->pick_drr = false;
+                return queue;
+            }
+        }
+    }
+
+    /* The others in deficit round robin, a child keeps the turn while its
+     * deficit lasts */
+    for (tries = 0; tries < group->child_count * SCHED_DRR_ROUNDS; tries++) {
+        child = group->children[group->rr];
+        node  = sched_child_node(port, child);
+        if (SAI_SCHEDULING_STRICT != node->params.algorithm) {
+            if (!sched_node_open(node)) {
+                node->granted = false;
+            } else if (SCHED_NONE == (queue = sched_select(port, child, now_ns, length))) {
+                node->deficit = 0;
+                node->granted = false;
+            } else {
+                if (!node->granted) {
+                    node->deficit += sched_quantum(node);
+                    node->granted  = true;
+                }
+                if (node->deficit >= sched_drr_cost(node, *length)) {
+                    group->pick     = child;
+                    group->pick_drr = true;
+                    return queue;
+                }
+                node->granted = false;
+            }
+        }
+        group->rr = (group->rr + 1) % group->child_count;
+    }
+
+    return SCHED_NONE;
+}
+
+/* Send the frame the last selection of a group took: charge the children
+ * on its way down, take it off its queue and out of the buffer. Caller
+ * holds the port lock and the buffer lock */
+static void sched_commit(_Inout_ sched_port_t     *port,
+                         _In_ uint32_t             index,
+                         _In_ const sched_group_t *group,
+                         _In_ uint32_t             length)
+{
+    sched_queue_t *queue;
+    sched_frame_t *frame;
+    sched_node_t  *node;
+    uint32_t       child, color;
+
+    while (true) {
+        child = group->pick;
+        node  = sched_child_node(port, child);
+        sched_node_charge(node, length);
+        if (group->pick_drr) {
+            node->deficit -= sched_drr_cost(node, length);
+        }
+        if (!(child & SCHED_GROUP_REF)) {
+            break;
+        }
+        group = &sched_groups[child & ~SCHED_GROUP_REF];
+    }
+
+    queue = &port->queues[child];
+    frame = &queue->frames[queue->head];
+    color = frame->color;
+
+    queue->head   = (queue->head + 1) % STUB_SCHEDULER_QUEUE_FRAMES;
+    queue->count--;
+    queue->bytes -= frame->length;
+    port->frames--;
+
+    queue->stats[SAI_QUEUE_STAT_PACKETS]++;
+    queue->stats[SAI_QUEUE_STAT_BYTES] += frame->length;
+    queue->stats[SCHED_COLOR_STAT(SAI_QUEUE_STAT_GREEN_PACKETS, color)]++;
+    queue->stats[SCHED_COLOR_STAT(SAI_QUEUE_STAT_GREEN_BYTES, color)] += frame->length;
+
+    db_buffer_release((SCHED_NO_PORT == frame->in_port) ? STUB_BUFFER_NO_PORT : frame->in_port,
+                      frame->priority_group, index, child, frame->length);
+}
+
+/* Port index of a port object, false for other objects */
+static inline bool sched_port_index(_In_ sai_object_id_t port_id, _Out_ uint32_t *port)
+{
+    const stub_object_id_t *object = (const stub_object_id_t*)&port_id;
+
+    *port = object->data;
+    return (SAI_OBJECT_TYPE_PORT == object->object_type) && (object->data < PORT_NUMBER);
+}
+
+static void sched_queue_drop(_Inout_ sched_queue_t *queue, _In_ uint32_t length, _In_ uint32_t color)
+{
+    queue->stats[SAI_QUEUE_STAT_DROPPED_PACKETS]++;
+    queue->stats[SAI_QUEUE_STAT_DROPPED_BYTES] += length;
+    queue->stats[SCHED_COLOR_STAT(SAI_QUEUE_STAT_GREEN_DROPPED_PACKETS, color)]++;
+    queue->stats[SCHED_COLOR_STAT(SAI_QUEUE_STAT_GREEN_DROPPED_BYTES, color)] += length;
+}
+
+/* Tail of a queue, a WRED drop or mark, a tail drop, or a drop for want
+ * of buffer. Caller holds the port lock and the buffer lock, and is in a
+ * read side section */
+static void sched_queue_push(_Inout_ sched_port_t  *port,
+                             _In_ uint32_t          index,
+                             _In_ uint32_t          queue_index,
+                             _Inout_ stub_packet_t *packet,
+                             _In_ uint32_t          color)
+{
+    sched_queue_t     *queue  = &port->queues[queue_index];
+    sched_frame_t     *frame;
+    stub_wred_action_t action = STUB_WRED_QUEUE;
+    uint32_t           length = packet->length, in_port, pg;
+
+    if (STUB_NO_WRED != queue->wred) {
+        action = db_apply_wred(queue->wred, &queue->wred_avg, queue->bytes, color);
+    }
+
+    if (STUB_WRED_MARK == action) {
+        if (db_wred_mark_ecn(packet)) {
+            queue->stats[SCHED_STAT(STUB_QUEUE_STAT_ECN_MARKED_PACKETS)]++;
+            queue->stats[SCHED_STAT(STUB_QUEUE_STAT_ECN_MARKED_BYTES)] += length;
+        } else {
+            action = STUB_WRED_DROP;
+        }
+    }
+
+    if (STUB_WRED_DROP == action) {
+        queue->stats[SAI_QUEUE_STAT_DISCARD_DROPPED_PACKETS]++;
+        queue->stats[SAI_QUEUE_STAT_DISCARD_DROPPED_BYTES] += length;
+        queue->stats[SCHED_COLOR_DISCARD_STAT(SAI_QUEUE_STAT_GREEN_DISCARD_DROPPED_PACKETS, color)]++;
+        queue->stats[SCHED_COLOR_DISCARD_STAT(SAI_QUEUE_STAT_GREEN_DISCARD_DROPPED_BYTES, color)] += length;
+        sched_queue_drop(queue, length, color);
+        return;
+    }
+
+    if (STUB_SCHEDULER_QUEUE_FRAMES == queue->count) {
+        sched_queue_drop(queue, length, color);
+        return;
+    }
+
+    if (!sched_port_index(packet->in_port, &in_port)) {
+        in_port = STUB_BUFFER_NO_PORT;
+    }
+    pg = packet->priority_group % STUB_QOS_PRIORITY_GROUPS;
+    if (!db_buffer_admit(in_port, pg, index, queue_index, length)) {
+        sched_queue_drop(queue, length, color);
+        return;
+    }
+
+    frame                 = &queue->frames[(queue->head + queue->count) % STUB_SCHEDULER_QUEUE_FRAMES];
+    frame->length         = length;
+    frame->color          = (uint8_t)color;
+    frame->in_port        = (STUB_BUFFER_NO_PORT == in_port) ? SCHED_NO_PORT : (uint8_t)in_port;
+    frame->priority_group = (uint8_t)pg;
+    queue->count++;
+    queue->bytes += length;
+    port->frames++;
+
+    if (queue->bytes > queue->stats[SAI_QUEUE_STAT_WATERMARK_BYTES]) {
+        queue->stats[SAI_QUEUE_STAT_WATERMARK_BYTES] = queue->bytes;
+    }
+}
+
+void db_init_scheduler(void)
+{
+    sched_port_t *port;
+    uint32_t      ii, queue;
+
+    pthread_rwlock_wrlock(&scheduler_db_lock);
+
+    memset(scheduler_db, 0, sizeof(scheduler_db));
+    memset(sched_groups, 0, sizeof(sched_groups));
+
+    for (ii = 0; ii < PORT_NUMBER; ii++) {
+        port = &sched_ports[ii];
+        pthread_mutex_lock(&port->lock);
+
+        port->frames  = 0;
+        port->root    = SCHED_NONE;
+        port->now_ns  = 0;
+        port->end_ns  = 0;
+        port->tx_frac = 0;
+        sched_node_set(&port->node, SCHED_NONE, 0);
+
+        memset(&port->flat, 0, sizeof(port->flat));
+        port->flat.is_used     = true;
+        port->flat.port        = ii;
+        port->flat.max_childs  = STUB_QOS_QUEUES;
+        port->flat.child_count = STUB_QOS_QUEUES;
+        sched_node_set(&port->flat.node, SCHED_NONE, 0);
+
+        for (queue = 0; queue < STUB_QOS_QUEUES; queue++) {
+            port->queues[queue].head  = 0;
+            port->queues[queue].count = 0;
+            port->queues[queue].bytes = 0;
+            port->queues[queue].wred     = STUB_NO_WRED;
+            port->queues[queue].wred_avg = 0;
+            memset(port->queues[queue].stats, 0, sizeof(port->queues[queue].stats));
+            sched_node_set(&port->queues[queue].node, SCHED_NONE, 0);
+            port->queues[queue].node.parent = SCHED_NONE;
+            port->flat.children[queue]      = queue;
+        }
+
+        pthread_mutex_unlock(&port->lock);
+    }
+
+    pthread_rwlock_unlock(&scheduler_db_lock);
+}
+
+/* Move a node to another profile, SAI_NULL_OBJECT_ID for the defaults.
+ * Caller holds scheduler_db_lock exclusively */
+static sai_status_t sched_node_bind(_Inout_ sched_port_t *port,
+                                    _Inout_ sched_node_t *node,
+                                    _In_ sai_object_id_t  scheduler_id)
+{
+    uint32_t profile = SCHED_NONE;
+
+    if ((SAI_NULL_OBJECT_ID != scheduler_id) &&
+        (SAI_STATUS_SUCCESS != scheduler_db_index(scheduler_id, &profile))) {
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    if (SCHED_NONE != profile) {
+        scheduler_db[profile].ref_count++;
+    }
+    if (SCHED_NONE != node->profile) {
+        assert(scheduler_db[node->profile].ref_count > 0);
+        scheduler_db[node->profile].ref_count--;
+    }
+
+    pthread_mutex_lock(&port->lock);
+    sched_node_set(node, profile, port->now_ns);
+    pthread_mutex_unlock(&port->lock);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Get the queues, the scheduler groups or the scheduler of a port
+ *
+ * Arguments:
+ *    [in] port - port index
+ *    [in] attr - SAI_PORT_ATTR_QOS_NUMBER_OF_QUEUES, _QUEUE_LIST,
+ *                _NUMBER_OF_SCHEDULER_GROUPS, _SCHEDULER_GROUP_LIST or
+ *                _SCHEDULER_PROFILE_ID
+ *    [out] value - count, object list, or scheduler id
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t db_get_port_scheduler(_In_ uint32_t port, _In_ sai_attr_id_t attr, _Out_ sai_attribute_value_t *value)
+{
+    sai_object_id_t objects[MAX_SCHEDULER_GROUPS];
+    sai_status_t    status = SAI_STATUS_SUCCESS;
+    uint32_t        ii, count = 0;
+
+    assert(port < PORT_NUMBER);
+
+    pthread_rwlock_rdlock(&scheduler_db_lock);
+
+    switch ((long)attr) {
+    case SAI_PORT_ATTR_QOS_NUMBER_OF_QUEUES:
+        value->u32 = STUB_QOS_QUEUES;
+        break;
+
+    case SAI_PORT_ATTR_QOS_QUEUE_LIST:
+        for (ii = 0; (ii < STUB_QOS_QUEUES) && (SAI_STATUS_SUCCESS == status); ii++) {
+            status = sched_child_to_object(port, ii, &objects[ii]);
+        }
+        if (SAI_STATUS_SUCCESS == status) {
+            status = stub_fill_objlist(objects, STUB_QOS_QUEUES, &value->objlist);
+        }
+        break;
+
+    case SAI_PORT_ATTR_QOS_NUMBER_OF_SCHEDULER_GROUPS:
+    case SAI_PORT_ATTR_QOS_SCHEDULER_GROUP_LIST:
+        for (ii = 0; (ii < MAX_SCHEDULER_GROUPS) && (SAI_STATUS_SUCCESS == status); ii++) {
+            if (sched_groups[ii].is_used && (port == sched_groups[ii].port)) {
+                status = sched_child_to_object(port, ii | SCHED_GROUP_REF, &objects[count++]);
+            }
+        }
+        if (SAI_PORT_ATTR_QOS_NUMBER_OF_SCHEDULER_GROUPS == attr) {
+            value->u32 = count;
+        } else if (SAI_STATUS_SUCCESS == status) {
+            status = stub_fill_objlist(objects, count, &value->objlist);
+        }
+        break;
+
+    case SAI_PORT_ATTR_QOS_SCHEDULER_PROFILE_ID:
+        status = sched_node_profile_get(&sched_ports[port].node, &value->oid);
+        break;
+    }
+
+    pthread_rwlock_unlock(&scheduler_db_lock);
+
+    return status;
+}
+
+/*
+ * Routine Description:
+ *    Shape a port by the maximum rate of a scheduler
+ *
+ * Arguments:
+ *    [in] port - port index
+ *    [in] value - scheduler id, SAI_NULL_OBJECT_ID for none
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    SAI_STATUS_INVALID_ATTR_VALUE_0 if the scheduler does not exist
+ */
+sai_status_t db_set_port_scheduler(_In_ uint32_t port, _In_ const sai_attribute_value_t *value)
+{
+    sai_status_t status;
+
+    assert(port < PORT_NUMBER);
+
+    pthread_rwlock_wrlock(&scheduler_db_lock);
+    status = sched_node_bind(&sched_ports[port], &sched_ports[port].node, value->oid);
+    pthread_rwlock_unlock(&scheduler_db_lock);
+
+    return status;
+}
+
+/*
+ * Routine Description:
+ *    @brief Queue the forwarded frames of a processed burst on their egress
+ *    ports, flooded frames on every port but the ingress one
+ *
+ * Arguments:
+ *    @param[in] count - number of frames
+ *    @param[inout] packets - frames the data plane processed, WRED may mark
+ *                            them Congestion Experienced
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_scheduler_enqueue(_In_ uint32_t count, _Inout_ stub_packet_t *packets)
+{
+    sched_port_t *port;
+    uint32_t      ii, index, color;
+    bool          locked;
+
+    if (NULL == packets) {
+        STUB_LOG_ERR("NULL packets param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    stub_rcu_read_lock();
+
+    /* One lock per port and burst */
+    for (index = 0; index < PORT_NUMBER; index++) {
+        port   = &sched_ports[index];
+        locked = false;
+
+        for (ii = 0; ii < count; ii++) {
+            if (!stub_dataplane_is_sent_to(&packets[ii], index)) {
+                continue;
+            }
+            if (!locked) {
+                pthread_mutex_lock(&port->lock);
+                db_buffer_lock();
+                locked = true;
+            }
+            color = (packets[ii].color <= SAI_PACKET_COLOR_RED) ? packets[ii].color : SAI_PACKET_COLOR_RED;
+            sched_queue_push(port, index, packets[ii].queue % STUB_QOS_QUEUES, &packets[ii], color);
+        }
+
+        if (locked) {
+            db_buffer_unlock();
+            pthread_mutex_unlock(&port->lock);
+        }
+    }
+
+    stub_rcu_read_unlock();
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    @brief Run the egress scheduler of a port for a simulated interval,
+ *    sending frames back to back at the line rate. A frame sent past the
+ *    end of the interval takes its time from the next one
+ *
+ * Arguments:
+ *    @param[in] port_id - port
+ *    @param[in] interval_ns - simulated nanoseconds to run
+ *    @param[in] line_rate - port rate in bytes per second
+ *    @param[out] count - frames sent
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_scheduler_transmit(_In_ sai_object_id_t port_id,
+                                     _In_ uint64_t        interval_ns,
+                                     _In_ uint64_t        line_rate,
+                                     _Out_ uint32_t      *count)
+{
+    sched_port_t  *port;
+    sched_group_t *top;
+    sai_status_t   status;
+    uint64_t       tx;
+    uint32_t       index, queue, length = 0, batch = 0;
+
+    if (NULL == count) {
+        STUB_LOG_ERR("NULL count param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if ((0 == line_rate) || (line_rate > SCHED_MAX_RATE)) {
+        STUB_LOG_ERR("Line rate %" PRIu64 " out of range 1 to %llu\n", line_rate, SCHED_MAX_RATE);
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(port_id, SAI_OBJECT_TYPE_PORT, &index))) {
+        return status;
+    }
+
+    if (index >= PORT_NUMBER) {
+        STUB_LOG_ERR("Invalid port index %u\n", index);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    *count = 0;
+    port   = &sched_ports[index];
+
+    pthread_mutex_lock(&port->lock);
+    db_buffer_lock();
+
+    port->end_ns += interval_ns;
+
+    while (port->now_ns < port->end_ns) {
+        if (0 == port->frames) {
+            port->now_ns = port->end_ns;
+            break;
+        }
+
+        top = (SCHED_NONE == port->root) ? &port->flat : &sched_groups[port->root];
+        sched_node_refill(&port->node, port->now_ns);
+        sched_node_refill(&top->node, port->now_ns);
+
+        queue = SCHED_NONE;
+        if (sched_node_open(&port->node) && sched_node_open(&top->node)) {
+            queue = sched_select_group(port, top, port->now_ns, &length);
+        }
+
+        /* Shaped, or what is queued is outside the tree */
+        if (SCHED_NONE == queue) {
+            port->now_ns = (port->end_ns - port->now_ns > SCHED_IDLE_NS) ? port->now_ns + SCHED_IDLE_NS :
+                           port->end_ns;
+            continue;
+        }
+
+        sched_node_charge(&port->node, length);
+        sched_node_charge(&top->node, length);
+        sched_commit(port, index, top, length);
+        if (SCHED_BUFFER_BATCH == ++batch) {
+            db_buffer_unlock();
+            db_buffer_lock();
+            batch = 0;
+        }
+
+        tx             = length * SCHED_TOKEN + port->tx_frac;
+        port->now_ns  += tx / line_rate;
+        port->tx_frac  = tx % line_rate;
+        (*count)++;
+    }
+
+    db_buffer_unlock();
+    pthread_mutex_unlock(&port->lock);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Algorithm [sai_scheduling_type_t], weight [uint8_t], shaper type
+ * [sai_meter_type_t], rates and bursts [uint64_t] in range */
+static sai_status_t scheduler_check(_In_ sai_attr_id_t attr, _In_ const sai_attribute_value_t *value)
+{
+    switch ((long)attr) {
+    case SAI_SCHEDULER_ATTR_SCHEDULING_ALGORITHM:
+        if ((value->s32 < SAI_SCHEDULING_STRICT) || (value->s32 > SAI_SCHEDULING_DWRR)) {
+            STUB_LOG_ERR("Invalid scheduling algorithm %d\n", value->s32);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        break;
+
+    case SAI_SCHEDULER_ATTR_SCHEDULING_WEIGHT:
+        if ((0 == value->u8) || (value->u8 > SCHED_MAX_WEIGHT)) {
+            STUB_LOG_ERR("Scheduling weight %u out of range 1 to %u\n", value->u8, SCHED_MAX_WEIGHT);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        break;
+
+    case SAI_SCHEDULER_ATTR_SHAPER_TYPE:
+        if ((SAI_METER_TYPE_PACKETS != value->s32) && (SAI_METER_TYPE_BYTES != value->s32)) {
+            STUB_LOG_ERR("Invalid shaper type %d\n", value->s32);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        break;
+
+    case SAI_SCHEDULER_ATTR_MIN_BANDWIDTH_RATE:
+    case SAI_SCHEDULER_ATTR_MAX_BANDWIDTH_RATE:
+        if (value->u64 > SCHED_MAX_RATE) {
+            STUB_LOG_ERR("Scheduler rate %" PRIu64 " above %llu\n", value->u64, SCHED_MAX_RATE);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        break;
+
+    case SAI_SCHEDULER_ATTR_MIN_BANDWIDTH_BURST_RATE:
+    case SAI_SCHEDULER_ATTR_MAX_BANDWIDTH_BURST_RATE:
+        if (value->u64 > SCHED_MAX_BURST) {
+            STUB_LOG_ERR("Scheduler burst %" PRIu64 " above %llu\n", value->u64, SCHED_MAX_BURST);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        break;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void scheduler_apply(_Inout_ sched_params_t *params, _In_ sai_attr_id_t attr,
+                            _In_ const sai_attribute_value_t *value)
+{
+    switch ((long)attr) {
+    case SAI_SCHEDULER_ATTR_SCHEDULING_ALGORITHM:
+        params->algorithm = value->s32;
+        break;
+
+    case SAI_SCHEDULER_ATTR_SCHEDULING_WEIGHT:
+        params->weight = value->u8;
+        break;
+
+    case SAI_SCHEDULER_ATTR_SHAPER_TYPE:
+        params->shaper_type = value->s32;
+        break;
+
+    case SAI_SCHEDULER_ATTR_MIN_BANDWIDTH_RATE:
+        params->min_rate = value->u64;
+        break;
+
+    case SAI_SCHEDULER_ATTR_MIN_BANDWIDTH_BURST_RATE:
+        params->min_burst = value->u64;
+        break;
+
+    case SAI_SCHEDULER_ATTR_MAX_BANDWIDTH_RATE:
+        params->max_rate = value->u64;
+        break;
+
+    case SAI_SCHEDULER_ATTR_MAX_BANDWIDTH_BURST_RATE:
+        params->max_burst = value->u64;
+        break;
+    }
+}
+
+/*
+ * Routine Description:
+ *    Create Scheduler Profile
+ *
+ * Arguments:
+ *    [out] scheduler_id - Scheduler id
+ *    [in] attr_count - number of attributes
+ *    [in] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_create_scheduler_profile(_Out_ sai_object_id_t     *scheduler_id,
+                                           _In_ uint32_t               attr_count,
+                                           _In_ const sai_attribute_t *attr_list)
+{
+    const sai_attribute_value_t *value;
+    sched_params_t               params = sched_default_params;
+    sai_attr_id_t                attr;
+    uint32_t                     index, scheduler;
+    sai_status_t                 status;
+    char                         list_str[MAX_LIST_VALUE_STR_LEN];
+    char                         key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    if (NULL == scheduler_id) {
+        STUB_LOG_ERR("NULL scheduler id param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS !=
+        (status =
+             check_attribs_metadata(attr_count, attr_list, scheduler_attribs, scheduler_vendor_attribs,
+                                    SAI_OPERATION_CREATE))) {
+        STUB_LOG_ERR("Failed attribs check\n");
+        return status;
+    }
+
+    sai_attr_list_to_str(attr_count, attr_list, scheduler_attribs, MAX_LIST_VALUE_STR_LEN, list_str);
+    STUB_LOG_NTC("Create scheduler, %s\n", list_str);
+
+    for (attr = SAI_SCHEDULER_ATTR_SCHEDULING_ALGORITHM; attr <= SAI_SCHEDULER_ATTR_MAX_BANDWIDTH_BURST_RATE; attr++) {
+        if (SAI_STATUS_SUCCESS != find_attrib_in_list(attr_count, attr_list, attr, &value, &index)) {
+            continue;
+        }
+        if (SAI_STATUS_SUCCESS != scheduler_check(attr, value)) {
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + index;
+        }
+        scheduler_apply(&params, attr, value);
+    }
+
+    pthread_rwlock_wrlock(&scheduler_db_lock);
+
+    for (scheduler = 0; scheduler < MAX_SCHEDULERS; scheduler++) {
+        if (!scheduler_db[scheduler].is_used) {
+            break;
+        }
+    }
+
+    if (MAX_SCHEDULERS == scheduler) {
+        pthread_rwlock_unlock(&scheduler_db_lock);
+        STUB_LOG_ERR("Scheduler table full\n");
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    scheduler_db[scheduler].is_used   = true;
+    scheduler_db[scheduler].params    = params;
+    scheduler_db[scheduler].ref_count = 0;
+
+    pthread_rwlock_unlock(&scheduler_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_SCHEDULER, scheduler, scheduler_id))) {
+        return status;
+    }
+    scheduler_key_to_str(*scheduler_id, key_str);
+    STUB_LOG_NTC("Created %s\n", key_str);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Remove Scheduler profile
+ *
+ * Arguments:
+ *    [in] scheduler_id - Scheduler id
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_remove_scheduler_profile(_In_ sai_object_id_t scheduler_id)
+{
+    char         key_str[MAX_KEY_STR_LEN];
+    sai_status_t status;
+    uint32_t     scheduler;
+
+    STUB_LOG_ENTER();
+
+    scheduler_key_to_str(scheduler_id, key_str);
+    STUB_LOG_NTC("Remove %s\n", key_str);
+
+    pthread_rwlock_wrlock(&scheduler_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = scheduler_db_index(scheduler_id, &scheduler))) {
+        pthread_rwlock_unlock(&scheduler_db_lock);
+        return status;
+    }
+
+    if (0 != scheduler_db[scheduler].ref_count) {
+        pthread_rwlock_unlock(&scheduler_db_lock);
+        STUB_LOG_ERR("Scheduler %u has %u users\n", scheduler, scheduler_db[scheduler].ref_count);
+        return SAI_STATUS_OBJECT_IN_USE;
+    }
+
+    scheduler_db[scheduler].is_used = false;
+
+    pthread_rwlock_unlock(&scheduler_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Set Scheduler Attribute
+ *
+ * Arguments:
+ *    [in] scheduler_id - Scheduler id
+ *    [in] attr - attribute to set
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_set_scheduler_attribute(_In_ sai_object_id_t scheduler_id, _In_ const sai_attribute_t *attr)
+{
+    const sai_object_key_t key = { .object_id = scheduler_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    scheduler_key_to_str(scheduler_id, key_str);
+    return sai_set_attribute(&key, key_str, scheduler_attribs, scheduler_vendor_attribs, attr);
+}
+
+/*
+ * Routine Description:
+ *    Get Scheduler attribute
+ *
+ * Arguments:
+ *    [in] scheduler_id - scheduler id
+ *    [in] attr_count - number of attributes
+ *    [inout] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_scheduler_attribute(_In_ sai_object_id_t     scheduler_id,
+                                          _In_ uint32_t            attr_count,
+                                          _Inout_ sai_attribute_t *attr_list)
+{
+    const sai_object_key_t key = { .object_id = scheduler_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
+
+    STUB_LOG_ENTER();
+
+    scheduler_key_to_str(scheduler_id, key_str);
+
+    pthread_rwlock_rdlock(&scheduler_db_lock);
+    status = sai_get_attributes(&key, key_str, scheduler_attribs, scheduler_vendor_attribs, attr_count, attr_list);
+    pthread_rwlock_unlock(&scheduler_db_lock);
+
+    return status;
+}
+
+/* Algorithm [sai_scheduling_type_t], weight [uint8_t], shaper type
+ * [sai_meter_type_t], rates and bursts [uint64_t] */
+sai_status_t stub_scheduler_attr_get(_In_ const sai_object_key_t   *key,
+                                     _Inout_ sai_attribute_value_t *value,
+                                     _In_ uint32_t                  attr_index,
+                                     _Inout_ vendor_cache_t        *cache,
+                                     void                          *arg)
+{
+    const sched_params_t *params;
+    sai_status_t          status;
+    uint32_t              scheduler;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = scheduler_db_index(key->object_id, &scheduler))) {
+        return status;
+    }
+
+    params = &scheduler_db[scheduler].params;
+
+    switch ((long)arg) {
+    case SAI_SCHEDULER_ATTR_SCHEDULING_ALGORITHM:
+        value->s32 = params->algorithm;
+        break;
+
+    case SAI_SCHEDULER_ATTR_SCHEDULING_WEIGHT:
+        value->u8 = (uint8_t)params->weight;
+        break;
+
+    case SAI_SCHEDULER_ATTR_SHAPER_TYPE:
+        value->s32 = params->shaper_type;
+        break;
+
+    case SAI_SCHEDULER_ATTR_MIN_BANDWIDTH_RATE:
+        value->u64 = params->min_rate;
+        break;
+
+    case SAI_SCHEDULER_ATTR_MIN_BANDWIDTH_BURST_RATE:
+        value->u64 = params->min_burst;
+        break;
+
+    case SAI_SCHEDULER_ATTR_MAX_BANDWIDTH_RATE:
+        value->u64 = params->max_rate;
+        break;
+
+    case SAI_SCHEDULER_ATTR_MAX_BANDWIDTH_BURST_RATE:
+        value->u64 = params->max_burst;
+        break;
+    }
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Algorithm [sai_scheduling_type_t], weight [uint8_t], shaper type
+ * [sai_meter_type_t], rates and bursts [uint64_t]. Queues, groups and ports
+ * of the profile take the change at once, with full buckets */
+sai_status_t stub_scheduler_attr_set(_In_ const sai_object_key_t      *key,
+                                     _In_ const sai_attribute_value_t *value,
+                                     void                             *arg)
+{
+    sched_port_t *port;
+    sai_status_t  status;
+    uint32_t      scheduler, ii, jj;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = scheduler_check((long)arg, value))) {
+        return status;
+    }
+
+    pthread_rwlock_wrlock(&scheduler_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = scheduler_db_index(key->object_id, &scheduler))) {
+        pthread_rwlock_unlock(&scheduler_db_lock);
+        return status;
+    }
+
+    scheduler_apply(&scheduler_db[scheduler].params, (long)arg, value);
+
+    for (ii = 0; (ii < PORT_NUMBER) && (0 != scheduler_db[scheduler].ref_count); ii++) {
+        port = &sched_ports[ii];
+        pthread_mutex_lock(&port->lock);
+
+        if (scheduler == port->node.profile) {
+            sched_node_set(&port->node, scheduler, port->now_ns);
+        }
+        for (jj = 0; jj < STUB_QOS_QUEUES; jj++) {
+            if (scheduler == port->queues[jj].node.profile) {
+                sched_node_set(&port->queues[jj].node, scheduler, port->now_ns);
+            }
+        }
+        for (jj = 0; jj < MAX_SCHEDULER_GROUPS; jj++) {
+            if (sched_groups[jj].is_used && (ii == sched_groups[jj].port) &&
+                (scheduler == sched_groups[jj].node.profile)) {
+                sched_node_set(&sched_groups[jj].node, scheduler, port->now_ns);
+            }
+        }
+
+        pthread_mutex_unlock(&port->lock);
+    }
+
+    pthread_rwlock_unlock(&scheduler_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Create Scheduler group
+ *
+ * Arguments:
+ *    [out] scheduler_group_id - Scheduler group id
+ *    [in] attr_count - number of attributes
+ *    [in] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_create_scheduler_group(_Out_ sai_object_id_t     *scheduler_group_id,
+                                         _In_ uint32_t               attr_count,
+                                         _In_ const sai_attribute_t *attr_list)
+{
+    const sai_attribute_value_t *port_id, *level, *max_childs, *scheduler = NULL;
+    uint32_t                     port_index, level_index, max_childs_index, scheduler_index, port, group;
+    sched_group_t               *entry;
+    sai_status_t                 status;
+    char                         list_str[MAX_LIST_VALUE_STR_LEN];
+    char                         key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    if (NULL == scheduler_group_id) {
+        STUB_LOG_ERR("NULL scheduler group id param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS !=
+        (status =
+             check_attribs_metadata(attr_count, attr_list, scheduler_group_attribs, scheduler_group_vendor_attribs,
+                                    SAI_OPERATION_CREATE))) {
+        STUB_LOG_ERR("Failed attribs check\n");
+        return status;
+    }
+
+    sai_attr_list_to_str(attr_count, attr_list, scheduler_group_attribs, MAX_LIST_VALUE_STR_LEN, list_str);
+    STUB_LOG_NTC("Create scheduler group, %s\n", list_str);
+
+    assert(SAI_STATUS_SUCCESS ==
+           find_attrib_in_list(attr_count, attr_list, SAI_SCHEDULER_GROUP_ATTR_PORT_ID, &port_id, &port_index));
+    if ((SAI_STATUS_SUCCESS != stub_object_to_type(port_id->oid, SAI_OBJECT_TYPE_PORT, &port)) ||
+        (port >= PORT_NUMBER)) {
+        STUB_LOG_ERR("Invalid scheduler group port\n");
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + port_index;
+    }
+
+    assert(SAI_STATUS_SUCCESS ==
+           find_attrib_in_list(attr_count, attr_list, SAI_SCHEDULER_GROUP_ATTR_LEVEL, &level, &level_index));
+    if (level->u8 >= STUB_SCHEDULER_LEVELS) {
+        STUB_LOG_ERR("Scheduler group level %u, at most %u\n", level->u8, STUB_SCHEDULER_LEVELS - 1);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + level_index;
+    }
+
+    assert(SAI_STATUS_SUCCESS ==
+           find_attrib_in_list(attr_count, attr_list, SAI_SCHEDULER_GROUP_ATTR_MAX_CHILDS, &max_childs,
+                               &max_childs_index));
+    if ((0 == max_childs->u8) || (max_childs->u8 > STUB_SCHEDULER_MAX_CHILDS)) {
+        STUB_LOG_ERR("Scheduler group max childs %u out of range 1 to %u\n", max_childs->u8,
+                     STUB_SCHEDULER_MAX_CHILDS);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + max_childs_index;
+    }
+
+    find_attrib_in_list(attr_count, attr_list, SAI_SCHEDULER_GROUP_ATTR_SCHEDULER_PROFILE_ID, &scheduler,
+                        &scheduler_index);
+
+    pthread_rwlock_wrlock(&scheduler_db_lock);
+
+    if ((0 == level->u8) && (SCHED_NONE != sched_ports[port].root)) {
+        pthread_rwlock_unlock(&scheduler_db_lock);
+        STUB_LOG_ERR("Port %u already has a level 0 scheduler group\n", port);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + level_index;
+    }
+
+    for (group = 0; group < MAX_SCHEDULER_GROUPS; group++) {
+        if (!sched_groups[group].is_used) {
+            break;
+        }
+    }
+
+    if (MAX_SCHEDULER_GROUPS == group) {
+        pthread_rwlock_unlock(&scheduler_db_lock);
+        STUB_LOG_ERR("Scheduler group table full\n");
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    entry = &sched_groups[group];
+    memset(entry, 0, sizeof(*entry));
+    entry->port         = port;
+    entry->level        = level->u8;
+    entry->max_childs   = max_childs->u8;
+    entry->node.profile = SCHED_NONE;
+    entry->node.parent  = SCHED_NONE;
+
+    if ((NULL != scheduler) &&
+        (SAI_STATUS_SUCCESS != sched_node_bind(&sched_ports[port], &entry->node, scheduler->oid))) {
+        pthread_rwlock_unlock(&scheduler_db_lock);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + scheduler_index;
+    }
+    if (NULL == scheduler) {
+        sched_node_bind(&sched_ports[port], &entry->node, SAI_NULL_OBJECT_ID);
+    }
+
+    pthread_mutex_lock(&sched_ports[port].lock);
+    entry->is_used = true;
+    if (0 == entry->level) {
+        sched_ports[port].root = group;
+    }
+    pthread_mutex_unlock(&sched_ports[port].lock);
+
+    pthread_rwlock_unlock(&scheduler_db_lock);
+
+    if (SAI_STATUS_SUCCESS !=
+        (status = stub_create_object(SAI_OBJECT_TYPE_SCHEDULER_GROUP, group, scheduler_group_id))) {
+        return status;
+    }
+    scheduler_group_key_to_str(*scheduler_group_id, key_str);
+    STUB_LOG_NTC("Created %s\n", key_str);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Remove Scheduler group
+ *
+ * Arguments:
+ *    [in] scheduler_group_id - Scheduler group id
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_remove_scheduler_group(_In_ sai_object_id_t scheduler_group_id)
+{
+    sched_group_t *entry;
+    char           key_str[MAX_KEY_STR_LEN];
+    sai_status_t   status;
+    uint32_t       group;
+
+    STUB_LOG_ENTER();
+
+    scheduler_group_key_to_str(scheduler_group_id, key_str);
+    STUB_LOG_NTC("Remove %s\n", key_str);
+
+    pthread_rwlock_wrlock(&scheduler_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = scheduler_group_db_index(scheduler_group_id, &group))) {
+        pthread_rwlock_unlock(&scheduler_db_lock);
+        return status;
+    }
+
+    entry = &sched_groups[group];
+    if ((0 != entry->child_count) || (SCHED_NONE != entry->node.parent)) {
+        pthread_rwlock_unlock(&scheduler_db_lock);
+        STUB_LOG_ERR("Scheduler group %u has children or a parent\n", group);
+        return SAI_STATUS_OBJECT_IN_USE;
+    }
+
+    sched_node_bind(&sched_ports[entry->port], &entry->node, SAI_NULL_OBJECT_ID);
+
+    pthread_mutex_lock(&sched_ports[entry->port].lock);
+    if (group == sched_ports[entry->port].root) {
+        sched_ports[entry->port].root = SCHED_NONE;
+    }
+    entry->is_used = false;
+    pthread_mutex_unlock(&sched_ports[entry->port].lock);
+
+    pthread_rwlock_unlock(&scheduler_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Set Scheduler group Attribute
+ *
+ * Arguments:
+ *    [in] scheduler_group_id - Scheduler group id
+ *    [in] attr - attribute to set
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_set_scheduler_group_attribute(_In_ sai_object_id_t        scheduler_group_id,
+                                                _In_ const sai_attribute_t *attr)
+{
+    const sai_object_key_t key = { .object_id = scheduler_group_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    scheduler_group_key_to_str(scheduler_group_id, key_str);
+    return sai_set_attribute(&key, key_str, scheduler_group_attribs, scheduler_group_vendor_attribs, attr);
+}
+
+/*
+ * Routine Description:
+ *    Get Scheduler Group attribute
+ *
+ * Arguments:
+ *    [in] scheduler_group_id - scheduler group id
+ *    [in] attr_count - number of attributes
+ *    [inout] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_scheduler_group_attribute(_In_ sai_object_id_t     scheduler_group_id,
+                                                _In_ uint32_t            attr_count,
+                                                _Inout_ sai_attribute_t *attr_list)
+{
+    const sai_object_key_t key = { .object_id = scheduler_group_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
+
+    STUB_LOG_ENTER();
+
+    scheduler_group_key_to_str(scheduler_group_id, key_str);
+
+    pthread_rwlock_rdlock(&scheduler_db_lock);
+    status = sai_get_attributes(&key, key_str, scheduler_group_attribs, scheduler_group_vendor_attribs, attr_count,
+                                attr_list);
+    pthread_rwlock_unlock(&scheduler_db_lock);
+
+    return status;
+}
+
+/* Child count [uint32_t], children [sai_object_list_t], port
+ * [sai_object_id_t], level and max childs [uint8_t], scheduler
+ * [sai_object_id_t] */
+sai_status_t stub_scheduler_group_attr_get(_In_ const sai_object_key_t   *key,
+                                           _Inout_ sai_attribute_value_t *value,
+                                           _In_ uint32_t                  attr_index,
+                                           _Inout_ vendor_cache_t        *cache,
+                                           void                          *arg)
+{
+    sai_object_id_t      children[STUB_SCHEDULER_MAX_CHILDS];
+    const sched_group_t *entry;
+    sai_status_t         status;
+    uint32_t             group, ii;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = scheduler_group_db_index(key->object_id, &group))) {
+        return status;
+    }
+
+    entry = &sched_groups[group];
+
+    switch ((long)arg) {
+    case SAI_SCHEDULER_GROUP_ATTR_CHILD_COUNT:
+        value->u32 = entry->child_count;
+        break;
+
+    case SAI_SCHEDULER_GROUP_ATTR_CHILD_LIST:
+        for (ii = 0; (ii < entry->child_count) && (SAI_STATUS_SUCCESS == status); ii++) {
+            status = sched_child_to_object(entry->port, entry->children[ii], &children[ii]);
+        }
+        if (SAI_STATUS_SUCCESS == status) {
+            status = stub_fill_objlist(children, entry->child_count, &value->objlist);
+        }
+        break;
+
+    case SAI_SCHEDULER_GROUP_ATTR_PORT_ID:
+        status = stub_create_object(SAI_OBJECT_TYPE_PORT, entry->port, &value->oid);
+        break;
+
+    case SAI_SCHEDULER_GROUP_ATTR_LEVEL:
+        value->u8 = entry->level;
+        break;
+
+    case SAI_SCHEDULER_GROUP_ATTR_MAX_CHILDS:
+        value->u8 = entry->max_childs;
+        break;
+
+    case SAI_SCHEDULER_GROUP_ATTR_SCHEDULER_PROFILE_ID:
+        status = sched_node_profile_get(&entry->node, &value->oid);
+        break;
+    }
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* Scheduler [sai_object_id_t], SAI_NULL_OBJECT_ID for the defaults */
+sai_status_t stub_scheduler_group_profile_set(_In_ const sai_object_key_t      *key,
+                                              _In_ const sai_attribute_value_t *value,
+                                              void                             *arg)
+{
+    sai_status_t status;
+    uint32_t     group;
+
+    STUB_LOG_ENTER();
+
+    pthread_rwlock_wrlock(&scheduler_db_lock);
+
+    if (SAI_STATUS_SUCCESS == (status = scheduler_group_db_index(key->object_id, &group))) {
+        status = sched_node_bind(&sched_ports[sched_groups[group].port], &sched_groups[group].node, value->oid);
+    }
+
+    pthread_rwlock_unlock(&scheduler_db_lock);
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* Child reference of a queue or group object to add to a group: on the
+ * port of the group, a level below it and without a parent. Caller holds
+ * scheduler_db_lock */
+static sai_status_t sched_child_index(_In_ const sched_group_t *group,
+                                      _In_ sai_object_id_t      object_id,
+                                      _Out_ uint32_t           *child)
+{
+    uint32_t port, index;
+
+    switch ((long)sai_object_type_query(object_id)) {
+    case SAI_OBJECT_TYPE_QUEUE:
+        if (SAI_STATUS_SUCCESS != queue_db_index(object_id, &port, &index)) {
+            return SAI_STATUS_INVALID_PARAMETER;
+        }
+        *child = index;
+        break;
+
+    case SAI_OBJECT_TYPE_SCHEDULER_GROUP:
+        if (SAI_STATUS_SUCCESS != scheduler_group_db_index(object_id, &index)) {
+            return SAI_STATUS_INVALID_PARAMETER;
+        }
+        if (sched_groups[index].level != group->level + 1) {
+            STUB_LOG_ERR("Scheduler group of level %u under a group of level %u\n", sched_groups[index].level,
+                         group->level);
+            return SAI_STATUS_INVALID_PARAMETER;
+        }
+        port   = sched_groups[index].port;
+        *child = index | SCHED_GROUP_REF;
+        break;
+
+    default:
+        STUB_LOG_ERR("Scheduler group children are queues and scheduler groups\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (port != group->port) {
+        STUB_LOG_ERR("Child on port %u of a scheduler group on port %u\n", port, group->port);
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SCHED_NONE != sched_child_node(&sched_ports[port], *child)->parent) {
+        STUB_LOG_ERR("Scheduler group child already has a parent\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Add Child queue/group objects to scheduler group
+ *
+ * Arguments:
+ *    [in] scheduler_group_id - Scheduler group id
+ *    [in] child_count - number of child count
+ *    [in] child_objects - array of child objects
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_add_child_object_to_group(_In_ sai_object_id_t        scheduler_group_id,
+                                            _In_ uint32_t               child_count,
+                                            _In_ const sai_object_id_t* child_objects)
+{
+    uint32_t       children[STUB_SCHEDULER_MAX_CHILDS];
+    sched_group_t *entry;
+    sched_node_t  *node;
+    sai_status_t   status;
+    uint32_t       group, ii, jj;
+    char           key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    scheduler_group_key_to_str(scheduler_group_id, key_str);
+    STUB_LOG_NTC("Add %u children to %s\n", child_count, key_str);
+
+    if ((0 != child_count) && (NULL == child_objects)) {
+        STUB_LOG_ERR("NULL child objects param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    pthread_rwlock_wrlock(&scheduler_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = scheduler_group_db_index(scheduler_group_id, &group))) {
+        pthread_rwlock_unlock(&scheduler_db_lock);
+        return status;
+    }
+
+    entry = &sched_groups[group];
+    if (child_count > (uint32_t)entry->max_childs - entry->child_count) {
+        pthread_rwlock_unlock(&scheduler_db_lock);
+        STUB_LOG_ERR("Scheduler group %u has %u of %u children, %u more do not fit\n", group, entry->child_count,
+                     entry->max_childs, child_count);
+        return SAI_STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    for (ii = 0; ii < child_count; ii++) {
+        if (SAI_STATUS_SUCCESS != (status = sched_child_index(entry, child_objects[ii], &children[ii]))) {
+            pthread_rwlock_unlock(&scheduler_db_lock);
+            return status;
+        }
+        for (jj = 0; jj < ii; jj++) {
+            if (children[jj] == children[ii]) {
+                pthread_rwlock_unlock(&scheduler_db_lock);
+                STUB_LOG_ERR("Scheduler group child %u given twice\n", ii);
+                return SAI_STATUS_INVALID_PARAMETER;
+            }
+        }
+    }
+
+    pthread_mutex_lock(&sched_ports[entry->port].lock);
+    for (ii = 0; ii < child_count; ii++) {
+        node          = sched_child_node(&sched_ports[entry->port], children[ii]);
+        node->parent  = group;
+        node->deficit = 0;
+        node->granted = false;
+        entry->children[entry->child_count++] = children[ii];
+    }
+    pthread_mutex_unlock(&sched_ports[entry->port].lock);
+
+    pthread_rwlock_unlock(&scheduler_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Remove Child queue/group objects from scheduler group
+ *
+ * Arguments:
+ *    [in] scheduler_group_id - Scheduler group id
+ *    [in] child_count - number of child count
+ *    [in] child_objects - array of child objects
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_remove_child_object_from_group(_In_ sai_object_id_t        scheduler_group_id,
+                                                 _In_ uint32_t               child_count,
+                                                 _In_ const sai_object_id_t* child_objects)
+{
+    sched_group_t *entry;
+    sai_status_t   status;
+    uint32_t       group, child, port, index, ii, jj;
+    char           key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    scheduler_group_key_to_str(scheduler_group_id, key_str);
+    STUB_LOG_NTC("Remove %u children from %s\n", child_count, key_str);
+
+    if ((0 != child_count) && (NULL == child_objects)) {
+        STUB_LOG_ERR("NULL child objects param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    pthread_rwlock_wrlock(&scheduler_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = scheduler_group_db_index(scheduler_group_id, &group))) {
+        pthread_rwlock_unlock(&scheduler_db_lock);
+        return status;
+    }
+
+    entry = &sched_groups[group];
+
+    /* All or nothing */
+    for (ii = 0; ii < child_count; ii++) {
+        if (SAI_OBJECT_TYPE_QUEUE == sai_object_type_query(child_objects[ii])) {
+            status = queue_db_index(child_objects[ii], &port, &child);
+            port   = (SAI_STATUS_SUCCESS == status) ? port : SCHED_NONE;
+        } else {
+            status = scheduler_group_db_index(child_objects[ii], &index);
+            port   = (SAI_STATUS_SUCCESS == status) ? sched_groups[index].port : SCHED_NONE;
+            child  = index | SCHED_GROUP_REF;
+        }
+        if ((port != entry->port) || (group != sched_child_node(&sched_ports[port], child)->parent)) {
+            pthread_rwlock_unlock(&scheduler_db_lock);
+            STUB_LOG_ERR("Object %u is not a child of scheduler group %u\n", ii, group);
+            return SAI_STATUS_INVALID_PARAMETER;
+        }
+    }
+
+    pthread_mutex_lock(&sched_ports[entry->port].lock);
+    for (ii = 0; ii < child_count; ii++) {
+        if (SAI_OBJECT_TYPE_QUEUE == sai_object_type_query(child_objects[ii])) {
+            queue_db_index(child_objects[ii], &port, &child);
+        } else {
+            scheduler_group_db_index(child_objects[ii], &index);
+            child = index | SCHED_GROUP_REF;
+        }
+        sched_child_node(&sched_ports[entry->port], child)->parent = SCHED_NONE;
+        for (jj = 0; jj < entry->child_count; jj++) {
+            if (child == entry->children[jj]) {
+                memmove(&entry->children[jj], &entry->children[jj + 1],
+                        (entry->child_count - jj - 1) * sizeof(entry->children[0]));
+                entry->child_count--;
+                break;
+            }
+        }
+    }
+    if (entry->rr >= entry->child_count) {
+        entry->rr = 0;
+    }
+    pthread_mutex_unlock(&sched_ports[entry->port].lock);
+
+    pthread_rwlock_unlock(&scheduler_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Set attribute to Queue
+ *
+ * Arguments:
+ *    [in] queue_id - queue id to set the attribute
+ *    [in] attr - attribute to set
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_set_queue_attribute(_In_ sai_object_id_t queue_id, _In_ const sai_attribute_t *attr)
+{
+    const sai_object_key_t key = { .object_id = queue_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    queue_key_to_str(queue_id, key_str);
+    return sai_set_attribute(&key, key_str, queue_attribs, queue_vendor_attribs, attr);
+}
+
+/*
+ * Routine Description:
+ *    Get attribute to Queue
+ *
+ * Arguments:
+ *    [in] queue_id - queue id to set the attribute
+ *    [in] attr_count - number of attributes
+ *    [inout] attr_list - Array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_queue_attribute(_In_ sai_object_id_t     queue_id,
+                                      _In_ uint32_t            attr_count,
+                                      _Inout_ sai_attribute_t *attr_list)
+{
+    const sai_object_key_t key = { .object_id = queue_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
+
+    STUB_LOG_ENTER();
+
+    queue_key_to_str(queue_id, key_str);
+
+    pthread_rwlock_rdlock(&scheduler_db_lock);
+    status = sai_get_attributes(&key, key_str, queue_attribs, queue_vendor_attribs, attr_count, attr_list);
+    pthread_rwlock_unlock(&scheduler_db_lock);
+
+    return status;
+}
+
+/* Type [sai_queue_type_t], WRED profile, buffer profile and scheduler
+ * [sai_object_id_t] */
+sai_status_t stub_queue_attr_get(_In_ const sai_object_key_t   *key,
+                                 _Inout_ sai_attribute_value_t *value,
+                                 _In_ uint32_t                  attr_index,
+                                 _Inout_ vendor_cache_t        *cache,
+                                 void                          *arg)
+{
+    sai_status_t status;
+    uint32_t     port, queue;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = queue_db_index(key->object_id, &port, &queue))) {
+        return status;
+    }
+
+    switch ((long)arg) {
+    case SAI_QUEUE_ATTR_TYPE:
+        value->s32 = SAI_QUEUE_TYPE_ALL;
+        break;
+
+    case SAI_QUEUE_ATTR_WRED_PROFILE_ID:
+        value->oid = SAI_NULL_OBJECT_ID;
+        if (STUB_NO_WRED != sched_ports[port].queues[queue].wred) {
+            status = stub_create_object(SAI_OBJECT_TYPE_WRED, sched_ports[port].queues[queue].wred, &value->oid);
+        }
+        break;
+
+    case SAI_QUEUE_ATTR_BUFFER_PROFILE_ID:
+        status = db_get_queue_buffer(port, queue, &value->oid);
+        break;
+
+    case SAI_QUEUE_ATTR_SCHEDULER_PROFILE_ID:
+        status = sched_node_profile_get(&sched_ports[port].queues[queue].node, &value->oid);
+        break;
+    }
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* Scheduler [sai_object_id_t], SAI_NULL_OBJECT_ID for the defaults */
+sai_status_t stub_queue_profile_set(_In_ const sai_object_key_t      *key,
+                                    _In_ const sai_attribute_value_t *value,
+                                    void                             *arg)
+{
+    sai_status_t status;
+    uint32_t     port, queue;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = queue_db_index(key->object_id, &port, &queue))) {
+        return status;
+    }
+
+    pthread_rwlock_wrlock(&scheduler_db_lock);
+    status = sched_node_bind(&sched_ports[port], &sched_ports[port].queues[queue].node, value->oid);
+    pthread_rwlock_unlock(&scheduler_db_lock);
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* WRED profile [sai_object_id_t], SAI_NULL_OBJECT_ID for none. The queue
+ * average starts over */
+sai_status_t stub_queue_wred_set(_In_ const sai_object_key_t      *key,
+                                 _In_ const sai_attribute_value_t *value,
+                                 void                             *arg)
+{
+    sched_queue_t *queue;
+    sai_status_t   status;
+    uint32_t       port, index, wred = STUB_NO_WRED, old;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = queue_db_index(key->object_id, &port, &index))) {
+        return status;
+    }
+
+    if ((SAI_NULL_OBJECT_ID != value->oid) && (SAI_STATUS_SUCCESS != (status = db_wred_bind(value->oid, &wred)))) {
+        return status;
+    }
+
+    queue = &sched_ports[port].queues[index];
+
+    pthread_rwlock_wrlock(&scheduler_db_lock);
+    pthread_mutex_lock(&sched_ports[port].lock);
+    old             = queue->wred;
+    queue->wred     = wred;
+    queue->wred_avg = 0;
+    pthread_mutex_unlock(&sched_ports[port].lock);
+    pthread_rwlock_unlock(&scheduler_db_lock);
+
+    db_wred_unbind(old);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Buffer profile of an egress pool [sai_object_id_t], SAI_NULL_OBJECT_ID
+ * for none. The frames the queue holds move along */
+sai_status_t stub_queue_buffer_set(_In_ const sai_object_key_t      *key,
+                                   _In_ const sai_attribute_value_t *value,
+                                   void                             *arg)
+{
+    sai_status_t status;
+    uint32_t     port, queue;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = queue_db_index(key->object_id, &port, &queue))) {
+        return status;
+    }
+
+    status = db_set_queue_buffer(port, queue, value->oid);
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+static sai_status_t queue_check_counters(_In_ const sai_queue_stat_counter_t *counter_ids,
+                                         _In_ uint32_t                        number_of_counters)
+{
+    uint32_t ii;
+
+    if (NULL == counter_ids) {
+        STUB_LOG_ERR("NULL counter ids array param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    for (ii = 0; ii < number_of_counters; ii++) {
+        if ((counter_ids[ii] < SAI_QUEUE_STAT_PACKETS) || (SCHED_STAT(counter_ids[ii]) >= SCHED_STAT_COUNT) ||
+            ((counter_ids[ii] >= SCHED_SAI_STATS) && (counter_ids[ii] < SAI_QUEUE_STAT_CUSTOM_RANGE_BASE))) {
+            STUB_LOG_ERR("Invalid queue counter %d\n", counter_ids[ii]);
+            return SAI_STATUS_INVALID_PARAMETER;
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Get queue statistics counters.
+ *
+ * Arguments:
+ *    [in] queue_id - Queue id
+ *    [in] counter_ids - specifies the array of counter ids
+ *    [in] number_of_counters - number of counters in the array
+ *    [out] counters - array of resulting counter values.
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_queue_stats(_In_ sai_object_id_t                 queue_id,
+                                  _In_ const sai_queue_stat_counter_t *counter_ids,
+                                  _In_ uint32_t                        number_of_counters,
+                                  _Out_ uint64_t                      *counters)
+{
+    const sched_queue_t *queue;
+    sai_status_t         status;
+    uint32_t             port, index, ii;
+    char                 key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    queue_key_to_str(queue_id, key_str);
+    STUB_LOG_DBG("Get queue stats %s\n", key_str);
+
+    if (NULL == counters) {
+        STUB_LOG_ERR("NULL counters array param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS != (status = queue_check_counters(counter_ids, number_of_counters))) {
+        return status;
+    }
+
+    if (SAI_STATUS_SUCCESS != (status = queue_db_index(queue_id, &port, &index))) {
+        return status;
+    }
+
+    queue = &sched_ports[port].queues[index];
+
+    pthread_mutex_lock(&sched_ports[port].lock);
+    for (ii = 0; ii < number_of_counters; ii++) {
+        counters[ii] = (SAI_QUEUE_STAT_CURR_OCCUPANCY_BYTES == counter_ids[ii]) ? queue->bytes :
+                       queue->stats[SCHED_STAT(counter_ids[ii])];
+    }
+    pthread_mutex_unlock(&sched_ports[port].lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Clear queue statistics counters. The watermark restarts from the
+ *    current occupancy, the occupancy itself stays
+ *
+ * Arguments:
+ *    [in] queue_id - Queue id
+ *    [in] counter_ids - specifies the array of counter ids
+ *    [in] number_of_counters - number of counters in the array
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_clear_queue_stats(_In_ sai_object_id_t                 queue_id,
+                                    _In_ const sai_queue_stat_counter_t *counter_ids,
+                                    _In_ uint32_t                        number_of_counters)
+{
+    sched_queue_t *queue;
+    sai_status_t   status;
+    uint32_t       port, index, ii;
+    char           key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    queue_key_to_str(queue_id, key_str);
+    STUB_LOG_NTC("Clear queue stats %s\n", key_str);
+
+    if (SAI_STATUS_SUCCESS != (status = queue_check_counters(counter_ids, number_of_counters))) {
+        return status;
+    }
+
+    if (SAI_STATUS_SUCCESS != (status = queue_db_index(queue_id, &port, &index))) {
+        return status;
+    }
+
+    queue = &sched_ports[port].queues[index];
+
+    pthread_mutex_lock(&sched_ports[port].lock);
+    for (ii = 0; ii < number_of_counters; ii++) {
+        queue->stats[SCHED_STAT(counter_ids[ii])] = (SAI_QUEUE_STAT_WATERMARK_BYTES == counter_ids[ii]) ?
+                                                    queue->bytes : 0;
+    }
+    pthread_mutex_unlock(&sched_ports[port].lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+const sai_scheduler_api_t scheduler_api = {
+    stub_create_scheduler_profile,
+    stub_remove_scheduler_profile,
+    stub_set_scheduler_attribute,
+    stub_get_scheduler_attribute,
+};
+
+const sai_scheduler_group_api_t scheduler_group_api = {
+    stub_create_scheduler_group,
+    stub_remove_scheduler_group,
+    stub_set_scheduler_group_attribute,
+    stub_get_scheduler_group_attribute,
+    stub_add_child_object_to_group,
+    stub_remove_child_object_from_group,
+};
+
+const sai_queue_api_t queue_api = {
+    stub_set_queue_attribute,
+    stub_get_queue_attribute,
+    stub_get_queue_stats,
+    stub_clear_queue_stats,
+};
@@ -17,6 +17,11 @@
 
 #include "sai.h"
 #include "stub_sai.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_counter.h"
+#include "stub_sai_acl.h"
+#include "stub_sai_hash.h"
+#include "stub_sai_buffer.h"
 
 #undef  __MODULE__
 #define __MODULE__ SAI_SWITCH
@@ -54,6 +59,11 @@ sai_status_t stub_switch_max_temp_get(_In_ const sai_object_key_t   *key,
                                       _In_ uint32_t                  attr_index,
                                       _Inout_ vendor_cache_t        *cache,
                                       void                          *arg);
+sai_status_t stub_switch_buffer_get(_In_ const sai_object_key_t   *key,
+                                    _Inout_ sai_attribute_value_t *value,
+                                    _In_ uint32_t                  attr_index,
+                                    _Inout_ vendor_cache_t        *cache,
+                                    void                          *arg);
 sai_status_t stub_switch_default_stp_get(_In_ const sai_object_key_t   *key,
                                          _Inout_ sai_attribute_value_t *value,
                                          _In_ uint32_t                  attr_index,
@@ -109,21 +119,21 @@ sai_status_t stub_switch_aging_time_get(_In_ const sai_object_key_t   *key,
                                         _In_ uint32_t                  attr_index,
                                         _Inout_ vendor_cache_t        *cache,
                                         void                          *arg);
-sai_status_t stub_switch_ecmp_hash_seed_get(_In_ const sai_object_key_t   *key,
-                                            _Inout_ sai_attribute_value_t *value,
-                                            _In_ uint32_t                  attr_index,
-                                            _Inout_ vendor_cache_t        *cache,
-                                            void                          *arg);
-sai_status_t stub_switch_ecmp_hash_algo_get(_In_ const sai_object_key_t   *key,
-                                            _Inout_ sai_attribute_value_t *value,
-                                            _In_ uint32_t                  attr_index,
-                                            _Inout_ vendor_cache_t        *cache,
-                                            void                          *arg);
-sai_status_t stub_switch_ecmp_hash_fields_get(_In_ const sai_object_key_t   *key,
-                                              _Inout_ sai_attribute_value_t *value,
-                                              _In_ uint32_t                  attr_index,
-                                              _Inout_ vendor_cache_t        *cache,
-                                              void                          *arg);
+sai_status_t stub_switch_hash_seed_get(_In_ const sai_object_key_t   *key,
+                                       _Inout_ sai_attribute_value_t *value,
+                                       _In_ uint32_t                  attr_index,
+                                       _Inout_ vendor_cache_t        *cache,
+                                       void                          *arg);
+sai_status_t stub_switch_hash_algo_get(_In_ const sai_object_key_t   *key,
+                                       _Inout_ sai_attribute_value_t *value,
+                                       _In_ uint32_t                  attr_index,
+                                       _Inout_ vendor_cache_t        *cache,
+                                       void                          *arg);
+sai_status_t stub_switch_hash_get(_In_ const sai_object_key_t   *key,
+                                  _Inout_ sai_attribute_value_t *value,
+                                  _In_ uint32_t                  attr_index,
+                                  _Inout_ vendor_cache_t        *cache,
+                                  void                          *arg);
 sai_status_t stub_switch_counter_refresh_get(_In_ const sai_object_key_t   *key,
                                              _Inout_ sai_attribute_value_t *value,
                                              _In_ uint32_t                  attr_index,
@@ -153,15 +163,15 @@ sai_status_t stub_switch_default_port_vlan_set(_In_ const sai_object_key_t
 sai_status_t stub_switch_aging_time_set(_In_ const sai_object_key_t      *key,
                                         _In_ const sai_attribute_value_t *value,
                                         void                             *arg);
-sai_status_t stub_switch_ecmp_hash_seed_set(_In_ const sai_object_key_t      *key,
-                                            _In_ const sai_attribute_value_t *value,
-                                            void                             *arg);
-sai_status_t stub_switch_ecmp_hash_algo_set(_In_ const sai_object_key_t      *key,
-                                            _In_ const sai_attribute_value_t *value,
-                                            void                             *arg);
-sai_status_t stub_switch_ecmp_hash_fields_set(_In_ const sai_object_key_t      *key,
-                                              _In_ const sai_attribute_value_t *value,
-                                              void                             *arg);
+sai_status_t stub_switch_hash_seed_set(_In_ const sai_object_key_t      *key,
+                                       _In_ const sai_attribute_value_t *value,
+                                       void                             *arg);
+sai_status_t stub_switch_hash_algo_set(_In_ const sai_object_key_t      *key,
+                                       _In_ const sai_attribute_value_t *value,
+                                       void                             *arg);
+sai_status_t stub_switch_hash_set(_In_ const sai_object_key_t      *key,
+                                  _In_ const sai_attribute_value_t *value,
+                                  void                             *arg);
 sai_status_t stub_switch_counter_refresh_set(_In_ const sai_object_key_t      *key,
                                              _In_ const sai_attribute_value_t *value,
                                              void                             *arg);
@@ -192,6 +202,12 @@ static const sai_attribute_entry_t        switch_attribs[] = {
       "Switch operational status", SAI_ATTR_VAL_TYPE_S32 },
     { SAI_SWITCH_ATTR_MAX_TEMP, false, false, false, true,
       "Switch maximum temperature", SAI_ATTR_VAL_TYPE_S32 },
+    { SAI_SWITCH_ATTR_TOTAL_BUFFER_SIZE, false, false, false, true,
+      "Switch total buffer size", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_SWITCH_ATTR_INGRESS_BUFFER_POOL_NUM, false, false, false, true,
+      "Switch ingress buffer pools", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_SWITCH_ATTR_EGRESS_BUFFER_POOL_NUM, false, false, false, true,
+      "Switch egress buffer pools", SAI_ATTR_VAL_TYPE_U32 },
     { SAI_SWITCH_ATTR_ACL_TABLE_MINIMUM_PRIORITY, false, false, false, true,
       "Switch ACL table min prio", SAI_ATTR_VAL_TYPE_U32 },
     { SAI_SWITCH_ATTR_ACL_TABLE_MAXIMUM_PRIORITY, false, false, false, true,
@@ -225,13 +241,13 @@ static const sai_attribute_entry_t        switch_attribs[] = {
     { SAI_SWITCH_ATTR_LAG_DEFAULT_HASH_ALGORITHM, false, false, true, true,
       "Switch LAG hash algorithm", SAI_ATTR_VAL_TYPE_S32 },
     { SAI_SWITCH_ATTR_LAG_HASH, false, false, true, true,
-      "Switch LAG hash fields", SAI_ATTR_VAL_TYPE_S32LIST },
+      "Switch LAG hash", SAI_ATTR_VAL_TYPE_OID },
     { SAI_SWITCH_ATTR_ECMP_DEFAULT_HASH_SEED, false, false, true, true,
       "Switch ECMP hash seed", SAI_ATTR_VAL_TYPE_U32 },
     { SAI_SWITCH_ATTR_ECMP_DEFAULT_HASH_ALGORITHM, false, false, true, true,
       "Switch ECMP hash algorithm", SAI_ATTR_VAL_TYPE_S32 },
     { SAI_SWITCH_ATTR_ECMP_HASH, false, false, true, true,
-      "Switch ECMP hash fields", SAI_ATTR_VAL_TYPE_S32LIST },
+      "Switch ECMP hash", SAI_ATTR_VAL_TYPE_OID },
     { SAI_SWITCH_ATTR_COUNTER_REFRESH_INTERVAL, false, false, true, true,
       "Switch counter refresh interval", SAI_ATTR_VAL_TYPE_U32 },
     { SAI_SWITCH_ATTR_DEFAULT_TRAP_GROUP, false, false, true, true,
@@ -282,6 +298,21 @@ static const sai_vendor_attribute_entry_t switch_vendor_attribs[] = {
       { false, false, false, true },
       stub_switch_max_temp_get, NULL,
       NULL, NULL },
+    { SAI_SWITCH_ATTR_TOTAL_BUFFER_SIZE,
+      { false, false, false, true },
+      { false, false, false, true },
+      stub_switch_buffer_get, (void*)SAI_SWITCH_ATTR_TOTAL_BUFFER_SIZE,
+      NULL, NULL },
+    { SAI_SWITCH_ATTR_INGRESS_BUFFER_POOL_NUM,
+      { false, false, false, true },
+      { false, false, false, true },
+      stub_switch_buffer_get, (void*)SAI_SWITCH_ATTR_INGRESS_BUFFER_POOL_NUM,
+      NULL, NULL },
+    { SAI_SWITCH_ATTR_EGRESS_BUFFER_POOL_NUM,
+      { false, false, false, true },
+      { false, false, false, true },
+      stub_switch_buffer_get, (void*)SAI_SWITCH_ATTR_EGRESS_BUFFER_POOL_NUM,
+      NULL, NULL },
     { SAI_SWITCH_ATTR_ACL_TABLE_MINIMUM_PRIORITY,
       { false, false, false, true },
       { false, false, false, true },
@@ -353,35 +384,35 @@ static const sai_vendor_attribute_entry_t switch_vendor_attribs[] = {
       NULL, NULL,
       NULL, NULL },
     { SAI_SWITCH_ATTR_LAG_DEFAULT_HASH_SEED,
-      { false, false, false, false },
       { false, false, true, true },
-      NULL, NULL,
-      NULL, NULL },
+      { false, false, true, true },
+      stub_switch_hash_seed_get, (void*)STUB_HASH_TYPE_LAG,
+      stub_switch_hash_seed_set, (void*)STUB_HASH_TYPE_LAG },
     { SAI_SWITCH_ATTR_LAG_DEFAULT_HASH_ALGORITHM,
-      { false, false, false, false },
       { false, false, true, true },
-      NULL, NULL,
-      NULL, NULL },
+      { false, false, true, true },
+      stub_switch_hash_algo_get, (void*)STUB_HASH_TYPE_LAG,
+      stub_switch_hash_algo_set, (void*)STUB_HASH_TYPE_LAG },
     { SAI_SWITCH_ATTR_LAG_HASH,
-      { false, false, false, false },
       { false, false, true, true },
-      NULL, NULL,
-      NULL, NULL },
+      { false, false, true, true },
+      stub_switch_hash_get, (void*)STUB_HASH_TYPE_LAG,
+      stub_switch_hash_set, (void*)STUB_HASH_TYPE_LAG },
     { SAI_SWITCH_ATTR_ECMP_DEFAULT_HASH_SEED,
       { false, false, true, true },
       { false, false, true, true },
-      stub_switch_ecmp_hash_seed_get, NULL,
-      stub_switch_ecmp_hash_seed_set, NULL },
+      stub_switch_hash_seed_get, (void*)STUB_HASH_TYPE_ECMP,
+      stub_switch_hash_seed_set, (void*)STUB_HASH_TYPE_ECMP },
     { SAI_SWITCH_ATTR_ECMP_DEFAULT_HASH_ALGORITHM,
       { false, false, true, true },
       { false, false, true, true },
-      stub_switch_ecmp_hash_algo_get, NULL,
-      stub_switch_ecmp_hash_algo_set, NULL },
+      stub_switch_hash_algo_get, (void*)STUB_HASH_TYPE_ECMP,
+      stub_switch_hash_algo_set, (void*)STUB_HASH_TYPE_ECMP },
     { SAI_SWITCH_ATTR_ECMP_HASH,
       { false, false, true, true },
       { false, false, true, true },
-      stub_switch_ecmp_hash_fields_get, NULL,
-      stub_switch_ecmp_hash_fields_set, NULL },
+      stub_switch_hash_get, (void*)STUB_HASH_TYPE_ECMP,
+      stub_switch_hash_set, (void*)STUB_HASH_TYPE_ECMP },
     { SAI_SWITCH_ATTR_COUNTER_REFRESH_INTERVAL,
       { false, false, true, true },
       { false, false, true, true },
@@ -442,6 +473,23 @@ sai_status_t stub_initialize_switch(_In_ sai_switch_profile_id_t
 
     db_init_vlan();
     db_init_next_hop_group();
+    db_init_fdb();
+    db_init_route();
+    db_init_neighbor();
+    db_init_next_hop();
+    db_init_rif();
+    db_init_port();
+    db_init_host_interface(profile_id);
+    db_init_policer();
+    db_init_qos_map();
+    db_init_wred();
+    db_init_buffer();
+    db_init_mirror();
+    db_init_scheduler();
+    db_init_hostif_trap();
+    db_init_udf();
+    db_init_acl();
+    db_init_hash();
 
     return SAI_STATUS_SUCCESS;
 }
@@ -462,6 +510,9 @@ sai_status_t stub_initialize_switch(_In_ sai_switch_profile_id_t
 void stub_shutdown_switch(_In_ bool warm_restart_hint)
 {
     STUB_LOG_NTC("Shutdown switch\n");
+    stub_counter_poll_stop();
+    stub_dataplane_stop();
+    db_stop_host_interface_io();
     gh_sdk = 0;
 }
 
@@ -593,92 +644,47 @@ sai_status_t stub_switch_aging_time_set(_In_ const sai_object_key_t      *key,
     return SAI_STATUS_SUCCESS;
 }
 
-/* ECMP hashing seed  [uint32_t] */
-sai_status_t stub_switch_ecmp_hash_seed_set(_In_ const sai_object_key_t      *key,
-                                            _In_ const sai_attribute_value_t *value,
-                                            void                             *arg)
+/* ECMP and LAG hashing seed [uint32_t] */
+sai_status_t stub_switch_hash_seed_set(_In_ const sai_object_key_t      *key,
+                                       _In_ const sai_attribute_value_t *value,
+                                       void                             *arg)
 {
     STUB_LOG_ENTER();
 
+    db_set_switch_hash_seed((long)arg, value->u32);
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
 
-/* Hash algorithm for all ECMP in the switch[sai_switch_hash_algo_t] */
-sai_status_t stub_switch_ecmp_hash_algo_set(_In_ const sai_object_key_t      *key,
-                                            _In_ const sai_attribute_value_t *value,
-                                            void                             *arg)
+/* Hash algorithm for all ECMP or LAG in the switch [sai_hash_algorithm_t] */
+sai_status_t stub_switch_hash_algo_set(_In_ const sai_object_key_t      *key,
+                                       _In_ const sai_attribute_value_t *value,
+                                       void                             *arg)
 {
-    STUB_LOG_ENTER();
-
-    switch (value->s32) {
-    case SAI_HASH_ALGORITHM_XOR:
-        break;
+    sai_status_t status;
 
-    case SAI_HASH_ALGORITHM_CRC:
-        break;
+    STUB_LOG_ENTER();
 
-    case SAI_HASH_ALGORITHM_RANDOM:
-        break;
-
-    default:
-        STUB_LOG_ERR("Invalid hash type value %d\n", value->s32);
-        return SAI_STATUS_INVALID_ATTR_VALUE_0;
-    }
+    status = db_set_switch_hash_algorithm((long)arg, value->s32);
 
     STUB_LOG_EXIT();
-    return SAI_STATUS_SUCCESS;
+    return status;
 }
 
-/* Hash fields for all ECMP in the switch[sai_s32_list_t] */
-sai_status_t stub_switch_ecmp_hash_fields_set(_In_ const sai_object_key_t      *key,
-                                              _In_ const sai_attribute_value_t *value,
-                                              void                             *arg)
+/* Hash object for all ECMP or LAG in the switch [sai_object_id_t] */
+sai_status_t stub_switch_hash_set(_In_ const sai_object_key_t      *key,
+                                  _In_ const sai_attribute_value_t *value,
+                                  void                             *arg)
 {
-    uint32_t ii;
+    sai_status_t status;
 
     STUB_LOG_ENTER();
 
-    for (ii = 0; ii < value->s32list.count; ii++) {
-        switch (value->s32list.list[ii]) {
-        case SAI_NATIVE_HASH_FIELD_SRC_IP:
-            break;
-
-        case SAI_NATIVE_HASH_FIELD_DST_IP:
-            break;
-
-        case SAI_NATIVE_HASH_FIELD_VLAN_ID:
-            break;
-
-        case SAI_NATIVE_HASH_FIELD_IP_PROTOCOL:
-            break;
-
-        case SAI_NATIVE_HASH_FIELD_ETHERTYPE:
-            break;
-
-        case SAI_NATIVE_HASH_FIELD_L4_SRC_PORT:
-            break;
-
-        case SAI_NATIVE_HASH_FIELD_L4_DST_PORT:
-            break;
-
-        case SAI_NATIVE_HASH_FIELD_SRC_MAC:
-            break;
-
-        case SAI_NATIVE_HASH_FIELD_DST_MAC:
-            break;
-
-        case SAI_NATIVE_HASH_FIELD_IN_PORT:
-            break;
-
-        default:
-            STUB_LOG_ERR("Invalid ecmp hash field , element %d, value %d\n", ii, value->s32list.list[ii]);
-            return SAI_STATUS_INVALID_ATTR_VALUE_0;
-        }
-    }
+    status = db_set_switch_hash((long)arg, value->oid);
 
     STUB_LOG_EXIT();
-    return SAI_STATUS_SUCCESS;
+    return status;
 }
 
 /* The SDK can
@@ -732,8 +738,14 @@ sai_status_t stub_switch_default_trap_group_set(_In_ const sai_object_key_t
                                                 _In_ const sai_attribute_value_t *value,
                                                 void                             *arg)
 {
+    sai_status_t status;
+
     STUB_LOG_ENTER();
 
+    if (SAI_STATUS_SUCCESS != (status = db_set_default_trap_group(value->oid))) {
+        return status;
+    }
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -862,6 +874,31 @@ sai_status_t stub_switch_max_temp_get(_In_ const sai_object_key_t   *key,
     return SAI_STATUS_SUCCESS;
 }
 
+/* Total buffer size in KB [uint32_t], number of ingress and of egress
+ * buffer pools [uint32_t] */
+sai_status_t stub_switch_buffer_get(_In_ const sai_object_key_t   *key,
+                                    _Inout_ sai_attribute_value_t *value,
+                                    _In_ uint32_t                  attr_index,
+                                    _Inout_ vendor_cache_t        *cache,
+                                    void                          *arg)
+{
+    STUB_LOG_ENTER();
+
+    switch ((long)arg) {
+    case SAI_SWITCH_ATTR_TOTAL_BUFFER_SIZE:
+        value->u32 = STUB_BUFFER_SIZE / 1024;
+        break;
+
+    case SAI_SWITCH_ATTR_INGRESS_BUFFER_POOL_NUM:
+    case SAI_SWITCH_ATTR_EGRESS_BUFFER_POOL_NUM:
+        value->u32 = STUB_BUFFER_POOLS;
+        break;
+    }
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
 /* Default SAI STP instance ID [sai_object_id_t] */
 sai_status_t stub_switch_default_stp_get(_In_ const sai_object_key_t   *key,
                                          _Inout_ sai_attribute_value_t *value,
@@ -923,6 +960,8 @@ sai_status_t stub_switch_acl_table_min_prio_get(_In_ const sai_object_key_t   *k
 {
     STUB_LOG_ENTER();
 
+    value->u32 = STUB_ACL_TABLE_MIN_PRIORITY;
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -936,6 +975,8 @@ sai_status_t stub_switch_acl_table_max_prio_get(_In_ const sai_object_key_t   *k
 {
     STUB_LOG_ENTER();
 
+    value->u32 = STUB_ACL_TABLE_MAX_PRIORITY;
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -949,6 +990,8 @@ sai_status_t stub_switch_acl_entry_min_prio_get(_In_ const sai_object_key_t   *k
 {
     STUB_LOG_ENTER();
 
+    value->u32 = STUB_ACL_ENTRY_MIN_PRIORITY;
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -962,6 +1005,8 @@ sai_status_t stub_switch_acl_entry_max_prio_get(_In_ const sai_object_key_t   *k
 {
     STUB_LOG_ENTER();
 
+    value->u32 = STUB_ACL_ENTRY_MAX_PRIORITY;
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -1029,45 +1074,47 @@ sai_status_t stub_switch_aging_time_get(_In_ const sai_object_key_t   *key,
     return SAI_STATUS_SUCCESS;
 }
 
-/* ECMP hashing seed  [uint32_t] */
-sai_status_t stub_switch_ecmp_hash_seed_get(_In_ const sai_object_key_t   *key,
-                                            _Inout_ sai_attribute_value_t *value,
-                                            _In_ uint32_t                  attr_index,
-                                            _Inout_ vendor_cache_t        *cache,
-                                            void                          *arg)
+/* ECMP and LAG hashing seed [uint32_t] */
+sai_status_t stub_switch_hash_seed_get(_In_ const sai_object_key_t   *key,
+                                       _Inout_ sai_attribute_value_t *value,
+                                       _In_ uint32_t                  attr_index,
+                                       _Inout_ vendor_cache_t        *cache,
+                                       void                          *arg)
 {
     STUB_LOG_ENTER();
 
-    value->u32 = 0;
+    value->u32 = db_get_switch_hash_seed((long)arg);
 
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
 
-/* Hash algorithm for all ECMP in the switch[sai_switch_hash_algo_t] */
-sai_status_t stub_switch_ecmp_hash_algo_get(_In_ const sai_object_key_t   *key,
-                                            _Inout_ sai_attribute_value_t *value,
-                                            _In_ uint32_t                  attr_index,
-                                            _Inout_ vendor_cache_t        *cache,
-                                            void                          *arg)
+/* Hash algorithm for all ECMP or LAG in the switch [sai_hash_algorithm_t] */
+sai_status_t stub_switch_hash_algo_get(_In_ const sai_object_key_t   *key,
+                                       _Inout_ sai_attribute_value_t *value,
+                                       _In_ uint32_t                  attr_index,
+                                       _Inout_ vendor_cache_t        *cache,
+                                       void                          *arg)
 {
     STUB_LOG_ENTER();
 
-    value->s32 = SAI_HASH_ALGORITHM_XOR;
+    value->s32 = db_get_switch_hash_algorithm((long)arg);
 
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
 
-/* Hash fields for all ECMP in the switch [sai_s32_list_t] */
-sai_status_t stub_switch_ecmp_hash_fields_get(_In_ const sai_object_key_t   *key,
-                                              _Inout_ sai_attribute_value_t *value,
-                                              _In_ uint32_t                  attr_index,
-                                              _Inout_ vendor_cache_t        *cache,
-                                              void                          *arg)
+/* Hash object for all ECMP or LAG in the switch [sai_object_id_t] */
+sai_status_t stub_switch_hash_get(_In_ const sai_object_key_t   *key,
+                                  _Inout_ sai_attribute_value_t *value,
+                                  _In_ uint32_t                  attr_index,
+                                  _Inout_ vendor_cache_t        *cache,
+                                  void                          *arg)
 {
     STUB_LOG_ENTER();
 
+    value->oid = db_get_switch_hash((long)arg);
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -1133,6 +1180,8 @@ sai_status_t stub_switch_default_trap_group_get(_In_ const sai_object_key_t   *k
 {
     STUB_LOG_ENTER();
 
+    value->oid = db_get_default_trap_group();
+
     STUB_LOG_EXIT();
     return SAI_STATUS_SUCCESS;
 }
@@ -0,0 +1,1452 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#include "sai.h"
+#include "stub_sai.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_udf.h"
+#include "assert.h"
+
+#undef  __MODULE__
+#define __MODULE__ SAI_UDF
+
+static const sai_attribute_entry_t udf_attribs[] = {
+    { SAI_UDF_ATTR_MATCH_ID, true, true, false, true,
+      "UDF match", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_UDF_ATTR_GROUP_ID, true, true, false, true,
+      "UDF group", SAI_ATTR_VAL_TYPE_OID },
+    { SAI_UDF_ATTR_BASE, false, true, true, true,
+      "UDF base", SAI_ATTR_VAL_TYPE_S32 },
+    { SAI_UDF_ATTR_OFFSET, true, true, true, true,
+      "UDF offset", SAI_ATTR_VAL_TYPE_U16 },
+    { SAI_UDF_ATTR_HASH_MASK, false, true, true, true,
+      "UDF hash mask", SAI_ATTR_VAL_TYPE_U8LIST },
+    { END_FUNCTIONALITY_ATTRIBS_ID, false, false, false, false,
+      "", SAI_ATTR_VAL_TYPE_UNDETERMINED }
+};
+
+static const sai_attribute_entry_t udf_match_attribs[] = {
+    { SAI_UDF_MATCH_ATTR_L2_TYPE, false, true, false, true,
+      "UDF match L2 type", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_UDF_MATCH_ATTR_L3_TYPE, false, true, false, true,
+      "UDF match L3 type", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_UDF_MATCH_ATTR_GRE_TYPE, false, true, false, true,
+      "UDF match GRE type", SAI_ATTR_VAL_TYPE_ACLFIELD },
+    { SAI_UDF_MATCH_ATTR_PRIORITY, false, true, false, true,
+      "UDF match priority", SAI_ATTR_VAL_TYPE_U8 },
+    { END_FUNCTIONALITY_ATTRIBS_ID, false, false, false, false,
+      "", SAI_ATTR_VAL_TYPE_UNDETERMINED }
+};
+
+static const sai_attribute_entry_t udf_group_attribs[] = {
+    { SAI_UDF_GROUP_ATTR_UDF_LIST, false, false, false, true,
+      "UDF group UDFs", SAI_ATTR_VAL_TYPE_OBJLIST },
+    { SAI_UDF_GROUP_ATTR_TYPE, false, true, false, true,
+      "UDF group type", SAI_ATTR_VAL_TYPE_S32 },
+    { SAI_UDF_ATTR_LENGTH, true, true, false, true,
+      "UDF group length", SAI_ATTR_VAL_TYPE_U16 },
+    { END_FUNCTIONALITY_ATTRIBS_ID, false, false, false, false,
+      "", SAI_ATTR_VAL_TYPE_UNDETERMINED }
+};
+
+sai_status_t stub_udf_attr_get(_In_ const sai_object_key_t   *key,
+                               _Inout_ sai_attribute_value_t *value,
+                               _In_ uint32_t                  attr_index,
+                               _Inout_ vendor_cache_t        *cache,
+                               void                          *arg);
+sai_status_t stub_udf_attr_set(_In_ const sai_object_key_t      *key,
+                               _In_ const sai_attribute_value_t *value,
+                               void                             *arg);
+sai_status_t stub_udf_match_attr_get(_In_ const sai_object_key_t   *key,
+                                     _Inout_ sai_attribute_value_t *value,
+                                     _In_ uint32_t                  attr_index,
+                                     _Inout_ vendor_cache_t        *cache,
+                                     void                          *arg);
+sai_status_t stub_udf_group_attr_get(_In_ const sai_object_key_t   *key,
+                                     _Inout_ sai_attribute_value_t *value,
+                                     _In_ uint32_t                  attr_index,
+                                     _Inout_ vendor_cache_t        *cache,
+                                     void                          *arg);
+
+static const sai_vendor_attribute_entry_t udf_vendor_attribs[] = {
+    { SAI_UDF_ATTR_MATCH_ID,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_udf_attr_get, (void*)SAI_UDF_ATTR_MATCH_ID,
+      NULL, NULL },
+    { SAI_UDF_ATTR_GROUP_ID,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_udf_attr_get, (void*)SAI_UDF_ATTR_GROUP_ID,
+      NULL, NULL },
+    { SAI_UDF_ATTR_BASE,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_udf_attr_get, (void*)SAI_UDF_ATTR_BASE,
+      stub_udf_attr_set, (void*)SAI_UDF_ATTR_BASE },
+    { SAI_UDF_ATTR_OFFSET,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_udf_attr_get, (void*)SAI_UDF_ATTR_OFFSET,
+      stub_udf_attr_set, (void*)SAI_UDF_ATTR_OFFSET },
+    { SAI_UDF_ATTR_HASH_MASK,
+      { true, false, true, true },
+      { true, false, true, true },
+      stub_udf_attr_get, (void*)SAI_UDF_ATTR_HASH_MASK,
+      stub_udf_attr_set, (void*)SAI_UDF_ATTR_HASH_MASK },
+};
+
+static const sai_vendor_attribute_entry_t udf_match_vendor_attribs[] = {
+    { SAI_UDF_MATCH_ATTR_L2_TYPE,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_udf_match_attr_get, (void*)SAI_UDF_MATCH_ATTR_L2_TYPE,
+      NULL, NULL },
+    { SAI_UDF_MATCH_ATTR_L3_TYPE,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_udf_match_attr_get, (void*)SAI_UDF_MATCH_ATTR_L3_TYPE,
+      NULL, NULL },
+    { SAI_UDF_MATCH_ATTR_GRE_TYPE,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_udf_match_attr_get, (void*)SAI_UDF_MATCH_ATTR_GRE_TYPE,
+      NULL, NULL },
+    { SAI_UDF_MATCH_ATTR_PRIORITY,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_udf_match_attr_get, (void*)SAI_UDF_MATCH_ATTR_PRIORITY,
+      NULL, NULL },
+};
+
+static const sai_vendor_attribute_entry_t udf_group_vendor_attribs[] = {
+    { SAI_UDF_GROUP_ATTR_UDF_LIST,
+      { false, false, false, true },
+      { false, false, false, true },
+      stub_udf_group_attr_get, (void*)SAI_UDF_GROUP_ATTR_UDF_LIST,
+      NULL, NULL },
+    { SAI_UDF_GROUP_ATTR_TYPE,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_udf_group_attr_get, (void*)SAI_UDF_GROUP_ATTR_TYPE,
+      NULL, NULL },
+    { SAI_UDF_ATTR_LENGTH,
+      { true, false, false, true },
+      { true, false, false, true },
+      stub_udf_group_attr_get, (void*)SAI_UDF_ATTR_LENGTH,
+      NULL, NULL },
+};
+
+/* State DB *************/
+#define MAX_UDFS              64
+#define MAX_UDF_MATCHES       32
+#define MAX_UDF_GROUPS        16
+/* base of the sentinel rule, never inside a frame */
+#define UDF_BASE_NONE         (SAI_UDF_BASE_L4 + 1)
+#define UDF_NO_OFFSET         UINT32_MAX
+
+#define UDF_ETH_HDR_LEN       14
+#define UDF_VLAN_TAGS_MAX     2
+#define UDF_ETHERTYPE_VLAN    0x8100
+#define UDF_ETHERTYPE_QINQ    0x88A8
+#define UDF_ETHERTYPE_IPV4    0x0800
+#define UDF_ETHERTYPE_IPV6    0x86DD
+#define UDF_IP_PROTO_GRE      47
+#define UDF_IPV4_HDR_LEN      20
+#define UDF_IPV6_HDR_LEN      40
+
+_Static_assert(MAX_UDF_MATCHES < 64, "UDF program hits do not fit a word");
+
+typedef struct _udf_match_t {
+    bool     is_used;
+    uint16_t l2_type;
+    uint16_t l2_mask;
+    uint16_t gre_type;
+    uint16_t gre_mask;
+    uint8_t  l3_type;
+    uint8_t  l3_mask;
+    uint8_t  priority;
+    /* UDFs of the match */
+    uint32_t ref_count;
+} udf_match_t;
+
+typedef struct _udf_t {
+    bool        is_used;
+    uint32_t    match;
+    uint32_t    group;
+    sai_int32_t base;
+    uint16_t    offset;
+    uint8_t     hash_mask[STUB_UDF_GROUP_MAX_LENGTH];
+} udf_t;
+
+typedef struct _udf_group_t {
+    bool        is_used;
+    sai_int32_t type;
+    uint32_t    length;
+    uint32_t    udf_count;
+    /* hashes and ACL tables extracting the group */
+    uint32_t    ref_count;
+} udf_group_t;
+
+/* A UDF of a group with its match folded in, values already masked */
+typedef struct _udf_rule_t {
+    uint16_t l2_type;
+    uint16_t l2_mask;
+    uint16_t gre_type;
+    uint16_t gre_mask;
+    uint8_t  l3_type;
+    uint8_t  l3_mask;
+    uint8_t  priority;
+    uint8_t  base;
+    uint16_t offset;
+    uint32_t match;
+    uint8_t  hash_mask[STUB_UDF_GROUP_MAX_LENGTH];
+} udf_rule_t;
+
+/* Rules of a group by match priority, highest first, then a sentinel rule
+ * that never finds its bytes. Never changed once published, a change
+ * replaces it */
+typedef struct _udf_program_t {
+    uint32_t   length;
+    uint32_t   count;
+    udf_rule_t rules[];
+} udf_program_t;
+
+static udf_t            udf_db[MAX_UDFS];
+static udf_match_t      udf_match_db[MAX_UDF_MATCHES];
+static udf_group_t      udf_group_db[MAX_UDF_GROUPS];
+/* Readers extract under RCU only, writers serialize on udf_db_lock */
+static udf_program_t   *udf_programs[MAX_UDF_GROUPS];
+static pthread_rwlock_t udf_db_lock = STUB_RWLOCK_INITIALIZER;
+
+static const uint8_t    udf_zeros[STUB_UDF_GROUP_MAX_LENGTH];
+static const uint8_t    udf_ones[STUB_UDF_GROUP_MAX_LENGTH] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+static inline uint16_t udf_read16(_In_ const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+/* Caller holds udf_db_lock */
+static sai_status_t udf_db_index(_In_ sai_object_id_t udf_id, _Out_ uint32_t *index)
+{
+    sai_status_t status;
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(udf_id, SAI_OBJECT_TYPE_UDF, index))) {
+        return status;
+    }
+
+    if ((*index >= MAX_UDFS) || (!udf_db[*index].is_used)) {
+        STUB_LOG_ERR("UDF %u does not exist\n", *index);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Caller holds udf_db_lock */
+static sai_status_t udf_match_db_index(_In_ sai_object_id_t udf_match_id, _Out_ uint32_t *index)
+{
+    sai_status_t status;
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(udf_match_id, SAI_OBJECT_TYPE_UDF_MATCH, index))) {
+        return status;
+    }
+
+    if ((*index >= MAX_UDF_MATCHES) || (!udf_match_db[*index].is_used)) {
+        STUB_LOG_ERR("UDF match %u does not exist\n", *index);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Caller holds udf_db_lock */
+static sai_status_t udf_group_db_index(_In_ sai_object_id_t udf_group_id, _Out_ uint32_t *index)
+{
+    sai_status_t status;
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(udf_group_id, SAI_OBJECT_TYPE_UDF_GROUP, index))) {
+        return status;
+    }
+
+    if ((*index >= MAX_UDF_GROUPS) || (!udf_group_db[*index].is_used)) {
+        STUB_LOG_ERR("UDF group %u does not exist\n", *index);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void udf_key_to_str(_In_ sai_object_id_t   object_id,
+                           _In_ sai_object_type_t type,
+                           _In_ const char       *name,
+                           _Out_ char            *key_str)
+{
+    uint32_t index;
+
+    if (SAI_STATUS_SUCCESS != stub_object_to_type(object_id, type, &index)) {
+        snprintf(key_str, MAX_KEY_STR_LEN, "invalid %s id", name);
+    } else {
+        snprintf(key_str, MAX_KEY_STR_LEN, "%s id %u", name, index);
+    }
+}
+
+static int udf_rule_cmp(_In_ const void *a, _In_ const void *b)
+{
+    const udf_rule_t *rule_a = a, *rule_b = b;
+
+    if (rule_a->priority != rule_b->priority) {
+        return (rule_a->priority > rule_b->priority) ? -1 : 1;
+    }
+
+    /* Equal priorities by match creation order */
+    return (rule_a->match < rule_b->match) ? -1 : (rule_a->match > rule_b->match);
+}
+
+/* Compile the UDFs of a group into a new program and publish it. Caller
+ * holds udf_db_lock */
+static sai_status_t udf_group_compile(_In_ uint32_t group)
+{
+    const udf_match_t *match;
+    udf_program_t     *program, *old;
+    udf_rule_t        *rule;
+    uint32_t           udf;
+
+    program = calloc(1, sizeof(*program) + (udf_group_db[group].udf_count + 1) * sizeof(udf_rule_t));
+    if (NULL == program) {
+        STUB_LOG_ERR("Failed to allocate UDF group %u program\n", group);
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    program->length = udf_group_db[group].length;
+
+    for (udf = 0; udf < MAX_UDFS; udf++) {
+        if (!udf_db[udf].is_used || (group != udf_db[udf].group)) {
+            continue;
+        }
+
+        match          = &udf_match_db[udf_db[udf].match];
+        rule           = &program->rules[program->count++];
+        rule->l2_type  = match->l2_type;
+        rule->l2_mask  = match->l2_mask;
+        rule->l3_type  = match->l3_type;
+        rule->l3_mask  = match->l3_mask;
+        rule->gre_type = match->gre_type;
+        rule->gre_mask = match->gre_mask;
+        /* A GRE type is read from GRE frames only */
+        if ((0 != rule->gre_mask) && (0 == rule->l3_mask)) {
+            rule->l3_type = UDF_IP_PROTO_GRE;
+            rule->l3_mask = 0xFF;
+        }
+        rule->priority = match->priority;
+        rule->match    = udf_db[udf].match;
+        rule->base     = (uint8_t)udf_db[udf].base;
+        rule->offset   = udf_db[udf].offset;
+        memcpy(rule->hash_mask, udf_db[udf].hash_mask, sizeof(rule->hash_mask));
+    }
+
+    qsort(program->rules, program->count, sizeof(udf_rule_t), udf_rule_cmp);
+    /* calloc left the sentinel all zeros */
+    program->rules[program->count].base = UDF_BASE_NONE;
+
+    old = udf_programs[group];
+    STUB_RCU_ASSIGN(udf_programs[group], program);
+    stub_rcu_defer_free(old);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Value and mask of a match rule, value masked */
+static void udf_match_field(_In_ const sai_attribute_value_t *value,
+                            _In_ uint32_t                     size,
+                            _Out_ uint16_t                   *data,
+                            _Out_ uint16_t                   *mask)
+{
+    *data = 0;
+    *mask = 0;
+
+    if ((NULL == value) || !value->aclfield.enable) {
+        return;
+    }
+
+    if (sizeof(uint8_t) == size) {
+        *mask = value->aclfield.mask.u8;
+        *data = value->aclfield.data.u8 & value->aclfield.mask.u8;
+    } else {
+        *mask = value->aclfield.mask.u16;
+        *data = value->aclfield.data.u16 & value->aclfield.mask.u16;
+    }
+}
+
+void db_init_udf(void)
+{
+    uint32_t group;
+
+    pthread_rwlock_wrlock(&udf_db_lock);
+
+    for (group = 0; group < MAX_UDF_GROUPS; group++) {
+        stub_rcu_defer_free(udf_programs[group]);
+        STUB_RCU_ASSIGN(udf_programs[group], NULL);
+    }
+
+    memset(udf_db, 0, sizeof(udf_db));
+    memset(udf_match_db, 0, sizeof(udf_match_db));
+    memset(udf_group_db, 0, sizeof(udf_group_db));
+
+    pthread_rwlock_unlock(&udf_db_lock);
+}
+
+/*
+ * Routine Description:
+ *    Find the headers UDF bases and matches refer to in a frame
+ *
+ * Arguments:
+ *    [in] packet - frame
+ *    [out] layout - bases and match types of the frame
+ */
+void db_udf_parse(_In_ const struct _stub_packet_t *packet, _Out_ stub_udf_layout_t *layout)
+{
+    const uint8_t *data = packet->data;
+    uint32_t       l3   = UDF_ETH_HDR_LEN, ihl, tags;
+    uint16_t       type;
+
+    layout->base[SAI_UDF_BASE_L2] = 0;
+    layout->base[SAI_UDF_BASE_L3] = UDF_NO_OFFSET;
+    layout->base[SAI_UDF_BASE_L4] = UDF_NO_OFFSET;
+    layout->base[UDF_BASE_NONE]   = UDF_NO_OFFSET;
+    layout->l2_type               = 0;
+    layout->l3_type               = 0;
+    layout->gre_type              = 0;
+
+    if (packet->length < UDF_ETH_HDR_LEN) {
+        return;
+    }
+
+    type = udf_read16(data + 12);
+    for (tags = 0; (tags < UDF_VLAN_TAGS_MAX) && ((UDF_ETHERTYPE_VLAN == type) || (UDF_ETHERTYPE_QINQ == type)) &&
+         (packet->length >= l3 + 4); tags++) {
+        type = udf_read16(data + l3 + 2);
+        l3  += 4;
+    }
+
+    layout->l2_type               = type;
+    layout->base[SAI_UDF_BASE_L3] = l3;
+
+    if ((UDF_ETHERTYPE_IPV4 == type) && (packet->length >= l3 + UDF_IPV4_HDR_LEN) && (4 == (data[l3] >> 4)) &&
+        ((ihl = (data[l3] & 0x0F) * 4) >= UDF_IPV4_HDR_LEN) && (packet->length >= l3 + ihl)) {
+        layout->l3_type = data[l3 + 9];
+        /* L4 only on the first fragment */
+        if (0 == (udf_read16(data + l3 + 6) & 0x1FFF)) {
+            layout->base[SAI_UDF_BASE_L4] = l3 + ihl;
+        }
+    } else if ((UDF_ETHERTYPE_IPV6 == type) && (packet->length >= l3 + UDF_IPV6_HDR_LEN) && (6 == (data[l3] >> 4))) {
+        layout->l3_type               = data[l3 + 6];
+        layout->base[SAI_UDF_BASE_L4] = l3 + UDF_IPV6_HDR_LEN;
+    }
+
+    /* The protocol type sits in front of the GRE options */
+    if ((UDF_IP_PROTO_GRE == layout->l3_type) && (UDF_NO_OFFSET != layout->base[SAI_UDF_BASE_L4]) &&
+        (packet->length >= layout->base[SAI_UDF_BASE_L4] + 4)) {
+        layout->gre_type = udf_read16(data + layout->base[SAI_UDF_BASE_L4] + 2);
+    }
+}
+
+/*
+ * Routine Description:
+ *    Extract the bytes of a UDF group from a parsed frame. Call inside a
+ *    read side section. A group removed since the caller looked it up
+ *    gives no bytes, db_udf_group_bind keeps a group from removal
+ *
+ * Arguments:
+ *    [in] group - UDF group index
+ *    [in] packet - frame
+ *    [in] layout - db_udf_parse of the frame
+ *    [in] hash - apply the hash mask of the UDF
+ *    [out] bytes - group length bytes
+ *
+ * Return Values:
+ *    number of bytes extracted, the length of the group
+ */
+uint32_t db_udf_extract(_In_ uint32_t                     group,
+                        _In_ const struct _stub_packet_t *packet,
+                        _In_ const stub_udf_layout_t     *layout,
+                        _In_ bool                         hash,
+                        _Out_ uint8_t                    *bytes)
+{
+    const udf_program_t *program = STUB_RCU_DEREF(udf_programs[group]);
+    const udf_rule_t    *rule;
+    const uint8_t       *src, *mask;
+    uint64_t             hits = 0, start;
+    uint32_t             ii;
+
+    if (NULL == program) {
+        return 0;
+    }
+
+    /* Test every rule, the lowest hit is the highest priority one and the
+     * sentinel bit catches frames no rule matches */
+    for (ii = 0; ii < program->count; ii++) {
+        rule  = &program->rules[ii];
+        hits |= (uint64_t)(((layout->l2_type & rule->l2_mask) == rule->l2_type) &
+                           ((layout->l3_type & rule->l3_mask) == rule->l3_type) &
+                           ((layout->gre_type & rule->gre_mask) == rule->gre_type)) << ii;
+    }
+    rule = &program->rules[__builtin_ctzll(hits | (1ULL << program->count))];
+
+    start = (uint64_t)layout->base[rule->base] + rule->offset;
+    src   = (start + program->length <= packet->length) ? packet->data + start : udf_zeros;
+    mask  = hash ? rule->hash_mask : udf_ones;
+
+    for (ii = 0; ii < program->length; ii++) {
+        bytes[ii] = src[ii] & mask[ii];
+    }
+
+    return program->length;
+}
+
+/*
+ * Routine Description:
+ *    Take a reference on a UDF group for a hash or an ACL table
+ *
+ * Arguments:
+ *    [in] udf_group_id - UDF group
+ *    [in] type - group type the user needs
+ *    [out] group - UDF group index
+ *    [out] length - bytes of the group
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    SAI_STATUS_INVALID_ATTR_VALUE_0 if the group does not exist or is of
+ *    another type
+ */
+sai_status_t db_udf_group_bind(_In_ sai_object_id_t udf_group_id,
+                               _In_ sai_int32_t     type,
+                               _Out_ uint32_t      *group,
+                               _Out_ uint32_t      *length)
+{
+    pthread_rwlock_wrlock(&udf_db_lock);
+
+    if (SAI_STATUS_SUCCESS != udf_group_db_index(udf_group_id, group)) {
+        pthread_rwlock_unlock(&udf_db_lock);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    if (type != udf_group_db[*group].type) {
+        pthread_rwlock_unlock(&udf_db_lock);
+        STUB_LOG_ERR("UDF group %u is of type %d, not %d\n", *group, udf_group_db[*group].type, type);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    udf_group_db[*group].ref_count++;
+    *length = udf_group_db[*group].length;
+
+    pthread_rwlock_unlock(&udf_db_lock);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Drop a reference of db_udf_group_bind */
+void db_udf_group_unbind(_In_ uint32_t group)
+{
+    pthread_rwlock_wrlock(&udf_db_lock);
+    assert(udf_group_db[group].ref_count > 0);
+    udf_group_db[group].ref_count--;
+    pthread_rwlock_unlock(&udf_db_lock);
+}
+
+/*
+ * Routine Description:
+ *    @brief Extract the bytes of a UDF group from a burst of frames the way
+ *    the hash engine and ACL tables do
+ *
+ * Arguments:
+ *    @param[in] udf_group_id - UDF group
+ *    @param[in] count - number of frames
+ *    @param[in] packets - frames
+ *    @param[in] hash - apply the UDF hash masks
+ *    @param[out] bytes - group length bytes per frame, frame after frame
+ *
+ * Return Values:
+ *    @return SAI_STATUS_SUCCESS on success
+ *            Failure status code on error
+ */
+sai_status_t stub_udf_extract(_In_ sai_object_id_t      udf_group_id,
+                              _In_ uint32_t             count,
+                              _In_ const stub_packet_t *packets,
+                              _In_ bool                 hash,
+                              _Out_ uint8_t            *bytes)
+{
+    stub_udf_layout_t layout;
+    sai_status_t      status;
+    uint32_t          group, ii;
+
+    if ((NULL == packets) || (NULL == bytes)) {
+        STUB_LOG_ERR("NULL packets or bytes param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    pthread_rwlock_rdlock(&udf_db_lock);
+    if (SAI_STATUS_SUCCESS != (status = udf_group_db_index(udf_group_id, &group))) {
+        pthread_rwlock_unlock(&udf_db_lock);
+        return status;
+    }
+    /* Group removal frees the program after the readers, it stays until the unlock */
+    stub_rcu_read_lock();
+    pthread_rwlock_unlock(&udf_db_lock);
+
+    for (ii = 0; ii < count; ii++) {
+        db_udf_parse(&packets[ii], &layout);
+        bytes += db_udf_extract(group, &packets[ii], &layout, hash, bytes);
+    }
+
+    stub_rcu_read_unlock();
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Create UDF
+ *
+ * Arguments:
+ *    [out] udf_id - UDF id
+ *    [in] attr_count - number of attributes
+ *    [in] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_create_udf(_Out_ sai_object_id_t     *udf_id,
+                             _In_ uint32_t               attr_count,
+                             _In_ const sai_attribute_t *attr_list)
+{
+    const sai_attribute_value_t *match_id, *group_id, *offset, *base, *hash_mask;
+    uint32_t                     match_id_index, group_id_index, offset_index, base_index, hash_mask_index;
+    uint32_t                     match, group, udf;
+    sai_int32_t                  base_value = SAI_UDF_BASE_L2;
+    sai_status_t                 status;
+    char                         list_str[MAX_LIST_VALUE_STR_LEN];
+    char                         key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    if (NULL == udf_id) {
+        STUB_LOG_ERR("NULL UDF id param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS !=
+        (status =
+             check_attribs_metadata(attr_count, attr_list, udf_attribs, udf_vendor_attribs,
+                                    SAI_OPERATION_CREATE))) {
+        STUB_LOG_ERR("Failed attribs check\n");
+        return status;
+    }
+
+    sai_attr_list_to_str(attr_count, attr_list, udf_attribs, MAX_LIST_VALUE_STR_LEN, list_str);
+    STUB_LOG_NTC("Create UDF, %s\n", list_str);
+
+    assert(SAI_STATUS_SUCCESS ==
+           find_attrib_in_list(attr_count, attr_list, SAI_UDF_ATTR_MATCH_ID, &match_id, &match_id_index));
+    assert(SAI_STATUS_SUCCESS ==
+           find_attrib_in_list(attr_count, attr_list, SAI_UDF_ATTR_GROUP_ID, &group_id, &group_id_index));
+    assert(SAI_STATUS_SUCCESS ==
+           find_attrib_in_list(attr_count, attr_list, SAI_UDF_ATTR_OFFSET, &offset, &offset_index));
+
+    if (SAI_STATUS_SUCCESS == find_attrib_in_list(attr_count, attr_list, SAI_UDF_ATTR_BASE, &base, &base_index)) {
+        if ((base->s32 < SAI_UDF_BASE_L2) || (base->s32 > SAI_UDF_BASE_L4)) {
+            STUB_LOG_ERR("Invalid UDF base %d\n", base->s32);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + base_index;
+        }
+        base_value = base->s32;
+    }
+
+    pthread_rwlock_wrlock(&udf_db_lock);
+
+    if (SAI_STATUS_SUCCESS != udf_match_db_index(match_id->oid, &match)) {
+        pthread_rwlock_unlock(&udf_db_lock);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + match_id_index;
+    }
+
+    if (SAI_STATUS_SUCCESS != udf_group_db_index(group_id->oid, &group)) {
+        pthread_rwlock_unlock(&udf_db_lock);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + group_id_index;
+    }
+
+    if ((SAI_STATUS_SUCCESS ==
+         find_attrib_in_list(attr_count, attr_list, SAI_UDF_ATTR_HASH_MASK, &hash_mask, &hash_mask_index)) &&
+        (hash_mask->u8list.count != udf_group_db[group].length)) {
+        pthread_rwlock_unlock(&udf_db_lock);
+        STUB_LOG_ERR("UDF hash mask of %u bytes, group length %u\n", hash_mask->u8list.count,
+                     udf_group_db[group].length);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + hash_mask_index;
+    }
+
+    for (udf = 0; udf < MAX_UDFS; udf++) {
+        if (udf_db[udf].is_used && (match == udf_db[udf].match) && (group == udf_db[udf].group)) {
+            pthread_rwlock_unlock(&udf_db_lock);
+            STUB_LOG_ERR("UDF group %u already has a UDF for match %u\n", group, match);
+            return SAI_STATUS_ITEM_ALREADY_EXISTS;
+        }
+    }
+
+    for (udf = 0; udf < MAX_UDFS; udf++) {
+        if (!udf_db[udf].is_used) {
+            break;
+        }
+    }
+
+    if (MAX_UDFS == udf) {
+        pthread_rwlock_unlock(&udf_db_lock);
+        STUB_LOG_ERR("UDF table full\n");
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    udf_db[udf].is_used = true;
+    udf_db[udf].match   = match;
+    udf_db[udf].group   = group;
+    udf_db[udf].base    = base_value;
+    udf_db[udf].offset  = offset->u16;
+    memcpy(udf_db[udf].hash_mask, udf_ones, sizeof(udf_db[udf].hash_mask));
+    if (SAI_STATUS_SUCCESS ==
+        find_attrib_in_list(attr_count, attr_list, SAI_UDF_ATTR_HASH_MASK, &hash_mask, &hash_mask_index)) {
+        memcpy(udf_db[udf].hash_mask, hash_mask->u8list.list, hash_mask->u8list.count);
+    }
+    udf_group_db[group].udf_count++;
+
+    if (SAI_STATUS_SUCCESS != (status = udf_group_compile(group))) {
+        udf_group_db[group].udf_count--;
+        udf_db[udf].is_used = false;
+        pthread_rwlock_unlock(&udf_db_lock);
+        return status;
+    }
+    udf_match_db[match].ref_count++;
+
+    pthread_rwlock_unlock(&udf_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_UDF, udf, udf_id))) {
+        return status;
+    }
+    udf_key_to_str(*udf_id, SAI_OBJECT_TYPE_UDF, "UDF", key_str);
+    STUB_LOG_NTC("Created %s\n", key_str);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Remove UDF
+ *
+ * Arguments:
+ *    [in] udf_id - UDF id
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_remove_udf(_In_ sai_object_id_t udf_id)
+{
+    char         key_str[MAX_KEY_STR_LEN];
+    sai_status_t status;
+    uint32_t     udf, group;
+
+    STUB_LOG_ENTER();
+
+    udf_key_to_str(udf_id, SAI_OBJECT_TYPE_UDF, "UDF", key_str);
+    STUB_LOG_NTC("Remove %s\n", key_str);
+
+    pthread_rwlock_wrlock(&udf_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = udf_db_index(udf_id, &udf))) {
+        pthread_rwlock_unlock(&udf_db_lock);
+        return status;
+    }
+
+    group               = udf_db[udf].group;
+    udf_db[udf].is_used = false;
+    udf_group_db[group].udf_count--;
+
+    if (SAI_STATUS_SUCCESS != (status = udf_group_compile(group))) {
+        udf_group_db[group].udf_count++;
+        udf_db[udf].is_used = true;
+        pthread_rwlock_unlock(&udf_db_lock);
+        return status;
+    }
+    udf_match_db[udf_db[udf].match].ref_count--;
+
+    pthread_rwlock_unlock(&udf_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Set UDF attribute
+ *
+ * Arguments:
+ *    [in] udf_id - UDF id
+ *    [in] attr - attribute
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_set_udf_attribute(_In_ sai_object_id_t udf_id, _In_ const sai_attribute_t *attr)
+{
+    const sai_object_key_t key = { .object_id = udf_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    udf_key_to_str(udf_id, SAI_OBJECT_TYPE_UDF, "UDF", key_str);
+    return sai_set_attribute(&key, key_str, udf_attribs, udf_vendor_attribs, attr);
+}
+
+/*
+ * Routine Description:
+ *    Get UDF attribute
+ *
+ * Arguments:
+ *    [in] udf_id - UDF id
+ *    [in] attr_count - number of attributes
+ *    [inout] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_udf_attribute(_In_ sai_object_id_t     udf_id,
+                                    _In_ uint32_t            attr_count,
+                                    _Inout_ sai_attribute_t *attr_list)
+{
+    const sai_object_key_t key = { .object_id = udf_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
+
+    STUB_LOG_ENTER();
+
+    udf_key_to_str(udf_id, SAI_OBJECT_TYPE_UDF, "UDF", key_str);
+
+    pthread_rwlock_rdlock(&udf_db_lock);
+    status = sai_get_attributes(&key, key_str, udf_attribs, udf_vendor_attribs, attr_count, attr_list);
+    pthread_rwlock_unlock(&udf_db_lock);
+
+    return status;
+}
+
+/* Match [sai_object_id_t], group [sai_object_id_t], base [sai_udf_base_t],
+ * offset [uint16_t], hash mask [sai_u8_list_t] */
+sai_status_t stub_udf_attr_get(_In_ const sai_object_key_t   *key,
+                               _Inout_ sai_attribute_value_t *value,
+                               _In_ uint32_t                  attr_index,
+                               _Inout_ vendor_cache_t        *cache,
+                               void                          *arg)
+{
+    const udf_t *entry;
+    sai_status_t status;
+    uint32_t     udf;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = udf_db_index(key->object_id, &udf))) {
+        return status;
+    }
+
+    entry = &udf_db[udf];
+
+    switch ((long)arg) {
+    case SAI_UDF_ATTR_MATCH_ID:
+        return stub_create_object(SAI_OBJECT_TYPE_UDF_MATCH, entry->match, &value->oid);
+
+    case SAI_UDF_ATTR_GROUP_ID:
+        return stub_create_object(SAI_OBJECT_TYPE_UDF_GROUP, entry->group, &value->oid);
+
+    case SAI_UDF_ATTR_BASE:
+        value->s32 = entry->base;
+        break;
+
+    case SAI_UDF_ATTR_OFFSET:
+        value->u16 = entry->offset;
+        break;
+
+    case SAI_UDF_ATTR_HASH_MASK:
+        status = stub_fill_u8list((uint8_t*)entry->hash_mask, udf_group_db[entry->group].length, &value->u8list);
+        break;
+    }
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/* Base [sai_udf_base_t], offset [uint16_t], hash mask [sai_u8_list_t] */
+sai_status_t stub_udf_attr_set(_In_ const sai_object_key_t      *key,
+                               _In_ const sai_attribute_value_t *value,
+                               void                             *arg)
+{
+    udf_t        saved, *entry;
+    sai_status_t status;
+    uint32_t     udf;
+
+    STUB_LOG_ENTER();
+
+    pthread_rwlock_wrlock(&udf_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = udf_db_index(key->object_id, &udf))) {
+        pthread_rwlock_unlock(&udf_db_lock);
+        return status;
+    }
+
+    entry = &udf_db[udf];
+    saved = *entry;
+
+    switch ((long)arg) {
+    case SAI_UDF_ATTR_BASE:
+        if ((value->s32 < SAI_UDF_BASE_L2) || (value->s32 > SAI_UDF_BASE_L4)) {
+            pthread_rwlock_unlock(&udf_db_lock);
+            STUB_LOG_ERR("Invalid UDF base %d\n", value->s32);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        entry->base = value->s32;
+        break;
+
+    case SAI_UDF_ATTR_OFFSET:
+        entry->offset = value->u16;
+        break;
+
+    case SAI_UDF_ATTR_HASH_MASK:
+        if (value->u8list.count != udf_group_db[entry->group].length) {
+            pthread_rwlock_unlock(&udf_db_lock);
+            STUB_LOG_ERR("UDF hash mask of %u bytes, group length %u\n", value->u8list.count,
+                         udf_group_db[entry->group].length);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        memcpy(entry->hash_mask, value->u8list.list, value->u8list.count);
+        break;
+    }
+
+    if (SAI_STATUS_SUCCESS != (status = udf_group_compile(entry->group))) {
+        *entry = saved;
+    }
+
+    pthread_rwlock_unlock(&udf_db_lock);
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+/*
+ * Routine Description:
+ *    Create UDF match
+ *
+ * Arguments:
+ *    [out] udf_match_id - UDF match id
+ *    [in] attr_count - number of attributes
+ *    [in] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_create_udf_match(_Out_ sai_object_id_t     *udf_match_id,
+                                   _In_ uint32_t               attr_count,
+                                   _In_ const sai_attribute_t *attr_list)
+{
+    const sai_attribute_value_t *l2_type = NULL, *l3_type = NULL, *gre_type = NULL, *priority;
+    uint32_t                     l2_type_index, l3_type_index, gre_type_index, priority_index, match;
+    udf_match_t                  rule;
+    uint16_t                     l3_value, l3_mask;
+    sai_status_t                 status;
+    char                         list_str[MAX_LIST_VALUE_STR_LEN];
+    char                         key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    if (NULL == udf_match_id) {
+        STUB_LOG_ERR("NULL UDF match id param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS !=
+        (status =
+             check_attribs_metadata(attr_count, attr_list, udf_match_attribs, udf_match_vendor_attribs,
+                                    SAI_OPERATION_CREATE))) {
+        STUB_LOG_ERR("Failed attribs check\n");
+        return status;
+    }
+
+    sai_attr_list_to_str(attr_count, attr_list, udf_match_attribs, MAX_LIST_VALUE_STR_LEN, list_str);
+    STUB_LOG_NTC("Create UDF match, %s\n", list_str);
+
+    find_attrib_in_list(attr_count, attr_list, SAI_UDF_MATCH_ATTR_L2_TYPE, &l2_type, &l2_type_index);
+    find_attrib_in_list(attr_count, attr_list, SAI_UDF_MATCH_ATTR_L3_TYPE, &l3_type, &l3_type_index);
+    find_attrib_in_list(attr_count, attr_list, SAI_UDF_MATCH_ATTR_GRE_TYPE, &gre_type, &gre_type_index);
+
+    memset(&rule, 0, sizeof(rule));
+    udf_match_field(l2_type, sizeof(uint16_t), &rule.l2_type, &rule.l2_mask);
+    udf_match_field(gre_type, sizeof(uint16_t), &rule.gre_type, &rule.gre_mask);
+    udf_match_field(l3_type, sizeof(uint8_t), &l3_value, &l3_mask);
+    rule.l3_type = (uint8_t)l3_value;
+    rule.l3_mask = (uint8_t)l3_mask;
+    if (SAI_STATUS_SUCCESS ==
+        find_attrib_in_list(attr_count, attr_list, SAI_UDF_MATCH_ATTR_PRIORITY, &priority, &priority_index)) {
+        rule.priority = priority->u8;
+    }
+
+    pthread_rwlock_wrlock(&udf_db_lock);
+
+    /* A rule exists once, whatever its priority */
+    for (match = 0; match < MAX_UDF_MATCHES; match++) {
+        if (udf_match_db[match].is_used &&
+            (rule.l2_type == udf_match_db[match].l2_type) && (rule.l2_mask == udf_match_db[match].l2_mask) &&
+            (rule.l3_type == udf_match_db[match].l3_type) && (rule.l3_mask == udf_match_db[match].l3_mask) &&
+            (rule.gre_type == udf_match_db[match].gre_type) && (rule.gre_mask == udf_match_db[match].gre_mask)) {
+            pthread_rwlock_unlock(&udf_db_lock);
+            STUB_LOG_ERR("UDF match %u has the same rule\n", match);
+            return SAI_STATUS_ITEM_ALREADY_EXISTS;
+        }
+    }
+
+    for (match = 0; match < MAX_UDF_MATCHES; match++) {
+        if (!udf_match_db[match].is_used) {
+            break;
+        }
+    }
+
+    if (MAX_UDF_MATCHES == match) {
+        pthread_rwlock_unlock(&udf_db_lock);
+        STUB_LOG_ERR("UDF match table full\n");
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    rule.is_used        = true;
+    udf_match_db[match] = rule;
+
+    pthread_rwlock_unlock(&udf_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_UDF_MATCH, match, udf_match_id))) {
+        return status;
+    }
+    udf_key_to_str(*udf_match_id, SAI_OBJECT_TYPE_UDF_MATCH, "UDF match", key_str);
+    STUB_LOG_NTC("Created %s\n", key_str);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Remove UDF match
+ *
+ * Arguments:
+ *    [in] udf_match_id - UDF match id
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_remove_udf_match(_In_ sai_object_id_t udf_match_id)
+{
+    char         key_str[MAX_KEY_STR_LEN];
+    sai_status_t status;
+    uint32_t     match;
+
+    STUB_LOG_ENTER();
+
+    udf_key_to_str(udf_match_id, SAI_OBJECT_TYPE_UDF_MATCH, "UDF match", key_str);
+    STUB_LOG_NTC("Remove %s\n", key_str);
+
+    pthread_rwlock_wrlock(&udf_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = udf_match_db_index(udf_match_id, &match))) {
+        pthread_rwlock_unlock(&udf_db_lock);
+        return status;
+    }
+
+    if (0 != udf_match_db[match].ref_count) {
+        pthread_rwlock_unlock(&udf_db_lock);
+        STUB_LOG_ERR("UDF match %u is used by %u UDFs\n", match, udf_match_db[match].ref_count);
+        return SAI_STATUS_OBJECT_IN_USE;
+    }
+
+    udf_match_db[match].is_used = false;
+
+    pthread_rwlock_unlock(&udf_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Set UDF match attribute
+ *
+ * Arguments:
+ *    [in] udf_match_id - UDF match id
+ *    [in] attr - attribute
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_set_udf_match_attribute(_In_ sai_object_id_t udf_match_id, _In_ const sai_attribute_t *attr)
+{
+    const sai_object_key_t key = { .object_id = udf_match_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    udf_key_to_str(udf_match_id, SAI_OBJECT_TYPE_UDF_MATCH, "UDF match", key_str);
+    return sai_set_attribute(&key, key_str, udf_match_attribs, udf_match_vendor_attribs, attr);
+}
+
+/*
+ * Routine Description:
+ *    Get UDF match attribute
+ *
+ * Arguments:
+ *    [in] udf_match_id - UDF match id
+ *    [in] attr_count - number of attributes
+ *    [inout] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_udf_match_attribute(_In_ sai_object_id_t     udf_match_id,
+                                          _In_ uint32_t            attr_count,
+                                          _Inout_ sai_attribute_t *attr_list)
+{
+    const sai_object_key_t key = { .object_id = udf_match_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
+
+    STUB_LOG_ENTER();
+
+    udf_key_to_str(udf_match_id, SAI_OBJECT_TYPE_UDF_MATCH, "UDF match", key_str);
+
+    pthread_rwlock_rdlock(&udf_db_lock);
+    status = sai_get_attributes(&key, key_str, udf_match_attribs, udf_match_vendor_attribs, attr_count, attr_list);
+    pthread_rwlock_unlock(&udf_db_lock);
+
+    return status;
+}
+
+/* L2 type [sai_acl_field_data_t(uint16_t)], L3 type [sai_acl_field_data_t(uint8_t)],
+ * GRE type [sai_acl_field_data_t(uint16_t)], priority [uint8_t] */
+sai_status_t stub_udf_match_attr_get(_In_ const sai_object_key_t   *key,
+                                     _Inout_ sai_attribute_value_t *value,
+                                     _In_ uint32_t                  attr_index,
+                                     _Inout_ vendor_cache_t        *cache,
+                                     void                          *arg)
+{
+    const udf_match_t *rule;
+    sai_status_t       status;
+    uint32_t           match;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = udf_match_db_index(key->object_id, &match))) {
+        return status;
+    }
+
+    rule = &udf_match_db[match];
+
+    switch ((long)arg) {
+    case SAI_UDF_MATCH_ATTR_L2_TYPE:
+        value->aclfield.enable   = 0 != rule->l2_mask;
+        value->aclfield.data.u16 = rule->l2_type;
+        value->aclfield.mask.u16 = rule->l2_mask;
+        break;
+
+    case SAI_UDF_MATCH_ATTR_L3_TYPE:
+        value->aclfield.enable  = 0 != rule->l3_mask;
+        value->aclfield.data.u8 = rule->l3_type;
+        value->aclfield.mask.u8 = rule->l3_mask;
+        break;
+
+    case SAI_UDF_MATCH_ATTR_GRE_TYPE:
+        value->aclfield.enable   = 0 != rule->gre_mask;
+        value->aclfield.data.u16 = rule->gre_type;
+        value->aclfield.mask.u16 = rule->gre_mask;
+        break;
+
+    case SAI_UDF_MATCH_ATTR_PRIORITY:
+        value->u8 = rule->priority;
+        break;
+    }
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Create UDF group
+ *
+ * Arguments:
+ *    [out] udf_group_id - UDF group id
+ *    [in] attr_count - number of attributes
+ *    [in] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_create_udf_group(_Out_ sai_object_id_t     *udf_group_id,
+                                   _In_ uint32_t               attr_count,
+                                   _In_ const sai_attribute_t *attr_list)
+{
+    const sai_attribute_value_t *type, *length;
+    uint32_t                     type_index, length_index, group;
+    sai_int32_t                  type_value = SAI_UDF_GROUP_GENERIC;
+    sai_status_t                 status;
+    char                         list_str[MAX_LIST_VALUE_STR_LEN];
+    char                         key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    if (NULL == udf_group_id) {
+        STUB_LOG_ERR("NULL UDF group id param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS !=
+        (status =
+             check_attribs_metadata(attr_count, attr_list, udf_group_attribs, udf_group_vendor_attribs,
+                                    SAI_OPERATION_CREATE))) {
+        STUB_LOG_ERR("Failed attribs check\n");
+        return status;
+    }
+
+    sai_attr_list_to_str(attr_count, attr_list, udf_group_attribs, MAX_LIST_VALUE_STR_LEN, list_str);
+    STUB_LOG_NTC("Create UDF group, %s\n", list_str);
+
+    assert(SAI_STATUS_SUCCESS ==
+           find_attrib_in_list(attr_count, attr_list, SAI_UDF_ATTR_LENGTH, &length, &length_index));
+
+    if ((0 == length->u16) || (length->u16 > STUB_UDF_GROUP_MAX_LENGTH)) {
+        STUB_LOG_ERR("UDF group length %u not in 1..%u\n", length->u16, STUB_UDF_GROUP_MAX_LENGTH);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0 + length_index;
+    }
+
+    if (SAI_STATUS_SUCCESS == find_attrib_in_list(attr_count, attr_list, SAI_UDF_GROUP_ATTR_TYPE, &type, &type_index)) {
+        if ((SAI_UDF_GROUP_GENERIC != type->s32) && (SAI_UDF_GROUP_HASH != type->s32)) {
+            STUB_LOG_ERR("Invalid UDF group type %d\n", type->s32);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + type_index;
+        }
+        type_value = type->s32;
+    }
+
+    pthread_rwlock_wrlock(&udf_db_lock);
+
+    for (group = 0; group < MAX_UDF_GROUPS; group++) {
+        if (!udf_group_db[group].is_used) {
+            break;
+        }
+    }
+
+    if (MAX_UDF_GROUPS == group) {
+        pthread_rwlock_unlock(&udf_db_lock);
+        STUB_LOG_ERR("UDF group table full\n");
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    udf_group_db[group].type      = type_value;
+    udf_group_db[group].length    = length->u16;
+    udf_group_db[group].udf_count = 0;
+    udf_group_db[group].ref_count = 0;
+
+    /* Extraction needs a program even without UDFs */
+    if (SAI_STATUS_SUCCESS != (status = udf_group_compile(group))) {
+        pthread_rwlock_unlock(&udf_db_lock);
+        return status;
+    }
+    udf_group_db[group].is_used = true;
+
+    pthread_rwlock_unlock(&udf_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_UDF_GROUP, group, udf_group_id))) {
+        return status;
+    }
+    udf_key_to_str(*udf_group_id, SAI_OBJECT_TYPE_UDF_GROUP, "UDF group", key_str);
+    STUB_LOG_NTC("Created %s\n", key_str);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Remove UDF group
+ *
+ * Arguments:
+ *    [in] udf_group_id - UDF group id
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_remove_udf_group(_In_ sai_object_id_t udf_group_id)
+{
+    char         key_str[MAX_KEY_STR_LEN];
+    sai_status_t status;
+    uint32_t     group;
+
+    STUB_LOG_ENTER();
+
+    udf_key_to_str(udf_group_id, SAI_OBJECT_TYPE_UDF_GROUP, "UDF group", key_str);
+    STUB_LOG_NTC("Remove %s\n", key_str);
+
+    pthread_rwlock_wrlock(&udf_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = udf_group_db_index(udf_group_id, &group))) {
+        pthread_rwlock_unlock(&udf_db_lock);
+        return status;
+    }
+
+    if ((0 != udf_group_db[group].udf_count) || (0 != udf_group_db[group].ref_count)) {
+        pthread_rwlock_unlock(&udf_db_lock);
+        STUB_LOG_ERR("UDF group %u has %u UDFs and %u users\n", group, udf_group_db[group].udf_count,
+                     udf_group_db[group].ref_count);
+        return SAI_STATUS_OBJECT_IN_USE;
+    }
+
+    udf_group_db[group].is_used = false;
+    stub_rcu_defer_free(udf_programs[group]);
+    STUB_RCU_ASSIGN(udf_programs[group], NULL);
+
+    pthread_rwlock_unlock(&udf_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Set UDF group attribute
+ *
+ * Arguments:
+ *    [in] udf_group_id - UDF group id
+ *    [in] attr - attribute
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_set_udf_group_attribute(_In_ sai_object_id_t udf_group_id, _In_ const sai_attribute_t *attr)
+{
+    const sai_object_key_t key = { .object_id = udf_group_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    udf_key_to_str(udf_group_id, SAI_OBJECT_TYPE_UDF_GROUP, "UDF group", key_str);
+    return sai_set_attribute(&key, key_str, udf_group_attribs, udf_group_vendor_attribs, attr);
+}
+
+/*
+ * Routine Description:
+ *    Get UDF group attribute
+ *
+ * Arguments:
+ *    [in] udf_group_id - UDF group id
+ *    [in] attr_count - number of attributes
+ *    [inout] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_udf_group_attribute(_In_ sai_object_id_t     udf_group_id,
+                                          _In_ uint32_t            attr_count,
+                                          _Inout_ sai_attribute_t *attr_list)
+{
+    const sai_object_key_t key = { .object_id = udf_group_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
+
+    STUB_LOG_ENTER();
+
+    udf_key_to_str(udf_group_id, SAI_OBJECT_TYPE_UDF_GROUP, "UDF group", key_str);
+
+    pthread_rwlock_rdlock(&udf_db_lock);
+    status = sai_get_attributes(&key, key_str, udf_group_attribs, udf_group_vendor_attribs, attr_count, attr_list);
+    pthread_rwlock_unlock(&udf_db_lock);
+
+    return status;
+}
+
+/* UDFs [sai_object_list_t], type [sai_udf_group_type_t], length [uint16_t] */
+sai_status_t stub_udf_group_attr_get(_In_ const sai_object_key_t   *key,
+                                     _Inout_ sai_attribute_value_t *value,
+                                     _In_ uint32_t                  attr_index,
+                                     _Inout_ vendor_cache_t        *cache,
+                                     void                          *arg)
+{
+    sai_object_id_t udfs[MAX_UDFS];
+    sai_status_t    status;
+    uint32_t        group, udf, count = 0;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = udf_group_db_index(key->object_id, &group))) {
+        return status;
+    }
+
+    switch ((long)arg) {
+    case SAI_UDF_GROUP_ATTR_UDF_LIST:
+        for (udf = 0; udf < MAX_UDFS; udf++) {
+            if (udf_db[udf].is_used && (group == udf_db[udf].group)) {
+                stub_create_object(SAI_OBJECT_TYPE_UDF, udf, &udfs[count++]);
+            }
+        }
+        status = stub_fill_objlist(udfs, count, &value->objlist);
+        break;
+
+    case SAI_UDF_GROUP_ATTR_TYPE:
+        value->s32 = udf_group_db[group].type;
+        break;
+
+    case SAI_UDF_ATTR_LENGTH:
+        value->u16 = (uint16_t)udf_group_db[group].length;
+        break;
+    }
+
+    STUB_LOG_EXIT();
+    return status;
+}
+
+const sai_udf_api_t udf_api = {
+    stub_create_udf,
+    stub_remove_udf,
+    stub_set_udf_attribute,
+    stub_get_udf_attribute,
+    stub_create_udf_match,
+    stub_remove_udf_match,
+    stub_set_udf_match_attribute,
+    stub_get_udf_match_attribute,
+    stub_create_udf_group,
+    stub_remove_udf_group,
+    stub_set_udf_group_attribute,
+    stub_get_udf_group_attribute,
+};
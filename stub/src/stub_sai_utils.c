@@ -177,7 +177,11 @@ sai_status_t check_attribs_metadata(_In_ uint32_t                            att
             ((SAI_ATTR_VAL_TYPE_S32LIST == functionality_attr[index].type) &&
              (NULL == attr_list[ii].value.s32list.list)) ||
             ((SAI_ATTR_VAL_TYPE_VLANLIST == functionality_attr[index].type) &&
-             (NULL == attr_list[ii].value.vlanlist.list))) {
+             (NULL == attr_list[ii].value.vlanlist.list)) ||
+            ((SAI_ATTR_VAL_TYPE_U8LIST == functionality_attr[index].type) &&
+             (NULL == attr_list[ii].value.u8list.list)) ||
+            ((SAI_ATTR_VAL_TYPE_QOSMAP == functionality_attr[index].type) &&
+             (NULL == attr_list[ii].value.qosmap.list))) {
             STUB_LOG_ERR("Null list attribute %s at index %d\n",
                          functionality_attr[index].attrib_name,
                          ii);
@@ -414,7 +418,7 @@ static sai_status_t sai_ipv6_to_str(_In_ sai_ip6_t value,
                                     _Out_ char    *value_str,
                                     _Out_ int     *chars_written)
 {
-    inet_ntop(AF_INET6, &value, value_str, max_length);
+    inet_ntop(AF_INET6, value, value_str, max_length);
 
     if (NULL != chars_written) {
         *chars_written = (int)strlen(value_str);
@@ -602,6 +606,7 @@ sai_status_t sai_value_to_str(_In_ sai_attribute_value_t      value,
     case SAI_ATTR_VAL_TYPE_U32LIST:
     case SAI_ATTR_VAL_TYPE_S32LIST:
     case SAI_ATTR_VAL_TYPE_VLANLIST:
+    case SAI_ATTR_VAL_TYPE_U8LIST:
     case SAI_ATTR_VAL_TYPE_PORTBREAKOUT:
         if (SAI_ATTR_VAL_TYPE_PORTBREAKOUT == type) {
             pos += snprintf(value_str, max_length, "breakout mode %d.", value.portbreakout.breakout_mode);
@@ -614,6 +619,7 @@ sai_status_t sai_value_to_str(_In_ sai_attribute_value_t      value,
                 (SAI_ATTR_VAL_TYPE_U32LIST == type) ? value.u32list.count :
                 (SAI_ATTR_VAL_TYPE_S32LIST == type) ? value.s32list.count :
                 (SAI_ATTR_VAL_TYPE_VLANLIST == type) ? value.vlanlist.count :
+                (SAI_ATTR_VAL_TYPE_U8LIST == type) ? value.u8list.count :
                 value.portbreakout.port_list.count;
         pos += snprintf(value_str + pos, max_length - pos, "%u : [", count);
         if (pos > max_length) {
@@ -629,6 +635,8 @@ sai_status_t sai_value_to_str(_In_ sai_attribute_value_t      value,
                 pos += snprintf(value_str + pos, max_length - pos, " %d", value.s32list.list[ii]);
             } else if (SAI_ATTR_VAL_TYPE_VLANLIST == type) {
                 pos += snprintf(value_str + pos, max_length - pos, " %u", value.vlanlist.list[ii]);
+            } else if (SAI_ATTR_VAL_TYPE_U8LIST == type) {
+                pos += snprintf(value_str + pos, max_length - pos, " %02x", value.u8list.list[ii]);
             } else {
                 pos += snprintf(value_str + pos, max_length - pos, " %" PRIx64, value.portbreakout.port_list.list[ii]);
             }
@@ -641,10 +649,16 @@ sai_status_t sai_value_to_str(_In_ sai_attribute_value_t      value,
 
 
     case SAI_ATTR_VAL_TYPE_ACLFIELD:
+        snprintf(value_str, max_length, "%s", value.aclfield.enable ? "enabled" : "disabled");
+        break;
+
     case SAI_ATTR_VAL_TYPE_ACLACTION:
-        /* TODO : implement if in case it is used */
-        snprintf(value_str, max_length, "Not implemented value type %d", type);
-        return SAI_STATUS_NOT_IMPLEMENTED;
+        snprintf(value_str, max_length, "%s", value.aclaction.enable ? "enabled" : "disabled");
+        break;
+
+    case SAI_ATTR_VAL_TYPE_QOSMAP:
+        snprintf(value_str, max_length, "%u map entries", value.qosmap.count);
+        break;
 
     case SAI_ATTR_VAL_TYPE_UNDETERMINED:
     default:
@@ -740,6 +754,22 @@ sai_status_t stub_create_object(sai_object_type_t type, uint32_t data, sai_objec
     return SAI_STATUS_SUCCESS;
 }
 
+/*
+ * Routine Description:
+ *    Allocate the next object index from a per-type counter.
+ *    Safe to call concurrently, every caller gets a distinct index.
+ *
+ * Arguments:
+ *    [inout] next_index - counter owned by the object type
+ *
+ * Return Values:
+ *    Allocated index
+ */
+uint32_t stub_alloc_object_index(_Inout_ uint32_t *next_index)
+{
+    return __atomic_fetch_add(next_index, 1, __ATOMIC_RELAXED);
+}
+
 static sai_status_t stub_fill_genericlist(size_t element_size, void *data, uint32_t count, void *list)
 {
     /* all list objects have same field count in the beginning of the object, and then different data,
@@ -794,6 +824,16 @@ sai_status_t stub_fill_vlanlist(sai_vlan_id_t *data, uint32_t count, sai_vlan_li
     return stub_fill_genericlist(sizeof(sai_vlan_id_t), (void*)data, count, (void*)list);
 }
 
+sai_status_t stub_fill_u8list(uint8_t *data, uint32_t count, sai_u8_list_t *list)
+{
+    return stub_fill_genericlist(sizeof(uint8_t), (void*)data, count, (void*)list);
+}
+
+sai_status_t stub_fill_qosmaplist(sai_qos_map_t *data, uint32_t count, sai_qos_map_list_t *list)
+{
+    return stub_fill_genericlist(sizeof(sai_qos_map_t), (void*)data, count, (void*)list);
+}
+
 #define LOG_ENTRY_SIZE_MAX 1024
 
 #ifndef _WIN32
@@ -27,6 +27,8 @@
 /* Storage layer data structures / variables to store the states */
 static int number_of_vlans;
 struct __vlan* vlans = NULL;
+/* Protects vlans/number_of_vlans and the per vlan port lists */
+static pthread_rwlock_t vlan_db_lock = STUB_RWLOCK_INITIALIZER;
 
 struct __vlan {
     sai_vlan_id_t id;
@@ -34,6 +36,11 @@ struct __vlan {
     sai_vlan_port_t* port_list;
 };
 
+/* Member ports of every VLAN by tagging mode and port index, for the data
+ * plane. Written under vlan_db_lock, read without it */
+#define VLAN_TAGGING_MODES (SAI_VLAN_PORT_PRIORITY_TAGGED + 1)
+_Static_assert(PORT_NUMBER <= 32, "vlan member bitmap holds 32 ports");
+static uint32_t vlan_member_ports[4096][VLAN_TAGGING_MODES];
 
 static const sai_attribute_entry_t vlan_attribs[] = {
     {   SAI_VLAN_ATTR_MAX_LEARNED_ADDRESSES, false, false, true, true,
@@ -79,6 +86,87 @@ static const sai_vendor_attribute_entry_t vlan_vendor_attribs[] = {
     },
 };
 
+/* Rebuild the member bitmaps of a VLAN from its port list, the last entry
+ * of a port sets its tagging mode. Called with the lock held */
+static void vlan_update_members(_In_ const struct __vlan* v)
+{
+    uint32_t members[VLAN_TAGGING_MODES] = { 0 };
+    uint32_t port, mode;
+    int      i;
+
+    for (i = 0; i < v->number_of_ports; i++) {
+        if ((SAI_STATUS_SUCCESS != stub_object_to_type(v->port_list[i].port_id, SAI_OBJECT_TYPE_PORT, &port)) ||
+            (port >= PORT_NUMBER) || ((uint32_t)v->port_list[i].tagging_mode >= VLAN_TAGGING_MODES)) {
+            continue;
+        }
+        for (mode = 0; mode < VLAN_TAGGING_MODES; mode++) {
+            members[mode] &= ~(1u << port);
+        }
+        members[v->port_list[i].tagging_mode] |= 1u << port;
+    }
+
+    for (mode = 0; mode < VLAN_TAGGING_MODES; mode++) {
+        __atomic_store_n(&vlan_member_ports[v->id][mode], members[mode], __ATOMIC_RELAXED);
+    }
+}
+
+static void vlan_clear_members(_In_ sai_vlan_id_t vlan_id)
+{
+    uint32_t mode;
+
+    for (mode = 0; mode < VLAN_TAGGING_MODES; mode++) {
+        __atomic_store_n(&vlan_member_ports[vlan_id][mode], 0, __ATOMIC_RELAXED);
+    }
+}
+
+/*
+ * Routine Description:
+ *    Get the tagging mode of a port in a VLAN
+ *
+ * Arguments:
+ *    [in] vlan_id - VLAN id
+ *    [in] port - port index
+ *    [out] tagging_mode - how frames of the VLAN leave the port
+ *
+ * Return Values:
+ *    true when the port is a member
+ */
+bool db_vlan_port_tagging(_In_ sai_vlan_id_t vlan_id, _In_ uint32_t port, _Out_ sai_vlan_tagging_mode_t *tagging_mode)
+{
+    uint32_t mode;
+
+    if (!vlan_id_range_ok(vlan_id) || (port >= PORT_NUMBER)) {
+        return false;
+    }
+
+    for (mode = 0; mode < VLAN_TAGGING_MODES; mode++) {
+        if (__atomic_load_n(&vlan_member_ports[vlan_id][mode], __ATOMIC_RELAXED) & (1u << port)) {
+            *tagging_mode = (sai_vlan_tagging_mode_t)mode;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Routine Description:
+ *    Check whether a port is a member of a VLAN
+ *
+ * Arguments:
+ *    [in] vlan_id - VLAN id
+ *    [in] port - port index
+ *
+ * Return Values:
+ *    true when the port is a member
+ */
+bool db_vlan_port_member(_In_ sai_vlan_id_t vlan_id, _In_ uint32_t port)
+{
+    sai_vlan_tagging_mode_t tagging_mode;
+
+    return db_vlan_port_tagging(vlan_id, port, &tagging_mode);
+}
+
 /*
  * Routine Description:
  *    Create default VLAN and add all port into it.
@@ -88,6 +176,12 @@ void db_init_vlan()
     int ii;
     sai_object_id_t port;
 
+    pthread_rwlock_wrlock(&vlan_db_lock);
+
+    for (ii = 0; ii < number_of_vlans; ++ii) {
+        free(vlans[ii].port_list);
+    }
+
     if (NULL != vlans) {
         free(vlans);
     }
@@ -106,6 +200,13 @@ void db_init_vlan()
     }
 
     number_of_vlans = 1;
+
+    for (ii = 0; ii < 4096; ++ii) {
+        vlan_clear_members(ii);
+    }
+    vlan_update_members(&vlans[0]);
+
+    pthread_rwlock_unlock(&vlan_db_lock);
 }
 
 static void vlan_key_to_str(_In_ sai_vlan_id_t vlan_id, _Out_ char *key_str)
@@ -208,28 +309,36 @@ sai_status_t stub_create_vlan(_In_ sai_vlan_id_t vlan_id)
         return SAI_STATUS_INVALID_VLAN_ID;
     }
 
+    pthread_rwlock_wrlock(&vlan_db_lock);
+
     // make sure the given vlan_id is available
     for (i = 0; i < number_of_vlans; i++) {
         if (vlans[i].id == vlan_id) {
+            pthread_rwlock_unlock(&vlan_db_lock);
             STUB_LOG_WRN("Warning: given vlan_id (%d) already exsits.\n", vlan_id);
             return SAI_STATUS_INVALID_VLAN_ID;
         }
     }
 
     // add new vlan
-    number_of_vlans++;
-    vlans = realloc(vlans, number_of_vlans * sizeof(struct __vlan));
+    struct __vlan* new_vlans = realloc(vlans, (number_of_vlans + 1) * sizeof(struct __vlan));
 
-    if (vlans == NULL) {
+    if (new_vlans == NULL) {
+        pthread_rwlock_unlock(&vlan_db_lock);
         STUB_LOG_ERR("Error: memory allocation for creating a new vlan failed.\n");
         return SAI_STATUS_NO_MEMORY;
     }
 
+    vlans = new_vlans;
+    number_of_vlans++;
+
     struct __vlan* v = &(vlans[number_of_vlans - 1]);
     v->id = vlan_id;
     v->number_of_ports = 0;
     v->port_list = NULL;
 
+    pthread_rwlock_unlock(&vlan_db_lock);
+
     return SAI_STATUS_SUCCESS;
 }
 
@@ -252,6 +361,8 @@ sai_status_t stub_remove_vlan(_In_ sai_vlan_id_t vlan_id)
 
     vlan_key_to_str(vlan_id, key_str);
 
+    pthread_rwlock_wrlock(&vlan_db_lock);
+
     // make sure the given vlan_id exists
     for (i = 0; i < number_of_vlans; i++) {
         if (vlans[i].id == vlan_id) {
@@ -260,24 +371,33 @@ sai_status_t stub_remove_vlan(_In_ sai_vlan_id_t vlan_id)
         }
     }
     if (index_removed_vlan == -1) {
+        pthread_rwlock_unlock(&vlan_db_lock);
         STUB_LOG_NTC("the given vlan id (%d) does not exist.\n", vlan_id);
         return SAI_STATUS_INVALID_VLAN_ID;
     }
 
     // delete the vlans[index_removed_vlan]
+    vlan_clear_members(vlan_id);
+    free(vlans[index_removed_vlan].port_list);
     for (i = 0; i < number_of_vlans; i++) {
         if (i > index_removed_vlan) {
             vlans[i - 1] = vlans[i];
         }
     }
     number_of_vlans--;
-    vlans = realloc(vlans, sizeof(struct __vlan) * number_of_vlans);
-    // Note: realloc(ptr, 0) returns NULL, which is not an error
-    if (vlans == NULL && number_of_vlans > 0) {
-        STUB_LOG_ERR("Error: memory allocation for removing a vlan failed.\n");
-        return SAI_STATUS_NO_MEMORY;
+    // Note: shrinking can not fail in a way that loses the table, keep the old block on NULL
+    if (number_of_vlans > 0) {
+        struct __vlan* new_vlans = realloc(vlans, sizeof(struct __vlan) * number_of_vlans);
+        if (new_vlans != NULL) {
+            vlans = new_vlans;
+        }
+    } else {
+        free(vlans);
+        vlans = NULL;
     }
 
+    pthread_rwlock_unlock(&vlan_db_lock);
+
     STUB_LOG_NTC("Remove vlan %s\n", key_str);
 
     return SAI_STATUS_SUCCESS;
@@ -307,6 +427,8 @@ sai_status_t stub_add_ports_to_vlan(_In_ sai_vlan_id_t          vlan_id,
 
     vlan_key_to_str(vlan_id, key_str);
 
+    pthread_rwlock_wrlock(&vlan_db_lock);
+
     for (i = 0; i < number_of_vlans; i++) {
         if (vlans[i].id == vlan_id) {
             index_target_vlan = i;
@@ -315,21 +437,27 @@ sai_status_t stub_add_ports_to_vlan(_In_ sai_vlan_id_t          vlan_id,
     }
 
     if (index_target_vlan == -1) {
+        pthread_rwlock_unlock(&vlan_db_lock);
         STUB_LOG_WRN("the given vlan id (%d) does not exist.\n", vlan_id);
         return SAI_STATUS_INVALID_VLAN_ID;
     }
 
     struct __vlan* v = &vlans[index_target_vlan];
     int old_size = v->number_of_ports, new_size = old_size + port_count;
-    v->port_list = realloc(v->port_list, new_size * sizeof(sai_vlan_port_t));
+    sai_vlan_port_t* new_port_list = realloc(v->port_list, new_size * sizeof(sai_vlan_port_t));
 
-    if (v->port_list == NULL) {
-        STUB_LOG_ERR("Error: memory allocation for removing a vlan failed.\n");
+    if (new_port_list == NULL) {
+        pthread_rwlock_unlock(&vlan_db_lock);
+        STUB_LOG_ERR("Error: memory allocation for adding ports to a vlan failed.\n");
         return SAI_STATUS_NO_MEMORY;
     }
 
+    v->port_list = new_port_list;
     v->number_of_ports = new_size;
     memcpy(v->port_list + old_size, port_list, port_count * sizeof(sai_vlan_port_t));
+    vlan_update_members(v);
+
+    pthread_rwlock_unlock(&vlan_db_lock);
 
     return SAI_STATUS_SUCCESS;
 }
@@ -383,6 +511,8 @@ sai_status_t stub_remove_ports_from_vlan(_In_ sai_vlan_id_t          vlan_id,
 
     vlan_key_to_str(vlan_id, key_str);
 
+    pthread_rwlock_wrlock(&vlan_db_lock);
+
     for (i = 0; i < number_of_vlans; i++) {
         if (vlans[i].id == vlan_id) {
             v = &vlans[i];
@@ -391,6 +521,7 @@ sai_status_t stub_remove_ports_from_vlan(_In_ sai_vlan_id_t          vlan_id,
     }
 
     if (v == NULL) {
+        pthread_rwlock_unlock(&vlan_db_lock);
         STUB_LOG_WRN("the given vlan id (%d) does not exist.\n", vlan_id);
         return SAI_STATUS_INVALID_VLAN_ID;
     }
@@ -401,6 +532,9 @@ sai_status_t stub_remove_ports_from_vlan(_In_ sai_vlan_id_t          vlan_id,
             STUB_LOG_NTC("the given port (%d) does not belong to the given vlan (%d)\n", port_list[i].port_id, vlan_id);
         }
     }
+    vlan_update_members(v);
+
+    pthread_rwlock_unlock(&vlan_db_lock);
 
     return SAI_STATUS_SUCCESS;
 }
@@ -0,0 +1,788 @@
+/*
+ *  Copyright (C) 2014. Mellanox Technologies, Ltd. ALL RIGHTS RESERVED.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ */
+
+#include "sai.h"
+#include "stub_sai.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_scheduler.h"
+#include "stub_sai_wred.h"
+#include "assert.h"
+
+#undef  __MODULE__
+#define __MODULE__ SAI_WRED
+
+static const sai_attribute_entry_t wred_attribs[] = {
+    { SAI_WRED_ATTR_GREEN_ENABLE, false, true, true, true,
+      "WRED green enable", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_WRED_ATTR_GREEN_MIN_THRESHOLD, false, true, true, true,
+      "WRED green min threshold", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_WRED_ATTR_GREEN_MAX_THRESHOLD, false, true, true, true,
+      "WRED green max threshold", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_WRED_ATTR_GREEN_DROP_PROBABILITY, false, true, true, true,
+      "WRED green drop probability", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_WRED_ATTR_YELLOW_ENABLE, false, true, true, true,
+      "WRED yellow enable", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_WRED_ATTR_YELLOW_MIN_THRESHOLD, false, true, true, true,
+      "WRED yellow min threshold", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_WRED_ATTR_YELLOW_MAX_THRESHOLD, false, true, true, true,
+      "WRED yellow max threshold", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_WRED_ATTR_YELLOW_DROP_PROBABILITY, false, true, true, true,
+      "WRED yellow drop probability", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_WRED_ATTR_RED_ENABLE, false, true, true, true,
+      "WRED red enable", SAI_ATTR_VAL_TYPE_BOOL },
+    { SAI_WRED_ATTR_RED_MIN_THRESHOLD, false, true, true, true,
+      "WRED red min threshold", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_WRED_ATTR_RED_MAX_THRESHOLD, false, true, true, true,
+      "WRED red max threshold", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_WRED_ATTR_RED_DROP_PROBABILITY, false, true, true, true,
+      "WRED red drop probability", SAI_ATTR_VAL_TYPE_U32 },
+    { SAI_WRED_ATTR_WEIGHT, false, true, true, true,
+      "WRED weight", SAI_ATTR_VAL_TYPE_U8 },
+    { SAI_WRED_ATTR_ECN_MARK_ENABLE, false, true, true, true,
+      "WRED ECN mark enable", SAI_ATTR_VAL_TYPE_BOOL },
+    { END_FUNCTIONALITY_ATTRIBS_ID, false, false, false, false,
+      "", SAI_ATTR_VAL_TYPE_UNDETERMINED }
+};
+
+sai_status_t stub_wred_attr_get(_In_ const sai_object_key_t   *key,
+                                _Inout_ sai_attribute_value_t *value,
+                                _In_ uint32_t                  attr_index,
+                                _Inout_ vendor_cache_t        *cache,
+                                void                          *arg);
+sai_status_t stub_wred_attr_set(_In_ const sai_object_key_t      *key,
+                                _In_ const sai_attribute_value_t *value,
+                                void                             *arg);
+
+#define WRED_VENDOR_ATTR(attr)                  \
+    { attr,                                     \
+      { true, false, true, true },              \
+      { true, false, true, true },              \
+      stub_wred_attr_get, (void*)attr,          \
+      stub_wred_attr_set, (void*)attr }
+
+static const sai_vendor_attribute_entry_t wred_vendor_attribs[] = {
+    WRED_VENDOR_ATTR(SAI_WRED_ATTR_GREEN_ENABLE),
+    WRED_VENDOR_ATTR(SAI_WRED_ATTR_GREEN_MIN_THRESHOLD),
+    WRED_VENDOR_ATTR(SAI_WRED_ATTR_GREEN_MAX_THRESHOLD),
+    WRED_VENDOR_ATTR(SAI_WRED_ATTR_GREEN_DROP_PROBABILITY),
+    WRED_VENDOR_ATTR(SAI_WRED_ATTR_YELLOW_ENABLE),
+    WRED_VENDOR_ATTR(SAI_WRED_ATTR_YELLOW_MIN_THRESHOLD),
+    WRED_VENDOR_ATTR(SAI_WRED_ATTR_YELLOW_MAX_THRESHOLD),
+    WRED_VENDOR_ATTR(SAI_WRED_ATTR_YELLOW_DROP_PROBABILITY),
+    WRED_VENDOR_ATTR(SAI_WRED_ATTR_RED_ENABLE),
+    WRED_VENDOR_ATTR(SAI_WRED_ATTR_RED_MIN_THRESHOLD),
+    WRED_VENDOR_ATTR(SAI_WRED_ATTR_RED_MAX_THRESHOLD),
+    WRED_VENDOR_ATTR(SAI_WRED_ATTR_RED_DROP_PROBABILITY),
+    WRED_VENDOR_ATTR(SAI_WRED_ATTR_WEIGHT),
+    WRED_VENDOR_ATTR(SAI_WRED_ATTR_ECN_MARK_ENABLE),
+};
+
+/* State DB *************/
+#define MAX_WREDS              64
+#define WRED_COLORS            (SAI_PACKET_COLOR_RED + 1)
+/* attributes of a color, SAI_WRED_ATTR_GREEN_* to SAI_WRED_ATTR_RED_* */
+#define WRED_COLOR_ATTRS       (SAI_WRED_ATTR_YELLOW_ENABLE - SAI_WRED_ATTR_GREEN_ENABLE)
+#define WRED_COLOR(attr)       (((attr) - SAI_WRED_ATTR_GREEN_ENABLE) / WRED_COLOR_ATTRS)
+#define WRED_COLOR_ATTR(attr)  (((attr) - SAI_WRED_ATTR_GREEN_ENABLE) % WRED_COLOR_ATTRS)
+/* fraction bits of the average queue length */
+#define WRED_AVG_SHIFT         16
+
+#define WRED_ETH_HDR_LEN       14
+#define WRED_VLAN_HDR_LEN      4
+#define WRED_IPV4_HDR_LEN      20
+#define WRED_IPV6_HDR_LEN      40
+#define WRED_ETHERTYPE_VLAN    0x8100
+#define WRED_ETHERTYPE_IPV4    0x0800
+#define WRED_ETHERTYPE_IPV6    0x86DD
+#define WRED_ECN_CE            0x3
+
+typedef struct _wred_color_t {
+    bool     enable;
+    uint32_t min_threshold;
+    uint32_t max_threshold;
+    uint32_t drop_probability;
+} wred_color_t;
+
+typedef struct _wred_t {
+    bool         is_used;
+    wred_color_t colors[WRED_COLORS];
+    uint8_t      weight;
+    bool         ecn_mark;
+    /* queues binding the profile */
+    uint32_t     ref_count;
+} wred_t;
+
+/* Drop decision of a color. A frame between the thresholds drops when a
+ * 32 bit random number is below (avg - min) * slope */
+typedef struct _wred_ramp_t {
+    bool     enable;
+    uint32_t min_threshold;
+    uint32_t max_threshold;
+    uint64_t slope;
+} wred_ramp_t;
+
+/* A profile compiled, swapped whole, never changed in place */
+typedef struct _wred_table_t {
+    wred_ramp_t ramps[WRED_COLORS];
+    uint8_t     weight;
+    bool        ecn_mark;
+} wred_table_t;
+
+static const wred_t     wred_defaults = {
+    false,
+    { { false, 0, 0, 100 }, { false, 0, 0, 100 }, { false, 0, 0, 100 } },
+    0, false, 0
+};
+
+static wred_t           wred_db[MAX_WREDS];
+/* Compiled profiles, the scheduler reads them in read side sections */
+static wred_table_t    *wred_tables[MAX_WREDS];
+static pthread_rwlock_t wred_db_lock = STUB_RWLOCK_INITIALIZER;
+static __thread uint32_t wred_random_state;
+
+/* Caller holds wred_db_lock */
+static sai_status_t wred_db_index(_In_ sai_object_id_t wred_id, _Out_ uint32_t *index)
+{
+    sai_status_t status;
+
+    if (SAI_STATUS_SUCCESS != (status = stub_object_to_type(wred_id, SAI_OBJECT_TYPE_WRED, index))) {
+        return status;
+    }
+
+    if ((*index >= MAX_WREDS) || (!wred_db[*index].is_used)) {
+        STUB_LOG_ERR("WRED profile %u does not exist\n", *index);
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void wred_key_to_str(_In_ sai_object_id_t wred_id, _Out_ char *key_str)
+{
+    uint32_t index;
+
+    if (SAI_STATUS_SUCCESS != stub_object_to_type(wred_id, SAI_OBJECT_TYPE_WRED, &index)) {
+        snprintf(key_str, MAX_KEY_STR_LEN, "invalid WRED profile id");
+    } else {
+        snprintf(key_str, MAX_KEY_STR_LEN, "WRED profile id %u", index);
+    }
+}
+
+/* Thresholds [uint32_t] 1 to STUB_WRED_MAX_THRESHOLD, drop probability
+ * [uint32_t] up to 100, weight [uint8_t] up to STUB_WRED_MAX_WEIGHT */
+static sai_status_t wred_check_value(_In_ sai_attr_id_t attr, _In_ const sai_attribute_value_t *value)
+{
+    if (SAI_WRED_ATTR_WEIGHT == attr) {
+        if (value->u8 > STUB_WRED_MAX_WEIGHT) {
+            STUB_LOG_ERR("WRED weight %u above %u\n", value->u8, STUB_WRED_MAX_WEIGHT);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        return SAI_STATUS_SUCCESS;
+    }
+
+    if (SAI_WRED_ATTR_ECN_MARK_ENABLE == attr) {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    switch (WRED_COLOR_ATTR(attr)) {
+    case SAI_WRED_ATTR_GREEN_MIN_THRESHOLD:
+    case SAI_WRED_ATTR_GREEN_MAX_THRESHOLD:
+        if ((0 == value->u32) || (value->u32 > STUB_WRED_MAX_THRESHOLD)) {
+            STUB_LOG_ERR("WRED threshold %u out of range 1 to %u\n", value->u32, STUB_WRED_MAX_THRESHOLD);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        break;
+
+    case SAI_WRED_ATTR_GREEN_DROP_PROBABILITY:
+        if (value->u32 > 100) {
+            STUB_LOG_ERR("WRED drop probability %u above 100\n", value->u32);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+        break;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static void wred_apply(_Inout_ wred_t *wred, _In_ sai_attr_id_t attr, _In_ const sai_attribute_value_t *value)
+{
+    wred_color_t *color;
+
+    if (SAI_WRED_ATTR_WEIGHT == attr) {
+        wred->weight = value->u8;
+        return;
+    }
+
+    if (SAI_WRED_ATTR_ECN_MARK_ENABLE == attr) {
+        wred->ecn_mark = value->booldata;
+        return;
+    }
+
+    color = &wred->colors[WRED_COLOR(attr)];
+
+    switch (WRED_COLOR_ATTR(attr)) {
+    case SAI_WRED_ATTR_GREEN_ENABLE:
+        color->enable = value->booldata;
+        break;
+
+    case SAI_WRED_ATTR_GREEN_MIN_THRESHOLD:
+        color->min_threshold = value->u32;
+        break;
+
+    case SAI_WRED_ATTR_GREEN_MAX_THRESHOLD:
+        color->max_threshold = value->u32;
+        break;
+
+    case SAI_WRED_ATTR_GREEN_DROP_PROBABILITY:
+        color->drop_probability = value->u32;
+        break;
+    }
+}
+
+/* Compile a profile. Enabled colors need both thresholds, the minimum not
+ * above the maximum. Returns the first color attribute at fault in attr */
+static sai_status_t wred_compile(_In_ const wred_t *wred, _Out_ wred_table_t **table, _Out_ sai_attr_id_t *attr)
+{
+    const wred_color_t *color;
+    wred_ramp_t        *ramp;
+    uint32_t            ii;
+
+    *table = NULL;
+
+    for (ii = 0; ii < WRED_COLORS; ii++) {
+        color = &wred->colors[ii];
+        *attr = SAI_WRED_ATTR_GREEN_ENABLE + ii * WRED_COLOR_ATTRS;
+        if (!color->enable) {
+            continue;
+        }
+        if ((0 == color->min_threshold) || (0 == color->max_threshold)) {
+            STUB_LOG_ERR("WRED color %u enabled without thresholds\n", ii);
+            return SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING;
+        }
+        if (color->min_threshold > color->max_threshold) {
+            *attr = SAI_WRED_ATTR_GREEN_MIN_THRESHOLD + ii * WRED_COLOR_ATTRS;
+            STUB_LOG_ERR("WRED color %u min threshold %u above max threshold %u\n", ii, color->min_threshold,
+                         color->max_threshold);
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+    }
+
+    if (NULL == (*table = calloc(1, sizeof(**table)))) {
+        STUB_LOG_ERR("Can't allocate WRED table\n");
+        return SAI_STATUS_NO_MEMORY;
+    }
+
+    for (ii = 0; ii < WRED_COLORS; ii++) {
+        color               = &wred->colors[ii];
+        ramp                = &(*table)->ramps[ii];
+        ramp->enable        = color->enable;
+        ramp->min_threshold = color->min_threshold;
+        ramp->max_threshold = color->max_threshold;
+        /* (avg - min) * slope stays below 2^32 inside the ramp */
+        if (color->max_threshold > color->min_threshold) {
+            ramp->slope = (((uint64_t)color->drop_probability << 32) / 100) /
+                          (color->max_threshold - color->min_threshold);
+        }
+    }
+    (*table)->weight   = wred->weight;
+    (*table)->ecn_mark = wred->ecn_mark;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+void db_init_wred(void)
+{
+    uint32_t ii;
+
+    pthread_rwlock_wrlock(&wred_db_lock);
+
+    for (ii = 0; ii < MAX_WREDS; ii++) {
+        free(wred_tables[ii]);
+        wred_tables[ii] = NULL;
+    }
+    memset(wred_db, 0, sizeof(wred_db));
+
+    pthread_rwlock_unlock(&wred_db_lock);
+}
+
+/* Take a reference on a profile for a queue, the index tells it in
+ * db_apply_wred. SAI_STATUS_INVALID_ATTR_VALUE_0 when it does not exist */
+sai_status_t db_wred_bind(_In_ sai_object_id_t wred_id, _Out_ uint32_t *wred)
+{
+    pthread_rwlock_wrlock(&wred_db_lock);
+
+    if (SAI_STATUS_SUCCESS != wred_db_index(wred_id, wred)) {
+        pthread_rwlock_unlock(&wred_db_lock);
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    wred_db[*wred].ref_count++;
+
+    pthread_rwlock_unlock(&wred_db_lock);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Drop a reference of db_wred_bind, STUB_NO_WRED is ignored */
+void db_wred_unbind(_In_ uint32_t wred)
+{
+    if (STUB_NO_WRED == wred) {
+        return;
+    }
+
+    pthread_rwlock_wrlock(&wred_db_lock);
+    assert(wred_db[wred].ref_count > 0);
+    wred_db[wred].ref_count--;
+    pthread_rwlock_unlock(&wred_db_lock);
+}
+
+/* xorshift32, a state per thread */
+static inline uint32_t wred_random(void)
+{
+    uint32_t state = wred_random_state;
+
+    if (0 == state) {
+        state = (uint32_t)(uintptr_t)&wred_random_state | 1;
+    }
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    return wred_random_state = state;
+}
+
+/*
+ * Routine Description:
+ *    Move the average of a queue by a frame offered to it and tell what
+ *    becomes of the frame. Called inside a read side section
+ *
+ * Arguments:
+ *    [in] wred - profile index of the queue
+ *    [inout] average - average occupancy of the queue, in bytes times
+ *                      2^16, kept by the queue
+ *    [in] occupancy - bytes in the queue
+ *    [in] color - color of the frame [sai_packet_color_t]
+ *
+ * Return Values:
+ *    STUB_WRED_QUEUE, STUB_WRED_DROP, or STUB_WRED_MARK for frames to mark
+ *    if ECN capable and drop otherwise
+ */
+stub_wred_action_t db_apply_wred(_In_ uint32_t    wred,
+                                 _Inout_ int64_t *average,
+                                 _In_ uint64_t    occupancy,
+                                 _In_ uint32_t    color)
+{
+    const wred_table_t *table = STUB_RCU_DEREF(wred_tables[wred]);
+    const wred_ramp_t  *ramp;
+    uint64_t            avg;
+
+    /* A queue may still hold the index of a profile just unbound */
+    if (NULL == table) {
+        return STUB_WRED_QUEUE;
+    }
+
+    *average += (((int64_t)occupancy << WRED_AVG_SHIFT) - *average) >> table->weight;
+
+    ramp = &table->ramps[color];
+    if (!ramp->enable) {
+        return STUB_WRED_QUEUE;
+    }
+
+    avg = (uint64_t)*average >> WRED_AVG_SHIFT;
+    if (avg < ramp->min_threshold) {
+        return STUB_WRED_QUEUE;
+    }
+    if (avg >= ramp->max_threshold) {
+        return STUB_WRED_DROP;
+    }
+
+    if (wred_random() >= (avg - ramp->min_threshold) * ramp->slope) {
+        return STUB_WRED_QUEUE;
+    }
+
+    return table->ecn_mark ? STUB_WRED_MARK : STUB_WRED_DROP;
+}
+
+static inline uint16_t wred_read16(_In_ const uint8_t *data)
+{
+    return (uint16_t)((data[0] << 8) | data[1]);
+}
+
+/*
+ * Routine Description:
+ *    Mark an ECN capable IPv4 or IPv6 frame Congestion Experienced, with
+ *    an incremental IPv4 header checksum update, RFC 1624 eqn. 3
+ *
+ * Arguments:
+ *    [inout] packet - frame
+ *
+ * Return Values:
+ *    true if the frame is ECN capable and now marked, false otherwise
+ */
+bool db_wred_mark_ecn(_Inout_ struct _stub_packet_t *packet)
+{
+    uint8_t *data = packet->data;
+    uint32_t l3_offset = WRED_ETH_HDR_LEN;
+    uint16_t ethertype, old_word, new_word;
+    uint32_t sum;
+    uint8_t *ip;
+
+    if ((NULL == data) || (packet->length < WRED_ETH_HDR_LEN)) {
+        return false;
+    }
+
+    ethertype = wred_read16(data + 12);
+    if (WRED_ETHERTYPE_VLAN == ethertype) {
+        if (packet->length < WRED_ETH_HDR_LEN + WRED_VLAN_HDR_LEN) {
+            return false;
+        }
+        ethertype  = wred_read16(data + WRED_ETH_HDR_LEN + 2);
+        l3_offset += WRED_VLAN_HDR_LEN;
+    }
+    ip = data + l3_offset;
+
+    if ((WRED_ETHERTYPE_IPV4 == ethertype) && (packet->length >= l3_offset + WRED_IPV4_HDR_LEN) &&
+        (4 == ip[0] >> 4)) {
+        if (0 == (ip[1] & WRED_ECN_CE)) {
+            return false;
+        }
+        old_word = wred_read16(ip);
+        ip[1]   |= WRED_ECN_CE;
+        new_word = wred_read16(ip);
+
+        sum  = (uint16_t)~wred_read16(ip + 10);
+        sum += (uint16_t)~old_word;
+        sum += new_word;
+        sum  = (sum & 0xFFFF) + (sum >> 16);
+        sum  = (sum & 0xFFFF) + (sum >> 16);
+        ip[10] = (uint8_t)(~sum >> 8);
+        ip[11] = (uint8_t)~sum;
+        return true;
+    }
+
+    /* Traffic class across the first two bytes, ECN in bits 4 and 5 of the second */
+    if ((WRED_ETHERTYPE_IPV6 == ethertype) && (packet->length >= l3_offset + WRED_IPV6_HDR_LEN) &&
+        (6 == ip[0] >> 4)) {
+        if (0 == (ip[1] & (WRED_ECN_CE << 4))) {
+            return false;
+        }
+        ip[1] |= WRED_ECN_CE << 4;
+        return true;
+    }
+
+    return false;
+}
+
+/*
+ * Routine Description:
+ *    Create WRED Profile
+ *
+ * Arguments:
+ *    [out] wred_id - Wred profile Id.
+ *    [in] attr_count - number of attributes
+ *    [in] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_create_wred_profile(_Out_ sai_object_id_t     *wred_id,
+                                      _In_ uint32_t               attr_count,
+                                      _In_ const sai_attribute_t *attr_list)
+{
+    const sai_attribute_value_t *value;
+    wred_t                       wred = wred_defaults;
+    wred_table_t                *table;
+    sai_attr_id_t                attr, fault;
+    uint32_t                     index, profile;
+    sai_status_t                 status;
+    char                         list_str[MAX_LIST_VALUE_STR_LEN];
+    char                         key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    if (NULL == wred_id) {
+        STUB_LOG_ERR("NULL WRED id param\n");
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (SAI_STATUS_SUCCESS !=
+        (status =
+             check_attribs_metadata(attr_count, attr_list, wred_attribs, wred_vendor_attribs,
+                                    SAI_OPERATION_CREATE))) {
+        STUB_LOG_ERR("Failed attribs check\n");
+        return status;
+    }
+
+    sai_attr_list_to_str(attr_count, attr_list, wred_attribs, MAX_LIST_VALUE_STR_LEN, list_str);
+    STUB_LOG_NTC("Create WRED profile, %s\n", list_str);
+
+    for (attr = SAI_WRED_ATTR_GREEN_ENABLE; attr <= SAI_WRED_ATTR_ECN_MARK_ENABLE; attr++) {
+        if (SAI_STATUS_SUCCESS != find_attrib_in_list(attr_count, attr_list, attr, &value, &index)) {
+            continue;
+        }
+        if (SAI_STATUS_SUCCESS != wred_check_value(attr, value)) {
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + index;
+        }
+        wred_apply(&wred, attr, value);
+    }
+
+    if (SAI_STATUS_SUCCESS != (status = wred_compile(&wred, &table, &fault))) {
+        if ((SAI_STATUS_INVALID_ATTR_VALUE_0 == status) &&
+            (SAI_STATUS_SUCCESS == find_attrib_in_list(attr_count, attr_list, fault, &value, &index))) {
+            return SAI_STATUS_INVALID_ATTR_VALUE_0 + index;
+        }
+        return status;
+    }
+
+    pthread_rwlock_wrlock(&wred_db_lock);
+
+    for (profile = 0; profile < MAX_WREDS; profile++) {
+        if (!wred_db[profile].is_used) {
+            break;
+        }
+    }
+
+    if (MAX_WREDS == profile) {
+        pthread_rwlock_unlock(&wred_db_lock);
+        free(table);
+        STUB_LOG_ERR("WRED profile table full\n");
+        return SAI_STATUS_TABLE_FULL;
+    }
+
+    wred_db[profile]         = wred;
+    wred_db[profile].is_used = true;
+    STUB_RCU_ASSIGN(wred_tables[profile], table);
+
+    pthread_rwlock_unlock(&wred_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = stub_create_object(SAI_OBJECT_TYPE_WRED, profile, wred_id))) {
+        return status;
+    }
+    wred_key_to_str(*wred_id, key_str);
+    STUB_LOG_NTC("Created %s\n", key_str);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Remove WRED Profile
+ *
+ * Arguments:
+ *    [in] wred_id - Wred profile Id.
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_remove_wred_profile(_In_ sai_object_id_t wred_id)
+{
+    wred_table_t *old;
+    char          key_str[MAX_KEY_STR_LEN];
+    sai_status_t  status;
+    uint32_t      profile;
+
+    STUB_LOG_ENTER();
+
+    wred_key_to_str(wred_id, key_str);
+    STUB_LOG_NTC("Remove %s\n", key_str);
+
+    pthread_rwlock_wrlock(&wred_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = wred_db_index(wred_id, &profile))) {
+        pthread_rwlock_unlock(&wred_db_lock);
+        return status;
+    }
+
+    if (0 != wred_db[profile].ref_count) {
+        pthread_rwlock_unlock(&wred_db_lock);
+        STUB_LOG_ERR("WRED profile %u is bound to %u queues\n", profile, wred_db[profile].ref_count);
+        return SAI_STATUS_OBJECT_IN_USE;
+    }
+
+    old = wred_tables[profile];
+    STUB_RCU_ASSIGN(wred_tables[profile], NULL);
+    stub_rcu_defer_free(old);
+
+    wred_db[profile].is_used = false;
+
+    pthread_rwlock_unlock(&wred_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Routine Description:
+ *    Set attributes to Wred profile.
+ *
+ * Arguments:
+ *    [in] wred_id - Wred profile Id.
+ *    [in] attr - attribute
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_set_wred_attribute(_In_ sai_object_id_t wred_id, _In_ const sai_attribute_t *attr)
+{
+    const sai_object_key_t key = { .object_id = wred_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+
+    STUB_LOG_ENTER();
+
+    wred_key_to_str(wred_id, key_str);
+    return sai_set_attribute(&key, key_str, wred_attribs, wred_vendor_attribs, attr);
+}
+
+/*
+ * Routine Description:
+ *    Get Wred profile attribute
+ *
+ * Arguments:
+ *    [in] wred_id - Wred Profile Id
+ *    [in] attr_count - number of attributes
+ *    [inout] attr_list - array of attributes
+ *
+ * Return Values:
+ *    SAI_STATUS_SUCCESS on success
+ *    Failure status code on error
+ */
+sai_status_t stub_get_wred_attribute(_In_ sai_object_id_t     wred_id,
+                                     _In_ uint32_t            attr_count,
+                                     _Inout_ sai_attribute_t *attr_list)
+{
+    const sai_object_key_t key = { .object_id = wred_id };
+    char                   key_str[MAX_KEY_STR_LEN];
+    sai_status_t           status;
+
+    STUB_LOG_ENTER();
+
+    wred_key_to_str(wred_id, key_str);
+
+    pthread_rwlock_rdlock(&wred_db_lock);
+    status = sai_get_attributes(&key, key_str, wred_attribs, wred_vendor_attribs, attr_count, attr_list);
+    pthread_rwlock_unlock(&wred_db_lock);
+
+    return status;
+}
+
+/* Color enables [bool], thresholds [uint32_t], drop probabilities
+ * [uint32_t], weight [uint8_t], ECN mark enable [bool] */
+sai_status_t stub_wred_attr_get(_In_ const sai_object_key_t   *key,
+                                _Inout_ sai_attribute_value_t *value,
+                                _In_ uint32_t                  attr_index,
+                                _Inout_ vendor_cache_t        *cache,
+                                void                          *arg)
+{
+    const wred_color_t *color;
+    const wred_t       *wred;
+    sai_status_t        status;
+    uint32_t            profile;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = wred_db_index(key->object_id, &profile))) {
+        return status;
+    }
+
+    wred = &wred_db[profile];
+
+    if (SAI_WRED_ATTR_WEIGHT == (long)arg) {
+        value->u8 = wred->weight;
+    } else if (SAI_WRED_ATTR_ECN_MARK_ENABLE == (long)arg) {
+        value->booldata = wred->ecn_mark;
+    } else {
+        color = &wred->colors[WRED_COLOR((long)arg)];
+        switch (WRED_COLOR_ATTR((long)arg)) {
+        case SAI_WRED_ATTR_GREEN_ENABLE:
+            value->booldata = color->enable;
+            break;
+
+        case SAI_WRED_ATTR_GREEN_MIN_THRESHOLD:
+            value->u32 = color->min_threshold;
+            break;
+
+        case SAI_WRED_ATTR_GREEN_MAX_THRESHOLD:
+            value->u32 = color->max_threshold;
+            break;
+
+        case SAI_WRED_ATTR_GREEN_DROP_PROBABILITY:
+            value->u32 = color->drop_probability;
+            break;
+        }
+    }
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+/* Color enables [bool], thresholds [uint32_t], drop probabilities
+ * [uint32_t], weight [uint8_t], ECN mark enable [bool]. The profile is
+ * compiled again and the queues switch to it at once */
+sai_status_t stub_wred_attr_set(_In_ const sai_object_key_t      *key,
+                                _In_ const sai_attribute_value_t *value,
+                                void                             *arg)
+{
+    wred_table_t *table, *old;
+    sai_attr_id_t fault;
+    sai_status_t  status;
+    uint32_t      profile;
+    wred_t        wred;
+
+    STUB_LOG_ENTER();
+
+    if (SAI_STATUS_SUCCESS != (status = wred_check_value((long)arg, value))) {
+        return status;
+    }
+
+    pthread_rwlock_wrlock(&wred_db_lock);
+
+    if (SAI_STATUS_SUCCESS != (status = wred_db_index(key->object_id, &profile))) {
+        pthread_rwlock_unlock(&wred_db_lock);
+        return status;
+    }
+
+    /* Enabling a color takes its thresholds, set them first */
+    wred = wred_db[profile];
+    wred_apply(&wred, (long)arg, value);
+    if (SAI_STATUS_SUCCESS != (status = wred_compile(&wred, &table, &fault))) {
+        pthread_rwlock_unlock(&wred_db_lock);
+        return (SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING == status) ? SAI_STATUS_INVALID_ATTR_VALUE_0 : status;
+    }
+
+    wred_db[profile] = wred;
+
+    old = wred_tables[profile];
+    STUB_RCU_ASSIGN(wred_tables[profile], table);
+    stub_rcu_defer_free(old);
+
+    pthread_rwlock_unlock(&wred_db_lock);
+
+    STUB_LOG_EXIT();
+    return SAI_STATUS_SUCCESS;
+}
+
+const sai_wred_api_t wred_api = {
+    stub_create_wred_profile,
+    stub_remove_wred_profile,
+    stub_set_wred_attribute,
+    stub_get_wred_attribute
+};
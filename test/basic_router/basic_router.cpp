@@ -26,6 +26,7 @@
 #include <vector>
 #include <map>
 #include <thread>
+#include <chrono>
 
 
 #include <stdint.h>
@@ -48,6 +49,7 @@
 #include "nexthopgrp_mgr.h"
 #include "nexthop_mgr.h"
 #include "fdb_mgr.h"
+#include "route_feed.h"
 #include "basic_router.h"
 
 
@@ -58,6 +60,9 @@ using ::testing::InitGoogleTest;
 #define PANEL_PORT_VLAN_START   1024
 #define MAX_PORT                256
 #define MAX_TEST                4
+#define FDB_SCALE_ENTRIES       100000
+#define ROUTE_SCALE_ENTRIES     50000
+#define ROUTE_FEED_ENTRIES      100000
 
 /*--------------------------------------------------------*/
 //definition of the api tables
@@ -124,6 +129,7 @@ IpAddress   g_ipAddr[MAX_PORT];
 IpAddress   g_ipMask[MAX_PORT];
 MacAddress  g_macAddr[MAX_PORT];
 sai_object_id_t g_rif_id[MAX_PORT];
+sai_object_id_t g_port_id[MAX_PORT];
 MacAddress  g_dst_mac[MAX_PORT];
 
 NextHopMgr* nexthop_mgr;
@@ -483,6 +489,7 @@ bool basic_router_setup()
         vlanid = PANEL_PORT_VLAN_START + i + 1;
 
         port_objlist.push_back(port_list[i]);
+        g_port_id[i] = port_list[i];
 
         if (!setup_one_l3_interface(vlanid, port_objlist.size(), port_objlist.data(),
                                     g_macAddr[i], g_ipAddr[i], g_ipMask[i], g_rif_id[i]))
@@ -878,9 +885,15 @@ static void route_removing()
     neighbor_mgr->Show();
 
     ipAddr = IpAddress("192.168.1.1");
-    ASSERT_TRUE(!neighbor_mgr->Del(ipAddr));
+    nexthops = IpAddresses("192.168.1.1,192.168.2.1,192.169.3.1");
+    ASSERT_TRUE(neighbor_mgr->Del(ipAddr));
+
+    LOGG(TEST_INFO, TESTCASE, "*** the ECMP group of 192.0.0.0/8 drops 192.168.1.1 in place ***\n");
+    ASSERT_EQ(2u, nexthopgrp_mgr->GetNextHopGrpEntry(nexthops)->members.size());
 
-    LOGG(TEST_INFO, TESTCASE, "*** expected failure to remove the neighbor 192.168.1.1 ***\n");
+    LOGG(TEST_INFO, TESTCASE, "--- add back the neighbor 192.168.1.1, the group takes it back ---\n");
+    ASSERT_TRUE(neighbor_mgr->Add(ipAddr, g_dst_mac[0], g_intfAlias[0], g_rif_id[0]));
+    ASSERT_EQ(3u, nexthopgrp_mgr->GetNextHopGrpEntry(nexthops)->members.size());
 
     LOGG(TEST_INFO, TESTCASE, "--- remove route 192.0.0.0/8 with ECMP group, the last route use neighbor 192.168.1.1 ---\n");
     prefix = IpPrefix("192.0.0.0/8");
@@ -904,6 +917,362 @@ TEST_F(saiUnitTest, route_unittest)
     neighbor_mgr->Show();
 }
 
+/*
+ * IPv4 and IPv6 routes in the default and in a second virtual router.
+ * The same prefix may exist in both, lookups take the longest match of
+ * the asked virtual router only.
+ */
+TEST_F(saiUnitTest, route_dual_stack_vrf_test)
+{
+    sai_object_id_t vr_id;
+    IpAddress nhAddr("2001:db8:1::1");
+    const RouteEntry *entry;
+    int saved_log_level = curr_log_level;
+    unsigned int i;
+
+    ASSERT_EQ(SAI_STATUS_SUCCESS, sai_vr_api->create_virtual_router(&vr_id, 0, NULL));
+    ASSERT_TRUE(neighbor_mgr->Add(nhAddr, g_dst_mac[0], g_intfAlias[0], g_rif_id[0]));
+
+    LOGG(TEST_INFO, TESTCASE, "--- add ipv6 routes to the default virtual router ---\n");
+    ASSERT_TRUE(route_mgr->Add(IpPrefix("2001:db8::/32"), IpAddresses("2001:db8:1::1")));
+    ASSERT_TRUE(route_mgr->Add(IpPrefix("2001:db8:100::/48"), IpAddresses("::")));
+    ASSERT_TRUE(route_mgr->Add(IpPrefix("10.0.0.0/8"), IpAddresses("0.0.0.0")));
+
+    LOGG(TEST_INFO, TESTCASE, "--- add the same and longer prefixes to virtual router 0x%lx ---\n", vr_id);
+    ASSERT_TRUE(route_mgr->Add(IpPrefix("10.0.0.0/8"), IpAddresses("0.0.0.0"), vr_id));
+    ASSERT_TRUE(route_mgr->Add(IpPrefix("10.1.0.0/16"), IpAddresses("0.0.0.0"), vr_id));
+    route_mgr->Show();
+
+    entry = route_mgr->Lookup(IpAddress("2001:db8:100::5"));
+    ASSERT_TRUE(entry != NULL);
+    ASSERT_EQ(48, entry->prefix.MaskLen());
+
+    entry = route_mgr->Lookup(IpAddress("2001:db8:ffff::1"));
+    ASSERT_TRUE(entry != NULL);
+    ASSERT_TRUE(entry->nexthops == IpAddresses("2001:db8:1::1"));
+
+    ASSERT_TRUE(route_mgr->Lookup(IpAddress("2001:db9::1")) == NULL);
+    ASSERT_EQ(8, route_mgr->Lookup(IpAddress("10.1.2.3"))->prefix.MaskLen());
+    ASSERT_EQ(16, route_mgr->Lookup(IpAddress("10.1.2.3"), vr_id)->prefix.MaskLen());
+    ASSERT_EQ(8, route_mgr->Lookup(IpAddress("10.2.2.3"), vr_id)->prefix.MaskLen());
+
+    LOGG(TEST_INFO, TESTCASE, "--- remove the ipv6 next hop route ---\n");
+    ASSERT_TRUE(route_mgr->Del(IpPrefix("2001:db8::/32")));
+    ASSERT_TRUE(route_mgr->Lookup(IpAddress("2001:db8:ffff::1")) == NULL);
+
+    /* Per-entry logs would dominate the timing */
+    curr_log_level = TEST_NOTICE;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (i = 0; i < ROUTE_SCALE_ENTRIES; i++)
+    {
+        uint8_t v6[16] = { 0x20, 0x01, 0x0d, 0xb9, (uint8_t)(i >> 8), (uint8_t)i };
+
+        ASSERT_TRUE(route_mgr->Add(IpPrefix(IpAddress(htonl(0x14000000 | (i << 8))), 24),
+                                   IpAddresses("0.0.0.0"), vr_id));
+        ASSERT_TRUE(route_mgr->Add(IpPrefix(IpAddress(v6), 48), IpAddresses("::"), vr_id));
+    }
+
+    auto added = std::chrono::steady_clock::now();
+
+    for (i = 0; i < ROUTE_SCALE_ENTRIES; i++)
+    {
+        uint8_t v6[16] = { 0x20, 0x01, 0x0d, 0xb9, (uint8_t)(i >> 8), (uint8_t)i, 0, 1 };
+
+        ASSERT_TRUE(route_mgr->Lookup(IpAddress(htonl(0x14000001 | (i << 8))), vr_id) != NULL);
+        ASSERT_TRUE(route_mgr->Lookup(IpAddress(v6), vr_id) != NULL);
+    }
+
+    auto looked_up = std::chrono::steady_clock::now();
+
+    ASSERT_TRUE(route_mgr->EraseAll());
+
+    curr_log_level = saved_log_level;
+
+    ASSERT_EQ(0u, route_mgr->Size());
+    ASSERT_TRUE(neighbor_mgr->Del(nhAddr));
+    ASSERT_EQ(SAI_STATUS_SUCCESS, sai_vr_api->remove_virtual_router(vr_id));
+
+    LOGG(TEST_NOTICE, TESTCASE, "routes 2x%u dual stack: add %.0f ms, lookup %.0f ms\n",
+         ROUTE_SCALE_ENTRIES,
+         std::chrono::duration<double, std::milli>(added - start).count(),
+         std::chrono::duration<double, std::milli>(looked_up - added).count());
+}
+
+/*
+ * Routes with the same next hops share one refcounted group. A next hop
+ * flap and a small change of the set update the group members in place.
+ */
+TEST_F(saiUnitTest, route_ecmp_sharing_test)
+{
+    IpAddresses ecmp("192.168.1.1,192.168.2.1,192.169.3.1");
+    IpAddresses grown("192.168.1.1,192.168.2.1,192.169.3.1,24.58.202.118");
+    const NextHopGrpEntry *nhgEntry;
+    sai_object_id_t nhg_id;
+    unsigned int i;
+
+    neighbor_adding();
+
+    for (i = 0; i < 8; i++)
+    {
+        ASSERT_TRUE(route_mgr->Add(IpPrefix(IpAddress(htonl(0x64000000 | (i << 8))), 24), ecmp));
+    }
+
+    nhgEntry = nexthopgrp_mgr->GetNextHopGrpEntry(ecmp);
+    ASSERT_TRUE(nhgEntry != NULL);
+    ASSERT_EQ(8u, nhgEntry->refCount);
+    nhg_id = nhgEntry->nhg_id;
+    nexthopgrp_mgr->Show();
+
+    LOGG(TEST_INFO, TESTCASE, "--- next hop 192.168.2.1 down and up ---\n");
+    ASSERT_TRUE(nexthopgrp_mgr->SetMemberState(IpAddress("192.168.2.1"), false));
+    ASSERT_EQ(2u, nhgEntry->members.size());
+    ASSERT_TRUE(nexthopgrp_mgr->SetMemberState(IpAddress("192.168.2.1"), true));
+    ASSERT_EQ(3u, nhgEntry->members.size());
+    ASSERT_EQ(nhg_id, nhgEntry->nhg_id);
+
+    for (i = 1; i < 8; i++)
+    {
+        ASSERT_TRUE(route_mgr->Del(IpPrefix(IpAddress(htonl(0x64000000 | (i << 8))), 24)));
+    }
+
+    ASSERT_EQ(1u, nhgEntry->refCount);
+
+    LOGG(TEST_INFO, TESTCASE, "--- grow the set of the last route in place ---\n");
+    ASSERT_TRUE(route_mgr->Add(IpPrefix("100.0.0.0/24"), grown));
+    ASSERT_TRUE(nexthopgrp_mgr->GetNextHopGrpEntry(ecmp) == NULL);
+    nhgEntry = nexthopgrp_mgr->GetNextHopGrpEntry(grown);
+    ASSERT_TRUE(nhgEntry != NULL);
+    ASSERT_EQ(nhg_id, nhgEntry->nhg_id);
+    ASSERT_EQ(4u, nhgEntry->members.size());
+
+    ASSERT_TRUE(route_mgr->Del(IpPrefix("100.0.0.0/24")));
+    ASSERT_TRUE(nexthopgrp_mgr->GetNextHopGrpEntry(grown) == NULL);
+    ASSERT_TRUE(neighbor_mgr->EraseAll());
+}
+
+/*
+ * Neighbor loss reaches only the groups and routes using the neighbor.
+ * A group shrinks in place, routes left without next hop trap to the CPU
+ * and forward again once a next hop is back.
+ */
+TEST_F(saiUnitTest, neighbor_loss_test)
+{
+    IpAddresses single("172.16.20.22");
+    IpAddresses ecmp("192.168.1.1,192.168.2.1");
+    IpAddress addr;
+    unsigned int i;
+
+    neighbor_adding();
+
+    for (i = 0; i < 10; i++)
+    {
+        ASSERT_TRUE(route_mgr->Add(IpPrefix(IpAddress(htonl(0x28000000 | (i << 8))), 24), single));
+        ASSERT_TRUE(route_mgr->Add(IpPrefix(IpAddress(htonl(0x29000000 | (i << 8))), 24), ecmp));
+    }
+
+    LOGG(TEST_INFO, TESTCASE, "--- lose 172.16.20.22, its routes trap ---\n");
+    ASSERT_TRUE(neighbor_mgr->Del(IpAddress("172.16.20.22")));
+    ASSERT_EQ(SAI_PACKET_ACTION_TRAP, route_mgr->Lookup(IpAddress("40.0.3.1"))->action);
+    ASSERT_EQ(SAI_PACKET_ACTION_FORWARD, route_mgr->Lookup(IpAddress("41.0.3.1"))->action);
+    ASSERT_EQ((sai_object_id_t)SAI_NULL_OBJECT_ID, nexthopgrp_mgr->GetNextHopGrpEntry(single)->nhg_id);
+
+    LOGG(TEST_INFO, TESTCASE, "--- lose 192.168.1.1, the group keeps forwarding ---\n");
+    ASSERT_TRUE(neighbor_mgr->Del(IpAddress("192.168.1.1")));
+    ASSERT_EQ(1u, nexthopgrp_mgr->GetNextHopGrpEntry(ecmp)->members.size());
+    ASSERT_EQ(SAI_PACKET_ACTION_FORWARD, route_mgr->Lookup(IpAddress("41.0.3.1"))->action);
+
+    LOGG(TEST_INFO, TESTCASE, "--- lose 192.168.2.1, the group routes trap and the group runs empty ---\n");
+    ASSERT_TRUE(neighbor_mgr->Del(IpAddress("192.168.2.1")));
+    ASSERT_EQ(SAI_PACKET_ACTION_TRAP, route_mgr->Lookup(IpAddress("41.0.3.1"))->action);
+    ASSERT_TRUE(nexthopgrp_mgr->GetNextHopGrpEntry(ecmp)->members.empty());
+
+    LOGG(TEST_INFO, TESTCASE, "--- neighbors back, routes forward again ---\n");
+    addr = IpAddress("192.168.2.1");
+    ASSERT_TRUE(neighbor_mgr->Add(addr, g_dst_mac[2], g_intfAlias[2], g_rif_id[2]));
+    ASSERT_EQ(SAI_PACKET_ACTION_FORWARD, route_mgr->Lookup(IpAddress("41.0.3.1"))->action);
+
+    addr = IpAddress("172.16.20.22");
+    ASSERT_TRUE(neighbor_mgr->Add(addr, g_dst_mac[1], g_intfAlias[1], g_rif_id[1]));
+    ASSERT_EQ(SAI_PACKET_ACTION_FORWARD, route_mgr->Lookup(IpAddress("40.0.3.1"))->action);
+    ASSERT_EQ(neighbor_mgr->GetNeighborEntry(addr)->nhid, nexthopgrp_mgr->GetNextHopGrpEntry(single)->nhg_id);
+
+    ASSERT_TRUE(route_mgr->EraseAll());
+    ASSERT_TRUE(neighbor_mgr->EraseAll());
+}
+
+/*
+ * A text feed from a file and a binary feed from a pipe. Re-announced and
+ * withdrawn prefixes coalesce, the bad line is counted and skipped. Set
+ * ROUTE_FEED to the path of a feed to time its convergence as well.
+ */
+TEST_F(saiUnitTest, route_feed_test)
+{
+    char path[] = "/tmp/route_feed_XXXXXX";
+    IpAddress nhAddr("2001:db8:1::1");
+    RouteFeed feed(route_mgr);
+    int saved_log_level = curr_log_level;
+    size_t base_count = route_mgr->Size();
+    int pipefd[2];
+    unsigned int i;
+    FILE *fp;
+
+    neighbor_adding();
+    ASSERT_TRUE(neighbor_mgr->Add(nhAddr, g_dst_mac[0], g_intfAlias[0], g_rif_id[0]));
+
+    int fd = mkstemp(path);
+    ASSERT_TRUE(fd >= 0);
+    fp = fdopen(fd, "w");
+    fprintf(fp, "# prefix nexthops\n");
+    fprintf(fp, "30.0.0.0/8 192.168.1.1\n-30.0.0.0/8\n");
+
+    for (i = 0; i < ROUTE_FEED_ENTRIES; i++)
+    {
+        fprintf(fp, "%u.%u.%u.0/24 192.168.1.1\n", 20 + (i >> 16), i >> 8 & 0xFF, i & 0xFF);
+    }
+
+    for (i = 0; i < ROUTE_FEED_ENTRIES / 10; i++)
+    {
+        fprintf(fp, "%u.%u.%u.0/24 192.168.1.1,192.168.2.1\n", 20 + (i >> 16), i >> 8 & 0xFF, i & 0xFF);
+    }
+
+    for (i = 0; i < ROUTE_FEED_ENTRIES / 20; i++)
+    {
+        fprintf(fp, "-%u.%u.%u.0/24\n", 20 + (i >> 16), i >> 8 & 0xFF, i & 0xFF);
+    }
+
+    fprintf(fp, "not-a-prefix 192.168.1.1\n");
+    fclose(fp);
+
+    /* Per-route logs would dominate the timing */
+    curr_log_level = TEST_NOTICE;
+
+    ASSERT_TRUE(feed.Run(path));
+    unlink(path);
+
+    ASSERT_EQ(1u, feed.Stats().errors);
+    ASSERT_EQ(1u, feed.Stats().coalesced);
+    ASSERT_EQ(0u, feed.Stats().failed);
+    ASSERT_EQ(base_count + ROUTE_FEED_ENTRIES - ROUTE_FEED_ENTRIES / 20, route_mgr->Size());
+    ASSERT_TRUE(route_mgr->Lookup(IpAddress("20.0.1.1")) == NULL);
+    ASSERT_EQ(2u, route_mgr->Lookup(IpAddress("20.23.40.1"))->nexthops.size());
+
+    LOGG(TEST_NOTICE, TESTCASE, "text feed %lu updates: %.0f ms to FIB\n",
+         feed.Stats().records, feed.Stats().elapsed_ms);
+
+    ASSERT_EQ(0, pipe(pipefd));
+
+    std::thread writer([&pipefd]()
+    {
+        FILE *out = fdopen(pipefd[1], "w");
+        uint8_t rec[26] = { ROUTE_FEED_ANNOUNCE, 6, 48, 0x20, 0x01, 0x0d, 0xb9, 0, 0, 1 };
+
+        fputs(ROUTE_FEED_MAGIC, out);
+
+        for (unsigned int n = 0; n < ROUTE_FEED_ENTRIES / 10; n++)
+        {
+            rec[7] = (uint8_t)(n >> 8);
+            rec[8] = (uint8_t)n;
+            memcpy(rec + 10, IpAddress("2001:db8:1::1").bytes(), 16);
+            fwrite(rec, 1, sizeof(rec), out);
+        }
+
+        fclose(out);
+    });
+
+    ASSERT_TRUE(feed.Run(pipefd[0]));
+    writer.join();
+    close(pipefd[0]);
+
+    ASSERT_EQ(0u, feed.Stats().errors);
+    ASSERT_EQ((uint64_t)ROUTE_FEED_ENTRIES / 10, feed.Stats().programmed);
+    ASSERT_TRUE(route_mgr->Lookup(IpAddress("2001:db9:2::1")) != NULL);
+
+    LOGG(TEST_NOTICE, TESTCASE, "binary feed %lu updates: %.0f ms to FIB\n",
+         feed.Stats().records, feed.Stats().elapsed_ms);
+
+    if (getenv("ROUTE_FEED"))
+    {
+        ASSERT_TRUE(feed.Run(getenv("ROUTE_FEED")));
+        LOGG(TEST_NOTICE, TESTCASE, "%s: %lu updates, %lu programmed, %.0f ms to FIB\n",
+             getenv("ROUTE_FEED"), feed.Stats().records, feed.Stats().programmed, feed.Stats().elapsed_ms);
+    }
+
+    ASSERT_TRUE(route_mgr->EraseAll());
+    curr_log_level = saved_log_level;
+    ASSERT_TRUE(neighbor_mgr->EraseAll());
+}
+
+/*
+ * Dynamic entries spread over the panel ports and vlans, flushed by port
+ * and by vlan. Static entries of the setup survive the flushes.
+ */
+TEST_F(saiUnitTest, fdb_scale_test)
+{
+    std::vector<MacAddress> macs;
+    uint8_t bytes[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    size_t static_count = fdb_mgr->Size();
+    size_t flushed_count;
+    int saved_log_level = curr_log_level;
+    unsigned int i;
+
+    for (i = 0; i < FDB_SCALE_ENTRIES; i++)
+    {
+        bytes[3] = (uint8_t)(i >> 16);
+        bytes[4] = (uint8_t)(i >> 8);
+        bytes[5] = (uint8_t)i;
+        macs.push_back(MacAddress(bytes));
+    }
+
+    /* Per-entry logs would dominate the timing */
+    curr_log_level = TEST_NOTICE;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (i = 0; i < FDB_SCALE_ENTRIES; i++)
+    {
+        ASSERT_TRUE(fdb_mgr->Add(macs[i], PANEL_PORT_VLAN_START + (i % g_testcount) + 1,
+                                 SAI_FDB_ENTRY_DYNAMIC, g_port_id[i % g_testcount],
+                                 SAI_PACKET_ACTION_FORWARD));
+    }
+
+    auto added = std::chrono::steady_clock::now();
+
+    for (i = 0; i < FDB_SCALE_ENTRIES; i++)
+    {
+        ASSERT_TRUE(fdb_mgr->GetFdbEntry(macs[i], PANEL_PORT_VLAN_START + (i % g_testcount) + 1) != NULL);
+    }
+
+    auto looked_up = std::chrono::steady_clock::now();
+
+    ASSERT_EQ(static_count + FDB_SCALE_ENTRIES, fdb_mgr->Size());
+
+    flushed_count = fdb_mgr->Size();
+    ASSERT_TRUE(fdb_mgr->FlushByPort(g_port_id[0]));
+    flushed_count -= fdb_mgr->Size();
+    ASSERT_TRUE(fdb_mgr->GetFdbEntry(macs[0], PANEL_PORT_VLAN_START + 1) == NULL);
+    ASSERT_TRUE(fdb_mgr->GetFdbEntry(g_dst_mac[0], PANEL_PORT_VLAN_START + 1) != NULL);
+
+    auto flushed = std::chrono::steady_clock::now();
+
+    for (i = 1; i < g_testcount; i++)
+    {
+        ASSERT_TRUE(fdb_mgr->FlushByVlan(PANEL_PORT_VLAN_START + i + 1));
+    }
+
+    curr_log_level = saved_log_level;
+
+    ASSERT_EQ(static_count, fdb_mgr->Size());
+
+    LOGG(TEST_NOTICE, TESTCASE, "fdb %u entries: add %.0f ms, lookup %.0f ms, flush %zu by port %.2f ms\n",
+         FDB_SCALE_ENTRIES,
+         std::chrono::duration<double, std::milli>(added - start).count(),
+         std::chrono::duration<double, std::milli>(looked_up - added).count(),
+         flushed_count,
+         std::chrono::duration<double, std::milli>(flushed - looked_up).count());
+}
+
 static void tearup_tests(void)
 {
 
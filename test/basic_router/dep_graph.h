@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2015 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc
+ *
+ *
+ */
+#pragma once
+
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+/*
+ * One layer of the forwarding dependency graph, the reverse edges from an
+ * object to the objects that use it. NextHopGrpMgr keeps next hop -> next
+ * hop set, RouteMgr keeps next hop set -> route, so a neighbor event reaches
+ * exactly the objects it affects without a table scan.
+ */
+template <typename From, typename To, typename Hash = std::hash<From> >
+class DepIndex
+{
+public:
+    typedef std::unordered_set<To> Users;
+
+    void Link(const From &from, const To &to)
+    {
+        m_users[from].insert(to);
+    }
+
+    void Unlink(const From &from, const To &to)
+    {
+        auto it = m_users.find(from);
+
+        if (it == m_users.end())
+        {
+            return;
+        }
+
+        it->second.erase(to);
+
+        if (it->second.empty())
+        {
+            m_users.erase(it);
+        }
+    }
+
+    // objects using from, NULL when there are none
+    const Users* Find(const From &from) const
+    {
+        auto it = m_users.find(from);
+
+        return (it == m_users.end()) ? NULL : &it->second;
+    }
+
+    size_t Size() const
+    {
+        return m_users.size();
+    }
+
+private:
+    std::unordered_map<From, Users, Hash> m_users;
+};
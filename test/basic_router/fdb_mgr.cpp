@@ -39,18 +39,59 @@
 
 extern sai_fdb_api_t* sai_fdb_api;
 
+FdbKey FdbMgr::MakeKey(const MacAddress &macAddr, sai_uint32_t vlan_id)
+{
+    const uint8_t *mac = macAddr.to_bytes();
+    FdbKey key = 0;
+
+    for (int i = 0; i < 6; i++)
+    {
+        key = (key << 8) | mac[i];
+    }
+
+    return key | ((FdbKey)(vlan_id & 0xFFFF) << 48);
+}
+
+/* Drop the entry from the table and from both indexes */
+void FdbMgr::Unlink(FdbKey key, const FdbEntry &fdbEntry)
+{
+    auto portIt = m_PortIndex.find(fdbEntry.port_id);
+    auto vlanIt = m_VlanIndex.find(fdbEntry.vlan_id);
+
+    if (portIt != m_PortIndex.end())
+    {
+        portIt->second.erase(key);
+
+        if (portIt->second.empty())
+        {
+            m_PortIndex.erase(portIt);
+        }
+    }
+
+    if (vlanIt != m_VlanIndex.end())
+    {
+        vlanIt->second.erase(key);
+
+        if (vlanIt->second.empty())
+        {
+            m_VlanIndex.erase(vlanIt);
+        }
+    }
+
+    m_FdbTable.erase(key);
+}
+
 void FdbMgr::Show()
 {
     const FdbEntry* fdbEntry;
     MacAddress mac;
-    std::vector<FdbEntry>::iterator it;
 
     LOGG(TEST_DEBUG, FDB, "\t--- --- --- --- --- --- Fdb Entry Table --- --- --- --- --- --- \n");
     LOGG(TEST_DEBUG, FDB, "\t{%-20s %-10s} {%-10s %-14s %-10s}\n", "mac", "valn_id", "type", "port id", "pkt act");
 
-    for (it = m_FdbVector.begin(); it != m_FdbVector.end(); ++it)
+    for (auto it = m_FdbTable.begin(); it != m_FdbTable.end(); ++it)
     {
-        fdbEntry = &(*it);
+        fdbEntry = &it->second;
         mac = fdbEntry->macAddr;
         LOGG(TEST_DEBUG, FDB, "\t{%-20s %-10hu} {%-10s 0x%-12lx %-10s}\n",
              mac.to_string().c_str(),
@@ -72,6 +113,7 @@ bool FdbMgr::Add( MacAddress macAddr,
                   sai_int32_t pkt_action)
 {
     FdbEntry fdbEntry;
+    FdbKey key = MakeKey(macAddr, vlan_id);
 
     fdbEntry.macAddr = macAddr;
     fdbEntry.vlan_id = vlan_id;
@@ -82,15 +124,11 @@ bool FdbMgr::Add( MacAddress macAddr,
     LOGG(TEST_INFO, FDB, "lookup fdb_entry {mac %-15s vlan_id %hu} \n",
          macAddr.to_string().c_str(), vlan_id);
 
-    for (std::vector<FdbEntry>::iterator it = m_FdbVector.begin();
-            it != m_FdbVector.end(); ++it)
+    if (m_FdbTable.find(key) != m_FdbTable.end())
     {
-        if (it->macAddr == macAddr && it->vlan_id == vlan_id )
-        {
-            LOGG(TEST_DEBUG, FDB, "fdb_entry {mac %-15s vlan_id %hu} already exists\n",
-                 macAddr.to_string().c_str(), vlan_id);
-            return true;
-        }
+        LOGG(TEST_DEBUG, FDB, "fdb_entry {mac %-15s vlan_id %hu} already exists\n",
+             macAddr.to_string().c_str(), vlan_id);
+        return true;
     }
 
     sai_status_t status;
@@ -119,7 +157,9 @@ bool FdbMgr::Add( MacAddress macAddr,
         return false;
     }
 
-    m_FdbVector.push_back(fdbEntry);
+    m_FdbTable.emplace(key, fdbEntry);
+    m_PortIndex[port_id].insert(key);
+    m_VlanIndex[vlan_id].insert(key);
 
     return true;
 }
@@ -129,19 +169,11 @@ bool FdbMgr::Del(MacAddress macAddr,
 {
     sai_status_t status;
     sai_fdb_entry_t saifdbent;
+    FdbKey key = MakeKey(macAddr, vlan_id);
 
+    auto it = m_FdbTable.find(key);
 
-    std::vector<FdbEntry>::const_iterator it;
-
-    for (it = m_FdbVector.begin(); it != m_FdbVector.end(); ++it)
-    {
-        if ((it->macAddr == macAddr) && (it->vlan_id == vlan_id))
-        {
-            break;
-        }
-    }
-
-    if (it == m_FdbVector.end() )
+    if (it == m_FdbTable.end() )
     {
         LOGG(TEST_DEBUG, FDB, "fdb_entry {mac %-15s vlan_id %hu} does not exist\n",
              macAddr.to_string().c_str(), vlan_id);
@@ -150,7 +182,7 @@ bool FdbMgr::Del(MacAddress macAddr,
     }
 
     memcpy(saifdbent.mac_address, macAddr.to_bytes(), sizeof(sai_mac_t));
-    saifdbent.vlan_id = it->vlan_id;
+    saifdbent.vlan_id = it->second.vlan_id;
 
     LOGG(TEST_INFO, FDB, "remove sai_fdb_entry {mac %-15s vlan_id %hu}\n",
          macAddr.to_string().c_str(), saifdbent.vlan_id);
@@ -165,7 +197,7 @@ bool FdbMgr::Del(MacAddress macAddr,
         return false;
     }
 
-    m_FdbVector.erase(it);
+    Unlink(key, it->second);
 
     return true;
 }
@@ -176,13 +208,11 @@ bool FdbMgr::EraseAll()
     sai_fdb_entry_t saifdbent;
     MacAddress macAddr;
 
-    std::vector<FdbEntry>::const_iterator it;
-
-    for (it = m_FdbVector.begin(); it != m_FdbVector.end(); it++)
+    for (auto it = m_FdbTable.begin(); it != m_FdbTable.end(); it++)
     {
-        macAddr = it->macAddr;
+        macAddr = it->second.macAddr;
         memcpy(saifdbent.mac_address, macAddr.to_bytes(), sizeof(sai_mac_t));
-        saifdbent.vlan_id = it->vlan_id;
+        saifdbent.vlan_id = it->second.vlan_id;
 
         LOGG(TEST_INFO, FDB, "remove sai_fdb_entry {mac %-15s vlan_id %hu}\n",
              macAddr.to_string().c_str(), saifdbent.vlan_id);
@@ -197,25 +227,100 @@ bool FdbMgr::EraseAll()
         }
     }
 
-    m_FdbVector.clear();
+    m_FdbTable.clear();
+    m_PortIndex.clear();
+    m_VlanIndex.clear();
     return true;
 }
 
-const FdbEntry* FdbMgr::GetFdbEntry(const MacAddress &mac, const sai_uint32_t &vlan_id) const
+/*
+ * Flush through sai_flush_fdb_entries, then drop the flushed entries of the
+ * given type from the cache. Only the entries of the matching index are visited.
+ */
+bool FdbMgr::Flush(const FdbKeySet &keys, const sai_attribute_t &match, sai_int32_t type)
 {
-    std::vector<FdbEntry>::const_iterator it;
+    sai_status_t status;
+    sai_attribute_t flushattrs[2];
+    std::vector<FdbKey> flushed;
+
+    flushattrs[0] = match;
+    flushattrs[1].id = SAI_FDB_FLUSH_ATTR_ENTRY_TYPE;
+    flushattrs[1].value.s32 = (type == SAI_FDB_ENTRY_STATIC) ?
+                              SAI_FDB_FLUSH_ENTRY_STATIC : SAI_FDB_FLUSH_ENTRY_DYNAMIC;
 
-    for (it = m_FdbVector.begin(); it != m_FdbVector.end(); ++it)
+    status = sai_fdb_api->flush_fdb_entries(2, flushattrs);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        LOGG(TEST_ERR, FDB, "fail to flush fdb entries. status=0x%x\n", -status);
+        return false;
+    }
+
+    for (auto key : keys)
     {
-        if ((it->macAddr == mac) && (it->vlan_id == vlan_id))
+        if (m_FdbTable[key].type == type)
         {
-            break;
+            flushed.push_back(key);
         }
     }
 
-    if (it != m_FdbVector.end())
+    /* keys may be the index set Unlink is erasing from, so unlink afterwards */
+    for (auto key : flushed)
+    {
+        FdbEntry fdbEntry = m_FdbTable[key];
+        Unlink(key, fdbEntry);
+    }
+
+    LOGG(TEST_INFO, FDB, "flushed %zu fdb entries\n", flushed.size());
+
+    return true;
+}
+
+bool FdbMgr::FlushByPort(sai_object_id_t port_id, sai_int32_t type)
+{
+    sai_attribute_t match;
+
+    LOGG(TEST_INFO, FDB, "flush fdb entries on port 0x%lx\n", port_id);
+
+    auto it = m_PortIndex.find(port_id);
+
+    if (it == m_PortIndex.end())
+    {
+        return true;
+    }
+
+    match.id = SAI_FDB_FLUSH_ATTR_PORT_ID;
+    match.value.oid = port_id;
+
+    return Flush(it->second, match, type);
+}
+
+bool FdbMgr::FlushByVlan(sai_uint32_t vlan_id, sai_int32_t type)
+{
+    sai_attribute_t match;
+
+    LOGG(TEST_INFO, FDB, "flush fdb entries in vlan %u\n", vlan_id);
+
+    auto it = m_VlanIndex.find(vlan_id);
+
+    if (it == m_VlanIndex.end())
+    {
+        return true;
+    }
+
+    match.id = SAI_FDB_FLUSH_ATTR_VLAN_ID;
+    match.value.u16 = (sai_vlan_id_t)vlan_id;
+
+    return Flush(it->second, match, type);
+}
+
+const FdbEntry* FdbMgr::GetFdbEntry(const MacAddress &mac, const sai_uint32_t &vlan_id) const
+{
+    auto it = m_FdbTable.find(MakeKey(mac, vlan_id));
+
+    if (it != m_FdbTable.end())
     {
-        return &(*it);
+        return &it->second;
     }
     else
     {
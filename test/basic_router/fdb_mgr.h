@@ -22,6 +22,8 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <unordered_map>
+#include <unordered_set>
 #include <saitypes.h>
 #include <saifdb.h>
 
@@ -39,9 +41,20 @@ struct FdbEntry
     sai_int32_t pkt_action;
 };
 
+/* Packed (MAC, VLAN) key: MAC in the low 48 bits, VLAN above */
+typedef uint64_t FdbKey;
+
 class FdbMgr
 {
-    std::vector<FdbEntry> m_FdbVector;
+    typedef std::unordered_set<FdbKey> FdbKeySet;
+
+    std::unordered_map<FdbKey, FdbEntry> m_FdbTable;
+    std::unordered_map<sai_object_id_t, FdbKeySet> m_PortIndex;
+    std::unordered_map<sai_uint32_t, FdbKeySet> m_VlanIndex;
+
+    static FdbKey MakeKey(const MacAddress &macAddr, sai_uint32_t vlan_id);
+    void Unlink(FdbKey key, const FdbEntry &fdbEntry);
+    bool Flush(const FdbKeySet &keys, const sai_attribute_t &match, sai_int32_t type);
 
 public:
     bool Add(MacAddress macAddr,
@@ -52,6 +65,14 @@ public:
     bool Del(MacAddress macAddr,
              sai_uint32_t vlan_id);
     bool EraseAll();
+    bool FlushByPort(sai_object_id_t port_id,
+                     sai_int32_t type = SAI_FDB_ENTRY_DYNAMIC);
+    bool FlushByVlan(sai_uint32_t vlan_id,
+                     sai_int32_t type = SAI_FDB_ENTRY_DYNAMIC);
+    size_t Size() const
+    {
+        return m_FdbTable.size();
+    }
     void Show();
 
     const FdbEntry* GetFdbEntry(const MacAddress &, const sai_uint32_t &) const;
@@ -25,24 +25,75 @@
 
 #include "ip.h"
 
+IpAddress::IpAddress(const sai_ip_address_t &addr)
+{
+    if (addr.addr_family == SAI_IP_ADDR_FAMILY_IPV4)
+    {
+        *this = IpAddress(addr.addr.ip4);
+    }
+    else
+    {
+        *this = IpAddress(addr.addr.ip6);
+    }
+}
+
 IpAddress::IpAddress(const std::string &ipstr)
 {
-    if (inet_pton(AF_INET, ipstr.c_str(), &m_addr) != 1)
+    memset(m_bytes, 0, sizeof(m_bytes));
+
+    if (inet_pton(AF_INET, ipstr.c_str(), m_bytes) == 1)
     {
-        std::string errmsg = "connot convert " + ipstr + " to ip address";
-        throw std::invalid_argument(errmsg);
+        m_family = V4;
+        return;
+    }
+
+    if (inet_pton(AF_INET6, ipstr.c_str(), m_bytes) == 1)
+    {
+        m_family = V6;
+        return;
+    }
+
+    std::string errmsg = "connot convert " + ipstr + " to ip address";
+    throw std::invalid_argument(errmsg);
+}
+
+IpAddress IpAddress::masked(int len) const
+{
+    IpAddress addr(*this);
+    int byte = len / 8;
+
+    if (byte < 16)
+    {
+        addr.m_bytes[byte] &= (uint8_t)(0xFF00 >> (len % 8));
+        memset(addr.m_bytes + byte + 1, 0, 15 - byte);
+    }
+
+    return addr;
+}
+
+void IpAddress::to_sai(sai_ip_address_t &addr) const
+{
+    if (isV4())
+    {
+        addr.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+        memcpy(&addr.addr.ip4, m_bytes, 4);
+    }
+    else
+    {
+        addr.addr_family = SAI_IP_ADDR_FAMILY_IPV6;
+        memcpy(addr.addr.ip6, m_bytes, 16);
     }
 }
 
 const std::string IpAddress::to_string() const
 {
-    char str[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, &m_addr, str, INET_ADDRSTRLEN);
+    char str[INET6_ADDRSTRLEN];
+    inet_ntop(isV4() ? AF_INET : AF_INET6, m_bytes, str, INET6_ADDRSTRLEN);
     std::string addrstr(str);
     return addrstr;
 }
 
-IpAddresses::IpAddresses(const std::string &ipListStr)
+IpAddresses::IpAddresses(const std::string &ipListStr) : m_hash(0)
 {
     size_t pos = 0;
     size_t nextpos;
@@ -54,8 +105,7 @@ IpAddresses::IpAddresses(const std::string &ipListStr)
 
         if (!ipStr.empty())
         {
-            IpAddress ip(ipStr);
-            m_addrSet.insert(ip);
+            add(IpAddress(ipStr));
         }
 
         pos = nextpos + 1;
@@ -65,15 +115,23 @@ IpAddresses::IpAddresses(const std::string &ipListStr)
 
     if (!ipStr.empty())
     {
-        IpAddress ip(ipStr);
-        m_addrSet.insert(ip);
+        add(IpAddress(ipStr));
     }
 }
 
 void IpAddresses::add(const std::string &ipstr)
 {
-    IpAddress ip(ipstr);
-    m_addrSet.insert(ip);
+    add(IpAddress(ipstr));
+}
+
+void IpAddresses::add(const IpAddress &ip)
+{
+    if (m_addrSet.insert(ip).second)
+    {
+        // mix each member before the sum so close addresses spread out
+        uint64_t h = ip.hash() * 0xFF51AFD7ED558CCDULL;
+        m_hash += (size_t)(h ^ (h >> 33));
+    }
 }
 
 const std::string IpAddresses::to_string() const
@@ -104,11 +162,7 @@ IpPrefix::IpPrefix(
     size_t pos = prefix.find('/');
     std::string ipStr = prefix.substr(0, pos);
 
-    if (ipStr.empty())
-    {
-        m_addr = 0;
-    }
-    else
+    if (!ipStr.empty())
     {
         m_addr = IpAddress(ipStr);
     }
@@ -116,27 +170,89 @@ IpPrefix::IpPrefix(
     std::string maskStr = prefix.substr(pos + 1);
     m_maskLen = std::stoi(maskStr);
 
-    if (m_maskLen < 0 || m_maskLen > 32)
+    if (m_maskLen < 0 || m_maskLen > m_addr.bitLen())
     {
         std::string errmsg = "connot convert " + ipStr + " to ip prefix";
         throw std::invalid_argument(errmsg);
     }
+}
 
-    m_mask = htonl(((uint64_t)0xFFFFFFFF << (32 - m_maskLen)) & 0xFFFFFFFF);
+IpPrefix::IpPrefix(const IpAddress &addr, int maskLen) :
+    m_addr(addr),
+    m_maskLen(maskLen)
+{
+    if (m_maskLen < 0 || m_maskLen > m_addr.bitLen())
+    {
+        std::string errmsg = "connot convert " + addr.to_string() + " to ip prefix";
+        throw std::invalid_argument(errmsg);
+    }
 }
 
-bool IpPrefix::operator<(const IpPrefix &o) const
+IpAddress IpPrefix::Mask() const
+{
+    uint8_t ones[16];
+
+    memset(ones, 0xFF, sizeof(ones));
+
+    IpAddress mask = IpAddress(ones).masked(m_maskLen);
+
+    if (m_addr.isV4())
+    {
+        uint32_t mask4;
+        memcpy(&mask4, mask.bytes(), 4);
+        return IpAddress(mask4);
+    }
+
+    return mask;
+}
+
+IpPrefixKey IpPrefix::MakeKey(const IpAddress &addr, int len)
+{
+    IpPrefixKey key;
+    IpAddress net = addr.masked(len);
+
+    memcpy(&key.hi, net.bytes(), 8);
+    memcpy(&key.lo, net.bytes() + 8, 8);
+    key.len = (uint8_t)len;
+    key.family = addr.family();
+
+    return key;
+}
+
+void IpPrefix::to_sai(sai_ip_prefix_t &prefix) const
 {
-    uint64_t addrmask = ((uint64_t)m_addr.addr()) << 32 | m_mask.addr();
-    uint64_t o_addrmask = ((uint64_t)o.m_addr.addr()) << 32 | o.m_mask.addr();
+    IpAddress mask = Mask();
+
+    if (m_addr.isV4())
+    {
+        prefix.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+        prefix.addr.ip4 = m_addr.addr();
+        prefix.mask.ip4 = mask.addr();
+    }
+    else
+    {
+        prefix.addr_family = SAI_IP_ADDR_FAMILY_IPV6;
+        memcpy(prefix.addr.ip6, m_addr.bytes(), 16);
+        memcpy(prefix.mask.ip6, mask.bytes(), 16);
+    }
+}
 
-    if (addrmask < o_addrmask)
-        return true;
+bool IpPrefix::operator<(const IpPrefix &o) const
+{
+    if (m_addr != o.m_addr)
+    {
+        return m_addr < o.m_addr;
+    }
 
-    return false;
+    return m_maskLen < o.m_maskLen;
 }
 
 const std::string IpPrefix::to_string() const
 {
-    return (m_addr.to_string() + "/" + m_mask.to_string());
+    if (m_addr.isV4())
+    {
+        return (m_addr.to_string() + "/" + Mask().to_string());
+    }
+
+    return (m_addr.to_string() + "/" + std::to_string(m_maskLen));
 }
@@ -22,62 +22,169 @@
 #pragma once
 
 #include <stdint.h>
+#include <string.h>
 #include <string>
 #include <set>
+#include <functional>
+
+extern "C"
+{
+#include <saitypes.h>
+}
+
 #include "log.h"
 
+/*
+ * IPv4 or IPv6 address. Both families are kept in one 16 byte buffer in
+ * network order, an IPv4 address uses the first 4 bytes and the rest stays
+ * zero, so compare and hash never look at the family separately.
+ */
 class IpAddress
 {
 public:
-    IpAddress() : m_addr(0) {}
-    IpAddress(uint32_t addr)
+    enum Family : uint8_t
+    {
+        V4 = 4,
+        V6 = 6,
+    };
+
+    IpAddress() : m_family(V4)
+    {
+        memset(m_bytes, 0, sizeof(m_bytes));
+    }
+
+    // addr is in network order
+    IpAddress(uint32_t addr) : m_family(V4)
+    {
+        memset(m_bytes, 0, sizeof(m_bytes));
+        memcpy(m_bytes, &addr, 4);
+    }
+
+    // addr holds 16 bytes in network order
+    IpAddress(const uint8_t *addr) : m_family(V6)
     {
-        m_addr = addr;
+        memcpy(m_bytes, addr, sizeof(m_bytes));
     }
+
+    IpAddress(const sai_ip_address_t &addr);
     IpAddress(const std::string &ipstr);
 
-    // the address is in network order
+    Family family() const
+    {
+        return m_family;
+    }
+
+    bool isV4() const
+    {
+        return m_family == V4;
+    }
+
+    // address length in bits
+    int bitLen() const
+    {
+        return isV4() ? 32 : 128;
+    }
+
+    // the IPv4 address in network order, 0 for IPv6
     uint32_t addr() const
     {
-        return m_addr;
+        uint32_t addr = 0;
+
+        if (isV4())
+        {
+            memcpy(&addr, m_bytes, 4);
+        }
+
+        return addr;
+    }
+
+    const uint8_t *bytes() const
+    {
+        return m_bytes;
+    }
+
+    // the address with only the first len bits kept
+    IpAddress masked(int len) const;
+
+    void to_sai(sai_ip_address_t &addr) const;
+
+    bool isZero() const
+    {
+        static const uint8_t zero[16] = {0};
+        return memcmp(m_bytes, zero, sizeof(m_bytes)) == 0;
     }
 
     bool operator<(const IpAddress &o) const
     {
-        return (m_addr < o.m_addr);
+        if (m_family != o.m_family)
+        {
+            return m_family < o.m_family;
+        }
+
+        return memcmp(m_bytes, o.m_bytes, sizeof(m_bytes)) < 0;
     }
 
     bool operator==(const IpAddress &o) const
     {
-        return (m_addr == o.m_addr);
+        return m_family == o.m_family && memcmp(m_bytes, o.m_bytes, sizeof(m_bytes)) == 0;
+    }
+
+    bool operator!=(const IpAddress &o) const
+    {
+        return !(*this == o);
+    }
+
+    size_t hash() const
+    {
+        uint64_t hi, lo;
+
+        memcpy(&hi, m_bytes, 8);
+        memcpy(&lo, m_bytes + 8, 8);
+
+        return std::hash<uint64_t>()(hi ^ (lo * 0x9E3779B97F4A7C15ULL) ^ m_family);
     }
 
     const std::string to_string() const;
 
 private:
-    uint32_t m_addr;
+    Family m_family;
+    uint8_t m_bytes[16];
 };
 
+struct IpAddressHash
+{
+    size_t operator()(const IpAddress &addr) const
+    {
+        return addr.hash();
+    }
+};
+
+/*
+ * Set of addresses. The hash is kept up to date on insert and does not
+ * depend on the insertion order, so equal sets hash equal and unequal sets
+ * rarely need a full compare.
+ */
 class IpAddresses
 {
 public:
-    IpAddresses() {}
+    IpAddresses() : m_hash(0) {}
 
     // ipStrList is a list IPs separated by ","
     IpAddresses(const std::string &ipstrList);
 
     void add(const std::string &ipstr);
+    void add(const IpAddress &ip);
 
     bool operator<(const IpAddresses &o) const;
 
     bool operator==(const IpAddresses &o) const
     {
-        return m_addrSet == o.m_addrSet;
+        return m_hash == o.m_hash && m_addrSet == o.m_addrSet;
     }
 
     bool operator!=(const IpAddresses &o) const
     {
-        return m_addrSet != o.m_addrSet;
+        return !(*this == o);
     }
 
     size_t size() const
@@ -85,6 +192,16 @@ public:
         return m_addrSet.size();
     }
 
+    size_t hash() const
+    {
+        return m_hash;
+    }
+
+    bool contains(const IpAddress &ip) const
+    {
+        return m_addrSet.find(ip) != m_addrSet.end();
+    }
+
     const std::string to_string() const;
 
     const std::set<IpAddress> &AddrSet() const
@@ -94,15 +211,56 @@ public:
 
 private:
     std::set<IpAddress> m_addrSet;
+    size_t m_hash;
+};
+
+struct IpAddressesHash
+{
+    size_t operator()(const IpAddresses &addrs) const
+    {
+        return addrs.hash();
+    }
+};
+
+/*
+ * Packed route key: the masked address, the prefix length and the family.
+ * Two prefixes that cover the same addresses have the same key.
+ */
+struct IpPrefixKey
+{
+    uint64_t hi;
+    uint64_t lo;
+    uint8_t len;
+    uint8_t family;
+
+    bool operator==(const IpPrefixKey &o) const
+    {
+        return hi == o.hi && lo == o.lo && len == o.len && family == o.family;
+    }
+};
+
+struct IpPrefixKeyHash
+{
+    size_t operator()(const IpPrefixKey &key) const
+    {
+        uint64_t h = key.hi * 0x9E3779B97F4A7C15ULL;
+
+        h ^= key.lo + 0x7F4A7C159E3779B9ULL + (h << 6) + (h >> 2);
+        h ^= ((uint64_t)key.family << 8) | key.len;
+
+        return std::hash<uint64_t>()(h);
+    }
 };
 
 class IpPrefix
 {
 public:
-    IpPrefix() : m_addr(0), m_mask(0), m_maskLen(0) {}
+    IpPrefix() : m_maskLen(0) {}
 
     IpPrefix(const std::string &);
 
+    IpPrefix(const IpAddress &addr, int maskLen);
+
     const std::string to_string() const;
 
     IpAddress Addr() const
@@ -110,33 +268,39 @@ public:
         return m_addr;
     }
 
-    IpAddress Mask() const
-    {
-        return m_mask;
-    }
+    IpAddress Mask() const;
 
     int MaskLen() const
     {
         return m_maskLen;
     }
 
-    uint32_t SubnetSize() const
+    bool isV4() const
     {
-        uint32_t i = 1;
+        return m_addr.isV4();
+    }
 
-        for (int j = 0; j < 32 - m_maskLen; ++j)
-        {
-            i *= 2;
-        }
+    // number of addresses in the prefix, saturates at UINT64_MAX
+    uint64_t SubnetSize() const
+    {
+        int hostBits = m_addr.bitLen() - m_maskLen;
 
-        return i;
+        return (hostBits >= 64) ? UINT64_MAX : (1ULL << hostBits);
     }
 
+    IpPrefixKey Key() const
+    {
+        return MakeKey(m_addr, m_maskLen);
+    }
+
+    // key of the prefix of length len that covers addr
+    static IpPrefixKey MakeKey(const IpAddress &addr, int len);
+
+    void to_sai(sai_ip_prefix_t &prefix) const;
+
     bool operator<(const IpPrefix &o) const;
 
 private:
     IpAddress m_addr;
-    IpAddress m_mask;
     int m_maskLen;
 };
-
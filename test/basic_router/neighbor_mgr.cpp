@@ -40,7 +40,7 @@
 extern sai_neighbor_api_t* sai_neighbor_api;
 extern sai_next_hop_api_t* sai_next_hop_api;
 
-NeighborMgr::NeighborMgr(NextHopMgr* nhMgr) : m_nhMgr(nhMgr)
+NeighborMgr::NeighborMgr(NextHopMgr* nhMgr) : m_nhMgr(nhMgr), m_listener(NULL)
 {
 }
 
@@ -87,8 +87,7 @@ bool NeighborMgr::Add(IpAddress ipAddr,
     //Write to the ASIC
     // add new neighbor
     sainb.rif_id = rif_id;
-    sainb.ip_address.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
-    sainb.ip_address.addr.ip4 = ipAddr.addr();
+    ipAddr.to_sai(sainb.ip_address);
 
     sai_attribute_t rif_attr;
     rif_attr.id = SAI_NEIGHBOR_ATTR_DST_MAC_ADDRESS;
@@ -132,6 +131,11 @@ bool NeighborMgr::Add(IpAddress ipAddr,
     nbEntry.nhid = nhid;
     m_ip2NbrMap[ipAddr] = nbEntry;
 
+    if (m_listener)
+    {
+        m_listener->OnNeighborAdd(ipAddr);
+    }
+
     return true;
 }
 
@@ -148,6 +152,12 @@ bool NeighborMgr::Del(IpAddress ipAddr)
         return true;
     }
 
+    if (m_listener && !m_listener->OnNeighborDel(ipAddr))
+    {
+        LOGG(TEST_ERR, NEIGHBOR, "fail to move the users of %s off its next hop\n", ipAddr.to_string().c_str());
+        return false;
+    }
+
     if (!m_nhMgr->Del(ipAddr))
     {
         LOGG(TEST_INFO, NEIGHBOR, "fail to remove nexthop\n");
@@ -156,8 +166,7 @@ bool NeighborMgr::Del(IpAddress ipAddr)
 
 
     sainb.rif_id = nbEntry->rif_id;
-    sainb.ip_address.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
-    sainb.ip_address.addr.ip4 = ipAddr.addr();
+    ipAddr.to_sai(sainb.ip_address);
 
     LOGG(TEST_INFO, NEIGHBOR, "sai_neighbor_api->remove_neighbor_entry ip %s rif_id 0x%lx \n",
          ipAddr.to_string().c_str(), nbEntry->rif_id);
@@ -176,11 +185,17 @@ bool NeighborMgr::Del(IpAddress ipAddr)
 
 bool NeighborMgr::EraseAll()
 {
-    std::map<IpAddress, NeighborEntry>::iterator itnb;
+    std::vector<IpAddress> ipAddrs;
+
+    // Del erases from the map, so collect the neighbors first
+    for (auto itnb = m_ip2NbrMap.begin(); itnb != m_ip2NbrMap.end(); ++itnb)
+    {
+        ipAddrs.push_back(itnb->first);
+    }
 
-    for (itnb = m_ip2NbrMap.begin(); itnb != m_ip2NbrMap.end(); ++itnb)
+    for (auto it = ipAddrs.begin(); it != ipAddrs.end(); ++it)
     {
-        if (!NeighborMgr::Del(itnb->first))
+        if (!NeighborMgr::Del(*it))
         {
             return false;
         }
@@ -32,6 +32,22 @@
 
 class NextHopMgr;
 
+/*
+ * Told about neighbor changes, so the objects resolved through a neighbor
+ * follow it without a table scan
+ */
+class NeighborListener
+{
+public:
+    virtual ~NeighborListener() {}
+
+    // the neighbor is going away, move its users off its next hop
+    virtual bool OnNeighborDel(const IpAddress &ipAddr) = 0;
+
+    // the neighbor and its next hop are usable
+    virtual void OnNeighborAdd(const IpAddress &ipAddr) = 0;
+};
+
 struct NeighborEntry
 {
     MacAddress macAddr;
@@ -44,10 +60,16 @@ class NeighborMgr
 {
     std::map<IpAddress, NeighborEntry> m_ip2NbrMap;
     NextHopMgr* m_nhMgr;
+    NeighborListener* m_listener;
 
 public:
     NeighborMgr(NextHopMgr* nhMgr);
 
+    void SetListener(NeighborListener* listener)
+    {
+        m_listener = listener;
+    }
+
     bool Add(IpAddress ipAddr,
              MacAddress macAddr,
              std::string intfAlias,
@@ -101,8 +101,7 @@ bool NextHopMgr::Add(IpAddress ipAddr,
     nhattrs[0].id = SAI_NEXT_HOP_ATTR_TYPE;
     nhattrs[0].value.u64 = SAI_NEXT_HOP_IP;
     nhattrs[1].id = SAI_NEXT_HOP_ATTR_IP;
-    nhattrs[1].value.ipaddr.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
-    nhattrs[1].value.ipaddr.addr.ip4 = ipAddr.addr();
+    ipAddr.to_sai(nhattrs[1].value.ipaddr);
     nhattrs[2].id = SAI_NEXT_HOP_ATTR_ROUTER_INTERFACE_ID;
     nhattrs[2].value.oid = rif_id;
     status = sai_next_hop_api->create_next_hop(&nhid, 3, nhattrs);
@@ -45,134 +45,442 @@ NextHopGrpMgr::NextHopGrpMgr(NeighborMgr* neighborMgr) : m_neighborMgr(neighborM
 {
 }
 
+static bool IsGroup(const NextHopGrpEntry *nhgEntry)
+{
+    return nhgEntry->nhg_id != SAI_NULL_OBJECT_ID &&
+           SAI_OID_TYPE_CHECK(nhgEntry->nhg_id, SAI_OBJECT_TYPE_NEXT_HOP_GROUP);
+}
+
 void NextHopGrpMgr::Show()
 {
-    std::map<IpAddresses, NextHopGrpEntry>::const_iterator it;
     const NextHopGrpEntry* nhgEntry;
 
     LOGG(TEST_DEBUG, NXTHG, "\t--- --- --- --- --- --- NextHopGroup Entry Table --- --- --- --- --- --- \n");
-    LOGG(TEST_DEBUG, NXTHG, "\t%-14s    %s\n", "next_hop_grp_id", "nexthops");
+    LOGG(TEST_DEBUG, NXTHG, "\t%-14s    %-6s %-7s %s\n", "next_hop_grp_id", "refs", "members", "nexthops");
 
-    for (it = m_ips2NextHGMap.begin(); it != m_ips2NextHGMap.end(); it++)
+    for (auto it = m_ips2NextHGMap.begin(); it != m_ips2NextHGMap.end(); it++)
     {
         nhgEntry = &it->second;
 
-        LOGG(TEST_DEBUG, NXTHG, "\t0x%-12lx     %s\n",
+        LOGG(TEST_DEBUG, NXTHG, "\t0x%-12lx     %-6u %-7zu %s\n",
              nhgEntry->nhg_id,
+             nhgEntry->refCount,
+             nhgEntry->members.size(),
              it->first.to_string().c_str());
     }
 
     LOGG(TEST_DEBUG, NXTHG, "\t--- --- --- --- --- --- --- --- --- --- --- --- --- --- --- --- --- ---- \n");
 }
 
-bool NextHopGrpMgr::Add(IpAddresses nextHops)
+bool NextHopGrpMgr::Resolve(const IpAddresses &nextHops, std::map<IpAddress, sai_object_id_t> &members)
+{
+    //walkthrough the nexthops
+    for (auto itnh = nextHops.AddrSet().begin(); itnh != nextHops.AddrSet().end(); itnh++)
+    {
+        const NeighborEntry *nbEntry = m_neighborMgr->GetNeighborEntry(*itnh);
+
+        if (!nbEntry)
+        {
+            LOGG(TEST_ERR, NXTHG, "fail to find the NeiborEntry for nexthop %s\n", itnh->to_string().c_str());
+            continue;
+        }
+
+        members[*itnh] = nbEntry->nhid;
+    }
+
+    return !members.empty();
+}
+
+void NextHopGrpMgr::Index(NextHopGrpEntry *nhgEntry, bool add)
+{
+    for (auto itnh = nhgEntry->nextHops.AddrSet().begin(); itnh != nhgEntry->nextHops.AddrSet().end(); itnh++)
+    {
+        if (add)
+        {
+            m_nhUsers.Link(*itnh, nhgEntry);
+        }
+        else
+        {
+            m_nhUsers.Unlink(*itnh, nhgEntry);
+        }
+    }
+}
+
+/* Members are added before the removed ones go, the group never runs empty */
+bool NextHopGrpMgr::UpdateMembers(NextHopGrpEntry *nhgEntry,
+                                  const std::vector<sai_object_id_t> &added,
+                                  const std::vector<sai_object_id_t> &removed)
+{
+    sai_status_t status;
+
+    if (!added.empty())
+    {
+        LOGG(TEST_INFO, NXTHG, "sai_next_hop_group_api->add_next_hop_to_group nhg_id 0x%lx count %zu\n",
+             nhgEntry->nhg_id, added.size());
+
+        status = sai_next_hop_group_api->add_next_hop_to_group(nhgEntry->nhg_id, added.size(), added.data());
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            LOGG(TEST_ERR, NXTHG, "fail to add next hops to nhg_id 0x%lx. status=0x%x\n", nhgEntry->nhg_id, -status);
+            return false;
+        }
+    }
+
+    if (!removed.empty())
+    {
+        LOGG(TEST_INFO, NXTHG, "sai_next_hop_group_api->remove_next_hop_from_group nhg_id 0x%lx count %zu\n",
+             nhgEntry->nhg_id, removed.size());
+
+        status = sai_next_hop_group_api->remove_next_hop_from_group(nhgEntry->nhg_id, removed.size(), removed.data());
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            LOGG(TEST_ERR, NXTHG, "fail to remove next hops from nhg_id 0x%lx. status=0x%x\n", nhgEntry->nhg_id, -status);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+NextHopGrpEntry* NextHopGrpMgr::Acquire(const IpAddresses &nextHops)
 {
     sai_status_t status;
     NextHopGrpEntry nhgEntry;
+
+    auto itnhg = m_ips2NextHGMap.find(nextHops);
+
+    if (itnhg != m_ips2NextHGMap.end())
+    {
+        itnhg->second.refCount++;
+        return &itnhg->second;
+    }
+
     nhgEntry.nextHops = nextHops;
+    nhgEntry.nhg_id = SAI_NULL_OBJECT_ID;
+    nhgEntry.resolved = true;
+    nhgEntry.refCount = 1;
 
-    std::map<IpAddresses, NextHopGrpEntry>::iterator itnhg = m_ips2NextHGMap.find(nextHops);
+    //a black hole needs neither next hop nor group
+    if (nextHops.size() == 1 && nextHops.AddrSet().begin()->isZero())
+    {
+        return &m_ips2NextHGMap.emplace(nextHops, nhgEntry).first->second;
+    }
 
-    //create Next Hop Group
-    sai_object_id_t nhg_id;
-    std::vector<sai_object_id_t> nhids;
+    //nexthops contain 0 neighbors
+    if (!Resolve(nextHops, nhgEntry.members))
+    {
+        LOGG(TEST_DEBUG, NXTHG, "cannot find the any of nexthops %s in the neighbor table\n", nextHops.to_string().c_str());
+        return NULL;
+    }
 
-    std::set<IpAddress> addrset = nextHops.AddrSet();
+    if (nhgEntry.members.size() == 1)
+    {
+        nhgEntry.nhg_id = nhgEntry.members.begin()->second;
+        NextHopGrpEntry *entry = &m_ips2NextHGMap.emplace(nextHops, nhgEntry).first->second;
+        Index(entry, true);
+        return entry;
+    }
 
+    //create Next Hop Group
+    std::vector<sai_object_id_t> nhids;
     std::vector<sai_attribute_t> nhg_attrs;
     sai_attribute_t nhg_attr;
 
-    //walkthrough the nexthops
-    for (std::set<IpAddress>::const_iterator itnh = addrset.begin(); itnh != addrset.end(); itnh++)
+    for (auto itm = nhgEntry.members.begin(); itm != nhgEntry.members.end(); itm++)
     {
-        const NeighborEntry *nbEntry = m_neighborMgr->GetNeighborEntry(*itnh);
+        nhids.push_back(itm->second);
+    }
 
-        if (!nbEntry)
-        {
-            LOGG(TEST_ERR, NXTHG, "fail to find the NeiborEntry for nexthop %s\n", itnh->to_string().c_str());
-            continue;
-        }
+    nhg_attr.id = SAI_NEXT_HOP_GROUP_ATTR_TYPE;
+    nhg_attr.value.s32 = SAI_NEXT_HOP_GROUP_ECMP;
+    nhg_attrs.push_back(nhg_attr);
+
+    nhg_attr.id = SAI_NEXT_HOP_GROUP_ATTR_NEXT_HOP_LIST;
+    nhg_attr.value.objlist.count = nhids.size();
+    nhg_attr.value.objlist.list = nhids.data();
+    nhg_attrs.push_back(nhg_attr);
 
-        nhg_id = nbEntry->nhid;
-        nhids.push_back(nbEntry->nhid);
+    LOGG(TEST_INFO, NXTHG, "sai_next_hop_group_api->create_next_hop_group %s\n",  nextHops.to_string().c_str());
+    status = sai_next_hop_group_api->create_next_hop_group(&nhgEntry.nhg_id, nhg_attrs.size(), nhg_attrs.data());
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        LOGG(TEST_ERR, NXTHG, "fail to create ECMP group for %s. status=0x%x\n", nextHops.to_string().c_str(), -status);
+        return NULL;
     }
 
-    //nexthops contain 0 neighbors
-    if (nhids.size() == 0)
+    if (!SAI_OID_TYPE_CHECK(nhgEntry.nhg_id, SAI_OBJECT_TYPE_NEXT_HOP_GROUP))
     {
-        LOGG(TEST_DEBUG, NXTHG, "cannot find the any of nexthops %s in the neighbor table\n", nextHops.to_string().c_str());
-        return false;
+        LOGG(TEST_ERR, NXTHG, "next hop group oid generated is not the right type\n");
+        return NULL;
     }
 
-    if (nhids.size() > 1)
+    LOGG(TEST_DEBUG, NXTHG, "create ECMP groupnexthops %s nhg_id 0x%lx\n",
+         nextHops.to_string().c_str(), nhgEntry.nhg_id);
+
+    //insert this entry to the internal data structure
+    NextHopGrpEntry *entry = &m_ips2NextHGMap.emplace(nextHops, nhgEntry).first->second;
+    Index(entry, true);
+
+    return entry;
+}
+
+bool NextHopGrpMgr::Release(NextHopGrpEntry *nhgEntry)
+{
+    sai_status_t status;
+
+    if (--nhgEntry->refCount > 0)
     {
-        nhg_attr.id = SAI_NEXT_HOP_GROUP_ATTR_TYPE;
-        nhg_attr.value.s32 = SAI_NEXT_HOP_GROUP_ECMP;
-        nhg_attrs.push_back(nhg_attr);
+        return true;
+    }
 
-        nhg_attr.id = SAI_NEXT_HOP_GROUP_ATTR_NEXT_HOP_LIST;
-        nhg_attr.value.objlist.count = nhids.size();
-        nhg_attr.value.objlist.list = nhids.data();
-        nhg_attrs.push_back(nhg_attr);
+    if (IsGroup(nhgEntry))
+    {
+        LOGG(TEST_INFO, NXTHG, "sai_next_hop_group_api->sai_remove_next_hop_group nhg_id 0x%lx \n", nhgEntry->nhg_id);
 
-        LOGG(TEST_INFO, NXTHG, "sai_next_hop_group_api->create_next_hop_group %s\n",  nextHops.to_string().c_str());
-        status = sai_next_hop_group_api->create_next_hop_group(&nhg_id, nhg_attrs.size(), nhg_attrs.data());
+        status = sai_next_hop_group_api->remove_next_hop_group(nhgEntry->nhg_id);
 
         if (status != SAI_STATUS_SUCCESS)
         {
-            LOGG(TEST_ERR, NXTHG, "fail to create ECMP group for %s. status=0x%x\n", nextHops.to_string().c_str(), -status);
+            LOGG(TEST_ERR, ROUTE, "failed to remove nhg_id 0x%lx rc=0x%x\n", nhgEntry->nhg_id, -status);
+            nhgEntry->refCount++;
             return false;
         }
+    }
+
+    Index(nhgEntry, false);
+    m_ips2NextHGMap.erase(nhgEntry->nextHops);
+
+    return true;
+}
+
+NextHopGrpEntry* NextHopGrpMgr::Modify(NextHopGrpEntry *nhgEntry, const IpAddresses &nextHops)
+{
+    std::map<IpAddress, sai_object_id_t> members;
+    std::vector<sai_object_id_t> added;
+    std::vector<sai_object_id_t> removed;
+
+    if (nhgEntry->refCount != 1 || !IsGroup(nhgEntry) || !nhgEntry->resolved || nextHops.size() < 2 ||
+            m_ips2NextHGMap.find(nextHops) != m_ips2NextHGMap.end())
+    {
+        return NULL;
+    }
+
+    if (!Resolve(nextHops, members) || members.size() < 2)
+    {
+        return NULL;
+    }
+
+    for (auto itm = members.begin(); itm != members.end(); itm++)
+    {
+        if (nhgEntry->members.find(itm->first) == nhgEntry->members.end())
+        {
+            added.push_back(itm->second);
+        }
+    }
 
-        if (!SAI_OID_TYPE_CHECK(nhg_id, SAI_OBJECT_TYPE_NEXT_HOP_GROUP))
+    for (auto itm = nhgEntry->members.begin(); itm != nhgEntry->members.end(); itm++)
+    {
+        if (members.find(itm->first) == members.end())
         {
-            LOGG(TEST_ERR, NXTHG, "next hop group oid generated is not the right type\n");
-            return false;
+            removed.push_back(itm->second);
         }
+    }
 
-        nhgEntry.nhg_id = nhg_id;
+    //a new group is cheaper once most of the members change
+    if (added.size() + removed.size() >= members.size())
+    {
+        return NULL;
+    }
 
-        LOGG(TEST_DEBUG, NXTHG, "create ECMP groupnexthops %s nhg_id 0x%lx\n",
-             nextHops.to_string().c_str(), nhg_id);
+    if (!UpdateMembers(nhgEntry, added, removed))
+    {
+        return NULL;
     }
 
-    //insert this entry to the internal data structure
-    m_ips2NextHGMap[nextHops] = nhgEntry;
-    return true;
+    LOGG(TEST_DEBUG, NXTHG, "nhg_id 0x%lx nexthops %s -> %s in place\n",
+         nhgEntry->nhg_id, nhgEntry->nextHops.to_string().c_str(), nextHops.to_string().c_str());
+
+    NextHopGrpEntry modified = *nhgEntry;
+    modified.nextHops = nextHops;
+    modified.members = members;
+
+    Index(nhgEntry, false);
+    m_ips2NextHGMap.erase(nhgEntry->nextHops);
+
+    NextHopGrpEntry *entry = &m_ips2NextHGMap.emplace(nextHops, modified).first->second;
+    Index(entry, true);
+
+    return entry;
 }
 
-bool NextHopGrpMgr::Del(IpAddresses nextHops)
+/*
+ * A group drops a next hop in place while it has others. The last next hop
+ * of a set stays until DropStale, the routes using the set are moved off it
+ * first, and the set is unresolved until one of its next hops is back.
+ */
+bool NextHopGrpMgr::SetMemberState(const IpAddress &nextHop, bool up,
+                                   std::vector<NextHopGrpEntry*> *changed)
 {
-    sai_object_id_t nhg_id;
-    sai_status_t status;
+    sai_object_id_t nhid = SAI_NULL_OBJECT_ID;
+    std::vector<sai_object_id_t> added;
+    std::vector<sai_object_id_t> removed;
 
-    const NextHopGrpEntry *nhgEntry = NextHopGrpMgr::GetNextHopGrpEntry(nextHops);
+    const DepIndex<IpAddress, NextHopGrpEntry*, IpAddressHash>::Users *users = m_nhUsers.Find(nextHop);
 
-    if (!nhgEntry)
+    if (!users)
     {
-        return false;
+        return true;
     }
 
-    nhg_id = nhgEntry->nhg_id;
+    if (up)
+    {
+        const NeighborEntry *nbEntry = m_neighborMgr->GetNeighborEntry(nextHop);
 
-    LOGG(TEST_INFO, NXTHG, "sai_next_hop_group_api->sai_remove_next_hop_group nhg_id 0x%lx \n", nhg_id);
+        if (!nbEntry)
+        {
+            LOGG(TEST_ERR, NXTHG, "fail to find the NeiborEntry for nexthop %s\n", nextHop.to_string().c_str());
+            return false;
+        }
 
-    status = sai_next_hop_group_api->remove_next_hop_group(nhg_id);
+        nhid = nbEntry->nhid;
+    }
 
-    if (status != SAI_STATUS_SUCCESS)
+    for (NextHopGrpEntry *nhgEntry : *users)
     {
-        LOGG(TEST_ERR, ROUTE, "failed to remove nhg_id 0x%lx rc=0x%x\n", nhg_id, -status);
-        return false;
+        auto itm = nhgEntry->members.find(nextHop);
+
+        added.clear();
+        removed.clear();
+
+        if (!up)
+        {
+            if (itm == nhgEntry->members.end() || !nhgEntry->resolved)
+            {
+                continue;
+            }
+
+            if (nhgEntry->members.size() == 1)
+            {
+                nhgEntry->resolved = false;
+
+                if (changed)
+                {
+                    changed->push_back(nhgEntry);
+                }
+
+                continue;
+            }
+
+            removed.push_back(itm->second);
+
+            if (!UpdateMembers(nhgEntry, added, removed))
+            {
+                return false;
+            }
+
+            nhgEntry->members.erase(itm);
+            continue;
+        }
+
+        if (nhgEntry->resolved && itm != nhgEntry->members.end())
+        {
+            continue;
+        }
+
+        if (!IsGroup(nhgEntry))
+        {
+            nhgEntry->nhg_id = nhid;
+        }
+        else
+        {
+            added.push_back(nhid);
+
+            if (!UpdateMembers(nhgEntry, added, removed))
+            {
+                return false;
+            }
+        }
+
+        if (!nhgEntry->resolved)
+        {
+            nhgEntry->resolved = true;
+
+            if (changed)
+            {
+                changed->push_back(nhgEntry);
+            }
+        }
+
+        nhgEntry->members[nextHop] = nhid;
     }
 
-    m_ips2NextHGMap.erase(nextHops);
+    return true;
+}
+
+/*
+ * An unresolved group gives up its last member and runs empty, a single
+ * next hop set its next hop id, so the next hop can be removed.
+ */
+bool NextHopGrpMgr::DropStale(const std::vector<NextHopGrpEntry*> &changed)
+{
+    std::vector<sai_object_id_t> added;
+    std::vector<sai_object_id_t> removed;
+
+    for (NextHopGrpEntry *nhgEntry : changed)
+    {
+        if (nhgEntry->resolved || nhgEntry->members.empty())
+        {
+            continue;
+        }
+
+        if (IsGroup(nhgEntry))
+        {
+            removed.clear();
+
+            for (auto itm = nhgEntry->members.begin(); itm != nhgEntry->members.end(); itm++)
+            {
+                removed.push_back(itm->second);
+            }
+
+            if (!UpdateMembers(nhgEntry, added, removed))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            nhgEntry->nhg_id = SAI_NULL_OBJECT_ID;
+        }
+
+        nhgEntry->members.clear();
+    }
 
     return true;
 }
 
+bool NextHopGrpMgr::Add(IpAddresses nextHops)
+{
+    return Acquire(nextHops) != NULL;
+}
+
+bool NextHopGrpMgr::Del(IpAddresses nextHops)
+{
+    auto it = m_ips2NextHGMap.find(nextHops);
+
+    if (it == m_ips2NextHGMap.end())
+    {
+        return false;
+    }
+
+    return Release(&it->second);
+}
+
 const NextHopGrpEntry* NextHopGrpMgr::GetNextHopGrpEntry(const IpAddresses &ips) const
 {
-    std::map<IpAddresses, NextHopGrpEntry>::const_iterator it = m_ips2NextHGMap.find(ips);
+    auto it = m_ips2NextHGMap.find(ips);
 
     if (it != m_ips2NextHGMap.end())
     {
@@ -183,4 +491,3 @@ const NextHopGrpEntry* NextHopGrpMgr::GetNextHopGrpEntry(const IpAddresses &ips)
         return NULL;
     }
 }
-
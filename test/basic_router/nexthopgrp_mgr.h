@@ -24,6 +24,8 @@
 #include <set>
 #include <map>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 extern "C"
 {
@@ -34,13 +36,24 @@ extern "C"
 #include "ip.h"
 #include "mac.h"
 #include "basic_router.h"
+#include "dep_graph.h"
 
 class NeighborMgr;
 
+/*
+ * One interned next hop set. Routes hold a pointer to the entry as the
+ * handle of their next hops and every holder counts in refCount.
+ */
 struct NextHopGrpEntry
 {
     IpAddresses nextHops;
+    // next hop group id, the next hop id of a single next hop, 0 for a black hole
     sai_object_id_t nhg_id;
+    // next hops in use, for a group the members of the SAI group
+    std::map<IpAddress, sai_object_id_t> members;
+    // false once every next hop is gone, no member is left after DropStale
+    bool resolved;
+    uint32_t refCount;
 };
 
 class NextHopGrpMgr
@@ -48,15 +61,43 @@ class NextHopGrpMgr
 
     NeighborMgr* m_neighborMgr;
 
-    std::map<IpAddresses, NextHopGrpEntry> m_ips2NextHGMap;
+    std::unordered_map<IpAddresses, NextHopGrpEntry, IpAddressesHash> m_ips2NextHGMap;
+
+    // next hop sets each next hop is configured in
+    DepIndex<IpAddress, NextHopGrpEntry*, IpAddressHash> m_nhUsers;
+
+    bool Resolve(const IpAddresses &nextHops, std::map<IpAddress, sai_object_id_t> &members);
+    void Index(NextHopGrpEntry *nhgEntry, bool add);
+    bool UpdateMembers(NextHopGrpEntry *nhgEntry,
+                       const std::vector<sai_object_id_t> &added,
+                       const std::vector<sai_object_id_t> &removed);
 
 public:
     NextHopGrpMgr(NeighborMgr* neighborMgr);
 
+    // take a reference on the set, creating its group on first use
+    NextHopGrpEntry* Acquire(const IpAddresses &nextHops);
+    // drop a reference, the group is removed with the last one
+    bool Release(NextHopGrpEntry *nhgEntry);
+    // move a group held by a single reference to another set by adding and
+    // removing members, returns the new handle or NULL when a new group is needed
+    NextHopGrpEntry* Modify(NextHopGrpEntry *nhgEntry, const IpAddresses &nextHops);
+    // take a next hop out of, or back into, every set configured with it.
+    // Sets that lost their last next hop or resolved again go to changed.
+    bool SetMemberState(const IpAddress &nextHop, bool up,
+                        std::vector<NextHopGrpEntry*> *changed = NULL);
+    // let go of the last next hop of sets that lost it, once no route
+    // forwards through them any more
+    bool DropStale(const std::vector<NextHopGrpEntry*> &changed);
+
     bool Add(IpAddresses nextHops);
     bool Del(IpAddresses nextHops);
     void Show();
 
+    size_t Size() const
+    {
+        return m_ips2NextHGMap.size();
+    }
+
     const NextHopGrpEntry* GetNextHopGrpEntry(const IpAddresses &) const;
 };
-
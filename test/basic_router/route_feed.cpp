@@ -0,0 +1,495 @@
+/*
+ * Copyright (c) 2015 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc
+ *
+ *
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#include "route_feed.h"
+#include "route_mgr.h"
+
+/* Bytes the reader hands to a parser at once */
+#define ROUTE_FEED_BLOCK_SIZE   (256 * 1024)
+
+/* Blocks in flight per parser, in each direction */
+#define ROUTE_FEED_RING_SIZE    4
+
+struct RouteFeed::Block
+{
+    std::string data;
+    bool binary;
+    std::vector<RouteUpdate> updates;
+    uint64_t records;
+    uint64_t errors;
+};
+
+typedef SpscRing<RouteFeed::Block*> BlockRing;
+
+template <typename T>
+static void PushWait(SpscRing<T> &ring, const T &item)
+{
+    while (!ring.Push(item))
+    {
+        std::this_thread::yield();
+    }
+}
+
+template <typename T>
+static void PopWait(SpscRing<T> &ring, T &item)
+{
+    while (!ring.Pop(item))
+    {
+        std::this_thread::yield();
+    }
+}
+
+RouteFeed::RouteFeed(RouteMgr* routeMgr, unsigned int workers, size_t batchSize) :
+    m_routeMgr(routeMgr),
+    m_workers(workers),
+    m_batchSize(batchSize)
+{
+    if (m_workers == 0)
+    {
+        m_workers = std::thread::hardware_concurrency();
+    }
+
+    if (m_workers == 0)
+    {
+        m_workers = 1;
+    }
+
+    if (m_batchSize == 0)
+    {
+        m_batchSize = 1;
+    }
+
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+/*
+ * Length of the binary record at data, 0 when it is not complete yet and
+ * SIZE_MAX when the header is not valid.
+ */
+size_t RouteFeed::BinaryRecordLen(const uint8_t *data, size_t len)
+{
+    size_t addrLen;
+    size_t recLen;
+
+    if (len < 3)
+    {
+        return 0;
+    }
+
+    addrLen = (data[1] == 4) ? 4 : (data[1] == 6) ? 16 : 0;
+
+    if (addrLen == 0 || data[2] > addrLen * 8 ||
+            (data[0] != ROUTE_FEED_ANNOUNCE && data[0] != ROUTE_FEED_WITHDRAW))
+    {
+        return SIZE_MAX;
+    }
+
+    recLen = 3 + (data[2] + 7) / 8;
+
+    if (len < recLen + 1)
+    {
+        return 0;
+    }
+
+    recLen += 1 + data[recLen] * addrLen;
+
+    return (len < recLen) ? 0 : recLen;
+}
+
+void RouteFeed::ParseText(Block *block)
+{
+    const char *pos = block->data.data();
+    const char *end = pos + block->data.size();
+
+    while (pos < end)
+    {
+        const char *eol = (const char*)memchr(pos, '\n', end - pos);
+        const char *next = eol ? eol + 1 : end;
+
+        if (!eol)
+        {
+            eol = end;
+        }
+
+        while (pos < eol && (*pos == ' ' || *pos == '\t'))
+        {
+            pos++;
+        }
+
+        while (eol > pos && (eol[-1] == '\r' || eol[-1] == ' ' || eol[-1] == '\t'))
+        {
+            eol--;
+        }
+
+        if (pos == eol || *pos == '#')
+        {
+            pos = next;
+            continue;
+        }
+
+        RouteUpdate update;
+        std::string line(pos, eol);
+        size_t sep = line.find_first_of(" \t");
+
+        block->records++;
+        update.withdraw = (line[0] == '-');
+
+        try
+        {
+            std::string prefixStr = line.substr(update.withdraw ? 1 : 0, sep - (update.withdraw ? 1 : 0));
+
+            if (prefixStr.find('/') == std::string::npos)
+            {
+                throw std::invalid_argument(prefixStr);
+            }
+
+            update.prefix = IpPrefix(prefixStr);
+
+            if (!update.withdraw)
+            {
+                if (sep == std::string::npos)
+                {
+                    throw std::invalid_argument(line);
+                }
+
+                update.nexthops = IpAddresses(line.substr(line.find_first_not_of(" \t", sep)));
+
+                if (update.nexthops.size() == 0)
+                {
+                    throw std::invalid_argument(line);
+                }
+            }
+
+            block->updates.push_back(update);
+        }
+        catch (const std::exception &)
+        {
+            LOGG(TEST_DEBUG, ROUTEFEED, "cannot parse route update \"%s\"\n", line.c_str());
+            block->errors++;
+        }
+
+        pos = next;
+    }
+}
+
+void RouteFeed::ParseBinary(Block *block)
+{
+    const uint8_t *data = (const uint8_t*)block->data.data();
+    size_t len = block->data.size();
+    size_t pos = 0;
+
+    while (pos < len)
+    {
+        size_t recLen = BinaryRecordLen(data + pos, len - pos);
+
+        block->records++;
+
+        if (recLen == 0 || recLen == SIZE_MAX)
+        {
+            LOGG(TEST_DEBUG, ROUTEFEED, "bad or truncated route record at offset %zu of a block\n", pos);
+            block->errors++;
+            return;
+        }
+
+        const uint8_t *rec = data + pos;
+        bool v4 = (rec[1] == 4);
+        size_t addrLen = v4 ? 4 : 16;
+        size_t prefixBytes = (rec[2] + 7) / 8;
+        const uint8_t *nh = rec + 4 + prefixBytes;
+        uint8_t bytes[16] = {0};
+        uint32_t addr4;
+        RouteUpdate update;
+
+        memcpy(bytes, rec + 3, prefixBytes);
+        memcpy(&addr4, bytes, 4);
+        update.withdraw = (rec[0] == ROUTE_FEED_WITHDRAW);
+        update.prefix = IpPrefix(v4 ? IpAddress(addr4) : IpAddress(bytes), rec[2]);
+
+        for (uint8_t i = 0; !update.withdraw && i < rec[3 + prefixBytes]; i++, nh += addrLen)
+        {
+            memcpy(bytes, nh, addrLen);
+            memcpy(&addr4, bytes, 4);
+            update.nexthops.add(v4 ? IpAddress(addr4) : IpAddress(bytes));
+        }
+
+        if (update.withdraw || update.nexthops.size() > 0)
+        {
+            block->updates.push_back(update);
+        }
+        else
+        {
+            block->errors++;
+        }
+
+        pos += recLen;
+    }
+}
+
+bool RouteFeed::Program(std::vector<RouteUpdate> &batch, sai_object_id_t vr_id)
+{
+    for (auto it = batch.begin(); it != batch.end(); ++it)
+    {
+        bool ok = it->withdraw ? m_routeMgr->Del(it->prefix, vr_id) :
+                  m_routeMgr->Add(it->prefix, it->nexthops, vr_id);
+
+        if (ok)
+        {
+            m_stats.programmed++;
+        }
+        else
+        {
+            m_stats.failed++;
+        }
+    }
+
+    batch.clear();
+    return true;
+}
+
+bool RouteFeed::Run(const std::string &path, sai_object_id_t vr_id)
+{
+    if (path == "-")
+    {
+        return Run(STDIN_FILENO, vr_id);
+    }
+
+    int fd = open(path.c_str(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        LOGG(TEST_ERR, ROUTEFEED, "cannot open route feed %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    bool ok = Run(fd, vr_id);
+
+    close(fd);
+    return ok;
+}
+
+bool RouteFeed::Run(int fd, sai_object_id_t vr_id)
+{
+    std::vector<std::unique_ptr<BlockRing>> inRings;
+    std::vector<std::unique_ptr<BlockRing>> outRings;
+    std::vector<std::thread> threads;
+    std::atomic<bool> readError(false);
+    unsigned int i;
+
+    memset(&m_stats, 0, sizeof(m_stats));
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (i = 0; i < m_workers; i++)
+    {
+        inRings.emplace_back(new BlockRing(ROUTE_FEED_RING_SIZE));
+        outRings.emplace_back(new BlockRing(ROUTE_FEED_RING_SIZE));
+    }
+
+    // parsers, block n goes to parser n % m_workers and back on its out ring
+    for (i = 0; i < m_workers; i++)
+    {
+        threads.emplace_back([&inRings, &outRings, i]()
+        {
+            Block *block;
+
+            do
+            {
+                PopWait(*inRings[i], block);
+
+                if (block)
+                {
+                    block->binary ? ParseBinary(block) : ParseText(block);
+                }
+
+                PushWait(*outRings[i], block);
+            }
+            while (block);
+        });
+    }
+
+    // reader, cuts the input after the last whole update
+    threads.emplace_back([this, fd, &inRings, &readError]()
+    {
+        std::vector<char> buf(ROUTE_FEED_BLOCK_SIZE);
+        std::string carry;
+        const size_t magicLen = strlen(ROUTE_FEED_MAGIC);
+        bool binary = false;
+        bool detected = false;
+        bool eof = false;
+        uint64_t seq = 0;
+
+        while (!eof)
+        {
+            ssize_t n = read(fd, buf.data(), buf.size());
+
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (n < 0)
+            {
+                LOGG(TEST_ERR, ROUTEFEED, "route feed read failed: %s\n", strerror(errno));
+                readError = true;
+                break;
+            }
+
+            eof = (n == 0);
+            carry.append(buf.data(), n);
+
+            if (!detected)
+            {
+                if (!eof && carry.size() < magicLen)
+                {
+                    continue;
+                }
+
+                binary = (carry.compare(0, magicLen, ROUTE_FEED_MAGIC) == 0);
+                detected = true;
+
+                if (binary)
+                {
+                    carry.erase(0, magicLen);
+                }
+            }
+
+            size_t cut = carry.size();
+
+            if (!eof && binary)
+            {
+                const uint8_t *data = (const uint8_t*)carry.data();
+                size_t recLen;
+
+                for (cut = 0; cut < carry.size(); cut += recLen)
+                {
+                    recLen = BinaryRecordLen(data + cut, carry.size() - cut);
+
+                    if (recLen == SIZE_MAX)
+                    {
+                        // no way to resync, let the parser count the bad record
+                        LOGG(TEST_ERR, ROUTEFEED, "bad binary route record, stop reading\n");
+                        readError = true;
+                        cut = carry.size();
+                        eof = true;
+                        break;
+                    }
+
+                    if (recLen == 0)
+                    {
+                        break;
+                    }
+                }
+            }
+            else if (!eof)
+            {
+                size_t eol = carry.rfind('\n');
+                cut = (eol == std::string::npos) ? 0 : eol + 1;
+            }
+
+            if (cut == 0)
+            {
+                continue;
+            }
+
+            Block *block = new Block();
+            block->binary = binary;
+            block->records = 0;
+            block->errors = 0;
+            block->data = carry.substr(0, cut);
+            carry.erase(0, cut);
+
+            PushWait(*inRings[seq++ % m_workers], block);
+        }
+
+        for (unsigned int w = 0; w < m_workers; w++)
+        {
+            PushWait(*inRings[w], (Block*)NULL);
+        }
+    });
+
+    // take the blocks back in input order and coalesce per prefix
+    std::vector<RouteUpdate> batch;
+    std::unordered_map<IpPrefixKey, size_t, IpPrefixKeyHash> pending;
+
+    for (uint64_t seq = 0;; seq++)
+    {
+        Block *block;
+
+        PopWait(*outRings[seq % m_workers], block);
+
+        if (!block)
+        {
+            break;
+        }
+
+        m_stats.records += block->records;
+        m_stats.errors += block->errors;
+
+        for (auto it = block->updates.begin(); it != block->updates.end(); ++it)
+        {
+            auto res = pending.emplace(it->prefix.Key(), batch.size());
+
+            if (res.second)
+            {
+                batch.push_back(*it);
+            }
+            else
+            {
+                batch[res.first->second] = *it;
+                m_stats.coalesced++;
+            }
+
+            if (batch.size() >= m_batchSize)
+            {
+                Program(batch, vr_id);
+                pending.clear();
+            }
+        }
+
+        delete block;
+    }
+
+    Program(batch, vr_id);
+
+    for (auto it = threads.begin(); it != threads.end(); ++it)
+    {
+        it->join();
+    }
+
+    m_stats.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    LOGG(TEST_NOTICE, ROUTEFEED, "%lu updates, %lu coalesced, %lu programmed, %lu failed, %lu bad in %.0f ms\n",
+         m_stats.records, m_stats.coalesced, m_stats.programmed, m_stats.failed, m_stats.errors,
+         m_stats.elapsed_ms);
+
+    return !readError;
+}
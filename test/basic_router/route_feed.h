@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2015 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc
+ *
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+extern "C"
+{
+#include <saitypes.h>
+}
+
+#include "log.h"
+#include "ip.h"
+
+class RouteMgr;
+
+/* Magic line a binary feed starts with */
+#define ROUTE_FEED_MAGIC        "RFEED1\n"
+
+/* Binary record types */
+#define ROUTE_FEED_ANNOUNCE     1
+#define ROUTE_FEED_WITHDRAW     2
+
+struct RouteUpdate
+{
+    IpPrefix prefix;
+    IpAddresses nexthops;
+    bool withdraw;
+};
+
+struct RouteFeedStats
+{
+    uint64_t records;       // updates read from the feed
+    uint64_t errors;        // updates that did not parse
+    uint64_t coalesced;     // updates replaced by a later one of the same batch
+    uint64_t programmed;    // updates RouteMgr took
+    uint64_t failed;        // updates RouteMgr refused
+    double elapsed_ms;      // feed start to last update programmed
+};
+
+/*
+ * Single producer single consumer ring. The producer only writes m_tail,
+ * the consumer only writes m_head.
+ */
+template <typename T>
+class SpscRing
+{
+    std::vector<T> m_slots;
+    size_t m_mask;
+    std::atomic<size_t> m_head;
+    std::atomic<size_t> m_tail;
+
+public:
+    // size is rounded up to a power of two
+    SpscRing(size_t size) : m_head(0), m_tail(0)
+    {
+        size_t capacity = 1;
+
+        while (capacity < size)
+        {
+            capacity <<= 1;
+        }
+
+        m_slots.resize(capacity);
+        m_mask = capacity - 1;
+    }
+
+    bool Push(const T &item)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+
+        if (tail - m_head.load(std::memory_order_acquire) > m_mask)
+        {
+            return false;
+        }
+
+        m_slots[tail & m_mask] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T &item)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+
+        if (head == m_tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        item = m_slots[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+/*
+ * Streams route updates from a file or a pipe into RouteMgr.
+ *
+ * Text feed, one update per line:
+ *     <prefix> <nexthop>[,<nexthop>...]    add or replace a route
+ *     -<prefix>                            withdraw a route
+ *     # comment
+ *
+ * Binary feed, ROUTE_FEED_MAGIC followed by records of
+ *     u8 type, u8 family (4 or 6), u8 prefix length,
+ *     prefix (length rounded up to whole bytes),
+ *     u8 next hop count, next hops (4 or 16 bytes each)
+ *
+ * A reader thread cuts the input into blocks of whole updates, parser threads
+ * turn the blocks into updates and the calling thread takes the blocks back
+ * in input order. Updates are coalesced per prefix, the last one wins, and
+ * programmed through RouteMgr one batch at a time.
+ */
+class RouteFeed
+{
+public:
+    // updates handed from the reader to a parser and back
+    struct Block;
+
+private:
+    RouteMgr* m_routeMgr;
+    unsigned int m_workers;
+    size_t m_batchSize;
+    RouteFeedStats m_stats;
+
+    static size_t BinaryRecordLen(const uint8_t *data, size_t len);
+    static void ParseText(Block *block);
+    static void ParseBinary(Block *block);
+
+    bool Program(std::vector<RouteUpdate> &batch, sai_object_id_t vr_id);
+
+public:
+    // workers 0 uses one parser thread per core
+    RouteFeed(RouteMgr* routeMgr, unsigned int workers = 0, size_t batchSize = 4096);
+
+    // path "-" reads stdin
+    bool Run(const std::string &path, sai_object_id_t vr_id = SAI_NULL_OBJECT_ID);
+    bool Run(int fd, sai_object_id_t vr_id = SAI_NULL_OBJECT_ID);
+
+    const RouteFeedStats &Stats() const
+    {
+        return m_stats;
+    }
+};
@@ -27,6 +27,7 @@ extern "C"
 #include "sai.h"
 }
 
+#include <algorithm>
 #include <vector>
 #include <arpa/inet.h>
 
@@ -42,175 +43,329 @@ extern sai_route_api_t* sai_route_api;
 
 extern sai_object_id_t g_vr_id;
 
-RouteMgr::RouteMgr(NeighborMgr* neighborMgr, NextHopGrpMgr* nhgMgr)
+RouteEntry* RouteTable::Find(const IpPrefix &prefix)
 {
-    m_neighborMgr = neighborMgr;
-    m_nhgMgr = nhgMgr;
-    // setup black hole
-    IpAddresses ipaddrs("0.0.0.0");
-    m_EcmpGroups[ipaddrs] = 0;
-}
+    FamilyTable &table = Table(prefix.isV4());
+    auto it = table.routes.find(prefix.Key());
 
+    return (it == table.routes.end()) ? NULL : &it->second;
+}
 
-void RouteMgr::Show()
+RouteEntry* RouteTable::Insert(const IpPrefix &prefix, const IpAddresses &nexthops)
 {
-    LOGG(TEST_DEBUG, ROUTE, "\t--- --- --- --- --- --- Routes Synced --- --- --- --- --- --- ---\n");
-    LOGG(TEST_DEBUG, ROUTE, "\t%-40s | %s\n", "route", "nexthops");
+    FamilyTable &table = Table(prefix.isV4());
+    auto res = table.routes.emplace(prefix.Key(), RouteEntry());
+    RouteEntry *entry = &res.first->second;
+
+    entry->prefix = prefix;
+    entry->nexthops = nexthops;
 
-    for (RouteTable::const_iterator it = m_Routes.begin(); it != m_Routes.end(); it++)
+    if (res.second && table.lenCount[prefix.MaskLen()]++ == 0)
     {
-        IpPrefix prefix = it->first;
-        LOGG(TEST_DEBUG, ROUTE, "\t%-40s | %s\n",
-             prefix.to_string().c_str(),
-             it->second.to_string().c_str());
+        table.lens.insert(std::upper_bound(table.lens.begin(), table.lens.end(),
+                                           prefix.MaskLen(), std::greater<int>()),
+                          prefix.MaskLen());
     }
 
-    LOGG(TEST_DEBUG, ROUTE, "\t--- --- --- --- --- --- --- --- --- --- --- --- --- --- --- --- -\n");
+    return entry;
 }
 
-void RouteMgr::ShowECMP()
+void RouteTable::Erase(const IpPrefix &prefix)
 {
-    LOGG(TEST_DEBUG, ROUTE, "\t--- --- --- --- --- --- ECMP Group Table --- --- --- --- --- --- \n");
-    LOGG(TEST_DEBUG, ROUTE, "\t%-40s | %s\n", "nexthops", "next_hop_group_id");
-    std::map<IpAddresses, sai_object_id_t>::iterator itnhg;
+    FamilyTable &table = Table(prefix.isV4());
 
-    for (itnhg = m_EcmpGroups.begin(); itnhg != m_EcmpGroups.end(); itnhg++)
+    if (table.routes.erase(prefix.Key()) == 0)
     {
-        IpAddresses nexthops = itnhg->first;
-        LOGG(TEST_DEBUG, ROUTE, "\t%-40s | 0x%lx\n",
-             nexthops.to_string().c_str(),
-             itnhg->second);
+        return;
     }
 
-    LOGG(TEST_DEBUG, ROUTE, "\t--- --- --- --- --- --- --- --- --- --- --- --- --- --- --- --- -\n");
+    if (--table.lenCount[prefix.MaskLen()] == 0)
+    {
+        table.lens.erase(std::find(table.lens.begin(), table.lens.end(), prefix.MaskLen()));
+    }
 }
 
-bool RouteMgr::Add(IpPrefix prefix, IpAddresses nexthops)
+const RouteEntry* RouteTable::Lookup(const IpAddress &addr) const
 {
-    sai_status_t status;
-    sai_object_id_t nhg_id;
-    std::vector<sai_object_id_t> nhids;
-
-    std::set<IpAddress> addrset = nexthops.AddrSet();
+    const FamilyTable &table = Table(addr.isV4());
 
-    std::vector<sai_attribute_t> nhg_attrs;
-    std::map<IpAddresses, sai_object_id_t>::iterator itnhg = m_EcmpGroups.find(nexthops);
-
-    if (itnhg == m_EcmpGroups.end())
+    for (int len : table.lens)
     {
-        for (std::set<IpAddress>::const_iterator itnh = addrset.begin(); itnh != addrset.end(); itnh++)
+        auto it = table.routes.find(IpPrefix::MakeKey(addr, len));
+
+        if (it != table.routes.end())
         {
-            const NeighborEntry *nbEntry = m_neighborMgr->GetNeighborEntry(*itnh);
+            return &it->second;
+        }
+    }
 
-            if (!nbEntry)
-            {
-                LOGG(TEST_ERR, ROUTE, "fail to find the NeiborEntry for nexthop %s\n", itnh->to_string().c_str());
-                continue;
-            }
+    return NULL;
+}
 
-            nhg_id = nbEntry->nhid;
-            nhids.push_back(nbEntry->nhid);
-        }
+std::vector<const RouteEntry*> RouteTable::Entries() const
+{
+    std::vector<const RouteEntry*> entries;
 
-        if (nhids.size() == 0)
+    for (const FamilyTable *table : { &m_v4, &m_v6 })
+    {
+        for (auto it = table->routes.begin(); it != table->routes.end(); ++it)
         {
-            LOGG(TEST_DEBUG, ROUTE, "cannot find the any of nexthops %s in the neighbor table\n", nexthops.to_string().c_str());
-            return false;
+            entries.push_back(&it->second);
         }
+    }
 
-        if (nhids.size() > 1)
-        {
-            if (!m_nhgMgr->Add(nexthops))
-            {
-                LOGG(TEST_ERR, ROUTE, "fail to add next hop group %s\n", nexthops.to_string().c_str());
-                return false;
-            }
+    std::sort(entries.begin(), entries.end(),
+              [](const RouteEntry * a, const RouteEntry * b)
+    {
+        return a->prefix < b->prefix;
+    });
 
-            const NextHopGrpEntry *nhgEntry = m_nhgMgr->GetNextHopGrpEntry(nexthops);
+    return entries;
+}
 
-            if (!nhgEntry)
-            {
-                LOGG(TEST_ERR, ROUTE, "fail to retrieve next hop group %s\n", nexthops.to_string().c_str());
-                return false;
-            }
+RouteMgr::RouteMgr(NeighborMgr* neighborMgr, NextHopGrpMgr* nhgMgr)
+{
+    m_neighborMgr = neighborMgr;
+    m_nhgMgr = nhgMgr;
+    m_neighborMgr->SetListener(this);
+}
 
-            nhg_id = nhgEntry->nhg_id;
-        }
+sai_object_id_t RouteMgr::VrId(sai_object_id_t vr_id)
+{
+    return (vr_id == SAI_NULL_OBJECT_ID) ? g_vr_id : vr_id;
+}
 
-        m_EcmpGroups[nexthops] = nhg_id;
+sai_int32_t RouteMgr::RouteAction(const NextHopGrpEntry *nhg)
+{
+    //no next hop left, let the CPU resolve
+    if (!nhg->resolved)
+    {
+        return SAI_PACKET_ACTION_TRAP;
     }
-    else
+
+    //black hole
+    if (nhg->nhg_id == SAI_NULL_OBJECT_ID)
     {
-        nhg_id = m_EcmpGroups[nexthops];
+        return SAI_PACKET_ACTION_DROP;
     }
 
+    return SAI_PACKET_ACTION_FORWARD;
+}
+
+/* Point a programmed route at nhg, only the attributes that change are set.
+ * A trapping route of an unresolved set lets go of its next hop */
+bool RouteMgr::SetRoute(RouteEntry *entry, NextHopGrpEntry *nhg)
+{
+    sai_status_t status = SAI_STATUS_SUCCESS;
+    sai_int32_t action = RouteAction(nhg);
+    sai_attribute_t route_attr;
 
     sai_unicast_route_entry_t unicast_route_entry;
-    unicast_route_entry.vr_id = g_vr_id;
-    unicast_route_entry.destination.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
-    unicast_route_entry.destination.addr.ip4 = prefix.Addr().addr();
-    unicast_route_entry.destination.mask.ip4 = prefix.Mask().addr();
+    unicast_route_entry.vr_id = entry->vr_id;
+    entry->prefix.to_sai(unicast_route_entry.destination);
 
-    sai_attribute_t route_attr;
+    LOGG(TEST_INFO, ROUTE, "sai_route_api->set_route_attribute %s | nexthops %s\n",
+         entry->prefix.to_string().c_str(), nhg->nextHops.to_string().c_str());
 
-    if (nexthops.size() == 1 &&
-            nexthops == IpAddresses("0.0.0.0"))
+    if (action == SAI_PACKET_ACTION_FORWARD)
+    {
+        route_attr.id = SAI_ROUTE_ATTR_NEXT_HOP_ID;
+        route_attr.value.oid = nhg->nhg_id;
+        status = sai_route_api->set_route_attribute(&unicast_route_entry, &route_attr);
+    }
+
+    if (status == SAI_STATUS_SUCCESS && action != entry->action)
     {
         route_attr.id = SAI_ROUTE_ATTR_PACKET_ACTION;
-        route_attr.value.s32 = SAI_PACKET_ACTION_DROP;
+        route_attr.value.s32 = action;
+        status = sai_route_api->set_route_attribute(&unicast_route_entry, &route_attr);
     }
-    else
+
+    if (status == SAI_STATUS_SUCCESS && !nhg->resolved)
     {
         route_attr.id = SAI_ROUTE_ATTR_NEXT_HOP_ID;
-        route_attr.value.oid = nhg_id;
+        route_attr.value.oid = SAI_NULL_OBJECT_ID;
+        status = sai_route_api->set_route_attribute(&unicast_route_entry, &route_attr);
     }
 
-    if (m_Routes.find(prefix) == m_Routes.end())
+    if (status != SAI_STATUS_SUCCESS)
     {
-        LOGG(TEST_INFO, ROUTE, "sai_route_api->create_route %s | nexthops %s\n",
-             prefix.to_string().c_str(), nexthops.to_string().c_str());
+        LOGG(TEST_ERR, ROUTE, "fail to set nexthop(s) %s for route %s, rc=0x%x",
+             nhg->nextHops.to_string().c_str(),
+             entry->prefix.to_string().c_str(), -status);
+        return false;
+    }
 
-        status = sai_route_api->create_route(&unicast_route_entry, 1, &route_attr);
+    entry->action = action;
+    return true;
+}
 
-        if (status != SAI_STATUS_SUCCESS)
+bool RouteMgr::Reprogram(const std::vector<NextHopGrpEntry*> &changed)
+{
+    std::vector<RouteEntry*> routes;
+    bool ok = true;
+
+    for (auto it = changed.begin(); it != changed.end(); ++it)
+    {
+        const DepIndex<const NextHopGrpEntry*, RouteEntry*>::Users *users = m_groupUsers.Find(*it);
+
+        if (users)
         {
-            LOGG(TEST_ERR, ROUTE, "fail to create route for %s, nexthop(s) are %s rc=0x%x\n",
-                 prefix.to_string().c_str(),
-                 nexthops.to_string().c_str(), -status);
-            return false;
+            routes.insert(routes.end(), users->begin(), users->end());
         }
     }
-    else
+
+    LOGG(TEST_INFO, ROUTE, "%zu next hop sets changed, reprogram %zu routes\n", changed.size(), routes.size());
+
+    for (auto it = routes.begin(); it != routes.end(); ++it)
     {
-        LOGG(TEST_INFO, ROUTE, "sai_route_api->set_route_attribute %s | nexthops %s\n",
-             prefix.to_string().c_str(), nexthops.to_string().c_str());
+        ok = SetRoute(*it, (*it)->nhg) && ok;
+    }
 
-        status = sai_route_api->set_route_attribute(&unicast_route_entry, &route_attr);
+    return ok;
+}
+
+bool RouteMgr::OnNeighborDel(const IpAddress &ipAddr)
+{
+    std::vector<NextHopGrpEntry*> changed;
 
-        if (status != SAI_STATUS_SUCCESS)
+    if (!m_nhgMgr->SetMemberState(ipAddr, false, &changed))
+    {
+        return false;
+    }
+
+    //routes trap before the last next hop leaves their sets
+    return Reprogram(changed) && m_nhgMgr->DropStale(changed);
+}
+
+void RouteMgr::OnNeighborAdd(const IpAddress &ipAddr)
+{
+    std::vector<NextHopGrpEntry*> changed;
+
+    if (m_nhgMgr->SetMemberState(ipAddr, true, &changed))
+    {
+        Reprogram(changed);
+    }
+}
+
+void RouteMgr::Show()
+{
+    LOGG(TEST_DEBUG, ROUTE, "\t--- --- --- --- --- --- Routes Synced --- --- --- --- --- --- ---\n");
+    LOGG(TEST_DEBUG, ROUTE, "\t%-14s %-40s | %s\n", "vr_id", "route", "nexthops");
+
+    for (auto itvr = m_Routes.begin(); itvr != m_Routes.end(); itvr++)
+    {
+        for (const RouteEntry *entry : itvr->second.Entries())
         {
-            LOGG(TEST_ERR, ROUTE, "fail to set nexthop(s) %s for route %s, rc=0x%x",
-                 nexthops.to_string().c_str(),
-                 prefix.to_string().c_str(), -status);
+            LOGG(TEST_DEBUG, ROUTE, "\t0x%-12lx %-40s | %s\n",
+                 itvr->first,
+                 entry->prefix.to_string().c_str(),
+                 entry->nexthops.to_string().c_str());
+        }
+    }
+
+    LOGG(TEST_DEBUG, ROUTE, "\t--- --- --- --- --- --- --- --- --- --- --- --- --- --- --- --- -\n");
+}
+
+void RouteMgr::ShowECMP()
+{
+    m_nhgMgr->Show();
+}
+
+bool RouteMgr::Add(IpPrefix prefix, IpAddresses nexthops, sai_object_id_t vr_id)
+{
+    sai_status_t status;
+    NextHopGrpEntry *nhg;
+
+    sai_unicast_route_entry_t unicast_route_entry;
+    unicast_route_entry.vr_id = VrId(vr_id);
+    prefix.to_sai(unicast_route_entry.destination);
+
+    RouteTable &routes = m_Routes[unicast_route_entry.vr_id];
+    RouteEntry *entry = routes.Find(prefix);
+
+    if (entry && entry->nexthops == nexthops)
+    {
+        return true;
+    }
+
+    //a route whose ECMP set changes by a few members keeps its group
+    if (entry && (nhg = m_nhgMgr->Modify(entry->nhg, nexthops)) != NULL)
+    {
+        m_groupUsers.Unlink(entry->nhg, entry);
+        m_groupUsers.Link(nhg, entry);
+        entry->nexthops = nexthops;
+        entry->nhg = nhg;
+        return true;
+    }
+
+    nhg = m_nhgMgr->Acquire(nexthops);
+
+    if (!nhg)
+    {
+        LOGG(TEST_ERR, ROUTE, "fail to add next hop group %s\n", nexthops.to_string().c_str());
+        return false;
+    }
+
+    if (entry)
+    {
+        if (!SetRoute(entry, nhg))
+        {
+            m_nhgMgr->Release(nhg);
             return false;
         }
 
+        m_groupUsers.Unlink(entry->nhg, entry);
+        m_nhgMgr->Release(entry->nhg);
+        m_groupUsers.Link(nhg, entry);
+        entry->nexthops = nexthops;
+        entry->nhg = nhg;
         return true;
     }
 
-    m_Routes[prefix] = nexthops;
+    sai_attribute_t route_attr;
+    sai_int32_t action = RouteAction(nhg);
+
+    if (action == SAI_PACKET_ACTION_FORWARD)
+    {
+        route_attr.id = SAI_ROUTE_ATTR_NEXT_HOP_ID;
+        route_attr.value.oid = nhg->nhg_id;
+    }
+    else
+    {
+        route_attr.id = SAI_ROUTE_ATTR_PACKET_ACTION;
+        route_attr.value.s32 = action;
+    }
+
+    LOGG(TEST_INFO, ROUTE, "sai_route_api->create_route %s | nexthops %s\n",
+         prefix.to_string().c_str(), nexthops.to_string().c_str());
+
+    status = sai_route_api->create_route(&unicast_route_entry, 1, &route_attr);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        LOGG(TEST_ERR, ROUTE, "fail to create route for %s, nexthop(s) are %s rc=0x%x\n",
+             prefix.to_string().c_str(),
+             nexthops.to_string().c_str(), -status);
+        m_nhgMgr->Release(nhg);
+        return false;
+    }
+
+    entry = routes.Insert(prefix, nexthops);
+    entry->vr_id = unicast_route_entry.vr_id;
+    entry->nhg = nhg;
+    entry->action = action;
+    m_groupUsers.Link(nhg, entry);
 
     return true;
 }
 
-bool RouteMgr::Del(IpPrefix prefix)
+bool RouteMgr::Del(IpPrefix prefix, sai_object_id_t vr_id)
 {
+    auto itvr = m_Routes.find(VrId(vr_id));
+    RouteEntry *entry = (itvr == m_Routes.end()) ? NULL : itvr->second.Find(prefix);
 
-    RouteTable::const_iterator it;
-    it = m_Routes.find(prefix);
-    IpAddresses nexthops;
-
-    if (it == m_Routes.end())
+    if (!entry)
     {
         LOGG(TEST_DEBUG, ROUTE, "cannot find route %s in the route table\n", prefix.to_string().c_str());
         return true;
@@ -221,10 +376,8 @@ bool RouteMgr::Del(IpPrefix prefix)
          prefix.to_string().c_str());
 
     sai_unicast_route_entry_t unicast_route_entry;
-    unicast_route_entry.vr_id = g_vr_id;
-    unicast_route_entry.destination.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
-    unicast_route_entry.destination.addr.ip4 = prefix.Addr().addr();
-    unicast_route_entry.destination.mask.ip4 = prefix.Mask().addr();
+    unicast_route_entry.vr_id = itvr->first;
+    entry->prefix.to_sai(unicast_route_entry.destination);
 
     sai_status_t status = sai_route_api->remove_route(&unicast_route_entry);
 
@@ -234,54 +387,66 @@ bool RouteMgr::Del(IpPrefix prefix)
         return false;
     }
 
+    NextHopGrpEntry *nhg = entry->nhg;
 
-    sai_object_id_t nhg_id;
-    nexthops = m_Routes[prefix];
+    m_groupUsers.Unlink(nhg, entry);
+    itvr->second.Erase(prefix);
 
-    nhg_id = m_EcmpGroups[nexthops];
-
-    //skip the entry for blackhole
-    if (nhg_id == 0)
+    if (itvr->second.Size() == 0)
     {
-        m_Routes.erase(prefix);
-        return true;
+        m_Routes.erase(itvr);
     }
 
-    //On this field, there could be next hop id and next hop group id.
-    //the following handles only next hop group id
-    if (SAI_OID_TYPE_CHECK(nhg_id, SAI_OBJECT_TYPE_NEXT_HOP_GROUP))
+    //the group goes with the last route using it
+    if (!m_nhgMgr->Release(nhg))
     {
-        LOGG(TEST_INFO, ROUTE, "remove nexthopgrp id 0x%lx\n", nhg_id);
-
-        if (!m_nhgMgr->Del(nexthops))
-        {
-            LOGG(TEST_ERR, ROUTE, "failed to remove nexthopgrp id 0x%lx\n", nhg_id);
-            return false;
-        }
+        LOGG(TEST_ERR, ROUTE, "failed to release nexthops of %s\n", prefix.to_string().c_str());
+        return false;
     }
 
-    m_EcmpGroups.erase(nexthops);
-    m_Routes.erase(prefix);
+    return true;
+}
+
+const RouteEntry* RouteMgr::Lookup(const IpAddress &addr, sai_object_id_t vr_id) const
+{
+    auto itvr = m_Routes.find(VrId(vr_id));
 
-    for (it = m_Routes.begin(); it != m_Routes.end(); ++it)
+    if (itvr == m_Routes.end())
     {
-        if (it->second == nexthops)
-        {
-            break;
-        }
+        return NULL;
     }
 
-    return true;
+    return itvr->second.Lookup(addr);
 }
 
+size_t RouteMgr::Size() const
+{
+    size_t size = 0;
+
+    for (auto itvr = m_Routes.begin(); itvr != m_Routes.end(); itvr++)
+    {
+        size += itvr->second.Size();
+    }
+
+    return size;
+}
 
 bool RouteMgr::EraseAll()
 {
-    RouteTable::const_iterator it;
+    std::vector<std::pair<sai_object_id_t, IpPrefix>> routes;
+
+    // Del drops entries and empty tables, so collect the routes first
+    for (auto itvr = m_Routes.begin(); itvr != m_Routes.end(); itvr++)
+    {
+        for (const RouteEntry *entry : itvr->second.Entries())
+        {
+            routes.push_back(std::make_pair(itvr->first, entry->prefix));
+        }
+    }
 
-    for (it = m_Routes.begin(); it != m_Routes.end(); ++it)
+    for (auto it = routes.begin(); it != routes.end(); ++it)
     {
-        if (!RouteMgr::Del(it->first))
+        if (!RouteMgr::Del(it->second, it->first))
         {
             return false;
         }
@@ -24,6 +24,8 @@
 #include <set>
 #include <map>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 extern "C"
 {
@@ -35,27 +37,103 @@ extern "C"
 #include "log.h"
 #include "ip.h"
 #include "basic_router.h"
+#include "dep_graph.h"
+#include "neighbor_mgr.h"
 
 
 class NeighborMgr;
 class NextHopGrpMgr;
+struct NextHopGrpEntry;
 
-typedef std::map<IpPrefix, IpAddresses> RouteTable;
+struct RouteEntry
+{
+    IpPrefix prefix;
+    IpAddresses nexthops;
+    sai_object_id_t vr_id;
+    // handle of the interned next hop set
+    NextHopGrpEntry* nhg;
+    // programmed packet action [sai_packet_action_t]
+    sai_int32_t action;
+};
+
+/*
+ * Routes of one virtual router. Every family keeps one hash table keyed by
+ * the packed prefix and the list of prefix lengths in use, longest first.
+ * Add and Del are a single probe, a longest prefix match probes each length
+ * in use once.
+ */
+class RouteTable
+{
+    struct FamilyTable
+    {
+        std::unordered_map<IpPrefixKey, RouteEntry, IpPrefixKeyHash> routes;
+        uint32_t lenCount[129] = {0};
+        std::vector<int> lens;
+    };
+
+    FamilyTable m_v4;
+    FamilyTable m_v6;
+
+    FamilyTable &Table(bool v4)
+    {
+        return v4 ? m_v4 : m_v6;
+    }
+
+    const FamilyTable &Table(bool v4) const
+    {
+        return v4 ? m_v4 : m_v6;
+    }
+
+public:
+    RouteEntry* Find(const IpPrefix &prefix);
+    RouteEntry* Insert(const IpPrefix &prefix, const IpAddresses &nexthops);
+    void Erase(const IpPrefix &prefix);
+
+    // longest prefix match
+    const RouteEntry* Lookup(const IpAddress &addr) const;
+
+    // all routes, sorted by prefix
+    std::vector<const RouteEntry*> Entries() const;
+
+    size_t Size() const
+    {
+        return m_v4.routes.size() + m_v6.routes.size();
+    }
+};
 
-class RouteMgr
+/*
+ * Follows the neighbors: routes whose next hop set lost every next hop trap
+ * to the CPU and forward again once one is back. Only the routes of the
+ * changed sets are visited, all in one pass after the groups are updated.
+ */
+class RouteMgr : public NeighborListener
 {
     NeighborMgr* m_neighborMgr;
     NextHopGrpMgr* m_nhgMgr;
 
-    RouteTable m_Routes;
+    // route table per virtual router
+    std::unordered_map<sai_object_id_t, RouteTable> m_Routes;
+
+    // routes using each next hop set
+    DepIndex<const NextHopGrpEntry*, RouteEntry*> m_groupUsers;
 
-    std::map<IpAddresses, sai_object_id_t> m_EcmpGroups;
+    static sai_object_id_t VrId(sai_object_id_t vr_id);
+    static sai_int32_t RouteAction(const NextHopGrpEntry *nhg);
+
+    bool SetRoute(RouteEntry *entry, NextHopGrpEntry *nhg);
+    bool Reprogram(const std::vector<NextHopGrpEntry*> &changed);
 
 public:
     RouteMgr(NeighborMgr* neighborMgr, NextHopGrpMgr* nhgMgr);
 
-    bool Add(IpPrefix prefix, IpAddresses nexthops);
-    bool Del(IpPrefix prefix);
+    bool OnNeighborDel(const IpAddress &ipAddr);
+    void OnNeighborAdd(const IpAddress &ipAddr);
+
+    // vr_id SAI_NULL_OBJECT_ID is the default virtual router
+    bool Add(IpPrefix prefix, IpAddresses nexthops, sai_object_id_t vr_id = SAI_NULL_OBJECT_ID);
+    bool Del(IpPrefix prefix, sai_object_id_t vr_id = SAI_NULL_OBJECT_ID);
+    const RouteEntry* Lookup(const IpAddress &addr, sai_object_id_t vr_id = SAI_NULL_OBJECT_ID) const;
+    size_t Size() const;
     bool EraseAll();
     void Show();
     void ShowECMP();
@@ -0,0 +1,780 @@
+/************************************************************************
+*    Licensed under the Apache License, Version 2.0 (the "License"); you may
+*    not use this file except in compliance with the License. You may obtain
+*    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+*
+*    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+*    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+*    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+*    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+*
+*    See the Apache Version 2.0 License for specific language governing
+*    permissions and limitations under the License.
+*
+*
+* Module Name:
+*
+*    sai_stub_acl_unit_test.cpp
+*
+* Abstract:
+*
+*    This file contains tests for the stub ACL tables, entries and
+*    counters. Frames are run through the stub software data plane and
+*    through the classifier of a single table, and the classifier rate and
+*    update latency are reported for a large rule set.
+*
+*************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/sai_stub_unit_test_utils.h"
+
+extern "C" {
+#include "sai.h"
+#include "saitypes.h"
+#include "saistatus.h"
+#include "saiswitch.h"
+#include "saiacl.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_acl.h"
+#include <arpa/inet.h>
+#include <string.h>
+#include <stdio.h>
+#include <inttypes.h>
+}
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+class saiStubAclTest : public saiStubTest
+{
+    protected:
+        static void SetUpTestCase (void);
+
+        struct frame_t {
+            uint8_t       buffer[STUB_DATAPLANE_HEADROOM + 128];
+            stub_packet_t packet;
+        };
+
+        static void build_tcp (frame_t *frame, sai_object_id_t in_port, uint32_t host_order_src,
+                               uint32_t host_order_dst, uint16_t dst_port);
+        static sai_object_id_t table_create (sai_acl_stage_t stage, uint32_t priority);
+        static sai_status_t entry_create (sai_object_id_t *entry_id, sai_object_id_t table_id,
+                                          uint32_t priority, uint32_t host_order_dst,
+                                          uint32_t dst_mask, uint16_t dst_port,
+                                          sai_packet_action_t action);
+
+        static sai_acl_api_t    *p_acl_api;
+};
+
+sai_acl_api_t* saiStubAclTest::p_acl_api = NULL;
+
+static void frame_init (uint8_t *eth, stub_packet_t *packet, uint32_t length,
+                        sai_object_id_t in_port)
+{
+    memset (packet, 0, sizeof (*packet));
+    packet->data     = eth;
+    packet->length   = length;
+    packet->headroom = STUB_DATAPLANE_HEADROOM;
+    packet->in_port  = in_port;
+}
+
+/* TCP over IPv4 to an unknown MAC */
+void saiStubAclTest::build_tcp (frame_t *frame, sai_object_id_t in_port, uint32_t host_order_src,
+                                uint32_t host_order_dst, uint16_t dst_port)
+{
+    uint8_t  *eth = frame->buffer + STUB_DATAPLANE_HEADROOM;
+    uint8_t  *ip = eth + 14;
+    uint32_t  src = htonl (host_order_src), dst = htonl (host_order_dst);
+
+    memset (frame->buffer, 0, sizeof (frame->buffer));
+    eth[5]  = 0x10;
+    eth[6]  = 0x02;
+    eth[11] = 0x99;
+    eth[12] = 0x08;
+
+    ip[0]  = 0x45;
+    ip[3]  = 40;
+    ip[8]  = 64;
+    ip[9]  = 6;
+    memcpy (ip + 12, &src, 4);
+    memcpy (ip + 16, &dst, 4);
+    ip[20] = 0xC3;
+    ip[21] = 0x50;
+    ip[22] = (uint8_t) (dst_port >> 8);
+    ip[23] = (uint8_t) dst_port;
+    frame_init (eth, &frame->packet, 54, in_port);
+}
+
+/* Table matching on in/out port, source and destination IP, protocol and
+ * destination L4 port */
+sai_object_id_t saiStubAclTest::table_create (sai_acl_stage_t stage, uint32_t priority)
+{
+    sai_object_id_t table_id = SAI_NULL_OBJECT_ID;
+    sai_attribute_t attr[8];
+
+    memset (attr, 0, sizeof (attr));
+    attr[0].id        = SAI_ACL_TABLE_ATTR_STAGE;
+    attr[0].value.s32 = stage;
+    attr[1].id        = SAI_ACL_TABLE_ATTR_PRIORITY;
+    attr[1].value.u32 = priority;
+    attr[2].id        = SAI_ACL_TABLE_ATTR_FIELD_IN_PORT;
+    attr[3].id        = SAI_ACL_TABLE_ATTR_FIELD_OUT_PORT;
+    attr[4].id        = SAI_ACL_TABLE_ATTR_FIELD_SRC_IP;
+    attr[5].id        = SAI_ACL_TABLE_ATTR_FIELD_DST_IP;
+    attr[6].id        = SAI_ACL_TABLE_ATTR_FIELD_IP_PROTOCOL;
+    attr[7].id        = SAI_ACL_TABLE_ATTR_FIELD_L4_DST_PORT;
+    for (uint32_t i = 2; i < 8; i++) {
+        attr[i].value.booldata = true;
+    }
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->create_acl_table (&table_id, 8, attr));
+
+    return table_id;
+}
+
+/* Entry matching a destination prefix and, unless 0, a TCP destination port */
+sai_status_t saiStubAclTest::entry_create (sai_object_id_t *entry_id, sai_object_id_t table_id,
+                                           uint32_t priority, uint32_t host_order_dst,
+                                           uint32_t dst_mask, uint16_t dst_port,
+                                           sai_packet_action_t action)
+{
+    sai_attribute_t attr[6];
+    uint32_t        count = 4;
+
+    memset (attr, 0, sizeof (attr));
+    attr[0].id                               = SAI_ACL_ENTRY_ATTR_TABLE_ID;
+    attr[0].value.oid                        = table_id;
+    attr[1].id                               = SAI_ACL_ENTRY_ATTR_PRIORITY;
+    attr[1].value.u32                        = priority;
+    attr[2].id                               = SAI_ACL_ENTRY_ATTR_FIELD_DST_IP;
+    attr[2].value.aclfield.enable            = true;
+    attr[2].value.aclfield.data.ip4          = htonl (host_order_dst);
+    attr[2].value.aclfield.mask.ip4          = htonl (dst_mask);
+    attr[3].id                               = SAI_ACL_ENTRY_ATTR_PACKET_ACTION;
+    attr[3].value.aclaction.enable           = true;
+    attr[3].value.aclaction.parameter.s32    = action;
+    if (0 != dst_port) {
+        attr[4].id                           = SAI_ACL_ENTRY_ATTR_FIELD_L4_DST_PORT;
+        attr[4].value.aclfield.enable        = true;
+        attr[4].value.aclfield.data.u16      = dst_port;
+        attr[4].value.aclfield.mask.u16      = 0xFFFF;
+        attr[5].id                           = SAI_ACL_ENTRY_ATTR_FIELD_IP_PROTOCOL;
+        attr[5].value.aclfield.enable        = true;
+        attr[5].value.aclfield.data.u8       = 6;
+        attr[5].value.aclfield.mask.u8       = 0xFF;
+        count = 6;
+    }
+
+    return p_acl_api->create_acl_entry (entry_id, count, attr);
+}
+
+void saiStubAclTest::SetUpTestCase (void)
+{
+    SetUpStubSwitch ();
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_ACL, (void **)&p_acl_api));
+}
+
+/*
+ * Tables, entries and counters are validated on create, read back and
+ * refuse removal while in use.
+ */
+TEST_F (saiStubAclTest, acl_crud)
+{
+    sai_object_id_t table_id, other_id, entry_id, spare_id, counter_id, other_counter_id;
+    sai_attribute_t attr[4];
+
+    attr[0].id = SAI_SWITCH_ATTR_ACL_TABLE_MAXIMUM_PRIORITY;
+    attr[1].id = SAI_SWITCH_ATTR_ACL_ENTRY_MAXIMUM_PRIORITY;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->get_switch_attribute (2, attr));
+    EXPECT_EQ ((uint32_t)STUB_ACL_TABLE_MAX_PRIORITY, attr[0].value.u32);
+    EXPECT_EQ ((uint32_t)STUB_ACL_ENTRY_MAX_PRIORITY, attr[1].value.u32);
+
+    /* Stage and priority are mandatory, the priority is range checked */
+    memset (attr, 0, sizeof (attr));
+    attr[0].id             = SAI_ACL_TABLE_ATTR_FIELD_DST_IP;
+    attr[0].value.booldata = true;
+    attr[1].id             = SAI_ACL_TABLE_ATTR_STAGE;
+    attr[1].value.s32      = SAI_ACL_STAGE_INGRESS;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_acl_api->create_acl_table (&table_id, 2, attr));
+    attr[2].id             = SAI_ACL_TABLE_ATTR_PRIORITY;
+    attr[2].value.u32      = STUB_ACL_TABLE_MAX_PRIORITY + 1;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_acl_api->create_acl_table (&table_id, 3, attr));
+    attr[2].value.u32      = 7;
+    attr[3].id             = SAI_ACL_TABLE_ATTR_SIZE;
+    attr[3].value.u32      = 1;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->create_acl_table (&table_id, 4, attr));
+
+    attr[0].id = SAI_ACL_TABLE_ATTR_STAGE;
+    attr[1].id = SAI_ACL_TABLE_ATTR_PRIORITY;
+    attr[2].id = SAI_ACL_TABLE_ATTR_FIELD_DST_IP;
+    attr[3].id = SAI_ACL_TABLE_ATTR_FIELD_SRC_IP;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->get_acl_table_attribute (table_id, 4, attr));
+    EXPECT_EQ (SAI_ACL_STAGE_INGRESS, attr[0].value.s32);
+    EXPECT_EQ (7u, attr[1].value.u32);
+    EXPECT_TRUE (attr[2].value.booldata);
+    EXPECT_FALSE (attr[3].value.booldata);
+
+    /* Entries need a field the table matches on */
+    memset (attr, 0, sizeof (attr));
+    attr[0].id        = SAI_ACL_ENTRY_ATTR_TABLE_ID;
+    attr[0].value.oid = table_id;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_acl_api->create_acl_entry (&entry_id, 1, attr));
+    attr[1].id                      = SAI_ACL_ENTRY_ATTR_FIELD_SRC_IP;
+    attr[1].value.aclfield.enable   = true;
+    attr[1].value.aclfield.data.ip4 = htonl (0x0A000001);
+    attr[1].value.aclfield.mask.ip4 = 0xFFFFFFFF;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_acl_api->create_acl_entry (&entry_id, 2, attr));
+
+    /* Counters count something and belong to their table */
+    memset (attr, 0, sizeof (attr));
+    attr[0].id             = SAI_ACL_COUNTER_ATTR_TABLE_ID;
+    attr[0].value.oid      = table_id;
+    attr[1].id             = SAI_ACL_COUNTER_ATTR_ENABLE_BYTE_COUNT;
+    attr[1].value.booldata = false;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_acl_api->create_acl_counter (&counter_id, 2, attr));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->create_acl_counter (&counter_id, 1, attr));
+
+    other_id = table_create (SAI_ACL_STAGE_EGRESS, 1);
+    attr[0].value.oid = other_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->create_acl_counter (&other_counter_id, 1, attr));
+
+    memset (attr, 0, sizeof (attr));
+    attr[0].id                            = SAI_ACL_ENTRY_ATTR_TABLE_ID;
+    attr[0].value.oid                     = table_id;
+    attr[1].id                            = SAI_ACL_ENTRY_ATTR_FIELD_DST_IP;
+    attr[1].value.aclfield.enable         = true;
+    attr[1].value.aclfield.data.ip4       = htonl (0x0A010000);
+    attr[1].value.aclfield.mask.ip4       = htonl (0xFFFF0000);
+    attr[2].id                            = SAI_ACL_ENTRY_ATTR_ACTION_COUNTER;
+    attr[2].value.aclaction.enable        = true;
+    attr[2].value.aclaction.parameter.oid = other_counter_id;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_acl_api->create_acl_entry (&entry_id, 3, attr));
+    attr[2].value.aclaction.parameter.oid = counter_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->create_acl_entry (&entry_id, 3, attr));
+
+    /* The table was sized for one entry */
+    attr[1].value.aclfield.data.ip4 = htonl (0x0A020000);
+    EXPECT_EQ (SAI_STATUS_TABLE_FULL, p_acl_api->create_acl_entry (&spare_id, 2, attr));
+
+    memset (attr, 0, sizeof (attr));
+    attr[0].id = SAI_ACL_ENTRY_ATTR_FIELD_DST_IP;
+    attr[1].id = SAI_ACL_ENTRY_ATTR_ACTION_COUNTER;
+    attr[2].id = SAI_ACL_ENTRY_ATTR_ADMIN_STATE;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->get_acl_entry_attribute (entry_id, 3, attr));
+    EXPECT_TRUE (attr[0].value.aclfield.enable);
+    EXPECT_EQ (htonl (0x0A010000), attr[0].value.aclfield.data.ip4);
+    EXPECT_EQ (htonl (0xFFFF0000), attr[0].value.aclfield.mask.ip4);
+    EXPECT_TRUE (attr[1].value.aclaction.enable);
+    EXPECT_EQ (counter_id, attr[1].value.aclaction.parameter.oid);
+    EXPECT_TRUE (attr[2].value.booldata);
+
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_acl_api->delete_acl_counter (counter_id));
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_acl_api->delete_acl_table (table_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_entry (entry_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_counter (counter_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_table (table_id));
+
+    /* Redirect is an ingress action */
+    memset (attr, 0, sizeof (attr));
+    attr[0].id                            = SAI_ACL_ENTRY_ATTR_TABLE_ID;
+    attr[0].value.oid                     = other_id;
+    attr[1].id                            = SAI_ACL_ENTRY_ATTR_FIELD_OUT_PORT;
+    attr[1].value.aclfield.enable         = true;
+    attr[1].value.aclfield.data.oid       = port_oid (2);
+    attr[2].id                            = SAI_ACL_ENTRY_ATTR_ACTION_REDIRECT;
+    attr[2].value.aclaction.enable        = true;
+    attr[2].value.aclaction.parameter.oid = port_oid (3);
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_acl_api->create_acl_entry (&entry_id, 3, attr));
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_counter (other_counter_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_table (other_id));
+}
+
+/*
+ * Ingress entries drop, trap and redirect frames in the data plane, the
+ * highest priority table decides, every hit counts, and egress entries
+ * see the redirected port.
+ */
+TEST_F (saiStubAclTest, dataplane_actions)
+{
+    frame_t         frame, baseline;
+    sai_object_id_t high_id, low_id, egress_id, drop_id, trap_id, redirect_id, count_id;
+    sai_object_id_t counter_id, block_id;
+    sai_attribute_t attr[3];
+
+    build_tcp (&baseline, port_oid (3), 0x0B000001, 0x0C000001, 80);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, &baseline.packet));
+
+    high_id   = table_create (SAI_ACL_STAGE_INGRESS, 20);
+    low_id    = table_create (SAI_ACL_STAGE_INGRESS, 10);
+    egress_id = table_create (SAI_ACL_STAGE_EGRESS, 10);
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, entry_create (&drop_id, high_id, 10, 0x0A010000, 0xFFFF0000, 80,
+                                                 SAI_PACKET_ACTION_DROP));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, entry_create (&trap_id, high_id, 5, 0x0A000000, 0xFF000000, 22,
+                                                 SAI_PACKET_ACTION_TRAP));
+
+    memset (attr, 0, sizeof (attr));
+    attr[0].id        = SAI_ACL_COUNTER_ATTR_TABLE_ID;
+    attr[0].value.oid = low_id;
+    attr[1].id             = SAI_ACL_COUNTER_ATTR_ENABLE_PACKET_COUNT;
+    attr[1].value.booldata = true;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->create_acl_counter (&counter_id, 2, attr));
+
+    /* The low priority table redirects 10.1.2.3 and counts everything from port 2 */
+    ASSERT_EQ (SAI_STATUS_SUCCESS, entry_create (&redirect_id, low_id, 100, 0x0A010203, 0xFFFFFFFF, 0,
+                                                 SAI_PACKET_ACTION_FORWARD));
+    attr[0].id                            = SAI_ACL_ENTRY_ATTR_ACTION_REDIRECT;
+    attr[0].value.aclaction.enable        = true;
+    attr[0].value.aclaction.parameter.oid = port_oid (5);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->set_acl_entry_attribute (redirect_id, attr));
+
+    memset (attr, 0, sizeof (attr));
+    attr[0].id                            = SAI_ACL_ENTRY_ATTR_TABLE_ID;
+    attr[0].value.oid                     = low_id;
+    attr[1].id                            = SAI_ACL_ENTRY_ATTR_FIELD_IN_PORT;
+    attr[1].value.aclfield.enable         = true;
+    attr[1].value.aclfield.data.oid       = port_oid (2);
+    attr[2].id                            = SAI_ACL_ENTRY_ATTR_ACTION_COUNTER;
+    attr[2].value.aclaction.enable        = true;
+    attr[2].value.aclaction.parameter.oid = counter_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->create_acl_entry (&count_id, 3, attr));
+
+    /* Egress blocks HTTPS out of port 5 */
+    ASSERT_EQ (SAI_STATUS_SUCCESS, entry_create (&block_id, egress_id, 1, 0, 0, 443,
+                                                 SAI_PACKET_ACTION_DROP));
+    attr[0].id                      = SAI_ACL_ENTRY_ATTR_FIELD_OUT_PORT;
+    attr[0].value.aclfield.enable   = true;
+    attr[0].value.aclfield.data.oid = port_oid (5);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->set_acl_entry_attribute (block_id, attr));
+
+    /* A frame no entry matches is left to the forwarding */
+    build_tcp (&frame, port_oid (3), 0x0B000001, 0x0C000001, 80);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, &frame.packet));
+    EXPECT_EQ (baseline.packet.packet_action, frame.packet.packet_action);
+    EXPECT_EQ (baseline.packet.out_port, frame.packet.out_port);
+
+    build_tcp (&frame, port_oid (2), 0x0B000001, 0x0A010505, 80);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, &frame.packet));
+    EXPECT_EQ (SAI_PACKET_ACTION_DROP, frame.packet.packet_action);
+
+    build_tcp (&frame, port_oid (2), 0x0B000001, 0x0A010505, 22);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, &frame.packet));
+    EXPECT_EQ (SAI_PACKET_ACTION_TRAP, frame.packet.packet_action);
+
+    /* The drop of the high priority table beats the redirect of the low one */
+    build_tcp (&frame, port_oid (3), 0x0B000001, 0x0A010203, 80);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, &frame.packet));
+    EXPECT_EQ (SAI_PACKET_ACTION_DROP, frame.packet.packet_action);
+
+    build_tcp (&frame, port_oid (3), 0x0B000001, 0x0A010203, 8080);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, &frame.packet));
+    EXPECT_EQ (SAI_PACKET_ACTION_FORWARD, frame.packet.packet_action);
+    EXPECT_EQ (port_oid (5), frame.packet.out_port);
+
+    build_tcp (&frame, port_oid (3), 0x0B000001, 0x0A010203, 443);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, &frame.packet));
+    EXPECT_EQ (SAI_PACKET_ACTION_DROP, frame.packet.packet_action);
+
+    /* Both frames from port 2 hit the counted entry, dropped or not */
+    attr[0].id = SAI_ACL_COUNTER_ATTR_PACKETS;
+    attr[1].id = SAI_ACL_COUNTER_ATTR_BYTES;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->get_acl_counter_attribute (counter_id, 2, attr));
+    EXPECT_EQ (2u, attr[0].value.u64);
+    EXPECT_EQ (2u * 54, attr[1].value.u64);
+
+    attr[0].value.u64 = 0;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->set_acl_counter_attribute (counter_id, attr));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->get_acl_counter_attribute (counter_id, 1, attr));
+    EXPECT_EQ (0u, attr[0].value.u64);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_entry (block_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_entry (count_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_entry (redirect_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_entry (trap_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_entry (drop_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_counter (counter_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_table (egress_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_table (low_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_table (high_id));
+}
+
+/*
+ * Priority, field and admin state changes take effect on the next
+ * classification.
+ */
+TEST_F (saiStubAclTest, entry_updates)
+{
+    frame_t         frame;
+    sai_object_id_t table_id, wide_id, narrow_id, hit;
+    sai_attribute_t attr;
+
+    table_id = table_create (SAI_ACL_STAGE_INGRESS, 1);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, entry_create (&wide_id, table_id, 10, 0x0A000000, 0xFF000000, 0,
+                                                 SAI_PACKET_ACTION_DROP));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, entry_create (&narrow_id, table_id, 5, 0x0A010203, 0xFFFFFFFF, 80,
+                                                 SAI_PACKET_ACTION_FORWARD));
+
+    build_tcp (&frame, port_oid (1), 0x0B000001, 0x0A010203, 80);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_acl_classify (table_id, 1, &frame.packet, &hit));
+    EXPECT_EQ (wide_id, hit);
+
+    attr.id        = SAI_ACL_ENTRY_ATTR_PRIORITY;
+    attr.value.u32 = 20;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->set_acl_entry_attribute (narrow_id, &attr));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_acl_classify (table_id, 1, &frame.packet, &hit));
+    EXPECT_EQ (narrow_id, hit);
+
+    attr.id = SAI_ACL_ENTRY_ATTR_PRIORITY;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->get_acl_entry_attribute (narrow_id, 1, &attr));
+    EXPECT_EQ (20u, attr.value.u32);
+
+    /* Move the narrow entry to another port */
+    memset (&attr, 0, sizeof (attr));
+    attr.id                       = SAI_ACL_ENTRY_ATTR_FIELD_L4_DST_PORT;
+    attr.value.aclfield.enable    = true;
+    attr.value.aclfield.data.u16  = 8080;
+    attr.value.aclfield.mask.u16  = 0xFFFF;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->set_acl_entry_attribute (narrow_id, &attr));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_acl_classify (table_id, 1, &frame.packet, &hit));
+    EXPECT_EQ (wide_id, hit);
+
+    attr.id             = SAI_ACL_ENTRY_ATTR_ADMIN_STATE;
+    attr.value.booldata = false;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->set_acl_entry_attribute (wide_id, &attr));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_acl_classify (table_id, 1, &frame.packet, &hit));
+    EXPECT_EQ (SAI_NULL_OBJECT_ID, hit);
+
+    attr.value.booldata = true;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->set_acl_entry_attribute (wide_id, &attr));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_acl_classify (table_id, 1, &frame.packet, &hit));
+    EXPECT_EQ (wide_id, hit);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_entry (wide_id));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_acl_classify (table_id, 1, &frame.packet, &hit));
+    EXPECT_EQ (SAI_NULL_OBJECT_ID, hit);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_entry (narrow_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_table (table_id));
+}
+
+/*
+ * Entry changes of a bulk update are not seen by lookups before the
+ * commit, which swaps the whole policy in and reports its latency and the
+ * classifier memory.
+ */
+TEST_F (saiStubAclTest, bulk_update)
+{
+    const uint32_t               entries = 4000;
+    std::vector<sai_object_id_t> entry_ids (entries);
+    frame_t                      old_frame, new_frame;
+    sai_object_id_t              table_id, old_id, hits[2];
+    stub_packet_t                packets[2];
+    sai_attribute_t              attr[4];
+    uint32_t                     ii;
+
+    table_id = table_create (SAI_ACL_STAGE_INGRESS, 1);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, entry_create (&old_id, table_id, 1, 0x0A000000, 0xFF000000, 0,
+                                                 SAI_PACKET_ACTION_DROP));
+
+    attr[0].id = STUB_ACL_TABLE_ATTR_LAST_UPDATE_LATENCY;
+    attr[1].id = STUB_ACL_TABLE_ATTR_SUBTABLE_COUNT;
+    attr[2].id = STUB_ACL_TABLE_ATTR_CLASSIFIER_MEMORY;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->get_acl_table_attribute (table_id, 3, attr));
+    EXPECT_LT (0u, attr[0].value.u64);
+    EXPECT_EQ (1u, attr[1].value.u32);
+    EXPECT_LT (0u, attr[2].value.u64);
+
+    attr[0].id             = STUB_ACL_TABLE_ATTR_BULK_UPDATE;
+    attr[0].value.booldata = true;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->set_acl_table_attribute (table_id, attr));
+
+    for (ii = 0; ii < entries; ii++) {
+        /* Odd entries are hosts of the subnets of the even ones */
+        ASSERT_EQ (SAI_STATUS_SUCCESS, entry_create (&entry_ids[ii], table_id, 10 + ii % 3,
+                                                     (ii % 2) ? 0x0B000000 + ii : 0x0B000000 + (ii << 8),
+                                                     (ii % 2) ? 0xFFFFFFFF : 0xFFFFFF00, 80,
+                                                     SAI_PACKET_ACTION_DROP));
+    }
+    attr[0].id        = SAI_ACL_ENTRY_ATTR_PRIORITY;
+    attr[0].value.u32 = 2;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->set_acl_entry_attribute (old_id, attr));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_entry (old_id));
+
+    /* Lookups keep the policy from before the bulk update */
+    build_tcp (&old_frame, port_oid (1), 0x0C000001, 0x0A000001, 80);
+    build_tcp (&new_frame, port_oid (1), 0x0C000001, 0x0B000001, 80);
+    packets[0] = old_frame.packet;
+    packets[1] = new_frame.packet;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_acl_classify (table_id, 2, packets, hits));
+    EXPECT_EQ (old_id, hits[0]);
+    EXPECT_EQ (SAI_NULL_OBJECT_ID, hits[1]);
+
+    attr[0].id             = STUB_ACL_TABLE_ATTR_BULK_UPDATE;
+    attr[0].value.booldata = false;
+    auto start = std::chrono::steady_clock::now ();
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->set_acl_table_attribute (table_id, attr));
+    double commit_sec = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_acl_classify (table_id, 2, packets, hits));
+    EXPECT_EQ (SAI_NULL_OBJECT_ID, hits[0]);
+    EXPECT_EQ (entry_ids[1], hits[1]);
+
+    attr[0].id = STUB_ACL_TABLE_ATTR_BULK_UPDATE;
+    attr[1].id = STUB_ACL_TABLE_ATTR_LAST_UPDATE_LATENCY;
+    attr[2].id = STUB_ACL_TABLE_ATTR_SUBTABLE_COUNT;
+    attr[3].id = STUB_ACL_TABLE_ATTR_CLASSIFIER_MEMORY;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->get_acl_table_attribute (table_id, 4, attr));
+    EXPECT_FALSE (attr[0].value.booldata);
+    EXPECT_LT (0u, attr[1].value.u64);
+    EXPECT_EQ (2u, attr[2].value.u32);
+    EXPECT_LT ((uint64_t)entries * 100, attr[3].value.u64);
+
+    printf ("bulk commit of %u entries: %.2f ms, classifier %" PRIu64 " KB\n",
+            entries, commit_sec * 1e3, attr[3].value.u64 / 1024);
+
+    /* Entries changed after the commit go back to incremental updates */
+    attr[0].id        = SAI_ACL_ENTRY_ATTR_PRIORITY;
+    attr[0].value.u32 = 1;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->set_acl_entry_attribute (entry_ids[1], attr));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_acl_classify (table_id, 2, packets, hits));
+    EXPECT_EQ (entry_ids[0], hits[1]);
+
+    for (ii = 0; ii < entries; ii++) {
+        ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_entry (entry_ids[ii]));
+    }
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_table (table_id));
+}
+
+/*
+ * Data plane threads count into shards of their own, more threads than
+ * shards share the last one. No hit is lost and a read sums them all.
+ */
+TEST_F (saiStubAclTest, counter_threads)
+{
+    const uint32_t               threads = 24, bursts = 2000;
+    std::vector<std::thread>     workers;
+    sai_object_id_t              table_id, entry_id, counter_id;
+    sai_attribute_t              attr[3];
+
+    table_id = table_create (SAI_ACL_STAGE_INGRESS, 1);
+
+    memset (attr, 0, sizeof (attr));
+    attr[0].id             = SAI_ACL_COUNTER_ATTR_TABLE_ID;
+    attr[0].value.oid      = table_id;
+    attr[1].id             = SAI_ACL_COUNTER_ATTR_ENABLE_PACKET_COUNT;
+    attr[1].value.booldata = true;
+    attr[2].id             = SAI_ACL_COUNTER_ATTR_ENABLE_BYTE_COUNT;
+    attr[2].value.booldata = true;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->create_acl_counter (&counter_id, 3, attr));
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, entry_create (&entry_id, table_id, 1, 0x0A020000, 0xFFFF0000, 0,
+                                                 SAI_PACKET_ACTION_FORWARD));
+    attr[0].id                            = SAI_ACL_ENTRY_ATTR_ACTION_COUNTER;
+    attr[0].value.aclaction.enable        = true;
+    attr[0].value.aclaction.parameter.oid = counter_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->set_acl_entry_attribute (entry_id, attr));
+
+    for (uint32_t t = 0; t < threads; t++) {
+        workers.push_back (std::thread ([t, bursts] () {
+            frame_t       frame[STUB_DATAPLANE_BURST];
+            stub_packet_t packets[STUB_DATAPLANE_BURST];
+
+            for (uint32_t ii = 0; ii < bursts; ii++) {
+                for (uint32_t jj = 0; jj < STUB_DATAPLANE_BURST; jj++) {
+                    build_tcp (&frame[jj], port_oid (1), 0x0B000001, 0x0A020000 + (t << 8) + jj, 80);
+                    packets[jj] = frame[jj].packet;
+                }
+                stub_dataplane_process_burst (STUB_DATAPLANE_BURST, packets);
+            }
+        }));
+    }
+    for (auto &worker : workers) {
+        worker.join ();
+    }
+
+    attr[0].id = SAI_ACL_COUNTER_ATTR_PACKETS;
+    attr[1].id = SAI_ACL_COUNTER_ATTR_BYTES;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->get_acl_counter_attribute (counter_id, 2, attr));
+    EXPECT_EQ ((uint64_t)threads * bursts * STUB_DATAPLANE_BURST, attr[0].value.u64);
+    EXPECT_EQ ((uint64_t)threads * bursts * STUB_DATAPLANE_BURST * 54, attr[1].value.u64);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_entry (entry_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_counter (counter_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_table (table_id));
+}
+
+/*
+ * A bulk read returns every counter of a table, clears them on request
+ * and is timed against reading the counters one by one.
+ */
+TEST_F (saiStubAclTest, counter_bulk_read)
+{
+    const uint32_t               counters = 20000, entries = 256;
+    std::vector<sai_object_id_t> counter_ids (counters), read_ids (counters);
+    std::vector<sai_object_id_t> entry_ids (entries);
+    std::vector<uint64_t>        packets (counters), bytes (counters);
+    std::vector<frame_t>         frame (entries);
+    std::vector<stub_packet_t>   burst (entries);
+    sai_object_id_t              table_id;
+    sai_attribute_t              attr[3];
+    uint32_t                     ii, count;
+
+    table_id = table_create (SAI_ACL_STAGE_INGRESS, 1);
+
+    memset (attr, 0, sizeof (attr));
+    attr[0].id             = SAI_ACL_COUNTER_ATTR_TABLE_ID;
+    attr[0].value.oid      = table_id;
+    attr[1].id             = SAI_ACL_COUNTER_ATTR_ENABLE_PACKET_COUNT;
+    attr[1].value.booldata = true;
+    attr[2].id             = SAI_ACL_COUNTER_ATTR_ENABLE_BYTE_COUNT;
+    attr[2].value.booldata = true;
+    for (ii = 0; ii < counters; ii++) {
+        ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->create_acl_counter (&counter_ids[ii], 3, attr));
+    }
+
+    /* Entry ii counts into counter 78 * ii and is hit ii + 1 times */
+    for (ii = 0; ii < entries; ii++) {
+        ASSERT_EQ (SAI_STATUS_SUCCESS, entry_create (&entry_ids[ii], table_id, 1, 0x0A030000 + ii, 0xFFFFFFFF, 0,
+                                                     SAI_PACKET_ACTION_FORWARD));
+        attr[0].id                            = SAI_ACL_ENTRY_ATTR_ACTION_COUNTER;
+        attr[0].value.aclaction.enable        = true;
+        attr[0].value.aclaction.parameter.oid = counter_ids[78 * ii];
+        ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->set_acl_entry_attribute (entry_ids[ii], attr));
+    }
+    for (uint32_t round = 0; round < entries; round++) {
+        count = 0;
+        for (ii = round; ii < entries; ii++) {
+            build_tcp (&frame[ii], port_oid (1), 0x0B000001, 0x0A030000 + ii, 80);
+            burst[count++] = frame[ii].packet;
+        }
+        for (ii = 0; ii < count; ii += STUB_DATAPLANE_BURST) {
+            stub_dataplane_process_burst ((count - ii < STUB_DATAPLANE_BURST) ? count - ii : STUB_DATAPLANE_BURST,
+                                          &burst[ii]);
+        }
+    }
+
+    count = counters - 1;
+    EXPECT_EQ (SAI_STATUS_BUFFER_OVERFLOW, stub_acl_get_counters_bulk (table_id, &count, read_ids.data (),
+                                                                       packets.data (), bytes.data (), false));
+    EXPECT_EQ (counters, count);
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_acl_get_counters_bulk (table_id, &count, read_ids.data (),
+                                                               packets.data (), bytes.data (), true));
+    ASSERT_EQ (counters, count);
+    for (ii = 0; ii < counters; ii++) {
+        uint64_t hits = (ii % 78 == 0 && ii / 78 < entries) ? ii / 78 + 1 : 0;
+
+        ASSERT_EQ (counter_ids[ii], read_ids[ii]);
+        EXPECT_EQ (hits, packets[ii]);
+        EXPECT_EQ (hits * 54, bytes[ii]);
+    }
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_acl_get_counters_bulk (table_id, &count, read_ids.data (),
+                                                               packets.data (), bytes.data (), false));
+    for (ii = 0; ii < counters; ii++) {
+        EXPECT_EQ (0u, packets[ii]);
+    }
+
+    auto start = std::chrono::steady_clock::now ();
+    stub_acl_get_counters_bulk (table_id, &count, read_ids.data (), packets.data (), bytes.data (), false);
+    double bulk_sec = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+    start = std::chrono::steady_clock::now ();
+    attr[0].id = SAI_ACL_COUNTER_ATTR_PACKETS;
+    attr[1].id = SAI_ACL_COUNTER_ATTR_BYTES;
+    for (ii = 0; ii < counters; ii++) {
+        p_acl_api->get_acl_counter_attribute (counter_ids[ii], 2, attr);
+    }
+    double single_sec = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+    printf ("%u ACL counters: bulk read %.2f ms, one by one %.2f ms\n",
+            counters, bulk_sec * 1e3, single_sec * 1e3);
+
+    for (ii = 0; ii < entries; ii++) {
+        EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_entry (entry_ids[ii]));
+    }
+    for (ii = 0; ii < counters; ii++) {
+        EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_counter (counter_ids[ii]));
+    }
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_table (table_id));
+}
+
+/*
+ * Classify rate and entry create/delete latency of a table with 20k
+ * entries spread over a few mask shapes.
+ */
+TEST_F (saiStubAclTest, classify_rate)
+{
+    const uint32_t               entries = 20000, frames = 256, rounds = 2000;
+    std::vector<sai_object_id_t> entry_ids (entries);
+    std::vector<frame_t>         frame (frames);
+    std::vector<stub_packet_t>   packets (frames);
+    std::vector<sai_object_id_t> hits (frames);
+    sai_object_id_t              table_id;
+    uint32_t                     ii, matched = 0;
+
+    table_id = table_create (SAI_ACL_STAGE_INGRESS, 1);
+
+    auto start = std::chrono::steady_clock::now ();
+    for (ii = 0; ii < entries; ii++) {
+        switch (ii % 4) {
+        case 0:
+            ASSERT_EQ (SAI_STATUS_SUCCESS, entry_create (&entry_ids[ii], table_id, ii, 0x0A000000 + ii,
+                                                         0xFFFFFFFF, 80, SAI_PACKET_ACTION_DROP));
+            break;
+        case 1:
+            ASSERT_EQ (SAI_STATUS_SUCCESS, entry_create (&entry_ids[ii], table_id, ii, 0x14000000 + (ii << 8),
+                                                         0xFFFFFF00, 0, SAI_PACKET_ACTION_DROP));
+            break;
+        case 2:
+            ASSERT_EQ (SAI_STATUS_SUCCESS, entry_create (&entry_ids[ii], table_id, ii, 0x1E000000 + (ii << 16),
+                                                         0xFFFF0000, 0, SAI_PACKET_ACTION_DROP));
+            break;
+        default:
+            ASSERT_EQ (SAI_STATUS_SUCCESS, entry_create (&entry_ids[ii], table_id, ii, 0x28000000 + ii,
+                                                         0xFFFFFFFF, (uint16_t)(1024 + ii),
+                                                         SAI_PACKET_ACTION_DROP));
+            break;
+        }
+    }
+    double create_sec = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+    for (ii = 0; ii < frames; ii++) {
+        uint32_t rule = (ii * 79) % entries;
+
+        if (ii % 8 == 7) {
+            build_tcp (&frame[ii], port_oid (1), 0x0B000001, 0x32000000 + ii, 80);
+        } else if (rule % 4 == 3) {
+            build_tcp (&frame[ii], port_oid (1), 0x0B000001, 0x28000000 + rule, (uint16_t)(1024 + rule));
+        } else {
+            build_tcp (&frame[ii], port_oid (1), 0x0B000001, 0x0A000000 + rule - (rule % 4), 80);
+        }
+        packets[ii] = frame[ii].packet;
+    }
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_acl_classify (table_id, frames, packets.data (), hits.data ()));
+    for (ii = 0; ii < frames; ii++) {
+        matched += (SAI_NULL_OBJECT_ID != hits[ii]);
+    }
+    EXPECT_EQ (frames - frames / 8, matched);
+
+    start = std::chrono::steady_clock::now ();
+    for (ii = 0; ii < rounds; ii++) {
+        stub_acl_classify (table_id, frames, packets.data (), hits.data ());
+    }
+    double classify_sec = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+    start = std::chrono::steady_clock::now ();
+    for (ii = 0; ii < entries; ii++) {
+        ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_entry (entry_ids[ii]));
+    }
+    double delete_sec = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+    printf ("%u entries: create %.2f us, delete %.2f us per entry, classify %.2f Mpps\n",
+            entries, create_sec * 1e6 / entries, delete_sec * 1e6 / entries,
+            (double)frames * rounds / classify_sec / 1e6);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_table (table_id));
+}
@@ -0,0 +1,584 @@
+/************************************************************************
+*    Licensed under the Apache License, Version 2.0 (the "License"); you may
+*    not use this file except in compliance with the License. You may obtain
+*    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+*
+*    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+*    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+*    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+*    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+*
+*    See the Apache Version 2.0 License for specific language governing
+*    permissions and limitations under the License.
+*
+*
+* Module Name:
+*
+*    sai_stub_buffer_unit_test.cpp
+*
+* Abstract:
+*
+*    This file contains tests for the stub shared buffer. Pools and
+*    profiles are checked and read back, queues and priority groups bound
+*    to them take reserved, shared and headroom cells by their thresholds,
+*    priority groups assert and release XOFF, and the occupancies and
+*    watermarks show in the statistics.
+*
+*************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/sai_stub_unit_test_utils.h"
+
+extern "C" {
+#include "sai.h"
+#include "saitypes.h"
+#include "saistatus.h"
+#include "saiswitch.h"
+#include "saiport.h"
+#include "saiqueue.h"
+#include "saibuffer.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_scheduler.h"
+#include "stub_sai_qos_map.h"
+#include "stub_sai_buffer.h"
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+}
+
+#include <chrono>
+
+/* 10 Gbps */
+#define LINE_RATE 1250000000ULL
+/* four cells */
+#define FRAME_LEN 1024
+/* simulated time to send one frame of FRAME_LEN at LINE_RATE, just under, so
+ * that each transmit sends one */
+#define FRAME_NS  819
+
+class saiStubBufferTest : public saiStubTest
+{
+    protected:
+        static void SetUpTestCase (void);
+
+        static sai_object_id_t queue_oid (uint32_t port, uint32_t queue);
+        static sai_object_id_t pg_oid (uint32_t port, uint32_t pg);
+        static void enqueue (uint32_t in_port, uint32_t pg, uint32_t port, uint32_t queue, uint32_t count);
+        static uint32_t transmit (uint32_t port, uint32_t count);
+        static uint64_t queue_stat (sai_object_id_t queue_id, sai_queue_stat_counter_t counter);
+        static uint64_t pg_stat (sai_object_id_t pg_id, sai_ingress_priority_group_stat_counter_t counter);
+        static uint64_t pool_stat (sai_object_id_t pool_id, sai_buffer_pool_stat_counter_t counter);
+        static uint32_t pool_shared_size (sai_object_id_t pool_id);
+        static sai_object_id_t pool_create (sai_buffer_pool_type_t type, uint32_t size,
+                                            sai_buffer_threshold_mode_t mode);
+        static sai_object_id_t profile_create (sai_object_id_t pool_id, uint32_t size, bool dynamic,
+                                               int32_t threshold, uint32_t xoff, uint32_t xon);
+        static void queue_profile_set (sai_object_id_t queue_id, sai_object_id_t profile_id);
+        static void pg_profile_set (sai_object_id_t pg_id, sai_object_id_t profile_id);
+
+        static sai_port_api_t   *p_port_api;
+        static sai_queue_api_t  *p_queue_api;
+        static sai_buffer_api_t *p_buffer_api;
+};
+
+sai_port_api_t* saiStubBufferTest::p_port_api = NULL;
+sai_queue_api_t* saiStubBufferTest::p_queue_api = NULL;
+sai_buffer_api_t* saiStubBufferTest::p_buffer_api = NULL;
+
+/* Queue from the queue list of the port */
+sai_object_id_t saiStubBufferTest::queue_oid (uint32_t port, uint32_t queue)
+{
+    sai_object_id_t queues[STUB_SCHEDULER_MAX_CHILDS];
+    sai_attribute_t attr;
+
+    attr.id                   = SAI_PORT_ATTR_QOS_QUEUE_LIST;
+    attr.value.objlist.count  = STUB_SCHEDULER_MAX_CHILDS;
+    attr.value.objlist.list   = queues;
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_port_api->get_port_attribute (port_oid (port), 1, &attr));
+    EXPECT_LT (queue, attr.value.objlist.count);
+
+    return queues[queue];
+}
+
+/* Priority group from the priority group list of the port */
+sai_object_id_t saiStubBufferTest::pg_oid (uint32_t port, uint32_t pg)
+{
+    sai_object_id_t pgs[STUB_QOS_PRIORITY_GROUPS];
+    sai_attribute_t attr;
+
+    attr.id                   = SAI_PORT_ATTR_PRIORITY_GROUP_LIST;
+    attr.value.objlist.count  = STUB_QOS_PRIORITY_GROUPS;
+    attr.value.objlist.list   = pgs;
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_port_api->get_port_attribute (port_oid (port), 1, &attr));
+    EXPECT_LT (pg, attr.value.objlist.count);
+
+    return pgs[pg];
+}
+
+/* Forwarded frames without data from a priority group of a port to a
+ * queue of another, in bursts */
+void saiStubBufferTest::enqueue (uint32_t in_port, uint32_t pg, uint32_t port, uint32_t queue, uint32_t count)
+{
+    stub_packet_t packets[STUB_DATAPLANE_BURST];
+    uint32_t      ii, burst;
+
+    for (; count > 0; count -= burst) {
+        burst = (count < STUB_DATAPLANE_BURST) ? count : STUB_DATAPLANE_BURST;
+        memset (packets, 0, sizeof (packets));
+        for (ii = 0; ii < burst; ii++) {
+            packets[ii].length         = FRAME_LEN;
+            packets[ii].in_port        = port_oid (in_port);
+            packets[ii].out_port       = port_oid (port);
+            packets[ii].packet_action  = SAI_PACKET_ACTION_FORWARD;
+            packets[ii].queue          = queue;
+            packets[ii].priority_group = pg;
+        }
+        ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_enqueue (burst, packets));
+    }
+}
+
+/* Send frames of a port one at a time, returns how many went */
+uint32_t saiStubBufferTest::transmit (uint32_t port, uint32_t count)
+{
+    uint32_t ii, sent = 0, one;
+
+    for (ii = 0; ii < count; ii++) {
+        EXPECT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_transmit (port_oid (port), FRAME_NS, LINE_RATE, &one));
+        sent += one;
+    }
+
+    return sent;
+}
+
+uint64_t saiStubBufferTest::queue_stat (sai_object_id_t queue_id, sai_queue_stat_counter_t counter)
+{
+    uint64_t value = 0;
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_queue_api->get_queue_stats (queue_id, &counter, 1, &value));
+
+    return value;
+}
+
+uint64_t saiStubBufferTest::pg_stat (sai_object_id_t pg_id, sai_ingress_priority_group_stat_counter_t counter)
+{
+    uint64_t value = 0;
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->get_ingress_priority_group_stats (pg_id, &counter, 1, &value));
+
+    return value;
+}
+
+uint64_t saiStubBufferTest::pool_stat (sai_object_id_t pool_id, sai_buffer_pool_stat_counter_t counter)
+{
+    uint64_t value = 0;
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->get_buffer_pool_stats (pool_id, &counter, 1, &value));
+
+    return value;
+}
+
+uint32_t saiStubBufferTest::pool_shared_size (sai_object_id_t pool_id)
+{
+    sai_attribute_t attr;
+
+    attr.id = SAI_BUFFER_POOL_ATTR_SHARED_SIZE;
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->get_buffer_pool_attr (pool_id, 1, &attr));
+
+    return attr.value.u32;
+}
+
+sai_object_id_t saiStubBufferTest::pool_create (sai_buffer_pool_type_t type, uint32_t size,
+                                                sai_buffer_threshold_mode_t mode)
+{
+    sai_object_id_t pool_id = SAI_NULL_OBJECT_ID;
+    sai_attribute_t attr[3];
+
+    attr[0].id        = SAI_BUFFER_POOL_ATTR_TYPE;
+    attr[0].value.s32 = type;
+    attr[1].id        = SAI_BUFFER_POOL_ATTR_SIZE;
+    attr[1].value.u32 = size;
+    attr[2].id        = SAI_BUFFER_POOL_ATTR_TH_MODE;
+    attr[2].value.s32 = mode;
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->create_buffer_pool (&pool_id, 3, attr));
+
+    return pool_id;
+}
+
+sai_object_id_t saiStubBufferTest::profile_create (sai_object_id_t pool_id, uint32_t size, bool dynamic,
+                                                   int32_t threshold, uint32_t xoff, uint32_t xon)
+{
+    sai_object_id_t profile_id = SAI_NULL_OBJECT_ID;
+    sai_attribute_t attr[5];
+
+    attr[0].id        = SAI_BUFFER_PROFILE_ATTR_POOL_ID;
+    attr[0].value.oid = pool_id;
+    attr[1].id        = SAI_BUFFER_PROFILE_ATTR_BUFFER_SIZE;
+    attr[1].value.u32 = size;
+    if (dynamic) {
+        attr[2].id       = SAI_BUFFER_PROFILE_ATTR_SHARED_DYNAMIC_TH;
+        attr[2].value.s8 = (int8_t)threshold;
+    } else {
+        attr[2].id        = SAI_BUFFER_PROFILE_ATTR_SHARED_STATIC_TH;
+        attr[2].value.u32 = (uint32_t)threshold;
+    }
+    attr[3].id        = SAI_BUFFER_PROFILE_ATTR_XOFF_TH;
+    attr[3].value.u32 = xoff;
+    attr[4].id        = SAI_BUFFER_PROFILE_ATTR_XON_TH;
+    attr[4].value.u32 = xon;
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->create_buffer_profile (&profile_id, 5, attr));
+
+    return profile_id;
+}
+
+void saiStubBufferTest::queue_profile_set (sai_object_id_t queue_id, sai_object_id_t profile_id)
+{
+    sai_attribute_t attr;
+
+    attr.id        = SAI_QUEUE_ATTR_BUFFER_PROFILE_ID;
+    attr.value.oid = profile_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_queue_api->set_queue_attribute (queue_id, &attr));
+}
+
+void saiStubBufferTest::pg_profile_set (sai_object_id_t pg_id, sai_object_id_t profile_id)
+{
+    sai_attribute_t attr;
+
+    attr.id        = SAI_INGRESS_PRIORITY_GROUP_ATTR_BUFFER_PROFILE;
+    attr.value.oid = profile_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->set_ingress_priority_group_attr (pg_id, &attr));
+}
+
+void saiStubBufferTest::SetUpTestCase (void)
+{
+    SetUpStubSwitch ();
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_PORT, (void **)&p_port_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_QUEUE, (void **)&p_queue_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_BUFFERS, (void **)&p_buffer_api));
+}
+
+/*
+ * Pools and profiles take values in range and read back as set. Binding
+ * sets reserved and headroom bytes aside from the shared size, needs a
+ * pool of the right type with room, and keeps the pool and the profile
+ * from being removed.
+ */
+TEST_F (saiStubBufferTest, buffer_attributes)
+{
+    sai_object_id_t pool_id, profile_id, bad_id, queue_id, pg_id;
+    sai_attribute_t attr[6];
+
+    attr[0].id = SAI_SWITCH_ATTR_TOTAL_BUFFER_SIZE;
+    attr[1].id = SAI_SWITCH_ATTR_INGRESS_BUFFER_POOL_NUM;
+    attr[2].id = SAI_SWITCH_ATTR_EGRESS_BUFFER_POOL_NUM;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->get_switch_attribute (3, attr));
+    EXPECT_EQ ((uint32_t)STUB_BUFFER_SIZE / 1024, attr[0].value.u32);
+    EXPECT_EQ ((uint32_t)STUB_BUFFER_POOLS, attr[1].value.u32);
+    EXPECT_EQ ((uint32_t)STUB_BUFFER_POOLS, attr[2].value.u32);
+
+    attr[0].id = SAI_PORT_ATTR_NUMBER_OF_PRIORITY_GROUPS;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->get_port_attribute (port_oid (1), 1, attr));
+    EXPECT_EQ ((uint32_t)STUB_QOS_PRIORITY_GROUPS, attr[0].value.u32);
+    EXPECT_NE (pg_oid (1, 0), pg_oid (1, 1));
+    EXPECT_NE (pg_oid (1, 0), pg_oid (2, 0));
+
+    /* Type and size are mandatory, in range */
+    attr[0].id        = SAI_BUFFER_POOL_ATTR_SIZE;
+    attr[0].value.u32 = 1024 * 1024;
+    EXPECT_EQ (SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING, p_buffer_api->create_buffer_pool (&bad_id, 1, attr));
+    attr[1].id        = SAI_BUFFER_POOL_ATTR_TYPE;
+    attr[1].value.s32 = 7;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0 + 1, p_buffer_api->create_buffer_pool (&bad_id, 2, attr));
+    attr[1].value.s32 = SAI_BUFFER_POOL_INGRESS;
+    attr[0].value.u32 = STUB_BUFFER_SIZE + 1;
+    EXPECT_EQ (SAI_STATUS_INSUFFICIENT_RESOURCES, p_buffer_api->create_buffer_pool (&bad_id, 2, attr));
+    attr[0].value.u32 = 0;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0, p_buffer_api->create_buffer_pool (&bad_id, 2, attr));
+
+    pool_id = pool_create (SAI_BUFFER_POOL_INGRESS, 1024 * 1024, SAI_BUFFER_THRESHOLD_MODE_DYNAMIC);
+    attr[0].id = SAI_BUFFER_POOL_ATTR_SHARED_SIZE;
+    attr[1].id = SAI_BUFFER_POOL_ATTR_TYPE;
+    attr[2].id = SAI_BUFFER_POOL_ATTR_SIZE;
+    attr[3].id = SAI_BUFFER_POOL_ATTR_TH_MODE;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->get_buffer_pool_attr (pool_id, 4, attr));
+    EXPECT_EQ (1024u * 1024, attr[0].value.u32);
+    EXPECT_EQ (SAI_BUFFER_POOL_INGRESS, attr[1].value.s32);
+    EXPECT_EQ (1024u * 1024, attr[2].value.u32);
+    EXPECT_EQ (SAI_BUFFER_THRESHOLD_MODE_DYNAMIC, attr[3].value.s32);
+
+    /* A dynamic pool takes a dynamic threshold, in range */
+    attr[0].id        = SAI_BUFFER_PROFILE_ATTR_POOL_ID;
+    attr[0].value.oid = pool_id;
+    attr[1].id        = SAI_BUFFER_PROFILE_ATTR_BUFFER_SIZE;
+    attr[1].value.u32 = 4096;
+    attr[2].id        = SAI_BUFFER_PROFILE_ATTR_SHARED_STATIC_TH;
+    attr[2].value.u32 = 4096;
+    EXPECT_EQ (SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING, p_buffer_api->create_buffer_profile (&bad_id, 3, attr));
+    attr[2].id       = SAI_BUFFER_PROFILE_ATTR_SHARED_DYNAMIC_TH;
+    attr[2].value.s8 = STUB_BUFFER_MAX_DYNAMIC_TH + 1;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0 + 2, p_buffer_api->create_buffer_profile (&bad_id, 3, attr));
+
+    profile_id = profile_create (pool_id, 4096, true, -2, 8192, 1024);
+    attr[0].id = SAI_BUFFER_PROFILE_ATTR_POOL_ID;
+    attr[1].id = SAI_BUFFER_PROFILE_ATTR_BUFFER_SIZE;
+    attr[2].id = SAI_BUFFER_PROFILE_ATTR_SHARED_DYNAMIC_TH;
+    attr[3].id = SAI_BUFFER_PROFILE_ATTR_XOFF_TH;
+    attr[4].id = SAI_BUFFER_PROFILE_ATTR_XON_TH;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->get_buffer_profile_attr (profile_id, 5, attr));
+    EXPECT_EQ (pool_id, attr[0].value.oid);
+    EXPECT_EQ (4096u, attr[1].value.u32);
+    EXPECT_EQ (-2, attr[2].value.s8);
+    EXPECT_EQ (8192u, attr[3].value.u32);
+    EXPECT_EQ (1024u, attr[4].value.u32);
+
+    /* Priority groups take profiles of ingress pools, queues of egress ones */
+    pg_id    = pg_oid (1, 2);
+    queue_id = queue_oid (1, 2);
+    attr[0].id        = SAI_QUEUE_ATTR_BUFFER_PROFILE_ID;
+    attr[0].value.oid = profile_id;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0, p_queue_api->set_queue_attribute (queue_id, &attr[0]));
+    pg_profile_set (pg_id, profile_id);
+    attr[0].id = SAI_INGRESS_PRIORITY_GROUP_ATTR_BUFFER_PROFILE;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->get_ingress_priority_group_attr (pg_id, 1, attr));
+    EXPECT_EQ (profile_id, attr[0].value.oid);
+    EXPECT_EQ (1024u * 1024 - 4096 - 8192, pool_shared_size (pool_id));
+
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_buffer_api->remove_buffer_profile (profile_id));
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_buffer_api->remove_buffer_pool (pool_id));
+
+    /* The pool can't shrink below, nor a profile grow beyond, what it holds */
+    attr[0].id        = SAI_BUFFER_POOL_ATTR_SIZE;
+    attr[0].value.u32 = 8192;
+    EXPECT_EQ (SAI_STATUS_INSUFFICIENT_RESOURCES, p_buffer_api->set_buffer_pool_attr (pool_id, &attr[0]));
+    attr[0].id        = SAI_BUFFER_PROFILE_ATTR_XOFF_TH;
+    attr[0].value.u32 = 2 * 1024 * 1024;
+    EXPECT_EQ (SAI_STATUS_INSUFFICIENT_RESOURCES, p_buffer_api->set_buffer_profile_attr (profile_id, &attr[0]));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->get_buffer_profile_attr (profile_id, 1, &attr[0]));
+    EXPECT_EQ (8192u, attr[0].value.u32);
+    EXPECT_EQ (1024u * 1024 - 4096 - 8192, pool_shared_size (pool_id));
+
+    /* Sizes follow the set */
+    attr[0].id        = SAI_BUFFER_PROFILE_ATTR_BUFFER_SIZE;
+    attr[0].value.u32 = 16384;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->set_buffer_profile_attr (profile_id, &attr[0]));
+    EXPECT_EQ (1024u * 1024 - 16384 - 8192, pool_shared_size (pool_id));
+    attr[0].id        = SAI_BUFFER_POOL_ATTR_SIZE;
+    attr[0].value.u32 = 512 * 1024;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->set_buffer_pool_attr (pool_id, &attr[0]));
+    EXPECT_EQ (512u * 1024 - 16384 - 8192, pool_shared_size (pool_id));
+
+    pg_profile_set (pg_id, SAI_NULL_OBJECT_ID);
+    EXPECT_EQ (512u * 1024, pool_shared_size (pool_id));
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_buffer_api->remove_buffer_pool (pool_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->remove_buffer_profile (profile_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->remove_buffer_pool (pool_id));
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_buffer_api->remove_buffer_pool (pool_id));
+}
+
+/*
+ * A queue of a static pool holds its reserved bytes and SHARED_STATIC_TH
+ * shared bytes, the frames beyond drop at its tail; the pool occupancy
+ * follows and keeps its watermark once the queue drains.
+ */
+TEST_F (saiStubBufferTest, static_threshold)
+{
+    sai_object_id_t pool_id, profile_id, queue_id;
+
+    queue_id   = queue_oid (4, 1);
+    pool_id    = pool_create (SAI_BUFFER_POOL_EGRESS, 1024 * 1024, SAI_BUFFER_THRESHOLD_MODE_STATIC);
+    profile_id = profile_create (pool_id, 2 * FRAME_LEN, false, 16 * FRAME_LEN, 0, 0);
+    queue_profile_set (queue_id, profile_id);
+
+    enqueue (3, 0, 4, 1, 100);
+    EXPECT_EQ (18u * FRAME_LEN, queue_stat (queue_id, SAI_QUEUE_STAT_CURR_OCCUPANCY_BYTES));
+    EXPECT_EQ (82u, queue_stat (queue_id, SAI_QUEUE_STAT_DROPPED_PACKETS));
+    EXPECT_EQ (18u * FRAME_LEN, pool_stat (pool_id, SAI_BUFFER_POOL_STAT_CURR_OCCUPANCY_BYTES));
+
+    EXPECT_EQ (18u, transmit (4, 20));
+    EXPECT_EQ (0u, pool_stat (pool_id, SAI_BUFFER_POOL_STAT_CURR_OCCUPANCY_BYTES));
+    EXPECT_EQ (18u * FRAME_LEN, pool_stat (pool_id, SAI_BUFFER_POOL_STAT_WATERMARK_BYTES));
+
+    /* Unbound, the queue is limited by its ring alone */
+    queue_profile_set (queue_id, SAI_NULL_OBJECT_ID);
+    enqueue (3, 0, 4, 1, 100);
+    EXPECT_EQ (100u * FRAME_LEN, queue_stat (queue_id, SAI_QUEUE_STAT_CURR_OCCUPANCY_BYTES));
+    EXPECT_EQ (100u, transmit (4, 100));
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->remove_buffer_profile (profile_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->remove_buffer_pool (pool_id));
+}
+
+/*
+ * With a dynamic threshold a queue may hold 2^n times the shared bytes
+ * still free: alone with n = 0 it takes half the pool, two congested
+ * queues a third each, and n = -1 leaves a lone queue a third.
+ */
+TEST_F (saiStubBufferTest, dynamic_threshold)
+{
+    sai_object_id_t pool_id, profile_id, queue_id[2];
+    sai_attribute_t attr;
+    uint64_t        occupancy;
+    uint32_t        ii;
+
+    queue_id[0] = queue_oid (6, 0);
+    queue_id[1] = queue_oid (6, 1);
+    /* 1024 cells, 256 frames */
+    pool_id     = pool_create (SAI_BUFFER_POOL_EGRESS, 256 * FRAME_LEN, SAI_BUFFER_THRESHOLD_MODE_DYNAMIC);
+    profile_id  = profile_create (pool_id, 0, true, 0, 0, 0);
+    queue_profile_set (queue_id[0], profile_id);
+    queue_profile_set (queue_id[1], profile_id);
+
+    enqueue (5, 0, 6, 0, 300);
+    EXPECT_EQ (128u * FRAME_LEN, queue_stat (queue_id[0], SAI_QUEUE_STAT_CURR_OCCUPANCY_BYTES));
+    EXPECT_EQ (128u, transmit (6, 130));
+
+    for (ii = 0; ii < 300; ii++) {
+        enqueue (5, 0, 6, ii % 2, 1);
+    }
+    for (ii = 0; ii < 2; ii++) {
+        occupancy = queue_stat (queue_id[ii], SAI_QUEUE_STAT_CURR_OCCUPANCY_BYTES);
+        EXPECT_GE (occupancy, 84u * FRAME_LEN);
+        EXPECT_LE (occupancy, 86u * FRAME_LEN);
+    }
+    EXPECT_LE (pool_stat (pool_id, SAI_BUFFER_POOL_STAT_WATERMARK_BYTES), 172u * FRAME_LEN);
+    EXPECT_GE (transmit (6, 180), 168u);
+
+    attr.id       = SAI_BUFFER_PROFILE_ATTR_SHARED_DYNAMIC_TH;
+    attr.value.s8 = -1;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->set_buffer_profile_attr (profile_id, &attr));
+    enqueue (5, 0, 6, 0, 300);
+    EXPECT_EQ (85u * FRAME_LEN, queue_stat (queue_id[0], SAI_QUEUE_STAT_CURR_OCCUPANCY_BYTES));
+    EXPECT_EQ (85u, transmit (6, 90));
+
+    queue_profile_set (queue_id[0], SAI_NULL_OBJECT_ID);
+    queue_profile_set (queue_id[1], SAI_NULL_OBJECT_ID);
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->remove_buffer_profile (profile_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->remove_buffer_pool (pool_id));
+}
+
+/*
+ * A priority group out of shared bytes asserts XOFF and takes what still
+ * arrives into its headroom, dropping what does not fit; it goes back to
+ * XON once its occupancy falls to XON_TH. Counters and watermarks follow,
+ * a clear restarts the watermarks from the occupancy.
+ */
+TEST_F (saiStubBufferTest, headroom_xoff)
+{
+    sai_object_id_t                           pool_id, profile_id, pg_id, queue_id;
+    sai_ingress_priority_group_stat_counter_t counters[2];
+    uint8_t                                   xoff;
+
+    pg_id      = pg_oid (8, 3);
+    queue_id   = queue_oid (9, 0);
+    pool_id    = pool_create (SAI_BUFFER_POOL_INGRESS, 1024 * 1024, SAI_BUFFER_THRESHOLD_MODE_STATIC);
+    profile_id = profile_create (pool_id, 0, false, 8 * FRAME_LEN, 4 * FRAME_LEN, 2 * FRAME_LEN);
+    pg_profile_set (pg_id, profile_id);
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_buffer_port_xoff (port_oid (8), &xoff));
+    EXPECT_EQ (0, xoff);
+
+    /* Other groups of the port are not limited */
+    enqueue (8, 2, 9, 0, 20);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_buffer_port_xoff (port_oid (8), &xoff));
+    EXPECT_EQ (0, xoff);
+    EXPECT_EQ (20u, transmit (9, 20));
+
+    enqueue (8, 3, 9, 0, 20);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_buffer_port_xoff (port_oid (8), &xoff));
+    EXPECT_EQ (1 << 3, xoff);
+    EXPECT_EQ (12u, pg_stat (pg_id, SAI_INGRESS_PRIORITY_GROUP_STAT_PACKETS));
+    EXPECT_EQ (12u * FRAME_LEN, pg_stat (pg_id, SAI_INGRESS_PRIORITY_GROUP_STAT_CURR_OCCUPANCY_BYTES));
+    EXPECT_EQ (12u * FRAME_LEN, pg_stat (pg_id, SAI_INGRESS_PRIORITY_GROUP_STAT_WATERMARK_BYTES));
+    EXPECT_EQ (8u, pg_stat (pg_id, (sai_ingress_priority_group_stat_counter_t)STUB_INGRESS_PRIORITY_GROUP_STAT_DROPPED_PACKETS));
+    EXPECT_EQ (4u * FRAME_LEN, pg_stat (pg_id,
+                                        (sai_ingress_priority_group_stat_counter_t)STUB_INGRESS_PRIORITY_GROUP_STAT_HEADROOM_OCCUPANCY_BYTES));
+    EXPECT_EQ (1u, pg_stat (pg_id, (sai_ingress_priority_group_stat_counter_t)STUB_INGRESS_PRIORITY_GROUP_STAT_XOFF_COUNT));
+    EXPECT_EQ (8u, queue_stat (queue_id, SAI_QUEUE_STAT_DROPPED_PACKETS));
+
+    /* Headroom drains first, XON at two frames */
+    EXPECT_EQ (4u, transmit (9, 4));
+    EXPECT_EQ (0u, pg_stat (pg_id,
+                            (sai_ingress_priority_group_stat_counter_t)STUB_INGRESS_PRIORITY_GROUP_STAT_HEADROOM_OCCUPANCY_BYTES));
+    EXPECT_EQ (4u * FRAME_LEN, pg_stat (pg_id,
+                                        (sai_ingress_priority_group_stat_counter_t)STUB_INGRESS_PRIORITY_GROUP_STAT_HEADROOM_WATERMARK_BYTES));
+    EXPECT_EQ (5u, transmit (9, 5));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_buffer_port_xoff (port_oid (8), &xoff));
+    EXPECT_EQ (1 << 3, xoff);
+    EXPECT_EQ (1u, transmit (9, 1));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_buffer_port_xoff (port_oid (8), &xoff));
+    EXPECT_EQ (0, xoff);
+
+    counters[0] = SAI_INGRESS_PRIORITY_GROUP_STAT_WATERMARK_BYTES;
+    counters[1] = (sai_ingress_priority_group_stat_counter_t)STUB_INGRESS_PRIORITY_GROUP_STAT_XOFF_COUNT;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->clear_ingress_priority_group_stats (pg_id, counters, 2));
+    EXPECT_EQ (2u * FRAME_LEN, pg_stat (pg_id, SAI_INGRESS_PRIORITY_GROUP_STAT_WATERMARK_BYTES));
+    EXPECT_EQ (0u, pg_stat (pg_id, (sai_ingress_priority_group_stat_counter_t)STUB_INGRESS_PRIORITY_GROUP_STAT_XOFF_COUNT));
+    counters[0] = (sai_ingress_priority_group_stat_counter_t)(SAI_INGRESS_PRIORITY_GROUP_STAT_WATERMARK_BYTES + 1);
+    EXPECT_EQ (SAI_STATUS_INVALID_PARAMETER, p_buffer_api->clear_ingress_priority_group_stats (pg_id, counters, 1));
+
+    EXPECT_EQ (2u, transmit (9, 2));
+    EXPECT_EQ (0u, pg_stat (pg_id, SAI_INGRESS_PRIORITY_GROUP_STAT_CURR_OCCUPANCY_BYTES));
+    EXPECT_EQ (0u, pool_stat (pool_id, SAI_BUFFER_POOL_STAT_CURR_OCCUPANCY_BYTES));
+
+    pg_profile_set (pg_id, SAI_NULL_OBJECT_ID);
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->remove_buffer_profile (profile_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->remove_buffer_pool (pool_id));
+}
+
+/*
+ * Frames queued and sent through a priority group and a queue both bound
+ * to profiles, the buffer admission and release on every frame.
+ */
+TEST_F (saiStubBufferTest, buffer_rate)
+{
+    stub_packet_t   packets[STUB_DATAPLANE_BURST];
+    sai_object_id_t pool_id[2], profile_id[2], pg_id, queue_id;
+    uint32_t        ii, jj, count, sent = 0;
+
+    pg_id         = pg_oid (20, 0);
+    queue_id      = queue_oid (21, 0);
+    pool_id[0]    = pool_create (SAI_BUFFER_POOL_INGRESS, 1024 * 1024, SAI_BUFFER_THRESHOLD_MODE_DYNAMIC);
+    pool_id[1]    = pool_create (SAI_BUFFER_POOL_EGRESS, 1024 * 1024, SAI_BUFFER_THRESHOLD_MODE_DYNAMIC);
+    profile_id[0] = profile_create (pool_id[0], 4096, true, 0, 16384, 8192);
+    profile_id[1] = profile_create (pool_id[1], 4096, true, 0, 0, 0);
+    pg_profile_set (pg_id, profile_id[0]);
+    queue_profile_set (queue_id, profile_id[1]);
+
+    /* 2048 bytes a burst, 1250 sent */
+    memset (packets, 0, sizeof (packets));
+    for (ii = 0; ii < STUB_DATAPLANE_BURST; ii++) {
+        packets[ii].length        = 64;
+        packets[ii].in_port       = port_oid (20);
+        packets[ii].out_port      = port_oid (21);
+        packets[ii].packet_action = SAI_PACKET_ACTION_FORWARD;
+    }
+
+    auto start = std::chrono::steady_clock::now ();
+    for (jj = 0; jj < 100000; jj++) {
+        stub_scheduler_enqueue (STUB_DATAPLANE_BURST, packets);
+        stub_scheduler_transmit (port_oid (21), 100, 10 * LINE_RATE, &count);
+        sent += count;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now () - start;
+    printf ("buffer: %.1f Mpps offered, %.1f Mpps sent\n", 100000.0 * STUB_DATAPLANE_BURST / elapsed.count () / 1e6,
+            sent / elapsed.count () / 1e6);
+
+    EXPECT_GT (sent, 0u);
+    EXPECT_EQ (queue_stat (queue_id, SAI_QUEUE_STAT_DROPPED_PACKETS),
+               100000u * STUB_DATAPLANE_BURST - sent - queue_stat (queue_id, SAI_QUEUE_STAT_CURR_OCCUPANCY_BYTES) / 64);
+    EXPECT_EQ (pg_stat (pg_id, SAI_INGRESS_PRIORITY_GROUP_STAT_CURR_OCCUPANCY_BYTES),
+               queue_stat (queue_id, SAI_QUEUE_STAT_CURR_OCCUPANCY_BYTES) / 64 * STUB_BUFFER_CELL_SIZE);
+
+    while (queue_stat (queue_id, SAI_QUEUE_STAT_CURR_OCCUPANCY_BYTES) > 0) {
+        stub_scheduler_transmit (port_oid (21), 100000, LINE_RATE, &count);
+    }
+    EXPECT_EQ (0u, pool_stat (pool_id[0], SAI_BUFFER_POOL_STAT_CURR_OCCUPANCY_BYTES));
+    EXPECT_EQ (0u, pool_stat (pool_id[1], SAI_BUFFER_POOL_STAT_CURR_OCCUPANCY_BYTES));
+
+    pg_profile_set (pg_id, SAI_NULL_OBJECT_ID);
+    queue_profile_set (queue_id, SAI_NULL_OBJECT_ID);
+    for (ii = 0; ii < 2; ii++) {
+        EXPECT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->remove_buffer_profile (profile_id[ii]));
+        EXPECT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->remove_buffer_pool (pool_id[ii]));
+    }
+}
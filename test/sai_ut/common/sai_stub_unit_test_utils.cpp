@@ -0,0 +1,102 @@
+/************************************************************************
+*    Licensed under the Apache License, Version 2.0 (the "License"); you may
+*    not use this file except in compliance with the License. You may obtain
+*    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+*
+*    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+*    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+*    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+*    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+*
+*    See the Apache Version 2.0 License for specific language governing
+*    permissions and limitations under the License.
+*
+*
+* Module Name:
+*
+*    sai_stub_unit_test_utils.cpp
+*
+* Abstract:
+*
+*    This file contains the switch setup shared by the stub unit-tests.
+*
+*************************************************************************/
+
+#include "common/sai_stub_unit_test_utils.h"
+
+#include <map>
+#include <string>
+
+extern "C" {
+#include <string.h>
+}
+
+sai_switch_api_t* saiStubTest::p_switch_api = NULL;
+uint32_t saiStubTest::port_count = 0;
+sai_object_id_t saiStubTest::port_list[SAI_STUB_TEST_MAX_PORTS];
+
+static std::map<std::string, std::string> stub_test_profile;
+
+static const char* stub_test_profile_get_value (sai_switch_profile_id_t profile_id,
+                                                const char* variable)
+{
+    std::map<std::string, std::string>::const_iterator it;
+
+    if (NULL == variable) {
+        return NULL;
+    }
+
+    it = stub_test_profile.find (variable);
+
+    return (it == stub_test_profile.end ()) ? NULL : it->second.c_str ();
+}
+
+static int stub_test_profile_get_next_value (sai_switch_profile_id_t profile_id,
+                                             const char** variable,
+                                             const char** value)
+{
+    return -1;
+}
+
+static const service_method_table_t stub_test_services =
+{
+    stub_test_profile_get_value,
+    stub_test_profile_get_next_value
+};
+
+void saiStubTest::profile_value_set (const char *variable, const char *value)
+{
+    stub_test_profile[variable] = value;
+}
+
+void saiStubTest::SetUpStubSwitch (const sai_switch_notification_t *notification)
+{
+    sai_switch_notification_t notify;
+    sai_attribute_t           attr;
+    char                      hw_id[] = "0xb850";
+    char                      firmware[] = "";
+
+    memset (&notify, 0, sizeof (notify));
+    if (NULL != notification) {
+        notify = *notification;
+    }
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_initialize (0, &stub_test_services));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_SWITCH, (void **)&p_switch_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS,
+               p_switch_api->initialize_switch (0, hw_id, firmware, &notify));
+
+    memset (&attr, 0, sizeof (attr));
+    attr.id                  = SAI_SWITCH_ATTR_PORT_LIST;
+    attr.value.objlist.count = SAI_STUB_TEST_MAX_PORTS;
+    attr.value.objlist.list  = port_list;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->get_switch_attribute (1, &attr));
+
+    port_count = attr.value.objlist.count;
+    ASSERT_NE (0, port_count);
+}
+
+sai_object_id_t saiStubTest::port_oid (uint32_t index)
+{
+    return (index < port_count) ? port_list[index] : 0;
+}
@@ -0,0 +1,59 @@
+/************************************************************************
+*    Licensed under the Apache License, Version 2.0 (the "License"); you may
+*    not use this file except in compliance with the License. You may obtain
+*    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+*
+*    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+*    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+*    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+*    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+*
+*    See the Apache Version 2.0 License for specific language governing
+*    permissions and limitations under the License.
+*
+*
+* Module Name:
+*
+*    sai_stub_unit_test_utils.h
+*
+* Abstract:
+*
+*    This contains the base class shared by the stub unit-tests. It owns
+*    the profile service table, brings the switch up once per test case
+*    and hands out the switch port ids.
+*
+*************************************************************************/
+
+#ifndef __SAI_STUB_UNIT_TEST_UTILS_H__
+#define __SAI_STUB_UNIT_TEST_UTILS_H__
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "sai.h"
+#include "saitypes.h"
+#include "saistatus.h"
+#include "saiswitch.h"
+}
+
+class saiStubTest : public ::testing::Test
+{
+    public:
+        /* Profile value seen by the switch, set before SetUpStubSwitch */
+        static void profile_value_set (const char *variable, const char *value);
+
+        /* Initialize the SAI API, bring the switch up and read its ports */
+        static void SetUpStubSwitch (const sai_switch_notification_t *notification = NULL);
+
+        /* Port at index of the switch port list, 0 when out of range */
+        static sai_object_id_t port_oid (uint32_t index);
+
+    protected:
+        static const uint32_t SAI_STUB_TEST_MAX_PORTS = 256;
+
+        static sai_switch_api_t *p_switch_api;
+        static uint32_t          port_count;
+        static sai_object_id_t   port_list[SAI_STUB_TEST_MAX_PORTS];
+};
+
+#endif /* __SAI_STUB_UNIT_TEST_UTILS_H__ */
@@ -0,0 +1,538 @@
+/************************************************************************
+*    Licensed under the Apache License, Version 2.0 (the "License"); you may
+*    not use this file except in compliance with the License. You may obtain
+*    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+*
+*    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+*    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+*    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+*    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+*
+*    See the Apache Version 2.0 License for specific language governing
+*    permissions and limitations under the License.
+*
+*
+* Module Name:
+*
+*    sai_mt_stress_unit_test.cpp
+*
+* Abstract:
+*
+*    This file contains multi-threaded stress tests for the SAI object
+*    tables. Several threads issue create/remove/set/get calls at the
+*    same time and the tests verify that no update is lost, no object
+*    id is handed out twice and readers always see consistent entries.
+*
+*************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/sai_stub_unit_test_utils.h"
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "sai.h"
+#include "saitypes.h"
+#include "saistatus.h"
+#include "saiswitch.h"
+#include "saivlan.h"
+#include "saifdb.h"
+#include "sainexthop.h"
+#include "sainexthopgroup.h"
+#include "sairouter.h"
+#include "sairoute.h"
+#include "saineighbor.h"
+#include <arpa/inet.h>
+#include <string.h>
+}
+
+#define SAI_MT_THREADS          8
+#define SAI_MT_ITERATIONS       2000
+#define SAI_MT_SHARED_FDB_COUNT 64
+#define SAI_MT_NH_COUNT         16
+#define SAI_MT_ROUTE_COUNT      256
+
+class saiMtStressTest : public saiStubTest
+{
+    protected:
+        static void SetUpTestCase (void);
+
+        static void fdb_entry_init (sai_fdb_entry_t *entry, uint32_t thread,
+                                    uint32_t index);
+        static sai_status_t fdb_create (const sai_fdb_entry_t *entry,
+                                        sai_object_id_t port);
+
+        static sai_vlan_api_t           *p_vlan_api;
+        static sai_fdb_api_t            *p_fdb_api;
+        static sai_next_hop_api_t       *p_nh_api;
+        static sai_next_hop_group_api_t *p_nhg_api;
+        static sai_virtual_router_api_t *p_vr_api;
+        static sai_route_api_t          *p_route_api;
+        static sai_neighbor_api_t       *p_neighbor_api;
+};
+
+sai_vlan_api_t* saiMtStressTest::p_vlan_api = NULL;
+sai_fdb_api_t* saiMtStressTest::p_fdb_api = NULL;
+sai_next_hop_api_t* saiMtStressTest::p_nh_api = NULL;
+sai_next_hop_group_api_t* saiMtStressTest::p_nhg_api = NULL;
+sai_virtual_router_api_t* saiMtStressTest::p_vr_api = NULL;
+sai_route_api_t* saiMtStressTest::p_route_api = NULL;
+sai_neighbor_api_t* saiMtStressTest::p_neighbor_api = NULL;
+
+void saiMtStressTest::SetUpTestCase (void)
+{
+    SetUpStubSwitch ();
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS,
+               sai_api_query (SAI_API_VLAN, (void **)&p_vlan_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS,
+               sai_api_query (SAI_API_FDB, (void **)&p_fdb_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS,
+               sai_api_query (SAI_API_NEXT_HOP, (void **)&p_nh_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS,
+               sai_api_query (SAI_API_NEXT_HOP_GROUP, (void **)&p_nhg_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS,
+               sai_api_query (SAI_API_VIRTUAL_ROUTER, (void **)&p_vr_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS,
+               sai_api_query (SAI_API_ROUTE, (void **)&p_route_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS,
+               sai_api_query (SAI_API_NEIGHBOR, (void **)&p_neighbor_api));
+}
+
+void saiMtStressTest::fdb_entry_init (sai_fdb_entry_t *entry, uint32_t thread,
+                                      uint32_t index)
+{
+    memset (entry, 0, sizeof (*entry));
+
+    entry->mac_address[0] = 0x02;
+    entry->mac_address[1] = (uint8_t) thread;
+    entry->mac_address[2] = (uint8_t) (index >> 16);
+    entry->mac_address[3] = (uint8_t) (index >> 8);
+    entry->mac_address[4] = (uint8_t) index;
+    entry->vlan_id        = 1;
+}
+
+sai_status_t saiMtStressTest::fdb_create (const sai_fdb_entry_t *entry,
+                                          sai_object_id_t port)
+{
+    sai_attribute_t attr[3];
+
+    memset (attr, 0, sizeof (attr));
+
+    attr[0].id        = SAI_FDB_ENTRY_ATTR_TYPE;
+    attr[0].value.s32 = SAI_FDB_ENTRY_STATIC;
+    attr[1].id        = SAI_FDB_ENTRY_ATTR_PORT_ID;
+    attr[1].value.oid = port;
+    attr[2].id        = SAI_FDB_ENTRY_ATTR_PACKET_ACTION;
+    attr[2].value.s32 = SAI_PACKET_ACTION_FORWARD;
+
+    return p_fdb_api->create_fdb_entry (entry, 3, attr);
+}
+
+/*
+ * Concurrent object creation must never hand out the same object id twice.
+ */
+TEST_F (saiMtStressTest, unique_oid_allocation)
+{
+    std::vector<std::vector<sai_object_id_t> > oids (SAI_MT_THREADS);
+    std::vector<std::thread>                   threads;
+    std::set<sai_object_id_t>                  all_oids;
+
+    for (uint32_t t = 0; t < SAI_MT_THREADS; t++) {
+        threads.push_back (std::thread ([&oids, t] () {
+            sai_object_id_t vr_id;
+
+            for (uint32_t i = 0; i < SAI_MT_ITERATIONS; i++) {
+                if (SAI_STATUS_SUCCESS ==
+                    p_vr_api->create_virtual_router (&vr_id, 0, NULL)) {
+                    oids[t].push_back (vr_id);
+                }
+            }
+        }));
+    }
+
+    for (auto &thread : threads) {
+        thread.join ();
+    }
+
+    for (auto &list : oids) {
+        EXPECT_EQ ((size_t) SAI_MT_ITERATIONS, list.size ());
+        all_oids.insert (list.begin (), list.end ());
+    }
+
+    EXPECT_EQ ((size_t) SAI_MT_THREADS * SAI_MT_ITERATIONS, all_oids.size ());
+}
+
+/*
+ * Writers add/remove private FDB entries while readers keep querying a
+ * shared set of entries. Readers must always find the shared entries
+ * with their original port.
+ */
+TEST_F (saiMtStressTest, fdb_concurrent_readers_and_writers)
+{
+    std::vector<std::thread> threads;
+    std::atomic<uint32_t>    errors (0);
+    std::atomic<bool>        writers_done (false);
+    sai_fdb_entry_t          entry;
+
+    for (uint32_t i = 0; i < SAI_MT_SHARED_FDB_COUNT; i++) {
+        fdb_entry_init (&entry, 0xFF, i);
+        ASSERT_EQ (SAI_STATUS_SUCCESS, fdb_create (&entry, port_oid (i % 32)));
+    }
+
+    for (uint32_t t = 0; t < SAI_MT_THREADS / 2; t++) {
+        threads.push_back (std::thread ([&errors, t] () {
+            sai_fdb_entry_t fdb_entry;
+            sai_attribute_t attr;
+
+            for (uint32_t i = 0; i < SAI_MT_ITERATIONS; i++) {
+                fdb_entry_init (&fdb_entry, t, i);
+
+                if (SAI_STATUS_SUCCESS != fdb_create (&fdb_entry, port_oid (t))) {
+                    errors++;
+                    continue;
+                }
+
+                attr.id = SAI_FDB_ENTRY_ATTR_PORT_ID;
+                if ((SAI_STATUS_SUCCESS !=
+                     p_fdb_api->get_fdb_entry_attribute (&fdb_entry, 1, &attr)) ||
+                    (attr.value.oid != port_oid (t))) {
+                    errors++;
+                }
+
+                if (SAI_STATUS_SUCCESS != p_fdb_api->remove_fdb_entry (&fdb_entry)) {
+                    errors++;
+                }
+            }
+        }));
+    }
+
+    for (uint32_t t = 0; t < SAI_MT_THREADS / 2; t++) {
+        threads.push_back (std::thread ([&errors, &writers_done] () {
+            sai_fdb_entry_t fdb_entry;
+            sai_attribute_t attr;
+            uint32_t        i = 0;
+
+            while (!writers_done.load ()) {
+                fdb_entry_init (&fdb_entry, 0xFF, i % SAI_MT_SHARED_FDB_COUNT);
+
+                attr.id = SAI_FDB_ENTRY_ATTR_PORT_ID;
+                if ((SAI_STATUS_SUCCESS !=
+                     p_fdb_api->get_fdb_entry_attribute (&fdb_entry, 1, &attr)) ||
+                    (attr.value.oid != port_oid ((i % SAI_MT_SHARED_FDB_COUNT) % 32))) {
+                    errors++;
+                }
+                i++;
+            }
+        }));
+    }
+
+    for (uint32_t t = 0; t < SAI_MT_THREADS / 2; t++) {
+        threads[t].join ();
+    }
+    writers_done = true;
+    for (uint32_t t = SAI_MT_THREADS / 2; t < SAI_MT_THREADS; t++) {
+        threads[t].join ();
+    }
+
+    EXPECT_EQ (0u, errors.load ());
+
+    /* Private entries are gone, shared ones are flushed by port */
+    fdb_entry_init (&entry, 0, 0);
+    EXPECT_EQ (SAI_STATUS_ITEM_NOT_FOUND, p_fdb_api->remove_fdb_entry (&entry));
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_fdb_api->flush_fdb_entries (0, NULL));
+
+    fdb_entry_init (&entry, 0xFF, 0);
+    EXPECT_EQ (SAI_STATUS_ITEM_NOT_FOUND, p_fdb_api->remove_fdb_entry (&entry));
+}
+
+/*
+ * Membership updates on a shared next hop group must keep the count and
+ * the list consistent for concurrent readers.
+ */
+TEST_F (saiMtStressTest, next_hop_group_member_updates)
+{
+    std::vector<std::thread> threads;
+    std::atomic<uint32_t>    errors (0);
+    std::atomic<bool>        writers_done (false);
+    sai_object_id_t          nh_list[SAI_MT_NH_COUNT];
+    sai_object_id_t          nhg_id;
+    sai_attribute_t          attr[3];
+
+    memset (attr, 0, sizeof (attr));
+
+    for (uint32_t i = 0; i < SAI_MT_NH_COUNT; i++) {
+        attr[0].id                       = SAI_NEXT_HOP_ATTR_TYPE;
+        attr[0].value.s32                = SAI_NEXT_HOP_IP;
+        attr[1].id                       = SAI_NEXT_HOP_ATTR_IP;
+        attr[1].value.ipaddr.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+        attr[1].value.ipaddr.addr.ip4    = htonl (0x0A000001 + i);
+        attr[2].id                       = SAI_NEXT_HOP_ATTR_ROUTER_INTERFACE_ID;
+        attr[2].value.oid                = SAI_OBJECT_TYPE_ROUTER_INTERFACE;
+
+        ASSERT_EQ (SAI_STATUS_SUCCESS,
+                   p_nh_api->create_next_hop (&nh_list[i], 3, attr));
+    }
+
+    attr[0].id                     = SAI_NEXT_HOP_GROUP_ATTR_TYPE;
+    attr[0].value.s32              = SAI_NEXT_HOP_GROUP_ECMP;
+    attr[1].id                     = SAI_NEXT_HOP_GROUP_ATTR_NEXT_HOP_LIST;
+    attr[1].value.objlist.count    = 1;
+    attr[1].value.objlist.list     = nh_list;
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS,
+               p_nhg_api->create_next_hop_group (&nhg_id, 2, attr));
+
+    /* Each writer owns one next hop and toggles its membership */
+    for (uint32_t t = 1; t < SAI_MT_THREADS; t++) {
+        threads.push_back (std::thread ([&errors, &nh_list, nhg_id, t] () {
+            for (uint32_t i = 0; i < SAI_MT_ITERATIONS; i++) {
+                if ((SAI_STATUS_SUCCESS !=
+                     p_nhg_api->add_next_hop_to_group (nhg_id, 1, &nh_list[t])) ||
+                    (SAI_STATUS_SUCCESS !=
+                     p_nhg_api->remove_next_hop_from_group (nhg_id, 1, &nh_list[t]))) {
+                    errors++;
+                }
+            }
+        }));
+    }
+
+    threads.push_back (std::thread ([&errors, &writers_done, nhg_id] () {
+        sai_object_id_t list[SAI_MT_NH_COUNT];
+        sai_attribute_t get_attr[2];
+
+        while (!writers_done.load ()) {
+            get_attr[0].id                  = SAI_NEXT_HOP_GROUP_ATTR_NEXT_HOP_COUNT;
+            get_attr[1].id                  = SAI_NEXT_HOP_GROUP_ATTR_NEXT_HOP_LIST;
+            get_attr[1].value.objlist.count = SAI_MT_NH_COUNT;
+            get_attr[1].value.objlist.list  = list;
+
+            if ((SAI_STATUS_SUCCESS !=
+                 p_nhg_api->get_next_hop_group_attribute (nhg_id, 2, get_attr)) ||
+                (get_attr[0].value.u32 != get_attr[1].value.objlist.count) ||
+                (get_attr[0].value.u32 < 1) ||
+                (get_attr[0].value.u32 > SAI_MT_THREADS)) {
+                errors++;
+                continue;
+            }
+
+            for (uint32_t i = 0; i < get_attr[1].value.objlist.count; i++) {
+                if (SAI_OBJECT_TYPE_NEXT_HOP != sai_object_type_query (list[i])) {
+                    errors++;
+                }
+            }
+        }
+    }));
+
+    for (uint32_t t = 0; t < SAI_MT_THREADS - 1; t++) {
+        threads[t].join ();
+    }
+    writers_done = true;
+    threads.back ().join ();
+
+    EXPECT_EQ (0u, errors.load ());
+
+    attr[0].id = SAI_NEXT_HOP_GROUP_ATTR_NEXT_HOP_COUNT;
+    ASSERT_EQ (SAI_STATUS_SUCCESS,
+               p_nhg_api->get_next_hop_group_attribute (nhg_id, 1, attr));
+    EXPECT_EQ (1u, attr[0].value.u32);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_nhg_api->remove_next_hop_group (nhg_id));
+}
+
+/*
+ * Concurrent VLAN create/remove and membership changes on private VLANs.
+ */
+TEST_F (saiMtStressTest, vlan_create_remove)
+{
+    std::vector<std::thread> threads;
+    std::atomic<uint32_t>    errors (0);
+
+    for (uint32_t t = 0; t < SAI_MT_THREADS; t++) {
+        threads.push_back (std::thread ([&errors, t] () {
+            sai_vlan_id_t   vlan_id = (sai_vlan_id_t) (100 + t);
+            sai_vlan_port_t port;
+
+            port.port_id      = port_oid (t);
+            port.tagging_mode = SAI_VLAN_PORT_TAGGED;
+
+            for (uint32_t i = 0; i < SAI_MT_ITERATIONS / 4; i++) {
+                if ((SAI_STATUS_SUCCESS != p_vlan_api->create_vlan (vlan_id)) ||
+                    (SAI_STATUS_SUCCESS != p_vlan_api->add_ports_to_vlan (vlan_id, 1, &port)) ||
+                    (SAI_STATUS_SUCCESS != p_vlan_api->remove_ports_from_vlan (vlan_id, 1, &port)) ||
+                    (SAI_STATUS_SUCCESS != p_vlan_api->remove_vlan (vlan_id))) {
+                    errors++;
+                }
+            }
+        }));
+    }
+
+    for (auto &thread : threads) {
+        thread.join ();
+    }
+
+    EXPECT_EQ (0u, errors.load ());
+
+    /* Default VLAN survived all the resizing */
+    EXPECT_EQ (SAI_STATUS_INVALID_VLAN_ID, p_vlan_api->create_vlan (1));
+}
+
+/*
+ * Route and neighbor readers are lock-free: they must keep finding the
+ * stable entries with consistent data while a writer reloads a second
+ * set of routes and rewrites the neighbors underneath them.
+ */
+TEST_F (saiMtStressTest, route_neighbor_reads_during_reload)
+{
+    std::vector<std::thread>  threads;
+    std::atomic<uint32_t>     errors (0);
+    std::atomic<bool>         writer_done (false);
+    sai_unicast_route_entry_t route;
+    sai_neighbor_entry_t      neighbor;
+    sai_object_id_t           vr_id;
+    sai_object_id_t           nh_id;
+    sai_attribute_t           attr[3];
+    const sai_object_id_t     rif_id = SAI_OBJECT_TYPE_ROUTER_INTERFACE;
+
+    memset (attr, 0, sizeof (attr));
+    memset (&route, 0, sizeof (route));
+    memset (&neighbor, 0, sizeof (neighbor));
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vr_api->create_virtual_router (&vr_id, 0, NULL));
+
+    attr[0].id                       = SAI_NEXT_HOP_ATTR_TYPE;
+    attr[0].value.s32                = SAI_NEXT_HOP_IP;
+    attr[1].id                       = SAI_NEXT_HOP_ATTR_IP;
+    attr[1].value.ipaddr.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+    attr[1].value.ipaddr.addr.ip4    = htonl (0x0B000001);
+    attr[2].id                       = SAI_NEXT_HOP_ATTR_ROUTER_INTERFACE_ID;
+    attr[2].value.oid                = rif_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_nh_api->create_next_hop (&nh_id, 3, attr));
+
+    /* Stable set: 20.<i>.0.0/16 routes and 20.0.<i>.1 neighbors */
+    route.vr_id                               = vr_id;
+    route.destination.addr_family             = SAI_IP_ADDR_FAMILY_IPV4;
+    route.destination.mask.ip4                = htonl (0xFFFF0000);
+    neighbor.rif_id                           = rif_id;
+    neighbor.ip_address.addr_family           = SAI_IP_ADDR_FAMILY_IPV4;
+
+    for (uint32_t i = 0; i < SAI_MT_ROUTE_COUNT; i++) {
+        route.destination.addr.ip4 = htonl (0x14000000 | (i << 16));
+        attr[0].id                 = SAI_ROUTE_ATTR_NEXT_HOP_ID;
+        attr[0].value.oid          = nh_id;
+        ASSERT_EQ (SAI_STATUS_SUCCESS, p_route_api->create_route (&route, 1, attr));
+
+        neighbor.ip_address.addr.ip4 = htonl (0x14000001 | (i << 8));
+        attr[0].id                   = SAI_NEIGHBOR_ATTR_DST_MAC_ADDRESS;
+        memset (attr[0].value.mac, (int) (i & 0xFF), sizeof (sai_mac_t));
+        ASSERT_EQ (SAI_STATUS_SUCCESS, p_neighbor_api->create_neighbor_entry (&neighbor, 1, attr));
+    }
+
+    /* Writer reloads 30.<i>.0.0/16 and rewrites the stable neighbors' action */
+    threads.push_back (std::thread ([&errors, vr_id, nh_id, rif_id] () {
+        sai_unicast_route_entry_t w_route;
+        sai_neighbor_entry_t      w_neighbor;
+        sai_attribute_t           w_attr;
+
+        memset (&w_route, 0, sizeof (w_route));
+        memset (&w_neighbor, 0, sizeof (w_neighbor));
+        memset (&w_attr, 0, sizeof (w_attr));
+
+        w_route.vr_id                      = vr_id;
+        w_route.destination.addr_family    = SAI_IP_ADDR_FAMILY_IPV4;
+        w_route.destination.mask.ip4       = htonl (0xFFFF0000);
+        w_neighbor.rif_id                  = rif_id;
+        w_neighbor.ip_address.addr_family  = SAI_IP_ADDR_FAMILY_IPV4;
+
+        for (uint32_t pass = 0; pass < SAI_MT_ITERATIONS / SAI_MT_ROUTE_COUNT + 1; pass++) {
+            for (uint32_t i = 0; i < SAI_MT_ROUTE_COUNT; i++) {
+                w_route.destination.addr.ip4 = htonl (0x1E000000 | (i << 16));
+                w_attr.id                    = SAI_ROUTE_ATTR_NEXT_HOP_ID;
+                w_attr.value.oid             = nh_id;
+                if (SAI_STATUS_SUCCESS != p_route_api->create_route (&w_route, 1, &w_attr)) {
+                    errors++;
+                }
+
+                w_neighbor.ip_address.addr.ip4 = htonl (0x14000001 | (i << 8));
+                w_attr.id                      = SAI_NEIGHBOR_ATTR_PACKET_ACTION;
+                w_attr.value.s32               = (pass & 1) ? SAI_PACKET_ACTION_FORWARD :
+                                                              SAI_PACKET_ACTION_TRAP;
+                if (SAI_STATUS_SUCCESS != p_neighbor_api->set_neighbor_attribute (&w_neighbor, &w_attr)) {
+                    errors++;
+                }
+            }
+
+            for (uint32_t i = 0; i < SAI_MT_ROUTE_COUNT; i++) {
+                w_route.destination.addr.ip4 = htonl (0x1E000000 | (i << 16));
+                if (SAI_STATUS_SUCCESS != p_route_api->remove_route (&w_route)) {
+                    errors++;
+                }
+            }
+        }
+    }));
+
+    for (uint32_t t = 1; t < SAI_MT_THREADS; t++) {
+        threads.push_back (std::thread ([&errors, &writer_done, vr_id, nh_id, rif_id, t] () {
+            sai_unicast_route_entry_t r_route;
+            sai_neighbor_entry_t      r_neighbor;
+            sai_attribute_t           r_attr[2];
+            uint32_t                  i = t;
+
+            memset (&r_route, 0, sizeof (r_route));
+            memset (&r_neighbor, 0, sizeof (r_neighbor));
+
+            r_route.vr_id                     = vr_id;
+            r_route.destination.addr_family   = SAI_IP_ADDR_FAMILY_IPV4;
+            r_route.destination.mask.ip4      = htonl (0xFFFF0000);
+            r_neighbor.rif_id                 = rif_id;
+            r_neighbor.ip_address.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+
+            while (!writer_done.load ()) {
+                uint32_t index = i++ % SAI_MT_ROUTE_COUNT;
+
+                r_route.destination.addr.ip4 = htonl (0x14000000 | (index << 16));
+                r_attr[0].id                 = SAI_ROUTE_ATTR_NEXT_HOP_ID;
+                r_attr[1].id                 = SAI_ROUTE_ATTR_PACKET_ACTION;
+                if ((SAI_STATUS_SUCCESS != p_route_api->get_route_attribute (&r_route, 2, r_attr)) ||
+                    (r_attr[0].value.oid != nh_id) ||
+                    (r_attr[1].value.s32 != SAI_PACKET_ACTION_FORWARD)) {
+                    errors++;
+                }
+
+                r_neighbor.ip_address.addr.ip4 = htonl (0x14000001 | (index << 8));
+                r_attr[0].id                   = SAI_NEIGHBOR_ATTR_DST_MAC_ADDRESS;
+                r_attr[1].id                   = SAI_NEIGHBOR_ATTR_PACKET_ACTION;
+                if ((SAI_STATUS_SUCCESS !=
+                     p_neighbor_api->get_neighbor_attribute (&r_neighbor, 2, r_attr)) ||
+                    (r_attr[0].value.mac[5] != (uint8_t) index) ||
+                    ((r_attr[1].value.s32 != SAI_PACKET_ACTION_FORWARD) &&
+                     (r_attr[1].value.s32 != SAI_PACKET_ACTION_TRAP))) {
+                    errors++;
+                }
+            }
+        }));
+    }
+
+    threads[0].join ();
+    writer_done = true;
+    for (uint32_t t = 1; t < SAI_MT_THREADS; t++) {
+        threads[t].join ();
+    }
+
+    EXPECT_EQ (0u, errors.load ());
+
+    /* Reloaded routes are gone, host bits are ignored on lookup */
+    route.destination.addr.ip4 = htonl (0x1E000000);
+    EXPECT_EQ (SAI_STATUS_ITEM_NOT_FOUND, p_route_api->remove_route (&route));
+    route.destination.addr.ip4 = htonl (0x14000001);
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_route_api->remove_route (&route));
+    EXPECT_EQ (SAI_STATUS_ITEM_NOT_FOUND, p_route_api->remove_route (&route));
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_neighbor_api->remove_all_neighbor_entries ());
+    neighbor.ip_address.addr.ip4 = htonl (0x14000001);
+    EXPECT_EQ (SAI_STATUS_ITEM_NOT_FOUND, p_neighbor_api->remove_neighbor_entry (&neighbor));
+}
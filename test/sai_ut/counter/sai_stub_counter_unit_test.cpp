@@ -0,0 +1,561 @@
+/************************************************************************
+*    Licensed under the Apache License, Version 2.0 (the "License"); you may
+*    not use this file except in compliance with the License. You may obtain
+*    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+*
+*    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+*    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+*    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+*    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+*
+*    See the Apache Version 2.0 License for specific language governing
+*    permissions and limitations under the License.
+*
+*
+* Module Name:
+*
+*    sai_stub_counter_unit_test.cpp
+*
+* Abstract:
+*
+*    This file contains tests for the stub counter polling service. Port
+*    counters move by running frames through the stub software data plane,
+*    snapshots are read in process and out of the shared memory ring; the
+*    rate test reports how fast ring readers get a snapshot.
+*
+*************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/sai_stub_unit_test_utils.h"
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "sai.h"
+#include "saitypes.h"
+#include "saistatus.h"
+#include "saiswitch.h"
+#include "saiport.h"
+#include "saiqueue.h"
+#include "saibuffer.h"
+#include "saipolicer.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_scheduler.h"
+#include "stub_sai_policer.h"
+#include "stub_sai_counter.h"
+#include <string.h>
+}
+
+#define COUNTER_UT_RING "/sai_stub_ut_counters"
+
+class saiStubCounterTest : public saiStubTest
+{
+    protected:
+        static void SetUpTestCase (void);
+
+        static void send_frames (uint32_t port, uint32_t count, uint32_t length);
+        static void enqueue (uint32_t port, uint32_t queue, uint32_t count, uint32_t length);
+        static sai_object_id_t queue_oid (uint32_t port, uint32_t queue);
+        static void wait_polls (uint32_t group, uint64_t polls, stub_counter_snapshot_t *snapshot);
+
+        static sai_port_api_t   *p_port_api;
+        static sai_queue_api_t  *p_queue_api;
+        static sai_buffer_api_t *p_buffer_api;
+        static sai_policer_api_t *p_policer_api;
+};
+
+sai_port_api_t* saiStubCounterTest::p_port_api = NULL;
+sai_queue_api_t* saiStubCounterTest::p_queue_api = NULL;
+sai_buffer_api_t* saiStubCounterTest::p_buffer_api = NULL;
+sai_policer_api_t* saiStubCounterTest::p_policer_api = NULL;
+
+/* Bridged unicast frames between two hosts no FDB entry knows */
+void saiStubCounterTest::send_frames (uint32_t port, uint32_t count, uint32_t length)
+{
+    std::vector<uint8_t> buffer (STUB_DATAPLANE_HEADROOM + length);
+    uint8_t             *eth = buffer.data () + STUB_DATAPLANE_HEADROOM;
+    stub_packet_t        packet;
+
+    /* one frame at a time, the data plane may rewrite it */
+    for (uint32_t i = 0; i < count; i++) {
+        memset (buffer.data (), 0, buffer.size ());
+        eth[0]  = 0x02;
+        eth[5]  = 0x42;
+        eth[6]  = 0x02;
+        eth[11] = 0x99;
+        eth[12] = 0x08;
+
+        memset (&packet, 0, sizeof (packet));
+        packet.data     = eth;
+        packet.length   = length;
+        packet.headroom = STUB_DATAPLANE_HEADROOM;
+        packet.in_port  = port_oid (port);
+        ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, &packet));
+    }
+}
+
+/* Forwarded frames straight to a queue of a port */
+void saiStubCounterTest::enqueue (uint32_t port, uint32_t queue, uint32_t count, uint32_t length)
+{
+    stub_packet_t packet;
+
+    for (uint32_t i = 0; i < count; i++) {
+        memset (&packet, 0, sizeof (packet));
+        packet.length        = length;
+        packet.in_port       = port_oid (0);
+        packet.out_port      = port_oid (port);
+        packet.packet_action = SAI_PACKET_ACTION_FORWARD;
+        packet.queue         = queue;
+        ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_enqueue (1, &packet));
+    }
+}
+
+/* Queue from the queue list of the port */
+sai_object_id_t saiStubCounterTest::queue_oid (uint32_t port, uint32_t queue)
+{
+    sai_object_id_t queues[STUB_SCHEDULER_MAX_CHILDS];
+    sai_attribute_t attr;
+
+    attr.id                  = SAI_PORT_ATTR_QOS_QUEUE_LIST;
+    attr.value.objlist.count = STUB_SCHEDULER_MAX_CHILDS;
+    attr.value.objlist.list  = queues;
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_port_api->get_port_attribute (port_oid (port), 1, &attr));
+    EXPECT_LT (queue, attr.value.objlist.count);
+
+    return queues[queue];
+}
+
+/* Snapshot of the polling thread after polls more polls, a poll that
+ * started after the call sees everything done before it */
+void saiStubCounterTest::wait_polls (uint32_t group, uint64_t polls, stub_counter_snapshot_t *snapshot)
+{
+    uint64_t target;
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_get (group, snapshot));
+    target = snapshot->poll_count + polls;
+
+    for (uint32_t i = 0; i < 5000 && snapshot->poll_count < target; i++) {
+        std::this_thread::sleep_for (std::chrono::milliseconds (1));
+        ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_get (group, snapshot));
+    }
+
+    ASSERT_GE (snapshot->poll_count, target);
+}
+
+void saiStubCounterTest::SetUpTestCase (void)
+{
+    SetUpStubSwitch ();
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_PORT, (void **)&p_port_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_QUEUE, (void **)&p_queue_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_BUFFERS, (void **)&p_buffer_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_POLICER, (void **)&p_policer_api));
+}
+
+/*
+ * Snapshots are column major, deltas follow the counters through a clear
+ * and the rate is an EWMA of the per second increase.
+ */
+TEST_F (saiStubCounterTest, deltas_and_rates)
+{
+    const sai_object_id_t       ports[] = { port_oid (8), port_oid (9) };
+    const int32_t               ids[] = { SAI_PORT_STAT_IF_IN_UCAST_PKTS, SAI_PORT_STAT_IF_IN_OCTETS };
+    stub_counter_group_config_t config;
+    uint32_t                    group;
+    double                      rate;
+
+    std::unique_ptr<stub_counter_snapshot_t> snapshot (new stub_counter_snapshot_t);
+
+    memset (&config, 0, sizeof (config));
+    config.object_type   = SAI_OBJECT_TYPE_PORT;
+    config.object_count  = 2;
+    config.object_ids    = ports;
+    config.counter_count = 2;
+    config.counter_ids   = ids;
+    config.interval_ms   = 1000;
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_create (&group, &config));
+
+    send_frames (8, 3, 100);
+    send_frames (9, 1, 100);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_poll (group));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_get (group, snapshot.get ()));
+
+    EXPECT_EQ (1u, snapshot->poll_count);
+    EXPECT_EQ (2u, snapshot->object_count);
+    EXPECT_EQ (2u, snapshot->counter_count);
+    EXPECT_GT (snapshot->elapsed_ns, 0u);
+    /* counter c of object o at c * object_count + o */
+    EXPECT_EQ (3u, snapshot->deltas[0]);
+    EXPECT_EQ (1u, snapshot->deltas[1]);
+    EXPECT_EQ (300u, snapshot->deltas[2]);
+    EXPECT_EQ (100u, snapshot->deltas[3]);
+    EXPECT_GT (snapshot->rates[0], 0);
+
+    /* a cleared counter reports its new value as the delta */
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->clear_port_all_stats (port_oid (8)));
+    send_frames (8, 1, 100);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_poll (group));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_get (group, snapshot.get ()));
+    EXPECT_EQ (2u, snapshot->poll_count);
+    EXPECT_EQ (1u, snapshot->values[0]);
+    EXPECT_EQ (1u, snapshot->deltas[0]);
+    EXPECT_EQ (0u, snapshot->deltas[1]);
+    rate = snapshot->rates[1];
+
+    /* without traffic the rate halves with the default weight */
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_poll (group));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_get (group, snapshot.get ()));
+    EXPECT_EQ (0u, snapshot->deltas[1]);
+    EXPECT_DOUBLE_EQ (rate / 2, snapshot->rates[1]);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_remove (group));
+    EXPECT_EQ (SAI_STATUS_INVALID_OBJECT_ID, stub_counter_group_poll (group));
+}
+
+/*
+ * Groups that cannot be polled are refused at creation.
+ */
+TEST_F (saiStubCounterTest, invalid_groups)
+{
+    const sai_object_id_t       ports[] = { port_oid (1) };
+    int32_t                     ids[] = { SAI_PORT_STAT_IF_IN_OCTETS };
+    stub_counter_group_config_t config;
+    uint32_t                    group;
+
+    memset (&config, 0, sizeof (config));
+    config.object_type   = SAI_OBJECT_TYPE_PORT;
+    config.object_count  = 1;
+    config.object_ids    = ports;
+    config.counter_count = 1;
+    config.counter_ids   = ids;
+
+    EXPECT_EQ (SAI_STATUS_INVALID_PARAMETER, stub_counter_group_create (&group, &config));
+
+    config.interval_ms = 10;
+    config.object_type = SAI_OBJECT_TYPE_ROUTE;
+    EXPECT_EQ (SAI_STATUS_NOT_SUPPORTED, stub_counter_group_create (&group, &config));
+
+    config.object_type = SAI_OBJECT_TYPE_PORT;
+    ids[0]             = 1000;
+    EXPECT_EQ (SAI_STATUS_INVALID_PARAMETER, stub_counter_group_create (&group, &config));
+
+    config.object_count = STUB_COUNTER_MAX_OBJECTS + 1;
+    EXPECT_EQ (SAI_STATUS_INVALID_PARAMETER, stub_counter_group_create (&group, &config));
+
+    EXPECT_EQ (SAI_STATUS_INVALID_OBJECT_ID, stub_counter_group_remove (STUB_COUNTER_MAX_GROUPS));
+}
+
+/*
+ * The polling thread publishes into the shared memory ring, every reader
+ * that maps it sees the same snapshots without calling into SAI.
+ */
+TEST_F (saiStubCounterTest, ring_readers)
+{
+    const sai_object_id_t       ports[] = { port_oid (10) };
+    const int32_t               ids[] = { SAI_PORT_STAT_IF_IN_UCAST_PKTS };
+    const stub_counter_ring_t  *readers[3];
+    stub_counter_group_config_t config;
+    uint32_t                    group;
+
+    std::unique_ptr<stub_counter_snapshot_t> snapshot (new stub_counter_snapshot_t);
+
+    memset (&config, 0, sizeof (config));
+    config.object_type   = SAI_OBJECT_TYPE_PORT;
+    config.object_count  = 1;
+    config.object_ids    = ports;
+    config.counter_count = 1;
+    config.counter_ids   = ids;
+    config.interval_ms   = 5;
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->clear_port_all_stats (port_oid (10)));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_create (&group, &config));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_poll_start (COUNTER_UT_RING));
+
+    for (uint32_t i = 0; i < 3; i++) {
+        ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_ring_open (COUNTER_UT_RING, &readers[i]));
+    }
+
+    send_frames (10, 7, 64);
+
+    for (uint32_t i = 0; i < 3; i++) {
+        auto deadline = std::chrono::steady_clock::now () + std::chrono::seconds (5);
+        bool seen = false;
+
+        while (!seen && (std::chrono::steady_clock::now () < deadline)) {
+            if (SAI_STATUS_SUCCESS == stub_counter_ring_read (readers[i], group, snapshot.get ())) {
+                seen = (7u == snapshot->values[0]);
+            }
+            if (!seen) {
+                std::this_thread::sleep_for (std::chrono::milliseconds (1));
+            }
+        }
+        EXPECT_TRUE (seen) << "reader " << i;
+        EXPECT_EQ (0u, snapshot->sequence & 1);
+        EXPECT_EQ (group, snapshot->group_id);
+        EXPECT_EQ (ports[0], snapshot->object_ids[0]);
+    }
+
+    /* polls keep coming on the group interval */
+    uint64_t polls = snapshot->poll_count;
+    std::this_thread::sleep_for (std::chrono::milliseconds (50));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_ring_read (readers[0], group, snapshot.get ()));
+    EXPECT_GT (snapshot->poll_count, polls);
+
+    stub_counter_poll_stop ();
+
+    /* the mapping outlives the ring name */
+    EXPECT_EQ (SAI_STATUS_SUCCESS, stub_counter_ring_read (readers[1], group, snapshot.get ()));
+    EXPECT_EQ (7u, snapshot->values[0]);
+    EXPECT_NE (SAI_STATUS_SUCCESS, stub_counter_ring_open (COUNTER_UT_RING, &readers[0]));
+
+    for (uint32_t i = 0; i < 3; i++) {
+        stub_counter_ring_close (readers[i]);
+    }
+    EXPECT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_remove (group));
+}
+
+/*
+ * The polling thread follows the occupancy of queues while frames wait and
+ * their packet counters once the scheduler sent them.
+ */
+TEST_F (saiStubCounterTest, queue_polling)
+{
+    const sai_object_id_t       queues[] = { queue_oid (15, 2), queue_oid (15, 5) };
+    const int32_t               ids[] = { SAI_QUEUE_STAT_PACKETS, SAI_QUEUE_STAT_CURR_OCCUPANCY_BYTES };
+    stub_counter_group_config_t config;
+    uint32_t                    group, count;
+    uint64_t                    base[4];
+
+    std::unique_ptr<stub_counter_snapshot_t> snapshot (new stub_counter_snapshot_t);
+
+    memset (&config, 0, sizeof (config));
+    config.object_type   = SAI_OBJECT_TYPE_QUEUE;
+    config.object_count  = 2;
+    config.object_ids    = queues;
+    config.counter_count = 2;
+    config.counter_ids   = ids;
+    config.interval_ms   = 1;
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_create (&group, &config));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_get (group, snapshot.get ()));
+    EXPECT_EQ (0u, snapshot->poll_count);
+    memcpy (base, snapshot->values, sizeof (base));
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_poll_start (NULL));
+
+    enqueue (15, 2, 10, 500);
+    enqueue (15, 5, 4, 1000);
+    wait_polls (group, 2, snapshot.get ());
+    EXPECT_EQ (base[0], snapshot->values[0]);
+    EXPECT_EQ (base[1], snapshot->values[1]);
+    EXPECT_EQ (base[2] + 5000, snapshot->values[2]);
+    EXPECT_EQ (base[3] + 4000, snapshot->values[3]);
+
+    /* 1.25 GBps drains the 9000 bytes well within 1 ms */
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_transmit (port_oid (15), 1000000, 1250000000ULL, &count));
+    EXPECT_GE (count, 14u);
+    wait_polls (group, 2, snapshot.get ());
+    EXPECT_EQ (base[0] + 10, snapshot->values[0]);
+    EXPECT_EQ (base[1] + 4, snapshot->values[1]);
+    EXPECT_EQ (0u, snapshot->values[2]);
+    EXPECT_EQ (0u, snapshot->values[3]);
+
+    stub_counter_poll_stop ();
+    EXPECT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_remove (group));
+}
+
+/*
+ * A buffer pool group reports the occupancy of the queues bound to the
+ * pool and keeps the watermark once they drained.
+ */
+TEST_F (saiStubCounterTest, buffer_pool_polling)
+{
+    const int32_t               ids[] = { SAI_BUFFER_POOL_STAT_CURR_OCCUPANCY_BYTES,
+                                          SAI_BUFFER_POOL_STAT_WATERMARK_BYTES };
+    sai_object_id_t             pool_id, profile_id, queue_id;
+    stub_counter_group_config_t config;
+    sai_attribute_t             attr[3];
+    uint32_t                    group, count;
+
+    std::unique_ptr<stub_counter_snapshot_t> snapshot (new stub_counter_snapshot_t);
+
+    attr[0].id        = SAI_BUFFER_POOL_ATTR_TYPE;
+    attr[0].value.s32 = SAI_BUFFER_POOL_EGRESS;
+    attr[1].id        = SAI_BUFFER_POOL_ATTR_SIZE;
+    attr[1].value.u32 = 1024 * 1024;
+    attr[2].id        = SAI_BUFFER_POOL_ATTR_TH_MODE;
+    attr[2].value.s32 = SAI_BUFFER_THRESHOLD_MODE_STATIC;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->create_buffer_pool (&pool_id, 3, attr));
+
+    attr[0].id        = SAI_BUFFER_PROFILE_ATTR_POOL_ID;
+    attr[0].value.oid = pool_id;
+    attr[1].id        = SAI_BUFFER_PROFILE_ATTR_BUFFER_SIZE;
+    attr[1].value.u32 = 0;
+    attr[2].id        = SAI_BUFFER_PROFILE_ATTR_SHARED_STATIC_TH;
+    attr[2].value.u32 = 64 * 1024;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->create_buffer_profile (&profile_id, 3, attr));
+
+    queue_id          = queue_oid (16, 3);
+    attr[0].id        = SAI_QUEUE_ATTR_BUFFER_PROFILE_ID;
+    attr[0].value.oid = profile_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_queue_api->set_queue_attribute (queue_id, &attr[0]));
+
+    memset (&config, 0, sizeof (config));
+    config.object_type   = SAI_OBJECT_TYPE_BUFFER_POOL;
+    config.object_count  = 1;
+    config.object_ids    = &pool_id;
+    config.counter_count = 2;
+    config.counter_ids   = ids;
+    config.interval_ms   = 1000;
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_create (&group, &config));
+
+    enqueue (16, 3, 8, 1024);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_poll (group));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_get (group, snapshot.get ()));
+    EXPECT_EQ (8192u, snapshot->values[0]);
+    EXPECT_EQ (8192u, snapshot->deltas[0]);
+    EXPECT_EQ (8192u, snapshot->values[1]);
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_transmit (port_oid (16), 1000000, 1250000000ULL, &count));
+    EXPECT_EQ (8u, count);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_poll (group));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_get (group, snapshot.get ()));
+    EXPECT_EQ (0u, snapshot->values[0]);
+    EXPECT_EQ (8192u, snapshot->values[1]);
+    EXPECT_EQ (0u, snapshot->deltas[1]);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_remove (group));
+
+    attr[0].value.oid = SAI_NULL_OBJECT_ID;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_queue_api->set_queue_attribute (queue_id, &attr[0]));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->remove_buffer_profile (profile_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_buffer_api->remove_buffer_pool (pool_id));
+}
+
+/*
+ * A policer group counts the frames of each color the policer metered.
+ */
+TEST_F (saiStubCounterTest, policer_polling)
+{
+    const int32_t               ids[] = { SAI_POLICER_STAT_GREEN_PACKETS, SAI_POLICER_STAT_YELLOW_PACKETS,
+                                          SAI_POLICER_STAT_RED_PACKETS, SAI_POLICER_STAT_ATTR_BYTES };
+    stub_packet_t               packets[10];
+    sai_packet_color_t          colors[10];
+    stub_counter_group_config_t config;
+    sai_object_id_t             policer_id;
+    sai_attribute_t             attr[5];
+    uint32_t                    group;
+
+    std::unique_ptr<stub_counter_snapshot_t> snapshot (new stub_counter_snapshot_t);
+
+    attr[0].id        = SAI_POLICER_ATTR_METER_TYPE;
+    attr[0].value.s32 = SAI_METER_TYPE_PACKETS;
+    attr[1].id        = SAI_POLICER_ATTR_MODE;
+    attr[1].value.s32 = SAI_POLICER_MODE_Sr_TCM;
+    attr[2].id        = SAI_POLICER_ATTR_CIR;
+    attr[2].value.u64 = 1;
+    attr[3].id        = SAI_POLICER_ATTR_CBS;
+    attr[3].value.u64 = 4;
+    attr[4].id        = SAI_POLICER_ATTR_PBS;
+    attr[4].value.u64 = 3;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_policer_api->create_policer (&policer_id, 5, attr));
+
+    memset (&config, 0, sizeof (config));
+    config.object_type   = SAI_OBJECT_TYPE_POLICER;
+    config.object_count  = 1;
+    config.object_ids    = &policer_id;
+    config.counter_count = 4;
+    config.counter_ids   = ids;
+    config.interval_ms   = 1000;
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_create (&group, &config));
+
+    memset (packets, 0, sizeof (packets));
+    for (uint32_t i = 0; i < 10; i++) {
+        packets[i].length  = 100;
+        packets[i].in_port = port_oid (1);
+    }
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_policer_meter (policer_id, 10, packets, colors));
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_poll (group));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_get (group, snapshot.get ()));
+    EXPECT_EQ (4u, snapshot->deltas[0]);
+    EXPECT_EQ (3u, snapshot->deltas[1]);
+    EXPECT_EQ (3u, snapshot->deltas[2]);
+    EXPECT_EQ (1000u, snapshot->deltas[3]);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_remove (group));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_policer_api->remove_policer (policer_id));
+}
+
+/*
+ * A telemetry client reading 40 counters of every port, from the ring
+ * against calling get_port_stats per port.
+ */
+TEST_F (saiStubCounterTest, reader_rate)
+{
+    const uint32_t              reads = 20000, counter_count = 40;
+    std::vector<sai_object_id_t> ports;
+    std::vector<int32_t>        ids;
+    std::vector<uint64_t>       counters (counter_count);
+    const stub_counter_ring_t  *ring;
+    stub_counter_group_config_t config;
+    sai_attribute_t             attr;
+    uint32_t                    group;
+
+    std::unique_ptr<stub_counter_snapshot_t> snapshot (new stub_counter_snapshot_t);
+
+    attr.id = SAI_SWITCH_ATTR_PORT_NUMBER;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->get_switch_attribute (1, &attr));
+    for (uint32_t i = 0; i < attr.value.u32; i++) {
+        ports.push_back (port_oid (i));
+    }
+    for (uint32_t i = 0; i < counter_count; i++) {
+        ids.push_back (i);
+    }
+
+    memset (&config, 0, sizeof (config));
+    config.object_type   = SAI_OBJECT_TYPE_PORT;
+    config.object_count  = ports.size ();
+    config.object_ids    = ports.data ();
+    config.counter_count = counter_count;
+    config.counter_ids   = ids.data ();
+    config.interval_ms   = 1;
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_create (&group, &config));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_poll_start (COUNTER_UT_RING));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_ring_open (COUNTER_UT_RING, &ring));
+    while (SAI_STATUS_SUCCESS != stub_counter_ring_read (ring, group, snapshot.get ())) {
+        std::this_thread::sleep_for (std::chrono::milliseconds (1));
+    }
+
+    auto start = std::chrono::steady_clock::now ();
+    for (uint32_t read = 0; read < reads; read++) {
+        for (uint32_t i = 0; i < ports.size (); i++) {
+            ASSERT_EQ (SAI_STATUS_SUCCESS,
+                       p_port_api->get_port_stats (ports[i], (const sai_port_stat_counter_t*)ids.data (),
+                                                   counter_count, counters.data ()));
+        }
+    }
+    double direct_sec = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+    start = std::chrono::steady_clock::now ();
+    for (uint32_t read = 0; read < reads; read++) {
+        ASSERT_EQ (SAI_STATUS_SUCCESS, stub_counter_ring_read (ring, group, snapshot.get ()));
+    }
+    double ring_sec = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+    EXPECT_EQ (ports.size () * counter_count, snapshot->object_count * snapshot->counter_count);
+
+    printf ("read of %zu ports x %u counters: get_port_stats %.2f us, ring %.2f us\n",
+            ports.size (), counter_count, direct_sec * 1e6 / reads, ring_sec * 1e6 / reads);
+
+    stub_counter_ring_close (ring);
+    stub_counter_poll_stop ();
+    EXPECT_EQ (SAI_STATUS_SUCCESS, stub_counter_group_remove (group));
+}
@@ -0,0 +1,602 @@
+/************************************************************************
+*    Licensed under the Apache License, Version 2.0 (the "License"); you may
+*    not use this file except in compliance with the License. You may obtain
+*    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+*
+*    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+*    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+*    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+*    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+*
+*    See the Apache Version 2.0 License for specific language governing
+*    permissions and limitations under the License.
+*
+*
+* Module Name:
+*
+*    sai_stub_dataplane_unit_test.cpp
+*
+* Abstract:
+*
+*    This file contains tests for the stub software data plane. Crafted
+*    frames are run through a small topology programmed through the SAI
+*    API and the forwarding decision and rewritten headers are checked.
+*
+*************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/sai_stub_unit_test_utils.h"
+
+#include <vector>
+
+extern "C" {
+#include "sai.h"
+#include "saitypes.h"
+#include "saistatus.h"
+#include "saiswitch.h"
+#include "saiport.h"
+#include "saifdb.h"
+#include "saivlan.h"
+#include "sainexthop.h"
+#include "sairouter.h"
+#include "sairouterintf.h"
+#include "sairoute.h"
+#include "saineighbor.h"
+#include "saihostintf.h"
+#include "stub_sai_dataplane.h"
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+}
+
+static std::vector<int32_t> trapped_ids;
+
+static void dataplane_test_packet_event (const void *buffer, sai_size_t buffer_size,
+                                         uint32_t attr_count, const sai_attribute_t *attr_list)
+{
+    for (uint32_t i = 0; i < attr_count; i++) {
+        if (SAI_HOSTIF_PACKET_TRAP_ID == attr_list[i].id) {
+            trapped_ids.push_back (attr_list[i].value.s32);
+        }
+    }
+}
+
+class saiStubDataplaneTest : public saiStubTest
+{
+    protected:
+        static void SetUpTestCase (void);
+
+        /* Frame buffer with headroom for a VLAN push */
+        struct frame_t {
+            uint8_t       buffer[STUB_DATAPLANE_HEADROOM + 256];
+            stub_packet_t packet;
+        };
+
+        static void build_ipv4 (frame_t *frame, sai_object_id_t in_port, uint8_t router_mac,
+                                uint16_t vlan_id, uint32_t host_order_dst, uint8_t ttl);
+        static uint16_t ipv4_checksum (const uint8_t *ip);
+        static void route_create (uint32_t host_order_ip, uint32_t prefix_len,
+                                  sai_object_id_t next_hop);
+        static void neighbor_create (sai_object_id_t rif, uint32_t host_order_ip,
+                                     uint8_t mac_id);
+        static void fdb_create (uint8_t mac_id, uint16_t vlan_id, sai_object_id_t port);
+
+        static sai_port_api_t             *p_port_api;
+        static sai_fdb_api_t              *p_fdb_api;
+        static sai_vlan_api_t             *p_vlan_api;
+        static sai_virtual_router_api_t   *p_vr_api;
+        static sai_router_interface_api_t *p_rif_api;
+        static sai_route_api_t            *p_route_api;
+        static sai_neighbor_api_t         *p_neighbor_api;
+
+        static sai_object_id_t vr_id;
+        static sai_object_id_t port1_rif_id;
+        static sai_object_id_t port2_rif_id;
+        static sai_object_id_t vlan_rif_id;
+};
+
+sai_port_api_t* saiStubDataplaneTest::p_port_api = NULL;
+sai_fdb_api_t* saiStubDataplaneTest::p_fdb_api = NULL;
+sai_vlan_api_t* saiStubDataplaneTest::p_vlan_api = NULL;
+sai_virtual_router_api_t* saiStubDataplaneTest::p_vr_api = NULL;
+sai_router_interface_api_t* saiStubDataplaneTest::p_rif_api = NULL;
+sai_route_api_t* saiStubDataplaneTest::p_route_api = NULL;
+sai_neighbor_api_t* saiStubDataplaneTest::p_neighbor_api = NULL;
+sai_object_id_t saiStubDataplaneTest::vr_id = 0;
+sai_object_id_t saiStubDataplaneTest::port1_rif_id = 0;
+sai_object_id_t saiStubDataplaneTest::port2_rif_id = 0;
+sai_object_id_t saiStubDataplaneTest::vlan_rif_id = 0;
+
+uint16_t saiStubDataplaneTest::ipv4_checksum (const uint8_t *ip)
+{
+    uint32_t sum = 0;
+
+    for (uint32_t i = 0; i < 20; i += 2) {
+        sum += (ip[i] << 8) | ip[i + 1];
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+
+    return (uint16_t) ~sum;
+}
+
+/* UDP over IPv4 from 10.9.0.1, tagged when vlan_id is not 0 */
+void saiStubDataplaneTest::build_ipv4 (frame_t *frame, sai_object_id_t in_port, uint8_t router_mac,
+                                       uint16_t vlan_id, uint32_t host_order_dst, uint8_t ttl)
+{
+    uint8_t  *eth = frame->buffer + STUB_DATAPLANE_HEADROOM;
+    uint8_t  *ip;
+    uint32_t  offset = 12;
+    uint32_t  src = htonl (0x0A090001), dst = htonl (host_order_dst);
+    uint16_t  csum;
+
+    memset (frame->buffer, 0, sizeof (frame->buffer));
+    eth[5]  = router_mac;
+    eth[6]  = 0x02;
+    eth[11] = 0x99;
+
+    if (vlan_id) {
+        eth[offset++] = 0x81;
+        eth[offset++] = 0x00;
+        eth[offset++] = (uint8_t) (0x20 | (vlan_id >> 8));
+        eth[offset++] = (uint8_t) vlan_id;
+    }
+    eth[offset++] = 0x08;
+    eth[offset++] = 0x00;
+
+    ip     = eth + offset;
+    ip[0]  = 0x45;
+    ip[3]  = 28;
+    ip[8]  = ttl;
+    ip[9]  = 17;
+    memcpy (ip + 12, &src, 4);
+    memcpy (ip + 16, &dst, 4);
+    ip[21] = 53;
+    ip[23] = 53;
+    csum   = ipv4_checksum (ip);
+    ip[10] = (uint8_t) (csum >> 8);
+    ip[11] = (uint8_t) csum;
+
+    memset (&frame->packet, 0, sizeof (frame->packet));
+    frame->packet.data     = eth;
+    frame->packet.length   = offset + 28;
+    frame->packet.headroom = STUB_DATAPLANE_HEADROOM;
+    frame->packet.in_port  = in_port;
+}
+
+void saiStubDataplaneTest::route_create (uint32_t host_order_ip, uint32_t prefix_len,
+                                         sai_object_id_t next_hop)
+{
+    sai_unicast_route_entry_t route;
+    sai_attribute_t           attr;
+
+    memset (&route, 0, sizeof (route));
+    route.vr_id                    = vr_id;
+    route.destination.addr_family  = SAI_IP_ADDR_FAMILY_IPV4;
+    route.destination.addr.ip4     = htonl (host_order_ip);
+    route.destination.mask.ip4     = htonl (0xFFFFFFFFu << (32 - prefix_len));
+
+    attr.id        = SAI_ROUTE_ATTR_NEXT_HOP_ID;
+    attr.value.oid = next_hop;
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_route_api->create_route (&route, 1, &attr));
+}
+
+void saiStubDataplaneTest::neighbor_create (sai_object_id_t rif, uint32_t host_order_ip,
+                                            uint8_t mac_id)
+{
+    sai_neighbor_entry_t neighbor;
+    sai_attribute_t      attr;
+
+    memset (&neighbor, 0, sizeof (neighbor));
+    neighbor.rif_id                 = rif;
+    neighbor.ip_address.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+    neighbor.ip_address.addr.ip4    = htonl (host_order_ip);
+
+    attr.id = SAI_NEIGHBOR_ATTR_DST_MAC_ADDRESS;
+    memset (attr.value.mac, 0, sizeof (sai_mac_t));
+    attr.value.mac[0] = 0x02;
+    attr.value.mac[5] = mac_id;
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS,
+               p_neighbor_api->create_neighbor_entry (&neighbor, 1, &attr));
+}
+
+void saiStubDataplaneTest::fdb_create (uint8_t mac_id, uint16_t vlan_id, sai_object_id_t port)
+{
+    sai_fdb_entry_t fdb_entry;
+    sai_attribute_t attr[3];
+
+    memset (&fdb_entry, 0, sizeof (fdb_entry));
+    fdb_entry.mac_address[0] = 0x02;
+    fdb_entry.mac_address[5] = mac_id;
+    fdb_entry.vlan_id        = vlan_id;
+    attr[0].id        = SAI_FDB_ENTRY_ATTR_TYPE;
+    attr[0].value.s32 = SAI_FDB_ENTRY_STATIC;
+    attr[1].id        = SAI_FDB_ENTRY_ATTR_PORT_ID;
+    attr[1].value.oid = port;
+    attr[2].id        = SAI_FDB_ENTRY_ATTR_PACKET_ACTION;
+    attr[2].value.s32 = SAI_PACKET_ACTION_FORWARD;
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_fdb_api->create_fdb_entry (&fdb_entry, 3, attr));
+}
+
+/*
+ * Topology:
+ *   port rif (port 1, mac ..:01) 10.0.0.0/24, neighbor 10.0.0.2 ..:10
+ *   port rif (port 2, mac ..:03) 10.2.0.0/24
+ *   vlan rif (vlan 100, mac ..:02) 10.1.0.0/24, neighbor 10.1.0.1 ..:20 on port 10
+ *   vlan 100 tagged on ports 10 and 11
+ */
+void saiStubDataplaneTest::SetUpTestCase (void)
+{
+    sai_switch_notification_t notification;
+    sai_attribute_t           attr[4];
+    sai_vlan_port_t           members[2];
+
+    memset (&notification, 0, sizeof (notification));
+    notification.on_packet_event = dataplane_test_packet_event;
+
+    SetUpStubSwitch (&notification);
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_PORT, (void **)&p_port_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_FDB, (void **)&p_fdb_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_VLAN, (void **)&p_vlan_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_VIRTUAL_ROUTER, (void **)&p_vr_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_ROUTER_INTERFACE, (void **)&p_rif_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_ROUTE, (void **)&p_route_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_NEIGHBOR, (void **)&p_neighbor_api));
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vr_api->create_virtual_router (&vr_id, 0, NULL));
+
+    members[0].port_id      = port_oid (10);
+    members[0].tagging_mode = SAI_VLAN_PORT_TAGGED;
+    members[1].port_id      = port_oid (11);
+    members[1].tagging_mode = SAI_VLAN_PORT_TAGGED;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vlan_api->create_vlan (100));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vlan_api->add_ports_to_vlan (100, 2, members));
+
+    memset (attr, 0, sizeof (attr));
+    attr[0].id        = SAI_ROUTER_INTERFACE_ATTR_VIRTUAL_ROUTER_ID;
+    attr[0].value.oid = vr_id;
+    attr[1].id        = SAI_ROUTER_INTERFACE_ATTR_TYPE;
+    attr[1].value.s32 = SAI_ROUTER_INTERFACE_TYPE_PORT;
+    attr[2].id        = SAI_ROUTER_INTERFACE_ATTR_PORT_ID;
+    attr[2].value.oid = port_oid (1);
+    attr[3].id        = SAI_ROUTER_INTERFACE_ATTR_SRC_MAC_ADDRESS;
+    attr[3].value.mac[5] = 0x01;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_rif_api->create_router_interface (&port1_rif_id, 4, attr));
+
+    attr[2].value.oid    = port_oid (2);
+    attr[3].value.mac[5] = 0x03;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_rif_api->create_router_interface (&port2_rif_id, 4, attr));
+
+    attr[1].value.s32    = SAI_ROUTER_INTERFACE_TYPE_VLAN;
+    attr[2].id           = SAI_ROUTER_INTERFACE_ATTR_VLAN_ID;
+    attr[2].value.u16    = 100;
+    attr[3].value.mac[5] = 0x02;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_rif_api->create_router_interface (&vlan_rif_id, 4, attr));
+
+    route_create (0x0A000000, 24, port1_rif_id);
+    route_create (0x0A020000, 24, port2_rif_id);
+    route_create (0x0A010000, 24, vlan_rif_id);
+    neighbor_create (port1_rif_id, 0x0A000002, 0x10);
+    neighbor_create (vlan_rif_id, 0x0A010001, 0x20);
+    fdb_create (0x20, 100, port_oid (10));
+}
+
+/*
+ * Routed frame gets the egress MACs and a decremented TTL with a valid
+ * header checksum.
+ */
+TEST_F (saiStubDataplaneTest, routes_ipv4)
+{
+    frame_t frame;
+
+    build_ipv4 (&frame, port_oid (2), 0x03, 0, 0x0A000002, 64);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, &frame.packet));
+
+    EXPECT_EQ (SAI_PACKET_ACTION_FORWARD, frame.packet.packet_action);
+    EXPECT_EQ (port_oid (1), frame.packet.out_port);
+    EXPECT_EQ (42u, frame.packet.length);
+    EXPECT_EQ (0x10, frame.packet.data[5]);
+    EXPECT_EQ (0x01, frame.packet.data[11]);
+    EXPECT_EQ (63, frame.packet.data[14 + 8]);
+    EXPECT_EQ (0, ipv4_checksum (frame.packet.data + 14));
+}
+
+/*
+ * Routing into a VLAN interface pushes the tag and resolves the port
+ * through the FDB, routing out of it pops the tag.
+ */
+TEST_F (saiStubDataplaneTest, vlan_push_and_pop)
+{
+    frame_t frame;
+
+    build_ipv4 (&frame, port_oid (2), 0x03, 0, 0x0A010001, 64);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, &frame.packet));
+
+    EXPECT_EQ (SAI_PACKET_ACTION_FORWARD, frame.packet.packet_action);
+    EXPECT_EQ (port_oid (10), frame.packet.out_port);
+    EXPECT_EQ (46u, frame.packet.length);
+    EXPECT_EQ (STUB_DATAPLANE_HEADROOM - 4u, frame.packet.headroom);
+    EXPECT_EQ (0x20, frame.packet.data[5]);
+    EXPECT_EQ (0x02, frame.packet.data[11]);
+    EXPECT_EQ (0x81, frame.packet.data[12]);
+    EXPECT_EQ (100, frame.packet.data[15]);
+    EXPECT_EQ (0x08, frame.packet.data[16]);
+    EXPECT_EQ (0, ipv4_checksum (frame.packet.data + 18));
+
+    build_ipv4 (&frame, port_oid (10), 0x02, 100, 0x0A000002, 64);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, &frame.packet));
+
+    EXPECT_EQ (SAI_PACKET_ACTION_FORWARD, frame.packet.packet_action);
+    EXPECT_EQ (port_oid (1), frame.packet.out_port);
+    EXPECT_EQ (42u, frame.packet.length);
+    EXPECT_EQ (0x10, frame.packet.data[5]);
+    EXPECT_EQ (0x08, frame.packet.data[12]);
+    EXPECT_EQ (63, frame.packet.data[14 + 8]);
+    EXPECT_EQ (0, ipv4_checksum (frame.packet.data + 14));
+}
+
+/*
+ * Frames not addressed to the router are bridged, unknown destinations
+ * are flooded and route misses dropped.
+ */
+TEST_F (saiStubDataplaneTest, bridge_flood_and_miss)
+{
+    frame_t frame[3];
+
+    /* Addressed to the known neighbor MAC, not the router */
+    build_ipv4 (&frame[0], port_oid (11), 0x20, 100, 0x0A010001, 64);
+    frame[0].packet.data[0] = 0x02;
+    build_ipv4 (&frame[1], port_oid (11), 0x77, 100, 0x0A010001, 64);
+    build_ipv4 (&frame[2], port_oid (2), 0x03, 0, 0xC0A80001, 64);
+
+    stub_packet_t packets[3] = { frame[0].packet, frame[1].packet, frame[2].packet };
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (3, packets));
+
+    EXPECT_EQ (SAI_PACKET_ACTION_FORWARD, packets[0].packet_action);
+    EXPECT_EQ (port_oid (10), packets[0].out_port);
+    EXPECT_EQ (64, packets[0].data[18 + 8]);
+
+    EXPECT_EQ (SAI_PACKET_ACTION_FORWARD, packets[1].packet_action);
+    EXPECT_EQ (SAI_NULL_OBJECT_ID, packets[1].out_port);
+
+    EXPECT_EQ (SAI_PACKET_ACTION_DROP, packets[2].packet_action);
+}
+
+/*
+ * Unknown destinations flood only to the members of the frame's VLAN,
+ * never back to the ingress port.
+ */
+TEST_F (saiStubDataplaneTest, flood_within_vlan)
+{
+    frame_t         frame[2];
+    sai_vlan_port_t members[3];
+    uint32_t        port;
+
+    memset (members, 0, sizeof (members));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vlan_api->create_vlan (200));
+    members[0].port_id = port_oid (20);
+    members[1].port_id = port_oid (21);
+    members[2].port_id = port_oid (22);
+    for (uint32_t i = 0; i < 3; i++) {
+        members[i].tagging_mode = SAI_VLAN_PORT_TAGGED;
+    }
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vlan_api->add_ports_to_vlan (200, 3, members));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vlan_api->create_vlan (300));
+    members[0].port_id = port_oid (23);
+    members[1].port_id = port_oid (24);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vlan_api->add_ports_to_vlan (300, 2, members));
+
+    build_ipv4 (&frame[0], port_oid (20), 0x77, 200, 0x0A010001, 64);
+    build_ipv4 (&frame[1], port_oid (23), 0x77, 300, 0x0A010001, 64);
+
+    stub_packet_t packets[2] = { frame[0].packet, frame[1].packet };
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (2, packets));
+
+    ASSERT_EQ (SAI_PACKET_ACTION_FORWARD, packets[0].packet_action);
+    ASSERT_EQ (SAI_NULL_OBJECT_ID, packets[0].out_port);
+    ASSERT_EQ (SAI_NULL_OBJECT_ID, packets[1].out_port);
+    for (port = 0; port < port_count; port++) {
+        EXPECT_EQ ((21 == port) || (22 == port), stub_dataplane_is_sent_to (&packets[0], port)) << port;
+        EXPECT_EQ (24 == port, stub_dataplane_is_sent_to (&packets[1], port)) << port;
+    }
+
+    /* A port leaving the VLAN no longer gets its floods */
+    members[0].port_id = port_oid (22);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vlan_api->remove_ports_from_vlan (200, 1, members));
+    EXPECT_TRUE (stub_dataplane_is_sent_to (&packets[0], 21));
+    EXPECT_FALSE (stub_dataplane_is_sent_to (&packets[0], 22));
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vlan_api->remove_vlan (200));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vlan_api->remove_vlan (300));
+    EXPECT_FALSE (stub_dataplane_is_sent_to (&packets[0], 21));
+    EXPECT_FALSE (stub_dataplane_is_sent_to (&packets[1], 24));
+}
+
+/*
+ * Untagged frames are on the VLAN of their ingress port. Frames leave
+ * untagged members without a tag and tagged members with one, bridged or
+ * routed.
+ */
+TEST_F (saiStubDataplaneTest, port_vlan_and_tagging)
+{
+    frame_t         frame[3];
+    sai_vlan_port_t members[2];
+    sai_attribute_t attr;
+
+    attr.id        = SAI_PORT_ATTR_PORT_VLAN_ID;
+    attr.value.u16 = 0;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_port_api->set_port_attribute (port_oid (25), &attr));
+    attr.value.u16 = 400;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->set_port_attribute (port_oid (25), &attr));
+    attr.value.u16 = 0;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->get_port_attribute (port_oid (25), 1, &attr));
+    EXPECT_EQ (400, attr.value.u16);
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vlan_api->create_vlan (400));
+    members[0].port_id      = port_oid (25);
+    members[0].tagging_mode = SAI_VLAN_PORT_UNTAGGED;
+    members[1].port_id      = port_oid (26);
+    members[1].tagging_mode = SAI_VLAN_PORT_TAGGED;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vlan_api->add_ports_to_vlan (400, 2, members));
+    fdb_create (0x30, 400, port_oid (25));
+    fdb_create (0x31, 400, port_oid (26));
+
+    /* Untagged from port 25 to port 26 gets the tag of VLAN 400, tagged
+     * from port 26 to port 25 loses it */
+    build_ipv4 (&frame[0], port_oid (25), 0x31, 0, 0x0A010001, 64);
+    frame[0].packet.data[0] = 0x02;
+    build_ipv4 (&frame[1], port_oid (26), 0x30, 400, 0x0A010001, 64);
+    frame[1].packet.data[0] = 0x02;
+    /* Unknown destination, flooded on VLAN 400 */
+    build_ipv4 (&frame[2], port_oid (25), 0x77, 0, 0x0A010001, 64);
+
+    stub_packet_t packets[3] = { frame[0].packet, frame[1].packet, frame[2].packet };
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (3, packets));
+
+    EXPECT_EQ (SAI_PACKET_ACTION_FORWARD, packets[0].packet_action);
+    EXPECT_EQ (port_oid (26), packets[0].out_port);
+    EXPECT_EQ (46u, packets[0].length);
+    EXPECT_EQ (0x81, packets[0].data[12]);
+    EXPECT_EQ (400, ((packets[0].data[14] & 0x0F) << 8) | packets[0].data[15]);
+    EXPECT_EQ (0x08, packets[0].data[16]);
+
+    EXPECT_EQ (SAI_PACKET_ACTION_FORWARD, packets[1].packet_action);
+    EXPECT_EQ (port_oid (25), packets[1].out_port);
+    EXPECT_EQ (42u, packets[1].length);
+    EXPECT_EQ (0x08, packets[1].data[12]);
+    EXPECT_EQ (64, packets[1].data[14 + 8]);
+
+    EXPECT_EQ (SAI_NULL_OBJECT_ID, packets[2].out_port);
+    EXPECT_EQ (400, packets[2].vlan_id);
+    EXPECT_TRUE (stub_dataplane_is_sent_to (&packets[2], 26));
+    EXPECT_FALSE (stub_dataplane_is_sent_to (&packets[2], 27));
+
+    /* Routed into VLAN 100 on an untagged member leaves without a tag */
+    members[0].port_id = port_oid (10);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vlan_api->remove_ports_from_vlan (100, 1, members));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vlan_api->add_ports_to_vlan (100, 1, members));
+
+    build_ipv4 (&frame[0], port_oid (2), 0x03, 0, 0x0A010001, 64);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, &frame[0].packet));
+
+    EXPECT_EQ (SAI_PACKET_ACTION_FORWARD, frame[0].packet.packet_action);
+    EXPECT_EQ (port_oid (10), frame[0].packet.out_port);
+    EXPECT_EQ (42u, frame[0].packet.length);
+    EXPECT_EQ (0x20, frame[0].packet.data[5]);
+    EXPECT_EQ (0x08, frame[0].packet.data[12]);
+    EXPECT_EQ (63, frame[0].packet.data[14 + 8]);
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vlan_api->remove_ports_from_vlan (100, 1, members));
+    members[0].tagging_mode = SAI_VLAN_PORT_TAGGED;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vlan_api->add_ports_to_vlan (100, 1, members));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vlan_api->remove_vlan (400));
+    attr.value.u16 = 1;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->set_port_attribute (port_oid (25), &attr));
+}
+
+/*
+ * A port only takes the frames of its VLANs: tagged with a VLAN it is not
+ * in, or untagged on a port VLAN it is not in, a frame is dropped before
+ * it is bridged or flooded.
+ */
+TEST_F (saiStubDataplaneTest, ingress_vlan_filter)
+{
+    frame_t         frame[4];
+    sai_vlan_port_t member;
+    sai_attribute_t attr;
+
+    /* Known and unknown destination on VLAN 100 from a port out of it */
+    build_ipv4 (&frame[0], port_oid (12), 0x20, 100, 0x0A010001, 64);
+    frame[0].packet.data[0] = 0x02;
+    build_ipv4 (&frame[1], port_oid (12), 0x77, 100, 0x0A010001, 64);
+    /* The same from a member */
+    build_ipv4 (&frame[2], port_oid (11), 0x77, 100, 0x0A010001, 64);
+    /* Untagged on port VLAN 100 of a port out of it */
+    build_ipv4 (&frame[3], port_oid (12), 0x77, 0, 0x0A010001, 64);
+
+    attr.id        = SAI_PORT_ATTR_PORT_VLAN_ID;
+    attr.value.u16 = 100;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->set_port_attribute (port_oid (12), &attr));
+
+    stub_packet_t packets[4] = { frame[0].packet, frame[1].packet, frame[2].packet, frame[3].packet };
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (4, packets));
+
+    EXPECT_EQ (SAI_PACKET_ACTION_DROP, packets[0].packet_action);
+    EXPECT_EQ (SAI_PACKET_ACTION_DROP, packets[1].packet_action);
+    EXPECT_FALSE (stub_dataplane_is_sent_to (&packets[1], 10));
+    EXPECT_EQ (SAI_PACKET_ACTION_FORWARD, packets[2].packet_action);
+    EXPECT_TRUE (stub_dataplane_is_sent_to (&packets[2], 10));
+    EXPECT_EQ (SAI_PACKET_ACTION_DROP, packets[3].packet_action);
+
+    /* Once a member, the port takes them */
+    member.port_id      = port_oid (12);
+    member.tagging_mode = SAI_VLAN_PORT_TAGGED;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vlan_api->add_ports_to_vlan (100, 1, &member));
+
+    packets[0] = frame[1].packet;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, packets));
+    EXPECT_EQ (SAI_PACKET_ACTION_FORWARD, packets[0].packet_action);
+    EXPECT_TRUE (stub_dataplane_is_sent_to (&packets[0], 10));
+    EXPECT_TRUE (stub_dataplane_is_sent_to (&packets[0], 11));
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vlan_api->remove_ports_from_vlan (100, 1, &member));
+    attr.value.u16 = 1;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->set_port_attribute (port_oid (12), &attr));
+}
+
+/*
+ * Expiring TTL and unresolved neighbors are trapped; run_pcap delivers
+ * traps to the host and writes only forwarded frames.
+ */
+TEST_F (saiStubDataplaneTest, traps_through_pcap)
+{
+    frame_t  frame[3];
+    char     in_path[] = "/tmp/sai_dataplane_in_XXXXXX";
+    char     out_path[] = "/tmp/sai_dataplane_out_XXXXXX";
+    uint32_t header[6] = { 0xA1B2C3D4, 0x00040002, 0, 0, 65535, 1 };
+    uint32_t record[4], records = 0;
+    FILE    *file;
+
+    build_ipv4 (&frame[0], port_oid (2), 0x03, 0, 0x0A000002, 64);
+    build_ipv4 (&frame[1], port_oid (2), 0x03, 0, 0x0A000002, 1);
+    build_ipv4 (&frame[2], port_oid (2), 0x03, 0, 0x0A000063, 64);
+
+    close (mkstemp (in_path));
+    close (mkstemp (out_path));
+    ASSERT_TRUE (NULL != (file = fopen (in_path, "wb")));
+    fwrite (header, sizeof (header), 1, file);
+    for (uint32_t i = 0; i < 3; i++) {
+        record[0] = i;
+        record[1] = 0;
+        record[2] = record[3] = frame[i].packet.length;
+        fwrite (record, sizeof (record), 1, file);
+        fwrite (frame[i].packet.data, frame[i].packet.length, 1, file);
+    }
+    fclose (file);
+
+    trapped_ids.clear ();
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_run_pcap (in_path, port_oid (2), out_path));
+
+    ASSERT_EQ (2u, trapped_ids.size ());
+    EXPECT_EQ (SAI_HOSTIF_TRAP_ID_TTL_ERROR, trapped_ids[0]);
+    EXPECT_EQ (0, trapped_ids[1]);
+
+    ASSERT_TRUE (NULL != (file = fopen (out_path, "rb")));
+    ASSERT_EQ (1u, fread (header, sizeof (header), 1, file));
+    while (1 == fread (record, sizeof (record), 1, file)) {
+        EXPECT_EQ (0u, record[0]);
+        fseek (file, record[2], SEEK_CUR);
+        records++;
+    }
+    fclose (file);
+    EXPECT_EQ (1u, records);
+
+    unlink (in_path);
+    unlink (out_path);
+}
@@ -0,0 +1,592 @@
+/************************************************************************
+*    Licensed under the Apache License, Version 2.0 (the "License"); you may
+*    not use this file except in compliance with the License. You may obtain
+*    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+*
+*    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+*    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+*    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+*    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+*
+*    See the Apache Version 2.0 License for specific language governing
+*    permissions and limitations under the License.
+*
+*
+* Module Name:
+*
+*    sai_stub_hash_unit_test.cpp
+*
+* Abstract:
+*
+*    This file contains tests for the stub ECMP and LAG hash engine. Hash
+*    objects are set on the switch, routed frames are spread over next hop
+*    group and LAG members, and the hash rate and evenness are reported for
+*    each algorithm.
+*
+*************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/sai_stub_unit_test_utils.h"
+
+extern "C" {
+#include "sai.h"
+#include "saitypes.h"
+#include "saistatus.h"
+#include "saiswitch.h"
+#include "saihash.h"
+#include "sailag.h"
+#include "sainexthop.h"
+#include "sainexthopgroup.h"
+#include "sairouter.h"
+#include "sairouterintf.h"
+#include "sairoute.h"
+#include "saineighbor.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_hash.h"
+#include <arpa/inet.h>
+#include <string.h>
+#include <stdio.h>
+}
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <map>
+#include <vector>
+
+#define SAI_HASH_TEST_PATHS 4
+#define SAI_HASH_TEST_FLOWS 4096
+
+class saiStubHashTest : public saiStubTest
+{
+    protected:
+        static void SetUpTestCase (void);
+
+        struct frame_t {
+            uint8_t       buffer[STUB_DATAPLANE_HEADROOM + 128];
+            stub_packet_t packet;
+        };
+
+        static void build_udp (frame_t *frame, sai_object_id_t in_port, uint32_t host_order_src,
+                               uint32_t host_order_dst, uint16_t src_port, uint16_t dst_port);
+        static sai_object_id_t rif_create (sai_object_id_t port, uint8_t mac_id);
+        static void route_create (uint32_t host_order_ip, uint32_t prefix_len,
+                                  sai_object_id_t next_hop);
+        static void neighbor_create (sai_object_id_t rif, uint32_t host_order_ip, uint8_t mac_id);
+        static sai_object_id_t hash_create (uint32_t count, const int32_t *fields);
+        static void spread (uint32_t host_order_dst, std::map<sai_object_id_t, uint32_t> &ports);
+
+        static sai_hash_api_t             *p_hash_api;
+        static sai_lag_api_t              *p_lag_api;
+        static sai_next_hop_api_t         *p_nh_api;
+        static sai_next_hop_group_api_t   *p_nhg_api;
+        static sai_virtual_router_api_t   *p_vr_api;
+        static sai_router_interface_api_t *p_rif_api;
+        static sai_route_api_t            *p_route_api;
+        static sai_neighbor_api_t         *p_neighbor_api;
+
+        static sai_object_id_t vr_id;
+        static sai_object_id_t lag_id;
+};
+
+sai_hash_api_t* saiStubHashTest::p_hash_api = NULL;
+sai_lag_api_t* saiStubHashTest::p_lag_api = NULL;
+sai_next_hop_api_t* saiStubHashTest::p_nh_api = NULL;
+sai_next_hop_group_api_t* saiStubHashTest::p_nhg_api = NULL;
+sai_virtual_router_api_t* saiStubHashTest::p_vr_api = NULL;
+sai_router_interface_api_t* saiStubHashTest::p_rif_api = NULL;
+sai_route_api_t* saiStubHashTest::p_route_api = NULL;
+sai_neighbor_api_t* saiStubHashTest::p_neighbor_api = NULL;
+sai_object_id_t saiStubHashTest::vr_id = 0;
+sai_object_id_t saiStubHashTest::lag_id = 0;
+
+static const int32_t hash_five_tuple[] = {
+    SAI_NATIVE_HASH_FIELD_SRC_IP, SAI_NATIVE_HASH_FIELD_DST_IP, SAI_NATIVE_HASH_FIELD_IP_PROTOCOL,
+    SAI_NATIVE_HASH_FIELD_L4_SRC_PORT, SAI_NATIVE_HASH_FIELD_L4_DST_PORT
+};
+
+static const int32_t hash_l2[] = {
+    SAI_NATIVE_HASH_FIELD_SRC_MAC, SAI_NATIVE_HASH_FIELD_DST_MAC,
+    SAI_NATIVE_HASH_FIELD_IN_PORT, SAI_NATIVE_HASH_FIELD_ETHERTYPE
+};
+
+/* UDP over IPv4 to the router MAC ..:01 */
+void saiStubHashTest::build_udp (frame_t *frame, sai_object_id_t in_port, uint32_t host_order_src,
+                                 uint32_t host_order_dst, uint16_t src_port, uint16_t dst_port)
+{
+    uint8_t  *eth = frame->buffer + STUB_DATAPLANE_HEADROOM;
+    uint8_t  *ip = eth + 14;
+    uint32_t  src = htonl (host_order_src), dst = htonl (host_order_dst);
+
+    memset (frame->buffer, 0, sizeof (frame->buffer));
+    eth[5]  = 0x01;
+    eth[6]  = 0x02;
+    eth[11] = 0x99;
+    eth[12] = 0x08;
+
+    ip[0]  = 0x45;
+    ip[3]  = 28;
+    ip[8]  = 64;
+    ip[9]  = 17;
+    memcpy (ip + 12, &src, 4);
+    memcpy (ip + 16, &dst, 4);
+    ip[20] = (uint8_t) (src_port >> 8);
+    ip[21] = (uint8_t) src_port;
+    ip[22] = (uint8_t) (dst_port >> 8);
+    ip[23] = (uint8_t) dst_port;
+
+    memset (&frame->packet, 0, sizeof (frame->packet));
+    frame->packet.data     = eth;
+    frame->packet.length   = 42;
+    frame->packet.headroom = STUB_DATAPLANE_HEADROOM;
+    frame->packet.in_port  = in_port;
+}
+
+sai_object_id_t saiStubHashTest::rif_create (sai_object_id_t port, uint8_t mac_id)
+{
+    sai_object_id_t id = SAI_NULL_OBJECT_ID;
+    sai_attribute_t attr[4];
+
+    memset (attr, 0, sizeof (attr));
+    attr[0].id           = SAI_ROUTER_INTERFACE_ATTR_VIRTUAL_ROUTER_ID;
+    attr[0].value.oid    = vr_id;
+    attr[1].id           = SAI_ROUTER_INTERFACE_ATTR_TYPE;
+    attr[1].value.s32    = SAI_ROUTER_INTERFACE_TYPE_PORT;
+    attr[2].id           = SAI_ROUTER_INTERFACE_ATTR_PORT_ID;
+    attr[2].value.oid    = port;
+    attr[3].id           = SAI_ROUTER_INTERFACE_ATTR_SRC_MAC_ADDRESS;
+    attr[3].value.mac[5] = mac_id;
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_rif_api->create_router_interface (&id, 4, attr));
+
+    return id;
+}
+
+void saiStubHashTest::route_create (uint32_t host_order_ip, uint32_t prefix_len,
+                                    sai_object_id_t next_hop)
+{
+    sai_unicast_route_entry_t route;
+    sai_attribute_t           attr;
+
+    memset (&route, 0, sizeof (route));
+    route.vr_id                    = vr_id;
+    route.destination.addr_family  = SAI_IP_ADDR_FAMILY_IPV4;
+    route.destination.addr.ip4     = htonl (host_order_ip);
+    route.destination.mask.ip4     = htonl (0xFFFFFFFFu << (32 - prefix_len));
+
+    attr.id        = SAI_ROUTE_ATTR_NEXT_HOP_ID;
+    attr.value.oid = next_hop;
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_route_api->create_route (&route, 1, &attr));
+}
+
+void saiStubHashTest::neighbor_create (sai_object_id_t rif, uint32_t host_order_ip,
+                                       uint8_t mac_id)
+{
+    sai_neighbor_entry_t neighbor;
+    sai_attribute_t      attr;
+
+    memset (&neighbor, 0, sizeof (neighbor));
+    neighbor.rif_id                 = rif;
+    neighbor.ip_address.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+    neighbor.ip_address.addr.ip4    = htonl (host_order_ip);
+
+    attr.id = SAI_NEIGHBOR_ATTR_DST_MAC_ADDRESS;
+    memset (attr.value.mac, 0, sizeof (sai_mac_t));
+    attr.value.mac[0] = 0x02;
+    attr.value.mac[5] = mac_id;
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS,
+               p_neighbor_api->create_neighbor_entry (&neighbor, 1, &attr));
+}
+
+sai_object_id_t saiStubHashTest::hash_create (uint32_t count, const int32_t *fields)
+{
+    sai_object_id_t id = SAI_NULL_OBJECT_ID;
+    sai_attribute_t attr;
+
+    attr.id                 = SAI_HASH_NATIVE_FIELD_LIST;
+    attr.value.s32list.count = count;
+    attr.value.s32list.list  = (int32_t*) fields;
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_hash_api->create_hash (&id, 1, &attr));
+
+    return id;
+}
+
+/* Route one frame of each of SAI_HASH_TEST_FLOWS flows from port 1 and
+ * count the frames sent per egress port */
+void saiStubHashTest::spread (uint32_t host_order_dst, std::map<sai_object_id_t, uint32_t> &ports)
+{
+    std::vector<frame_t>       frames (SAI_HASH_TEST_FLOWS);
+    std::vector<stub_packet_t> packets (SAI_HASH_TEST_FLOWS);
+
+    for (uint32_t i = 0; i < SAI_HASH_TEST_FLOWS; i++) {
+        build_udp (&frames[i], port_oid (1), 0x0B000000 + (i >> 4), host_order_dst,
+                   (uint16_t) (1024 + i), 53);
+        packets[i] = frames[i].packet;
+    }
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (SAI_HASH_TEST_FLOWS, packets.data ()));
+
+    ports.clear ();
+    for (uint32_t i = 0; i < SAI_HASH_TEST_FLOWS; i++) {
+        ASSERT_EQ (SAI_PACKET_ACTION_FORWARD, packets[i].packet_action);
+        ports[packets[i].out_port]++;
+    }
+}
+
+/*
+ * Topology:
+ *   port rif (port 1, mac ..:01), frames come in here
+ *   port rifs (ports 10-13) 10.1.i.0/24, ECMP over 10.1.i.2 for 20.0.0.0/8
+ *   LAG rif (ports 20-23) 10.5.0.0/24, neighbor 10.5.0.2 ..:50
+ */
+void saiStubHashTest::SetUpTestCase (void)
+{
+    sai_attribute_t   attr[3];
+    sai_object_id_t   rif_id, nh_id[SAI_HASH_TEST_PATHS], nhg_id, member_id;
+    sai_object_list_t list;
+
+    SetUpStubSwitch ();
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_HASH, (void **)&p_hash_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_LAG, (void **)&p_lag_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_NEXT_HOP, (void **)&p_nh_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_NEXT_HOP_GROUP, (void **)&p_nhg_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_VIRTUAL_ROUTER, (void **)&p_vr_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_ROUTER_INTERFACE, (void **)&p_rif_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_ROUTE, (void **)&p_route_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_NEIGHBOR, (void **)&p_neighbor_api));
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vr_api->create_virtual_router (&vr_id, 0, NULL));
+
+    rif_create (port_oid (1), 0x01);
+
+    for (uint32_t i = 0; i < SAI_HASH_TEST_PATHS; i++) {
+        sai_ip_address_t ip;
+
+        rif_id = rif_create (port_oid (10 + i), 0x01);
+        neighbor_create (rif_id, 0x0A010002 + (i << 8), (uint8_t) (0x10 + i));
+
+        memset (&ip, 0, sizeof (ip));
+        ip.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+        ip.addr.ip4    = htonl (0x0A010002 + (i << 8));
+        attr[0].id           = SAI_NEXT_HOP_ATTR_TYPE;
+        attr[0].value.s32    = SAI_NEXT_HOP_IP;
+        attr[1].id           = SAI_NEXT_HOP_ATTR_IP;
+        attr[1].value.ipaddr = ip;
+        attr[2].id           = SAI_NEXT_HOP_ATTR_ROUTER_INTERFACE_ID;
+        attr[2].value.oid    = rif_id;
+        ASSERT_EQ (SAI_STATUS_SUCCESS, p_nh_api->create_next_hop (&nh_id[i], 3, attr));
+    }
+
+    list.count            = SAI_HASH_TEST_PATHS;
+    list.list             = nh_id;
+    attr[0].id            = SAI_NEXT_HOP_GROUP_ATTR_TYPE;
+    attr[0].value.s32     = SAI_NEXT_HOP_GROUP_ECMP;
+    attr[1].id            = SAI_NEXT_HOP_GROUP_ATTR_NEXT_HOP_LIST;
+    attr[1].value.objlist = list;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_nhg_api->create_next_hop_group (&nhg_id, 2, attr));
+    route_create (0x14000000, 8, nhg_id);
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_lag_api->create_lag (&lag_id, 0, NULL));
+    for (uint32_t i = 0; i < SAI_HASH_TEST_PATHS; i++) {
+        attr[0].id        = SAI_LAG_MEMBER_ATTR_LAG_ID;
+        attr[0].value.oid = lag_id;
+        attr[1].id        = SAI_LAG_MEMBER_ATTR_PORT_ID;
+        attr[1].value.oid = port_oid (20 + i);
+        ASSERT_EQ (SAI_STATUS_SUCCESS, p_lag_api->create_lag_member (&member_id, 2, attr));
+    }
+    rif_id = rif_create (lag_id, 0x01);
+    neighbor_create (rif_id, 0x0A050002, 0x50);
+    route_create (0x0A050000, 24, rif_id);
+}
+
+/*
+ * Hash objects are validated, read back and refuse removal while the
+ * switch uses them; the switch hash algorithm and seed are range checked.
+ */
+TEST_F (saiStubHashTest, hash_crud)
+{
+    sai_object_id_t ecmp_default, lag_default, hash_id;
+    sai_attribute_t attr[2];
+    int32_t         fields[8];
+    int32_t         bad_field = SAI_NATIVE_HASH_FIELD_IN_PORT + 1;
+
+    attr[0].id = SAI_SWITCH_ATTR_ECMP_HASH;
+    attr[1].id = SAI_SWITCH_ATTR_LAG_HASH;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->get_switch_attribute (2, attr));
+    ecmp_default = attr[0].value.oid;
+    lag_default  = attr[1].value.oid;
+    EXPECT_NE (SAI_NULL_OBJECT_ID, ecmp_default);
+    EXPECT_NE (SAI_NULL_OBJECT_ID, lag_default);
+    EXPECT_NE (ecmp_default, lag_default);
+
+    /* The LAG hash starts with the fields the header documents */
+    attr[0].id                 = SAI_HASH_NATIVE_FIELD_LIST;
+    attr[0].value.s32list.count = 8;
+    attr[0].value.s32list.list  = fields;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hash_api->get_hash_attribute (lag_default, 1, attr));
+    ASSERT_EQ (4u, attr[0].value.s32list.count);
+    for (uint32_t i = 0; i < 4; i++) {
+        EXPECT_NE (std::end (hash_l2), std::find (std::begin (hash_l2), std::end (hash_l2), fields[i]));
+    }
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_hash_api->remove_hash (lag_default));
+
+    /* Unknown fields are rejected */
+    attr[0].value.s32list.count = 1;
+    attr[0].value.s32list.list  = &bad_field;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_hash_api->create_hash (&hash_id, 1, attr));
+
+    hash_id = hash_create (5, hash_five_tuple);
+    attr[0].value.s32list.count = 2;
+    attr[0].value.s32list.list  = fields;
+    EXPECT_EQ (SAI_STATUS_BUFFER_OVERFLOW, p_hash_api->get_hash_attribute (hash_id, 1, attr));
+    EXPECT_EQ (5u, attr[0].value.s32list.count);
+
+    attr[0].value.s32list.count = 2;
+    attr[0].value.s32list.list  = (int32_t*) hash_l2;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hash_api->set_hash_attribute (hash_id, attr));
+    attr[0].value.s32list.count = 8;
+    attr[0].value.s32list.list  = fields;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hash_api->get_hash_attribute (hash_id, 1, attr));
+    EXPECT_EQ (2u, attr[0].value.s32list.count);
+
+    /* Setting the switch hash moves the reference */
+    attr[0].id        = SAI_SWITCH_ATTR_ECMP_HASH;
+    attr[0].value.oid = hash_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (attr));
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_hash_api->remove_hash (hash_id));
+    attr[0].value.oid = ecmp_default;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (attr));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_hash_api->remove_hash (hash_id));
+    attr[0].value.oid = hash_id;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (attr));
+
+    attr[0].id = SAI_SWITCH_ATTR_ECMP_DEFAULT_HASH_ALGORITHM;
+    attr[1].id = SAI_SWITCH_ATTR_LAG_DEFAULT_HASH_SEED;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->get_switch_attribute (2, attr));
+    EXPECT_EQ (SAI_HASH_ALGORITHM_CRC, attr[0].value.s32);
+    EXPECT_EQ (0u, attr[1].value.u32);
+
+    attr[0].value.s32 = SAI_HASH_ALGORITHM_RANDOM + 1;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (&attr[0]));
+    attr[1].value.u32 = 0x1234;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (&attr[1]));
+    attr[1].value.u32 = 0;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->get_switch_attribute (1, &attr[1]));
+    EXPECT_EQ (0x1234u, attr[1].value.u32);
+    attr[1].value.u32 = 0;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (&attr[1]));
+}
+
+/*
+ * Only the fields of the hash object and the seed change the hash, and
+ * the L4 ports of non-first fragments are left out.
+ */
+TEST_F (saiStubHashTest, field_selection)
+{
+    frame_t         frames[4];
+    stub_packet_t   packets[4];
+    uint32_t        hashes[4];
+    sai_object_id_t ecmp_default, hash_id;
+    sai_attribute_t attr;
+    const int32_t   src_ip = SAI_NATIVE_HASH_FIELD_SRC_IP;
+
+    attr.id = SAI_SWITCH_ATTR_ECMP_HASH;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->get_switch_attribute (1, &attr));
+    ecmp_default = attr.value.oid;
+
+    /* Same source, other destination, other source, other source port */
+    build_udp (&frames[0], port_oid (1), 0x0B000001, 0x14000001, 1000, 53);
+    build_udp (&frames[1], port_oid (1), 0x0B000001, 0x14000002, 1000, 53);
+    build_udp (&frames[2], port_oid (1), 0x0B000002, 0x14000001, 1000, 53);
+    build_udp (&frames[3], port_oid (1), 0x0B000001, 0x14000001, 1001, 53);
+    for (uint32_t i = 0; i < 4; i++) {
+        packets[i] = frames[i].packet;
+    }
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_hash_calculate (STUB_HASH_TYPE_ECMP, 4, packets, hashes));
+    EXPECT_NE (hashes[0], hashes[1]);
+    EXPECT_NE (hashes[0], hashes[2]);
+    EXPECT_NE (hashes[0], hashes[3]);
+
+    hash_id = hash_create (1, &src_ip);
+    attr.value.oid = hash_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (&attr));
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_hash_calculate (STUB_HASH_TYPE_ECMP, 4, packets, hashes));
+    EXPECT_EQ (hashes[0], hashes[1]);
+    EXPECT_NE (hashes[0], hashes[2]);
+    EXPECT_EQ (hashes[0], hashes[3]);
+
+    /* The seed changes every hash, the XOR hash still ignores the unselected fields */
+    uint32_t seeded[4];
+    attr.id        = SAI_SWITCH_ATTR_ECMP_DEFAULT_HASH_SEED;
+    attr.value.u32 = 0xABCD;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (&attr));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_hash_calculate (STUB_HASH_TYPE_ECMP, 4, packets, seeded));
+    EXPECT_NE (hashes[0], seeded[0]);
+
+    attr.id        = SAI_SWITCH_ATTR_ECMP_DEFAULT_HASH_ALGORITHM;
+    attr.value.s32 = SAI_HASH_ALGORITHM_XOR;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (&attr));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_hash_calculate (STUB_HASH_TYPE_ECMP, 4, packets, hashes));
+    EXPECT_EQ (hashes[0], hashes[1]);
+    EXPECT_NE (hashes[0], hashes[2]);
+    EXPECT_NE (hashes[0], seeded[0]);
+
+    attr.value.s32 = SAI_HASH_ALGORITHM_CRC;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (&attr));
+    attr.id        = SAI_SWITCH_ATTR_ECMP_DEFAULT_HASH_SEED;
+    attr.value.u32 = 0;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (&attr));
+    attr.id        = SAI_SWITCH_ATTR_ECMP_HASH;
+    attr.value.oid = ecmp_default;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (&attr));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_hash_api->remove_hash (hash_id));
+
+    /* A later fragment carries no L4 header, the port bytes are payload */
+    frames[3].packet.data[14 + 6] = 0x00;
+    frames[3].packet.data[14 + 7] = 0x10;
+    frames[0].packet.data[14 + 6] = 0x00;
+    frames[0].packet.data[14 + 7] = 0x10;
+    packets[0] = frames[0].packet;
+    packets[3] = frames[3].packet;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_hash_calculate (STUB_HASH_TYPE_ECMP, 4, packets, hashes));
+    EXPECT_EQ (hashes[0], hashes[3]);
+}
+
+/*
+ * Routed flows spread over the ECMP members and stick to their member.
+ */
+TEST_F (saiStubHashTest, ecmp_spread)
+{
+    std::map<sai_object_id_t, uint32_t> ports, again;
+
+    spread (0x14000001, ports);
+    ASSERT_EQ ((size_t)SAI_HASH_TEST_PATHS, ports.size ());
+    for (uint32_t i = 0; i < SAI_HASH_TEST_PATHS; i++) {
+        EXPECT_EQ (1u, ports.count (port_oid (10 + i)));
+        EXPECT_GT (ports[port_oid (10 + i)], SAI_HASH_TEST_FLOWS / SAI_HASH_TEST_PATHS / 2);
+    }
+
+    spread (0x14000001, again);
+    EXPECT_EQ (ports, again);
+}
+
+/*
+ * A router interface on a LAG sends on the members by the LAG hash. The
+ * default L2 hash sees the same MACs and in port on every routed frame
+ * and keeps them on one member, an L3 hash spreads them.
+ */
+TEST_F (saiStubHashTest, lag_spread)
+{
+    std::map<sai_object_id_t, uint32_t> ports;
+    sai_object_id_t                     lag_default, hash_id;
+    sai_attribute_t                     attr;
+
+    spread (0x0A050002, ports);
+    ASSERT_EQ (1u, ports.size ());
+    EXPECT_GE (ports.begin ()->first, port_oid (20));
+    EXPECT_LE (ports.begin ()->first, port_oid (20 + SAI_HASH_TEST_PATHS - 1));
+
+    attr.id = SAI_SWITCH_ATTR_LAG_HASH;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->get_switch_attribute (1, &attr));
+    lag_default = attr.value.oid;
+
+    hash_id        = hash_create (5, hash_five_tuple);
+    attr.value.oid = hash_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (&attr));
+
+    spread (0x0A050002, ports);
+    ASSERT_EQ ((size_t)SAI_HASH_TEST_PATHS, ports.size ());
+    for (uint32_t i = 0; i < SAI_HASH_TEST_PATHS; i++) {
+        EXPECT_GT (ports[port_oid (20 + i)], SAI_HASH_TEST_FLOWS / SAI_HASH_TEST_PATHS / 2);
+    }
+
+    attr.value.oid = lag_default;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (&attr));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_hash_api->remove_hash (hash_id));
+}
+
+/*
+ * Hash rate and evenness over 16 buckets, the largest bucket against the
+ * mean, for each algorithm on the 5-tuple and the CRC on L2 fields.
+ */
+TEST_F (saiStubHashTest, hash_rate)
+{
+    const uint32_t             frame_count = 65536, burst = 256, rounds = 16, buckets = 16;
+    std::vector<frame_t>       frames (frame_count);
+    std::vector<stub_packet_t> packets (frame_count);
+    std::vector<uint32_t>      hashes (frame_count);
+    sai_object_id_t            ecmp_default, hash_id;
+    sai_attribute_t            attr;
+
+    struct {
+        const char    *name;
+        sai_int32_t    algorithm;
+        uint32_t       field_count;
+        const int32_t *fields;
+    } configs[] = {
+        { "CRC 5-tuple", SAI_HASH_ALGORITHM_CRC, 5, hash_five_tuple },
+        { "XOR 5-tuple", SAI_HASH_ALGORITHM_XOR, 5, hash_five_tuple },
+        { "RANDOM", SAI_HASH_ALGORITHM_RANDOM, 5, hash_five_tuple },
+        { "CRC L2", SAI_HASH_ALGORITHM_CRC, 4, hash_l2 },
+    };
+
+    for (uint32_t i = 0; i < frame_count; i++) {
+        build_udp (&frames[i], port_oid (1 + (i & 7)), 0x0B000000 + (i >> 6), 0x14000000 + (i * 7919),
+                   (uint16_t) (1024 + i), 53);
+        packets[i] = frames[i].packet;
+    }
+
+    attr.id = SAI_SWITCH_ATTR_ECMP_HASH;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->get_switch_attribute (1, &attr));
+    ecmp_default = attr.value.oid;
+
+    for (auto &config : configs) {
+        uint32_t count[buckets] = { 0 }, largest = 0;
+
+        hash_id        = hash_create (config.field_count, config.fields);
+        attr.id        = SAI_SWITCH_ATTR_ECMP_HASH;
+        attr.value.oid = hash_id;
+        ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (&attr));
+        attr.id        = SAI_SWITCH_ATTR_ECMP_DEFAULT_HASH_ALGORITHM;
+        attr.value.s32 = config.algorithm;
+        ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (&attr));
+
+        auto start = std::chrono::steady_clock::now ();
+        for (uint32_t r = 0; r < rounds; r++) {
+            for (uint32_t i = 0; i < frame_count; i += burst) {
+                ASSERT_EQ (SAI_STATUS_SUCCESS,
+                           stub_hash_calculate (STUB_HASH_TYPE_ECMP, burst, &packets[i], &hashes[i]));
+            }
+        }
+        double sec = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+        for (uint32_t i = 0; i < frame_count; i++) {
+            count[hashes[i] % buckets]++;
+        }
+        for (uint32_t b = 0; b < buckets; b++) {
+            largest = std::max (largest, count[b]);
+        }
+
+        printf ("%s: %.2f Mpps, largest of %u buckets %.3f of the mean\n", config.name,
+                frame_count * rounds / sec / 1e6, buckets, (double)largest * buckets / frame_count);
+
+        /* Only the 5-tuple differs per frame, the L2 fields repeat per port */
+        if (SAI_HASH_ALGORITHM_CRC == config.algorithm && 5 == config.field_count) {
+            EXPECT_LT ((double)largest * buckets / frame_count, 1.1);
+        }
+
+        attr.id        = SAI_SWITCH_ATTR_ECMP_HASH;
+        attr.value.oid = ecmp_default;
+        ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (&attr));
+        EXPECT_EQ (SAI_STATUS_SUCCESS, p_hash_api->remove_hash (hash_id));
+    }
+
+    attr.id        = SAI_SWITCH_ATTR_ECMP_DEFAULT_HASH_ALGORITHM;
+    attr.value.s32 = SAI_HASH_ALGORITHM_CRC;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (&attr));
+}
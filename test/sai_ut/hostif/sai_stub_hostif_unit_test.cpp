@@ -0,0 +1,482 @@
+/************************************************************************
+*    Licensed under the Apache License, Version 2.0 (the "License"); you may
+*    not use this file except in compliance with the License. You may obtain
+*    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+*
+*    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+*    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+*    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+*    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+*
+*    See the Apache Version 2.0 License for specific language governing
+*    permissions and limitations under the License.
+*
+*
+* Module Name:
+*
+*    sai_stub_hostif_unit_test.cpp
+*
+* Abstract:
+*
+*    This file contains tests for the stub host interfaces, the kernel
+*    interfaces behind them and the packet I/O through TAP interfaces. The
+*    TAP tests need access to /dev/net/tun and pass without checking
+*    anything when it is not available.
+*
+*************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/sai_stub_unit_test_utils.h"
+
+extern "C" {
+#include "sai.h"
+#include "saitypes.h"
+#include "saistatus.h"
+#include "saiswitch.h"
+#include "saihostintf.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_hostif.h"
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <linux/if_packet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+}
+
+/* Ethertype of the test frames, frames the kernel sends on its own are ignored */
+#define HOSTIF_TEST_ETHERTYPE 0x88b5
+#define HOSTIF_TEST_LLDP      0x88cc
+
+/* Written by the stub I/O thread */
+static uint32_t        event_count;
+static sai_object_id_t event_port;
+
+static void hostif_test_packet_event (const void *buffer, sai_size_t buffer_size,
+                                      uint32_t attr_count, const sai_attribute_t *attr_list)
+{
+    const uint8_t *frame = (const uint8_t *)buffer;
+
+    if ((buffer_size < 14) || (HOSTIF_TEST_ETHERTYPE != ((frame[12] << 8) | frame[13]))) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < attr_count; i++) {
+        if (SAI_HOSTIF_PACKET_INGRESS_PORT == attr_list[i].id) {
+            __atomic_store_n (&event_port, attr_list[i].value.oid, __ATOMIC_RELAXED);
+        }
+    }
+
+    __atomic_fetch_add (&event_count, 1, __ATOMIC_RELEASE);
+}
+
+class saiStubHostifTest : public saiStubTest
+{
+    protected:
+        static void SetUpTestCase (void);
+
+        virtual void TearDown (void)
+        {
+            stub_host_interface_set_netdev_kind (STUB_HOSTIF_NETDEV_NONE);
+        }
+
+        static bool netdev_exists (const char *name);
+        static bool tap_available (void);
+        static sai_status_t hostif_create (const char *name, sai_object_id_t *hif_id);
+        static void switch_init (bool packet_events);
+        static int peer_open (const char *name, uint16_t ethertype);
+        static void lldp_run (sai_object_id_t in_port, uint32_t count);
+        static void build_frame (uint8_t *frame, uint32_t length, uint8_t seq);
+
+        static sai_hostif_api_t *p_hostif_api;
+};
+
+sai_hostif_api_t* saiStubHostifTest::p_hostif_api = NULL;
+
+bool saiStubHostifTest::netdev_exists (const char *name)
+{
+    char path[64];
+
+    snprintf (path, sizeof (path), "/sys/class/net/%s", name);
+
+    return (0 == access (path, F_OK));
+}
+
+bool saiStubHostifTest::tap_available (void)
+{
+    if (0 != access ("/dev/net/tun", R_OK | W_OK)) {
+        printf ("/dev/net/tun not available, skipping TAP checks\n");
+        return false;
+    }
+
+    return true;
+}
+
+sai_status_t saiStubHostifTest::hostif_create (const char *name, sai_object_id_t *hif_id)
+{
+    sai_attribute_t attr_list[3];
+
+    attr_list[0].id = SAI_HOSTIF_ATTR_TYPE;
+    attr_list[0].value.s32 = SAI_HOSTIF_TYPE_NETDEV;
+    attr_list[1].id = SAI_HOSTIF_ATTR_RIF_OR_PORT_ID;
+    attr_list[1].value.oid = port_oid (1);
+    attr_list[2].id = SAI_HOSTIF_ATTR_NAME;
+    memset (attr_list[2].value.chardata, 0, sizeof (attr_list[2].value.chardata));
+    strncpy (attr_list[2].value.chardata, name, HOSTIF_NAME_SIZE - 1);
+
+    return p_hostif_api->create_hostif (hif_id, 3, attr_list);
+}
+
+void saiStubHostifTest::switch_init (bool packet_events)
+{
+    sai_switch_notification_t notifications;
+
+    memset (&notifications, 0, sizeof (notifications));
+    if (packet_events) {
+        notifications.on_packet_event = hostif_test_packet_event;
+    }
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS,
+               p_switch_api->initialize_switch (0, (char *)"0xb850", NULL, &notifications));
+}
+
+/* Bring a TAP up and open a packet socket on it, the peer end of the wire */
+int saiStubHostifTest::peer_open (const char *name, uint16_t ethertype)
+{
+    struct sockaddr_ll addr;
+    struct ifreq       ifr;
+    int                fd;
+
+    fd = socket (AF_PACKET, SOCK_RAW, htons (ethertype));
+    if (0 > fd) {
+        return -1;
+    }
+
+    memset (&ifr, 0, sizeof (ifr));
+    strncpy (ifr.ifr_name, name, IFNAMSIZ - 1);
+    ioctl (fd, SIOCGIFFLAGS, &ifr);
+    ifr.ifr_flags |= IFF_UP;
+    ioctl (fd, SIOCSIFFLAGS, &ifr);
+
+    memset (&addr, 0, sizeof (addr));
+    addr.sll_family   = AF_PACKET;
+    addr.sll_protocol = htons (ethertype);
+    addr.sll_ifindex  = if_nametoindex (name);
+
+    if (0 > bind (fd, (struct sockaddr *)&addr, sizeof (addr))) {
+        close (fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+void saiStubHostifTest::build_frame (uint8_t *frame, uint32_t length, uint8_t seq)
+{
+    memset (frame, seq, length);
+    memset (frame, 0xff, 6);
+    frame[6]  = 0x02;
+    frame[12] = HOSTIF_TEST_ETHERTYPE >> 8;
+    frame[13] = HOSTIF_TEST_ETHERTYPE & 0xff;
+}
+
+/* LLDP frames through a pcap run, trapped ones go to the host */
+void saiStubHostifTest::lldp_run (sai_object_id_t in_port, uint32_t count)
+{
+    static const uint8_t dst[] = { 0x01, 0x80, 0xC2, 0x00, 0x00, 0x0E };
+    uint8_t              frame[64];
+    char                 in_path[] = "/tmp/sai_hostif_in_XXXXXX";
+    uint32_t             file_header[6] = { 0xA1B2C3D4, 0x00040002, 0, 0, 65535, 1 };
+    uint32_t             record[4] = { 0, 0, sizeof (frame), sizeof (frame) };
+    FILE                *file;
+
+    close (mkstemp (in_path));
+    ASSERT_TRUE (NULL != (file = fopen (in_path, "wb")));
+    fwrite (file_header, sizeof (file_header), 1, file);
+    for (uint32_t i = 0; i < count; i++) {
+        memset (frame, i, sizeof (frame));
+        memcpy (frame, dst, sizeof (dst));
+        frame[6]  = 0x02;
+        frame[12] = HOSTIF_TEST_LLDP >> 8;
+        frame[13] = HOSTIF_TEST_LLDP & 0xff;
+        fwrite (record, sizeof (record), 1, file);
+        fwrite (frame, sizeof (frame), 1, file);
+    }
+    fclose (file);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_run_pcap (in_path, in_port, NULL));
+    unlink (in_path);
+}
+
+void saiStubHostifTest::SetUpTestCase (void)
+{
+    /* Start without kernel interfaces, tests switch kinds as they need */
+    profile_value_set (STUB_HOSTIF_NETDEV_PROFILE_KEY, "none");
+
+    SetUpStubSwitch ();
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_HOST_INTERFACE, (void **)&p_hostif_api));
+}
+
+/*
+ * Host interfaces keep their attributes, with the profile key selecting
+ * no kernel interface none is created.
+ */
+TEST_F(saiStubHostifTest, attributes_without_netdev)
+{
+    sai_object_id_t hif_id;
+    sai_attribute_t attr;
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, hostif_create ("sut_none0", &hif_id));
+    EXPECT_FALSE (netdev_exists ("sut_none0"));
+
+    attr.id = SAI_HOSTIF_ATTR_NAME;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->get_hostif_attribute (hif_id, 1, &attr));
+    EXPECT_STREQ ("sut_none0", attr.value.chardata);
+
+    attr.id = SAI_HOSTIF_ATTR_RIF_OR_PORT_ID;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->get_hostif_attribute (hif_id, 1, &attr));
+    EXPECT_EQ (port_oid (1), attr.value.oid);
+
+    attr.id = SAI_HOSTIF_ATTR_TYPE;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->get_hostif_attribute (hif_id, 1, &attr));
+    EXPECT_EQ (SAI_HOSTIF_TYPE_NETDEV, attr.value.s32);
+
+    attr.id = SAI_HOSTIF_ATTR_NAME;
+    strcpy (attr.value.chardata, "sut_none1");
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_hostif_attribute (hif_id, &attr));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->get_hostif_attribute (hif_id, 1, &attr));
+    EXPECT_STREQ ("sut_none1", attr.value.chardata);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->remove_hostif (hif_id));
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_hostif_api->remove_hostif (hif_id));
+}
+
+/*
+ * Bulk sections do not nest, and a commit needs an open bulk.
+ */
+TEST_F(saiStubHostifTest, bulk_sections)
+{
+    sai_object_id_t hif_ids[64];
+    char            name[HOSTIF_NAME_SIZE];
+
+    EXPECT_NE (SAI_STATUS_SUCCESS, stub_host_interface_bulk_commit ());
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_host_interface_bulk_begin ());
+    EXPECT_NE (SAI_STATUS_SUCCESS, stub_host_interface_bulk_begin ());
+
+    for (uint32_t i = 0; i < 64; i++) {
+        snprintf (name, sizeof (name), "sut_bulk%u", i);
+        ASSERT_EQ (SAI_STATUS_SUCCESS, hostif_create (name, &hif_ids[i]));
+    }
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, stub_host_interface_bulk_commit ());
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_host_interface_bulk_begin ());
+
+    for (uint32_t i = 0; i < 64; i++) {
+        EXPECT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->remove_hostif (hif_ids[i]));
+    }
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, stub_host_interface_bulk_commit ());
+}
+
+/*
+ * A TAP kernel interface lives as long as its host interface and follows
+ * its renames.
+ */
+TEST_F(saiStubHostifTest, tap_netdev)
+{
+    sai_object_id_t hif_id;
+    sai_attribute_t attr;
+
+    if (!tap_available ()) {
+        return;
+    }
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_host_interface_set_netdev_kind (STUB_HOSTIF_NETDEV_TAP));
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, hostif_create ("sut_tap0", &hif_id));
+    EXPECT_TRUE (netdev_exists ("sut_tap0"));
+
+    attr.id = SAI_HOSTIF_ATTR_NAME;
+    strcpy (attr.value.chardata, "sut_tap1");
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_hostif_attribute (hif_id, &attr));
+    EXPECT_FALSE (netdev_exists ("sut_tap0"));
+    EXPECT_TRUE (netdev_exists ("sut_tap1"));
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->remove_hostif (hif_id));
+    EXPECT_FALSE (netdev_exists ("sut_tap1"));
+}
+
+/*
+ * Without a packet notification, send_packet writes into the TAP and
+ * recv_packet returns what the kernel sent on it.
+ */
+TEST_F(saiStubHostifTest, tap_send_recv)
+{
+    sai_object_id_t hif_id;
+    sai_attribute_t attrs[2];
+    uint32_t        attr_count;
+    uint8_t         frame[128], received[256];
+    sai_size_t      size;
+    sai_status_t    status = SAI_STATUS_ITEM_NOT_FOUND;
+    int             peer;
+
+    if (!tap_available ()) {
+        return;
+    }
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_host_interface_set_netdev_kind (STUB_HOSTIF_NETDEV_TAP));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, hostif_create ("sut_tap2", &hif_id));
+    ASSERT_LE (0, peer = peer_open ("sut_tap2", HOSTIF_TEST_ETHERTYPE));
+
+    /* switch to kernel */
+    build_frame (frame, sizeof (frame), 1);
+    attrs[0].id = SAI_HOSTIF_PACKET_TX_TYPE;
+    attrs[0].value.s32 = SAI_HOSTIF_TX_TYPE_PIPELINE_BYPASS;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_hostif_api->send_packet (hif_id, frame, sizeof (frame), 0, attrs));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->send_packet (hif_id, frame, sizeof (frame), 1, attrs));
+    EXPECT_EQ ((ssize_t)sizeof (frame), recv (peer, received, sizeof (received), 0));
+    EXPECT_EQ (0, memcmp (frame, received, sizeof (frame)));
+
+    /* kernel to switch, the frame is kept while the buffer is too small */
+    build_frame (frame, sizeof (frame), 2);
+    ASSERT_EQ ((ssize_t)sizeof (frame), send (peer, frame, sizeof (frame), 0));
+
+    for (uint32_t i = 0; (i < 100) && (SAI_STATUS_BUFFER_OVERFLOW != status); i++) {
+        size = 16;
+        attr_count = 2;
+        if (SAI_STATUS_ITEM_NOT_FOUND ==
+            (status = p_hostif_api->recv_packet (hif_id, received, &size, &attr_count, attrs))) {
+            usleep (10000);
+        }
+    }
+    ASSERT_EQ (SAI_STATUS_BUFFER_OVERFLOW, status);
+    EXPECT_EQ (sizeof (frame), size);
+
+    size = sizeof (received);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->recv_packet (hif_id, received, &size, &attr_count, attrs));
+    EXPECT_EQ (sizeof (frame), size);
+    EXPECT_EQ (0, memcmp (frame, received, sizeof (frame)));
+    ASSERT_EQ (1, attr_count);
+    EXPECT_EQ (SAI_HOSTIF_PACKET_INGRESS_PORT, attrs[0].id);
+    EXPECT_EQ (port_oid (1), attrs[0].value.oid);
+
+    close (peer);
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->remove_hostif (hif_id));
+}
+
+/*
+ * With a packet notification, the I/O thread delivers every frame the
+ * kernel sends on a TAP.
+ */
+TEST_F(saiStubHostifTest, tap_packet_event)
+{
+    sai_object_id_t hif_id;
+    sai_attribute_t attr;
+    uint32_t        attr_count = 1;
+    uint8_t         frame[256];
+    sai_size_t      size = sizeof (frame);
+    uint32_t        count = 0;
+    int             peer;
+
+    if (!tap_available ()) {
+        return;
+    }
+
+    switch_init (true);
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_host_interface_set_netdev_kind (STUB_HOSTIF_NETDEV_TAP));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, hostif_create ("sut_tap3", &hif_id));
+    ASSERT_LE (0, peer = peer_open ("sut_tap3", HOSTIF_TEST_ETHERTYPE));
+
+    for (uint32_t i = 0; i < 1000; i++) {
+        build_frame (frame, sizeof (frame), (uint8_t)i);
+        ASSERT_EQ ((ssize_t)sizeof (frame), send (peer, frame, sizeof (frame), 0));
+    }
+
+    for (uint32_t i = 0; (i < 200) && (count < 1000); i++) {
+        usleep (10000);
+        count = __atomic_load_n (&event_count, __ATOMIC_ACQUIRE);
+    }
+    EXPECT_EQ (1000, count);
+    EXPECT_EQ (port_oid (1), __atomic_load_n (&event_port, __ATOMIC_RELAXED));
+
+    /* no polling while the notification takes the frames */
+    EXPECT_EQ (SAI_STATUS_NOT_SUPPORTED, p_hostif_api->recv_packet (hif_id, frame, &size, &attr_count, &attr));
+
+    close (peer);
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->remove_hostif (hif_id));
+
+    p_switch_api->shutdown_switch (false);
+    switch_init (false);
+}
+
+/*
+ * Trapped frames of the netdev channel are written to the TAP of their
+ * ingress port, frames of the fd channel to the TAP of the trap's host
+ * interface, each frame once.
+ */
+TEST_F(saiStubHostifTest, trap_channels_to_tap)
+{
+    sai_object_id_t hif_id;
+    sai_attribute_t attr;
+    struct timeval  timeout = { 0, 200000 };
+    uint8_t         received[256];
+    uint32_t        count;
+    int             peer;
+
+    if (!tap_available ()) {
+        return;
+    }
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_host_interface_set_netdev_kind (STUB_HOSTIF_NETDEV_TAP));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, hostif_create ("sut_tap4", &hif_id));
+    ASSERT_LE (0, peer = peer_open ("sut_tap4", HOSTIF_TEST_LLDP));
+    setsockopt (peer, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof (timeout));
+
+    attr.id        = SAI_HOSTIF_TRAP_ATTR_PACKET_ACTION;
+    attr.value.s32 = SAI_PACKET_ACTION_TRAP;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LLDP, &attr));
+    attr.id        = SAI_HOSTIF_TRAP_ATTR_TRAP_CHANNEL;
+    attr.value.s32 = SAI_HOSTIF_TRAP_CHANNEL_NETDEV;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LLDP, &attr));
+
+    /* No host interface on port 2 */
+    lldp_run (port_oid (2), 3);
+    lldp_run (port_oid (1), 3);
+    for (count = 0; 0 < recv (peer, received, sizeof (received), 0); count++) {
+        EXPECT_EQ (count, received[14]);
+    }
+    EXPECT_EQ (3u, count);
+
+    attr.id        = SAI_HOSTIF_TRAP_ATTR_FD;
+    attr.value.oid = hif_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LLDP, &attr));
+    attr.id        = SAI_HOSTIF_TRAP_ATTR_TRAP_CHANNEL;
+    attr.value.s32 = SAI_HOSTIF_TRAP_CHANNEL_FD;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LLDP, &attr));
+
+    lldp_run (port_oid (2), 3);
+    for (count = 0; 0 < recv (peer, received, sizeof (received), 0); count++) {
+        EXPECT_EQ (count, received[14]);
+    }
+    EXPECT_EQ (3u, count);
+
+    attr.id        = SAI_HOSTIF_TRAP_ATTR_TRAP_CHANNEL;
+    attr.value.s32 = SAI_HOSTIF_TRAP_CHANNEL_CB;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LLDP, &attr));
+    attr.id        = SAI_HOSTIF_TRAP_ATTR_FD;
+    attr.value.oid = SAI_NULL_OBJECT_ID;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LLDP, &attr));
+    attr.id        = SAI_HOSTIF_TRAP_ATTR_PACKET_ACTION;
+    attr.value.s32 = SAI_PACKET_ACTION_DROP;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LLDP, &attr));
+
+    close (peer);
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->remove_hostif (hif_id));
+}
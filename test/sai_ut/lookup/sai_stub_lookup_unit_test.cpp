@@ -0,0 +1,389 @@
+/************************************************************************
+*    Licensed under the Apache License, Version 2.0 (the "License"); you may
+*    not use this file except in compliance with the License. You may obtain
+*    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+*
+*    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+*    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+*    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+*    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+*
+*    See the Apache Version 2.0 License for specific language governing
+*    permissions and limitations under the License.
+*
+*
+* Module Name:
+*
+*    sai_stub_lookup_unit_test.cpp
+*
+* Abstract:
+*
+*    This file contains tests for the stub software forwarding lookup.
+*    A small topology is programmed through the SAI API and the lookup
+*    results are checked against it; the rate test reports the lookup
+*    rate of the single and bulk variants.
+*
+*************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/sai_stub_unit_test_utils.h"
+
+#include <chrono>
+#include <vector>
+
+extern "C" {
+#include "sai.h"
+#include "saitypes.h"
+#include "saistatus.h"
+#include "saiswitch.h"
+#include "saifdb.h"
+#include "sainexthop.h"
+#include "sainexthopgroup.h"
+#include "sairouter.h"
+#include "sairouterintf.h"
+#include "sairoute.h"
+#include "saineighbor.h"
+#include "stub_sai_lookup.h"
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <string.h>
+}
+
+#define SAI_LOOKUP_ECMP_PATHS   4
+#define SAI_LOOKUP_RATE_ROUTES  65536
+#define SAI_LOOKUP_RATE_BATCH   64
+#define SAI_LOOKUP_RATE_ROUNDS  40
+
+class saiStubLookupTest : public saiStubTest
+{
+    protected:
+        static void SetUpTestCase (void);
+
+        static sai_ip_address_t ip4 (uint32_t host_order_ip);
+        static void route_create (uint32_t host_order_ip, uint32_t prefix_len,
+                                  sai_object_id_t next_hop, int32_t action);
+        static void neighbor_create (sai_object_id_t rif, uint32_t host_order_ip,
+                                     uint8_t mac_id);
+        static sai_object_id_t next_hop_create (sai_object_id_t rif,
+                                                uint32_t host_order_ip);
+
+        static sai_fdb_api_t              *p_fdb_api;
+        static sai_next_hop_api_t         *p_nh_api;
+        static sai_next_hop_group_api_t   *p_nhg_api;
+        static sai_virtual_router_api_t   *p_vr_api;
+        static sai_router_interface_api_t *p_rif_api;
+        static sai_route_api_t            *p_route_api;
+        static sai_neighbor_api_t         *p_neighbor_api;
+
+        static sai_object_id_t vr_id;
+        static sai_object_id_t port_rif_id;
+        static sai_object_id_t vlan_rif_id;
+        static sai_object_id_t nh_id;
+        static sai_object_id_t nhg_id;
+        static sai_object_id_t ecmp_nh_id[SAI_LOOKUP_ECMP_PATHS];
+};
+
+sai_fdb_api_t* saiStubLookupTest::p_fdb_api = NULL;
+sai_next_hop_api_t* saiStubLookupTest::p_nh_api = NULL;
+sai_next_hop_group_api_t* saiStubLookupTest::p_nhg_api = NULL;
+sai_virtual_router_api_t* saiStubLookupTest::p_vr_api = NULL;
+sai_router_interface_api_t* saiStubLookupTest::p_rif_api = NULL;
+sai_route_api_t* saiStubLookupTest::p_route_api = NULL;
+sai_neighbor_api_t* saiStubLookupTest::p_neighbor_api = NULL;
+sai_object_id_t saiStubLookupTest::vr_id = 0;
+sai_object_id_t saiStubLookupTest::port_rif_id = 0;
+sai_object_id_t saiStubLookupTest::vlan_rif_id = 0;
+sai_object_id_t saiStubLookupTest::nh_id = 0;
+sai_object_id_t saiStubLookupTest::nhg_id = 0;
+sai_object_id_t saiStubLookupTest::ecmp_nh_id[SAI_LOOKUP_ECMP_PATHS];
+
+sai_ip_address_t saiStubLookupTest::ip4 (uint32_t host_order_ip)
+{
+    sai_ip_address_t ip;
+
+    memset (&ip, 0, sizeof (ip));
+    ip.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+    ip.addr.ip4    = htonl (host_order_ip);
+
+    return ip;
+}
+
+void saiStubLookupTest::route_create (uint32_t host_order_ip, uint32_t prefix_len,
+                                      sai_object_id_t next_hop, int32_t action)
+{
+    sai_unicast_route_entry_t route;
+    sai_attribute_t           attr[2];
+
+    memset (&route, 0, sizeof (route));
+    route.vr_id                    = vr_id;
+    route.destination.addr_family  = SAI_IP_ADDR_FAMILY_IPV4;
+    route.destination.addr.ip4     = htonl (host_order_ip);
+    route.destination.mask.ip4     = htonl (prefix_len ? (0xFFFFFFFFu << (32 - prefix_len)) : 0);
+
+    attr[0].id        = SAI_ROUTE_ATTR_NEXT_HOP_ID;
+    attr[0].value.oid = next_hop;
+    attr[1].id        = SAI_ROUTE_ATTR_PACKET_ACTION;
+    attr[1].value.s32 = action;
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_route_api->create_route (&route, 2, attr));
+}
+
+void saiStubLookupTest::neighbor_create (sai_object_id_t rif, uint32_t host_order_ip,
+                                         uint8_t mac_id)
+{
+    sai_neighbor_entry_t neighbor;
+    sai_attribute_t      attr;
+
+    memset (&neighbor, 0, sizeof (neighbor));
+    neighbor.rif_id     = rif;
+    neighbor.ip_address = ip4 (host_order_ip);
+
+    attr.id = SAI_NEIGHBOR_ATTR_DST_MAC_ADDRESS;
+    memset (attr.value.mac, 0, sizeof (sai_mac_t));
+    attr.value.mac[0] = 0x02;
+    attr.value.mac[5] = mac_id;
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS,
+               p_neighbor_api->create_neighbor_entry (&neighbor, 1, &attr));
+}
+
+sai_object_id_t saiStubLookupTest::next_hop_create (sai_object_id_t rif,
+                                                    uint32_t host_order_ip)
+{
+    sai_object_id_t id = SAI_NULL_OBJECT_ID;
+    sai_attribute_t attr[3];
+
+    attr[0].id           = SAI_NEXT_HOP_ATTR_TYPE;
+    attr[0].value.s32    = SAI_NEXT_HOP_IP;
+    attr[1].id           = SAI_NEXT_HOP_ATTR_IP;
+    attr[1].value.ipaddr = ip4 (host_order_ip);
+    attr[2].id           = SAI_NEXT_HOP_ATTR_ROUTER_INTERFACE_ID;
+    attr[2].value.oid    = rif;
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_nh_api->create_next_hop (&id, 3, attr));
+
+    return id;
+}
+
+/*
+ * Topology:
+ *   port rif (port 1, mac ..:01) 10.0.0.0/24, next hop 10.0.0.2
+ *   vlan rif (vlan 100, mac ..:02) 10.1.0.0/24, ECMP over 10.1.0.1-4
+ */
+void saiStubLookupTest::SetUpTestCase (void)
+{
+    sai_attribute_t   attr[4];
+    sai_object_list_t list;
+    sai_fdb_entry_t   fdb_entry;
+
+    SetUpStubSwitch ();
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_FDB, (void **)&p_fdb_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_NEXT_HOP, (void **)&p_nh_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_NEXT_HOP_GROUP, (void **)&p_nhg_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_VIRTUAL_ROUTER, (void **)&p_vr_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_ROUTER_INTERFACE, (void **)&p_rif_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_ROUTE, (void **)&p_route_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_NEIGHBOR, (void **)&p_neighbor_api));
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vr_api->create_virtual_router (&vr_id, 0, NULL));
+
+    memset (attr, 0, sizeof (attr));
+    attr[0].id        = SAI_ROUTER_INTERFACE_ATTR_VIRTUAL_ROUTER_ID;
+    attr[0].value.oid = vr_id;
+    attr[1].id        = SAI_ROUTER_INTERFACE_ATTR_TYPE;
+    attr[1].value.s32 = SAI_ROUTER_INTERFACE_TYPE_PORT;
+    attr[2].id        = SAI_ROUTER_INTERFACE_ATTR_PORT_ID;
+    attr[2].value.oid = port_oid (1);
+    attr[3].id        = SAI_ROUTER_INTERFACE_ATTR_SRC_MAC_ADDRESS;
+    attr[3].value.mac[5] = 0x01;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_rif_api->create_router_interface (&port_rif_id, 4, attr));
+
+    attr[1].value.s32    = SAI_ROUTER_INTERFACE_TYPE_VLAN;
+    attr[2].id           = SAI_ROUTER_INTERFACE_ATTR_VLAN_ID;
+    attr[2].value.u16    = 100;
+    attr[3].value.mac[5] = 0x02;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_rif_api->create_router_interface (&vlan_rif_id, 4, attr));
+
+    nh_id = next_hop_create (port_rif_id, 0x0A000002);
+    neighbor_create (port_rif_id, 0x0A000002, 0x10);
+
+    for (uint32_t i = 0; i < SAI_LOOKUP_ECMP_PATHS; i++) {
+        ecmp_nh_id[i] = next_hop_create (vlan_rif_id, 0x0A010001 + i);
+        neighbor_create (vlan_rif_id, 0x0A010001 + i, (uint8_t) (0x20 + i));
+
+        /* Each ECMP neighbor is learned on its own port */
+        memset (&fdb_entry, 0, sizeof (fdb_entry));
+        fdb_entry.mac_address[0] = 0x02;
+        fdb_entry.mac_address[5] = (uint8_t) (0x20 + i);
+        fdb_entry.vlan_id        = 100;
+        attr[0].id        = SAI_FDB_ENTRY_ATTR_TYPE;
+        attr[0].value.s32 = SAI_FDB_ENTRY_STATIC;
+        attr[1].id        = SAI_FDB_ENTRY_ATTR_PORT_ID;
+        attr[1].value.oid = port_oid (10 + i);
+        attr[2].id        = SAI_FDB_ENTRY_ATTR_PACKET_ACTION;
+        attr[2].value.s32 = SAI_PACKET_ACTION_FORWARD;
+        ASSERT_EQ (SAI_STATUS_SUCCESS, p_fdb_api->create_fdb_entry (&fdb_entry, 3, attr));
+    }
+
+    list.count        = SAI_LOOKUP_ECMP_PATHS;
+    list.list         = ecmp_nh_id;
+    attr[0].id        = SAI_NEXT_HOP_GROUP_ATTR_TYPE;
+    attr[0].value.s32 = SAI_NEXT_HOP_GROUP_ECMP;
+    attr[1].id        = SAI_NEXT_HOP_GROUP_ATTR_NEXT_HOP_LIST;
+    attr[1].value.objlist = list;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_nhg_api->create_next_hop_group (&nhg_id, 2, attr));
+
+    route_create (0x0A000000, 24, port_rif_id, SAI_PACKET_ACTION_FORWARD);
+    route_create (0x0A010000, 24, vlan_rif_id, SAI_PACKET_ACTION_FORWARD);
+    route_create (0, 0, nh_id, SAI_PACKET_ACTION_FORWARD);
+    route_create (0x14000000, 8, nhg_id, SAI_PACKET_ACTION_FORWARD);
+    route_create (0x14010000, 16, nh_id, SAI_PACKET_ACTION_FORWARD);
+    route_create (0x14010100, 24, SAI_NULL_OBJECT_ID, SAI_PACKET_ACTION_DROP);
+    route_create (0x14010101, 32, nhg_id, SAI_PACKET_ACTION_FORWARD);
+    route_create (0x14010180, 25, nh_id, SAI_PACKET_ACTION_TRAP);
+}
+
+/*
+ * The most specific route wins at every prefix length.
+ */
+TEST_F (saiStubLookupTest, longest_prefix_match)
+{
+    stub_forwarding_result_t result;
+    sai_ip_address_t         dst;
+
+    dst = ip4 (0x14010101);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_lookup_forwarding (vr_id, &dst, 0, &result));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, result.status);
+    EXPECT_EQ (vlan_rif_id, result.rif_id);
+
+    dst = ip4 (0x14010102);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_lookup_forwarding (vr_id, &dst, 0, &result));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, result.status);
+    EXPECT_EQ (SAI_PACKET_ACTION_DROP, result.packet_action);
+
+    dst = ip4 (0x140101F0);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_lookup_forwarding (vr_id, &dst, 0, &result));
+    EXPECT_EQ (SAI_PACKET_ACTION_TRAP, result.packet_action);
+
+    dst = ip4 (0x14010201);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_lookup_forwarding (vr_id, &dst, 0, &result));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, result.status);
+    EXPECT_EQ (nh_id, result.next_hop_id);
+    EXPECT_EQ (port_oid (1), result.port_id);
+    EXPECT_EQ (0x01, result.src_mac[5]);
+    EXPECT_EQ (0x10, result.dst_mac[5]);
+
+    dst = ip4 (0x14020000);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_lookup_forwarding (vr_id, &dst, 0, &result));
+    EXPECT_EQ (vlan_rif_id, result.rif_id);
+
+    /* Default route */
+    dst = ip4 (0xC0A80001);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_lookup_forwarding (vr_id, &dst, 0, &result));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, result.status);
+    EXPECT_EQ (nh_id, result.next_hop_id);
+}
+
+/*
+ * ECMP member follows the flow hash and resolves through the FDB on a
+ * VLAN router interface.
+ */
+TEST_F (saiStubLookupTest, ecmp_over_vlan_rif)
+{
+    stub_forwarding_result_t result;
+    sai_ip_address_t         dst = ip4 (0x14000001);
+
+    for (uint32_t hash = 0; hash < 2 * SAI_LOOKUP_ECMP_PATHS; hash++) {
+        uint32_t member = hash % SAI_LOOKUP_ECMP_PATHS;
+
+        ASSERT_EQ (SAI_STATUS_SUCCESS, stub_lookup_forwarding (vr_id, &dst, hash, &result));
+        EXPECT_EQ (SAI_STATUS_SUCCESS, result.status);
+        EXPECT_EQ (SAI_PACKET_ACTION_FORWARD, result.packet_action);
+        EXPECT_EQ (ecmp_nh_id[member], result.next_hop_id);
+        EXPECT_EQ (100, result.vlan_id);
+        EXPECT_EQ (0x02, result.src_mac[5]);
+        EXPECT_EQ (0x20 + member, result.dst_mac[5]);
+        EXPECT_EQ (port_oid (10 + member), result.port_id);
+    }
+}
+
+/*
+ * Directly connected route resolves the destination itself as neighbor,
+ * unresolved neighbors are punted.
+ */
+TEST_F (saiStubLookupTest, connected_and_unresolved)
+{
+    stub_forwarding_result_t result;
+    sai_ip_address_t         dst;
+
+    dst = ip4 (0x0A000002);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_lookup_forwarding (vr_id, &dst, 0, &result));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, result.status);
+    EXPECT_EQ (SAI_NULL_OBJECT_ID, result.next_hop_id);
+    EXPECT_EQ (port_rif_id, result.rif_id);
+    EXPECT_EQ (0x10, result.dst_mac[5]);
+
+    dst = ip4 (0x0A000063);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_lookup_forwarding (vr_id, &dst, 0, &result));
+    EXPECT_EQ (SAI_STATUS_ITEM_NOT_FOUND, result.status);
+    EXPECT_EQ (SAI_PACKET_ACTION_TRAP, result.packet_action);
+    EXPECT_EQ (port_rif_id, result.rif_id);
+
+    /* No routes in an unknown virtual router */
+    dst = ip4 (0x0A000002);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_lookup_forwarding (vr_id + (1ULL << 32), &dst, 0, &result));
+    EXPECT_EQ (SAI_STATUS_ITEM_NOT_FOUND, result.status);
+    EXPECT_EQ (SAI_PACKET_ACTION_DROP, result.packet_action);
+}
+
+/*
+ * Bulk lookup returns the same results as single lookups, and both rates
+ * are reported over a large table.
+ */
+TEST_F (saiStubLookupTest, bulk_matches_single_and_rate)
+{
+    std::vector<sai_ip_address_t>         dst (SAI_LOOKUP_RATE_BATCH * SAI_LOOKUP_RATE_ROUNDS);
+    std::vector<uint32_t>                 hash (dst.size ());
+    std::vector<stub_forwarding_result_t> bulk (dst.size ());
+    stub_forwarding_result_t              single;
+
+    /* 30.0.0.0/8 split into /24s over the ECMP group */
+    for (uint32_t i = 0; i < SAI_LOOKUP_RATE_ROUTES; i++) {
+        route_create (0x1E000000 | (i << 8), 24, nhg_id, SAI_PACKET_ACTION_FORWARD);
+    }
+
+    for (uint32_t i = 0; i < dst.size (); i++) {
+        dst[i]  = ip4 (0x1E000001 | ((i * 7919 % SAI_LOOKUP_RATE_ROUTES) << 8));
+        hash[i] = i * 2654435761u;
+    }
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS,
+               stub_lookup_forwarding_bulk (vr_id, dst.size (), dst.data (), hash.data (), bulk.data ()));
+
+    for (uint32_t i = 0; i < dst.size (); i++) {
+        ASSERT_EQ (SAI_STATUS_SUCCESS, stub_lookup_forwarding (vr_id, &dst[i], hash[i], &single));
+        EXPECT_EQ (0, memcmp (&single, &bulk[i], sizeof (single)));
+        EXPECT_EQ (SAI_STATUS_SUCCESS, bulk[i].status);
+    }
+
+    auto start = std::chrono::steady_clock::now ();
+    for (uint32_t round = 0; round < 100; round++) {
+        for (uint32_t i = 0; i < dst.size (); i++) {
+            stub_lookup_forwarding (vr_id, &dst[i], hash[i], &single);
+        }
+    }
+    double single_sec = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+    start = std::chrono::steady_clock::now ();
+    for (uint32_t round = 0; round < 100; round++) {
+        for (uint32_t i = 0; i < dst.size (); i += SAI_LOOKUP_RATE_BATCH) {
+            stub_lookup_forwarding_bulk (vr_id, SAI_LOOKUP_RATE_BATCH, &dst[i], &hash[i], &bulk[i]);
+        }
+    }
+    double bulk_sec = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+    printf ("lookup rate: single %.2f Mpps, bulk %.2f Mpps\n",
+            100.0 * dst.size () / single_sec / 1e6,
+            100.0 * dst.size () / bulk_sec / 1e6);
+}
@@ -0,0 +1,591 @@
+/************************************************************************
+*    Licensed under the Apache License, Version 2.0 (the "License"); you may
+*    not use this file except in compliance with the License. You may obtain
+*    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+*
+*    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+*    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+*    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+*    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+*
+*    See the Apache Version 2.0 License for specific language governing
+*    permissions and limitations under the License.
+*
+*
+* Module Name:
+*
+*    sai_stub_mirror_unit_test.cpp
+*
+* Abstract:
+*
+*    This file contains tests for the stub mirror sessions. Sessions are
+*    checked against their type and read back, ports bind them per
+*    direction, and the clones of local, RSPAN and ERSPAN sessions carry
+*    their encapsulation and the truncated frame, through the pcap run too.
+*
+*************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/sai_stub_unit_test_utils.h"
+
+extern "C" {
+#include "sai.h"
+#include "saitypes.h"
+#include "saistatus.h"
+#include "saiswitch.h"
+#include "saiport.h"
+#include "saimirror.h"
+#include "saivlan.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_mirror.h"
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+}
+
+#include <chrono>
+#include <vector>
+
+#define ERSPAN_GRE_PROTOCOL 0x88BE
+
+class saiStubMirrorTest : public saiStubTest
+{
+    protected:
+        static void SetUpTestCase (void);
+
+        static void build_frame (uint8_t *frame, uint32_t length);
+        static sai_object_id_t local_create (uint32_t monitor_port, uint16_t truncate_size);
+        static sai_object_id_t rspan_create (uint32_t monitor_port, uint16_t truncate_size, uint16_t vlan_id);
+        static sai_object_id_t erspan_create (uint32_t monitor_port, uint16_t truncate_size, uint8_t version,
+                                              uint16_t vlan_id);
+        static void port_mirror_set (uint32_t port, bool ingress, uint32_t count, sai_object_id_t *sessions);
+
+        static sai_port_api_t   *p_port_api;
+        static sai_mirror_api_t *p_mirror_api;
+};
+
+sai_port_api_t* saiStubMirrorTest::p_port_api = NULL;
+sai_mirror_api_t* saiStubMirrorTest::p_mirror_api = NULL;
+
+/* To 02:00:00:00:00:77 from 02:00:00:00:00:99 on VLAN 100, then a byte
+ * pattern */
+void saiStubMirrorTest::build_frame (uint8_t *frame, uint32_t length)
+{
+    for (uint32_t i = 0; i < length; i++) {
+        frame[i] = (uint8_t)i;
+    }
+    memset (frame, 0, 12);
+    frame[0]  = 0x02;
+    frame[5]  = 0x77;
+    frame[6]  = 0x02;
+    frame[11] = 0x99;
+    frame[12] = 0x81;
+    frame[13] = 0x00;
+    frame[14] = 0x00;
+    frame[15] = 100;
+    frame[16] = 0x08;
+    frame[17] = 0x00;
+}
+
+sai_object_id_t saiStubMirrorTest::local_create (uint32_t monitor_port, uint16_t truncate_size)
+{
+    sai_object_id_t session_id = SAI_NULL_OBJECT_ID;
+    sai_attribute_t attr[3];
+
+    attr[0].id        = SAI_MIRROR_SESSION_ATTR_TYPE;
+    attr[0].value.s32 = SAI_MIRROR_TYPE_LOCAL;
+    attr[1].id        = SAI_MIRROR_SESSION_ATTR_MONITOR_PORT;
+    attr[1].value.oid = port_oid (monitor_port);
+    attr[2].id        = SAI_MIRROR_SESSION_ATTR_TRUNCATE_SIZE;
+    attr[2].value.u16 = truncate_size;
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_mirror_api->create_mirror_session (&session_id, 3, attr));
+    return session_id;
+}
+
+sai_object_id_t saiStubMirrorTest::rspan_create (uint32_t monitor_port, uint16_t truncate_size, uint16_t vlan_id)
+{
+    sai_object_id_t session_id = SAI_NULL_OBJECT_ID;
+    sai_attribute_t attr[7];
+
+    attr[0].id        = SAI_MIRROR_SESSION_ATTR_TYPE;
+    attr[0].value.s32 = SAI_MIRROR_TYPE_REMOTE;
+    attr[1].id        = SAI_MIRROR_SESSION_ATTR_MONITOR_PORT;
+    attr[1].value.oid = port_oid (monitor_port);
+    attr[2].id        = SAI_MIRROR_SESSION_ATTR_TRUNCATE_SIZE;
+    attr[2].value.u16 = truncate_size;
+    attr[3].id        = SAI_MIRROR_SESSION_ATTR_VLAN_TPID;
+    attr[3].value.u16 = 0x8100;
+    attr[4].id        = SAI_MIRROR_SESSION_ATTR_VLAN_ID;
+    attr[4].value.u16 = vlan_id;
+    attr[5].id        = SAI_MIRROR_SESSION_ATTR_VLAN_PRI;
+    attr[5].value.u8  = 5;
+    attr[6].id        = SAI_MIRROR_SESSION_ATTR_VLAN_CFI;
+    attr[6].value.u8  = 0;
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_mirror_api->create_mirror_session (&session_id, 7, attr));
+    return session_id;
+}
+
+/* From 10.0.0.1 to 10.0.0.2 or 2001:db8::1 to 2001:db8::2, MACs ..:aa to ..:bb */
+sai_object_id_t saiStubMirrorTest::erspan_create (uint32_t monitor_port, uint16_t truncate_size, uint8_t version,
+                                                  uint16_t vlan_id)
+{
+    sai_object_id_t session_id = SAI_NULL_OBJECT_ID;
+    sai_attribute_t attr[16];
+
+    memset (attr, 0, sizeof (attr));
+    attr[0].id         = SAI_MIRROR_SESSION_ATTR_TYPE;
+    attr[0].value.s32  = SAI_MIRROR_TYPE_ENHANCED_REMOTE;
+    attr[1].id         = SAI_MIRROR_SESSION_ATTR_MONITOR_PORT;
+    attr[1].value.oid  = port_oid (monitor_port);
+    attr[2].id         = SAI_MIRROR_SESSION_ATTR_TRUNCATE_SIZE;
+    attr[2].value.u16  = truncate_size;
+    attr[3].id         = SAI_MIRROR_SESSION_ATTR_VLAN_TPID;
+    attr[3].value.u16  = 0x8100;
+    attr[4].id         = SAI_MIRROR_SESSION_ATTR_VLAN_ID;
+    attr[4].value.u16  = vlan_id;
+    attr[5].id         = SAI_MIRROR_SESSION_ATTR_VLAN_PRI;
+    attr[5].value.u8   = 0;
+    attr[6].id         = SAI_MIRROR_SESSION_ATTR_VLAN_CFI;
+    attr[6].value.u8   = 0;
+    attr[7].id         = SAI_MIRROR_SESSION_ATTR_ENCAP_TYPE;
+    attr[7].value.s32  = SAI_MIRROR_L3_GRE_TUNNEL;
+    attr[8].id         = SAI_MIRROR_SESSION_ATTR_IPHDR_VERSION;
+    attr[8].value.u8   = version;
+    attr[9].id         = SAI_MIRROR_SESSION_ATTR_TOS;
+    attr[9].value.u8   = 0x20;
+    attr[10].id        = SAI_MIRROR_SESSION_ATTR_SRC_IP_ADDRESS;
+    attr[11].id        = SAI_MIRROR_SESSION_ATTR_DST_IP_ADDRESS;
+    if (4 == version) {
+        attr[10].value.ipaddr.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+        attr[10].value.ipaddr.addr.ip4    = htonl (0x0A000001);
+        attr[11].value.ipaddr.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+        attr[11].value.ipaddr.addr.ip4    = htonl (0x0A000002);
+    } else {
+        attr[10].value.ipaddr.addr_family = SAI_IP_ADDR_FAMILY_IPV6;
+        inet_pton (AF_INET6, "2001:db8::1", attr[10].value.ipaddr.addr.ip6);
+        attr[11].value.ipaddr.addr_family = SAI_IP_ADDR_FAMILY_IPV6;
+        inet_pton (AF_INET6, "2001:db8::2", attr[11].value.ipaddr.addr.ip6);
+    }
+    attr[12].id           = SAI_MIRROR_SESSION_ATTR_SRC_MAC_ADDRESS;
+    attr[12].value.mac[0] = 0x02;
+    attr[12].value.mac[5] = 0xAA;
+    attr[13].id           = SAI_MIRROR_SESSION_ATTR_DST_MAC_ADDRESS;
+    attr[13].value.mac[0] = 0x02;
+    attr[13].value.mac[5] = 0xBB;
+    attr[14].id           = SAI_MIRROR_SESSION_ATTR_GRE_PROTOCOL_TYPE;
+    attr[14].value.u16    = ERSPAN_GRE_PROTOCOL;
+    attr[15].id           = SAI_MIRROR_SESSION_ATTR_TTL;
+    attr[15].value.u8     = 16;
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_mirror_api->create_mirror_session (&session_id, 16, attr));
+    return session_id;
+}
+
+void saiStubMirrorTest::port_mirror_set (uint32_t port, bool ingress, uint32_t count, sai_object_id_t *sessions)
+{
+    sai_object_id_t none;
+    sai_attribute_t attr;
+
+    /* An empty list unbinds, it must not be NULL */
+    attr.id                  = ingress ? SAI_PORT_ATTR_INGRESS_MIRROR_SESSION : SAI_PORT_ATTR_EGRESS_MIRROR_SESSION;
+    attr.value.objlist.count = count;
+    attr.value.objlist.list  = (NULL != sessions) ? sessions : &none;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->set_port_attribute (port_oid (port), &attr));
+}
+
+/* Ports 11 to 13 carry VLAN 100 of the test frames */
+void saiStubMirrorTest::SetUpTestCase (void)
+{
+    sai_vlan_api_t *p_vlan_api;
+    sai_vlan_port_t members[3];
+
+    SetUpStubSwitch ();
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_PORT, (void **)&p_port_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_MIRROR, (void **)&p_mirror_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_VLAN, (void **)&p_vlan_api));
+
+    for (uint32_t i = 0; i < 3; i++) {
+        members[i].port_id      = port_oid (11 + i);
+        members[i].tagging_mode = SAI_VLAN_PORT_TAGGED;
+    }
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vlan_api->create_vlan (100));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vlan_api->add_ports_to_vlan (100, 3, members));
+}
+
+/*
+ * Sessions take the attributes of their type only, with values in range,
+ * read back as set, and take new values but for the type.
+ */
+TEST_F (saiStubMirrorTest, mirror_attributes)
+{
+    sai_object_id_t session_id;
+    sai_attribute_t attr[4];
+
+    /* No monitor port */
+    attr[0].id        = SAI_MIRROR_SESSION_ATTR_TYPE;
+    attr[0].value.s32 = SAI_MIRROR_TYPE_LOCAL;
+    EXPECT_EQ (SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING, p_mirror_api->create_mirror_session (&session_id, 1, attr));
+
+    /* A VLAN on a local session */
+    attr[1].id        = SAI_MIRROR_SESSION_ATTR_MONITOR_PORT;
+    attr[1].value.oid = port_oid (1);
+    attr[2].id        = SAI_MIRROR_SESSION_ATTR_VLAN_ID;
+    attr[2].value.u16 = 10;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTRIBUTE_0 + 2, p_mirror_api->create_mirror_session (&session_id, 3, attr));
+
+    /* RSPAN without its VLAN tag */
+    attr[0].value.s32 = SAI_MIRROR_TYPE_REMOTE;
+    EXPECT_EQ (SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING, p_mirror_api->create_mirror_session (&session_id, 3, attr));
+
+    /* Shorter than an Ethernet header */
+    attr[0].value.s32 = SAI_MIRROR_TYPE_LOCAL;
+    attr[2].id        = SAI_MIRROR_SESSION_ATTR_TRUNCATE_SIZE;
+    attr[2].value.u16 = 10;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0 + 2, p_mirror_api->create_mirror_session (&session_id, 3, attr));
+
+    attr[2].value.u16 = 128;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_mirror_api->create_mirror_session (&session_id, 3, attr));
+
+    attr[0].id = SAI_MIRROR_SESSION_ATTR_TYPE;
+    attr[1].id = SAI_MIRROR_SESSION_ATTR_MONITOR_PORT;
+    attr[2].id = SAI_MIRROR_SESSION_ATTR_TRUNCATE_SIZE;
+    attr[3].id = SAI_MIRROR_SESSION_ATTR_TTL;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_mirror_api->get_mirror_session_attribute (session_id, 4, attr));
+    EXPECT_EQ (SAI_MIRROR_TYPE_LOCAL, attr[0].value.s32);
+    EXPECT_EQ (port_oid (1), attr[1].value.oid);
+    EXPECT_EQ (128, attr[2].value.u16);
+    EXPECT_EQ (255, attr[3].value.u8);
+
+    attr[0].id        = SAI_MIRROR_SESSION_ATTR_TYPE;
+    attr[0].value.s32 = SAI_MIRROR_TYPE_REMOTE;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_mirror_api->set_mirror_session_attribute (session_id, &attr[0]));
+    attr[0].id        = SAI_MIRROR_SESSION_ATTR_TC;
+    attr[0].value.u8  = 100;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0, p_mirror_api->set_mirror_session_attribute (session_id, &attr[0]));
+    attr[0].value.u8  = 3;
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_mirror_api->set_mirror_session_attribute (session_id, &attr[0]));
+    attr[0].id        = SAI_MIRROR_SESSION_ATTR_MONITOR_PORT;
+    attr[0].value.oid = port_oid (2);
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_mirror_api->set_mirror_session_attribute (session_id, &attr[0]));
+
+    attr[0].id = SAI_MIRROR_SESSION_ATTR_TC;
+    attr[1].id = SAI_MIRROR_SESSION_ATTR_MONITOR_PORT;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_mirror_api->get_mirror_session_attribute (session_id, 2, attr));
+    EXPECT_EQ (3, attr[0].value.u8);
+    EXPECT_EQ (port_oid (2), attr[1].value.oid);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_mirror_api->remove_mirror_session (session_id));
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_mirror_api->remove_mirror_session (session_id));
+
+    /* ERSPAN addresses of the IP header version */
+    session_id = erspan_create (1, 0, 4, 0);
+    attr[0].id                        = SAI_MIRROR_SESSION_ATTR_DST_IP_ADDRESS;
+    attr[0].value.ipaddr.addr_family  = SAI_IP_ADDR_FAMILY_IPV6;
+    memset (attr[0].value.ipaddr.addr.ip6, 0, sizeof (sai_ip6_t));
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0, p_mirror_api->set_mirror_session_attribute (session_id, &attr[0]));
+    attr[0].id       = SAI_MIRROR_SESSION_ATTR_IPHDR_VERSION;
+    attr[0].value.u8 = 5;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0, p_mirror_api->set_mirror_session_attribute (session_id, &attr[0]));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_mirror_api->remove_mirror_session (session_id));
+}
+
+/*
+ * Ports bind up to STUB_MIRROR_PORT_SESSIONS existing sessions per
+ * direction, read back as bound, and keep them from being removed.
+ */
+TEST_F (saiStubMirrorTest, port_binding)
+{
+    sai_object_id_t sessions[STUB_MIRROR_PORT_SESSIONS + 1], list[STUB_MIRROR_PORT_SESSIONS];
+    sai_attribute_t attr;
+    uint32_t        ii;
+
+    for (ii = 0; ii <= STUB_MIRROR_PORT_SESSIONS; ii++) {
+        sessions[ii] = local_create (1, 0);
+    }
+
+    attr.id                  = SAI_PORT_ATTR_INGRESS_MIRROR_SESSION;
+    attr.value.objlist.count = STUB_MIRROR_PORT_SESSIONS + 1;
+    attr.value.objlist.list  = sessions;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0, p_port_api->set_port_attribute (port_oid (3), &attr));
+
+    sessions[1]              = sessions[0];
+    attr.value.objlist.count = 2;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0, p_port_api->set_port_attribute (port_oid (3), &attr));
+    sessions[1] = sessions[STUB_MIRROR_PORT_SESSIONS];
+
+    port_mirror_set (3, true, 2, sessions);
+    port_mirror_set (3, false, 1, &sessions[1]);
+
+    attr.value.objlist.count = STUB_MIRROR_PORT_SESSIONS;
+    attr.value.objlist.list  = list;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->get_port_attribute (port_oid (3), 1, &attr));
+    ASSERT_EQ (2u, attr.value.objlist.count);
+    EXPECT_EQ (sessions[0], list[0]);
+    EXPECT_EQ (sessions[1], list[1]);
+
+    attr.id                  = SAI_PORT_ATTR_EGRESS_MIRROR_SESSION;
+    attr.value.objlist.count = STUB_MIRROR_PORT_SESSIONS;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->get_port_attribute (port_oid (3), 1, &attr));
+    ASSERT_EQ (1u, attr.value.objlist.count);
+    EXPECT_EQ (sessions[1], list[0]);
+
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_mirror_api->remove_mirror_session (sessions[1]));
+    port_mirror_set (3, true, 0, NULL);
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_mirror_api->remove_mirror_session (sessions[1]));
+    port_mirror_set (3, false, 0, NULL);
+
+    for (ii = 0; ii < STUB_MIRROR_PORT_SESSIONS; ii++) {
+        EXPECT_EQ (SAI_STATUS_SUCCESS, p_mirror_api->remove_mirror_session (sessions[ii]));
+    }
+}
+
+/*
+ * A frame mirrored by local, RSPAN and ERSPAN sessions at once: one copy
+ * of its bytes for all three, each clone with its encapsulation, IP
+ * length and checksum, cut to its truncate size.
+ */
+TEST_F (saiStubMirrorTest, clone_encapsulation)
+{
+    uint8_t              frame[200];
+    stub_packet_t        packet;
+    stub_mirror_packet_t clones[STUB_MIRROR_BURST_CLONES];
+    sai_object_id_t      sessions[4];
+    uint32_t             count, sum, ii;
+    const uint8_t       *header, *ip;
+
+    sessions[0] = local_create (5, 0);
+    sessions[1] = rspan_create (6, 64, 200);
+    sessions[2] = erspan_create (7, 128, 4, 0);
+    sessions[3] = erspan_create (7, 0, 6, 300);
+    port_mirror_set (4, true, 4, sessions);
+
+    build_frame (frame, sizeof (frame));
+    memset (&packet, 0, sizeof (packet));
+    packet.data    = frame;
+    packet.length  = sizeof (frame);
+    packet.in_port = port_oid (4);
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_mirror_burst (true, 1, &packet, STUB_MIRROR_BURST_CLONES, clones, &count));
+    ASSERT_EQ (4u, count);
+
+    /* Local, the whole frame as received */
+    EXPECT_EQ (sessions[0], clones[0].session_id);
+    EXPECT_EQ (port_oid (5), clones[0].monitor_port);
+    EXPECT_EQ (0u, clones[0].header_length);
+    ASSERT_EQ (sizeof (frame), clones[0].length);
+    EXPECT_EQ (0, memcmp (frame, clones[0].data, sizeof (frame)));
+    EXPECT_NE (frame, clones[0].data);
+
+    /* RSPAN, the MACs, the session tag, then the frame from its tag */
+    header = clones[1].header;
+    ASSERT_EQ (16u, clones[1].header_length);
+    EXPECT_EQ (0, memcmp (frame, header, 12));
+    EXPECT_EQ (0x81, header[12]);
+    EXPECT_EQ (0x00, header[13]);
+    EXPECT_EQ ((5 << 13 | 200) >> 8, header[14]);
+    EXPECT_EQ (200 & 0xFF, header[15]);
+    EXPECT_EQ (64u - 12, clones[1].length);
+    EXPECT_EQ (clones[0].data + 12, clones[1].data);
+
+    /* ERSPAN over IPv4, 128 bytes after an untagged header */
+    header = clones[2].header;
+    ASSERT_EQ (14u + 20 + 4, clones[2].header_length);
+    EXPECT_EQ (0xBB, header[5]);
+    EXPECT_EQ (0xAA, header[11]);
+    EXPECT_EQ (0x08, header[12]);
+    ip = header + 14;
+    EXPECT_EQ (0x45, ip[0]);
+    EXPECT_EQ (0x20, ip[1]);
+    EXPECT_EQ (20 + 4 + 128, (ip[2] << 8) | ip[3]);
+    EXPECT_EQ (16, ip[8]);
+    EXPECT_EQ (47, ip[9]);
+    for (sum = 0, ii = 0; ii < 20; ii += 2) {
+        sum += (ip[ii] << 8) | ip[ii + 1];
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    EXPECT_EQ (0xFFFFu, sum);
+    EXPECT_EQ (ERSPAN_GRE_PROTOCOL, (ip[22] << 8) | ip[23]);
+    EXPECT_EQ (128u, clones[2].length);
+    EXPECT_EQ (clones[0].data, clones[2].data);
+
+    /* ERSPAN over IPv6, tagged, the whole frame */
+    header = clones[3].header;
+    ASSERT_EQ (18u + 40 + 4, clones[3].header_length);
+    EXPECT_EQ (0x81, header[12]);
+    EXPECT_EQ (300 >> 8, header[14]);
+    EXPECT_EQ (0x86, header[16]);
+    EXPECT_EQ (0xDD, header[17]);
+    ip = header + 18;
+    EXPECT_EQ (0x62, ip[0]);
+    EXPECT_EQ (4 + sizeof (frame), (uint32_t)((ip[4] << 8) | ip[5]));
+    EXPECT_EQ (47, ip[6]);
+    EXPECT_EQ (16, ip[7]);
+    EXPECT_EQ (0x01, ip[23]);
+    EXPECT_EQ (0x02, ip[39]);
+    EXPECT_EQ (sizeof (frame), clones[3].length);
+    EXPECT_EQ (clones[0].buffer, clones[3].buffer);
+
+    stub_mirror_release (count, clones);
+
+    /* Runts are not mirrored */
+    packet.length = 13;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_mirror_burst (true, 1, &packet, STUB_MIRROR_BURST_CLONES, clones, &count));
+    EXPECT_EQ (0u, count);
+
+    port_mirror_set (4, true, 0, NULL);
+    for (ii = 0; ii < 4; ii++) {
+        EXPECT_EQ (SAI_STATUS_SUCCESS, p_mirror_api->remove_mirror_session (sessions[ii]));
+    }
+}
+
+/*
+ * Egress sessions mirror frames forwarded or flooded to their port, not
+ * dropped ones; the pcap run writes the clones after the forwarded frames.
+ */
+TEST_F (saiStubMirrorTest, egress_through_pcap)
+{
+    uint8_t                            frame[3][100];
+    stub_packet_t                      packets[3];
+    stub_mirror_packet_t               clones[STUB_MIRROR_BURST_CLONES];
+    sai_object_id_t                    sessions[2];
+    uint32_t                           count, ii;
+    char                               in_path[] = "/tmp/sai_mirror_in_XXXXXX";
+    char                               out_path[] = "/tmp/sai_mirror_out_XXXXXX";
+    uint32_t                           file_header[6] = { 0xA1B2C3D4, 0x00040002, 0, 0, 65535, 1 };
+    uint32_t                           record[4];
+    stub_dataplane_stats_t             stats[2];
+    std::vector<std::vector<uint8_t> > records;
+    FILE                              *file;
+
+    sessions[0] = local_create (8, 0);
+    sessions[1] = erspan_create (9, 64, 4, 0);
+    port_mirror_set (12, false, 1, &sessions[0]);
+    port_mirror_set (11, true, 1, &sessions[1]);
+
+    memset (packets, 0, sizeof (packets));
+    for (ii = 0; ii < 3; ii++) {
+        build_frame (frame[ii], sizeof (frame[ii]));
+        packets[ii].data          = frame[ii];
+        packets[ii].length        = sizeof (frame[ii]);
+        packets[ii].in_port       = port_oid (13);
+        packets[ii].packet_action = SAI_PACKET_ACTION_FORWARD;
+    }
+    packets[0].out_port      = port_oid (12);
+    packets[1].out_port      = port_oid (12);
+    packets[1].packet_action = SAI_PACKET_ACTION_DROP;
+    packets[2].out_port      = SAI_NULL_OBJECT_ID;
+    packets[2].vlan_id       = 100;
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_mirror_burst (false, 3, packets, STUB_MIRROR_BURST_CLONES, clones, &count));
+    ASSERT_EQ (2u, count);
+    EXPECT_EQ (0u, clones[0].packet_index);
+    EXPECT_EQ (2u, clones[1].packet_index);
+    stub_mirror_release (count, clones);
+
+    /* Flooded from the port itself */
+    packets[2].in_port = port_oid (12);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_mirror_burst (false, 1, &packets[2], STUB_MIRROR_BURST_CLONES, clones, &count));
+    EXPECT_EQ (0u, count);
+
+    /* One frame in on port 11 */
+    close (mkstemp (in_path));
+    close (mkstemp (out_path));
+    ASSERT_TRUE (NULL != (file = fopen (in_path, "wb")));
+    fwrite (file_header, sizeof (file_header), 1, file);
+    record[0] = 7;
+    record[1] = 0;
+    record[2] = record[3] = sizeof (frame[0]);
+    fwrite (record, sizeof (record), 1, file);
+    fwrite (frame[0], sizeof (frame[0]), 1, file);
+    fclose (file);
+
+    stub_dataplane_get_stats (&stats[0]);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_run_pcap (in_path, port_oid (11), out_path));
+    stub_dataplane_get_stats (&stats[1]);
+    EXPECT_EQ (2u, stats[1].mirrored - stats[0].mirrored);
+
+    ASSERT_TRUE (NULL != (file = fopen (out_path, "rb")));
+    ASSERT_EQ (1u, fread (file_header, sizeof (file_header), 1, file));
+    while (1 == fread (record, sizeof (record), 1, file)) {
+        EXPECT_EQ (7u, record[0]);
+        records.push_back (std::vector<uint8_t> (record[2]));
+        ASSERT_EQ (1u, fread (records.back ().data (), record[2], 1, file));
+    }
+    fclose (file);
+
+    /* The flooded frame, its ERSPAN clone of 64 bytes from port 11 and its
+     * local clone from port 12 */
+    ASSERT_EQ (3u, records.size ());
+    EXPECT_EQ (sizeof (frame[0]), records[0].size ());
+    ASSERT_EQ (14u + 20 + 4 + 64, records[1].size ());
+    EXPECT_EQ (0, memcmp (frame[0], records[1].data () + 14 + 20 + 4, 64));
+    EXPECT_EQ (records[0], records[2]);
+
+    unlink (in_path);
+    unlink (out_path);
+
+    port_mirror_set (12, false, 0, NULL);
+    port_mirror_set (11, true, 0, NULL);
+    for (ii = 0; ii < 2; ii++) {
+        EXPECT_EQ (SAI_STATUS_SUCCESS, p_mirror_api->remove_mirror_session (sessions[ii]));
+    }
+}
+
+/*
+ * Bursts of full size frames mirrored by an ERSPAN session, cut to 128
+ * bytes and whole, and by a second session sharing the copy.
+ */
+TEST_F (saiStubMirrorTest, mirror_rate)
+{
+    static uint8_t       frames[STUB_DATAPLANE_BURST][1500];
+    stub_packet_t        packets[STUB_DATAPLANE_BURST];
+    stub_mirror_packet_t clones[STUB_MIRROR_BURST_CLONES];
+    sai_object_id_t      sessions[2];
+    sai_attribute_t      attr;
+    uint32_t             ii, jj, count, total;
+
+    sessions[0] = erspan_create (9, 128, 4, 0);
+    sessions[1] = local_create (8, 0);
+
+    memset (packets, 0, sizeof (packets));
+    for (ii = 0; ii < STUB_DATAPLANE_BURST; ii++) {
+        build_frame (frames[ii], sizeof (frames[ii]));
+        packets[ii].data    = frames[ii];
+        packets[ii].length  = sizeof (frames[ii]);
+        packets[ii].in_port = port_oid (14);
+    }
+
+    const char *names[3] = { "truncated", "whole", "two sessions" };
+    for (uint32_t run = 0; run < 3; run++) {
+        if (1 == run) {
+            attr.id        = SAI_MIRROR_SESSION_ATTR_TRUNCATE_SIZE;
+            attr.value.u16 = 0;
+            ASSERT_EQ (SAI_STATUS_SUCCESS, p_mirror_api->set_mirror_session_attribute (sessions[0], &attr));
+        }
+        port_mirror_set (14, true, (2 == run) ? 2 : 1, sessions);
+
+        total      = 0;
+        auto start = std::chrono::steady_clock::now ();
+        for (jj = 0; jj < 20000; jj++) {
+            stub_mirror_burst (true, STUB_DATAPLANE_BURST, packets, STUB_MIRROR_BURST_CLONES, clones, &count);
+            stub_mirror_release (count, clones);
+            total += count;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now () - start;
+        printf ("mirror %s: %.1f Mpps mirrored, %.1f Mclones/s\n", names[run],
+                20000.0 * STUB_DATAPLANE_BURST / elapsed.count () / 1e6, total / elapsed.count () / 1e6);
+
+        EXPECT_EQ (20000u * STUB_DATAPLANE_BURST * ((2 == run) ? 2 : 1), total);
+    }
+
+    port_mirror_set (14, true, 0, NULL);
+    for (ii = 0; ii < 2; ii++) {
+        EXPECT_EQ (SAI_STATUS_SUCCESS, p_mirror_api->remove_mirror_session (sessions[ii]));
+    }
+}
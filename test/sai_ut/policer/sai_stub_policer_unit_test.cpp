@@ -0,0 +1,580 @@
+/************************************************************************
+*    Licensed under the Apache License, Version 2.0 (the "License"); you may
+*    not use this file except in compliance with the License. You may obtain
+*    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+*
+*    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+*    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+*    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+*    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+*
+*    See the Apache Version 2.0 License for specific language governing
+*    permissions and limitations under the License.
+*
+*
+* Module Name:
+*
+*    sai_stub_policer_unit_test.cpp
+*
+* Abstract:
+*
+*    This file contains tests for the stub policers. Frames are colored
+*    by the three meter modes, and policers attached to ports, storm
+*    control, ACL entries and trap groups drop their red frames in the
+*    stub software data plane.
+*
+*************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/sai_stub_unit_test_utils.h"
+
+extern "C" {
+#include "sai.h"
+#include "saitypes.h"
+#include "saistatus.h"
+#include "saiswitch.h"
+#include "saiport.h"
+#include "saiacl.h"
+#include "saihostintf.h"
+#include "saipolicer.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_hostif.h"
+#include "stub_sai_policer.h"
+#include <string.h>
+#include <unistd.h>
+}
+
+#include <chrono>
+
+class saiStubPolicerTest : public saiStubTest
+{
+    protected:
+        static void SetUpTestCase (void);
+
+        struct frame_t {
+            uint8_t       buffer[STUB_DATAPLANE_HEADROOM + 128];
+            stub_packet_t packet;
+        };
+
+        static void build_frame (frame_t *frame, sai_object_id_t in_port, uint8_t dst0,
+                                 uint32_t length);
+        static void build_lldp (frame_t *frame, sai_object_id_t in_port);
+        static sai_object_id_t policer_create (sai_meter_type_t meter_type, sai_policer_mode_t mode,
+                                               uint64_t cir, uint64_t cbs, uint64_t pir,
+                                               uint64_t pbs);
+        static void burst_run (uint32_t count, sai_object_id_t in_port, uint8_t dst0,
+                               uint32_t *forwarded, uint32_t *dropped);
+        static void meter_run (sai_object_id_t policer_id, uint32_t count, uint32_t length,
+                               uint32_t colors[3]);
+
+        static sai_policer_api_t *p_policer_api;
+        static sai_port_api_t    *p_port_api;
+        static sai_acl_api_t     *p_acl_api;
+        static sai_hostif_api_t  *p_hostif_api;
+};
+
+sai_policer_api_t* saiStubPolicerTest::p_policer_api = NULL;
+sai_port_api_t* saiStubPolicerTest::p_port_api = NULL;
+sai_acl_api_t* saiStubPolicerTest::p_acl_api = NULL;
+sai_hostif_api_t* saiStubPolicerTest::p_hostif_api = NULL;
+
+static void frame_init (uint8_t *eth, stub_packet_t *packet, uint32_t length,
+                        sai_object_id_t in_port)
+{
+    memset (packet, 0, sizeof (*packet));
+    packet->data     = eth;
+    packet->length   = length;
+    packet->headroom = STUB_DATAPLANE_HEADROOM;
+    packet->in_port  = in_port;
+}
+
+/*
+ * Bridged frame of a local experimental ethertype, flooded since no
+ * address is learned: dst0 0x02 is unknown unicast, 0x01 multicast and
+ * 0xFF broadcast.
+ */
+void saiStubPolicerTest::build_frame (frame_t *frame, sai_object_id_t in_port, uint8_t dst0,
+                                      uint32_t length)
+{
+    uint8_t *eth = frame->buffer + STUB_DATAPLANE_HEADROOM;
+
+    memset (frame->buffer, 0, sizeof (frame->buffer));
+    memset (eth, dst0, 6);
+    eth[6]  = 0x02;
+    eth[11] = 0x77;
+    eth[12] = 0x88;
+    eth[13] = 0xB5;
+    frame_init (eth, &frame->packet, length, in_port);
+}
+
+/* LLDPDU to the nearest bridge address */
+void saiStubPolicerTest::build_lldp (frame_t *frame, sai_object_id_t in_port)
+{
+    static const uint8_t dst[] = { 0x01, 0x80, 0xC2, 0x00, 0x00, 0x0E };
+    uint8_t *eth = frame->buffer + STUB_DATAPLANE_HEADROOM;
+
+    memset (frame->buffer, 0, sizeof (frame->buffer));
+    memcpy (eth, dst, sizeof (dst));
+    eth[6]  = 0x02;
+    eth[11] = 0x77;
+    eth[12] = 0x88;
+    eth[13] = 0xCC;
+    frame_init (eth, &frame->packet, 64, in_port);
+}
+
+/* Policer dropping its red frames, a zero PIR is left out */
+sai_object_id_t saiStubPolicerTest::policer_create (sai_meter_type_t meter_type,
+                                                    sai_policer_mode_t mode, uint64_t cir,
+                                                    uint64_t cbs, uint64_t pir, uint64_t pbs)
+{
+    sai_object_id_t policer_id = SAI_NULL_OBJECT_ID;
+    sai_attribute_t attr[7];
+    uint32_t        count = 6;
+
+    memset (attr, 0, sizeof (attr));
+    attr[0].id        = SAI_POLICER_ATTR_METER_TYPE;
+    attr[0].value.s32 = meter_type;
+    attr[1].id        = SAI_POLICER_ATTR_MODE;
+    attr[1].value.s32 = mode;
+    attr[2].id        = SAI_POLICER_ATTR_CIR;
+    attr[2].value.u64 = cir;
+    attr[3].id        = SAI_POLICER_ATTR_CBS;
+    attr[3].value.u64 = cbs;
+    attr[4].id        = SAI_POLICER_ATTR_PBS;
+    attr[4].value.u64 = pbs;
+    attr[5].id        = SAI_POLICER_ATTR_RED_PACKET_ACTION;
+    attr[5].value.s32 = SAI_PACKET_ACTION_DROP;
+    if (0 != pir) {
+        attr[6].id        = SAI_POLICER_ATTR_PIR;
+        attr[6].value.u64 = pir;
+        count = 7;
+    }
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_policer_api->create_policer (&policer_id, count, attr));
+
+    return policer_id;
+}
+
+void saiStubPolicerTest::burst_run (uint32_t count, sai_object_id_t in_port, uint8_t dst0,
+                                    uint32_t *forwarded, uint32_t *dropped)
+{
+    frame_t       frame[16];
+    stub_packet_t packets[16];
+
+    ASSERT_LE (count, 16u);
+    for (uint32_t i = 0; i < count; i++) {
+        build_frame (&frame[i], in_port, dst0, 64);
+        packets[i] = frame[i].packet;
+    }
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (count, packets));
+
+    *forwarded = *dropped = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        *forwarded += (SAI_PACKET_ACTION_FORWARD == packets[i].packet_action);
+        *dropped   += (SAI_PACKET_ACTION_DROP == packets[i].packet_action);
+    }
+}
+
+/* Counts the colors of count back to back frames of length bytes */
+void saiStubPolicerTest::meter_run (sai_object_id_t policer_id, uint32_t count, uint32_t length,
+                                    uint32_t colors[3])
+{
+    frame_t            frame;
+    stub_packet_t      packets[32];
+    sai_packet_color_t color[32];
+
+    ASSERT_LE (count, 32u);
+    build_frame (&frame, port_oid (1), 0x02, length);
+    for (uint32_t i = 0; i < count; i++) {
+        packets[i] = frame.packet;
+    }
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_policer_meter (policer_id, count, packets, color));
+
+    colors[0] = colors[1] = colors[2] = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        ASSERT_LE (color[i], SAI_PACKET_COLOR_RED);
+        colors[color[i]]++;
+    }
+}
+
+void saiStubPolicerTest::SetUpTestCase (void)
+{
+    SetUpStubSwitch ();
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_POLICER, (void **)&p_policer_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_PORT, (void **)&p_port_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_ACL, (void **)&p_acl_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_HOST_INTERFACE, (void **)&p_hostif_api));
+}
+
+/*
+ * Policers need a meter type and a mode, two rate ones a peak rate, and
+ * their attributes read back as set.
+ */
+TEST_F (saiStubPolicerTest, policer_attributes)
+{
+    sai_object_id_t  policer_id;
+    sai_attribute_t  attr[4];
+    int32_t          counters[2];
+
+    memset (attr, 0, sizeof (attr));
+    attr[0].id        = SAI_POLICER_ATTR_METER_TYPE;
+    attr[0].value.s32 = SAI_METER_TYPE_BYTES;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_policer_api->create_policer (&policer_id, 1, attr));
+
+    attr[1].id        = SAI_POLICER_ATTR_MODE;
+    attr[1].value.s32 = SAI_POLICER_MODE_Tr_TCM;
+    EXPECT_EQ (SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING,
+               p_policer_api->create_policer (&policer_id, 2, attr));
+
+    attr[2].id        = SAI_POLICER_ATTR_PIR;
+    attr[2].value.u64 = 2000000000ULL;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_policer_api->create_policer (&policer_id, 3, attr));
+
+    attr[2].value.u64 = 2000000;
+    attr[3].id        = SAI_POLICER_ATTR_CIR;
+    attr[3].value.u64 = 1000000;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_policer_api->create_policer (&policer_id, 4, attr));
+
+    /* Create only */
+    attr[0].value.s32 = SAI_METER_TYPE_PACKETS;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_policer_api->set_policer_attribute (policer_id, &attr[0]));
+
+    attr[0].id        = SAI_POLICER_ATTR_YELLOW_PACKET_ACTION;
+    attr[0].value.s32 = SAI_PACKET_ACTION_TRAP;
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_policer_api->set_policer_attribute (policer_id, &attr[0]));
+    attr[0].value.s32 = SAI_PACKET_ACTION_COPY;
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_policer_api->set_policer_attribute (policer_id, &attr[0]));
+
+    counters[0]                  = SAI_POLICER_STAT_GREEN_PACKETS;
+    counters[1]                  = SAI_POLICER_STAT_RED_BYTES;
+    attr[0].id                   = SAI_POLICER_ATTR_ENABLE_COUNTER_LIST;
+    attr[0].value.s32list.count  = 2;
+    attr[0].value.s32list.list   = counters;
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_policer_api->set_policer_attribute (policer_id, &attr[0]));
+
+    memset (attr, 0, sizeof (attr));
+    counters[0] = counters[1] = -1;
+    attr[0].id                  = SAI_POLICER_ATTR_MODE;
+    attr[1].id                  = SAI_POLICER_ATTR_PIR;
+    attr[2].id                  = SAI_POLICER_ATTR_YELLOW_PACKET_ACTION;
+    attr[3].id                  = SAI_POLICER_ATTR_ENABLE_COUNTER_LIST;
+    attr[3].value.s32list.count = 2;
+    attr[3].value.s32list.list  = counters;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_policer_api->get_policer_attribute (policer_id, 4, attr));
+    EXPECT_EQ (SAI_POLICER_MODE_Tr_TCM, attr[0].value.s32);
+    EXPECT_EQ (2000000u, attr[1].value.u64);
+    EXPECT_EQ (SAI_PACKET_ACTION_COPY, attr[2].value.s32);
+    EXPECT_EQ (2u, attr[3].value.s32list.count);
+    EXPECT_EQ (SAI_POLICER_STAT_GREEN_PACKETS, counters[0]);
+    EXPECT_EQ (SAI_POLICER_STAT_RED_BYTES, counters[1]);
+
+    /* The green action defaults to forward */
+    attr[0].id = SAI_POLICER_ATTR_GREEN_PACKET_ACTION;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_policer_api->get_policer_attribute (policer_id, 1, attr));
+    EXPECT_EQ (SAI_PACKET_ACTION_FORWARD, attr[0].value.s32);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_policer_api->remove_policer (policer_id));
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_policer_api->remove_policer (policer_id));
+}
+
+/*
+ * Back to back frames drain the buckets: single rate three color frames
+ * go green, then yellow from the excess bucket, two rate ones yellow
+ * while the peak bucket lasts, storm control ones straight to red.
+ */
+TEST_F (saiStubPolicerTest, color_marking)
+{
+    sai_object_id_t        sr_id, tr_id, storm_id;
+    sai_policer_stat_counter_t counter_ids[4] = {
+        SAI_POLICER_STAT_GREEN_PACKETS, SAI_POLICER_STAT_YELLOW_PACKETS,
+        SAI_POLICER_STAT_RED_PACKETS, SAI_POLICER_STAT_ATTR_BYTES
+    };
+    uint64_t               counters[4];
+    uint32_t               colors[3];
+
+    sr_id    = policer_create (SAI_METER_TYPE_PACKETS, SAI_POLICER_MODE_Sr_TCM, 1, 4, 0, 3);
+    tr_id    = policer_create (SAI_METER_TYPE_PACKETS, SAI_POLICER_MODE_Tr_TCM, 1, 3, 1, 5);
+    storm_id = policer_create (SAI_METER_TYPE_BYTES, SAI_POLICER_MODE_STORM_CONTROL, 1, 1000, 0, 0);
+
+    meter_run (sr_id, 10, 64, colors);
+    EXPECT_EQ (4u, colors[SAI_PACKET_COLOR_GREEN]);
+    EXPECT_EQ (3u, colors[SAI_PACKET_COLOR_YELLOW]);
+    EXPECT_EQ (3u, colors[SAI_PACKET_COLOR_RED]);
+
+    /* Green frames take peak tokens too */
+    meter_run (tr_id, 10, 64, colors);
+    EXPECT_EQ (3u, colors[SAI_PACKET_COLOR_GREEN]);
+    EXPECT_EQ (2u, colors[SAI_PACKET_COLOR_YELLOW]);
+    EXPECT_EQ (5u, colors[SAI_PACKET_COLOR_RED]);
+
+    meter_run (storm_id, 20, 64, colors);
+    EXPECT_EQ (15u, colors[SAI_PACKET_COLOR_GREEN]);
+    EXPECT_EQ (0u, colors[SAI_PACKET_COLOR_YELLOW]);
+    EXPECT_EQ (5u, colors[SAI_PACKET_COLOR_RED]);
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS,
+               p_policer_api->get_policer_statistics (sr_id, counter_ids, 4, counters));
+    EXPECT_EQ (4u, counters[0]);
+    EXPECT_EQ (3u, counters[1]);
+    EXPECT_EQ (3u, counters[2]);
+    EXPECT_EQ (640u, counters[3]);
+
+    /* A new burst size refills the buckets */
+    sai_attribute_t attr;
+    attr.id        = SAI_POLICER_ATTR_CBS;
+    attr.value.u64 = 2;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_policer_api->set_policer_attribute (sr_id, &attr));
+    meter_run (sr_id, 10, 64, colors);
+    EXPECT_EQ (2u, colors[SAI_PACKET_COLOR_GREEN]);
+    EXPECT_EQ (3u, colors[SAI_PACKET_COLOR_YELLOW]);
+    EXPECT_EQ (5u, colors[SAI_PACKET_COLOR_RED]);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_policer_api->remove_policer (sr_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_policer_api->remove_policer (tr_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_policer_api->remove_policer (storm_id));
+}
+
+/*
+ * Buckets refill at the committed rate and never above their burst size.
+ */
+TEST_F (saiStubPolicerTest, bucket_refill)
+{
+    sai_object_id_t policer_id;
+    uint32_t        colors[3];
+
+    policer_id = policer_create (SAI_METER_TYPE_PACKETS, SAI_POLICER_MODE_STORM_CONTROL, 1000, 10,
+                                 0, 0);
+
+    meter_run (policer_id, 20, 64, colors);
+    EXPECT_EQ (10u, colors[SAI_PACKET_COLOR_GREEN]);
+
+    /* 50 frames earned, 10 kept */
+    usleep (50000);
+    meter_run (policer_id, 20, 64, colors);
+    EXPECT_EQ (10u, colors[SAI_PACKET_COLOR_GREEN]);
+
+    /* About 5 frames earned, with room for a slow scheduler */
+    usleep (5000);
+    meter_run (policer_id, 20, 64, colors);
+    EXPECT_LE (4u, colors[SAI_PACKET_COLOR_GREEN]);
+    EXPECT_GE (10u, colors[SAI_PACKET_COLOR_GREEN]);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_policer_api->remove_policer (policer_id));
+}
+
+/*
+ * Port policers drop the red frames a port receives, storm control the
+ * red frames it floods by destination kind, and a policer in use stays.
+ */
+TEST_F (saiStubPolicerTest, port_policers)
+{
+    sai_object_id_t policer_id, storm_id;
+    sai_attribute_t attr;
+    uint32_t        forwarded, dropped;
+
+    policer_id = policer_create (SAI_METER_TYPE_PACKETS, SAI_POLICER_MODE_STORM_CONTROL, 1, 2, 0, 0);
+    storm_id   = policer_create (SAI_METER_TYPE_PACKETS, SAI_POLICER_MODE_STORM_CONTROL, 1, 1, 0, 0);
+
+    attr.id        = SAI_PORT_ATTR_POLICER_ID;
+    attr.value.oid = policer_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->set_port_attribute (port_oid (1), &attr));
+    attr.value.oid = SAI_NULL_OBJECT_ID;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->get_port_attribute (port_oid (1), 1, &attr));
+    EXPECT_EQ (policer_id, attr.value.oid);
+
+    burst_run (5, port_oid (1), 0x02, &forwarded, &dropped);
+    EXPECT_EQ (2u, forwarded);
+    EXPECT_EQ (3u, dropped);
+
+    /* Other ports are not policed */
+    burst_run (5, port_oid (2), 0x02, &forwarded, &dropped);
+    EXPECT_EQ (5u, forwarded);
+
+    attr.id        = SAI_PORT_ATTR_BROADCAST_STORM_CONTROL_POLICER_ID;
+    attr.value.oid = storm_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->set_port_attribute (port_oid (2), &attr));
+
+    burst_run (3, port_oid (2), 0xFF, &forwarded, &dropped);
+    EXPECT_EQ (1u, forwarded);
+    EXPECT_EQ (2u, dropped);
+
+    /* Unknown unicast and multicast have their own policers */
+    burst_run (3, port_oid (2), 0x02, &forwarded, &dropped);
+    EXPECT_EQ (3u, forwarded);
+    burst_run (3, port_oid (2), 0x01, &forwarded, &dropped);
+    EXPECT_EQ (3u, forwarded);
+
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_policer_api->remove_policer (policer_id));
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_policer_api->remove_policer (storm_id));
+
+    attr.value.oid = SAI_NULL_OBJECT_ID;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->set_port_attribute (port_oid (2), &attr));
+    attr.id = SAI_PORT_ATTR_POLICER_ID;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->set_port_attribute (port_oid (1), &attr));
+
+    burst_run (5, port_oid (1), 0x02, &forwarded, &dropped);
+    EXPECT_EQ (5u, forwarded);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_policer_api->remove_policer (policer_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_policer_api->remove_policer (storm_id));
+}
+
+/*
+ * An ACL entry policer drops the red frames hitting the entry.
+ */
+TEST_F (saiStubPolicerTest, acl_policer)
+{
+    sai_object_id_t table_id, entry_id, policer_id;
+    sai_attribute_t attr[4];
+    uint32_t        forwarded, dropped;
+
+    policer_id = policer_create (SAI_METER_TYPE_PACKETS, SAI_POLICER_MODE_Sr_TCM, 1, 2, 0, 1);
+
+    memset (attr, 0, sizeof (attr));
+    attr[0].id             = SAI_ACL_TABLE_ATTR_STAGE;
+    attr[0].value.s32      = SAI_ACL_STAGE_INGRESS;
+    attr[1].id             = SAI_ACL_TABLE_ATTR_PRIORITY;
+    attr[1].value.u32      = 1;
+    attr[2].id             = SAI_ACL_TABLE_ATTR_FIELD_IN_PORT;
+    attr[2].value.booldata = true;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->create_acl_table (&table_id, 3, attr));
+
+    memset (attr, 0, sizeof (attr));
+    attr[0].id                            = SAI_ACL_ENTRY_ATTR_TABLE_ID;
+    attr[0].value.oid                     = table_id;
+    attr[1].id                            = SAI_ACL_ENTRY_ATTR_FIELD_IN_PORT;
+    attr[1].value.aclfield.enable         = true;
+    attr[1].value.aclfield.data.oid       = port_oid (3);
+    attr[2].id                            = SAI_ACL_ENTRY_ATTR_ACTION_SET_POLICER;
+    attr[2].value.aclaction.enable        = true;
+    attr[2].value.aclaction.parameter.oid = policer_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->create_acl_entry (&entry_id, 3, attr));
+
+    memset (attr, 0, sizeof (attr));
+    attr[0].id = SAI_ACL_ENTRY_ATTR_ACTION_SET_POLICER;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->get_acl_entry_attribute (entry_id, 1, attr));
+    EXPECT_TRUE (attr[0].value.aclaction.enable);
+    EXPECT_EQ (policer_id, attr[0].value.aclaction.parameter.oid);
+
+    /* Green and yellow frames go on */
+    burst_run (6, port_oid (3), 0x02, &forwarded, &dropped);
+    EXPECT_EQ (3u, forwarded);
+    EXPECT_EQ (3u, dropped);
+
+    burst_run (6, port_oid (4), 0x02, &forwarded, &dropped);
+    EXPECT_EQ (6u, forwarded);
+
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_policer_api->remove_policer (policer_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_entry (entry_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_table (table_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_policer_api->remove_policer (policer_id));
+}
+
+/*
+ * A trap group polices the frames trapped through it with its policer.
+ */
+TEST_F (saiStubPolicerTest, trap_group_policer)
+{
+    frame_t                        frame[5];
+    stub_packet_t                  packets[5];
+    stub_hostif_trap_group_stats_t stats;
+    sai_object_id_t                group_id, policer_id;
+    sai_attribute_t                attr[2];
+    uint32_t                       trapped = 0, dropped = 0;
+
+    policer_id = policer_create (SAI_METER_TYPE_PACKETS, SAI_POLICER_MODE_STORM_CONTROL, 1, 2, 0, 0);
+
+    attr[0].id        = SAI_HOSTIF_TRAP_GROUP_ATTR_PRIO;
+    attr[0].value.u32 = 1;
+    attr[1].id        = SAI_HOSTIF_TRAP_GROUP_ATTR_POLICER;
+    attr[1].value.oid = policer_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->create_hostif_trap_group (&group_id, 2, attr));
+
+    attr[1].value.oid = SAI_NULL_OBJECT_ID;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->get_trap_group_attribute (group_id, 1, &attr[1]));
+    EXPECT_EQ (policer_id, attr[1].value.oid);
+
+    attr[0].id        = SAI_HOSTIF_TRAP_ATTR_TRAP_GROUP;
+    attr[0].value.oid = group_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LLDP, attr));
+    attr[0].id        = SAI_HOSTIF_TRAP_ATTR_PACKET_ACTION;
+    attr[0].value.s32 = SAI_PACKET_ACTION_TRAP;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LLDP, attr));
+
+    for (uint32_t i = 0; i < 5; i++) {
+        build_lldp (&frame[i], port_oid (2));
+        packets[i] = frame[i].packet;
+    }
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (5, packets));
+
+    for (uint32_t i = 0; i < 5; i++) {
+        trapped += (SAI_PACKET_ACTION_TRAP == packets[i].packet_action);
+        dropped += (SAI_PACKET_ACTION_DROP == packets[i].packet_action);
+    }
+    EXPECT_EQ (2u, trapped);
+    EXPECT_EQ (3u, dropped);
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_host_interface_get_trap_group_stats (group_id, &stats));
+    EXPECT_EQ (2u, stats.passed);
+    EXPECT_EQ (3u, stats.policed);
+
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_policer_api->remove_policer (policer_id));
+
+    attr[0].value.s32 = SAI_PACKET_ACTION_DROP;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LLDP, attr));
+    attr[0].id        = SAI_HOSTIF_TRAP_ATTR_TRAP_GROUP;
+    attr[0].value.oid = SAI_NULL_OBJECT_ID;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LLDP, attr));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->remove_hostif_trap_group (group_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_policer_api->remove_policer (policer_id));
+}
+
+/*
+ * Metering rate of 32 frame bursts through one policer, and of the data
+ * plane with and without a port policer.
+ */
+TEST_F (saiStubPolicerTest, policer_rate)
+{
+    const uint32_t     rounds = 100000;
+    frame_t            frame;
+    stub_packet_t      packets[32];
+    sai_packet_color_t colors[32];
+    sai_object_id_t    policer_id;
+    sai_attribute_t    attr;
+
+    policer_id = policer_create (SAI_METER_TYPE_BYTES, SAI_POLICER_MODE_Tr_TCM, 100000000, 100000,
+                                 200000000, 200000);
+
+    build_frame (&frame, port_oid (5), 0x02, 64);
+    for (uint32_t i = 0; i < 32; i++) {
+        packets[i] = frame.packet;
+    }
+
+    auto start = std::chrono::steady_clock::now ();
+    for (uint32_t r = 0; r < rounds; r++) {
+        ASSERT_EQ (SAI_STATUS_SUCCESS, stub_policer_meter (policer_id, 32, packets, colors));
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now () - start;
+    printf ("policer meter: %.1f Mpps\n", rounds * 32 / elapsed.count () / 1e6);
+
+    for (int policed = 0; policed < 2; policed++) {
+        attr.id        = SAI_PORT_ATTR_POLICER_ID;
+        attr.value.oid = policed ? policer_id : SAI_NULL_OBJECT_ID;
+        ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->set_port_attribute (port_oid (5), &attr));
+
+        start = std::chrono::steady_clock::now ();
+        for (uint32_t r = 0; r < rounds / 10; r++) {
+            for (uint32_t i = 0; i < 32; i++) {
+                packets[i] = frame.packet;
+            }
+            ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (32, packets));
+        }
+        elapsed = std::chrono::steady_clock::now () - start;
+        printf ("data plane %s port policer: %.1f Mpps\n", policed ? "with" : "without",
+                rounds / 10 * 32 / elapsed.count () / 1e6);
+    }
+
+    attr.value.oid = SAI_NULL_OBJECT_ID;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->set_port_attribute (port_oid (5), &attr));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_policer_api->remove_policer (policer_id));
+}
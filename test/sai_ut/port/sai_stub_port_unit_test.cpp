@@ -0,0 +1,270 @@
+/************************************************************************
+*    Licensed under the Apache License, Version 2.0 (the "License"); you may
+*    not use this file except in compliance with the License. You may obtain
+*    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+*
+*    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+*    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+*    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+*    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+*
+*    See the Apache Version 2.0 License for specific language governing
+*    permissions and limitations under the License.
+*
+*
+* Module Name:
+*
+*    sai_stub_port_unit_test.cpp
+*
+* Abstract:
+*
+*    This file contains tests for the stub port counters. Frames are run
+*    through the stub software data plane and the counters are read back
+*    per port and in bulk; the rate test reports the telemetry poll rate.
+*
+*************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/sai_stub_unit_test_utils.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "sai.h"
+#include "saitypes.h"
+#include "saistatus.h"
+#include "saiswitch.h"
+#include "saiport.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_port.h"
+#include <string.h>
+}
+
+class saiStubPortStatsTest : public saiStubTest
+{
+    protected:
+        static void SetUpTestCase (void);
+
+        struct frame_t {
+            uint8_t       buffer[STUB_DATAPLANE_HEADROOM + 256];
+            stub_packet_t packet;
+        };
+
+        static void build_frame (frame_t *frame, sai_object_id_t in_port, bool broadcast,
+                                 uint32_t length);
+
+        static sai_port_api_t   *p_port_api;
+};
+
+sai_port_api_t* saiStubPortStatsTest::p_port_api = NULL;
+
+/* Bridged frame between two hosts no FDB entry knows */
+void saiStubPortStatsTest::build_frame (frame_t *frame, sai_object_id_t in_port, bool broadcast,
+                                        uint32_t length)
+{
+    uint8_t *eth = frame->buffer + STUB_DATAPLANE_HEADROOM;
+
+    memset (frame->buffer, 0, sizeof (frame->buffer));
+    if (broadcast) {
+        memset (eth, 0xFF, 6);
+    } else {
+        eth[0] = 0x02;
+        eth[5] = 0x42;
+    }
+    eth[6]  = 0x02;
+    eth[11] = 0x99;
+    eth[12] = 0x08;
+
+    memset (&frame->packet, 0, sizeof (frame->packet));
+    frame->packet.data     = eth;
+    frame->packet.length   = length;
+    frame->packet.headroom = STUB_DATAPLANE_HEADROOM;
+    frame->packet.in_port  = in_port;
+}
+
+void saiStubPortStatsTest::SetUpTestCase (void)
+{
+    SetUpStubSwitch ();
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_PORT, (void **)&p_port_api));
+}
+
+/*
+ * Received frames are counted by cast, size and fate before the data
+ * plane touches them.
+ */
+TEST_F (saiStubPortStatsTest, counts_received_frames)
+{
+    const sai_port_stat_counter_t ids[] = {
+        SAI_PORT_STAT_IF_IN_UCAST_PKTS,
+        SAI_PORT_STAT_IF_IN_NON_UCAST_PKTS,
+        SAI_PORT_STAT_IF_IN_BROADCAST_PKTS,
+        SAI_PORT_STAT_IF_IN_OCTETS,
+        SAI_PORT_STAT_IF_IN_DISCARDS,
+        SAI_PORT_STAT_ETHER_STATS_PKTS,
+        SAI_PORT_STAT_ETHER_STATS_UNDERSIZE_PKTS,
+        SAI_PORT_STAT_ETHER_IN_PKTS_64_OCTETS,
+        SAI_PORT_STAT_ETHER_IN_PKTS_65_TO_127_OCTETS,
+        SAI_PORT_STAT_IF_OUT_UCAST_PKTS,
+    };
+    const uint64_t expected[] = { 2, 1, 1, 170, 1, 3, 1, 2, 1, 0 };
+    const uint32_t count = sizeof (ids) / sizeof (ids[0]);
+    uint64_t       counters[count];
+    frame_t        frame[3];
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->clear_port_all_stats (port_oid (5)));
+
+    build_frame (&frame[0], port_oid (5), false, 100);
+    build_frame (&frame[1], port_oid (5), true, 60);
+    /* Runt, dropped by the parser */
+    build_frame (&frame[2], port_oid (5), false, 10);
+
+    stub_packet_t packets[3] = { frame[0].packet, frame[1].packet, frame[2].packet };
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (3, packets));
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->get_port_stats (port_oid (5), ids, count, counters));
+    for (uint32_t i = 0; i < count; i++) {
+        EXPECT_EQ (expected[i], counters[i]) << "counter " << ids[i];
+    }
+
+    /* Unknown counters are refused */
+    sai_port_stat_counter_t bad = (sai_port_stat_counter_t) STUB_PORT_STAT_COUNT;
+    EXPECT_EQ (SAI_STATUS_INVALID_PARAMETER, p_port_api->get_port_stats (port_oid (5), &bad, 1, counters));
+}
+
+/*
+ * Bulk reads cover several ports in one call, clear-on-read and clear
+ * leave the counters at 0.
+ */
+TEST_F (saiStubPortStatsTest, bulk_clear_on_read)
+{
+    const sai_port_stat_counter_t ids[] = {
+        SAI_PORT_STAT_IF_IN_UCAST_PKTS,
+        SAI_PORT_STAT_IF_IN_OCTETS,
+    };
+    const sai_object_id_t ports[] = { port_oid (3), port_oid (4) };
+    uint64_t              counters[4];
+    frame_t               frame[2];
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->clear_port_all_stats (port_oid (3)));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->clear_port_all_stats (port_oid (4)));
+
+    build_frame (&frame[0], port_oid (3), false, 100);
+    build_frame (&frame[1], port_oid (4), false, 200);
+
+    stub_packet_t packets[2] = { frame[0].packet, frame[1].packet };
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (2, packets));
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_port_get_stats_bulk (2, ports, 2, ids, true, counters));
+    EXPECT_EQ (1u, counters[0]);
+    EXPECT_EQ (100u, counters[1]);
+    EXPECT_EQ (1u, counters[2]);
+    EXPECT_EQ (200u, counters[3]);
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_port_get_stats_bulk (2, ports, 2, ids, false, counters));
+    for (uint32_t i = 0; i < 4; i++) {
+        EXPECT_EQ (0u, counters[i]);
+    }
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, &frame[0].packet));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->clear_port_stats (port_oid (3), ids, 1));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->get_port_stats (port_oid (3), ids, 2, counters));
+    EXPECT_EQ (0u, counters[0]);
+    EXPECT_EQ (100u, counters[1]);
+}
+
+/*
+ * Clear-on-read while several threads count frames never loses an
+ * increment.
+ */
+TEST_F (saiStubPortStatsTest, clear_on_read_loses_nothing)
+{
+    const sai_port_stat_counter_t id = SAI_PORT_STAT_IF_IN_UCAST_PKTS;
+    const sai_object_id_t         port = port_oid (7);
+    const uint32_t                threads = 4, bursts = 2000;
+    std::vector<std::thread>      writers;
+    uint64_t                      total = 0, value;
+    bool                          running = true;
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->clear_port_all_stats (port));
+
+    for (uint32_t t = 0; t < threads; t++) {
+        writers.push_back (std::thread ([port, bursts] () {
+            frame_t       frame[STUB_DATAPLANE_BURST];
+            stub_packet_t packets[STUB_DATAPLANE_BURST];
+
+            for (uint32_t b = 0; b < bursts; b++) {
+                for (uint32_t i = 0; i < STUB_DATAPLANE_BURST; i++) {
+                    build_frame (&frame[i], port, false, 64);
+                    packets[i] = frame[i].packet;
+                }
+                stub_dataplane_process_burst (STUB_DATAPLANE_BURST, packets);
+            }
+        }));
+    }
+
+    std::thread reader ([&] () {
+        while (__atomic_load_n (&running, __ATOMIC_ACQUIRE)) {
+            stub_port_get_stats_bulk (1, &port, 1, &id, true, &value);
+            total += value;
+        }
+    });
+
+    for (auto &writer : writers) {
+        writer.join ();
+    }
+    __atomic_store_n (&running, false, __ATOMIC_RELEASE);
+    reader.join ();
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_port_get_stats_bulk (1, &port, 1, &id, true, &value));
+    total += value;
+    EXPECT_EQ ((uint64_t) threads * bursts * STUB_DATAPLANE_BURST, total);
+}
+
+/*
+ * A telemetry poll of 40 counters on every port, one bulk call against a
+ * get_port_stats call per port.
+ */
+TEST_F (saiStubPortStatsTest, poll_rate)
+{
+    const uint32_t                       polls = 20000, counter_count = 40;
+    std::vector<sai_object_id_t>         ports;
+    std::vector<sai_port_stat_counter_t> ids;
+    sai_attribute_t                      attr;
+
+    attr.id = SAI_SWITCH_ATTR_PORT_NUMBER;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->get_switch_attribute (1, &attr));
+    for (uint32_t i = 0; i < attr.value.u32; i++) {
+        ports.push_back (port_oid (i));
+    }
+    for (uint32_t i = 0; i < counter_count; i++) {
+        ids.push_back ((sai_port_stat_counter_t) i);
+    }
+
+    std::vector<uint64_t> bulk (ports.size () * counter_count), single (ports.size () * counter_count);
+
+    auto start = std::chrono::steady_clock::now ();
+    for (uint32_t poll = 0; poll < polls; poll++) {
+        for (uint32_t i = 0; i < ports.size (); i++) {
+            ASSERT_EQ (SAI_STATUS_SUCCESS,
+                       p_port_api->get_port_stats (ports[i], ids.data (), counter_count,
+                                                   single.data () + i * counter_count));
+        }
+    }
+    double single_sec = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+    start = std::chrono::steady_clock::now ();
+    for (uint32_t poll = 0; poll < polls; poll++) {
+        ASSERT_EQ (SAI_STATUS_SUCCESS,
+                   stub_port_get_stats_bulk (ports.size (), ports.data (), counter_count, ids.data (),
+                                             false, bulk.data ()));
+    }
+    double bulk_sec = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+    EXPECT_EQ (single, bulk);
+
+    printf ("poll of %zu ports x %u counters: per port %.2f us, bulk %.2f us\n",
+            ports.size (), counter_count, single_sec * 1e6 / polls, bulk_sec * 1e6 / polls);
+}
@@ -0,0 +1,464 @@
+/************************************************************************
+*    Licensed under the Apache License, Version 2.0 (the "License"); you may
+*    not use this file except in compliance with the License. You may obtain
+*    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+*
+*    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+*    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+*    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+*    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+*
+*    See the Apache Version 2.0 License for specific language governing
+*    permissions and limitations under the License.
+*
+*
+* Module Name:
+*
+*    sai_stub_qos_unit_test.cpp
+*
+* Abstract:
+*
+*    This file contains tests for the stub QoS maps. Map lists are
+*    checked and read back, ports bind maps of the matching type, and the
+*    stub software data plane gives frames a traffic class, a color, a
+*    priority group and a queue by the maps of their ports, also while the
+*    maps change.
+*
+*************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/sai_stub_unit_test_utils.h"
+
+extern "C" {
+#include "sai.h"
+#include "saitypes.h"
+#include "saistatus.h"
+#include "saiswitch.h"
+#include "saiport.h"
+#include "saipolicer.h"
+#include "saiqosmaps.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_policer.h"
+#include <string.h>
+#include <unistd.h>
+}
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+class saiStubQosTest : public saiStubTest
+{
+    protected:
+        static void SetUpTestCase (void);
+
+        struct frame_t {
+            uint8_t       buffer[STUB_DATAPLANE_HEADROOM + 128];
+            stub_packet_t packet;
+        };
+
+        static void build_frame (frame_t *frame, sai_object_id_t in_port, int vlan_pcp, int dscp);
+        static sai_object_id_t map_create (sai_qos_map_type_t type, uint32_t count,
+                                           sai_qos_map_t *list);
+        static void port_set (sai_object_id_t port_id, sai_attr_id_t id, sai_object_id_t map_id);
+
+        static sai_qos_map_api_t *p_qos_map_api;
+        static sai_port_api_t    *p_port_api;
+        static sai_policer_api_t *p_policer_api;
+};
+
+sai_qos_map_api_t* saiStubQosTest::p_qos_map_api = NULL;
+sai_port_api_t* saiStubQosTest::p_port_api = NULL;
+sai_policer_api_t* saiStubQosTest::p_policer_api = NULL;
+
+static void frame_init (uint8_t *eth, stub_packet_t *packet, uint32_t length,
+                        sai_object_id_t in_port)
+{
+    memset (packet, 0, sizeof (*packet));
+    packet->data     = eth;
+    packet->length   = length;
+    packet->headroom = STUB_DATAPLANE_HEADROOM;
+    packet->in_port  = in_port;
+}
+
+/*
+ * Unknown unicast frame, flooded since no address is learned. A VLAN 1
+ * tag of priority vlan_pcp when not negative, an IPv4 header of DSCP dscp
+ * when not negative, a local experimental ethertype otherwise.
+ */
+void saiStubQosTest::build_frame (frame_t *frame, sai_object_id_t in_port, int vlan_pcp, int dscp)
+{
+    uint8_t *eth = frame->buffer + STUB_DATAPLANE_HEADROOM;
+    uint8_t *l3  = eth + 14;
+
+    memset (frame->buffer, 0, sizeof (frame->buffer));
+    memset (eth, 0x02, 6);
+    eth[6]  = 0x02;
+    eth[11] = 0x77;
+    if (vlan_pcp >= 0) {
+        eth[12] = 0x81;
+        eth[14] = (uint8_t)(vlan_pcp << 5);
+        eth[15] = 0x01;
+        l3     += 4;
+    }
+    if (dscp >= 0) {
+        l3[-2] = 0x08;
+        l3[-1] = 0x00;
+        l3[0]  = 0x45;
+        l3[1]  = (uint8_t)(dscp << 2);
+        l3[3]  = 46;
+        l3[8]  = 64;
+        l3[9]  = 0xFD;
+    } else {
+        l3[-2] = 0x88;
+        l3[-1] = 0xB5;
+    }
+    frame_init (eth, &frame->packet, 64, in_port);
+}
+
+sai_object_id_t saiStubQosTest::map_create (sai_qos_map_type_t type, uint32_t count,
+                                            sai_qos_map_t *list)
+{
+    sai_object_id_t map_id = SAI_NULL_OBJECT_ID;
+    sai_attribute_t attr[2];
+
+    memset (attr, 0, sizeof (attr));
+    attr[0].id                 = SAI_QOS_MAP_ATTR_TYPE;
+    attr[0].value.s32          = type;
+    attr[1].id                 = SAI_QOS_MAP_ATTR_MAP_TO_VALUE_LIST;
+    attr[1].value.qosmap.count = count;
+    attr[1].value.qosmap.list  = list;
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_qos_map_api->create_qos_map (&map_id, 2, attr));
+
+    return map_id;
+}
+
+void saiStubQosTest::port_set (sai_object_id_t port_id, sai_attr_id_t id, sai_object_id_t map_id)
+{
+    sai_attribute_t attr;
+
+    attr.id        = id;
+    attr.value.oid = map_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->set_port_attribute (port_id, &attr));
+}
+
+void saiStubQosTest::SetUpTestCase (void)
+{
+    SetUpStubSwitch ();
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_QOS_MAPS, (void **)&p_qos_map_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_PORT, (void **)&p_port_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_POLICER, (void **)&p_policer_api));
+}
+
+/*
+ * Map lists take keys and values in range, each key once, and read back
+ * as set. Ports bind maps of the matching type only, and bound maps stay.
+ */
+TEST_F (saiStubQosTest, map_attributes)
+{
+    sai_object_id_t map_id, bad_id;
+    sai_qos_map_t   list[3], read[3];
+    sai_attribute_t attr[2];
+
+    memset (list, 0, sizeof (list));
+    memset (attr, 0, sizeof (attr));
+    list[0].key.dscp  = 10;
+    list[0].value.tc  = 3;
+    list[1].key.dscp  = 46;
+    list[1].value.tc  = 8;
+    attr[0].id                 = SAI_QOS_MAP_ATTR_TYPE;
+    attr[0].value.s32          = SAI_QOS_MAP_DSCP_TO_TC;
+    attr[1].id                 = SAI_QOS_MAP_ATTR_MAP_TO_VALUE_LIST;
+    attr[1].value.qosmap.count = 2;
+    attr[1].value.qosmap.list  = list;
+
+    /* Traffic class out of range, then a repeated key */
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0 + 1, p_qos_map_api->create_qos_map (&bad_id, 2, attr));
+    list[1].value.tc = 5;
+    list[1].key.dscp = 10;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0 + 1, p_qos_map_api->create_qos_map (&bad_id, 2, attr));
+    list[1].key.dscp = 64;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_qos_map_api->create_qos_map (&bad_id, 2, attr));
+    list[1].key.dscp = 46;
+
+    /* The type is mandatory */
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_qos_map_api->create_qos_map (&bad_id, 1, &attr[1]));
+
+    map_id = map_create (SAI_QOS_MAP_DSCP_TO_TC, 2, list);
+
+    memset (read, 0, sizeof (read));
+    attr[0].id                 = SAI_QOS_MAP_ATTR_TYPE;
+    attr[1].value.qosmap.count = 3;
+    attr[1].value.qosmap.list  = read;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_qos_map_api->get_qos_map_attribute (map_id, 2, attr));
+    EXPECT_EQ (SAI_QOS_MAP_DSCP_TO_TC, attr[0].value.s32);
+    ASSERT_EQ (2u, attr[1].value.qosmap.count);
+    EXPECT_EQ (10, read[0].key.dscp);
+    EXPECT_EQ (3, read[0].value.tc);
+    EXPECT_EQ (46, read[1].key.dscp);
+    EXPECT_EQ (5, read[1].value.tc);
+
+    /* Create only type */
+    attr[0].value.s32 = SAI_QOS_MAP_DOT1P_TO_TC;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_qos_map_api->set_qos_map_attribute (map_id, &attr[0]));
+
+    /* A DSCP to TC map does not bind as a DOT1P to TC map */
+    attr[0].id        = SAI_PORT_ATTR_QOS_DOT1P_TO_TC_MAP;
+    attr[0].value.oid = map_id;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_port_api->set_port_attribute (port_oid (2), &attr[0]));
+
+    port_set (port_oid (2), SAI_PORT_ATTR_QOS_DSCP_TO_TC_MAP, map_id);
+    attr[0].id        = SAI_PORT_ATTR_QOS_DSCP_TO_TC_MAP;
+    attr[0].value.oid = SAI_NULL_OBJECT_ID;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->get_port_attribute (port_oid (2), 1, &attr[0]));
+    EXPECT_EQ (map_id, attr[0].value.oid);
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_qos_map_api->remove_qos_map (map_id));
+
+    /* Default traffic class up to 7 */
+    attr[0].id       = SAI_PORT_ATTR_QOS_DEFAULT_TC;
+    attr[0].value.u8 = 8;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_port_api->set_port_attribute (port_oid (2), &attr[0]));
+    attr[0].value.u8 = 0;
+
+    port_set (port_oid (2), SAI_PORT_ATTR_QOS_DSCP_TO_TC_MAP, SAI_NULL_OBJECT_ID);
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_qos_map_api->remove_qos_map (map_id));
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_qos_map_api->remove_qos_map (map_id));
+}
+
+/*
+ * IP frames take the traffic class and color of the DSCP maps, tagged
+ * frames those of the DOT1P maps, other frames the port default traffic
+ * class and green. Flooded frames take the queue of the ingress port TC to
+ * queue map, and color aware policers keep yellow frames from green.
+ */
+TEST_F (saiStubQosTest, classification)
+{
+    sai_object_id_t    port_id = port_oid (3), map_id[6], policer_id;
+    sai_qos_map_t      list[2];
+    sai_attribute_t    attr[6];
+    frame_t            frame[4];
+    stub_packet_t      packets[4];
+    sai_packet_color_t colors[4];
+
+    memset (list, 0, sizeof (list));
+    list[0].key.dscp    = 46;
+    list[0].value.tc    = 5;
+    map_id[0] = map_create (SAI_QOS_MAP_DSCP_TO_TC, 1, list);
+    list[0].value.color = SAI_PACKET_COLOR_YELLOW;
+    map_id[1] = map_create (SAI_QOS_MAP_DSCP_TO_COLOR, 1, list);
+    memset (list, 0, sizeof (list));
+    list[0].key.dot1p   = 6;
+    list[0].value.tc    = 6;
+    map_id[2] = map_create (SAI_QOS_MAP_DOT1P_TO_TC, 1, list);
+    list[0].value.color = SAI_PACKET_COLOR_RED;
+    map_id[3] = map_create (SAI_QOS_MAP_DOT1P_TO_COLOR, 1, list);
+    memset (list, 0, sizeof (list));
+    list[0].key.tc            = 5;
+    list[0].value.queue_index = 7;
+    list[1].key.tc            = 2;
+    list[1].value.queue_index = 1;
+    map_id[4] = map_create (SAI_QOS_MAP_TC_TO_QUEUE, 2, list);
+    memset (list, 0, sizeof (list));
+    list[0].key.tc   = 5;
+    list[0].value.pg = 3;
+    map_id[5] = map_create (SAI_QOS_MAP_TC_TO_PRIORITY_GROUP, 1, list);
+
+    port_set (port_id, SAI_PORT_ATTR_QOS_DSCP_TO_TC_MAP, map_id[0]);
+    port_set (port_id, SAI_PORT_ATTR_QOS_DSCP_TO_COLOR_MAP, map_id[1]);
+    port_set (port_id, SAI_PORT_ATTR_QOS_DOT1P_TO_TC_MAP, map_id[2]);
+    port_set (port_id, SAI_PORT_ATTR_QOS_DOT1P_TO_COLOR_MAP, map_id[3]);
+    port_set (port_id, SAI_PORT_ATTR_QOS_TC_TO_QUEUE_MAP, map_id[4]);
+    port_set (port_id, SAI_PORT_ATTR_QOS_TC_TO_PRIORITY_GROUP_MAP, map_id[5]);
+    attr[0].id       = SAI_PORT_ATTR_QOS_DEFAULT_TC;
+    attr[0].value.u8 = 2;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->set_port_attribute (port_id, &attr[0]));
+
+    build_frame (&frame[0], port_id, -1, 46);
+    build_frame (&frame[1], port_id, 6, 46);
+    build_frame (&frame[2], port_id, 6, -1);
+    build_frame (&frame[3], port_id, -1, -1);
+    for (uint32_t i = 0; i < 4; i++) {
+        packets[i] = frame[i].packet;
+    }
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (4, packets));
+
+    /* DSCP wins over DOT1P */
+    EXPECT_EQ (5, packets[0].tc);
+    EXPECT_EQ (SAI_PACKET_COLOR_YELLOW, packets[0].color);
+    EXPECT_EQ (7, packets[0].queue);
+    EXPECT_EQ (3, packets[0].priority_group);
+    EXPECT_EQ (5, packets[1].tc);
+    EXPECT_EQ (SAI_PACKET_COLOR_YELLOW, packets[1].color);
+    EXPECT_EQ (6, packets[2].tc);
+    EXPECT_EQ (SAI_PACKET_COLOR_RED, packets[2].color);
+    EXPECT_EQ (0, packets[2].queue);
+    EXPECT_EQ (2, packets[3].tc);
+    EXPECT_EQ (SAI_PACKET_COLOR_GREEN, packets[3].color);
+    EXPECT_EQ (1, packets[3].queue);
+    EXPECT_EQ (0, packets[3].priority_group);
+
+    /* Plenty of committed tokens, yet yellow frames stay yellow and red ones red */
+    memset (attr, 0, sizeof (attr));
+    attr[0].id        = SAI_POLICER_ATTR_METER_TYPE;
+    attr[0].value.s32 = SAI_METER_TYPE_PACKETS;
+    attr[1].id        = SAI_POLICER_ATTR_MODE;
+    attr[1].value.s32 = SAI_POLICER_MODE_Sr_TCM;
+    attr[2].id        = SAI_POLICER_ATTR_CIR;
+    attr[2].value.u64 = 1000;
+    attr[3].id        = SAI_POLICER_ATTR_CBS;
+    attr[3].value.u64 = 100;
+    attr[4].id        = SAI_POLICER_ATTR_PBS;
+    attr[4].value.u64 = 100;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_policer_api->create_policer (&policer_id, 5, attr));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_policer_meter (policer_id, 4, packets, colors));
+    EXPECT_EQ (SAI_PACKET_COLOR_YELLOW, colors[0]);
+    EXPECT_EQ (SAI_PACKET_COLOR_YELLOW, colors[1]);
+    EXPECT_EQ (SAI_PACKET_COLOR_RED, colors[2]);
+    EXPECT_EQ (SAI_PACKET_COLOR_GREEN, colors[3]);
+
+    /* Color blind policers take every frame as green */
+    attr[0].id        = SAI_POLICER_ATTR_COLOR_SOURCE;
+    attr[0].value.s32 = SAI_POLICER_COLOR_SOURCE_BLIND;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_policer_api->set_policer_attribute (policer_id, &attr[0]));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_policer_meter (policer_id, 4, packets, colors));
+    for (uint32_t i = 0; i < 4; i++) {
+        EXPECT_EQ (SAI_PACKET_COLOR_GREEN, colors[i]);
+    }
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_policer_api->remove_policer (policer_id));
+
+    /* Unbound, the frames fall back to the defaults */
+    port_set (port_id, SAI_PORT_ATTR_QOS_DSCP_TO_TC_MAP, SAI_NULL_OBJECT_ID);
+    port_set (port_id, SAI_PORT_ATTR_QOS_DSCP_TO_COLOR_MAP, SAI_NULL_OBJECT_ID);
+    port_set (port_id, SAI_PORT_ATTR_QOS_DOT1P_TO_TC_MAP, SAI_NULL_OBJECT_ID);
+    port_set (port_id, SAI_PORT_ATTR_QOS_DOT1P_TO_COLOR_MAP, SAI_NULL_OBJECT_ID);
+    port_set (port_id, SAI_PORT_ATTR_QOS_TC_TO_QUEUE_MAP, SAI_NULL_OBJECT_ID);
+    port_set (port_id, SAI_PORT_ATTR_QOS_TC_TO_PRIORITY_GROUP_MAP, SAI_NULL_OBJECT_ID);
+    attr[0].id       = SAI_PORT_ATTR_QOS_DEFAULT_TC;
+    attr[0].value.u8 = 0;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->set_port_attribute (port_id, &attr[0]));
+
+    packets[0] = frame[0].packet;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, packets));
+    EXPECT_EQ (0, packets[0].tc);
+    EXPECT_EQ (SAI_PACKET_COLOR_GREEN, packets[0].color);
+    EXPECT_EQ (0, packets[0].queue);
+    EXPECT_EQ (0, packets[0].priority_group);
+
+    for (uint32_t i = 0; i < 6; i++) {
+        EXPECT_EQ (SAI_STATUS_SUCCESS, p_qos_map_api->remove_qos_map (map_id[i]));
+    }
+}
+
+/*
+ * A writer keeps replacing the list of a bound map while bursts run;
+ * every frame sees one list or the other, never a table in between.
+ */
+TEST_F (saiStubQosTest, map_swap)
+{
+    sai_object_id_t   port_id = port_oid (4), map_id;
+    sai_qos_map_t     list[2][2];
+    std::atomic<bool> stop (false);
+    frame_t           frame;
+    stub_packet_t     packets[32];
+    uint32_t          seen[8] = { 0 };
+
+    memset (list, 0, sizeof (list));
+    list[0][0].key.dscp = 10;
+    list[0][0].value.tc = 3;
+    list[0][1].key.dscp = 20;
+    list[0][1].value.tc = 3;
+    list[1][0].key.dscp = 10;
+    list[1][0].value.tc = 5;
+    list[1][1].key.dscp = 20;
+    list[1][1].value.tc = 5;
+    map_id = map_create (SAI_QOS_MAP_DSCP_TO_TC, 2, list[0]);
+    port_set (port_id, SAI_PORT_ATTR_QOS_DSCP_TO_TC_MAP, map_id);
+
+    std::thread writer ([&] {
+        sai_attribute_t attr;
+
+        attr.id                 = SAI_QOS_MAP_ATTR_MAP_TO_VALUE_LIST;
+        attr.value.qosmap.count = 2;
+        for (uint32_t r = 0; !stop.load (); r++) {
+            attr.value.qosmap.list = list[r & 1];
+            EXPECT_EQ (SAI_STATUS_SUCCESS, p_qos_map_api->set_qos_map_attribute (map_id, &attr));
+        }
+    });
+
+    build_frame (&frame, port_id, -1, 10);
+    for (uint32_t r = 0; r < 2000; r++) {
+        for (uint32_t i = 0; i < 32; i++) {
+            packets[i] = frame.packet;
+        }
+        ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (32, packets));
+        for (uint32_t i = 0; i < 32; i++) {
+            ASSERT_LT (packets[i].tc, 8);
+            seen[packets[i].tc]++;
+        }
+    }
+
+    stop = true;
+    writer.join ();
+
+    EXPECT_EQ (2000u * 32, seen[3] + seen[5]);
+
+    port_set (port_id, SAI_PORT_ATTR_QOS_DSCP_TO_TC_MAP, SAI_NULL_OBJECT_ID);
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_qos_map_api->remove_qos_map (map_id));
+}
+
+/*
+ * Data plane rate of 32 frame bursts of IPv4 frames with and without the
+ * ingress and egress QoS maps.
+ */
+TEST_F (saiStubQosTest, qos_rate)
+{
+    const uint32_t  rounds = 10000;
+    sai_object_id_t port_id = port_oid (5), map_id[3];
+    sai_qos_map_t   list[8];
+    frame_t         frame;
+    stub_packet_t   packets[32];
+
+    memset (list, 0, sizeof (list));
+    for (uint32_t i = 0; i < 8; i++) {
+        list[i].key.dscp          = (uint8_t)(i * 8);
+        list[i].value.tc          = (sai_cos_t)i;
+        list[i].key.tc            = (sai_cos_t)i;
+        list[i].value.queue_index = (sai_queue_index_t)(7 - i);
+    }
+    map_id[0] = map_create (SAI_QOS_MAP_DSCP_TO_TC, 8, list);
+    map_id[1] = map_create (SAI_QOS_MAP_TC_TO_QUEUE, 8, list);
+    for (uint32_t i = 0; i < 8; i++) {
+        list[i].value.color = (i < 4) ? SAI_PACKET_COLOR_GREEN : SAI_PACKET_COLOR_YELLOW;
+    }
+    map_id[2] = map_create (SAI_QOS_MAP_DSCP_TO_COLOR, 8, list);
+
+    build_frame (&frame, port_id, -1, 40);
+
+    for (int mapped = 0; mapped < 2; mapped++) {
+        port_set (port_id, SAI_PORT_ATTR_QOS_DSCP_TO_TC_MAP, mapped ? map_id[0] : SAI_NULL_OBJECT_ID);
+        port_set (port_id, SAI_PORT_ATTR_QOS_TC_TO_QUEUE_MAP, mapped ? map_id[1] : SAI_NULL_OBJECT_ID);
+        port_set (port_id, SAI_PORT_ATTR_QOS_DSCP_TO_COLOR_MAP, mapped ? map_id[2] : SAI_NULL_OBJECT_ID);
+
+        auto start = std::chrono::steady_clock::now ();
+        for (uint32_t r = 0; r < rounds; r++) {
+            for (uint32_t i = 0; i < 32; i++) {
+                packets[i] = frame.packet;
+            }
+            ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (32, packets));
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now () - start;
+        printf ("data plane %s QoS maps: %.1f Mpps\n", mapped ? "with" : "without",
+                rounds * 32 / elapsed.count () / 1e6);
+
+        EXPECT_EQ (mapped ? 5 : 0, packets[0].tc);
+        EXPECT_EQ (mapped ? 2 : 0, packets[0].queue);
+    }
+
+    port_set (port_id, SAI_PORT_ATTR_QOS_DSCP_TO_TC_MAP, SAI_NULL_OBJECT_ID);
+    port_set (port_id, SAI_PORT_ATTR_QOS_TC_TO_QUEUE_MAP, SAI_NULL_OBJECT_ID);
+    port_set (port_id, SAI_PORT_ATTR_QOS_DSCP_TO_COLOR_MAP, SAI_NULL_OBJECT_ID);
+    for (uint32_t i = 0; i < 3; i++) {
+        EXPECT_EQ (SAI_STATUS_SUCCESS, p_qos_map_api->remove_qos_map (map_id[i]));
+    }
+}
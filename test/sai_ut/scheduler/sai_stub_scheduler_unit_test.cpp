@@ -0,0 +1,577 @@
+/************************************************************************
+*    Licensed under the Apache License, Version 2.0 (the "License"); you may
+*    not use this file except in compliance with the License. You may obtain
+*    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+*
+*    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+*    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+*    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+*    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+*
+*    See the Apache Version 2.0 License for specific language governing
+*    permissions and limitations under the License.
+*
+*
+* Module Name:
+*
+*    sai_stub_scheduler_unit_test.cpp
+*
+* Abstract:
+*
+*    This file contains tests for the stub egress scheduler. Scheduler
+*    profiles and groups are checked and read back, and congested queues
+*    drain on the simulated clock by strict priority, DWRR weights and
+*    shapers, with tail drops and occupancy in the queue statistics.
+*
+*************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/sai_stub_unit_test_utils.h"
+
+extern "C" {
+#include "sai.h"
+#include "saitypes.h"
+#include "saistatus.h"
+#include "saiswitch.h"
+#include "saiport.h"
+#include "saiqueue.h"
+#include "saischeduler.h"
+#include "saischedulergroup.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_scheduler.h"
+#include <string.h>
+#include <unistd.h>
+}
+
+#include <chrono>
+
+/* 10 Gbps */
+#define LINE_RATE 1250000000ULL
+
+class saiStubSchedulerTest : public saiStubTest
+{
+    protected:
+        static void SetUpTestCase (void);
+
+        struct frame_t {
+            uint8_t       buffer[STUB_DATAPLANE_HEADROOM + 128];
+            stub_packet_t packet;
+        };
+
+        static sai_object_id_t queue_oid (uint32_t port, uint32_t queue);
+        static void enqueue (uint32_t port, uint32_t queue, uint32_t count, uint32_t length);
+        static uint64_t queue_stat (sai_object_id_t queue_id, sai_queue_stat_counter_t counter);
+        static sai_object_id_t profile_create (sai_scheduling_type_t algorithm, uint8_t weight,
+                                               uint64_t max_rate);
+        static sai_object_id_t group_create (uint32_t port, uint8_t level, uint8_t max_childs);
+        static void queue_profile_set (sai_object_id_t queue_id, sai_object_id_t scheduler_id);
+
+        static sai_port_api_t            *p_port_api;
+        static sai_queue_api_t           *p_queue_api;
+        static sai_scheduler_api_t       *p_scheduler_api;
+        static sai_scheduler_group_api_t *p_scheduler_group_api;
+};
+
+sai_port_api_t* saiStubSchedulerTest::p_port_api = NULL;
+sai_queue_api_t* saiStubSchedulerTest::p_queue_api = NULL;
+sai_scheduler_api_t* saiStubSchedulerTest::p_scheduler_api = NULL;
+sai_scheduler_group_api_t* saiStubSchedulerTest::p_scheduler_group_api = NULL;
+
+/* Queue from the queue list of the port */
+sai_object_id_t saiStubSchedulerTest::queue_oid (uint32_t port, uint32_t queue)
+{
+    sai_object_id_t queues[STUB_SCHEDULER_MAX_CHILDS];
+    sai_attribute_t attr;
+
+    attr.id                   = SAI_PORT_ATTR_QOS_QUEUE_LIST;
+    attr.value.objlist.count  = STUB_SCHEDULER_MAX_CHILDS;
+    attr.value.objlist.list   = queues;
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_port_api->get_port_attribute (port_oid (port), 1, &attr));
+    EXPECT_LT (queue, attr.value.objlist.count);
+
+    return queues[queue];
+}
+
+/* Forwarded green frames to a queue of a port, in bursts */
+void saiStubSchedulerTest::enqueue (uint32_t port, uint32_t queue, uint32_t count, uint32_t length)
+{
+    stub_packet_t packets[STUB_DATAPLANE_BURST];
+    uint32_t      ii, burst;
+
+    for (; count > 0; count -= burst) {
+        burst = (count < STUB_DATAPLANE_BURST) ? count : STUB_DATAPLANE_BURST;
+        memset (packets, 0, sizeof (packets));
+        for (ii = 0; ii < burst; ii++) {
+            packets[ii].length        = length;
+            packets[ii].in_port       = port_oid (0);
+            packets[ii].out_port      = port_oid (port);
+            packets[ii].packet_action = SAI_PACKET_ACTION_FORWARD;
+            packets[ii].queue         = queue;
+        }
+        ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_enqueue (burst, packets));
+    }
+}
+
+uint64_t saiStubSchedulerTest::queue_stat (sai_object_id_t queue_id, sai_queue_stat_counter_t counter)
+{
+    uint64_t value = 0;
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_queue_api->get_queue_stats (queue_id, &counter, 1, &value));
+
+    return value;
+}
+
+sai_object_id_t saiStubSchedulerTest::profile_create (sai_scheduling_type_t algorithm, uint8_t weight,
+                                                      uint64_t max_rate)
+{
+    sai_object_id_t scheduler_id = SAI_NULL_OBJECT_ID;
+    sai_attribute_t attr[3];
+
+    attr[0].id        = SAI_SCHEDULER_ATTR_SCHEDULING_ALGORITHM;
+    attr[0].value.s32 = algorithm;
+    attr[1].id        = SAI_SCHEDULER_ATTR_SCHEDULING_WEIGHT;
+    attr[1].value.u8  = weight;
+    attr[2].id        = SAI_SCHEDULER_ATTR_MAX_BANDWIDTH_RATE;
+    attr[2].value.u64 = max_rate;
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_scheduler_api->create_scheduler_profile (&scheduler_id, 3, attr));
+
+    return scheduler_id;
+}
+
+sai_object_id_t saiStubSchedulerTest::group_create (uint32_t port, uint8_t level, uint8_t max_childs)
+{
+    sai_object_id_t group_id = SAI_NULL_OBJECT_ID;
+    sai_attribute_t attr[3];
+
+    attr[0].id        = SAI_SCHEDULER_GROUP_ATTR_PORT_ID;
+    attr[0].value.oid = port_oid (port);
+    attr[1].id        = SAI_SCHEDULER_GROUP_ATTR_LEVEL;
+    attr[1].value.u8  = level;
+    attr[2].id        = SAI_SCHEDULER_GROUP_ATTR_MAX_CHILDS;
+    attr[2].value.u8  = max_childs;
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_scheduler_group_api->create_scheduler_group (&group_id, 3, attr));
+
+    return group_id;
+}
+
+void saiStubSchedulerTest::queue_profile_set (sai_object_id_t queue_id, sai_object_id_t scheduler_id)
+{
+    sai_attribute_t attr;
+
+    attr.id        = SAI_QUEUE_ATTR_SCHEDULER_PROFILE_ID;
+    attr.value.oid = scheduler_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_queue_api->set_queue_attribute (queue_id, &attr));
+}
+
+void saiStubSchedulerTest::SetUpTestCase (void)
+{
+    SetUpStubSwitch ();
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_PORT, (void **)&p_port_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_QUEUE, (void **)&p_queue_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_SCHEDULER, (void **)&p_scheduler_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS,
+               sai_api_query (SAI_API_SCHEDULER_GROUP, (void **)&p_scheduler_group_api));
+}
+
+/*
+ * Profiles take values in range and read back as set. Groups take a level
+ * below STUB_SCHEDULER_LEVELS, one level 0 group a port, and children on
+ * their port a level below, each with one parent. Used profiles and groups
+ * with children stay.
+ */
+TEST_F (saiStubSchedulerTest, scheduler_attributes)
+{
+    sai_object_id_t scheduler_id, bad_id, root_id, group_id, other_id, children[4];
+    sai_attribute_t attr[3];
+
+    memset (attr, 0, sizeof (attr));
+
+    /* Weight 0 and an unknown algorithm */
+    attr[0].id        = SAI_SCHEDULER_ATTR_SCHEDULING_ALGORITHM;
+    attr[0].value.s32 = SAI_SCHEDULING_DWRR;
+    attr[1].id        = SAI_SCHEDULER_ATTR_SCHEDULING_WEIGHT;
+    attr[1].value.u8  = 0;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0 + 1,
+               p_scheduler_api->create_scheduler_profile (&bad_id, 2, attr));
+    attr[1].value.u8  = 101;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0 + 1,
+               p_scheduler_api->create_scheduler_profile (&bad_id, 2, attr));
+    attr[1].value.u8  = 20;
+    attr[0].value.s32 = 3;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0,
+               p_scheduler_api->create_scheduler_profile (&bad_id, 2, attr));
+    attr[0].value.s32 = SAI_SCHEDULING_DWRR;
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_scheduler_api->create_scheduler_profile (&scheduler_id, 2, attr));
+
+    attr[2].id = SAI_SCHEDULER_ATTR_SHAPER_TYPE;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_scheduler_api->get_scheduler_attribute (scheduler_id, 3, attr));
+    EXPECT_EQ (SAI_SCHEDULING_DWRR, attr[0].value.s32);
+    EXPECT_EQ (20, attr[1].value.u8);
+    EXPECT_EQ (SAI_METER_TYPE_BYTES, attr[2].value.s32);
+
+    attr[0].id        = SAI_SCHEDULER_ATTR_MAX_BANDWIDTH_RATE;
+    attr[0].value.u64 = 125000000;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_scheduler_api->set_scheduler_attribute (scheduler_id, &attr[0]));
+    attr[0].value.u64 = 0;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_scheduler_api->get_scheduler_attribute (scheduler_id, 1, &attr[0]));
+    EXPECT_EQ (125000000u, attr[0].value.u64);
+
+    /* Ports have STUB_QOS_QUEUES queues and no groups */
+    attr[0].id = SAI_PORT_ATTR_QOS_NUMBER_OF_QUEUES;
+    attr[1].id = SAI_PORT_ATTR_QOS_NUMBER_OF_SCHEDULER_GROUPS;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->get_port_attribute (port_oid (3), 2, attr));
+    EXPECT_EQ (8u, attr[0].value.u32);
+    EXPECT_EQ (0u, attr[1].value.u32);
+
+    /* Level and max childs in range, one root a port */
+    attr[0].id        = SAI_SCHEDULER_GROUP_ATTR_PORT_ID;
+    attr[0].value.oid = port_oid (3);
+    attr[1].id        = SAI_SCHEDULER_GROUP_ATTR_LEVEL;
+    attr[1].value.u8  = STUB_SCHEDULER_LEVELS;
+    attr[2].id        = SAI_SCHEDULER_GROUP_ATTR_MAX_CHILDS;
+    attr[2].value.u8  = 4;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0 + 1,
+               p_scheduler_group_api->create_scheduler_group (&bad_id, 3, attr));
+    attr[1].value.u8  = 0;
+    attr[2].value.u8  = 0;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0 + 2,
+               p_scheduler_group_api->create_scheduler_group (&bad_id, 3, attr));
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_scheduler_group_api->create_scheduler_group (&bad_id, 2, attr));
+
+    root_id  = group_create (3, 0, 2);
+    group_id = group_create (3, 1, 4);
+    other_id = group_create (4, 1, 4);
+    attr[2].value.u8 = 4;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0 + 1,
+               p_scheduler_group_api->create_scheduler_group (&bad_id, 3, attr));
+
+    /* Children a level below, on the port of the group, once */
+    children[0] = queue_oid (3, 0);
+    children[1] = queue_oid (3, 1);
+    children[2] = queue_oid (4, 0);
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_scheduler_group_api->add_child_object_to_group (group_id, 1, &root_id));
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_scheduler_group_api->add_child_object_to_group (root_id, 1, &other_id));
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_scheduler_group_api->add_child_object_to_group (group_id, 1, &children[2]));
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_scheduler_group_api->add_child_object_to_group (group_id, 2, children + 1));
+    children[3] = children[0];
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_scheduler_group_api->add_child_object_to_group (group_id, 2, children + 2));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_scheduler_group_api->add_child_object_to_group (group_id, 2, children));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_scheduler_group_api->add_child_object_to_group (root_id, 1, &group_id));
+
+    /* One parent each, and no more than max childs */
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_scheduler_group_api->add_child_object_to_group (root_id, 1, &children[0]));
+    children[2] = queue_oid (3, 2);
+    children[3] = queue_oid (3, 3);
+    EXPECT_EQ (SAI_STATUS_INSUFFICIENT_RESOURCES,
+               p_scheduler_group_api->add_child_object_to_group (root_id, 2, children + 2));
+
+    memset (children + 2, 0, 2 * sizeof (children[0]));
+    attr[0].id                  = SAI_SCHEDULER_GROUP_ATTR_CHILD_COUNT;
+    attr[1].id                  = SAI_SCHEDULER_GROUP_ATTR_CHILD_LIST;
+    attr[1].value.objlist.count = 2;
+    attr[1].value.objlist.list  = children + 2;
+    attr[2].id                  = SAI_SCHEDULER_GROUP_ATTR_LEVEL;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_scheduler_group_api->get_scheduler_group_attribute (group_id, 3, attr));
+    EXPECT_EQ (2u, attr[0].value.u32);
+    ASSERT_EQ (2u, attr[1].value.objlist.count);
+    EXPECT_EQ (children[0], children[2]);
+    EXPECT_EQ (children[1], children[3]);
+    EXPECT_EQ (1, attr[2].value.u8);
+
+    attr[0].id                  = SAI_PORT_ATTR_QOS_SCHEDULER_GROUP_LIST;
+    attr[0].value.objlist.count = 4;
+    attr[0].value.objlist.list  = children + 2;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->get_port_attribute (port_oid (3), 1, attr));
+    EXPECT_EQ (2u, attr[0].value.objlist.count);
+
+    /* A profile in use, groups in the tree */
+    attr[0].id        = SAI_SCHEDULER_GROUP_ATTR_SCHEDULER_PROFILE_ID;
+    attr[0].value.oid = scheduler_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_scheduler_group_api->set_scheduler_group_attribute (group_id, attr));
+    queue_profile_set (children[0], scheduler_id);
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_scheduler_api->remove_scheduler_profile (scheduler_id));
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_scheduler_group_api->remove_scheduler_group (group_id));
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_scheduler_group_api->remove_scheduler_group (root_id));
+
+    attr[0].id        = SAI_QUEUE_ATTR_SCHEDULER_PROFILE_ID;
+    attr[0].value.oid = SAI_NULL_OBJECT_ID;
+    attr[1].id        = SAI_QUEUE_ATTR_TYPE;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_queue_api->get_queue_attribute (children[0], 2, attr));
+    EXPECT_EQ (scheduler_id, attr[0].value.oid);
+    EXPECT_EQ (SAI_QUEUE_TYPE_ALL, attr[1].value.s32);
+
+    /* Tear down, leaves first */
+    queue_profile_set (children[0], SAI_NULL_OBJECT_ID);
+    EXPECT_NE (SAI_STATUS_SUCCESS,
+               p_scheduler_group_api->remove_child_object_from_group (root_id, 1, &children[0]));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_scheduler_group_api->remove_child_object_from_group (group_id, 2, children));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_scheduler_group_api->remove_child_object_from_group (root_id, 1, &group_id));
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_scheduler_api->remove_scheduler_profile (scheduler_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_scheduler_group_api->remove_scheduler_group (group_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_scheduler_api->remove_scheduler_profile (scheduler_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_scheduler_group_api->remove_scheduler_group (root_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_scheduler_group_api->remove_scheduler_group (other_id));
+}
+
+/*
+ * On a port without groups a strict queue drains before the others, which
+ * share what is left.
+ */
+TEST_F (saiStubSchedulerTest, strict_priority)
+{
+    sai_object_id_t scheduler_id, queue0_id, queue7_id;
+    uint32_t        count;
+
+    scheduler_id = profile_create (SAI_SCHEDULING_STRICT, 1, 0);
+    queue0_id    = queue_oid (8, 0);
+    queue7_id    = queue_oid (8, 7);
+    queue_profile_set (queue7_id, scheduler_id);
+
+    enqueue (8, 0, 100, 1000);
+    enqueue (8, 7, 100, 1000);
+    EXPECT_EQ (100000u, queue_stat (queue7_id, SAI_QUEUE_STAT_CURR_OCCUPANCY_BYTES));
+
+    /* 800 ns a frame at 10 Gbps */
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_transmit (port_oid (8), 50 * 800, LINE_RATE, &count));
+    EXPECT_EQ (50u, count);
+    EXPECT_EQ (50u, queue_stat (queue7_id, SAI_QUEUE_STAT_PACKETS));
+    EXPECT_EQ (0u, queue_stat (queue0_id, SAI_QUEUE_STAT_PACKETS));
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_transmit (port_oid (8), 100 * 800, LINE_RATE, &count));
+    EXPECT_EQ (100u, count);
+    EXPECT_EQ (100u, queue_stat (queue7_id, SAI_QUEUE_STAT_PACKETS));
+    EXPECT_EQ (100000u, queue_stat (queue7_id, SAI_QUEUE_STAT_GREEN_BYTES));
+    EXPECT_EQ (50u, queue_stat (queue0_id, SAI_QUEUE_STAT_PACKETS));
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_transmit (port_oid (8), 1000000, LINE_RATE, &count));
+    EXPECT_EQ (50u, count);
+    EXPECT_EQ (0u, queue_stat (queue0_id, SAI_QUEUE_STAT_CURR_OCCUPANCY_BYTES));
+
+    queue_profile_set (queue7_id, SAI_NULL_OBJECT_ID);
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_scheduler_api->remove_scheduler_profile (scheduler_id));
+}
+
+/*
+ * Under a level 0 group, congested DWRR queues share the line by their
+ * weights and queues outside the tree wait.
+ */
+TEST_F (saiStubSchedulerTest, dwrr_shares)
+{
+    const uint8_t   weights[3] = { 1, 2, 5 };
+    sai_object_id_t root_id, schedulers[3], queues[3];
+    uint64_t        sent[3];
+    uint32_t        ii, count;
+
+    root_id = group_create (9, 0, 8);
+    for (ii = 0; ii < 3; ii++) {
+        schedulers[ii] = profile_create (SAI_SCHEDULING_DWRR, weights[ii], 0);
+        queues[ii]     = queue_oid (9, ii);
+        queue_profile_set (queues[ii], schedulers[ii]);
+        enqueue (9, ii, 1000, 1500);
+    }
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_scheduler_group_api->add_child_object_to_group (root_id, 3, queues));
+    enqueue (9, 3, 10, 1500);
+
+    /* 1200 ns a frame at 10 Gbps */
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_transmit (port_oid (9), 800 * 1200, LINE_RATE, &count));
+    EXPECT_EQ (800u, count);
+
+    for (ii = 0; ii < 3; ii++) {
+        sent[ii] = queue_stat (queues[ii], SAI_QUEUE_STAT_PACKETS);
+        EXPECT_NEAR (100.0 * weights[ii], (double)sent[ii], 3.0) << "queue " << ii;
+    }
+    EXPECT_EQ (0u, queue_stat (queue_oid (9, 3), SAI_QUEUE_STAT_PACKETS));
+    EXPECT_EQ (15000u, queue_stat (queue_oid (9, 3), SAI_QUEUE_STAT_CURR_OCCUPANCY_BYTES));
+
+    /* Without the root the port serves every queue again */
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_scheduler_group_api->remove_child_object_from_group (root_id, 3, queues));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_scheduler_group_api->remove_scheduler_group (root_id));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_transmit (port_oid (9), 10000000, LINE_RATE, &count));
+    EXPECT_EQ (2200u + 10u, count);
+
+    for (ii = 0; ii < 3; ii++) {
+        queue_profile_set (queues[ii], SAI_NULL_OBJECT_ID);
+        EXPECT_EQ (SAI_STATUS_SUCCESS, p_scheduler_api->remove_scheduler_profile (schedulers[ii]));
+    }
+}
+
+/*
+ * A queue shaper holds a queue to its rate and burst while the others take
+ * the line, a port shaper holds the port.
+ */
+TEST_F (saiStubSchedulerTest, shaping)
+{
+    sai_object_id_t scheduler_id, queue1_id, queue2_id;
+    sai_attribute_t attr;
+    uint32_t        count, sent_frames;
+    uint64_t        sent;
+
+    /* 1 MB/s, a burst of one largest frame */
+    scheduler_id = profile_create (SAI_SCHEDULING_WRR, 1, 1000000);
+    queue1_id    = queue_oid (10, 1);
+    queue2_id    = queue_oid (10, 2);
+    queue_profile_set (queue2_id, scheduler_id);
+
+    enqueue (10, 1, 200, 1000);
+    enqueue (10, 2, 200, 1000);
+
+    /* 10 ms, 10000 bytes earned on top of the burst */
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_transmit (port_oid (10), 10000000, LINE_RATE, &count));
+    EXPECT_EQ (200u, queue_stat (queue1_id, SAI_QUEUE_STAT_PACKETS));
+    sent = queue_stat (queue2_id, SAI_QUEUE_STAT_BYTES);
+    EXPECT_GE (sent, 18000u);
+    EXPECT_LE (sent, 9216u + 10000u + 1000u);
+
+    /* The port shaper, on another port */
+    attr.id        = SAI_PORT_ATTR_QOS_SCHEDULER_PROFILE_ID;
+    attr.value.oid = scheduler_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->set_port_attribute (port_oid (11), &attr));
+    attr.value.oid = SAI_NULL_OBJECT_ID;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->get_port_attribute (port_oid (11), 1, &attr));
+    EXPECT_EQ (scheduler_id, attr.value.oid);
+
+    enqueue (11, 0, 100, 1000);
+    enqueue (11, 5, 100, 1000);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_transmit (port_oid (11), 10000000, LINE_RATE, &sent_frames));
+    EXPECT_GE (sent_frames, 18u);
+    EXPECT_LE (sent_frames, 20u);
+
+    /* A faster shaper takes effect at once, 100 MB/s drains the rest */
+    attr.id        = SAI_SCHEDULER_ATTR_MAX_BANDWIDTH_RATE;
+    attr.value.u64 = 100000000;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_scheduler_api->set_scheduler_attribute (scheduler_id, &attr));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_transmit (port_oid (11), 10000000, LINE_RATE, &count));
+    EXPECT_EQ (200u - sent_frames, count);
+
+    attr.id        = SAI_PORT_ATTR_QOS_SCHEDULER_PROFILE_ID;
+    attr.value.oid = SAI_NULL_OBJECT_ID;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_port_api->set_port_attribute (port_oid (11), &attr));
+    queue_profile_set (queue2_id, SAI_NULL_OBJECT_ID);
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_scheduler_api->remove_scheduler_profile (scheduler_id));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_transmit (port_oid (10), 10000000, LINE_RATE, &count));
+}
+
+/*
+ * A full queue drops at its tail, by color. The watermark keeps the
+ * highest occupancy until cleared.
+ */
+TEST_F (saiStubSchedulerTest, tail_drop)
+{
+    stub_packet_t            packets[STUB_DATAPLANE_BURST];
+    sai_queue_stat_counter_t counters[3];
+    sai_object_id_t          queue_id;
+    uint64_t                 values[3], dropped[3] = { 0, 0, 0 };
+    uint32_t                 ii, jj, count;
+
+    queue_id = queue_oid (12, 3);
+
+    /* 1100 frames of 100 bytes, colors in turn */
+    for (ii = 0; ii < 1100; ii += STUB_DATAPLANE_BURST) {
+        count = (1100 - ii < STUB_DATAPLANE_BURST) ? 1100 - ii : STUB_DATAPLANE_BURST;
+        memset (packets, 0, sizeof (packets));
+        for (jj = 0; jj < count; jj++) {
+            packets[jj].length        = 100;
+            packets[jj].out_port      = port_oid (12);
+            packets[jj].packet_action = SAI_PACKET_ACTION_FORWARD;
+            packets[jj].queue         = 3;
+            packets[jj].color         = (ii + jj) % 3;
+            if (ii + jj >= STUB_SCHEDULER_QUEUE_FRAMES) {
+                dropped[(ii + jj) % 3]++;
+            }
+        }
+        ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_enqueue (count, packets));
+    }
+
+    EXPECT_EQ (1100u - STUB_SCHEDULER_QUEUE_FRAMES, queue_stat (queue_id, SAI_QUEUE_STAT_DROPPED_PACKETS));
+    EXPECT_EQ (100u * (1100u - STUB_SCHEDULER_QUEUE_FRAMES), queue_stat (queue_id, SAI_QUEUE_STAT_DROPPED_BYTES));
+    EXPECT_EQ (dropped[0], queue_stat (queue_id, SAI_QUEUE_STAT_GREEN_DROPPED_PACKETS));
+    EXPECT_EQ (dropped[1], queue_stat (queue_id, SAI_QUEUE_STAT_YELLOW_DROPPED_PACKETS));
+    EXPECT_EQ (dropped[2], queue_stat (queue_id, SAI_QUEUE_STAT_RED_DROPPED_PACKETS));
+
+    counters[0] = SAI_QUEUE_STAT_PACKETS;
+    counters[1] = SAI_QUEUE_STAT_CURR_OCCUPANCY_BYTES;
+    counters[2] = SAI_QUEUE_STAT_WATERMARK_BYTES;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_queue_api->get_queue_stats (queue_id, counters, 3, values));
+    EXPECT_EQ (0u, values[0]);
+    EXPECT_EQ (100u * STUB_SCHEDULER_QUEUE_FRAMES, values[1]);
+    EXPECT_EQ (100u * STUB_SCHEDULER_QUEUE_FRAMES, values[2]);
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_transmit (port_oid (12), 1000000, LINE_RATE, &count));
+    EXPECT_EQ ((uint32_t)STUB_SCHEDULER_QUEUE_FRAMES, count);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_queue_api->get_queue_stats (queue_id, counters, 3, values));
+    EXPECT_EQ ((uint64_t)STUB_SCHEDULER_QUEUE_FRAMES, values[0]);
+    EXPECT_EQ (0u, values[1]);
+    EXPECT_EQ (100u * STUB_SCHEDULER_QUEUE_FRAMES, values[2]);
+    EXPECT_EQ ((STUB_SCHEDULER_QUEUE_FRAMES + 2u) / 3u, queue_stat (queue_id, SAI_QUEUE_STAT_GREEN_PACKETS));
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_queue_api->clear_queue_stats (queue_id, counters, 3));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_queue_api->get_queue_stats (queue_id, counters, 3, values));
+    EXPECT_EQ (0u, values[0]);
+    EXPECT_EQ (0u, values[2]);
+
+    counters[0] = (sai_queue_stat_counter_t)(SAI_QUEUE_STAT_WATERMARK_BYTES + 1);
+    EXPECT_EQ (SAI_STATUS_INVALID_PARAMETER, p_queue_api->get_queue_stats (queue_id, counters, 1, values));
+}
+
+/*
+ * Frames the data plane floods reach queue 0 of every port but the
+ * ingress one. Reports the rate of enqueueing and scheduling bursts.
+ */
+TEST_F (saiStubSchedulerTest, scheduler_rate)
+{
+    frame_t         frames[STUB_DATAPLANE_BURST];
+    stub_packet_t   packets[STUB_DATAPLANE_BURST];
+    sai_object_id_t queue_id;
+    uint64_t        before;
+    uint32_t        ii, jj, count, sent = 0;
+
+    before = queue_stat (queue_oid (14, 0), SAI_QUEUE_STAT_CURR_OCCUPANCY_BYTES);
+
+    memset (frames, 0, sizeof (frames));
+    for (ii = 0; ii < STUB_DATAPLANE_BURST; ii++) {
+        uint8_t *eth = frames[ii].buffer + STUB_DATAPLANE_HEADROOM;
+
+        memset (eth, 0x02, 6);
+        eth[6]  = 0x02;
+        eth[11] = 0x77;
+        eth[12] = 0x88;
+        eth[13] = 0xB5;
+        frames[ii].packet.data     = eth;
+        frames[ii].packet.length   = 64;
+        frames[ii].packet.headroom = STUB_DATAPLANE_HEADROOM;
+        frames[ii].packet.in_port  = port_oid (13);
+        packets[ii]                = frames[ii].packet;
+    }
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, packets));
+    ASSERT_EQ (SAI_NULL_OBJECT_ID, packets[0].out_port);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_enqueue (1, packets));
+    EXPECT_EQ (before + 64, queue_stat (queue_oid (14, 0), SAI_QUEUE_STAT_CURR_OCCUPANCY_BYTES));
+    EXPECT_EQ (0u, queue_stat (queue_oid (13, 0), SAI_QUEUE_STAT_CURR_OCCUPANCY_BYTES));
+    for (ii = 0; ii < 32; ii++) {
+        ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_transmit (port_oid (ii), 1000000000, LINE_RATE, &count));
+    }
+
+    /* Bursts of 64 byte frames over 8 queues, drained at 100 Gbps */
+    memset (packets, 0, sizeof (packets));
+    for (ii = 0; ii < STUB_DATAPLANE_BURST; ii++) {
+        packets[ii].length        = 64;
+        packets[ii].out_port      = port_oid (20);
+        packets[ii].packet_action = SAI_PACKET_ACTION_FORWARD;
+        packets[ii].queue         = ii % 8;
+    }
+
+    auto start = std::chrono::steady_clock::now ();
+    for (jj = 0; jj < 100000; jj++) {
+        stub_scheduler_enqueue (STUB_DATAPLANE_BURST, packets);
+        stub_scheduler_transmit (port_oid (20), 200, 10 * LINE_RATE, &count);
+        sent += count;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now () - start;
+    printf ("scheduler: %.1f Mpps\n", sent / elapsed.count () / 1e6);
+
+    queue_id = queue_oid (20, 7);
+    EXPECT_EQ (0u, queue_stat (queue_id, SAI_QUEUE_STAT_DROPPED_PACKETS));
+    EXPECT_EQ (100000u * STUB_DATAPLANE_BURST, sent);
+}
@@ -0,0 +1,605 @@
+/************************************************************************
+*    Licensed under the Apache License, Version 2.0 (the "License"); you may
+*    not use this file except in compliance with the License. You may obtain
+*    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+*
+*    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+*    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+*    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+*    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+*
+*    See the Apache Version 2.0 License for specific language governing
+*    permissions and limitations under the License.
+*
+*
+* Module Name:
+*
+*    sai_stub_trap_unit_test.cpp
+*
+* Abstract:
+*
+*    This file contains tests for the stub host interface traps. Control
+*    frames are run through the stub software data plane and the trap
+*    actions, the trap group admin state and policer are checked.
+*
+*************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/sai_stub_unit_test_utils.h"
+
+extern "C" {
+#include "sai.h"
+#include "saitypes.h"
+#include "saistatus.h"
+#include "saiswitch.h"
+#include "sairouter.h"
+#include "sairouterintf.h"
+#include "sairoute.h"
+#include "saihostintf.h"
+#include "saipolicer.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_hostif.h"
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+}
+
+/* Frames handed to the packet notification, by trap id */
+static uint32_t trap_events;
+static int32_t  trap_event_id;
+
+static void trap_test_packet_event (const void *buffer, sai_size_t buffer_size,
+                                    uint32_t attr_count, const sai_attribute_t *attr_list)
+{
+    for (uint32_t i = 0; i < attr_count; i++) {
+        if (SAI_HOSTIF_PACKET_TRAP_ID == attr_list[i].id) {
+            trap_event_id = attr_list[i].value.s32;
+        }
+    }
+    trap_events++;
+}
+
+class saiStubTrapTest : public saiStubTest
+{
+    protected:
+        static void SetUpTestCase (void);
+
+        struct frame_t {
+            uint8_t       buffer[STUB_DATAPLANE_HEADROOM + 128];
+            stub_packet_t packet;
+        };
+
+        static void build_lacp (frame_t *frame, sai_object_id_t in_port);
+        static void build_lldp (frame_t *frame, sai_object_id_t in_port);
+        static void build_tcp (frame_t *frame, sai_object_id_t in_port, uint32_t host_order_dst,
+                               uint16_t dst_port);
+        static void trap_action_set (sai_hostif_trap_id_t trap_id, sai_packet_action_t action);
+        static void trap_channel_set (sai_hostif_trap_id_t trap_id, sai_hostif_trap_channel_t channel);
+        static uint32_t trap_burst (sai_object_id_t in_port);
+        static sai_object_id_t policer_create (uint64_t cir, uint64_t cbs);
+
+        static sai_hostif_api_t           *p_hostif_api;
+        static sai_virtual_router_api_t   *p_vr_api;
+        static sai_router_interface_api_t *p_rif_api;
+        static sai_route_api_t            *p_route_api;
+        static sai_policer_api_t          *p_policer_api;
+
+        static sai_object_id_t vr_id;
+        static sai_object_id_t rif_id;
+};
+
+sai_hostif_api_t* saiStubTrapTest::p_hostif_api = NULL;
+sai_virtual_router_api_t* saiStubTrapTest::p_vr_api = NULL;
+sai_router_interface_api_t* saiStubTrapTest::p_rif_api = NULL;
+sai_route_api_t* saiStubTrapTest::p_route_api = NULL;
+sai_policer_api_t* saiStubTrapTest::p_policer_api = NULL;
+sai_object_id_t saiStubTrapTest::vr_id = 0;
+sai_object_id_t saiStubTrapTest::rif_id = 0;
+
+static void frame_init (uint8_t *eth, stub_packet_t *packet, uint32_t length,
+                        sai_object_id_t in_port)
+{
+    memset (packet, 0, sizeof (*packet));
+    packet->data     = eth;
+    packet->length   = length;
+    packet->headroom = STUB_DATAPLANE_HEADROOM;
+    packet->in_port  = in_port;
+}
+
+/* LACPDU to the slow protocols address */
+void saiStubTrapTest::build_lacp (frame_t *frame, sai_object_id_t in_port)
+{
+    static const uint8_t dst[] = { 0x01, 0x80, 0xC2, 0x00, 0x00, 0x02 };
+    uint8_t *eth = frame->buffer + STUB_DATAPLANE_HEADROOM;
+
+    memset (frame->buffer, 0, sizeof (frame->buffer));
+    memcpy (eth, dst, sizeof (dst));
+    eth[6]  = 0x02;
+    eth[11] = 0x99;
+    eth[12] = 0x88;
+    eth[13] = 0x09;
+    eth[14] = 0x01;
+    frame_init (eth, &frame->packet, 64, in_port);
+}
+
+/* LLDPDU to the nearest bridge address */
+void saiStubTrapTest::build_lldp (frame_t *frame, sai_object_id_t in_port)
+{
+    static const uint8_t dst[] = { 0x01, 0x80, 0xC2, 0x00, 0x00, 0x0E };
+    uint8_t *eth = frame->buffer + STUB_DATAPLANE_HEADROOM;
+
+    memset (frame->buffer, 0, sizeof (frame->buffer));
+    memcpy (eth, dst, sizeof (dst));
+    eth[6]  = 0x02;
+    eth[11] = 0x99;
+    eth[12] = 0x88;
+    eth[13] = 0xCC;
+    frame_init (eth, &frame->packet, 64, in_port);
+}
+
+/* TCP over IPv4 to the router MAC ..:01 */
+void saiStubTrapTest::build_tcp (frame_t *frame, sai_object_id_t in_port, uint32_t host_order_dst,
+                                 uint16_t dst_port)
+{
+    uint8_t  *eth = frame->buffer + STUB_DATAPLANE_HEADROOM;
+    uint8_t  *ip = eth + 14;
+    uint32_t  src = htonl (0x0A000002), dst = htonl (host_order_dst);
+
+    memset (frame->buffer, 0, sizeof (frame->buffer));
+    eth[5]  = 0x01;
+    eth[6]  = 0x02;
+    eth[11] = 0x99;
+    eth[12] = 0x08;
+
+    ip[0]  = 0x45;
+    ip[3]  = 40;
+    ip[8]  = 64;
+    ip[9]  = 6;
+    memcpy (ip + 12, &src, 4);
+    memcpy (ip + 16, &dst, 4);
+    ip[20] = 0xC3;
+    ip[21] = 0x50;
+    ip[22] = (uint8_t) (dst_port >> 8);
+    ip[23] = (uint8_t) dst_port;
+    frame_init (eth, &frame->packet, 54, in_port);
+}
+
+void saiStubTrapTest::trap_action_set (sai_hostif_trap_id_t trap_id, sai_packet_action_t action)
+{
+    sai_attribute_t attr;
+
+    attr.id        = SAI_HOSTIF_TRAP_ATTR_PACKET_ACTION;
+    attr.value.s32 = action;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (trap_id, &attr));
+}
+
+void saiStubTrapTest::trap_channel_set (sai_hostif_trap_id_t trap_id, sai_hostif_trap_channel_t channel)
+{
+    sai_attribute_t attr;
+
+    attr.id        = SAI_HOSTIF_TRAP_ATTR_TRAP_CHANNEL;
+    attr.value.s32 = channel;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (trap_id, &attr));
+}
+
+/* Three LLDP then three LACP frames through a pcap run, the path that
+ * hands trapped frames to the host. Returns the frames the packet
+ * notification got */
+uint32_t saiStubTrapTest::trap_burst (sai_object_id_t in_port)
+{
+    frame_t   frame;
+    char      in_path[] = "/tmp/sai_trap_in_XXXXXX";
+    uint32_t  file_header[6] = { 0xA1B2C3D4, 0x00040002, 0, 0, 65535, 1 };
+    uint32_t  record[4] = { 0, 0, 0, 0 };
+    FILE     *file;
+
+    close (mkstemp (in_path));
+    if (NULL == (file = fopen (in_path, "wb"))) {
+        ADD_FAILURE () << "Failed to open " << in_path;
+        return 0;
+    }
+    fwrite (file_header, sizeof (file_header), 1, file);
+    for (uint32_t i = 0; i < 6; i++) {
+        if (i < 3) {
+            build_lldp (&frame, in_port);
+        } else {
+            build_lacp (&frame, in_port);
+        }
+        record[2] = record[3] = frame.packet.length;
+        fwrite (record, sizeof (record), 1, file);
+        fwrite (frame.packet.data, frame.packet.length, 1, file);
+    }
+    fclose (file);
+
+    trap_events   = 0;
+    trap_event_id = 0;
+    EXPECT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_run_pcap (in_path, in_port, NULL));
+    unlink (in_path);
+
+    return trap_events;
+}
+
+/* Packet rate policer dropping what exceeds its burst */
+sai_object_id_t saiStubTrapTest::policer_create (uint64_t cir, uint64_t cbs)
+{
+    sai_object_id_t policer_id = SAI_NULL_OBJECT_ID;
+    sai_attribute_t attr[5];
+
+    attr[0].id        = SAI_POLICER_ATTR_METER_TYPE;
+    attr[0].value.s32 = SAI_METER_TYPE_PACKETS;
+    attr[1].id        = SAI_POLICER_ATTR_MODE;
+    attr[1].value.s32 = SAI_POLICER_MODE_STORM_CONTROL;
+    attr[2].id        = SAI_POLICER_ATTR_CIR;
+    attr[2].value.u64 = cir;
+    attr[3].id        = SAI_POLICER_ATTR_CBS;
+    attr[3].value.u64 = cbs;
+    attr[4].id        = SAI_POLICER_ATTR_RED_PACKET_ACTION;
+    attr[4].value.s32 = SAI_PACKET_ACTION_DROP;
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_policer_api->create_policer (&policer_id, 5, attr));
+
+    return policer_id;
+}
+
+/*
+ * Topology:
+ *   port rif (port 1, mac ..:01) 10.0.0.0/24, router address 10.0.0.1
+ */
+void saiStubTrapTest::SetUpTestCase (void)
+{
+    sai_switch_notification_t notification;
+    sai_unicast_route_entry_t route;
+    sai_attribute_t           attr[4];
+
+    memset (&notification, 0, sizeof (notification));
+    notification.on_packet_event = trap_test_packet_event;
+
+    /* Host interfaces without kernel interfaces */
+    profile_value_set (STUB_HOSTIF_NETDEV_PROFILE_KEY, "none");
+
+    SetUpStubSwitch (&notification);
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_HOST_INTERFACE, (void **)&p_hostif_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_VIRTUAL_ROUTER, (void **)&p_vr_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_ROUTER_INTERFACE, (void **)&p_rif_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_ROUTE, (void **)&p_route_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_POLICER, (void **)&p_policer_api));
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_vr_api->create_virtual_router (&vr_id, 0, NULL));
+
+    memset (attr, 0, sizeof (attr));
+    attr[0].id        = SAI_ROUTER_INTERFACE_ATTR_VIRTUAL_ROUTER_ID;
+    attr[0].value.oid = vr_id;
+    attr[1].id        = SAI_ROUTER_INTERFACE_ATTR_TYPE;
+    attr[1].value.s32 = SAI_ROUTER_INTERFACE_TYPE_PORT;
+    attr[2].id        = SAI_ROUTER_INTERFACE_ATTR_PORT_ID;
+    attr[2].value.oid = port_oid (1);
+    attr[3].id        = SAI_ROUTER_INTERFACE_ATTR_SRC_MAC_ADDRESS;
+    attr[3].value.mac[5] = 0x01;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_rif_api->create_router_interface (&rif_id, 4, attr));
+
+    /* IP2ME route of the router address */
+    memset (&route, 0, sizeof (route));
+    route.vr_id                   = vr_id;
+    route.destination.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+    route.destination.addr.ip4    = htonl (0x0A000001);
+    route.destination.mask.ip4    = 0xFFFFFFFF;
+    attr[0].id        = SAI_ROUTE_ATTR_PACKET_ACTION;
+    attr[0].value.s32 = SAI_PACKET_ACTION_TRAP;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_route_api->create_route (&route, 1, attr));
+}
+
+/*
+ * Trap groups are created, made the switch default and refuse removal
+ * while in use.
+ */
+TEST_F (saiStubTrapTest, trap_group_crud)
+{
+    sai_object_id_t group_id, default_id, policer_id;
+    sai_attribute_t attr[3];
+
+    policer_id = policer_create (100, 100);
+
+    attr[0].id = SAI_SWITCH_ATTR_DEFAULT_TRAP_GROUP;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->get_switch_attribute (1, attr));
+    default_id = attr[0].value.oid;
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_hostif_api->remove_hostif_trap_group (default_id));
+
+    /* Priority is mandatory */
+    attr[0].id        = SAI_HOSTIF_TRAP_GROUP_ATTR_QUEUE;
+    attr[0].value.u32 = 3;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_hostif_api->create_hostif_trap_group (&group_id, 1, attr));
+
+    attr[1].id        = SAI_HOSTIF_TRAP_GROUP_ATTR_PRIO;
+    attr[1].value.u32 = 7;
+    attr[2].id        = SAI_HOSTIF_TRAP_GROUP_ATTR_POLICER;
+    attr[2].value.oid = policer_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->create_hostif_trap_group (&group_id, 3, attr));
+
+    attr[0].id = SAI_HOSTIF_TRAP_GROUP_ATTR_QUEUE;
+    attr[1].id = SAI_HOSTIF_TRAP_GROUP_ATTR_ADMIN_STATE;
+    attr[2].id = SAI_HOSTIF_TRAP_GROUP_ATTR_POLICER;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->get_trap_group_attribute (group_id, 3, attr));
+    EXPECT_EQ (3u, attr[0].value.u32);
+    EXPECT_TRUE (attr[1].value.booldata);
+    EXPECT_EQ (policer_id, attr[2].value.oid);
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_policer_api->remove_policer (policer_id));
+
+    attr[0].id        = SAI_SWITCH_ATTR_DEFAULT_TRAP_GROUP;
+    attr[0].value.oid = group_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (attr));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->get_switch_attribute (1, attr));
+    EXPECT_EQ (group_id, attr[0].value.oid);
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_hostif_api->remove_hostif_trap_group (group_id));
+
+    attr[0].value.oid = default_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (attr));
+
+    /* A trap set to the group holds it */
+    attr[0].id        = SAI_HOSTIF_TRAP_ATTR_TRAP_GROUP;
+    attr[0].value.oid = group_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_OSPF, attr));
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_hostif_api->remove_hostif_trap_group (group_id));
+
+    attr[0].value.oid = SAI_NULL_OBJECT_ID;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_OSPF, attr));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->get_trap_attribute (SAI_HOSTIF_TRAP_ID_OSPF, 1, attr));
+    EXPECT_EQ (default_id, attr[0].value.oid);
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->remove_hostif_trap_group (group_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_policer_api->remove_policer (policer_id));
+}
+
+/*
+ * Link local frames are dropped by default, trapped once their trap says
+ * so and only on the ports of the trap port list.
+ */
+TEST_F (saiStubTrapTest, switch_trap_action_and_ports)
+{
+    frame_t         frame;
+    sai_object_id_t ports[1] = { port_oid (3) };
+    sai_attribute_t attr;
+
+    attr.id = SAI_HOSTIF_TRAP_ATTR_PACKET_ACTION;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->get_trap_attribute (SAI_HOSTIF_TRAP_ID_LACP, 1, &attr));
+    EXPECT_EQ (SAI_PACKET_ACTION_DROP, attr.value.s32);
+
+    build_lacp (&frame, port_oid (2));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, &frame.packet));
+    EXPECT_EQ (SAI_PACKET_ACTION_DROP, frame.packet.packet_action);
+
+    trap_action_set (SAI_HOSTIF_TRAP_ID_LACP, SAI_PACKET_ACTION_TRAP);
+    build_lacp (&frame, port_oid (2));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, &frame.packet));
+    EXPECT_EQ (SAI_PACKET_ACTION_TRAP, frame.packet.packet_action);
+    EXPECT_EQ (SAI_HOSTIF_TRAP_ID_LACP, frame.packet.trap_id);
+
+    attr.id                  = SAI_HOSTIF_TRAP_ATTR_PORT_LIST;
+    attr.value.objlist.count = 1;
+    attr.value.objlist.list  = ports;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LACP, &attr));
+    build_lacp (&frame, port_oid (2));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, &frame.packet));
+    EXPECT_EQ (SAI_PACKET_ACTION_DROP, frame.packet.packet_action);
+
+    attr.value.objlist.count = 0;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LACP, &attr));
+    trap_action_set (SAI_HOSTIF_TRAP_ID_LACP, SAI_PACKET_ACTION_DROP);
+
+    /* Unknown trap ids and actions are refused */
+    attr.id        = SAI_HOSTIF_TRAP_ATTR_PACKET_ACTION;
+    attr.value.s32 = SAI_PACKET_ACTION_TRANSIT;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LACP, &attr));
+    attr.value.s32 = SAI_PACKET_ACTION_TRAP;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_SAMPLEPACKET, &attr));
+}
+
+/*
+ * Frames trapped by an IP2ME route are named by protocol, the protocol
+ * trap can drop them.
+ */
+TEST_F (saiStubTrapTest, ip2me_protocol_trap)
+{
+    frame_t frame;
+
+    build_tcp (&frame, port_oid (1), 0x0A000001, 179);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, &frame.packet));
+    EXPECT_EQ (SAI_PACKET_ACTION_TRAP, frame.packet.packet_action);
+    EXPECT_EQ (0, frame.packet.trap_id);
+
+    trap_action_set (SAI_HOSTIF_TRAP_ID_BGP, SAI_PACKET_ACTION_TRAP);
+    build_tcp (&frame, port_oid (1), 0x0A000001, 179);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, &frame.packet));
+    EXPECT_EQ (SAI_PACKET_ACTION_TRAP, frame.packet.packet_action);
+    EXPECT_EQ (SAI_HOSTIF_TRAP_ID_BGP, frame.packet.trap_id);
+
+    /* Other TCP to the router is still trapped by the route */
+    build_tcp (&frame, port_oid (1), 0x0A000001, 22);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, &frame.packet));
+    EXPECT_EQ (SAI_PACKET_ACTION_TRAP, frame.packet.packet_action);
+    EXPECT_EQ (0, frame.packet.trap_id);
+
+    trap_action_set (SAI_HOSTIF_TRAP_ID_BGP, SAI_PACKET_ACTION_DROP);
+    build_tcp (&frame, port_oid (1), 0x0A000001, 179);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (1, &frame.packet));
+    EXPECT_EQ (SAI_PACKET_ACTION_DROP, frame.packet.packet_action);
+
+    trap_action_set (SAI_HOSTIF_TRAP_ID_BGP, SAI_PACKET_ACTION_FORWARD);
+}
+
+/*
+ * A trap group passes what its policer lets through and polices the rest
+ * of a burst, without a policer it passes everything.
+ */
+TEST_F (saiStubTrapTest, trap_group_policing)
+{
+    frame_t                        frame[10];
+    stub_packet_t                  packets[10];
+    stub_hostif_trap_group_stats_t stats;
+    sai_object_id_t                group_id, policer_id;
+    sai_attribute_t                attr[2];
+    uint32_t                       trapped = 0, dropped = 0;
+
+    policer_id = policer_create (1, 4);
+
+    attr[0].id        = SAI_HOSTIF_TRAP_GROUP_ATTR_PRIO;
+    attr[0].value.u32 = 1;
+    attr[1].id        = SAI_HOSTIF_TRAP_GROUP_ATTR_POLICER;
+    attr[1].value.oid = policer_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->create_hostif_trap_group (&group_id, 2, attr));
+
+    attr[0].id        = SAI_HOSTIF_TRAP_ATTR_TRAP_GROUP;
+    attr[0].value.oid = group_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LLDP, attr));
+    trap_action_set (SAI_HOSTIF_TRAP_ID_LLDP, SAI_PACKET_ACTION_TRAP);
+
+    for (uint32_t i = 0; i < 10; i++) {
+        build_lldp (&frame[i], port_oid (2));
+        packets[i] = frame[i].packet;
+    }
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (10, packets));
+
+    for (uint32_t i = 0; i < 10; i++) {
+        trapped += (SAI_PACKET_ACTION_TRAP == packets[i].packet_action);
+        dropped += (SAI_PACKET_ACTION_DROP == packets[i].packet_action);
+    }
+    EXPECT_EQ (4u, trapped);
+    EXPECT_EQ (6u, dropped);
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_host_interface_get_trap_group_stats (group_id, &stats));
+    EXPECT_EQ (4u, stats.passed);
+    EXPECT_EQ (6u, stats.policed);
+
+    /* Unpoliced, the whole burst reaches the host */
+    attr[1].value.oid = SAI_NULL_OBJECT_ID;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_group_attribute (group_id, &attr[1]));
+    for (uint32_t i = 0; i < 10; i++) {
+        build_lldp (&frame[i], port_oid (2));
+        packets[i] = frame[i].packet;
+    }
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (10, packets));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_host_interface_get_trap_group_stats (group_id, &stats));
+    EXPECT_EQ (14u, stats.passed);
+    EXPECT_EQ (6u, stats.policed);
+
+    trap_action_set (SAI_HOSTIF_TRAP_ID_LLDP, SAI_PACKET_ACTION_DROP);
+    attr[0].value.oid = SAI_NULL_OBJECT_ID;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LLDP, attr));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->remove_hostif_trap_group (group_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_policer_api->remove_policer (policer_id));
+}
+
+/*
+ * A disabled trap group keeps a whole burst from the host, an enabled
+ * one passes it.
+ */
+TEST_F (saiStubTrapTest, trap_group_admin_state)
+{
+    frame_t                        frame[10];
+    stub_packet_t                  packets[10];
+    stub_hostif_trap_group_stats_t stats;
+    sai_object_id_t                group_id;
+    sai_attribute_t                attr[2];
+    uint32_t                       trapped = 0, dropped = 0;
+
+    attr[0].id             = SAI_HOSTIF_TRAP_GROUP_ATTR_PRIO;
+    attr[0].value.u32      = 1;
+    attr[1].id             = SAI_HOSTIF_TRAP_GROUP_ATTR_ADMIN_STATE;
+    attr[1].value.booldata = false;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->create_hostif_trap_group (&group_id, 2, attr));
+
+    attr[0].id        = SAI_HOSTIF_TRAP_ATTR_TRAP_GROUP;
+    attr[0].value.oid = group_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LLDP, attr));
+    trap_action_set (SAI_HOSTIF_TRAP_ID_LLDP, SAI_PACKET_ACTION_TRAP);
+
+    for (uint32_t i = 0; i < 10; i++) {
+        build_lldp (&frame[i], port_oid (2));
+        packets[i] = frame[i].packet;
+    }
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (10, packets));
+
+    for (uint32_t i = 0; i < 10; i++) {
+        trapped += (SAI_PACKET_ACTION_TRAP == packets[i].packet_action);
+        dropped += (SAI_PACKET_ACTION_DROP == packets[i].packet_action);
+    }
+    EXPECT_EQ (0u, trapped);
+    EXPECT_EQ (10u, dropped);
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_host_interface_get_trap_group_stats (group_id, &stats));
+    EXPECT_EQ (0u, stats.passed);
+    EXPECT_EQ (10u, stats.policed);
+
+    attr[1].value.booldata = true;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_group_attribute (group_id, &attr[1]));
+    for (uint32_t i = 0; i < 10; i++) {
+        build_lldp (&frame[i], port_oid (2));
+        packets[i] = frame[i].packet;
+    }
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_dataplane_process_burst (10, packets));
+    for (uint32_t i = 0; i < 10; i++) {
+        EXPECT_EQ (SAI_PACKET_ACTION_TRAP, packets[i].packet_action);
+    }
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_host_interface_get_trap_group_stats (group_id, &stats));
+    EXPECT_EQ (10u, stats.passed);
+    EXPECT_EQ (10u, stats.policed);
+
+    trap_action_set (SAI_HOSTIF_TRAP_ID_LLDP, SAI_PACKET_ACTION_DROP);
+    attr[0].value.oid = SAI_NULL_OBJECT_ID;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LLDP, attr));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->remove_hostif_trap_group (group_id));
+}
+
+/*
+ * Only frames of callback channel traps reach the packet notification.
+ * Netdev channel frames go to the host interface of their ingress port
+ * and fd channel frames to the host interface of the trap, or are dropped
+ * without one.
+ */
+TEST_F (saiStubTrapTest, trap_channels)
+{
+    sai_object_id_t hif_id;
+    sai_attribute_t attr[3];
+
+    trap_action_set (SAI_HOSTIF_TRAP_ID_LLDP, SAI_PACKET_ACTION_TRAP);
+    trap_action_set (SAI_HOSTIF_TRAP_ID_LACP, SAI_PACKET_ACTION_TRAP);
+
+    EXPECT_EQ (6u, trap_burst (port_oid (2)));
+
+    /* No host interface on the port */
+    trap_channel_set (SAI_HOSTIF_TRAP_ID_LLDP, SAI_HOSTIF_TRAP_CHANNEL_NETDEV);
+    EXPECT_EQ (3u, trap_burst (port_oid (2)));
+    EXPECT_EQ (SAI_HOSTIF_TRAP_ID_LACP, trap_event_id);
+
+    trap_channel_set (SAI_HOSTIF_TRAP_ID_LACP, SAI_HOSTIF_TRAP_CHANNEL_NETDEV);
+    EXPECT_EQ (0u, trap_burst (port_oid (2)));
+
+    attr[0].id        = SAI_HOSTIF_ATTR_TYPE;
+    attr[0].value.s32 = SAI_HOSTIF_TYPE_NETDEV;
+    attr[1].id        = SAI_HOSTIF_ATTR_RIF_OR_PORT_ID;
+    attr[1].value.oid = port_oid (2);
+    attr[2].id        = SAI_HOSTIF_ATTR_NAME;
+    memset (attr[2].value.chardata, 0, sizeof (attr[2].value.chardata));
+    strcpy (attr[2].value.chardata, "sut_trap0");
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->create_hostif (&hif_id, 3, attr));
+    EXPECT_EQ (0u, trap_burst (port_oid (2)));
+
+    /* The fd channel needs its host interface first */
+    attr[0].id        = SAI_HOSTIF_TRAP_ATTR_TRAP_CHANNEL;
+    attr[0].value.s32 = SAI_HOSTIF_TRAP_CHANNEL_FD;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LLDP, attr));
+    attr[0].id        = SAI_HOSTIF_TRAP_ATTR_FD;
+    attr[0].value.oid = hif_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LLDP, attr));
+    trap_channel_set (SAI_HOSTIF_TRAP_ID_LLDP, SAI_HOSTIF_TRAP_CHANNEL_FD);
+    trap_channel_set (SAI_HOSTIF_TRAP_ID_LACP, SAI_HOSTIF_TRAP_CHANNEL_CB);
+    EXPECT_EQ (3u, trap_burst (port_oid (3)));
+    EXPECT_EQ (SAI_HOSTIF_TRAP_ID_LACP, trap_event_id);
+
+    trap_channel_set (SAI_HOSTIF_TRAP_ID_LLDP, SAI_HOSTIF_TRAP_CHANNEL_CB);
+    attr[0].value.oid = SAI_NULL_OBJECT_ID;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->set_trap_attribute (SAI_HOSTIF_TRAP_ID_LLDP, attr));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_hostif_api->remove_hostif (hif_id));
+    trap_action_set (SAI_HOSTIF_TRAP_ID_LLDP, SAI_PACKET_ACTION_DROP);
+    trap_action_set (SAI_HOSTIF_TRAP_ID_LACP, SAI_PACKET_ACTION_DROP);
+}
@@ -0,0 +1,579 @@
+/************************************************************************
+*    Licensed under the Apache License, Version 2.0 (the "License"); you may
+*    not use this file except in compliance with the License. You may obtain
+*    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+*
+*    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+*    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+*    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+*    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+*
+*    See the Apache Version 2.0 License for specific language governing
+*    permissions and limitations under the License.
+*
+*
+* Module Name:
+*
+*    sai_stub_udf_unit_test.cpp
+*
+* Abstract:
+*
+*    This file contains tests for the stub user defined fields. UDF groups,
+*    matches and UDFs are validated, their bytes are extracted from UDP and
+*    GRE frames, added to hash keys and matched by ACL entries, and the
+*    extraction rate is reported.
+*
+*************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/sai_stub_unit_test_utils.h"
+
+extern "C" {
+#include "sai.h"
+#include "saitypes.h"
+#include "saistatus.h"
+#include "saiswitch.h"
+#include "saihash.h"
+#include "saiacl.h"
+#include "saiudf.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_hash.h"
+#include "stub_sai_acl.h"
+#include "stub_sai_udf.h"
+#include <arpa/inet.h>
+#include <string.h>
+#include <stdio.h>
+}
+
+#include <chrono>
+#include <vector>
+
+class saiStubUdfTest : public saiStubTest
+{
+    protected:
+        static void SetUpTestCase (void);
+
+        struct frame_t {
+            uint8_t       buffer[STUB_DATAPLANE_HEADROOM + 128];
+            stub_packet_t packet;
+        };
+
+        static void build_ip (frame_t *frame, uint8_t protocol, uint32_t host_order_src,
+                              uint16_t l4_word0, uint16_t l4_word1, uint32_t length);
+        static void build_gre (frame_t *frame, uint32_t host_order_inner_src);
+        static sai_object_id_t group_create (sai_udf_group_type_t type, uint16_t length);
+        static sai_object_id_t match_create (uint8_t l3_type, uint16_t gre_type, uint8_t priority);
+        static sai_object_id_t udf_create (sai_object_id_t match_id, sai_object_id_t group_id,
+                                           sai_udf_base_t base, uint16_t offset);
+
+        static sai_hash_api_t   *p_hash_api;
+        static sai_acl_api_t    *p_acl_api;
+        static sai_udf_api_t    *p_udf_api;
+};
+
+sai_hash_api_t* saiStubUdfTest::p_hash_api = NULL;
+sai_acl_api_t* saiStubUdfTest::p_acl_api = NULL;
+sai_udf_api_t* saiStubUdfTest::p_udf_api = NULL;
+
+static const int32_t udf_five_tuple[] = {
+    SAI_NATIVE_HASH_FIELD_SRC_IP, SAI_NATIVE_HASH_FIELD_DST_IP, SAI_NATIVE_HASH_FIELD_IP_PROTOCOL,
+    SAI_NATIVE_HASH_FIELD_L4_SRC_PORT, SAI_NATIVE_HASH_FIELD_L4_DST_PORT
+};
+
+/* IPv4 to 20.0.0.1 with the first two 16 bit words of the L4 header given,
+ * cut to length bytes */
+void saiStubUdfTest::build_ip (frame_t *frame, uint8_t protocol, uint32_t host_order_src,
+                               uint16_t l4_word0, uint16_t l4_word1, uint32_t length)
+{
+    uint8_t  *eth = frame->buffer + STUB_DATAPLANE_HEADROOM;
+    uint8_t  *ip = eth + 14;
+    uint32_t  src = htonl (host_order_src), dst = htonl (0x14000001);
+
+    memset (frame->buffer, 0, sizeof (frame->buffer));
+    eth[5]  = 0x01;
+    eth[6]  = 0x02;
+    eth[11] = 0x99;
+    eth[12] = 0x08;
+
+    ip[0]  = 0x45;
+    ip[3]  = (uint8_t) (length - 14);
+    ip[8]  = 64;
+    ip[9]  = protocol;
+    memcpy (ip + 12, &src, 4);
+    memcpy (ip + 16, &dst, 4);
+    ip[20] = (uint8_t) (l4_word0 >> 8);
+    ip[21] = (uint8_t) l4_word0;
+    ip[22] = (uint8_t) (l4_word1 >> 8);
+    ip[23] = (uint8_t) l4_word1;
+
+    memset (&frame->packet, 0, sizeof (frame->packet));
+    frame->packet.data     = eth;
+    frame->packet.length   = length;
+    frame->packet.headroom = STUB_DATAPLANE_HEADROOM;
+    frame->packet.in_port  = port_oid (1);
+}
+
+/* GRE without options carrying IPv4 from the inner source given */
+void saiStubUdfTest::build_gre (frame_t *frame, uint32_t host_order_inner_src)
+{
+    uint8_t  *inner;
+    uint32_t  src = htonl (host_order_inner_src);
+
+    build_ip (frame, 47, 0x0B000001, 0x0000, 0x0800, 14 + 20 + 4 + 20);
+    inner    = frame->packet.data + 14 + 20 + 4;
+    inner[0] = 0x45;
+    inner[9] = 17;
+    memcpy (inner + 12, &src, 4);
+}
+
+sai_object_id_t saiStubUdfTest::group_create (sai_udf_group_type_t type, uint16_t length)
+{
+    sai_object_id_t id = SAI_NULL_OBJECT_ID;
+    sai_attribute_t attr[2];
+
+    attr[0].id        = SAI_UDF_GROUP_ATTR_TYPE;
+    attr[0].value.s32 = type;
+    attr[1].id        = SAI_UDF_ATTR_LENGTH;
+    attr[1].value.u16 = length;
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->create_udf_group (&id, 2, attr));
+
+    return id;
+}
+
+/* Match on the IP protocol and GRE protocol type unless 0 */
+sai_object_id_t saiStubUdfTest::match_create (uint8_t l3_type, uint16_t gre_type, uint8_t priority)
+{
+    sai_object_id_t id = SAI_NULL_OBJECT_ID;
+    sai_attribute_t attr[3];
+    uint32_t        count = 0;
+
+    memset (attr, 0, sizeof (attr));
+    if (0 != l3_type) {
+        attr[count].id                       = SAI_UDF_MATCH_ATTR_L3_TYPE;
+        attr[count].value.aclfield.enable    = true;
+        attr[count].value.aclfield.data.u8   = l3_type;
+        attr[count].value.aclfield.mask.u8   = 0xFF;
+        count++;
+    }
+    if (0 != gre_type) {
+        attr[count].id                       = SAI_UDF_MATCH_ATTR_GRE_TYPE;
+        attr[count].value.aclfield.enable    = true;
+        attr[count].value.aclfield.data.u16  = gre_type;
+        attr[count].value.aclfield.mask.u16  = 0xFFFF;
+        count++;
+    }
+    attr[count].id       = SAI_UDF_MATCH_ATTR_PRIORITY;
+    attr[count].value.u8 = priority;
+    count++;
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->create_udf_match (&id, count, attr));
+
+    return id;
+}
+
+sai_object_id_t saiStubUdfTest::udf_create (sai_object_id_t match_id, sai_object_id_t group_id,
+                                            sai_udf_base_t base, uint16_t offset)
+{
+    sai_object_id_t id = SAI_NULL_OBJECT_ID;
+    sai_attribute_t attr[4];
+
+    attr[0].id        = SAI_UDF_ATTR_MATCH_ID;
+    attr[0].value.oid = match_id;
+    attr[1].id        = SAI_UDF_ATTR_GROUP_ID;
+    attr[1].value.oid = group_id;
+    attr[2].id        = SAI_UDF_ATTR_BASE;
+    attr[2].value.s32 = base;
+    attr[3].id        = SAI_UDF_ATTR_OFFSET;
+    attr[3].value.u16 = offset;
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->create_udf (&id, 4, attr));
+
+    return id;
+}
+
+void saiStubUdfTest::SetUpTestCase (void)
+{
+    SetUpStubSwitch ();
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_HASH, (void **)&p_hash_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_ACL, (void **)&p_acl_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_UDF, (void **)&p_udf_api));
+}
+
+/*
+ * Groups, matches and UDFs are validated on create, read back and refuse
+ * removal while in use.
+ */
+TEST_F (saiStubUdfTest, udf_crud)
+{
+    sai_object_id_t group_id, match_id, udf_id, other_id, list[4];
+    sai_attribute_t attr[5];
+    uint8_t         mask[3] = { 0xFF, 0x00, 0xFF };
+
+    attr[0].id        = SAI_UDF_ATTR_LENGTH;
+    attr[0].value.u16 = 0;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_udf_api->create_udf_group (&group_id, 1, attr));
+    attr[0].value.u16 = STUB_UDF_GROUP_MAX_LENGTH + 1;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_udf_api->create_udf_group (&group_id, 1, attr));
+
+    group_id = group_create (SAI_UDF_GROUP_GENERIC, 2);
+    match_id = match_create (17, 0, 1);
+
+    /* A rule exists once, whatever its priority */
+    memset (attr, 0, sizeof (attr));
+    attr[0].id                     = SAI_UDF_MATCH_ATTR_L3_TYPE;
+    attr[0].value.aclfield.enable  = true;
+    attr[0].value.aclfield.data.u8 = 17;
+    attr[0].value.aclfield.mask.u8 = 0xFF;
+    attr[1].id                     = SAI_UDF_MATCH_ATTR_PRIORITY;
+    attr[1].value.u8               = 5;
+    EXPECT_EQ (SAI_STATUS_ITEM_ALREADY_EXISTS, p_udf_api->create_udf_match (&other_id, 2, attr));
+
+    udf_id = udf_create (match_id, group_id, SAI_UDF_BASE_L4, 2);
+
+    attr[0].id        = SAI_UDF_ATTR_MATCH_ID;
+    attr[0].value.oid = match_id;
+    attr[1].id        = SAI_UDF_ATTR_GROUP_ID;
+    attr[1].value.oid = group_id;
+    attr[2].id        = SAI_UDF_ATTR_OFFSET;
+    attr[2].value.u16 = 0;
+    EXPECT_EQ (SAI_STATUS_ITEM_ALREADY_EXISTS, p_udf_api->create_udf (&other_id, 3, attr));
+
+    /* The hash mask covers the group length exactly */
+    attr[3].id                  = SAI_UDF_ATTR_HASH_MASK;
+    attr[3].value.u8list.count  = 3;
+    attr[3].value.u8list.list   = mask;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf (udf_id));
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_udf_api->create_udf (&udf_id, 4, attr));
+    attr[3].value.u8list.count  = 2;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_udf_api->create_udf (&udf_id, 4, attr));
+
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_udf_api->remove_udf_match (match_id));
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_udf_api->remove_udf_group (group_id));
+
+    attr[0].id                  = SAI_UDF_GROUP_ATTR_UDF_LIST;
+    attr[0].value.objlist.count = 4;
+    attr[0].value.objlist.list  = list;
+    attr[1].id                  = SAI_UDF_ATTR_LENGTH;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_udf_api->get_udf_group_attribute (group_id, 2, attr));
+    ASSERT_EQ (1u, attr[0].value.objlist.count);
+    EXPECT_EQ (udf_id, list[0]);
+    EXPECT_EQ (2, attr[1].value.u16);
+
+    memset (mask, 0, sizeof (mask));
+    attr[0].id                 = SAI_UDF_ATTR_HASH_MASK;
+    attr[0].value.u8list.count = 3;
+    attr[0].value.u8list.list  = mask;
+    attr[1].id                 = SAI_UDF_ATTR_OFFSET;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_udf_api->get_udf_attribute (udf_id, 2, attr));
+    ASSERT_EQ (2u, attr[0].value.u8list.count);
+    EXPECT_EQ (0xFF, mask[0]);
+    EXPECT_EQ (0x00, mask[1]);
+    EXPECT_EQ (0, attr[1].value.u16);
+
+    attr[0].id        = SAI_UDF_ATTR_OFFSET;
+    attr[0].value.u16 = 6;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_udf_api->set_udf_attribute (udf_id, attr));
+    attr[0].value.u16 = 0;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_udf_api->get_udf_attribute (udf_id, 1, attr));
+    EXPECT_EQ (6, attr[0].value.u16);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf (udf_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf_match (match_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf_group (group_id));
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_udf_api->remove_udf_group (group_id));
+}
+
+/*
+ * The highest priority UDF whose match hits gives the bytes; frames too
+ * short for them, and later fragments for an L4 base, give zeros.
+ */
+TEST_F (saiStubUdfTest, extraction)
+{
+    sai_object_id_t group_id, udp_id, gre_id, any_id, udf_id[3];
+    sai_attribute_t attr;
+    frame_t         frames[5];
+    stub_packet_t   packets[5];
+    uint8_t         bytes[5 * 2];
+    uint8_t         hash_mask[2] = { 0xFF, 0x00 };
+
+    group_id = group_create (SAI_UDF_GROUP_GENERIC, 2);
+    udp_id   = match_create (17, 0, 1);
+    gre_id   = match_create (0, 0x0800, 10);
+    any_id   = match_create (0, 0, 0);
+
+    /* UDP destination port, inner source address, ethertype otherwise */
+    udf_id[0] = udf_create (udp_id, group_id, SAI_UDF_BASE_L4, 2);
+    udf_id[1] = udf_create (gre_id, group_id, SAI_UDF_BASE_L4, 4 + 12);
+    udf_id[2] = udf_create (any_id, group_id, SAI_UDF_BASE_L2, 12);
+
+    build_ip (&frames[0], 17, 0x0B000001, 1000, 0x1235, 42);
+    build_gre (&frames[1], 0xC0A80001);
+    build_ip (&frames[2], 6, 0x0B000001, 1000, 0x1235, 54);
+    build_ip (&frames[3], 17, 0x0B000001, 1000, 0x1235, 14 + 20 + 3);
+    build_ip (&frames[4], 17, 0x0B000001, 1000, 0x1235, 42);
+    frames[4].packet.data[14 + 7] = 0x10;
+    for (uint32_t i = 0; i < 5; i++) {
+        packets[i] = frames[i].packet;
+    }
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_udf_extract (group_id, 5, packets, false, bytes));
+    EXPECT_EQ (0x12, bytes[0]);
+    EXPECT_EQ (0x35, bytes[1]);
+    EXPECT_EQ (0xC0, bytes[2]);
+    EXPECT_EQ (0xA8, bytes[3]);
+    EXPECT_EQ (0x08, bytes[4]);
+    EXPECT_EQ (0x00, bytes[5]);
+    for (uint32_t i = 6; i < 10; i++) {
+        EXPECT_EQ (0, bytes[i]);
+    }
+
+    /* The hash mask applies to hash keys only */
+    attr.id                 = SAI_UDF_ATTR_HASH_MASK;
+    attr.value.u8list.count = 2;
+    attr.value.u8list.list  = hash_mask;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_udf_api->set_udf_attribute (udf_id[0], &attr));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_udf_extract (group_id, 1, packets, true, bytes));
+    EXPECT_EQ (0x12, bytes[0]);
+    EXPECT_EQ (0x00, bytes[1]);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_udf_extract (group_id, 1, packets, false, bytes));
+    EXPECT_EQ (0x35, bytes[1]);
+
+    /* Without the catch-all UDF, a TCP frame gives zeros */
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf (udf_id[2]));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_udf_extract (group_id, 1, &packets[2], false, bytes));
+    EXPECT_EQ (0, bytes[0]);
+    EXPECT_EQ (0, bytes[1]);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf (udf_id[0]));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf (udf_id[1]));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf_match (udp_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf_match (gre_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf_match (any_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf_group (group_id));
+    EXPECT_NE (SAI_STATUS_SUCCESS, stub_udf_extract (group_id, 1, packets, false, bytes));
+}
+
+/*
+ * The bytes of the hash UDF groups of the ECMP hash tell apart GRE flows
+ * whose outer headers are the same.
+ */
+TEST_F (saiStubUdfTest, hash_groups)
+{
+    sai_object_id_t ecmp_default, hash_id, group_id, generic_id, match_id, udf_id;
+    sai_attribute_t attr[2];
+    frame_t         frames[2];
+    stub_packet_t   packets[2];
+    uint32_t        hashes[2];
+
+    group_id   = group_create (SAI_UDF_GROUP_HASH, 4);
+    generic_id = group_create (SAI_UDF_GROUP_GENERIC, 4);
+    match_id   = match_create (0, 0x0800, 1);
+    udf_id     = udf_create (match_id, group_id, SAI_UDF_BASE_L4, 4 + 12);
+
+    build_gre (&frames[0], 0xC0A80001);
+    build_gre (&frames[1], 0xC0A80002);
+    packets[0] = frames[0].packet;
+    packets[1] = frames[1].packet;
+
+    attr[0].id = SAI_SWITCH_ATTR_ECMP_HASH;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->get_switch_attribute (1, attr));
+    ecmp_default = attr[0].value.oid;
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_hash_calculate (STUB_HASH_TYPE_ECMP, 2, packets, hashes));
+    EXPECT_EQ (hashes[0], hashes[1]);
+
+    /* Only hash groups go into a hash */
+    attr[0].id                  = SAI_HASH_NATIVE_FIELD_LIST;
+    attr[0].value.s32list.count = 5;
+    attr[0].value.s32list.list  = (int32_t*) udf_five_tuple;
+    attr[1].id                  = SAI_HASH_UDF_GROUP_LIST;
+    attr[1].value.objlist.count = 1;
+    attr[1].value.objlist.list  = &generic_id;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_hash_api->create_hash (&hash_id, 2, attr));
+    attr[1].value.objlist.list  = &group_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hash_api->create_hash (&hash_id, 2, attr));
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_udf_api->remove_udf_group (group_id));
+
+    attr[0].id        = SAI_SWITCH_ATTR_ECMP_HASH;
+    attr[0].value.oid = hash_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (attr));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_hash_calculate (STUB_HASH_TYPE_ECMP, 2, packets, hashes));
+    EXPECT_NE (hashes[0], hashes[1]);
+
+    /* Clearing the list leaves the native fields */
+    attr[1].value.objlist.count = 0;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hash_api->set_hash_attribute (hash_id, &attr[1]));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_hash_calculate (STUB_HASH_TYPE_ECMP, 2, packets, hashes));
+    EXPECT_EQ (hashes[0], hashes[1]);
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf (udf_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf_group (group_id));
+
+    attr[0].value.oid = ecmp_default;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (attr));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_hash_api->remove_hash (hash_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf_match (match_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf_group (generic_id));
+}
+
+/*
+ * An ACL table with a generic UDF group matches entries on its bytes and
+ * keeps the group from removal.
+ */
+TEST_F (saiStubUdfTest, acl_groups)
+{
+    sai_object_id_t table_id, entry_id, group_id, match_id, udf_id, hits[3];
+    sai_attribute_t attr[4];
+    frame_t         frames[3];
+    stub_packet_t   packets[3];
+    uint8_t         data[2] = { 0x00, 0x35 }, mask[2] = { 0xFF, 0xFF };
+    uint8_t         data_out[2], mask_out[2];
+
+    group_id = group_create (SAI_UDF_GROUP_GENERIC, 2);
+    match_id = match_create (17, 0, 1);
+    udf_id   = udf_create (match_id, group_id, SAI_UDF_BASE_L4, 2);
+
+    memset (attr, 0, sizeof (attr));
+    attr[0].id        = SAI_ACL_TABLE_ATTR_STAGE;
+    attr[0].value.s32 = SAI_ACL_STAGE_INGRESS;
+    attr[1].id        = SAI_ACL_TABLE_ATTR_PRIORITY;
+    attr[1].value.u32 = 1;
+    attr[2].id        = SAI_ACL_TABLE_ATTR_USER_DEFINED_FIELD_GROUP_MIN;
+    attr[2].value.oid = group_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->create_acl_table (&table_id, 3, attr));
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_udf_api->remove_udf_group (group_id));
+
+    attr[0].id                             = SAI_ACL_ENTRY_ATTR_TABLE_ID;
+    attr[0].value.oid                      = table_id;
+    attr[1].id                             = SAI_ACL_ENTRY_ATTR_PRIORITY;
+    attr[1].value.u32                      = 1;
+    attr[2].id                             = SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN;
+    attr[2].value.aclfield.enable          = true;
+    attr[2].value.aclfield.data.u8list.count = 1;
+    attr[2].value.aclfield.data.u8list.list  = data;
+    attr[2].value.aclfield.mask.u8list.count = 2;
+    attr[2].value.aclfield.mask.u8list.list  = mask;
+    attr[3].id                             = SAI_ACL_ENTRY_ATTR_PACKET_ACTION;
+    attr[3].value.aclaction.enable         = true;
+    attr[3].value.aclaction.parameter.s32  = SAI_PACKET_ACTION_DROP;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_acl_api->create_acl_entry (&entry_id, 4, attr));
+    attr[2].value.aclfield.data.u8list.count = 2;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->create_acl_entry (&entry_id, 4, attr));
+
+    /* Only the second slot of the table is empty */
+    attr[2].id = SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN + 1;
+    EXPECT_NE (SAI_STATUS_SUCCESS, p_acl_api->set_acl_entry_attribute (entry_id, &attr[2]));
+
+    build_ip (&frames[0], 17, 0x0B000001, 1000, 53, 42);
+    build_ip (&frames[1], 17, 0x0B000001, 1000, 54, 42);
+    build_ip (&frames[2], 6, 0x0B000001, 1000, 53, 54);
+    for (uint32_t i = 0; i < 3; i++) {
+        packets[i] = frames[i].packet;
+    }
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_acl_classify (table_id, 3, packets, hits));
+    EXPECT_EQ (entry_id, hits[0]);
+    EXPECT_EQ (SAI_NULL_OBJECT_ID, hits[1]);
+    EXPECT_EQ (SAI_NULL_OBJECT_ID, hits[2]);
+
+    attr[0].id                               = SAI_ACL_ENTRY_ATTR_USER_DEFINED_FIELD_MIN;
+    attr[0].value.aclfield.data.u8list.count = 2;
+    attr[0].value.aclfield.data.u8list.list  = data_out;
+    attr[0].value.aclfield.mask.u8list.count = 2;
+    attr[0].value.aclfield.mask.u8list.list  = mask_out;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->get_acl_entry_attribute (entry_id, 1, attr));
+    EXPECT_TRUE (attr[0].value.aclfield.enable);
+    EXPECT_EQ (0, memcmp (data, data_out, 2));
+    EXPECT_EQ (0, memcmp (mask, mask_out, 2));
+
+    attr[0].id        = SAI_ACL_TABLE_ATTR_USER_DEFINED_FIELD_GROUP_MIN;
+    attr[0].value.oid = SAI_NULL_OBJECT_ID;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_acl_api->get_acl_table_attribute (table_id, 1, attr));
+    EXPECT_EQ (group_id, attr[0].value.oid);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_entry (entry_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_acl_api->delete_acl_table (table_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf (udf_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf_match (match_id));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf_group (group_id));
+}
+
+/*
+ * Extraction rate of a group of four matches, and the ECMP hash rate of
+ * the 5-tuple with and without a 4 byte UDF group.
+ */
+TEST_F (saiStubUdfTest, udf_rate)
+{
+    const uint32_t             frame_count = 65536, burst = 256, rounds = 16;
+    std::vector<frame_t>       frames (frame_count);
+    std::vector<stub_packet_t> packets (frame_count);
+    std::vector<uint32_t>      hashes (frame_count);
+    std::vector<uint8_t>       bytes (burst * 4);
+    sai_object_id_t            ecmp_default, hash_id, group_id, match_id[4], udf_id[4];
+    sai_attribute_t            attr[2];
+    const uint8_t              protocols[4] = { 6, 17, 47, 0 };
+
+    group_id = group_create (SAI_UDF_GROUP_HASH, 4);
+    for (uint32_t i = 0; i < 4; i++) {
+        match_id[i] = match_create (protocols[i], 0, (uint8_t) i);
+        udf_id[i]   = udf_create (match_id[i], group_id, (0 == protocols[i]) ? SAI_UDF_BASE_L3 : SAI_UDF_BASE_L4,
+                                  (uint16_t) i);
+    }
+
+    for (uint32_t i = 0; i < frame_count; i++) {
+        if (0 == (i & 3)) {
+            build_gre (&frames[i], 0xC0A80000 + i);
+        } else {
+            build_ip (&frames[i], (i & 1) ? 17 : 6, 0x0B000000 + (i >> 6), (uint16_t) (1024 + i), 53, 54);
+        }
+        packets[i] = frames[i].packet;
+    }
+
+    auto start = std::chrono::steady_clock::now ();
+    for (uint32_t r = 0; r < rounds; r++) {
+        for (uint32_t i = 0; i < frame_count; i += burst) {
+            ASSERT_EQ (SAI_STATUS_SUCCESS, stub_udf_extract (group_id, burst, &packets[i], true, bytes.data ()));
+        }
+    }
+    double sec = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+    printf ("UDF extract: %.2f Mpps\n", frame_count * rounds / sec / 1e6);
+
+    attr[0].id = SAI_SWITCH_ATTR_ECMP_HASH;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->get_switch_attribute (1, attr));
+    ecmp_default = attr[0].value.oid;
+
+    attr[0].id                  = SAI_HASH_NATIVE_FIELD_LIST;
+    attr[0].value.s32list.count = 5;
+    attr[0].value.s32list.list  = (int32_t*) udf_five_tuple;
+    attr[1].id                  = SAI_HASH_UDF_GROUP_LIST;
+    attr[1].value.objlist.count = 0;
+    attr[1].value.objlist.list  = &group_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_hash_api->create_hash (&hash_id, 2, attr));
+    attr[0].id        = SAI_SWITCH_ATTR_ECMP_HASH;
+    attr[0].value.oid = hash_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (attr));
+
+    for (uint32_t groups = 0; groups <= 1; groups++) {
+        attr[1].value.objlist.count = groups;
+        ASSERT_EQ (SAI_STATUS_SUCCESS, p_hash_api->set_hash_attribute (hash_id, &attr[1]));
+
+        start = std::chrono::steady_clock::now ();
+        for (uint32_t r = 0; r < rounds; r++) {
+            for (uint32_t i = 0; i < frame_count; i += burst) {
+                ASSERT_EQ (SAI_STATUS_SUCCESS,
+                           stub_hash_calculate (STUB_HASH_TYPE_ECMP, burst, &packets[i], &hashes[i]));
+            }
+        }
+        sec = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+        printf ("CRC 5-tuple%s: %.2f Mpps\n", groups ? " + UDF group" : "", frame_count * rounds / sec / 1e6);
+    }
+
+    attr[0].value.oid = ecmp_default;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_switch_api->set_switch_attribute (attr));
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_hash_api->remove_hash (hash_id));
+    for (uint32_t i = 0; i < 4; i++) {
+        EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf (udf_id[i]));
+        EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf_match (match_id[i]));
+    }
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_udf_api->remove_udf_group (group_id));
+}
@@ -0,0 +1,490 @@
+/************************************************************************
+*    Licensed under the Apache License, Version 2.0 (the "License"); you may
+*    not use this file except in compliance with the License. You may obtain
+*    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+*
+*    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+*    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+*    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+*    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+*
+*    See the Apache Version 2.0 License for specific language governing
+*    permissions and limitations under the License.
+*
+*
+* Module Name:
+*
+*    sai_stub_wred_unit_test.cpp
+*
+* Abstract:
+*
+*    This file contains tests for the stub WRED profiles. Profiles are
+*    checked and read back, queues bound to them drop early and along the
+*    probability ramp, ECN capable IPv4 and IPv6 frames are marked instead,
+*    and the drops and marks show in the queue statistics.
+*
+*************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/sai_stub_unit_test_utils.h"
+
+extern "C" {
+#include "sai.h"
+#include "saitypes.h"
+#include "saistatus.h"
+#include "saiswitch.h"
+#include "saiport.h"
+#include "saiqueue.h"
+#include "saiwred.h"
+#include "stub_sai_dataplane.h"
+#include "stub_sai_scheduler.h"
+#include "stub_sai_wred.h"
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+}
+
+#include <chrono>
+
+/* 10 Gbps */
+#define LINE_RATE 1250000000ULL
+#define FRAME_LEN 64
+
+class saiStubWredTest : public saiStubTest
+{
+    protected:
+        static void SetUpTestCase (void);
+
+        struct frame_t {
+            uint8_t       buffer[FRAME_LEN];
+            stub_packet_t packet;
+        };
+
+        static sai_object_id_t queue_oid (uint32_t port, uint32_t queue);
+        static void enqueue (uint32_t port, uint32_t queue, uint32_t count, uint32_t length);
+        static uint64_t queue_stat (sai_object_id_t queue_id, sai_queue_stat_counter_t counter);
+        static sai_object_id_t wred_create (uint32_t min_threshold, uint32_t max_threshold,
+                                            uint32_t drop_probability, bool ecn_mark);
+        static void queue_wred_set (sai_object_id_t queue_id, sai_object_id_t wred_id);
+        static void ip_frame (frame_t *frame, bool ipv6, uint8_t ecn, uint32_t port);
+        static uint16_t ipv4_sum (const uint8_t *ip);
+
+        static sai_port_api_t   *p_port_api;
+        static sai_queue_api_t  *p_queue_api;
+        static sai_wred_api_t   *p_wred_api;
+};
+
+sai_port_api_t* saiStubWredTest::p_port_api = NULL;
+sai_queue_api_t* saiStubWredTest::p_queue_api = NULL;
+sai_wred_api_t* saiStubWredTest::p_wred_api = NULL;
+
+/* Queue from the queue list of the port */
+sai_object_id_t saiStubWredTest::queue_oid (uint32_t port, uint32_t queue)
+{
+    sai_object_id_t queues[STUB_SCHEDULER_MAX_CHILDS];
+    sai_attribute_t attr;
+
+    attr.id                   = SAI_PORT_ATTR_QOS_QUEUE_LIST;
+    attr.value.objlist.count  = STUB_SCHEDULER_MAX_CHILDS;
+    attr.value.objlist.list   = queues;
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_port_api->get_port_attribute (port_oid (port), 1, &attr));
+    EXPECT_LT (queue, attr.value.objlist.count);
+
+    return queues[queue];
+}
+
+/* Forwarded green frames without data to a queue of a port, in bursts */
+void saiStubWredTest::enqueue (uint32_t port, uint32_t queue, uint32_t count, uint32_t length)
+{
+    stub_packet_t packets[STUB_DATAPLANE_BURST];
+    uint32_t      ii, burst;
+
+    for (; count > 0; count -= burst) {
+        burst = (count < STUB_DATAPLANE_BURST) ? count : STUB_DATAPLANE_BURST;
+        memset (packets, 0, sizeof (packets));
+        for (ii = 0; ii < burst; ii++) {
+            packets[ii].length        = length;
+            packets[ii].in_port       = port_oid (0);
+            packets[ii].out_port      = port_oid (port);
+            packets[ii].packet_action = SAI_PACKET_ACTION_FORWARD;
+            packets[ii].queue         = queue;
+        }
+        ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_enqueue (burst, packets));
+    }
+}
+
+uint64_t saiStubWredTest::queue_stat (sai_object_id_t queue_id, sai_queue_stat_counter_t counter)
+{
+    uint64_t value = 0;
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_queue_api->get_queue_stats (queue_id, &counter, 1, &value));
+
+    return value;
+}
+
+/* Profile for green frames */
+sai_object_id_t saiStubWredTest::wred_create (uint32_t min_threshold, uint32_t max_threshold,
+                                              uint32_t drop_probability, bool ecn_mark)
+{
+    sai_object_id_t wred_id = SAI_NULL_OBJECT_ID;
+    sai_attribute_t attr[5];
+
+    attr[0].id             = SAI_WRED_ATTR_GREEN_ENABLE;
+    attr[0].value.booldata = true;
+    attr[1].id             = SAI_WRED_ATTR_GREEN_MIN_THRESHOLD;
+    attr[1].value.u32      = min_threshold;
+    attr[2].id             = SAI_WRED_ATTR_GREEN_MAX_THRESHOLD;
+    attr[2].value.u32      = max_threshold;
+    attr[3].id             = SAI_WRED_ATTR_GREEN_DROP_PROBABILITY;
+    attr[3].value.u32      = drop_probability;
+    attr[4].id             = SAI_WRED_ATTR_ECN_MARK_ENABLE;
+    attr[4].value.booldata = ecn_mark;
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_wred_api->create_wred_profile (&wred_id, 5, attr));
+
+    return wred_id;
+}
+
+void saiStubWredTest::queue_wred_set (sai_object_id_t queue_id, sai_object_id_t wred_id)
+{
+    sai_attribute_t attr;
+
+    attr.id        = SAI_QUEUE_ATTR_WRED_PROFILE_ID;
+    attr.value.oid = wred_id;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_queue_api->set_queue_attribute (queue_id, &attr));
+}
+
+/* Ones' complement sum of an IPv4 header, 0xFFFF when the checksum holds */
+uint16_t saiStubWredTest::ipv4_sum (const uint8_t *ip)
+{
+    uint32_t sum = 0;
+    uint32_t ii;
+
+    for (ii = 0; ii < 20; ii += 2) {
+        sum += (ip[ii] << 8) | ip[ii + 1];
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+
+    return (uint16_t)sum;
+}
+
+/* Forwarded UDP frame to queue 0 of a port with an ECN field */
+void saiStubWredTest::ip_frame (frame_t *frame, bool ipv6, uint8_t ecn, uint32_t port)
+{
+    uint8_t *ip = frame->buffer + 14;
+
+    memset (frame, 0, sizeof (*frame));
+    memset (frame->buffer, 0x02, 12);
+    if (ipv6) {
+        frame->buffer[12] = 0x86;
+        frame->buffer[13] = 0xDD;
+        ip[0] = 0x60 | 0x0B;
+        ip[1] = 0x80 | (ecn << 4);
+        ip[5] = FRAME_LEN - 14 - 40;
+        ip[6] = 17;
+        ip[7] = 64;
+    } else {
+        frame->buffer[12] = 0x08;
+        frame->buffer[13] = 0x00;
+        ip[0] = 0x45;
+        ip[1] = 0xB8 | ecn;
+        ip[3] = FRAME_LEN - 14;
+        ip[8] = 64;
+        ip[9] = 17;
+        ip[12] = 10;
+        ip[15] = 1;
+        ip[16] = 10;
+        ip[19] = 2;
+        ip[10] = (uint8_t)(~ipv4_sum (ip) >> 8);
+        ip[11] = (uint8_t)~ipv4_sum (ip);
+    }
+
+    frame->packet.data          = frame->buffer;
+    frame->packet.length        = FRAME_LEN;
+    frame->packet.out_port      = port_oid (port);
+    frame->packet.packet_action = SAI_PACKET_ACTION_FORWARD;
+}
+
+void saiStubWredTest::SetUpTestCase (void)
+{
+    SetUpStubSwitch ();
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_PORT, (void **)&p_port_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_QUEUE, (void **)&p_queue_api));
+    ASSERT_EQ (SAI_STATUS_SUCCESS, sai_api_query (SAI_API_WRED, (void **)&p_wred_api));
+}
+
+/*
+ * Profiles take values in range, enabled colors both thresholds with the
+ * minimum not above the maximum, and read back as set. Profiles bound to
+ * queues stay.
+ */
+TEST_F (saiStubWredTest, wred_attributes)
+{
+    sai_object_id_t wred_id, bad_id, queue_id;
+    sai_attribute_t attr[4];
+
+    memset (attr, 0, sizeof (attr));
+
+    /* Enabled without thresholds */
+    attr[0].id             = SAI_WRED_ATTR_YELLOW_ENABLE;
+    attr[0].value.booldata = true;
+    attr[1].id             = SAI_WRED_ATTR_YELLOW_MIN_THRESHOLD;
+    attr[1].value.u32      = 5000;
+    EXPECT_EQ (SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING, p_wred_api->create_wred_profile (&bad_id, 2, attr));
+
+    /* Thresholds out of range or crossed, probability and weight too high */
+    attr[2].id        = SAI_WRED_ATTR_YELLOW_MAX_THRESHOLD;
+    attr[2].value.u32 = 4000;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0 + 1, p_wred_api->create_wred_profile (&bad_id, 3, attr));
+    attr[2].value.u32 = STUB_WRED_MAX_THRESHOLD + 1;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0 + 2, p_wred_api->create_wred_profile (&bad_id, 3, attr));
+    attr[2].value.u32 = 0;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0 + 2, p_wred_api->create_wred_profile (&bad_id, 3, attr));
+    attr[2].value.u32 = 8000;
+    attr[3].id        = SAI_WRED_ATTR_YELLOW_DROP_PROBABILITY;
+    attr[3].value.u32 = 101;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0 + 3, p_wred_api->create_wred_profile (&bad_id, 4, attr));
+    attr[3].id        = SAI_WRED_ATTR_WEIGHT;
+    attr[3].value.u8  = STUB_WRED_MAX_WEIGHT + 1;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0 + 3, p_wred_api->create_wred_profile (&bad_id, 4, attr));
+
+    attr[3].value.u8 = 3;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_wred_api->create_wred_profile (&wred_id, 4, attr));
+
+    attr[0].id = SAI_WRED_ATTR_YELLOW_MAX_THRESHOLD;
+    attr[1].id = SAI_WRED_ATTR_YELLOW_DROP_PROBABILITY;
+    attr[2].id = SAI_WRED_ATTR_WEIGHT;
+    attr[3].id = SAI_WRED_ATTR_GREEN_ENABLE;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_wred_api->get_wred_attribute (wred_id, 4, attr));
+    EXPECT_EQ (8000u, attr[0].value.u32);
+    EXPECT_EQ (100u, attr[1].value.u32);
+    EXPECT_EQ (3u, attr[2].value.u8);
+    EXPECT_FALSE (attr[3].value.booldata);
+
+    /* Enabling takes the thresholds first, crossing them is refused */
+    attr[0].id             = SAI_WRED_ATTR_RED_ENABLE;
+    attr[0].value.booldata = true;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0, p_wred_api->set_wred_attribute (wred_id, &attr[0]));
+    attr[0].id        = SAI_WRED_ATTR_YELLOW_MIN_THRESHOLD;
+    attr[0].value.u32 = 9000;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0, p_wred_api->set_wred_attribute (wred_id, &attr[0]));
+    attr[0].value.u32 = 6000;
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_wred_api->set_wred_attribute (wred_id, &attr[0]));
+    attr[0].value.u32 = 0;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_wred_api->get_wred_attribute (wred_id, 1, &attr[0]));
+    EXPECT_EQ (6000u, attr[0].value.u32);
+
+    /* Bound to a queue */
+    queue_id = queue_oid (4, 2);
+    queue_wred_set (queue_id, wred_id);
+    attr[0].id = SAI_QUEUE_ATTR_WRED_PROFILE_ID;
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_queue_api->get_queue_attribute (queue_id, 1, &attr[0]));
+    EXPECT_EQ (wred_id, attr[0].value.oid);
+    EXPECT_EQ (SAI_STATUS_OBJECT_IN_USE, p_wred_api->remove_wred_profile (wred_id));
+
+    queue_wred_set (queue_id, SAI_NULL_OBJECT_ID);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_queue_api->get_queue_attribute (queue_id, 1, &attr[0]));
+    EXPECT_EQ (SAI_NULL_OBJECT_ID, attr[0].value.oid);
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_wred_api->remove_wred_profile (wred_id));
+
+    attr[0].value.oid = wred_id;
+    EXPECT_EQ (SAI_STATUS_INVALID_ATTR_VALUE_0, p_queue_api->set_queue_attribute (queue_id, &attr[0]));
+}
+
+/*
+ * With a weight of 0 the average follows the occupancy, which stays
+ * between the thresholds of a profile dropping everything past its
+ * maximum. The drops count as WRED discards and as drops. Yellow frames,
+ * not enabled in the profile, are all queued.
+ */
+TEST_F (saiStubWredTest, early_drop)
+{
+    sai_object_id_t wred_id, queue_id;
+    stub_packet_t   packets[STUB_DATAPLANE_BURST];
+    uint64_t        occupancy, dropped;
+    uint32_t        ii;
+
+    queue_id = queue_oid (5, 1);
+    wred_id  = wred_create (10000, 20000, 100, false);
+    queue_wred_set (queue_id, wred_id);
+
+    enqueue (5, 1, 1000, 100);
+
+    occupancy = queue_stat (queue_id, SAI_QUEUE_STAT_CURR_OCCUPANCY_BYTES);
+    dropped   = queue_stat (queue_id, SAI_QUEUE_STAT_DISCARD_DROPPED_PACKETS);
+    EXPECT_GE (occupancy, 10000u);
+    EXPECT_LE (occupancy, 20000u);
+    EXPECT_EQ (100u * 1000u, occupancy + 100u * dropped);
+    EXPECT_EQ (100u * dropped, queue_stat (queue_id, SAI_QUEUE_STAT_DISCARD_DROPPED_BYTES));
+    EXPECT_EQ (dropped, queue_stat (queue_id, SAI_QUEUE_STAT_GREEN_DISCARD_DROPPED_PACKETS));
+    EXPECT_EQ (dropped, queue_stat (queue_id, SAI_QUEUE_STAT_DROPPED_PACKETS));
+    EXPECT_EQ (dropped, queue_stat (queue_id, SAI_QUEUE_STAT_GREEN_DROPPED_PACKETS));
+    EXPECT_EQ (0u, queue_stat (queue_id, SAI_QUEUE_STAT_YELLOW_DISCARD_DROPPED_PACKETS));
+
+    memset (packets, 0, sizeof (packets));
+    for (ii = 0; ii < STUB_DATAPLANE_BURST; ii++) {
+        packets[ii].length        = 100;
+        packets[ii].out_port      = port_oid (5);
+        packets[ii].packet_action = SAI_PACKET_ACTION_FORWARD;
+        packets[ii].queue         = 1;
+        packets[ii].color         = SAI_PACKET_COLOR_YELLOW;
+    }
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_enqueue (STUB_DATAPLANE_BURST, packets));
+    EXPECT_EQ (occupancy + 100u * STUB_DATAPLANE_BURST,
+               queue_stat (queue_id, SAI_QUEUE_STAT_CURR_OCCUPANCY_BYTES));
+    EXPECT_EQ (dropped, queue_stat (queue_id, SAI_QUEUE_STAT_DROPPED_PACKETS));
+
+    queue_wred_set (queue_id, SAI_NULL_OBJECT_ID);
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_wred_api->remove_wred_profile (wred_id));
+}
+
+/*
+ * Halfway up the ramp of a profile with a drop probability of 50 a
+ * quarter of the frames drop.
+ */
+TEST_F (saiStubWredTest, drop_ramp)
+{
+    sai_object_id_t wred_id, queue_id;
+    uint64_t        dropped;
+
+    queue_id = queue_oid (6, 2);
+    enqueue (6, 2, 15, 1000);
+
+    wred_id = wred_create (10000, 20000, 50, false);
+    queue_wred_set (queue_id, wred_id);
+
+    /* Frames of 1 byte keep the average between 15000 and 16000 */
+    enqueue (6, 2, 1000, 1);
+
+    dropped = queue_stat (queue_id, SAI_QUEUE_STAT_DISCARD_DROPPED_PACKETS);
+    printf ("drop ramp: %" PRIu64 " of 1000 frames dropped\n", dropped);
+    EXPECT_GE (dropped, 200u);
+    EXPECT_LE (dropped, 320u);
+    EXPECT_EQ (dropped, queue_stat (queue_id, SAI_QUEUE_STAT_DROPPED_PACKETS));
+
+    queue_wred_set (queue_id, SAI_NULL_OBJECT_ID);
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_wred_api->remove_wred_profile (wred_id));
+}
+
+/*
+ * With ECN marking, ECN capable IPv4 and IPv6 frames the ramp picks are
+ * queued with Congestion Experienced, the IPv4 checksum still valid, and
+ * counted as marked. Frames not ECN capable drop.
+ */
+TEST_F (saiStubWredTest, ecn_marking)
+{
+    frame_t                  frames[100];
+    stub_packet_t            packets[100];
+    sai_queue_stat_counter_t counters[2];
+    sai_object_id_t          wred_id, queue_id;
+    uint64_t                 values[2];
+    uint32_t                 ii, pass, marked, ecn, count;
+    bool                     ipv6;
+
+    queue_id = queue_oid (7, 0);
+    wred_id  = wred_create (1000, 21000, 100, true);
+
+    counters[0] = (sai_queue_stat_counter_t)STUB_QUEUE_STAT_ECN_MARKED_PACKETS;
+    counters[1] = (sai_queue_stat_counter_t)STUB_QUEUE_STAT_ECN_MARKED_BYTES;
+
+    /* IPv4, IPv6 and IPv4 not ECN capable, each from 11000 bytes queued */
+    for (pass = 0; pass < 3; pass++) {
+        queue_wred_set (queue_id, SAI_NULL_OBJECT_ID);
+        ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_transmit (port_oid (7), 1000000, LINE_RATE, &count));
+        enqueue (7, 0, 11, 1000);
+        queue_wred_set (queue_id, wred_id);
+        if (2 == pass) {
+            break;
+        }
+
+        ipv6 = (1 == pass);
+        for (ii = 0; ii < 100; ii++) {
+            ip_frame (&frames[ii], ipv6, 1 + ii % 2, 7);
+            packets[ii] = frames[ii].packet;
+        }
+        ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_enqueue (100, packets));
+
+        marked = 0;
+        for (ii = 0; ii < 100; ii++) {
+            const uint8_t *ip = frames[ii].buffer + 14;
+
+            ecn = ipv6 ? (ip[1] >> 4) & 0x3 : ip[1] & 0x3;
+            if (3 == ecn) {
+                marked++;
+            } else {
+                EXPECT_EQ (1 + ii % 2, ecn);
+            }
+            if (!ipv6) {
+                EXPECT_EQ (0xB8, ip[1] & 0xFC);
+                EXPECT_EQ (0xFFFF, ipv4_sum (ip));
+            }
+        }
+        EXPECT_GT (marked, 0u);
+        EXPECT_EQ (0u, queue_stat (queue_id, SAI_QUEUE_STAT_DISCARD_DROPPED_PACKETS));
+        ASSERT_EQ (SAI_STATUS_SUCCESS, p_queue_api->get_queue_stats (queue_id, counters, 2, values));
+        EXPECT_EQ (marked, values[0]);
+        EXPECT_EQ ((uint64_t)FRAME_LEN * marked, values[1]);
+        ASSERT_EQ (SAI_STATUS_SUCCESS, p_queue_api->clear_queue_stats (queue_id, counters, 2));
+    }
+
+    for (ii = 0; ii < 100; ii++) {
+        ip_frame (&frames[ii], false, 0, 7);
+        packets[ii] = frames[ii].packet;
+    }
+    ASSERT_EQ (SAI_STATUS_SUCCESS, stub_scheduler_enqueue (100, packets));
+    for (ii = 0; ii < 100; ii++) {
+        EXPECT_EQ (0, frames[ii].buffer[14 + 1] & 0x3);
+    }
+    EXPECT_GT (queue_stat (queue_id, SAI_QUEUE_STAT_DISCARD_DROPPED_PACKETS), 0u);
+    ASSERT_EQ (SAI_STATUS_SUCCESS, p_queue_api->get_queue_stats (queue_id, counters, 2, values));
+    EXPECT_EQ (0u, values[0]);
+
+    queue_wred_set (queue_id, SAI_NULL_OBJECT_ID);
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_wred_api->remove_wred_profile (wred_id));
+}
+
+/*
+ * A queue offered more than it sends settles between the thresholds.
+ * Reports the rate of enqueueing and scheduling bursts through WRED.
+ */
+TEST_F (saiStubWredTest, wred_rate)
+{
+    stub_packet_t   packets[STUB_DATAPLANE_BURST];
+    sai_object_id_t wred_id, queue_id;
+    uint64_t        occupancy;
+    uint32_t        ii, jj, count, sent = 0;
+
+    queue_id = queue_oid (21, 0);
+    wred_id  = wred_create (10000, 50000, 20, false);
+    queue_wred_set (queue_id, wred_id);
+
+    /* 2048 bytes a burst, 1250 sent */
+    memset (packets, 0, sizeof (packets));
+    for (ii = 0; ii < STUB_DATAPLANE_BURST; ii++) {
+        packets[ii].length        = 64;
+        packets[ii].out_port      = port_oid (21);
+        packets[ii].packet_action = SAI_PACKET_ACTION_FORWARD;
+    }
+
+    auto start = std::chrono::steady_clock::now ();
+    for (jj = 0; jj < 100000; jj++) {
+        stub_scheduler_enqueue (STUB_DATAPLANE_BURST, packets);
+        stub_scheduler_transmit (port_oid (21), 100, 10 * LINE_RATE, &count);
+        sent += count;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now () - start;
+    printf ("wred: %.1f Mpps offered, %.1f Mpps sent\n", 100000.0 * STUB_DATAPLANE_BURST / elapsed.count () / 1e6,
+            sent / elapsed.count () / 1e6);
+
+    occupancy = queue_stat (queue_id, SAI_QUEUE_STAT_CURR_OCCUPANCY_BYTES);
+    EXPECT_GE (occupancy, 10000u);
+    EXPECT_LE (occupancy, 50000u);
+    EXPECT_GT (queue_stat (queue_id, SAI_QUEUE_STAT_DISCARD_DROPPED_PACKETS), 0u);
+    EXPECT_EQ (queue_stat (queue_id, SAI_QUEUE_STAT_DISCARD_DROPPED_PACKETS),
+               queue_stat (queue_id, SAI_QUEUE_STAT_DROPPED_PACKETS));
+
+    queue_wred_set (queue_id, SAI_NULL_OBJECT_ID);
+    EXPECT_EQ (SAI_STATUS_SUCCESS, p_wred_api->remove_wred_profile (wred_id));
+}
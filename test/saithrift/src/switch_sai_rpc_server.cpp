@@ -18,6 +18,7 @@ limitations under the License.
 // You should copy it to another filename to avoid overwriting it.
 
 #include <iostream>
+#include <algorithm>
 
 #include "switch_sai_rpc.h"
 #include <thrift/protocol/TBinaryProtocol.h>
@@ -619,24 +620,20 @@ class switch_sai_rpcHandler : virtual public switch_sai_rpcIf {
       if (status != SAI_STATUS_SUCCESS) {
           return;
       }
-      sai_vlan_stat_counter_t *counter_ids = (sai_vlan_stat_counter_t *) malloc(sizeof(sai_vlan_stat_counter_t) * thrift_counter_ids.size());
-      std::vector<int32_t>::const_iterator it = thrift_counter_ids.begin();
-      uint64_t *counters = (uint64_t *) malloc(sizeof(uint64_t) * thrift_counter_ids.size());
-      for(uint32_t i = 0; i < thrift_counter_ids.size(); i++, it++) {
-          counter_ids[i] = (sai_vlan_stat_counter_t) *it;
-      }
+      // counter ids are int sized enums, the thrift list is passed as is
+      uint32_t count = std::min<uint32_t>(number_of_counters, thrift_counter_ids.size());
+      stats_counters.resize(count);
 
       status = vlan_api->get_vlan_stats(
                              (sai_vlan_id_t) vlan_id,
-                             counter_ids,
-                             number_of_counters,
-                             counters);
-
-      for (uint32_t i = 0; i < thrift_counter_ids.size(); i++) {
-          thrift_counters.push_back(counters[i]);
+                             (const sai_vlan_stat_counter_t *) thrift_counter_ids.data(),
+                             count,
+                             stats_counters.data());
+      if (status != SAI_STATUS_SUCCESS) {
+          return;
       }
-      free(counter_ids);
-      free(counters);
+
+      thrift_counters.assign(stats_counters.begin(), stats_counters.end());
       return;
   }
 
@@ -1598,28 +1595,24 @@ class switch_sai_rpcHandler : virtual public switch_sai_rpcIf {
       if (status != SAI_STATUS_SUCCESS) {
           return;
       }
-      sai_policer_stat_counter_t *counter_ids = (sai_policer_stat_counter_t *) malloc(sizeof(sai_policer_stat_counter_t) * thrift_counter_ids.size());
-      std::vector<int32_t>::const_iterator it = thrift_counter_ids.begin();
-      uint64_t *counters = (uint64_t *) malloc(sizeof(uint64_t) * thrift_counter_ids.size());
-      for(uint32_t i = 0; i < thrift_counter_ids.size(); i++, it++) {
-          counter_ids[i] = (sai_policer_stat_counter_t) *it;
-      }
+      stats_counters.resize(thrift_counter_ids.size());
 
-      int32_t number_of_counters = thrift_counter_ids.size();
       status = policer_api->get_policer_statistics(
                              (sai_object_id_t) policer_id,
-                             counter_ids,
-                             number_of_counters,
-                             counters);
-
-      for (uint32_t i = 0; i < thrift_counter_ids.size(); i++) {
-          thrift_counters.push_back(counters[i]);
+                             (const sai_policer_stat_counter_t *) thrift_counter_ids.data(),
+                             thrift_counter_ids.size(),
+                             stats_counters.data());
+      if (status != SAI_STATUS_SUCCESS) {
+          return;
       }
-      free(counter_ids);
-      free(counters);
+
+      thrift_counters.assign(stats_counters.begin(), stats_counters.end());
       return;
   }
 
+ private:
+  // counter buffer of the stats handlers, grows to the largest request and is reused
+  std::vector<uint64_t> stats_counters;
 };
 
 static void * switch_sai_thrift_rpc_server_thread(void *arg) {